@@ -0,0 +1,309 @@
+#include "lpuart_lld.h"
+
+#define LPUART_LLD_TX_BUF_MASK (LPUART_LLD_TX_BUF_SIZE - 1U)
+
+uint8_t lpuart_lld_rx_data[5];
+uint8_t lpuart_lld_rx_flag = 0U;
+uint32_t lpuart_lld_rx_bytes_num = 0U;
+uint8_t lpuart_lld_data_received_flg = 0U;
+uint32_t lpuart_lld_tx_dropped_num = 0U;
+uint32_t lpuart_lld_tx_overwritten_num = 0U;
+uint32_t lpuart_lld_tx_error_num = 0U;
+
+/* TX ring buffer shared by all printf callers (tasks and ISRs).
+ * The indexes are free running, only the low bits address the buffer:
+ *  - head      : next slot a producer will reserve
+ *  - committed : number of reserved slots that are completely written
+ *  - tail      : next slot to be copied out for the DMA
+ * A producer reserves a slot with a CAS on head, writes it and then bumps
+ * committed. The DMA side only takes data while committed == head, so it
+ * never sends a slot that is reserved but not written yet. No lock is taken,
+ * the last producer to commit kicks the DMA. */
+static uint8_t lpuart_lld_tx_buf[LPUART_LLD_TX_BUF_SIZE];
+static volatile uint32_t lpuart_lld_tx_head = 0U;
+static volatile uint32_t lpuart_lld_tx_committed = 0U;
+static volatile uint32_t lpuart_lld_tx_tail = 0U;
+/* data is copied out of the ring before sending, so the ring space is freed
+ * at once and the overwrite policy never touches bytes owned by the DMA */
+static uint8_t lpuart_lld_tx_dma_buf[LPUART_LLD_TX_DMA_CHUNK_SIZE];
+/* 1 while a DMA transfer is owned by somebody */
+static volatile uint32_t lpuart_lld_tx_busy = 0U;
+
+static uint32_t lpuart_lld_tx_fetch(uint8_t *dest, uint32_t max_len);
+static bool lpuart_lld_tx_ready(void);
+static void lpuart_lld_tx_kick(void);
+static bool lpuart_lld_tx_overflow(uint32_t tail);
+
+void lpuart_lld_init(void)
+{
+    /* Initialize LPUART instance */
+    LPUART_DRV_Init(INST_LPUART1, &lpuart1_State, &lpuart1_InitConfig0);
+    INT_SYS_SetPriority(LPUART1_RxTx_IRQn,configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY);
+#if LPUART_LLD_TX_BUFFER_ENABLE
+    LPUART_DRV_InstallTxCallback(INST_LPUART1, lpuart_lld_tx_cbk_func, NULL);
+#endif
+}
+
+void lpuart_lld_step(void)
+{
+}
+
+/* @brief: Put one char into the TX ring buffer, never waits on the wire
+ * @param data : char to send
+ * @return     : None
+ */
+void lpuart_lld_tx_put(uint8_t data)
+{
+    uint32_t head;
+    uint32_t tail;
+
+    for (;;)
+    {
+        head = __atomic_load_n(&lpuart_lld_tx_head, __ATOMIC_RELAXED);
+        tail = __atomic_load_n(&lpuart_lld_tx_tail, __ATOMIC_ACQUIRE);
+
+        if ((head - tail) < LPUART_LLD_TX_BUF_SIZE)
+        {
+            if (__atomic_compare_exchange_n(&lpuart_lld_tx_head, &head, head + 1U,
+                                            false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+            {
+                break;
+            }
+        }
+        else if (!lpuart_lld_tx_overflow(tail))
+        {
+            return;
+        }
+    }
+
+    lpuart_lld_tx_buf[head & LPUART_LLD_TX_BUF_MASK] = data;
+    (void)__atomic_fetch_add(&lpuart_lld_tx_committed, 1U, __ATOMIC_RELEASE);
+
+    lpuart_lld_tx_kick();
+}
+
+/* @brief: Number of chars still waiting in the TX ring buffer
+ * @return: pending chars, the chunk owned by the DMA is not included
+ */
+uint32_t lpuart_lld_tx_pending(void)
+{
+    return __atomic_load_n(&lpuart_lld_tx_head, __ATOMIC_RELAXED) -
+           __atomic_load_n(&lpuart_lld_tx_tail, __ATOMIC_RELAXED);
+}
+
+/* @brief: Wait until everything in the TX ring buffer is on the wire,
+ *         must not be called from an ISR
+ * @return: None
+ */
+void lpuart_lld_tx_flush(void)
+{
+    uint32_t bytes_remaining;
+
+    do
+    {
+        lpuart_lld_tx_kick();
+        if (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING)
+        {
+            /* let a preempted lower priority producer commit its char */
+            vTaskDelay(1U);
+        }
+    } while ((lpuart_lld_tx_pending() != 0U) || (lpuart_lld_tx_busy != 0U));
+
+    /* the last chunk may still be shifting out of the LPUART */
+    while (STATUS_BUSY == LPUART_DRV_GetTransmitStatus(INST_LPUART1, &bytes_remaining))
+    {
+    }
+}
+
+void lpuart_lld_tx_cbk_func(void *driverState, uart_event_t event, void *userData)
+{
+    uint32_t len;
+
+    (void)driverState;
+    (void)userData;
+
+    switch (event)
+    {
+    case UART_EVENT_TX_EMPTY:
+        /* chain the next chunk into the running transfer, the DMA has already
+         * read the whole bounce buffer at this point */
+        len = lpuart_lld_tx_fetch(lpuart_lld_tx_dma_buf, LPUART_LLD_TX_DMA_CHUNK_SIZE);
+        if (len > 0U)
+        {
+            (void)LPUART_DRV_SetTxBuffer(INST_LPUART1, lpuart_lld_tx_dma_buf, len);
+        }
+        break;
+    case UART_EVENT_END_TRANSFER:
+        __atomic_store_n(&lpuart_lld_tx_busy, 0U, __ATOMIC_RELEASE);
+        lpuart_lld_tx_kick();
+        break;
+    case UART_EVENT_ERROR:
+        lpuart_lld_tx_error_num++;
+        __atomic_store_n(&lpuart_lld_tx_busy, 0U, __ATOMIC_RELEASE);
+        break;
+    default:
+        break;
+    }
+}
+
+/* @brief: Copy the oldest committed chars out of the ring buffer
+ * @param dest    : destination buffer
+ * @param max_len : size of the destination buffer
+ * @return        : number of chars copied, the ring space is released
+ */
+static uint32_t lpuart_lld_tx_fetch(uint8_t *dest, uint32_t max_len)
+{
+    uint32_t committed;
+    uint32_t head;
+    uint32_t tail;
+    uint32_t len;
+    uint32_t first;
+
+    tail = __atomic_load_n(&lpuart_lld_tx_tail, __ATOMIC_ACQUIRE);
+    do
+    {
+        /* committed must be read before head */
+        committed = __atomic_load_n(&lpuart_lld_tx_committed, __ATOMIC_ACQUIRE);
+        head = __atomic_load_n(&lpuart_lld_tx_head, __ATOMIC_ACQUIRE);
+        if (committed != head)
+        {
+            /* a producer is writing, it will kick the DMA when it commits */
+            return 0U;
+        }
+
+        len = head - tail;
+        if (len > max_len)
+        {
+            len = max_len;
+        }
+        if (len == 0U)
+        {
+            return 0U;
+        }
+
+        first = LPUART_LLD_TX_BUF_SIZE - (tail & LPUART_LLD_TX_BUF_MASK);
+        if (first > len)
+        {
+            first = len;
+        }
+        memcpy(dest, &lpuart_lld_tx_buf[tail & LPUART_LLD_TX_BUF_MASK], first);
+        memcpy(&dest[first], lpuart_lld_tx_buf, len - first);
+        /* the CAS fails if an overwriting producer moved the tail meanwhile */
+    } while (!__atomic_compare_exchange_n(&lpuart_lld_tx_tail, &tail, tail + len,
+                                          false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+    return len;
+}
+
+static bool lpuart_lld_tx_ready(void)
+{
+    uint32_t committed = __atomic_load_n(&lpuart_lld_tx_committed, __ATOMIC_ACQUIRE);
+
+    return (committed == __atomic_load_n(&lpuart_lld_tx_head, __ATOMIC_ACQUIRE)) &&
+           (committed != __atomic_load_n(&lpuart_lld_tx_tail, __ATOMIC_ACQUIRE));
+}
+
+/* @brief: Start a DMA transfer if none is running and data is ready
+ * @return: None
+ */
+static void lpuart_lld_tx_kick(void)
+{
+    uint32_t len;
+
+    while (__atomic_exchange_n(&lpuart_lld_tx_busy, 1U, __ATOMIC_ACQUIRE) == 0U)
+    {
+        len = lpuart_lld_tx_fetch(lpuart_lld_tx_dma_buf, LPUART_LLD_TX_DMA_CHUNK_SIZE);
+        if (len > 0U)
+        {
+            if (STATUS_SUCCESS != LPUART_DRV_SendData(INST_LPUART1, lpuart_lld_tx_dma_buf, len))
+            {
+                lpuart_lld_tx_error_num++;
+                __atomic_store_n(&lpuart_lld_tx_busy, 0U, __ATOMIC_RELEASE);
+            }
+            break;
+        }
+
+        __atomic_store_n(&lpuart_lld_tx_busy, 0U, __ATOMIC_RELEASE);
+        /* a producer may have committed after the fetch and lost the race for
+         * the busy flag, look once more before leaving */
+        if (!lpuart_lld_tx_ready())
+        {
+            break;
+        }
+    }
+}
+
+/* @brief: Apply LPUART_LLD_TX_OVERFLOW_POLICY on a full ring buffer
+ * @param tail : tail seen by the producer
+ * @return     : true to retry the put, false to drop the char
+ */
+static bool lpuart_lld_tx_overflow(uint32_t tail)
+{
+#if (LPUART_LLD_TX_OVERFLOW_POLICY == LPUART_LLD_TX_OVERFLOW_BLOCK)
+    (void)tail;
+    /* nobody would free the space for an ISR or before the scheduler runs */
+    if (((S32_SCB->ICSR & S32_SCB_ICSR_VECTACTIVE_MASK) != 0U) ||
+        (xTaskGetSchedulerState() != taskSCHEDULER_RUNNING))
+    {
+        lpuart_lld_tx_dropped_num++;
+        return false;
+    }
+    lpuart_lld_tx_kick();
+    /* the DMA side waits for producers that are in the middle of a put, so do
+     * not spin here in case one of them has a lower priority */
+    vTaskDelay(1U);
+    return true;
+#elif (LPUART_LLD_TX_OVERFLOW_POLICY == LPUART_LLD_TX_OVERFLOW_OVERWRITE)
+    uint32_t committed;
+
+    /* only written slots may be given up: a preempted producer can own a
+     * reserved slot anywhere between tail and head, and the next reservation
+     * would land on it again. committed must be read before head, while they
+     * differ fall back to DROP for this char */
+    committed = __atomic_load_n(&lpuart_lld_tx_committed, __ATOMIC_ACQUIRE);
+    if (committed != __atomic_load_n(&lpuart_lld_tx_head, __ATOMIC_ACQUIRE))
+    {
+        lpuart_lld_tx_dropped_num++;
+        lpuart_lld_tx_kick();
+        return false;
+    }
+    /* fails if the DMA side or another producer moved the tail meanwhile,
+     * head cannot move before the tail does */
+    if (__atomic_compare_exchange_n(&lpuart_lld_tx_tail, &tail, tail + 1U,
+                                    false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+    {
+        lpuart_lld_tx_overwritten_num++;
+    }
+    return true;
+#else
+    (void)tail;
+    lpuart_lld_tx_dropped_num++;
+    lpuart_lld_tx_kick();
+    return false;
+#endif
+}
+
+void freertos_task_uart_rx(void *pvParameters)
+{
+    const TickType_t delay_tick_1ms = pdMS_TO_TICKS(1UL);
+    TickType_t last_wake_time = xTaskGetTickCount();
+    status_t rx_status;
+    uint8_t rxBuff[5];
+
+    (void) pvParameters;
+
+    rx_status = LPUART_DRV_ReceiveDataPolling(INST_LPUART1,rxBuff,1);
+
+    for(;;)
+    {
+        if(STATUS_SUCCESS == rx_status)
+        {
+            lpuart_lld_data_received_flg = 1U;
+            memcpy(lpuart_lld_rx_data, rxBuff, 1);
+            printf("UART received data: %s\n", lpuart_lld_rx_data);
+            rx_status = LPUART_DRV_ReceiveDataPolling(INST_LPUART1,rxBuff,1);
+            lpuart_lld_rx_bytes_num += 5U;
+        }
+        vTaskDelayUntil(&last_wake_time, delay_tick_1ms);
+    }
+}
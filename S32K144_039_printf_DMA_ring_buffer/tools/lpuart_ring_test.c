@@ -0,0 +1,458 @@
+/* Host unit test and benchmark of the LPUART TX ring buffer. lpuart_lld.c is
+ * built as it is into this file, so the test sees its indexes, and a mock
+ * UART stands in for the LPUART DMA driver: a thread takes the chunk of
+ * LPUART_DRV_SendData(), calls the TX_EMPTY callback like the DMA interrupt
+ * and the END_TRANSFER one when nothing was chained. With -b it holds every
+ * chunk for its time on the wire, else the wire is as fast as the thread.
+ *
+ *   order     one producer, the output is the input without the chars the
+ *             policy gave up, and the counters account for every char
+ *   reserved  a slot is reserved and not written, as by a preempted
+ *             producer, while the ring fills up: the tail must stop in front
+ *             of it and the char must come out once, where it was reserved
+ *   stress    producer threads put chars tagged with their number and a
+ *             sequence, each producer's chars come out in order, with BLOCK
+ *             all of them
+ *   bench     ns per lpuart_lld_tx_put() in the caller for 1, 2 and 4
+ *             producers, against the blocking put of one char per 10 bit
+ *             times at 115200 baud
+ * The policy is the one the test is built with. Exit status 1 on a failed
+ * check.
+ *
+ * build: gcc -O2 -Wall -pthread -DLPUART_LLD_TX_OVERFLOW_POLICY=2 -I.. -I../../S32K144_057_CAN_socketcan/host
+ *            -o lpuart_ring_test lpuart_ring_test.c
+ *        (policy 0 drop, 1 block, 2 overwrite)
+ * usage: lpuart_ring_test [-n chars per producer] [-b baud]
+ */
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "lpuart_lld.c"
+
+#define TEST_OUT_MAX (16U * 1024U * 1024U)
+#define TEST_PRODUCER_MAX 4U
+#define TEST_BAUD_BOARD 115200U
+
+static uint8_t test_out[TEST_OUT_MAX];
+static uint32_t test_out_len;
+static uint32_t test_error = 0U;
+static uint32_t test_check_num = 0U;
+static uint32_t test_baud = 0U;
+
+#define TEST_CHECK(cond, ...) do { test_check_num++; if (!(cond)) { printf("FAIL: " __VA_ARGS__); printf("\n"); test_error++; } } while (0)
+
+/* mock UART, the lock stands for the driver state */
+static pthread_mutex_t test_uart_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t test_uart_cond = PTHREAD_COND_INITIALIZER;
+static const uint8_t *test_uart_buf;
+static uint32_t test_uart_len;
+static bool test_uart_busy = false;
+static bool test_uart_hold = false;
+static uint32_t test_uart_chunk_num;
+
+lpuart_state_t lpuart1_State;
+const lpuart_user_config_t lpuart1_InitConfig0 = {TEST_BAUD_BOARD};
+static S32_SCB_Type test_scb;
+S32_SCB_Type *const S32_SCB = &test_scb;
+
+static uint64_t test_ns(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return ((uint64_t)t.tv_sec * 1000000000ULL) + (uint64_t)t.tv_nsec;
+}
+
+status_t LPUART_DRV_SendData(uint32_t instance, const uint8_t *txBuff, uint32_t txSize)
+{
+    (void)instance;
+    pthread_mutex_lock(&test_uart_lock);
+    if (test_uart_busy)
+    {
+        pthread_mutex_unlock(&test_uart_lock);
+        return STATUS_BUSY;
+    }
+    test_uart_busy = true;
+    test_uart_buf = txBuff;
+    test_uart_len = txSize;
+    pthread_cond_signal(&test_uart_cond);
+    pthread_mutex_unlock(&test_uart_lock);
+    return STATUS_SUCCESS;
+}
+
+/* only called from the TX_EMPTY callback, in the UART thread */
+status_t LPUART_DRV_SetTxBuffer(uint32_t instance, const uint8_t *txBuff, uint32_t txSize)
+{
+    (void)instance;
+    test_uart_buf = txBuff;
+    test_uart_len = txSize;
+    return STATUS_SUCCESS;
+}
+
+status_t LPUART_DRV_GetTransmitStatus(uint32_t instance, uint32_t *bytesRemaining)
+{
+    bool busy;
+
+    (void)instance;
+    pthread_mutex_lock(&test_uart_lock);
+    busy = test_uart_busy;
+    pthread_mutex_unlock(&test_uart_lock);
+    *bytesRemaining = 0U;
+    return busy ? STATUS_BUSY : STATUS_SUCCESS;
+}
+
+status_t LPUART_DRV_Init(uint32_t instance, lpuart_state_t *lpuartStatePtr,
+                         const lpuart_user_config_t *lpuartUserConfig)
+{
+    (void)instance;
+    (void)lpuartStatePtr;
+    (void)lpuartUserConfig;
+    return STATUS_SUCCESS;
+}
+
+uart_callback_t LPUART_DRV_InstallTxCallback(uint32_t instance, uart_callback_t function, void *callbackParam)
+{
+    (void)instance;
+    (void)function;
+    (void)callbackParam;
+    return NULL;
+}
+
+status_t LPUART_DRV_ReceiveDataPolling(uint32_t instance, uint8_t *rxBuff, uint32_t rxSize)
+{
+    (void)instance;
+    (void)rxBuff;
+    (void)rxSize;
+    return STATUS_BUSY;
+}
+
+void INT_SYS_SetPriority(IRQn_Type irqNumber, uint8_t priority)
+{
+    (void)irqNumber;
+    (void)priority;
+}
+
+BaseType_t xTaskGetSchedulerState(void)
+{
+    return taskSCHEDULER_RUNNING;
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(test_ns() / (1000000000ULL / configTICK_RATE_HZ));
+}
+
+void vTaskDelay(TickType_t xTicksToDelay)
+{
+    usleep((useconds_t)(xTicksToDelay * (1000000U / configTICK_RATE_HZ)));
+}
+
+void vTaskDelayUntil(TickType_t *pxPreviousWakeTime, TickType_t xTimeIncrement)
+{
+    *pxPreviousWakeTime += xTimeIncrement;
+    vTaskDelay(xTimeIncrement);
+}
+
+/* the DMA channel and its interrupt: one chunk after the other, the next one
+ * chained from TX_EMPTY */
+static void *test_uart_thread(void *arg)
+{
+    uint64_t end;
+
+    (void)arg;
+    for (;;)
+    {
+        pthread_mutex_lock(&test_uart_lock);
+        while (!test_uart_busy || test_uart_hold)
+        {
+            pthread_cond_wait(&test_uart_cond, &test_uart_lock);
+        }
+        pthread_mutex_unlock(&test_uart_lock);
+
+        do
+        {
+            if (test_baud != 0U)
+            {
+                end = test_ns() + (((uint64_t)test_uart_len * 10U * 1000000000ULL) / test_baud);
+                while (test_ns() < end)
+                {
+                }
+            }
+            if ((test_out_len + test_uart_len) <= TEST_OUT_MAX)
+            {
+                memcpy(&test_out[test_out_len], test_uart_buf, test_uart_len);
+                test_out_len += test_uart_len;
+            }
+            test_uart_chunk_num++;
+            test_uart_len = 0U;
+            lpuart_lld_tx_cbk_func(NULL, UART_EVENT_TX_EMPTY, NULL);
+        } while (test_uart_len != 0U);
+
+        pthread_mutex_lock(&test_uart_lock);
+        test_uart_busy = false;
+        pthread_mutex_unlock(&test_uart_lock);
+        lpuart_lld_tx_cbk_func(NULL, UART_EVENT_END_TRANSFER, NULL);
+    }
+    return NULL;
+}
+
+#if (LPUART_LLD_TX_OVERFLOW_POLICY != LPUART_LLD_TX_OVERFLOW_BLOCK)
+static void test_uart_set_hold(bool hold)
+{
+    pthread_mutex_lock(&test_uart_lock);
+    test_uart_hold = hold;
+    pthread_cond_signal(&test_uart_cond);
+    pthread_mutex_unlock(&test_uart_lock);
+}
+#endif
+
+static void test_reset(void)
+{
+    lpuart_lld_tx_flush();
+    test_out_len = 0U;
+    test_uart_chunk_num = 0U;
+    lpuart_lld_tx_dropped_num = 0U;
+    lpuart_lld_tx_overwritten_num = 0U;
+}
+
+/* true if a is b with chars left out */
+static bool test_subsequence(const uint8_t *a, uint32_t a_len, const uint8_t *b, uint32_t b_len)
+{
+    uint32_t i = 0U;
+    uint32_t j;
+
+    for (j = 0U; (j < b_len) && (i < a_len); j++)
+    {
+        if (a[i] == b[j])
+        {
+            i++;
+        }
+    }
+    return i == a_len;
+}
+
+static void test_order(uint32_t num)
+{
+    uint8_t *in = malloc(num);
+    uint32_t lost;
+    uint32_t i;
+
+    test_reset();
+    for (i = 0U; i < num; i++)
+    {
+        in[i] = (uint8_t)(' ' + ((i * 7U) % 95U));
+        lpuart_lld_tx_put(in[i]);
+    }
+    lpuart_lld_tx_flush();
+
+    lost = lpuart_lld_tx_dropped_num + lpuart_lld_tx_overwritten_num;
+    TEST_CHECK((test_out_len + lost) == num, "order: %u out + %u lost of %u chars", test_out_len, lost, num);
+    TEST_CHECK(test_subsequence(test_out, test_out_len, in, num), "order: output is not the input in order");
+#if (LPUART_LLD_TX_OVERFLOW_POLICY == LPUART_LLD_TX_OVERFLOW_BLOCK)
+    TEST_CHECK(lost == 0U, "order: BLOCK lost %u chars", lost);
+#endif
+    TEST_CHECK((lpuart_lld_tx_head == lpuart_lld_tx_committed) && (lpuart_lld_tx_head == lpuart_lld_tx_tail),
+               "order: ring not empty after the flush");
+    printf("order:    %u chars, %u out, %u dropped, %u overwritten, %u DMA chunks\n", num, test_out_len,
+           lpuart_lld_tx_dropped_num, lpuart_lld_tx_overwritten_num, test_uart_chunk_num);
+    free(in);
+}
+
+/* BLOCK would wait for the reserved slot for ever, like a task spinning on a
+ * lower priority one, there is nothing to check */
+static void test_reserved(void)
+{
+#if (LPUART_LLD_TX_OVERFLOW_POLICY != LPUART_LLD_TX_OVERFLOW_BLOCK)
+    uint32_t reserved;
+    uint32_t i;
+    uint32_t r_num = 0U;
+    uint32_t r_pos = 0U;
+    bool passed = false;
+
+    test_reset();
+    test_uart_set_hold(true);
+    for (i = 0U; i < 100U; i++)
+    {
+        lpuart_lld_tx_put('a');
+    }
+    /* what lpuart_lld_tx_put() does up to the write of the char */
+    reserved = __atomic_fetch_add(&lpuart_lld_tx_head, 1U, __ATOMIC_ACQ_REL);
+    for (i = 0U; i < (2U * LPUART_LLD_TX_BUF_SIZE); i++)
+    {
+        lpuart_lld_tx_put('b');
+        if ((int32_t)(reserved - lpuart_lld_tx_tail) < 0)
+        {
+            passed = true;
+        }
+    }
+    TEST_CHECK(!passed, "reserved: the tail passed the reserved slot");
+    TEST_CHECK(lpuart_lld_tx_dropped_num > 0U, "reserved: nothing dropped while the slot was reserved");
+    lpuart_lld_tx_buf[reserved & LPUART_LLD_TX_BUF_MASK] = 'R';
+    (void)__atomic_fetch_add(&lpuart_lld_tx_committed, 1U, __ATOMIC_RELEASE);
+    lpuart_lld_tx_kick();
+    test_uart_set_hold(false);
+    lpuart_lld_tx_flush();
+
+    for (i = 0U; i < test_out_len; i++)
+    {
+        if (test_out[i] == 'R')
+        {
+            r_num++;
+            r_pos = i;
+        }
+    }
+    TEST_CHECK(r_num == 1U, "reserved: the reserved char came out %u times", r_num);
+    TEST_CHECK((r_num != 1U) || (r_pos == 100U), "reserved: the reserved char came out at %u, not after the 100 a",
+               r_pos);
+    TEST_CHECK((test_out_len + lpuart_lld_tx_dropped_num + lpuart_lld_tx_overwritten_num) ==
+               (101U + (2U * LPUART_LLD_TX_BUF_SIZE)), "reserved: %u out + %u lost", test_out_len,
+               lpuart_lld_tx_dropped_num + lpuart_lld_tx_overwritten_num);
+    printf("reserved: %u out, %u dropped, %u overwritten, reserved char at %u\n", test_out_len,
+           lpuart_lld_tx_dropped_num, lpuart_lld_tx_overwritten_num, r_pos);
+#endif
+}
+
+typedef struct
+{
+    uint32_t index;
+    uint32_t num;
+    uint64_t ns;
+} test_producer_t;
+
+/* chars of producer p are p << 6 | sequence & 0x3F */
+static void *test_producer_thread(void *arg)
+{
+    test_producer_t *p = arg;
+    uint64_t start = test_ns();
+    uint32_t i;
+
+    for (i = 0U; i < p->num; i++)
+    {
+        lpuart_lld_tx_put((uint8_t)((p->index << 6) | (i & 0x3FU)));
+    }
+    p->ns = test_ns() - start;
+    return NULL;
+}
+
+static uint64_t test_run(uint32_t producers, uint32_t num)
+{
+    test_producer_t p[TEST_PRODUCER_MAX];
+    pthread_t thread[TEST_PRODUCER_MAX];
+    uint64_t ns = 0U;
+    uint32_t i;
+
+    test_reset();
+    for (i = 0U; i < producers; i++)
+    {
+        p[i].index = i;
+        p[i].num = num;
+        pthread_create(&thread[i], NULL, test_producer_thread, &p[i]);
+    }
+    for (i = 0U; i < producers; i++)
+    {
+        pthread_join(thread[i], NULL);
+        ns += p[i].ns;
+    }
+    lpuart_lld_tx_flush();
+    return ns;
+}
+
+static void test_stress(uint32_t num)
+{
+    uint32_t next[TEST_PRODUCER_MAX] = {0U};
+    uint32_t got[TEST_PRODUCER_MAX] = {0U};
+    uint32_t bad = 0U;
+    uint32_t i;
+    uint32_t p;
+
+    (void)test_run(TEST_PRODUCER_MAX, num);
+    for (i = 0U; i < test_out_len; i++)
+    {
+        p = test_out[i] >> 6;
+        /* a gap of a multiple of 64 chars goes unseen, it is rare enough */
+        if ((test_out[i] & 0x3FU) != (next[p] & 0x3FU))
+        {
+#if (LPUART_LLD_TX_OVERFLOW_POLICY == LPUART_LLD_TX_OVERFLOW_BLOCK)
+            bad++;
+#else
+            next[p] += (uint32_t)((test_out[i] - next[p]) & 0x3FU);
+#endif
+        }
+        next[p]++;
+        got[p]++;
+    }
+    for (p = 0U; p < TEST_PRODUCER_MAX; p++)
+    {
+        TEST_CHECK(next[p] <= num, "stress: producer %u out of order, at %u of %u", p, next[p], num);
+#if (LPUART_LLD_TX_OVERFLOW_POLICY == LPUART_LLD_TX_OVERFLOW_BLOCK)
+        TEST_CHECK(got[p] == num, "stress: producer %u, %u of %u chars out", p, got[p], num);
+#endif
+    }
+    TEST_CHECK(bad == 0U, "stress: %u chars out of order", bad);
+    TEST_CHECK(test_out_len <= (TEST_PRODUCER_MAX * num), "stress: %u chars out of %u", test_out_len,
+               TEST_PRODUCER_MAX * num);
+    TEST_CHECK((lpuart_lld_tx_head == lpuart_lld_tx_committed) && (lpuart_lld_tx_head == lpuart_lld_tx_tail),
+               "stress: ring not empty after the flush");
+    printf("stress:   %u producers x %u chars, %u out, %u dropped, %u overwritten\n", TEST_PRODUCER_MAX, num,
+           test_out_len, lpuart_lld_tx_dropped_num, lpuart_lld_tx_overwritten_num);
+}
+
+static void test_bench(uint32_t num)
+{
+    static const uint32_t producers[3] = {1U, 2U, 4U};
+    uint64_t ns;
+    uint32_t i;
+
+    for (i = 0U; i < 3U; i++)
+    {
+        ns = test_run(producers[i], num);
+        printf("bench:    %u producers, %.1f ns per put, %u of %u chars out\n", producers[i],
+               (double)ns / ((double)producers[i] * num), test_out_len, producers[i] * num);
+    }
+    printf("bench:    blocking put at %u baud, %.0f ns per char\n", TEST_BAUD_BOARD,
+           10.0 * 1e9 / TEST_BAUD_BOARD);
+}
+
+int main(int argc, char **argv)
+{
+    static const char *const policy[3] = {"DROP", "BLOCK", "OVERWRITE"};
+    uint32_t num = 1000000U;
+    pthread_t thread;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:b:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            num = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'b':
+            test_baud = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-n chars per producer] [-b baud]\n", argv[0]);
+            return 2;
+        }
+    }
+    if ((num == 0U) || ((num * TEST_PRODUCER_MAX) > TEST_OUT_MAX))
+    {
+        fprintf(stderr, "1 to %u chars per producer\n", TEST_OUT_MAX / TEST_PRODUCER_MAX);
+        return 2;
+    }
+
+    printf("policy %s, ring %u, DMA chunk %u, wire %u baud\n", policy[LPUART_LLD_TX_OVERFLOW_POLICY],
+           LPUART_LLD_TX_BUF_SIZE, LPUART_LLD_TX_DMA_CHUNK_SIZE, test_baud);
+    lpuart_lld_init();
+    pthread_create(&thread, NULL, test_uart_thread, NULL);
+
+    test_order(num);
+    test_reserved();
+    test_stress(num);
+    test_bench(num);
+    printf("%s, %u checks, %u errors\n", (test_error == 0U) ? "PASS" : "FAIL", test_check_num, test_error);
+    return (test_error == 0U) ? 0 : 1;
+}
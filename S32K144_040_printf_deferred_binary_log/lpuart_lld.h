@@ -0,0 +1,44 @@
+#ifndef LPUART_LLD_H
+#define LPUART_LLD_H
+
+#include "lpuart1.h"
+#include "FreeRTOS.h"
+#include "printf.h"
+#include "string.h"
+#include "task.h"
+
+/* printf output goes to the TX ring buffer and is drained by DMA channel 1,
+ * set to 0 to fall back to the blocking LPUART_DRV_SendDataBlocking() per char */
+#ifndef LPUART_LLD_TX_BUFFER_ENABLE
+#define LPUART_LLD_TX_BUFFER_ENABLE 1
+#endif
+
+/* size of the TX ring buffer, must be a power of 2 */
+#define LPUART_LLD_TX_BUF_SIZE 1024U
+/* max bytes handed to the DMA in one transfer */
+#define LPUART_LLD_TX_DMA_CHUNK_SIZE 64U
+
+/* what to do with a new char when the TX ring buffer is full */
+#define LPUART_LLD_TX_OVERFLOW_DROP      0 /* drop the new char */
+#define LPUART_LLD_TX_OVERFLOW_BLOCK     1 /* wait for the DMA to free space, tasks only */
+#define LPUART_LLD_TX_OVERFLOW_OVERWRITE 2 /* discard the oldest queued chars */
+#ifndef LPUART_LLD_TX_OVERFLOW_POLICY
+#define LPUART_LLD_TX_OVERFLOW_POLICY LPUART_LLD_TX_OVERFLOW_DROP
+#endif
+
+extern uint32_t lpuart_lld_rx_bytes_num;
+extern uint8_t lpuart_lld_data_received_flg;
+extern uint8_t lpuart_lld_rx_data[5];
+extern uint32_t lpuart_lld_tx_dropped_num;
+extern uint32_t lpuart_lld_tx_overwritten_num;
+extern uint32_t lpuart_lld_tx_error_num;
+
+void lpuart_lld_init(void);
+void lpuart_lld_step(void);
+void lpuart_lld_tx_put(uint8_t data);
+bool lpuart_lld_tx_write(const uint8_t *data, uint32_t len);
+uint32_t lpuart_lld_tx_pending(void);
+void lpuart_lld_tx_flush(void);
+void lpuart_lld_tx_cbk_func(void *driverState, uart_event_t event, void *userData);
+
+#endif
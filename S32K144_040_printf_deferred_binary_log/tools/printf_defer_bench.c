@@ -0,0 +1,333 @@
+/* Host benchmark and test of printf_defer(). printf.c is built as it is into
+ * this file, the UART ring buffer is replaced by a counter of the bytes, so
+ * only the cost of the formatting is measured.
+ *
+ * The load is the periodic dump of the board: "running time" and the 14
+ * can_lld_*_num lines of can_lld_step(), with counters that keep growing.
+ * It is run through
+ *   printf      text rendered char by char into lpuart_lld_tx_put()
+ *   vsnprintf   text rendered into a buffer, _vsnprintf alone
+ *   defer       printf_defer() records into lpuart_lld_tx_write()
+ * and the ns per line and bytes per line are printed. Then the records of
+ * another run are checked: marker, length, format address, time stamp and
+ * the zigzag varint of the argument. Exit status 1 on a failed check.
+ *
+ * With -o the records of one dump are written to name.bin together with
+ * name.elf, a 32 bit ELF file that holds the format strings at the
+ * addresses of the records, and the expected text to name.txt:
+ *   printf_defer_decoder name.elf name.bin | cut -c 15- | diff - name.txt
+ * The binary must be linked without PIE, so the addresses fit in 32 bits.
+ *
+ * build: gcc -O2 -Wall -no-pie -fno-pie -I.. -I../../S32K144_057_CAN_socketcan/host
+ *            -o printf_defer_bench printf_defer_bench.c
+ * usage: printf_defer_bench [-n dumps] [-o name]
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "printf.c"
+/* the output of the bench goes to stdout, not to the printf under test */
+#undef printf
+#undef snprintf
+
+#define BENCH_LINE_NUM 15U
+#define BENCH_RECORD_MAX 64U
+
+/* the periodic dump of rtos.c and can_lld.c, in the order of the board */
+static const char *const bench_format[BENCH_LINE_NUM] =
+{
+    "running time: %ds\n",
+    "CAN event number: %d\n",
+    "can_lld_rx_complete_num: %d\n",
+    "can_lld_rx_fifo_compete_num: %d\n",
+    "can_lld_rx_fifo_warning_num: %d\n",
+    "can_lld_rx_fifo_overflow_num: %d\n",
+    "can_lld_tx_complete_num: %d\n",
+    "can_lld_wake_up_timeout_num: %d\n",
+    "can_lld_wake_up_match_num: %d\n",
+    "can_lld_self_wake_up_num: %d\n",
+    "can_lld_dma_complete_num: %d\n",
+    "can_lld_dma_error_num: %d\n",
+    "can_lld_error_num: %d\n",
+    "can_lld_default1_num: %d\n",
+    "can_lld_default2_num: %d\n"
+};
+
+/* counter growth per dump, the running time and busy RX and TX */
+static const int bench_step[BENCH_LINE_NUM] = {1, 1000, 500, 500, 0, 0, 500, 0, 0, 0, 0, 0, 1, 0, 0};
+
+static uint64_t bench_bytes;
+static uint32_t bench_tick;
+static uint8_t bench_record[BENCH_RECORD_MAX];
+static uint32_t bench_record_len;
+static FILE *bench_capture;
+static uint32_t test_error = 0U;
+static uint32_t test_check_num = 0U;
+
+#define TEST_CHECK(cond, ...) do { test_check_num++; if (!(cond)) { printf("FAIL: " __VA_ARGS__); printf("\n"); test_error++; } } while (0)
+
+/* the ring buffer of lpuart_lld.c and the tick of FreeRTOS */
+
+void lpuart_lld_tx_put(uint8_t data)
+{
+    (void)data;
+    bench_bytes++;
+}
+
+bool lpuart_lld_tx_write(const uint8_t *data, uint32_t len)
+{
+    bench_bytes += len;
+    bench_record_len = (len <= BENCH_RECORD_MAX) ? len : BENCH_RECORD_MAX;
+    memcpy(bench_record, data, bench_record_len);
+    if (bench_capture != NULL)
+    {
+        (void)fwrite(data, 1U, len, bench_capture);
+    }
+    return true;
+}
+
+TickType_t xTaskGetTickCountFromISR(void)
+{
+    return bench_tick;
+}
+
+static uint64_t bench_ns(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return ((uint64_t)t.tv_sec * 1000000000ULL) + (uint64_t)t.tv_nsec;
+}
+
+static uint32_t bench_uvar(const uint8_t *p, uint32_t len, uint32_t *idx, bool *ok)
+{
+    uint32_t value = 0U;
+    uint32_t shift = 0U;
+
+    while ((*idx < len) && (shift < 35U))
+    {
+        value |= (uint32_t)(p[*idx] & 0x7FU) << shift;
+        if ((p[(*idx)++] & 0x80U) == 0U)
+        {
+            return value;
+        }
+        shift += 7U;
+    }
+    *ok = false;
+    return 0U;
+}
+
+/* the record the last printf_defer() sent must carry what it was called with */
+static void bench_check_record(const char *format, int value)
+{
+    uint32_t idx = 2U;
+    uint32_t addr;
+    uint32_t stamp;
+    uint32_t arg;
+    bool ok = true;
+
+    TEST_CHECK((bench_record_len > 2U) && (bench_record[0] == 0x00U) &&
+               (bench_record[1] == (bench_record_len - 2U)), "%s: bad record header", format);
+    addr = bench_uvar(bench_record, bench_record_len, &idx, &ok);
+    stamp = (idx + 2U <= bench_record_len) ? (bench_record[idx] | ((uint32_t)bench_record[idx + 1U] << 8)) : 0U;
+    idx += 2U;
+    arg = bench_uvar(bench_record, bench_record_len, &idx, &ok);
+    TEST_CHECK(ok && (idx == bench_record_len), "%s: record of %u bytes cut", format, bench_record_len);
+    TEST_CHECK(addr == (uint32_t)(uintptr_t)format, "%s: format address 0x%08X", format, addr);
+    TEST_CHECK(stamp == (bench_tick & 0xFFFFU), "%s: time stamp %u", format, stamp);
+    TEST_CHECK((int)((arg >> 1) ^ (0U - (arg & 1U))) == value, "%s: argument %u", format, arg);
+}
+
+static int bench_vsnprintf(char *buf, size_t len, const char *format, ...)
+{
+    va_list va;
+    int ret;
+
+    va_start(va, format);
+    ret = _vsnprintf(_out_buffer, buf, len, format, va);
+    va_end(va);
+    return ret;
+}
+
+typedef enum
+{
+    BENCH_PRINTF = 0,
+    BENCH_VSNPRINTF,
+    BENCH_DEFER,
+    BENCH_MODE_NUM
+} bench_mode_t;
+
+static void bench_run(bench_mode_t mode, uint32_t dumps, bool check)
+{
+    static const char *const name[BENCH_MODE_NUM] = {"printf", "vsnprintf", "defer"};
+    int value[BENCH_LINE_NUM] = {0};
+    char text[64];
+    uint64_t start;
+    uint64_t ns;
+    uint32_t d;
+    uint32_t i;
+
+    bench_bytes = 0U;
+    start = bench_ns();
+    for (d = 0U; d < dumps; d++)
+    {
+        bench_tick += 10000U;
+        for (i = 0U; i < BENCH_LINE_NUM; i++)
+        {
+            value[i] += bench_step[i];
+            switch (mode)
+            {
+            case BENCH_PRINTF:
+                (void)printf_(bench_format[i], value[i]);
+                break;
+            case BENCH_VSNPRINTF:
+                bench_bytes += (uint32_t)bench_vsnprintf(text, sizeof(text), bench_format[i], value[i]);
+                break;
+            default:
+                (void)printf_defer(bench_format[i], value[i]);
+                if (check)
+                {
+                    bench_check_record(bench_format[i], value[i]);
+                }
+                break;
+            }
+        }
+    }
+    ns = bench_ns() - start;
+    if (check)
+    {
+        return;
+    }
+    printf("%-9s %7.1f ns per line, %5.1f bytes per line\n", name[mode],
+           (double)ns / ((double)dumps * BENCH_LINE_NUM), (double)bench_bytes / ((double)dumps * BENCH_LINE_NUM));
+}
+
+static void bench_le32(uint8_t *p, uint32_t value)
+{
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+}
+
+/* one ALLOC section from the lowest to the highest format address, a null
+ * section in front as the section index 0 */
+static bool bench_write_elf(const char *path)
+{
+    uint8_t header[52] = {0x7FU, 'E', 'L', 'F', 1U, 1U, 1U};
+    uint8_t section[2][40];
+    uintptr_t lo = UINTPTR_MAX;
+    uintptr_t hi = 0U;
+    FILE *fp;
+    uint32_t i;
+
+    for (i = 0U; i < BENCH_LINE_NUM; i++)
+    {
+        if ((uintptr_t)bench_format[i] < lo)
+        {
+            lo = (uintptr_t)bench_format[i];
+        }
+        if (((uintptr_t)bench_format[i] + strlen(bench_format[i]) + 1U) > hi)
+        {
+            hi = (uintptr_t)bench_format[i] + strlen(bench_format[i]) + 1U;
+        }
+    }
+    memset(section, 0, sizeof(section));
+    bench_le32(&section[1][4], 1U);                     /* PROGBITS */
+    bench_le32(&section[1][8], 2U);                     /* ALLOC */
+    bench_le32(&section[1][12], (uint32_t)lo);
+    bench_le32(&section[1][16], sizeof(header) + sizeof(section));
+    bench_le32(&section[1][20], (uint32_t)(hi - lo));
+    bench_le32(&header[32], sizeof(header));
+    header[46] = sizeof(section[0]);
+    header[48] = 2U;
+
+    fp = fopen(path, "wb");
+    if (fp == NULL)
+    {
+        return false;
+    }
+    (void)fwrite(header, 1U, sizeof(header), fp);
+    (void)fwrite(section, 1U, sizeof(section), fp);
+    (void)fwrite((const void *)lo, 1U, hi - lo, fp);
+    return fclose(fp) == 0;
+}
+
+static bool bench_write(const char *name)
+{
+    char path[256];
+    FILE *text;
+    uint32_t i;
+
+    (void)snprintf(path, sizeof(path), "%s.bin", name);
+    bench_capture = fopen(path, "wb");
+    (void)snprintf(path, sizeof(path), "%s.txt", name);
+    text = fopen(path, "w");
+    if ((bench_capture == NULL) || (text == NULL))
+    {
+        return false;
+    }
+    for (i = 0U; i < BENCH_LINE_NUM; i++)
+    {
+        bench_tick += 7U;
+        (void)printf_defer(bench_format[i], (int)(i * 100000U) - 7);
+        fprintf(text, bench_format[i], (int)(i * 100000U) - 7);
+    }
+    fclose(bench_capture);
+    bench_capture = NULL;
+    fclose(text);
+    (void)snprintf(path, sizeof(path), "%s.elf", name);
+    return bench_write_elf(path);
+}
+
+int main(int argc, char **argv)
+{
+    const char *name = NULL;
+    uint32_t dumps = 200000U;
+    bench_mode_t mode;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:o:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            dumps = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'o':
+            name = optarg;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-n dumps] [-o name]\n", argv[0]);
+            return 2;
+        }
+    }
+    if ((uintptr_t)bench_format[0] > UINT32_MAX)
+    {
+        fprintf(stderr, "format strings above 4 GB, link with -no-pie\n");
+        return 2;
+    }
+
+    if (name != NULL)
+    {
+        if (!bench_write(name))
+        {
+            perror(name);
+            return 1;
+        }
+        printf("%s.bin: %u records\n", name, BENCH_LINE_NUM);
+        return 0;
+    }
+
+    printf("%u dumps of %u lines\n", dumps, BENCH_LINE_NUM);
+    for (mode = BENCH_PRINTF; mode < BENCH_MODE_NUM; mode++)
+    {
+        bench_run(mode, dumps, false);
+    }
+    bench_run(BENCH_DEFER, dumps, true);
+    printf("%s, %u checks, %u errors\n", (test_error == 0U) ? "PASS" : "FAIL", test_check_num, test_error);
+    return (test_error == 0U) ? 0 : 1;
+}
@@ -0,0 +1,495 @@
+/* Host side decoder for the printf_defer() records.
+ *
+ * The target sends normal printf text and binary records on the same UART,
+ * a record starts with 0x00 which never shows up in the text. The format
+ * strings are looked up by address in the ELF file of the firmware.
+ *
+ * build: gcc -O2 -o printf_defer_decoder printf_defer_decoder.c
+ * usage: printf_defer_decoder [-t tick_hz] firmware.elf [capture.bin]
+ *        capture defaults to stdin, e.g. a raw dump of the serial port
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFER_MARKER 0x00U
+#define DEFER_TIMESTAMP_DEFAULT_HZ 10000U
+#define SPEC_SIZE 32U
+
+#define ELF_SHT_NOBITS 8U
+#define ELF_SHF_ALLOC 2U
+
+typedef struct
+{
+    uint32_t addr;
+    uint32_t size;
+    uint32_t offset;
+} elf_section_t;
+
+typedef struct
+{
+    const uint8_t *data;
+    uint32_t len;
+    uint32_t idx;
+} record_t;
+
+static uint8_t *elf_image;
+static long elf_size;
+static elf_section_t *elf_sections;
+static uint32_t elf_section_num;
+
+static uint32_t read_le(const uint8_t *p, uint32_t size)
+{
+    uint32_t value = 0U;
+
+    while (size--)
+    {
+        value = (value << 8U) | p[size];
+    }
+    return value;
+}
+
+static bool elf_load(const char *path)
+{
+    FILE *fp = fopen(path, "rb");
+    uint32_t shoff;
+    uint32_t shentsize;
+    uint32_t shnum;
+    uint32_t i;
+
+    if (fp == NULL)
+    {
+        return false;
+    }
+    fseek(fp, 0, SEEK_END);
+    elf_size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    elf_image = malloc((size_t)elf_size);
+    if ((elf_image == NULL) || (fread(elf_image, 1, (size_t)elf_size, fp) != (size_t)elf_size))
+    {
+        fclose(fp);
+        return false;
+    }
+    fclose(fp);
+
+    /* only 32 bit little endian, which is what arm-none-eabi-gcc produces */
+    if ((elf_size < 52) || (memcmp(elf_image, "\x7f" "ELF", 4) != 0) ||
+        (elf_image[4] != 1U) || (elf_image[5] != 1U))
+    {
+        return false;
+    }
+
+    shoff = read_le(&elf_image[32], 4U);
+    shentsize = read_le(&elf_image[46], 2U);
+    shnum = read_le(&elf_image[48], 2U);
+    if ((uint64_t)shoff + (uint64_t)shentsize * shnum > (uint64_t)elf_size)
+    {
+        return false;
+    }
+
+    elf_sections = calloc(shnum, sizeof(elf_section_t));
+    for (i = 0U; i < shnum; i++)
+    {
+        const uint8_t *sh = &elf_image[shoff + i * shentsize];
+        const uint32_t type = read_le(&sh[4], 4U);
+        const uint32_t flags = read_le(&sh[8], 4U);
+
+        if ((type != ELF_SHT_NOBITS) && ((flags & ELF_SHF_ALLOC) != 0U))
+        {
+            elf_sections[elf_section_num].addr = read_le(&sh[12], 4U);
+            elf_sections[elf_section_num].offset = read_le(&sh[16], 4U);
+            elf_sections[elf_section_num].size = read_le(&sh[20], 4U);
+            elf_section_num++;
+        }
+    }
+    return true;
+}
+
+/* @brief: Find the string at a target address
+ * @return: the string, NULL if the address is not in a loaded section
+ */
+static const char *elf_string(uint32_t addr)
+{
+    uint32_t i;
+
+    for (i = 0U; i < elf_section_num; i++)
+    {
+        const elf_section_t *sec = &elf_sections[i];
+
+        if ((addr >= sec->addr) && (addr - sec->addr < sec->size) &&
+            ((uint64_t)sec->offset + sec->size <= (uint64_t)elf_size))
+        {
+            const char *str = (const char *)&elf_image[sec->offset + addr - sec->addr];
+
+            /* must be terminated inside the section */
+            if (memchr(str, 0, sec->size - (addr - sec->addr)) != NULL)
+            {
+                return str;
+            }
+        }
+    }
+    return NULL;
+}
+
+static bool record_uvar(record_t *rec, uint64_t *value)
+{
+    uint32_t shift = 0U;
+
+    *value = 0U;
+    while ((rec->idx < rec->len) && (shift < 64U))
+    {
+        const uint8_t byte = rec->data[rec->idx++];
+
+        *value |= (uint64_t)(byte & 0x7FU) << shift;
+        if ((byte & 0x80U) == 0U)
+        {
+            return true;
+        }
+        shift += 7U;
+    }
+    return false;
+}
+
+static bool record_svar(record_t *rec, int64_t *value)
+{
+    uint64_t zigzag;
+
+    if (!record_uvar(rec, &zigzag))
+    {
+        return false;
+    }
+    *value = (int64_t)(zigzag >> 1U) ^ -(int64_t)(zigzag & 1U);
+    return true;
+}
+
+static bool record_word(record_t *rec, uint32_t *value, uint32_t size)
+{
+    if (rec->idx + size > rec->len)
+    {
+        return false;
+    }
+    *value = read_le(&rec->data[rec->idx], size);
+    rec->idx += size;
+    return true;
+}
+
+/* the target supports %b, the host printf does not */
+static void print_binary(const char *spec, uint64_t value)
+{
+    char digits[65];
+    char fmt[SPEC_SIZE];
+    int len = 0;
+    int width;
+    bool zero_pad = false;
+    bool left = false;
+    const char *p;
+
+    do
+    {
+        digits[len++] = (char)('0' + (value & 1U));
+        value >>= 1U;
+    } while (value != 0U);
+    digits[len] = '\0';
+    for (int i = 0; i < len / 2; i++)
+    {
+        const char tmp = digits[i];
+
+        digits[i] = digits[len - 1 - i];
+        digits[len - 1 - i] = tmp;
+    }
+
+    /* keep flags and width, drop precision, '0' pads by hand as %s can't */
+    for (p = &spec[1]; (*p == '0') || (*p == '-') || (*p == '+') || (*p == ' ') || (*p == '#'); p++)
+    {
+        zero_pad |= (*p == '0');
+        left |= (*p == '-');
+    }
+    width = atoi(p);
+    if (zero_pad && !left)
+    {
+        for (; len < width; len++)
+        {
+            putchar('0');
+        }
+        width = 0;
+    }
+    (void)snprintf(fmt, SPEC_SIZE, "%%%s%ds", left ? "-" : "", width);
+    printf(fmt, digits);
+}
+
+/* @brief: Render one record the same way _vsnprintf would on the target,
+ *         arguments cut off at the end of a full record show up as "<?>" */
+static void render(const char *format, record_t *rec)
+{
+    while (*format != '\0')
+    {
+        char spec[SPEC_SIZE];
+        uint32_t n = 0U;
+        char conv;
+
+        if (*format != '%')
+        {
+            putchar(*format++);
+            continue;
+        }
+
+        spec[n++] = *format++;
+        while ((*format == '0') || (*format == '-') || (*format == '+') || (*format == ' ') || (*format == '#'))
+        {
+            if (n < SPEC_SIZE - 8U)
+            {
+                spec[n++] = *format;
+            }
+            format++;
+        }
+        if (*format == '*')
+        {
+            int64_t width;
+
+            /* a missing width shows up as "<?>" at the argument */
+            if (record_svar(rec, &width))
+            {
+                n += (uint32_t)snprintf(&spec[n], SPEC_SIZE - 8U - n, "%d", (int)width);
+            }
+            format++;
+        }
+        while ((*format >= '0') && (*format <= '9'))
+        {
+            if (n < SPEC_SIZE - 8U)
+            {
+                spec[n++] = *format;
+            }
+            format++;
+        }
+        if (*format == '.')
+        {
+            spec[n++] = *format++;
+            if (*format == '*')
+            {
+                int64_t prec;
+
+                if (record_svar(rec, &prec))
+                {
+                    n += (uint32_t)snprintf(&spec[n], SPEC_SIZE - 8U - n, "%d", prec > 0 ? (int)prec : 0);
+                }
+                format++;
+            }
+            while ((*format >= '0') && (*format <= '9'))
+            {
+                if (n < SPEC_SIZE - 8U)
+                {
+                    spec[n++] = *format;
+                }
+                format++;
+            }
+        }
+        /* the record already holds the value truncated to the right size */
+        while ((*format == 'l') || (*format == 'h') || (*format == 't') || (*format == 'j') || (*format == 'z'))
+        {
+            format++;
+        }
+
+        conv = *format;
+        if (conv != '\0')
+        {
+            format++;
+        }
+
+        switch (conv)
+        {
+        case 'd':
+        case 'i':
+        {
+            int64_t value;
+
+            if (!record_svar(rec, &value))
+            {
+                fputs("<?>", stdout);
+                break;
+            }
+            strcpy(&spec[n], "lld");
+            printf(spec, (long long)value);
+            break;
+        }
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+        case 'b':
+        case 'p':
+        case 'c':
+        {
+            uint64_t value;
+
+            if (!record_uvar(rec, &value))
+            {
+                fputs("<?>", stdout);
+                break;
+            }
+            if (conv == 'b')
+            {
+                spec[n] = '\0';
+                print_binary(spec, value);
+            }
+            else if (conv == 'c')
+            {
+                strcpy(&spec[n], "c");
+                printf(spec, (int)value);
+            }
+            else if (conv == 'p')
+            {
+                /* target prints pointers as 8 upper case hex digits */
+                printf("%08llX", (unsigned long long)value);
+            }
+            else
+            {
+                spec[n++] = 'l';
+                spec[n++] = 'l';
+                spec[n++] = conv;
+                spec[n] = '\0';
+                printf(spec, (unsigned long long)value);
+            }
+            break;
+        }
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        {
+            union {
+                float F;
+                uint32_t U;
+            } conv_value;
+
+            if (!record_word(rec, &conv_value.U, 4U))
+            {
+                fputs("<?>", stdout);
+                break;
+            }
+            spec[n++] = conv;
+            spec[n] = '\0';
+            printf(spec, (double)conv_value.F);
+            break;
+        }
+        case 's':
+        {
+            uint32_t len;
+            char str[256];
+
+            if (!record_word(rec, &len, 1U) || (rec->idx + len > rec->len))
+            {
+                fputs("<?>", stdout);
+                break;
+            }
+            memcpy(str, &rec->data[rec->idx], len);
+            str[len] = '\0';
+            rec->idx += len;
+            strcpy(&spec[n], "s");
+            printf(spec, str);
+            break;
+        }
+        case '%':
+            putchar('%');
+            break;
+        case '\0':
+            break;
+        default:
+            putchar(conv);
+            break;
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    FILE *in = stdin;
+    double tick_hz = DEFER_TIMESTAMP_DEFAULT_HZ;
+    uint64_t timestamp = 0U;
+    uint32_t last_stamp = 0U;
+    bool first_record = true;
+    int argi = 1;
+    int c;
+
+    if ((argc > 2) && (strcmp(argv[1], "-t") == 0))
+    {
+        tick_hz = atof(argv[2]);
+        argi = 3;
+    }
+    if ((argi >= argc) || (tick_hz <= 0.0))
+    {
+        fprintf(stderr, "usage: %s [-t tick_hz] firmware.elf [capture.bin]\n", argv[0]);
+        return 1;
+    }
+    if (!elf_load(argv[argi]))
+    {
+        fprintf(stderr, "can not load 32 bit little endian ELF file %s\n", argv[argi]);
+        return 1;
+    }
+    if ((argi + 1 < argc) && ((in = fopen(argv[argi + 1], "rb")) == NULL))
+    {
+        fprintf(stderr, "can not open %s\n", argv[argi + 1]);
+        return 1;
+    }
+
+    while ((c = fgetc(in)) != EOF)
+    {
+        uint8_t payload[256];
+        record_t rec;
+        uint64_t addr;
+        uint32_t stamp;
+        const char *format;
+        int len;
+
+        if (c != DEFER_MARKER)
+        {
+            /* plain printf text */
+            putchar(c);
+            continue;
+        }
+
+        if (((len = fgetc(in)) == EOF) || (fread(payload, 1, (size_t)len, in) != (size_t)len))
+        {
+            break;
+        }
+        rec.data = payload;
+        rec.len = (uint32_t)len;
+        rec.idx = 0U;
+
+        if (!record_uvar(&rec, &addr) || !record_word(&rec, &stamp, 2U))
+        {
+            fputs("<broken record>\n", stdout);
+            continue;
+        }
+
+        /* 16 bit stamps, records from concurrent tasks may come slightly out of order */
+        if (first_record)
+        {
+            timestamp = stamp;
+            first_record = false;
+        }
+        else
+        {
+            timestamp += (uint64_t)(int64_t)(int16_t)(uint16_t)(stamp - last_stamp);
+        }
+        last_stamp = stamp;
+
+        printf("[%11.4f] ", (double)timestamp / tick_hz);
+        format = elf_string((uint32_t)addr);
+        if (format == NULL)
+        {
+            printf("<unknown format 0x%08llX>\n", (unsigned long long)addr);
+            continue;
+        }
+        render(format, &rec);
+    }
+
+    if (in != stdin)
+    {
+        fclose(in);
+    }
+    return 0;
+}
@@ -0,0 +1,147 @@
+#include "printf_lld.h"
+
+typedef struct
+{
+    uint16_t len;
+    char data[PRINTF_LLD_LINE_SIZE];
+} printf_lld_line_t;
+
+/* line buffer of one task, owner is NULL while the buffer is free.
+ * Tasks of this application are never deleted, so a buffer is never given back. */
+typedef struct
+{
+    TaskHandle_t owner;
+    printf_lld_line_t line;
+} printf_lld_task_buf_t;
+
+uint32_t printf_lld_line_dropped_num = 0U;
+uint32_t printf_lld_no_buffer_num = 0U;
+
+static QueueHandle_t printf_lld_queue = NULL;
+static printf_lld_task_buf_t printf_lld_task_buf[PRINTF_LLD_MAX_TASKS];
+/* the writer task copies one line at a time, keep it off its stack */
+static printf_lld_line_t printf_lld_writer_line;
+
+static printf_lld_task_buf_t *printf_lld_get_task_buf(void);
+static void printf_lld_emit(printf_lld_line_t *line);
+static void printf_lld_direct(const uint8_t *data, uint32_t len);
+
+void printf_lld_init(void)
+{
+    printf_lld_queue = xQueueCreate(PRINTF_LLD_QUEUE_LENGTH, sizeof(printf_lld_line_t));
+}
+
+/* @brief: Output one printf char, a task only ever writes into its own line
+ *         buffer, so lines of different tasks never tear
+ * @param data : char to send
+ * @return     : None
+ */
+void printf_lld_putchar(uint8_t data)
+{
+    printf_lld_task_buf_t *buf = printf_lld_get_task_buf();
+
+    if (buf == NULL)
+    {
+        printf_lld_direct(&data, 1U);
+        return;
+    }
+
+    buf->line.data[buf->line.len++] = (char)data;
+    if ((data == (uint8_t)'\n') || (buf->line.len >= PRINTF_LLD_LINE_SIZE))
+    {
+        printf_lld_emit(&buf->line);
+    }
+}
+
+/* @brief: Hand over the unfinished line of the calling task
+ * @return: None
+ */
+void printf_lld_flush(void)
+{
+    printf_lld_task_buf_t *buf = printf_lld_get_task_buf();
+
+    if ((buf != NULL) && (buf->line.len > 0U))
+    {
+        printf_lld_emit(&buf->line);
+    }
+}
+
+void freertos_task_printf(void *pvParameters)
+{
+    (void)pvParameters;
+
+    for (;;)
+    {
+        if (pdPASS == xQueueReceive(printf_lld_queue, &printf_lld_writer_line, portMAX_DELAY))
+        {
+#if LPUART_LLD_TX_BUFFER_ENABLE
+            /* wait for room here instead of letting the overflow policy drop the line */
+            while ((LPUART_LLD_TX_BUF_SIZE - lpuart_lld_tx_pending()) < printf_lld_writer_line.len)
+            {
+                vTaskDelay(1U);
+            }
+#endif
+            printf_lld_direct((const uint8_t *)printf_lld_writer_line.data, printf_lld_writer_line.len);
+        }
+    }
+}
+
+/* @brief: Find the line buffer of the calling task, claim one on its first printf
+ * @return: line buffer, NULL outside of a task or if all buffers are taken
+ */
+static printf_lld_task_buf_t *printf_lld_get_task_buf(void)
+{
+    TaskHandle_t self;
+    TaskHandle_t expected;
+    uint32_t i;
+
+    if ((printf_lld_queue == NULL) ||
+        ((S32_SCB->ICSR & S32_SCB_ICSR_VECTACTIVE_MASK) != 0U) ||
+        (xTaskGetSchedulerState() != taskSCHEDULER_RUNNING))
+    {
+        return NULL;
+    }
+
+    self = xTaskGetCurrentTaskHandle();
+    for (i = 0U; i < PRINTF_LLD_MAX_TASKS; i++)
+    {
+        if (printf_lld_task_buf[i].owner == self)
+        {
+            return &printf_lld_task_buf[i];
+        }
+    }
+
+    /* a higher priority task may claim a buffer in between, hence the CAS */
+    for (i = 0U; i < PRINTF_LLD_MAX_TASKS; i++)
+    {
+        expected = NULL;
+        if (__atomic_compare_exchange_n(&printf_lld_task_buf[i].owner, &expected, self,
+                                        false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+        {
+            printf_lld_task_buf[i].line.len = 0U;
+            return &printf_lld_task_buf[i];
+        }
+    }
+
+    printf_lld_no_buffer_num++;
+    return NULL;
+}
+
+static void printf_lld_emit(printf_lld_line_t *line)
+{
+    /* never wait for the writer task, a full queue loses the line */
+    if (pdPASS != xQueueSend(printf_lld_queue, line, 0U))
+    {
+        printf_lld_line_dropped_num++;
+    }
+    line->len = 0U;
+}
+
+static void printf_lld_direct(const uint8_t *data, uint32_t len)
+{
+#if LPUART_LLD_TX_BUFFER_ENABLE
+    (void)lpuart_lld_tx_write(data, len);
+#else
+    (void)LPUART_DRV_SendDataBlocking(INST_LPUART1, data, len, 100);
+#endif
+}
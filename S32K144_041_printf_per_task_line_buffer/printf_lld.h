@@ -0,0 +1,30 @@
+#ifndef PRINTF_LLD_H
+#define PRINTF_LLD_H
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "lpuart_lld.h"
+
+/* printf from a task is collected per task and sent line by line by the
+ * printf writer task, set to 0 to send every char straight to the UART */
+#ifndef PRINTF_LLD_LINE_BUFFER_ENABLE
+#define PRINTF_LLD_LINE_BUFFER_ENABLE 1
+#endif
+
+/* longer lines are split */
+#define PRINTF_LLD_LINE_SIZE 80U
+/* lines waiting for the writer task */
+#define PRINTF_LLD_QUEUE_LENGTH 8U
+/* tasks which can own a line buffer at the same time */
+#define PRINTF_LLD_MAX_TASKS 6U
+#define PRINTF_LLD_WRITER_PRIORITY (tskIDLE_PRIORITY + 1U)
+
+extern uint32_t printf_lld_line_dropped_num;
+extern uint32_t printf_lld_no_buffer_num;
+
+void printf_lld_init(void);
+void printf_lld_putchar(uint8_t data);
+void printf_lld_flush(void);
+
+#endif
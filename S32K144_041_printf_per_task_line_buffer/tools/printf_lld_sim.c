@@ -0,0 +1,609 @@
+/* Host simulation of the per-task printf line buffers on one CPU with fixed
+ * task priorities. Every FreeRTOS task is a SCHED_FIFO thread pinned to CPU
+ * 0 with the priority order of rtos_start(), the LPUART DMA interrupt is a
+ * thread above all of them, and the wire runs at 115200 baud in real time.
+ * printf.c, printf_lld.c and the lpuart_lld.c of S32K144_040 are built as
+ * they are.
+ *
+ *   1ms      priority 4, wakes every 1 ms, its release latency is measured,
+ *            with -p it prints a short line itself and the time spent in
+ *            printf is measured too
+ *   100ms    priority 3, one line every 100 ms
+ *   1000ms   priority 2, a burst of -l lines every 1000 ms
+ *   uart rx  priority 1, one line every 20 ms
+ *   printf   priority 1, the writer task
+ * The lines carry the task, a sequence number and a payload made from both,
+ * so the output on the wire shows every torn or lost line. The 1 ms task is
+ * measured for a second without any printf first, then with the load.
+ *
+ * The output path is picked at build time, as on the board:
+ *   default                              line buffers and writer task
+ *   -DPRINTF_LLD_LINE_BUFFER_ENABLE=0    chars straight into the ring buffer
+ *   ... -DLPUART_LLD_TX_BUFFER_ENABLE=0  LPUART_DRV_SendDataBlocking() per char
+ * Only the line buffer build is checked: no line may tear, and every line is
+ * either on the wire or counted in printf_lld_line_dropped_num. Exit status
+ * 1 on a failed check. SCHED_FIFO needs root, without it the numbers are
+ * those of the normal scheduler.
+ *
+ * build: gcc -O2 -Wall -pthread -I.. -I../../S32K144_040_printf_deferred_binary_log
+ *            -I../../S32K144_057_CAN_socketcan/host -o printf_lld_sim printf_lld_sim.c ../printf.c
+ *            ../printf_lld.c ../../S32K144_040_printf_deferred_binary_log/lpuart_lld.c
+ * usage: printf_lld_sim [-t seconds] [-l burst lines] [-p]
+ */
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "printf_lld.h"
+/* the output of the simulation goes to stdout, not to the printf under test */
+#undef printf
+#include <stdio.h>
+
+#define SIM_BAUD 115200U
+#define SIM_OUT_MAX (4U * 1024U * 1024U)
+#define SIM_TASK_NUM 4U
+#define SIM_LATENCY_MAX_US 20000U
+#define SIM_ISR_PRIORITY 90
+
+void freertos_task_printf(void *pvParameters);
+
+struct tskTaskControlBlock
+{
+    const char *name;
+    char id;                    /* first char of its lines */
+    UBaseType_t priority;
+    uint32_t period_ms;
+    uint32_t lines;             /* per period */
+    uint32_t sent;
+    pthread_t thread;
+};
+
+struct QueueDefinition
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint8_t *items;
+    UBaseType_t length;
+    UBaseType_t size;
+    UBaseType_t head;
+    UBaseType_t num;
+};
+
+static struct tskTaskControlBlock sim_task[SIM_TASK_NUM] =
+{
+    {"1ms", 'A', 4U, 1U, 0U, 0U, 0},
+    {"100ms", 'B', 3U, 100U, 1U, 0U, 0},
+    {"1000ms", 'C', 2U, 1000U, 6U, 0U, 0},
+    {"uart rx", 'D', 1U, 20U, 1U, 0U, 0}
+};
+static struct tskTaskControlBlock sim_writer = {"printf", 'W', PRINTF_LLD_WRITER_PRIORITY, 0U, 0U, 0U, 0};
+static __thread struct tskTaskControlBlock *sim_self = NULL;
+
+static uint8_t sim_out[SIM_OUT_MAX];
+static uint32_t sim_out_len;
+static volatile bool sim_load = false;
+static volatile bool sim_stop = false;
+static bool sim_fifo = true;
+static bool sim_print_1ms = false;
+
+static uint32_t sim_latency_hist[2][SIM_LATENCY_MAX_US + 1U];
+static uint32_t sim_printf_max_ns;
+static uint64_t sim_printf_sum_ns;
+static uint32_t sim_printf_num;
+static uint32_t sim_busy_num;
+
+static uint32_t test_error = 0U;
+static uint32_t test_check_num = 0U;
+
+#define TEST_CHECK(cond, ...) do { test_check_num++; if (!(cond)) { printf("FAIL: " __VA_ARGS__); printf("\n"); test_error++; } } while (0)
+
+/* mock UART, the lock stands for the driver state */
+static pthread_mutex_t sim_uart_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sim_uart_cond = PTHREAD_COND_INITIALIZER;
+static const uint8_t *sim_uart_buf;
+static uint32_t sim_uart_len;
+static bool sim_uart_busy = false;
+
+lpuart_state_t lpuart1_State;
+const lpuart_user_config_t lpuart1_InitConfig0 = {SIM_BAUD};
+static S32_SCB_Type sim_scb;
+S32_SCB_Type *const S32_SCB = &sim_scb;
+
+static uint64_t sim_ns(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return ((uint64_t)t.tv_sec * 1000000000ULL) + (uint64_t)t.tv_nsec;
+}
+
+static void sim_sleep_until(uint64_t ns)
+{
+    struct timespec t = {(time_t)(ns / 1000000000ULL), (long)(ns % 1000000000ULL)};
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &t, NULL) != 0)
+    {
+    }
+}
+
+static uint64_t sim_wire_ns(uint32_t len)
+{
+    return ((uint64_t)len * 10U * 1000000000ULL) / SIM_BAUD;
+}
+
+static void sim_out_append(const uint8_t *data, uint32_t len)
+{
+    if ((sim_out_len + len) <= SIM_OUT_MAX)
+    {
+        memcpy(&sim_out[sim_out_len], data, len);
+        sim_out_len += len;
+    }
+}
+
+/* LPUART driver */
+
+status_t LPUART_DRV_SendData(uint32_t instance, const uint8_t *txBuff, uint32_t txSize)
+{
+    (void)instance;
+    pthread_mutex_lock(&sim_uart_lock);
+    if (sim_uart_busy)
+    {
+        pthread_mutex_unlock(&sim_uart_lock);
+        return STATUS_BUSY;
+    }
+    sim_uart_busy = true;
+    sim_uart_buf = txBuff;
+    sim_uart_len = txSize;
+    pthread_cond_signal(&sim_uart_cond);
+    pthread_mutex_unlock(&sim_uart_lock);
+    return STATUS_SUCCESS;
+}
+
+status_t LPUART_DRV_SetTxBuffer(uint32_t instance, const uint8_t *txBuff, uint32_t txSize)
+{
+    (void)instance;
+    sim_uart_buf = txBuff;
+    sim_uart_len = txSize;
+    return STATUS_SUCCESS;
+}
+
+/* the caller sleeps on the semaphore of the driver while the chars go out,
+ * a second caller finds the driver busy and loses its chars */
+status_t LPUART_DRV_SendDataBlocking(uint32_t instance, const uint8_t *txBuff, uint32_t txSize, uint32_t timeout)
+{
+    (void)instance;
+    (void)timeout;
+    pthread_mutex_lock(&sim_uart_lock);
+    if (sim_uart_busy)
+    {
+        sim_busy_num++;
+        pthread_mutex_unlock(&sim_uart_lock);
+        return STATUS_BUSY;
+    }
+    sim_uart_busy = true;
+    pthread_mutex_unlock(&sim_uart_lock);
+    sim_sleep_until(sim_ns() + sim_wire_ns(txSize));
+    pthread_mutex_lock(&sim_uart_lock);
+    sim_out_append(txBuff, txSize);
+    sim_uart_busy = false;
+    pthread_mutex_unlock(&sim_uart_lock);
+    return STATUS_SUCCESS;
+}
+
+status_t LPUART_DRV_GetTransmitStatus(uint32_t instance, uint32_t *bytesRemaining)
+{
+    (void)instance;
+    *bytesRemaining = 0U;
+    return sim_uart_busy ? STATUS_BUSY : STATUS_SUCCESS;
+}
+
+status_t LPUART_DRV_Init(uint32_t instance, lpuart_state_t *lpuartStatePtr,
+                         const lpuart_user_config_t *lpuartUserConfig)
+{
+    (void)instance;
+    (void)lpuartStatePtr;
+    (void)lpuartUserConfig;
+    return STATUS_SUCCESS;
+}
+
+uart_callback_t LPUART_DRV_InstallTxCallback(uint32_t instance, uart_callback_t function, void *callbackParam)
+{
+    (void)instance;
+    (void)function;
+    (void)callbackParam;
+    return NULL;
+}
+
+status_t LPUART_DRV_ReceiveDataPolling(uint32_t instance, uint8_t *rxBuff, uint32_t rxSize)
+{
+    (void)instance;
+    (void)rxBuff;
+    (void)rxSize;
+    return STATUS_BUSY;
+}
+
+void INT_SYS_SetPriority(IRQn_Type irqNumber, uint8_t priority)
+{
+    (void)irqNumber;
+    (void)priority;
+}
+
+/* FreeRTOS */
+
+BaseType_t xTaskGetSchedulerState(void)
+{
+    return taskSCHEDULER_RUNNING;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return sim_self;
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(sim_ns() / (1000000000ULL / configTICK_RATE_HZ));
+}
+
+TickType_t xTaskGetTickCountFromISR(void)
+{
+    return xTaskGetTickCount();
+}
+
+void vTaskDelay(TickType_t xTicksToDelay)
+{
+    sim_sleep_until(sim_ns() + ((uint64_t)xTicksToDelay * (1000000000ULL / configTICK_RATE_HZ)));
+}
+
+void vTaskDelayUntil(TickType_t *pxPreviousWakeTime, TickType_t xTimeIncrement)
+{
+    *pxPreviousWakeTime += xTimeIncrement;
+    vTaskDelay(xTimeIncrement);
+}
+
+/* the mutex inherits the priority, like the critical section of a queue
+ * operation that nothing but an interrupt can preempt */
+QueueHandle_t xQueueCreate(UBaseType_t uxQueueLength, UBaseType_t uxItemSize)
+{
+    struct QueueDefinition *q = calloc(1U, sizeof(*q));
+    pthread_mutexattr_t attr;
+
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT);
+    pthread_mutex_init(&q->lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+    pthread_cond_init(&q->cond, NULL);
+    q->items = malloc(uxQueueLength * uxItemSize);
+    q->length = uxQueueLength;
+    q->size = uxItemSize;
+    return q;
+}
+
+BaseType_t xQueueSend(QueueHandle_t xQueue, const void *pvItemToQueue, TickType_t xTicksToWait)
+{
+    BaseType_t ret = pdFAIL;
+
+    (void)xTicksToWait;
+    pthread_mutex_lock(&xQueue->lock);
+    if (xQueue->num < xQueue->length)
+    {
+        memcpy(&xQueue->items[((xQueue->head + xQueue->num) % xQueue->length) * xQueue->size], pvItemToQueue,
+               xQueue->size);
+        xQueue->num++;
+        pthread_cond_signal(&xQueue->cond);
+        ret = pdPASS;
+    }
+    pthread_mutex_unlock(&xQueue->lock);
+    return ret;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void *pvBuffer, TickType_t xTicksToWait)
+{
+    (void)xTicksToWait;
+    pthread_mutex_lock(&xQueue->lock);
+    while (xQueue->num == 0U)
+    {
+        pthread_cond_wait(&xQueue->cond, &xQueue->lock);
+    }
+    memcpy(pvBuffer, &xQueue->items[xQueue->head * xQueue->size], xQueue->size);
+    xQueue->head = (xQueue->head + 1U) % xQueue->length;
+    xQueue->num--;
+    pthread_mutex_unlock(&xQueue->lock);
+    return pdPASS;
+}
+
+/* the DMA channel and its interrupt, one chunk after the other on the wire */
+static void *sim_uart_thread(void *arg)
+{
+    uint64_t end;
+
+    (void)arg;
+    for (;;)
+    {
+        pthread_mutex_lock(&sim_uart_lock);
+        while (!sim_uart_busy)
+        {
+            pthread_cond_wait(&sim_uart_cond, &sim_uart_lock);
+        }
+        pthread_mutex_unlock(&sim_uart_lock);
+
+        end = sim_ns();
+        do
+        {
+            end += sim_wire_ns(sim_uart_len);
+            sim_sleep_until(end);
+            sim_out_append(sim_uart_buf, sim_uart_len);
+            sim_uart_len = 0U;
+            lpuart_lld_tx_cbk_func(NULL, UART_EVENT_TX_EMPTY, NULL);
+        } while (sim_uart_len != 0U);
+
+        pthread_mutex_lock(&sim_uart_lock);
+        sim_uart_busy = false;
+        pthread_mutex_unlock(&sim_uart_lock);
+        lpuart_lld_tx_cbk_func(NULL, UART_EVENT_END_TRANSFER, NULL);
+    }
+    return NULL;
+}
+
+/* payload of 10 to 49 letters, both made from the task and the sequence */
+static uint32_t sim_payload_len(char id, uint32_t seq)
+{
+    return 10U + ((seq * 7U + (uint32_t)id) % 40U);
+}
+
+static void sim_print_line(struct tskTaskControlBlock *task)
+{
+    char payload[64];
+    uint32_t len = sim_payload_len(task->id, task->sent);
+    uint32_t i;
+
+    for (i = 0U; i < len; i++)
+    {
+        payload[i] = (char)('a' + ((task->sent + i) % 26U));
+    }
+    payload[len] = '\0';
+    (void)printf_("%c%06u %s\n", task->id, task->sent, payload);
+    task->sent++;
+}
+
+static void sim_record_latency(uint64_t ns)
+{
+    uint64_t us = ns / 1000U;
+
+    sim_latency_hist[sim_load ? 1 : 0][(us > SIM_LATENCY_MAX_US) ? SIM_LATENCY_MAX_US : us]++;
+}
+
+static void *sim_task_thread(void *arg)
+{
+    struct tskTaskControlBlock *task = arg;
+    uint64_t next = sim_ns();
+    uint64_t start;
+    uint64_t ns;
+    uint32_t i;
+
+    sim_self = task;
+    if (task == &sim_writer)
+    {
+        freertos_task_printf(NULL);
+        return NULL;
+    }
+    while (!sim_stop)
+    {
+        next += (uint64_t)task->period_ms * 1000000ULL;
+        sim_sleep_until(next);
+        if (task->period_ms == 1U)
+        {
+            sim_record_latency(sim_ns() - next);
+            if (sim_load && sim_print_1ms)
+            {
+                start = sim_ns();
+                sim_print_line(task);
+                ns = sim_ns() - start;
+                sim_printf_sum_ns += ns;
+                sim_printf_num++;
+                if (ns > sim_printf_max_ns)
+                {
+                    sim_printf_max_ns = (uint32_t)ns;
+                }
+            }
+        }
+        else if (sim_load)
+        {
+            for (i = 0U; i < task->lines; i++)
+            {
+                sim_print_line(task);
+            }
+        }
+    }
+    return NULL;
+}
+
+static void sim_start(struct tskTaskControlBlock *task, int priority, void *(*fn)(void *))
+{
+    struct sched_param param = {.sched_priority = priority};
+    pthread_attr_t attr;
+
+    pthread_attr_init(&attr);
+    if (sim_fifo)
+    {
+        pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+        pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+        pthread_attr_setschedparam(&attr, &param);
+    }
+    if (pthread_create(&task->thread, &attr, fn, task) != 0)
+    {
+        perror("pthread_create");
+        exit(1);
+    }
+    pthread_attr_destroy(&attr);
+}
+
+static void sim_latency_print(const char *name, const uint32_t *hist)
+{
+    uint64_t num = 0U;
+    uint64_t sum = 0U;
+    uint64_t acc = 0U;
+    uint32_t p999 = 0U;
+    uint32_t max = 0U;
+    uint32_t us;
+
+    for (us = 0U; us <= SIM_LATENCY_MAX_US; us++)
+    {
+        num += hist[us];
+        sum += (uint64_t)hist[us] * us;
+        if (hist[us] != 0U)
+        {
+            max = us;
+        }
+    }
+    for (us = 0U; (us <= SIM_LATENCY_MAX_US) && (acc < ((num * 999U) / 1000U)); us++)
+    {
+        acc += hist[us];
+        p999 = us;
+    }
+    printf("1ms task release latency %-11s %8llu periods, mean %5.1f us, 99.9%% %5u us, max %5u us\n", name,
+           (unsigned long long)num, (num != 0U) ? ((double)sum / (double)num) : 0.0, p999, max);
+}
+
+/* every line on the wire is a whole line of one task or it is torn */
+static void sim_check(void)
+{
+    uint32_t intact[SIM_TASK_NUM] = {0U};
+    uint32_t torn = 0U;
+    uint32_t sent = 0U;
+    uint32_t lines = 0U;
+    uint32_t start = 0U;
+    uint32_t seq;
+    uint32_t len;
+    uint32_t t;
+    uint32_t i;
+    bool ok;
+
+    for (i = 0U; i < sim_out_len; i++)
+    {
+        if (sim_out[i] != '\n')
+        {
+            continue;
+        }
+        lines++;
+        len = i - start;
+        ok = false;
+        for (t = 0U; (t < SIM_TASK_NUM) && (len > 8U); t++)
+        {
+            if (sim_out[start] == (uint8_t)sim_task[t].id)
+            {
+                break;
+            }
+        }
+        if ((t < SIM_TASK_NUM) && (sscanf((const char *)&sim_out[start + 1U], "%6u", &seq) == 1) &&
+            (sim_out[start + 7U] == ' ') && (len == (8U + sim_payload_len(sim_task[t].id, seq))))
+        {
+            ok = true;
+            for (len = 0U; ok && (len < sim_payload_len(sim_task[t].id, seq)); len++)
+            {
+                ok = (sim_out[start + 8U + len] == (uint8_t)('a' + ((seq + len) % 26U)));
+            }
+        }
+        if (ok)
+        {
+            intact[t]++;
+        }
+        else
+        {
+            torn++;
+        }
+        start = i + 1U;
+    }
+
+    for (t = 0U; t < SIM_TASK_NUM; t++)
+    {
+        printf("task %-7s %6u lines printed, %6u intact on the wire\n", sim_task[t].name, sim_task[t].sent,
+               intact[t]);
+        sent += sim_task[t].sent;
+    }
+    printf("%u lines on the wire, %u torn, %u dropped by printf_lld, %u chars dropped by the ring, "
+           "%u blocking sends refused\n", lines, torn, printf_lld_line_dropped_num, lpuart_lld_tx_dropped_num,
+           sim_busy_num);
+
+#if PRINTF_LLD_LINE_BUFFER_ENABLE
+    TEST_CHECK(torn == 0U, "%u torn lines", torn);
+    TEST_CHECK((lines + printf_lld_line_dropped_num) == sent, "%u lines + %u dropped, %u printed", lines,
+               printf_lld_line_dropped_num, sent);
+    TEST_CHECK(printf_lld_no_buffer_num == 0U, "%u chars without a line buffer", printf_lld_no_buffer_num);
+#endif
+}
+
+int main(int argc, char **argv)
+{
+    struct sched_param param = {.sched_priority = SIM_ISR_PRIORITY + 1};
+    struct tskTaskControlBlock isr = {"isr", 'I', 0U, 0U, 0U, 0U, 0};
+    uint32_t seconds = 10U;
+    cpu_set_t cpu;
+    uint32_t t;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:l:p")) != -1)
+    {
+        switch (opt)
+        {
+        case 't':
+            seconds = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'l':
+            sim_task[2].lines = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'p':
+            sim_print_1ms = true;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-t seconds] [-l burst lines] [-p]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    CPU_ZERO(&cpu);
+    CPU_SET(0, &cpu);
+    (void)sched_setaffinity(0, sizeof(cpu), &cpu);
+    if (sched_setscheduler(0, SCHED_FIFO, &param) != 0)
+    {
+        printf("no SCHED_FIFO, the task priorities are not applied\n");
+        sim_fifo = false;
+    }
+    printf("output: %s, %u s, 1000ms burst %u lines, 1ms task %s\n",
+           PRINTF_LLD_LINE_BUFFER_ENABLE ? "line buffers" :
+           LPUART_LLD_TX_BUFFER_ENABLE ? "TX ring buffer" : "blocking send", seconds, sim_task[2].lines,
+           sim_print_1ms ? "prints" : "silent");
+
+    printf_lld_init();
+    lpuart_lld_init();
+    sim_start(&isr, SIM_ISR_PRIORITY, sim_uart_thread);
+    sim_start(&sim_writer, 10 + (10 * (int)sim_writer.priority), sim_task_thread);
+    for (t = 0U; t < SIM_TASK_NUM; t++)
+    {
+        sim_start(&sim_task[t], 10 + (10 * (int)sim_task[t].priority), sim_task_thread);
+    }
+
+    sleep(1U);
+    sim_load = true;
+    sleep(seconds);
+    sim_stop = true;
+    for (t = 0U; t < SIM_TASK_NUM; t++)
+    {
+        pthread_join(sim_task[t].thread, NULL);
+    }
+    /* let the writer and the DMA empty the queue and the ring */
+    sleep(1U);
+
+    sim_latency_print("idle", sim_latency_hist[0]);
+    sim_latency_print("under load", sim_latency_hist[1]);
+    if (sim_printf_num != 0U)
+    {
+        printf("printf in the 1ms task: mean %.1f us, max %.1f us\n",
+               (double)sim_printf_sum_ns / (1000.0 * sim_printf_num), sim_printf_max_ns / 1000.0);
+    }
+    sim_check();
+    printf("%s, %u checks, %u errors\n", (test_error == 0U) ? "PASS" : "FAIL", test_check_num, test_error);
+    return (test_error == 0U) ? 0 : 1;
+}
@@ -0,0 +1,1627 @@
+///////////////////////////////////////////////////////////////////////////////
+// \author (c) Marco Paland (info@paland.com)
+//             2014-2019, PALANDesign Hannover, Germany
+//
+// \license The MIT License (MIT)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// \brief Tiny printf, sprintf and (v)snprintf implementation, optimized for speed on
+//        embedded systems with a very limited resources. These routines are thread
+//        safe and reentrant!
+//        Use this instead of the bloated standard/newlib printf cause these use
+//        malloc for printf (and may not be thread safe).
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
+
+#include "printf.h"
+#include "printf_lld.h"
+#include "string.h"
+
+// define this globally (e.g. gcc -DPRINTF_INCLUDE_CONFIG_H ...) to include the
+// printf_config.h header file
+// default: undefined
+#ifdef PRINTF_INCLUDE_CONFIG_H
+#include "printf_config.h"
+#endif
+
+#ifndef DBL_MAX
+#define DBL_MAX      1.79769313486231470e+308
+#endif
+
+// 'ntoa' conversion buffer size, this must be big enough to hold one converted
+// numeric number including padded zeros (dynamically created on stack)
+// default: 32 byte
+#ifndef PRINTF_NTOA_BUFFER_SIZE
+#define PRINTF_NTOA_BUFFER_SIZE 32U
+#endif
+
+// 'ftoa' conversion buffer size, this must be big enough to hold one converted
+// float number including padded zeros (dynamically created on stack)
+// default: 32 byte
+#ifndef PRINTF_FTOA_BUFFER_SIZE
+#define PRINTF_FTOA_BUFFER_SIZE 32U
+#endif
+
+// support for the floating point type (%f)
+// default: activated
+#ifndef PRINTF_DISABLE_SUPPORT_FLOAT
+#define PRINTF_SUPPORT_FLOAT
+#endif
+
+// support for exponential floating point notation (%e/%g)
+// default: activated
+#ifndef PRINTF_DISABLE_SUPPORT_EXPONENTIAL
+#define PRINTF_SUPPORT_EXPONENTIAL
+#endif
+
+// define the default floating point precision
+// default: 6 digits
+#ifndef PRINTF_DEFAULT_FLOAT_PRECISION
+#define PRINTF_DEFAULT_FLOAT_PRECISION 6U
+#endif
+
+// define the largest float suitable to print with %f
+// default: 1e9
+#ifndef PRINTF_MAX_FLOAT
+#define PRINTF_MAX_FLOAT 1e9
+#endif
+
+// fast integer kernels for %d/%u/%x..., two digits per step and no division
+// for base 10 (a 32 bit division costs up to 12 cycles on the M4)
+// default: activated
+#ifndef PRINTF_DISABLE_FAST_NTOA
+#define PRINTF_FAST_NTOA
+#endif
+
+// fast %f, the double is split with integer math only. The M4F FPU is single
+// precision, so every double operation of the default _ftoa is a library call.
+// The result is exactly rounded, the default _ftoa may be off by one in the
+// last digit when the double math is inexact
+// default: activated
+#ifndef PRINTF_DISABLE_FAST_FTOA
+#define PRINTF_FAST_FTOA
+#endif
+
+// support for the long long types (%llu or %p)
+// default: activated
+#ifndef PRINTF_DISABLE_SUPPORT_LONG_LONG
+#define PRINTF_SUPPORT_LONG_LONG
+#endif
+
+// support for the ptrdiff_t type (%t)
+// ptrdiff_t is normally defined in <stddef.h> as long or long long type
+// default: activated
+#ifndef PRINTF_DISABLE_SUPPORT_PTRDIFF_T
+#define PRINTF_SUPPORT_PTRDIFF_T
+#endif
+
+// support for deferred printf (printf_defer), the text is rendered on the host
+// default: activated
+#ifndef PRINTF_DISABLE_SUPPORT_DEFER
+#define PRINTF_SUPPORT_DEFER
+#endif
+
+// deferred record buffer size (dynamically created on stack), arguments which
+// don't fit any more are not sent
+// default: 64 byte
+#ifndef PRINTF_DEFER_BUFFER_SIZE
+#define PRINTF_DEFER_BUFFER_SIZE 64U
+#endif
+
+// max number of chars sent for one %s argument of a deferred record
+// default: 24 byte
+#ifndef PRINTF_DEFER_MAX_STRING
+#define PRINTF_DEFER_MAX_STRING 24U
+#endif
+
+// timestamp of a deferred record, only the low 16 bits are sent
+// default: FreeRTOS tick count (100us)
+#ifndef PRINTF_DEFER_TIMESTAMP
+#define PRINTF_DEFER_TIMESTAMP() ((uint32_t)xTaskGetTickCountFromISR())
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+
+// internal flag definitions
+#define FLAGS_ZEROPAD (1U << 0U)
+#define FLAGS_LEFT (1U << 1U)
+#define FLAGS_PLUS (1U << 2U)
+#define FLAGS_SPACE (1U << 3U)
+#define FLAGS_HASH (1U << 4U)
+#define FLAGS_UPPERCASE (1U << 5U)
+#define FLAGS_CHAR (1U << 6U)
+#define FLAGS_SHORT (1U << 7U)
+#define FLAGS_LONG (1U << 8U)
+#define FLAGS_LONG_LONG (1U << 9U)
+#define FLAGS_PRECISION (1U << 10U)
+#define FLAGS_ADAPT_EXP (1U << 11U)
+
+// import float.h for DBL_MAX
+#if defined(PRINTF_SUPPORT_FLOAT)
+#include <float.h>
+#endif
+
+void _putchar(char character)
+{
+    uint8_t data = 0U;
+
+    memcpy(&data, &character, 1);
+    // send char to console etc.
+#if PRINTF_LLD_LINE_BUFFER_ENABLE
+    // collected in the line buffer of the calling task, sent by the writer task
+    printf_lld_putchar(data);
+#elif LPUART_LLD_TX_BUFFER_ENABLE
+    // queued only, the LPUART TX DMA drains the ring buffer in background
+    lpuart_lld_tx_put(data);
+#else
+    LPUART_DRV_SendDataBlocking(INST_LPUART1, &data, 1, 100);
+#endif
+}
+
+#if defined(PRINTF_SUPPORT_DEFER)
+void _putblock(const char *data, size_t len)
+{
+#if LPUART_LLD_TX_BUFFER_ENABLE
+    // all or nothing, so a record is never split by chars of other callers
+    (void)lpuart_lld_tx_write((const uint8_t *)data, (uint32_t)len);
+#else
+    LPUART_DRV_SendDataBlocking(INST_LPUART1, (const uint8_t *)data, (uint32_t)len, 100);
+#endif
+}
+#endif // PRINTF_SUPPORT_DEFER
+
+// output function type
+typedef void (*out_fct_type)(char character, void *buffer, size_t idx, size_t maxlen);
+
+// wrapper (used as buffer) for output function type
+typedef struct
+{
+    void (*fct)(char character, void *arg);
+    void *arg;
+} out_fct_wrap_type;
+
+// internal buffer output
+static inline void _out_buffer(char character, void *buffer, size_t idx, size_t maxlen)
+{
+    if (idx < maxlen)
+    {
+        ((char *)buffer)[idx] = character;
+    }
+}
+
+// internal null output
+static inline void _out_null(char character, void *buffer, size_t idx, size_t maxlen)
+{
+    (void)character;
+    (void)buffer;
+    (void)idx;
+    (void)maxlen;
+}
+
+// internal _putchar wrapper
+static inline void _out_char(char character, void *buffer, size_t idx, size_t maxlen)
+{
+    (void)buffer;
+    (void)idx;
+    (void)maxlen;
+    if (character)
+    {
+        _putchar(character);
+    }
+}
+
+// internal output function wrapper
+static inline void _out_fct(char character, void *buffer, size_t idx, size_t maxlen)
+{
+    (void)idx;
+    (void)maxlen;
+    if (character)
+    {
+        // buffer is the output fct pointer
+        ((out_fct_wrap_type *)buffer)->fct(character, ((out_fct_wrap_type *)buffer)->arg);
+    }
+}
+
+// internal secure strlen
+// \return The length of the string (excluding the terminating 0) limited by 'maxsize'
+static inline unsigned int _strnlen_s(const char *str, size_t maxsize)
+{
+    const char *s;
+    for (s = str; *s && maxsize--; ++s)
+        ;
+    return (unsigned int)(s - str);
+}
+
+// internal test if char is a digit (0-9)
+// \return true if char is a digit
+static inline bool _is_digit(char ch)
+{
+    return (ch >= '0') && (ch <= '9');
+}
+
+// internal ASCII string to unsigned int conversion
+static unsigned int _atoi(const char **str)
+{
+    unsigned int i = 0U;
+    while (_is_digit(**str))
+    {
+        i = i * 10U + (unsigned int)(*((*str)++) - '0');
+    }
+    return i;
+}
+
+// output the specified string in reverse, taking care of any zero-padding
+static size_t _out_rev(out_fct_type out, char *buffer, size_t idx, size_t maxlen, const char *buf, size_t len, unsigned int width, unsigned int flags)
+{
+    const size_t start_idx = idx;
+    size_t i = len;
+
+    // pad spaces up to given width
+    if (!(flags & FLAGS_LEFT) && !(flags & FLAGS_ZEROPAD))
+    {
+        for (i = len; i < width; i++)
+        {
+            out(' ', buffer, idx++, maxlen);
+        }
+    }
+
+    // reverse string
+    while (len)
+    {
+        out(buf[--len], buffer, idx++, maxlen);
+    }
+
+    // append pad spaces up to given width
+    if (flags & FLAGS_LEFT)
+    {
+        while (idx - start_idx < width)
+        {
+            out(' ', buffer, idx++, maxlen);
+        }
+    }
+
+    return idx;
+}
+
+// internal itoa format
+static size_t _ntoa_format(out_fct_type out, char *buffer, size_t idx, size_t maxlen, char *buf, size_t len, bool negative, unsigned int base, unsigned int prec, unsigned int width, unsigned int flags)
+{
+    // pad leading zeros
+    if (!(flags & FLAGS_LEFT))
+    {
+        if (width && (flags & FLAGS_ZEROPAD) && (negative || (flags & (FLAGS_PLUS | FLAGS_SPACE))))
+        {
+            width--;
+        }
+        while ((len < prec) && (len < PRINTF_NTOA_BUFFER_SIZE))
+        {
+            buf[len++] = '0';
+        }
+        while ((flags & FLAGS_ZEROPAD) && (len < width) && (len < PRINTF_NTOA_BUFFER_SIZE))
+        {
+            buf[len++] = '0';
+        }
+    }
+
+    // handle hash
+    if (flags & FLAGS_HASH)
+    {
+        if (!(flags & FLAGS_PRECISION) && len && ((len == prec) || (len == width)))
+        {
+            len--;
+            if (len && (base == 16U))
+            {
+                len--;
+            }
+        }
+        if ((base == 16U) && !(flags & FLAGS_UPPERCASE) && (len < PRINTF_NTOA_BUFFER_SIZE))
+        {
+            buf[len++] = 'x';
+        }
+        else if ((base == 16U) && (flags & FLAGS_UPPERCASE) && (len < PRINTF_NTOA_BUFFER_SIZE))
+        {
+            buf[len++] = 'X';
+        }
+        else if ((base == 2U) && (len < PRINTF_NTOA_BUFFER_SIZE))
+        {
+            buf[len++] = 'b';
+        }
+        if (len < PRINTF_NTOA_BUFFER_SIZE)
+        {
+            buf[len++] = '0';
+        }
+    }
+
+    if (len < PRINTF_NTOA_BUFFER_SIZE)
+    {
+        if (negative)
+        {
+            buf[len++] = '-';
+        }
+        else if (flags & FLAGS_PLUS)
+        {
+            buf[len++] = '+'; // ignore the space if the '+' exists
+        }
+        else if (flags & FLAGS_SPACE)
+        {
+            buf[len++] = ' ';
+        }
+    }
+
+    return _out_rev(out, buffer, idx, maxlen, buf, len, width, flags);
+}
+
+#if defined(PRINTF_FAST_NTOA) || (defined(PRINTF_SUPPORT_FLOAT) && defined(PRINTF_FAST_FTOA))
+// "00" "01" ... "99", two digits per table access
+static const char _digit_pairs[200] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+// internal 32 bit itoa kernel, appends the digits reversed to buf[len]
+// base 10 takes two digits per step, value / 100 is done with a multiply-shift
+// which is exact for every 32 bit value. Power of 2 bases are shifted out
+static size_t _utoa_rev(char *buf, size_t len, size_t size, uint32_t value, unsigned int base, unsigned int flags)
+{
+    if (base == 10U)
+    {
+        while ((value >= 100U) && ((len + 2U) <= size))
+        {
+            const uint32_t q = (uint32_t)(((uint64_t)value * 0x51EB851FU) >> 37U);
+            const uint32_t r = (value - (q * 100U)) * 2U;
+            buf[len++] = _digit_pairs[r + 1U];
+            buf[len++] = _digit_pairs[r];
+            value = q;
+        }
+        if (value >= 10U)
+        {
+            if ((len + 2U) <= size)
+            {
+                buf[len++] = _digit_pairs[(value * 2U) + 1U];
+                buf[len++] = _digit_pairs[value * 2U];
+            }
+        }
+        else if (len < size)
+        {
+            buf[len++] = (char)('0' + value);
+        }
+    }
+    else if ((base & (base - 1U)) == 0U)
+    {
+        const unsigned int shift = (unsigned int)__builtin_ctz(base);
+        const char alpha = (flags & FLAGS_UPPERCASE) ? 'A' : 'a';
+        do
+        {
+            const char digit = (char)(value & (base - 1U));
+            buf[len++] = digit < 10 ? '0' + digit : alpha + digit - 10;
+            value >>= shift;
+        } while (value && (len < size));
+    }
+    else
+    {
+        do
+        {
+            const char digit = (char)(value % base);
+            buf[len++] = digit < 10 ? '0' + digit : (flags & FLAGS_UPPERCASE ? 'A' : 'a') + digit - 10;
+            value /= base;
+        } while (value && (len < size));
+    }
+
+    return len;
+}
+#endif
+
+#if defined(PRINTF_FAST_NTOA) && defined(PRINTF_SUPPORT_LONG_LONG)
+// internal 64 bit itoa kernel, only the digits above 2^32 need 64 bit math,
+// the rest is handed over to the 32 bit kernel
+static size_t _ulltoa_rev(char *buf, size_t len, size_t size, unsigned long long value, unsigned int base, unsigned int flags)
+{
+    if (base == 10U)
+    {
+        // one 64 bit division for 8 digits, zeros inside the chunk are kept
+        while ((value > 0xFFFFFFFFULL) && ((len + 8U) <= size))
+        {
+            const unsigned long long q = value / 100000000ULL;
+            uint32_t chunk = (uint32_t)(value - (q * 100000000ULL));
+            unsigned int i;
+            for (i = 0U; i < 4U; i++)
+            {
+                const uint32_t q2 = (uint32_t)(((uint64_t)chunk * 0x51EB851FU) >> 37U);
+                const uint32_t r = (chunk - (q2 * 100U)) * 2U;
+                buf[len++] = _digit_pairs[r + 1U];
+                buf[len++] = _digit_pairs[r];
+                chunk = q2;
+            }
+            value = q;
+        }
+    }
+    else
+    {
+        while ((value > 0xFFFFFFFFULL) && (len < size))
+        {
+            const char digit = (char)(value % base);
+            buf[len++] = digit < 10 ? '0' + digit : (flags & FLAGS_UPPERCASE ? 'A' : 'a') + digit - 10;
+            value /= base;
+        }
+    }
+
+    if (value > 0xFFFFFFFFULL)
+    {
+        // buffer is full
+        return len;
+    }
+    return _utoa_rev(buf, len, size, (uint32_t)value, base, flags);
+}
+#endif
+
+// internal itoa for 'long' type
+static size_t _ntoa_long(out_fct_type out, char *buffer, size_t idx, size_t maxlen, unsigned long value, bool negative, unsigned long base, unsigned int prec, unsigned int width, unsigned int flags)
+{
+    char buf[PRINTF_NTOA_BUFFER_SIZE];
+    size_t len = 0U;
+
+    // no hash for 0 values
+    if (!value)
+    {
+        flags &= ~FLAGS_HASH;
+    }
+
+    // write if precision != 0 and value is != 0
+    if (!(flags & FLAGS_PRECISION) || value)
+    {
+#if defined(PRINTF_FAST_NTOA) && (ULONG_MAX == 0xFFFFFFFFUL)
+        len = _utoa_rev(buf, len, PRINTF_NTOA_BUFFER_SIZE, (uint32_t)value, (unsigned int)base, flags);
+#elif defined(PRINTF_FAST_NTOA) && defined(PRINTF_SUPPORT_LONG_LONG)
+        len = _ulltoa_rev(buf, len, PRINTF_NTOA_BUFFER_SIZE, value, (unsigned int)base, flags);
+#else
+        do
+        {
+            const char digit = (char)(value % base);
+            buf[len++] = digit < 10 ? '0' + digit : (flags & FLAGS_UPPERCASE ? 'A' : 'a') + digit - 10;
+            value /= base;
+        } while (value && (len < PRINTF_NTOA_BUFFER_SIZE));
+#endif
+    }
+
+    return _ntoa_format(out, buffer, idx, maxlen, buf, len, negative, (unsigned int)base, prec, width, flags);
+}
+
+// internal itoa for 'long long' type
+#if defined(PRINTF_SUPPORT_LONG_LONG)
+static size_t _ntoa_long_long(out_fct_type out, char *buffer, size_t idx, size_t maxlen, unsigned long long value, bool negative, unsigned long long base, unsigned int prec, unsigned int width, unsigned int flags)
+{
+    char buf[PRINTF_NTOA_BUFFER_SIZE];
+    size_t len = 0U;
+
+    // no hash for 0 values
+    if (!value)
+    {
+        flags &= ~FLAGS_HASH;
+    }
+
+    // write if precision != 0 and value is != 0
+    if (!(flags & FLAGS_PRECISION) || value)
+    {
+#if defined(PRINTF_FAST_NTOA)
+        len = _ulltoa_rev(buf, len, PRINTF_NTOA_BUFFER_SIZE, value, (unsigned int)base, flags);
+#else
+        do
+        {
+            const char digit = (char)(value % base);
+            buf[len++] = digit < 10 ? '0' + digit : (flags & FLAGS_UPPERCASE ? 'A' : 'a') + digit - 10;
+            value /= base;
+        } while (value && (len < PRINTF_NTOA_BUFFER_SIZE));
+#endif
+    }
+
+    return _ntoa_format(out, buffer, idx, maxlen, buf, len, negative, (unsigned int)base, prec, width, flags);
+}
+#endif // PRINTF_SUPPORT_LONG_LONG
+
+#if defined(PRINTF_SUPPORT_FLOAT)
+
+#if defined(PRINTF_SUPPORT_EXPONENTIAL)
+// forward declaration so that _ftoa can switch to exp notation for values > PRINTF_MAX_FLOAT
+static size_t _etoa(out_fct_type out, char *buffer, size_t idx, size_t maxlen, double value, unsigned int prec, unsigned int width, unsigned int flags);
+#endif
+
+#if defined(PRINTF_FAST_FTOA)
+// internal exact split of a positive double below 2^32 into the whole part and
+// the fraction scaled by 10^prec (prec <= 9), integer math only
+// half way cases round to even like the prec 0 case of _ftoa does
+static void _ftoa_split(double value, unsigned int prec, uint32_t *whole, uint32_t *frac)
+{
+    static const uint32_t pow10[] = {1U, 10U, 100U, 1000U, 10000U, 100000U, 1000000U, 10000000U, 100000000U, 1000000000U};
+    union
+    {
+        uint64_t U;
+        double F;
+    } conv;
+    uint64_t mant;
+    uint64_t rest;
+    uint64_t hi;
+    uint64_t lo;
+    unsigned int shift;
+    int exp2;
+    int cmp;
+
+    conv.F = value;
+    exp2 = (int)((conv.U >> 52U) & 0x07FFU);
+    mant = conv.U & ((1ULL << 52U) - 1U);
+    if (exp2 == 0)
+    {
+        // denormal
+        exp2 = 1;
+    }
+    else
+    {
+        mant |= 1ULL << 52U;
+    }
+
+    // value = mant / 2^shift, shift >= 21 for any value below 2^32
+    shift = (unsigned int)(1075 - exp2);
+    *whole = 0U;
+    *frac = 0U;
+    if (shift > 83U)
+    {
+        // value < 2^-30, value * 10^9 is below 0.5
+        return;
+    }
+    if (shift >= 64U)
+    {
+        rest = mant;
+    }
+    else
+    {
+        *whole = (uint32_t)(mant >> shift);
+        rest = mant & ((1ULL << shift) - 1U);
+    }
+
+    // rest * 10^prec needs up to 83 bits, it is kept as hi * 2^32 + lo
+    lo = (rest & 0xFFFFFFFFU) * pow10[prec];
+    hi = ((rest >> 32U) * pow10[prec]) + (lo >> 32U);
+    lo &= 0xFFFFFFFFU;
+
+    // frac is the product shifted right, the rest is compared with the half
+    if (shift >= 32U)
+    {
+        const unsigned int sh = shift - 32U;
+        const uint64_t rest_hi = hi & ((1ULL << sh) - 1U);
+        *frac = (uint32_t)(hi >> sh);
+        if (sh == 0U)
+        {
+            cmp = (lo > 0x80000000U) ? 1 : ((lo == 0x80000000U) ? 0 : -1);
+        }
+        else
+        {
+            const uint64_t half_hi = 1ULL << (sh - 1U);
+            cmp = (rest_hi > half_hi) ? 1 : ((rest_hi < half_hi) ? -1 : ((lo != 0U) ? 1 : 0));
+        }
+    }
+    else
+    {
+        const uint64_t rest_lo = lo & ((1ULL << shift) - 1U);
+        const uint64_t half = 1ULL << (shift - 1U);
+        *frac = (uint32_t)((hi << (32U - shift)) | (lo >> shift));
+        cmp = (rest_lo > half) ? 1 : ((rest_lo < half) ? -1 : 0);
+    }
+
+    if ((cmp > 0) || ((cmp == 0) && (((prec > 0U) ? *frac : *whole) & 1U)))
+    {
+        ++*frac;
+        // handle rollover, e.g. case 0.99 with prec 1 is 1.0
+        if (*frac >= pow10[prec])
+        {
+            *frac = 0U;
+            ++*whole;
+        }
+    }
+}
+#endif // PRINTF_FAST_FTOA
+
+// internal ftoa for fixed decimal floating point
+static size_t _ftoa(out_fct_type out, char *buffer, size_t idx, size_t maxlen, double value, unsigned int prec, unsigned int width, unsigned int flags)
+{
+    char buf[PRINTF_FTOA_BUFFER_SIZE];
+    size_t len = 0U;
+#if !defined(PRINTF_FAST_FTOA)
+    double diff = 0.0;
+
+    // powers of 10
+    static const double pow10[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+#endif
+
+    // test for special values
+    if (value != value)
+        return _out_rev(out, buffer, idx, maxlen, "nan", 3, width, flags);
+    if (value < -DBL_MAX)
+        return _out_rev(out, buffer, idx, maxlen, "fni-", 4, width, flags);
+    if (value > DBL_MAX)
+        return _out_rev(out, buffer, idx, maxlen, (flags & FLAGS_PLUS) ? "fni+" : "fni", (flags & FLAGS_PLUS) ? 4U : 3U, width, flags);
+
+    // test for very large values
+    // standard printf behavior is to print EVERY whole number digit -- which could be 100s of characters overflowing your buffers == bad
+    if ((value > PRINTF_MAX_FLOAT) || (value < -PRINTF_MAX_FLOAT))
+    {
+#if defined(PRINTF_SUPPORT_EXPONENTIAL)
+        return _etoa(out, buffer, idx, maxlen, value, prec, width, flags);
+#else
+        return 0U;
+#endif
+    }
+
+    // test for negative
+    bool negative = false;
+    if (value < 0)
+    {
+        negative = true;
+        value = 0 - value;
+    }
+
+    // set default precision, if not set explicitly
+    if (!(flags & FLAGS_PRECISION))
+    {
+        prec = PRINTF_DEFAULT_FLOAT_PRECISION;
+    }
+    // limit precision to 9, cause a prec >= 10 can lead to overflow errors
+    while ((len < PRINTF_FTOA_BUFFER_SIZE) && (prec > 9U))
+    {
+        buf[len++] = '0';
+        prec--;
+    }
+
+#if defined(PRINTF_FAST_FTOA)
+    uint32_t whole;
+    uint32_t frac;
+
+    _ftoa_split(value, prec, &whole, &frac);
+
+    if (prec > 0U)
+    {
+        // now do fractional part, as an unsigned number
+        const size_t frac_start = len;
+        len = _utoa_rev(buf, len, PRINTF_FTOA_BUFFER_SIZE, frac, 10U, 0U);
+        // add extra 0s
+        while ((len < PRINTF_FTOA_BUFFER_SIZE) && ((len - frac_start) < prec))
+        {
+            buf[len++] = '0';
+        }
+        if (len < PRINTF_FTOA_BUFFER_SIZE)
+        {
+            // add decimal
+            buf[len++] = '.';
+        }
+    }
+
+    // do whole part, number is reversed
+    len = _utoa_rev(buf, len, PRINTF_FTOA_BUFFER_SIZE, whole, 10U, 0U);
+#else
+    int whole = (int)value;
+    double tmp = (value - whole) * pow10[prec];
+    unsigned long frac = (unsigned long)tmp;
+    diff = tmp - frac;
+
+    if (diff > 0.5)
+    {
+        ++frac;
+        // handle rollover, e.g. case 0.99 with prec 1 is 1.0
+        if (frac >= pow10[prec])
+        {
+            frac = 0;
+            ++whole;
+        }
+    }
+    else if (diff < 0.5)
+    {
+    }
+    else if ((frac == 0U) || (frac & 1U))
+    {
+        // if halfway, round up if odd OR if last digit is 0
+        ++frac;
+    }
+
+    if (prec == 0U)
+    {
+        diff = value - (double)whole;
+        if ((!(diff < 0.5) || (diff > 0.5)) && (whole & 1))
+        {
+            // exactly 0.5 and ODD, then round up
+            // 1.5 -> 2, but 2.5 -> 2
+            ++whole;
+        }
+    }
+    else
+    {
+        unsigned int count = prec;
+        // now do fractional part, as an unsigned number
+        while (len < PRINTF_FTOA_BUFFER_SIZE)
+        {
+            --count;
+            buf[len++] = (char)(48U + (frac % 10U));
+            if (!(frac /= 10U))
+            {
+                break;
+            }
+        }
+        // add extra 0s
+        while ((len < PRINTF_FTOA_BUFFER_SIZE) && (count-- > 0U))
+        {
+            buf[len++] = '0';
+        }
+        if (len < PRINTF_FTOA_BUFFER_SIZE)
+        {
+            // add decimal
+            buf[len++] = '.';
+        }
+    }
+
+    // do whole part, number is reversed
+    while (len < PRINTF_FTOA_BUFFER_SIZE)
+    {
+        buf[len++] = (char)(48 + (whole % 10));
+        if (!(whole /= 10))
+        {
+            break;
+        }
+    }
+#endif
+
+    // pad leading zeros
+    if (!(flags & FLAGS_LEFT) && (flags & FLAGS_ZEROPAD))
+    {
+        if (width && (negative || (flags & (FLAGS_PLUS | FLAGS_SPACE))))
+        {
+            width--;
+        }
+        while ((len < width) && (len < PRINTF_FTOA_BUFFER_SIZE))
+        {
+            buf[len++] = '0';
+        }
+    }
+
+    if (len < PRINTF_FTOA_BUFFER_SIZE)
+    {
+        if (negative)
+        {
+            buf[len++] = '-';
+        }
+        else if (flags & FLAGS_PLUS)
+        {
+            buf[len++] = '+'; // ignore the space if the '+' exists
+        }
+        else if (flags & FLAGS_SPACE)
+        {
+            buf[len++] = ' ';
+        }
+    }
+
+    return _out_rev(out, buffer, idx, maxlen, buf, len, width, flags);
+}
+
+#if defined(PRINTF_SUPPORT_EXPONENTIAL)
+// internal ftoa variant for exponential floating-point type, contributed by Martijn Jasperse <m.jasperse@gmail.com>
+static size_t _etoa(out_fct_type out, char *buffer, size_t idx, size_t maxlen, double value, unsigned int prec, unsigned int width, unsigned int flags)
+{
+    // check for NaN and special values
+    if ((value != value) || (value > DBL_MAX) || (value < -DBL_MAX))
+    {
+        return _ftoa(out, buffer, idx, maxlen, value, prec, width, flags);
+    }
+
+    // determine the sign
+    const bool negative = value < 0;
+    if (negative)
+    {
+        value = -value;
+    }
+
+    // default precision
+    if (!(flags & FLAGS_PRECISION))
+    {
+        prec = PRINTF_DEFAULT_FLOAT_PRECISION;
+    }
+
+    // determine the decimal exponent
+    // based on the algorithm by David Gay (https://www.ampl.com/netlib/fp/dtoa.c)
+    union {
+        uint64_t U;
+        double F;
+    } conv;
+
+    conv.F = value;
+    int exp2 = (int)((conv.U >> 52U) & 0x07FFU) - 1023;          // effectively log2
+    conv.U = (conv.U & ((1ULL << 52U) - 1U)) | (1023ULL << 52U); // drop the exponent so conv.F is now in [1,2)
+    // now approximate log10 from the log2 integer part and an expansion of ln around 1.5
+    int expval = (int)(0.1760912590558 + exp2 * 0.301029995663981 + (conv.F - 1.5) * 0.289529654602168);
+    // now we want to compute 10^expval but we want to be sure it won't overflow
+    exp2 = (int)(expval * 3.321928094887362 + 0.5);
+    const double z = expval * 2.302585092994046 - exp2 * 0.6931471805599453;
+    const double z2 = z * z;
+    conv.U = (uint64_t)(exp2 + 1023) << 52U;
+    // compute exp(z) using continued fractions, see https://en.wikipedia.org/wiki/Exponential_function#Continued_fractions_for_ex
+    conv.F *= 1 + 2 * z / (2 - z + (z2 / (6 + (z2 / (10 + z2 / 14)))));
+    // correct for rounding errors
+    if (value < conv.F)
+    {
+        expval--;
+        conv.F /= 10;
+    }
+
+    // the exponent format is "%+03d" and largest value is "307", so set aside 4-5 characters
+    unsigned int minwidth = ((expval < 100) && (expval > -100)) ? 4U : 5U;
+
+    // in "%g" mode, "prec" is the number of *significant figures* not decimals
+    if (flags & FLAGS_ADAPT_EXP)
+    {
+        // do we want to fall-back to "%f" mode?
+        if ((value >= 1e-4) && (value < 1e6))
+        {
+            if ((int)prec > expval)
+            {
+                prec = (unsigned)((int)prec - expval - 1);
+            }
+            else
+            {
+                prec = 0;
+            }
+            flags |= FLAGS_PRECISION; // make sure _ftoa respects precision
+            // no characters in exponent
+            minwidth = 0U;
+            expval = 0;
+        }
+        else
+        {
+            // we use one sigfig for the whole part
+            if ((prec > 0) && (flags & FLAGS_PRECISION))
+            {
+                --prec;
+            }
+        }
+    }
+
+    // will everything fit?
+    unsigned int fwidth = width;
+    if (width > minwidth)
+    {
+        // we didn't fall-back so subtract the characters required for the exponent
+        fwidth -= minwidth;
+    }
+    else
+    {
+        // not enough characters, so go back to default sizing
+        fwidth = 0U;
+    }
+    if ((flags & FLAGS_LEFT) && minwidth)
+    {
+        // if we're padding on the right, DON'T pad the floating part
+        fwidth = 0U;
+    }
+
+    // rescale the float value
+    if (expval)
+    {
+        value /= conv.F;
+    }
+
+    // output the floating part
+    const size_t start_idx = idx;
+    idx = _ftoa(out, buffer, idx, maxlen, negative ? -value : value, prec, fwidth, flags & ~FLAGS_ADAPT_EXP);
+
+    // output the exponent part
+    if (minwidth)
+    {
+        // output the exponential symbol
+        out((flags & FLAGS_UPPERCASE) ? 'E' : 'e', buffer, idx++, maxlen);
+        // output the exponent value
+        idx = _ntoa_long(out, buffer, idx, maxlen, (expval < 0) ? -expval : expval, expval < 0, 10, 0, minwidth - 1, FLAGS_ZEROPAD | FLAGS_PLUS);
+        // might need to right-pad spaces
+        if (flags & FLAGS_LEFT)
+        {
+            while (idx - start_idx < width)
+                out(' ', buffer, idx++, maxlen);
+        }
+    }
+    return idx;
+}
+#endif // PRINTF_SUPPORT_EXPONENTIAL
+#endif // PRINTF_SUPPORT_FLOAT
+
+// internal vsnprintf
+static int _vsnprintf(out_fct_type out, char *buffer, const size_t maxlen, const char *format, va_list va)
+{
+    unsigned int flags, width, precision, n;
+    size_t idx = 0U;
+
+    if (!buffer)
+    {
+        // use null output function
+        out = _out_null;
+    }
+
+    while (*format)
+    {
+        // format specifier?  %[flags][width][.precision][length]
+        if (*format != '%')
+        {
+            // no
+            out(*format, buffer, idx++, maxlen);
+            format++;
+            continue;
+        }
+        else
+        {
+            // yes, evaluate it
+            format++;
+        }
+
+        // evaluate flags
+        flags = 0U;
+        do
+        {
+            switch (*format)
+            {
+            case '0':
+                flags |= FLAGS_ZEROPAD;
+                format++;
+                n = 1U;
+                break;
+            case '-':
+                flags |= FLAGS_LEFT;
+                format++;
+                n = 1U;
+                break;
+            case '+':
+                flags |= FLAGS_PLUS;
+                format++;
+                n = 1U;
+                break;
+            case ' ':
+                flags |= FLAGS_SPACE;
+                format++;
+                n = 1U;
+                break;
+            case '#':
+                flags |= FLAGS_HASH;
+                format++;
+                n = 1U;
+                break;
+            default:
+                n = 0U;
+                break;
+            }
+        } while (n);
+
+        // evaluate width field
+        width = 0U;
+        if (_is_digit(*format))
+        {
+            width = _atoi(&format);
+        }
+        else if (*format == '*')
+        {
+            const int w = va_arg(va, int);
+            if (w < 0)
+            {
+                flags |= FLAGS_LEFT; // reverse padding
+                width = (unsigned int)-w;
+            }
+            else
+            {
+                width = (unsigned int)w;
+            }
+            format++;
+        }
+
+        // evaluate precision field
+        precision = 0U;
+        if (*format == '.')
+        {
+            flags |= FLAGS_PRECISION;
+            format++;
+            if (_is_digit(*format))
+            {
+                precision = _atoi(&format);
+            }
+            else if (*format == '*')
+            {
+                const int prec = (int)va_arg(va, int);
+                precision = prec > 0 ? (unsigned int)prec : 0U;
+                format++;
+            }
+        }
+
+        // evaluate length field
+        switch (*format)
+        {
+        case 'l':
+            flags |= FLAGS_LONG;
+            format++;
+            if (*format == 'l')
+            {
+                flags |= FLAGS_LONG_LONG;
+                format++;
+            }
+            break;
+        case 'h':
+            flags |= FLAGS_SHORT;
+            format++;
+            if (*format == 'h')
+            {
+                flags |= FLAGS_CHAR;
+                format++;
+            }
+            break;
+#if defined(PRINTF_SUPPORT_PTRDIFF_T)
+        case 't':
+            flags |= (sizeof(ptrdiff_t) == sizeof(long) ? FLAGS_LONG : FLAGS_LONG_LONG);
+            format++;
+            break;
+#endif
+        case 'j':
+            flags |= (sizeof(intmax_t) == sizeof(long) ? FLAGS_LONG : FLAGS_LONG_LONG);
+            format++;
+            break;
+        case 'z':
+            flags |= (sizeof(size_t) == sizeof(long) ? FLAGS_LONG : FLAGS_LONG_LONG);
+            format++;
+            break;
+        default:
+            break;
+        }
+
+        // evaluate specifier
+        switch (*format)
+        {
+        case 'd':
+        case 'i':
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+        case 'b':
+        {
+            // set the base
+            unsigned int base;
+            if (*format == 'x' || *format == 'X')
+            {
+                base = 16U;
+            }
+            else if (*format == 'o')
+            {
+                base = 8U;
+            }
+            else if (*format == 'b')
+            {
+                base = 2U;
+            }
+            else
+            {
+                base = 10U;
+                flags &= ~FLAGS_HASH; // no hash for dec format
+            }
+            // uppercase
+            if (*format == 'X')
+            {
+                flags |= FLAGS_UPPERCASE;
+            }
+
+            // no plus or space flag for u, x, X, o, b
+            if ((*format != 'i') && (*format != 'd'))
+            {
+                flags &= ~(FLAGS_PLUS | FLAGS_SPACE);
+            }
+
+            // ignore '0' flag when precision is given
+            if (flags & FLAGS_PRECISION)
+            {
+                flags &= ~FLAGS_ZEROPAD;
+            }
+
+            // convert the integer
+            if ((*format == 'i') || (*format == 'd'))
+            {
+                // signed
+                if (flags & FLAGS_LONG_LONG)
+                {
+#if defined(PRINTF_SUPPORT_LONG_LONG)
+                    const long long value = va_arg(va, long long);
+                    idx = _ntoa_long_long(out, buffer, idx, maxlen, (unsigned long long)(value > 0 ? value : 0 - value), value < 0, base, precision, width, flags);
+#endif
+                }
+                else if (flags & FLAGS_LONG)
+                {
+                    const long value = va_arg(va, long);
+                    idx = _ntoa_long(out, buffer, idx, maxlen, (unsigned long)(value > 0 ? value : 0 - value), value < 0, base, precision, width, flags);
+                }
+                else
+                {
+                    const int value = (flags & FLAGS_CHAR) ? (char)va_arg(va, int) : (flags & FLAGS_SHORT) ? (short int)va_arg(va, int) : va_arg(va, int);
+                    idx = _ntoa_long(out, buffer, idx, maxlen, (unsigned int)(value > 0 ? value : 0 - value), value < 0, base, precision, width, flags);
+                }
+            }
+            else
+            {
+                // unsigned
+                if (flags & FLAGS_LONG_LONG)
+                {
+#if defined(PRINTF_SUPPORT_LONG_LONG)
+                    idx = _ntoa_long_long(out, buffer, idx, maxlen, va_arg(va, unsigned long long), false, base, precision, width, flags);
+#endif
+                }
+                else if (flags & FLAGS_LONG)
+                {
+                    idx = _ntoa_long(out, buffer, idx, maxlen, va_arg(va, unsigned long), false, base, precision, width, flags);
+                }
+                else
+                {
+                    const unsigned int value = (flags & FLAGS_CHAR) ? (unsigned char)va_arg(va, unsigned int) : (flags & FLAGS_SHORT) ? (unsigned short int)va_arg(va, unsigned int) : va_arg(va, unsigned int);
+                    idx = _ntoa_long(out, buffer, idx, maxlen, value, false, base, precision, width, flags);
+                }
+            }
+            format++;
+            break;
+        }
+#if defined(PRINTF_SUPPORT_FLOAT)
+        case 'f':
+        case 'F':
+            if (*format == 'F')
+                flags |= FLAGS_UPPERCASE;
+            idx = _ftoa(out, buffer, idx, maxlen, va_arg(va, double), precision, width, flags);
+            format++;
+            break;
+#if defined(PRINTF_SUPPORT_EXPONENTIAL)
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+            if ((*format == 'g') || (*format == 'G'))
+                flags |= FLAGS_ADAPT_EXP;
+            if ((*format == 'E') || (*format == 'G'))
+                flags |= FLAGS_UPPERCASE;
+            idx = _etoa(out, buffer, idx, maxlen, va_arg(va, double), precision, width, flags);
+            format++;
+            break;
+#endif // PRINTF_SUPPORT_EXPONENTIAL
+#endif // PRINTF_SUPPORT_FLOAT
+        case 'c':
+        {
+            unsigned int l = 1U;
+            // pre padding
+            if (!(flags & FLAGS_LEFT))
+            {
+                while (l++ < width)
+                {
+                    out(' ', buffer, idx++, maxlen);
+                }
+            }
+            // char output
+            out((char)va_arg(va, int), buffer, idx++, maxlen);
+            // post padding
+            if (flags & FLAGS_LEFT)
+            {
+                while (l++ < width)
+                {
+                    out(' ', buffer, idx++, maxlen);
+                }
+            }
+            format++;
+            break;
+        }
+
+        case 's':
+        {
+            const char *p = va_arg(va, char *);
+            unsigned int l = _strnlen_s(p, precision ? precision : (size_t)-1);
+            // pre padding
+            if (flags & FLAGS_PRECISION)
+            {
+                l = (l < precision ? l : precision);
+            }
+            if (!(flags & FLAGS_LEFT))
+            {
+                while (l++ < width)
+                {
+                    out(' ', buffer, idx++, maxlen);
+                }
+            }
+            // string output
+            while ((*p != 0) && (!(flags & FLAGS_PRECISION) || precision--))
+            {
+                out(*(p++), buffer, idx++, maxlen);
+            }
+            // post padding
+            if (flags & FLAGS_LEFT)
+            {
+                while (l++ < width)
+                {
+                    out(' ', buffer, idx++, maxlen);
+                }
+            }
+            format++;
+            break;
+        }
+
+        case 'p':
+        {
+            width = sizeof(void *) * 2U;
+            flags |= FLAGS_ZEROPAD | FLAGS_UPPERCASE;
+#if defined(PRINTF_SUPPORT_LONG_LONG)
+            const bool is_ll = sizeof(uintptr_t) == sizeof(long long);
+            if (is_ll)
+            {
+                idx = _ntoa_long_long(out, buffer, idx, maxlen, (uintptr_t)va_arg(va, void *), false, 16U, precision, width, flags);
+            }
+            else
+            {
+#endif
+                idx = _ntoa_long(out, buffer, idx, maxlen, (unsigned long)((uintptr_t)va_arg(va, void *)), false, 16U, precision, width, flags);
+#if defined(PRINTF_SUPPORT_LONG_LONG)
+            }
+#endif
+            format++;
+            break;
+        }
+
+        case '%':
+            out('%', buffer, idx++, maxlen);
+            format++;
+            break;
+
+        default:
+            out(*format, buffer, idx++, maxlen);
+            format++;
+            break;
+        }
+    }
+
+    // termination
+    out((char)0, buffer, idx < maxlen ? idx : maxlen - 1U, maxlen);
+
+    // return written chars without terminating \0
+    return (int)idx;
+}
+
+#if defined(PRINTF_SUPPORT_DEFER)
+// deferred record layout, all multi byte fields are little endian:
+//   0x00          marker, never part of the text output (_out_char drops '\0')
+//   len           payload length in bytes
+//   payload       varint format string address (the string ID)
+//                 16 bit timestamp
+//                 one field per '*', width/precision and conversion argument:
+//                   d i              zigzag varint
+//                   u x X o b c p    varint
+//                   f F e E g G      IEEE754 single precision
+//                   s                length byte + chars (no terminator)
+// varint: 7 bits per byte, lowest group first, bit 7 set on all but the last byte
+#define PRINTF_DEFER_MARKER 0x00U
+#define PRINTF_DEFER_HEADER_SIZE 2U
+
+// internal varint append
+// \return The new index, or 0 if the field does not fit into the record
+static size_t _defer_uvar(char *buf, size_t idx, uint32_t value)
+{
+    while (idx < PRINTF_DEFER_BUFFER_SIZE)
+    {
+        if (value < 0x80U)
+        {
+            buf[idx++] = (char)value;
+            return idx;
+        }
+        buf[idx++] = (char)((value & 0x7FU) | 0x80U);
+        value >>= 7U;
+    }
+    return 0U;
+}
+
+#if defined(PRINTF_SUPPORT_LONG_LONG)
+static size_t _defer_uvar_long_long(char *buf, size_t idx, unsigned long long value)
+{
+    while ((value >> 32U) && (idx < PRINTF_DEFER_BUFFER_SIZE))
+    {
+        buf[idx++] = (char)((value & 0x7FU) | 0x80U);
+        value >>= 7U;
+    }
+    return (idx < PRINTF_DEFER_BUFFER_SIZE) ? _defer_uvar(buf, idx, (uint32_t)value) : 0U;
+}
+#endif
+
+// internal fixed size little endian append
+static size_t _defer_word(char *buf, size_t idx, uint32_t value, size_t size)
+{
+    if (idx + size > PRINTF_DEFER_BUFFER_SIZE)
+    {
+        return 0U;
+    }
+    while (size--)
+    {
+        buf[idx++] = (char)(value & 0xFFU);
+        value >>= 8U;
+    }
+    return idx;
+}
+
+// internal deferred vprintf, walks the format only to pick up the arguments
+static int _vprintf_defer(const char *format, va_list va)
+{
+    char buf[PRINTF_DEFER_BUFFER_SIZE];
+    size_t idx = PRINTF_DEFER_HEADER_SIZE;
+    size_t len;
+    unsigned int flags;
+
+    idx = _defer_uvar(buf, idx, (uint32_t)(uintptr_t)format);
+    idx = _defer_word(buf, idx, PRINTF_DEFER_TIMESTAMP(), 2U);
+
+    // length of the record up to the last complete field
+    len = idx;
+    while (*format && idx)
+    {
+        len = idx;
+
+        if (*(format++) != '%')
+        {
+            continue;
+        }
+
+        // flags are rendered on the host
+        while ((*format == '0') || (*format == '-') || (*format == '+') || (*format == ' ') || (*format == '#'))
+        {
+            format++;
+        }
+
+        // width and precision, only '*' takes an argument
+        if (*format == '*')
+        {
+            const int w = va_arg(va, int);
+            idx = _defer_uvar(buf, idx, ((uint32_t)w << 1U) ^ (uint32_t)(w >> 31));
+            format++;
+        }
+        else
+        {
+            (void)_atoi(&format);
+        }
+        if (*format == '.')
+        {
+            format++;
+            if (*format == '*')
+            {
+                const int p = va_arg(va, int);
+                idx = _defer_uvar(buf, idx, ((uint32_t)p << 1U) ^ (uint32_t)(p >> 31));
+                format++;
+            }
+            else
+            {
+                (void)_atoi(&format);
+            }
+        }
+        if (!idx)
+        {
+            break;
+        }
+
+        // length field, same rules as _vsnprintf
+        flags = 0U;
+        switch (*format)
+        {
+        case 'l':
+            flags |= FLAGS_LONG;
+            format++;
+            if (*format == 'l')
+            {
+                flags |= FLAGS_LONG_LONG;
+                format++;
+            }
+            break;
+        case 'h':
+            flags |= FLAGS_SHORT;
+            format++;
+            if (*format == 'h')
+            {
+                flags |= FLAGS_CHAR;
+                format++;
+            }
+            break;
+#if defined(PRINTF_SUPPORT_PTRDIFF_T)
+        case 't':
+            flags |= (sizeof(ptrdiff_t) == sizeof(long) ? FLAGS_LONG : FLAGS_LONG_LONG);
+            format++;
+            break;
+#endif
+        case 'j':
+            flags |= (sizeof(intmax_t) == sizeof(long) ? FLAGS_LONG : FLAGS_LONG_LONG);
+            format++;
+            break;
+        case 'z':
+            flags |= (sizeof(size_t) == sizeof(long) ? FLAGS_LONG : FLAGS_LONG_LONG);
+            format++;
+            break;
+        default:
+            break;
+        }
+
+        switch (*format)
+        {
+        case 'd':
+        case 'i':
+            if (flags & FLAGS_LONG_LONG)
+            {
+#if defined(PRINTF_SUPPORT_LONG_LONG)
+                const long long value = va_arg(va, long long);
+                idx = _defer_uvar_long_long(buf, idx, ((unsigned long long)value << 1U) ^ (unsigned long long)(value >> 63));
+#endif
+            }
+            else
+            {
+                const long value = (flags & FLAGS_LONG) ? va_arg(va, long) : (flags & FLAGS_CHAR) ? (char)va_arg(va, int) : (flags & FLAGS_SHORT) ? (short int)va_arg(va, int) : va_arg(va, int);
+                idx = _defer_uvar(buf, idx, ((uint32_t)value << 1U) ^ (uint32_t)(value >> 31));
+            }
+            break;
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+        case 'b':
+            if (flags & FLAGS_LONG_LONG)
+            {
+#if defined(PRINTF_SUPPORT_LONG_LONG)
+                idx = _defer_uvar_long_long(buf, idx, va_arg(va, unsigned long long));
+#endif
+            }
+            else
+            {
+                const unsigned long value = (flags & FLAGS_LONG) ? va_arg(va, unsigned long) : (flags & FLAGS_CHAR) ? (unsigned char)va_arg(va, unsigned int) : (flags & FLAGS_SHORT) ? (unsigned short int)va_arg(va, unsigned int) : va_arg(va, unsigned int);
+                idx = _defer_uvar(buf, idx, (uint32_t)value);
+            }
+            break;
+        case 'c':
+            idx = _defer_uvar(buf, idx, (unsigned char)va_arg(va, int));
+            break;
+        case 'p':
+            idx = _defer_uvar(buf, idx, (uint32_t)(uintptr_t)va_arg(va, void *));
+            break;
+#if defined(PRINTF_SUPPORT_FLOAT)
+        case 'f':
+        case 'F':
+#if defined(PRINTF_SUPPORT_EXPONENTIAL)
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+#endif
+        {
+            // single precision is all the M4F computes in hardware anyway
+            union {
+                float F;
+                uint32_t U;
+            } conv;
+            conv.F = (float)va_arg(va, double);
+            idx = _defer_word(buf, idx, conv.U, 4U);
+            break;
+        }
+#endif // PRINTF_SUPPORT_FLOAT
+        case 's':
+        {
+            const char *p = va_arg(va, char *);
+            const unsigned int l = _strnlen_s(p, PRINTF_DEFER_MAX_STRING);
+            if (idx + 1U + l > PRINTF_DEFER_BUFFER_SIZE)
+            {
+                idx = 0U;
+                break;
+            }
+            buf[idx++] = (char)l;
+            memcpy(&buf[idx], p, l);
+            idx += l;
+            break;
+        }
+        default:
+            // '%%' or unknown specifier, no argument
+            break;
+        }
+        if (*format)
+        {
+            format++;
+        }
+    }
+
+    if (idx)
+    {
+        len = idx;
+    }
+    // else the last field did not fit, the record ends before it
+
+    buf[0] = (char)PRINTF_DEFER_MARKER;
+    buf[1] = (char)(len - PRINTF_DEFER_HEADER_SIZE);
+    _putblock(buf, len);
+
+    return (int)len;
+}
+#endif // PRINTF_SUPPORT_DEFER
+
+///////////////////////////////////////////////////////////////////////////////
+
+int printf_(const char *format, ...)
+{
+    va_list va;
+    va_start(va, format);
+    char buffer[1];
+    const int ret = _vsnprintf(_out_char, buffer, (size_t)-1, format, va);
+    va_end(va);
+    return ret;
+}
+
+int sprintf_(char *buffer, const char *format, ...)
+{
+    va_list va;
+    va_start(va, format);
+    const int ret = _vsnprintf(_out_buffer, buffer, (size_t)-1, format, va);
+    va_end(va);
+    return ret;
+}
+
+int snprintf_(char *buffer, size_t count, const char *format, ...)
+{
+    va_list va;
+    va_start(va, format);
+    const int ret = _vsnprintf(_out_buffer, buffer, count, format, va);
+    va_end(va);
+    return ret;
+}
+
+int vprintf_(const char *format, va_list va)
+{
+    char buffer[1];
+    return _vsnprintf(_out_char, buffer, (size_t)-1, format, va);
+}
+
+int vsnprintf_(char *buffer, size_t count, const char *format, va_list va)
+{
+    return _vsnprintf(_out_buffer, buffer, count, format, va);
+}
+
+int fctprintf(void (*out)(char character, void *arg), void *arg, const char *format, ...)
+{
+    va_list va;
+    va_start(va, format);
+    const out_fct_wrap_type out_fct_wrap = {out, arg};
+    const int ret = _vsnprintf(_out_fct, (char *)(uintptr_t)&out_fct_wrap, (size_t)-1, format, va);
+    va_end(va);
+    return ret;
+}
+
+#if defined(PRINTF_SUPPORT_DEFER)
+int printf_defer(const char *format, ...)
+{
+    va_list va;
+    va_start(va, format);
+    const int ret = _vprintf_defer(format, va);
+    va_end(va);
+    return ret;
+}
+
+int vprintf_defer(const char *format, va_list va)
+{
+    return _vprintf_defer(format, va);
+}
+#endif // PRINTF_SUPPORT_DEFER
@@ -0,0 +1,336 @@
+/* Host test and benchmark of the integer and %f conversions of printf.c.
+ * printf.c is built as it is into this file and its snprintf_() is compared
+ * with the snprintf() of glibc:
+ *   integers   3M random values over the flags, widths, precisions and bases
+ *              of the int, long and long long formats, plus the edge values
+ *   %f         2M random values below PRINTF_MAX_FLOAT with %.0f .. %.9f,
+ *              plus the half way and rounding edge cases
+ * glibc rounds exactly (half to even), so does the integer only _ftoa of
+ * PRINTF_FAST_FTOA. The double math of the old _ftoa misses the last digit
+ * of some values, its %f mismatches are only counted, not checked.
+ * Then the ns per conversion of both mixes are printed, for printf.c and for
+ * glibc. Build once more with -DPRINTF_DISABLE_FAST_NTOA
+ * -DPRINTF_DISABLE_FAST_FTOA for the numbers of the old conversions.
+ * Exit status 1 on a failed check.
+ *
+ * build: gcc -O2 -Wall -I.. -I../../S32K144_041_printf_per_task_line_buffer
+ *            -I../../S32K144_040_printf_deferred_binary_log -I../../S32K144_057_CAN_socketcan/host
+ *            -o printf_ntoa_test printf_ntoa_test.c
+ * usage: printf_ntoa_test [-n integer values] [-f float values]
+ */
+#define _GNU_SOURCE
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "printf.c"
+/* the output of the test goes to stdout, not to the printf under test */
+#undef printf
+#undef sprintf
+#undef snprintf
+#undef vsnprintf
+
+#define TEST_TEXT_SIZE 128U
+#define TEST_INT_FORMAT_NUM 18U
+#define TEST_LONG_LONG_FORMAT_NUM 8U
+#define TEST_BENCH_NUM 1000000U
+
+static const char *const test_int_format[TEST_INT_FORMAT_NUM] =
+{
+    "%d", "%u", "%x", "%X", "%o", "%b", "%#x", "%#o", "%08d", "%-12d|", "%+d", "% d", "%.5d", "%.0d", "%12.7x",
+    "%ld", "%lu", "%lx"
+};
+static const char *const test_long_long_format[TEST_LONG_LONG_FORMAT_NUM] =
+{
+    "%lld", "%llu", "%llx", "%llX", "%llo", "%#llx", "%25lld", "%.22llu"
+};
+static const char *const test_float_format[10] =
+{
+    "%.0f", "%.1f", "%.2f", "%.3f", "%.4f", "%.5f", "%.6f", "%.7f", "%.8f", "%.9f"
+};
+
+static uint64_t test_seed = 88172645463325252ULL;
+static uint32_t test_error = 0U;
+static uint32_t test_check_num = 0U;
+
+#define TEST_CHECK(cond, ...) do { test_check_num++; if (!(cond)) { printf("FAIL: " __VA_ARGS__); printf("\n"); test_error++; } } while (0)
+
+/* the output path of printf.c, not used by snprintf_() */
+
+void printf_lld_putchar(uint8_t data)
+{
+    (void)data;
+}
+
+void lpuart_lld_tx_put(uint8_t data)
+{
+    (void)data;
+}
+
+bool lpuart_lld_tx_write(const uint8_t *data, uint32_t len)
+{
+    (void)data;
+    (void)len;
+    return true;
+}
+
+TickType_t xTaskGetTickCountFromISR(void)
+{
+    return 0U;
+}
+
+static uint64_t test_rand(void)
+{
+    test_seed ^= test_seed << 13;
+    test_seed ^= test_seed >> 7;
+    test_seed ^= test_seed << 17;
+    return test_seed;
+}
+
+static uint64_t test_ns(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return ((uint64_t)t.tv_sec * 1000000000ULL) + (uint64_t)t.tv_nsec;
+}
+
+/* random magnitudes, so short and long numbers are tested alike */
+static uint64_t test_rand_value(void)
+{
+    return test_rand() >> (test_rand() % 64U);
+}
+
+/* whole numbers, fractions, float values, values near .5 and tiny values */
+static double test_rand_double(uint32_t n)
+{
+    switch (n % 5U)
+    {
+    case 0U:
+        return (double)(test_rand() % 999999999U) / (double)(1U + (test_rand() % 100000U));
+    case 1U:
+        return (double)(float)((double)((int64_t)(test_rand() % 2000000U) - 1000000) /
+                               (double)(1U << (test_rand() % 20U)));
+    case 2U:
+        return ((double)(test_rand() % 100000U) / 1000.0) + 0.0005;
+    case 3U:
+        return -ldexp((double)(test_rand() & 0xFFFFFU), -(int)(test_rand() % 60U));
+    default:
+        return ldexp((double)(test_rand() & 0x1FFFFFFFFFFFFFULL), -(int)(24U + (test_rand() % 60U)));
+    }
+}
+
+static bool test_int(const char *format, uint64_t value)
+{
+    char text[TEST_TEXT_SIZE];
+    char ref[TEST_TEXT_SIZE];
+
+    /* %d negates INT_MIN into unsigned long, 2^31 with the 32 bit long of the
+     * M4, not on this 64 bit host */
+    if ((int)value == INT_MIN)
+    {
+        value++;
+    }
+    if (strstr(format, "ll") != NULL)
+    {
+        (void)snprintf_(text, sizeof(text), format, (long long)value);
+        (void)snprintf(ref, sizeof(ref), format, (long long)value);
+    }
+    else if (strchr(format, 'l') != NULL)
+    {
+        (void)snprintf_(text, sizeof(text), format, (long)value);
+        (void)snprintf(ref, sizeof(ref), format, (long)value);
+    }
+    else
+    {
+        (void)snprintf_(text, sizeof(text), format, (int)value);
+        (void)snprintf(ref, sizeof(ref), format, (int)value);
+    }
+    if (strcmp(text, ref) != 0)
+    {
+        printf("%s of 0x%llx: \"%s\", glibc \"%s\"\n", format, (unsigned long long)value, text, ref);
+        return false;
+    }
+    return true;
+}
+
+static bool test_float(const char *format, double value)
+{
+    char text[TEST_TEXT_SIZE];
+    char ref[TEST_TEXT_SIZE];
+
+    (void)snprintf_(text, sizeof(text), format, value);
+    (void)snprintf(ref, sizeof(ref), format, value);
+    if (strcmp(text, ref) != 0)
+    {
+#if defined(PRINTF_FAST_FTOA)
+        printf("%s of %.20g: \"%s\", glibc \"%s\"\n", format, value, text, ref);
+#endif
+        return false;
+    }
+    return true;
+}
+
+static void test_ints(uint32_t num)
+{
+    static const long long edge[] =
+    {
+        0LL, 1LL, 9LL, 10LL, 99LL, 100LL, 101LL, 999LL, 1000LL, 99999999LL, 100000000LL, 4294967295LL,
+        4294967296LL, -1LL, -2147483647LL, 2147483647LL, 10000000000000000LL, 1000000000000000000LL,
+        9223372036854775807LL, (long long)0x8000000000000000ULL
+    };
+    uint32_t mismatch = 0U;
+    uint32_t n;
+    uint32_t i;
+    uint64_t value;
+
+    for (n = 0U; n < num; n++)
+    {
+        value = test_rand_value();
+        if (!test_int(test_int_format[n % TEST_INT_FORMAT_NUM], value) && (++mismatch > 10U))
+        {
+            break;
+        }
+        if (!test_int(test_long_long_format[n % TEST_LONG_LONG_FORMAT_NUM], value) && (++mismatch > 10U))
+        {
+            break;
+        }
+    }
+    for (i = 0U; i < (sizeof(edge) / sizeof(edge[0])); i++)
+    {
+        for (n = 0U; n < TEST_INT_FORMAT_NUM; n++)
+        {
+            mismatch += test_int(test_int_format[n], (uint64_t)edge[i]) ? 0U : 1U;
+        }
+        for (n = 0U; n < TEST_LONG_LONG_FORMAT_NUM; n++)
+        {
+            mismatch += test_int(test_long_long_format[n], (uint64_t)edge[i]) ? 0U : 1U;
+        }
+    }
+    printf("integers: %u random values, %u edge values, %u mismatches\n", num,
+           (uint32_t)(sizeof(edge) / sizeof(edge[0])), mismatch);
+    TEST_CHECK(mismatch == 0U, "%u integer conversions differ from glibc", mismatch);
+}
+
+static void test_floats(uint32_t num)
+{
+    static const double edge[] =
+    {
+        0.0, 0.5, 1.5, 2.5, 0.125, 0.05, 0.15, 0.25, 0.999999999, 0.9999999995, 3.3, (double)3.3f, 1e-300, 5e-324,
+        999999999.9999999, 1e9 - 1.0, 4294967295.5 / 8.0, -0.5, -2.5, -3.3
+    };
+    uint32_t mismatch = 0U;
+    uint32_t n;
+    uint32_t i;
+
+    for (n = 0U; n < num; n++)
+    {
+        mismatch += test_float(test_float_format[test_rand() % 10U], test_rand_double(n)) ? 0U : 1U;
+    }
+    for (i = 0U; i < (sizeof(edge) / sizeof(edge[0])); i++)
+    {
+        for (n = 0U; n < 10U; n++)
+        {
+            mismatch += test_float(test_float_format[n], edge[i]) ? 0U : 1U;
+        }
+    }
+    printf("%%f: %u random values, %u edge values, %u mismatches\n", num,
+           (uint32_t)(sizeof(edge) / sizeof(edge[0])), mismatch);
+#if defined(PRINTF_FAST_FTOA)
+    TEST_CHECK(mismatch == 0U, "%u %%f conversions differ from glibc", mismatch);
+#endif
+}
+
+/* the same values through printf.c and glibc, the values are made up front */
+static void test_bench(void)
+{
+    static uint64_t value[TEST_BENCH_NUM];
+    static double fvalue[TEST_BENCH_NUM];
+    char text[TEST_TEXT_SIZE];
+    uint64_t start;
+    uint64_t ns[2][2];
+    uint32_t lib;
+    uint32_t n;
+
+    for (n = 0U; n < TEST_BENCH_NUM; n++)
+    {
+        value[n] = test_rand_value();
+        fvalue[n] = test_rand_double(n);
+    }
+    for (lib = 0U; lib < 2U; lib++)
+    {
+        start = test_ns();
+        for (n = 0U; n < TEST_BENCH_NUM; n++)
+        {
+            if (lib == 0U)
+            {
+                (void)snprintf_(text, sizeof(text), "%d %u %x %llu", (int)value[n], (unsigned)value[n],
+                                (unsigned)value[n], (unsigned long long)value[n]);
+            }
+            else
+            {
+                (void)snprintf(text, sizeof(text), "%d %u %x %llu", (int)value[n], (unsigned)value[n],
+                               (unsigned)value[n], (unsigned long long)value[n]);
+            }
+        }
+        ns[lib][0] = test_ns() - start;
+        start = test_ns();
+        for (n = 0U; n < TEST_BENCH_NUM; n++)
+        {
+            if (lib == 0U)
+            {
+                (void)snprintf_(text, sizeof(text), test_float_format[n % 10U], fvalue[n]);
+            }
+            else
+            {
+                (void)snprintf(text, sizeof(text), test_float_format[n % 10U], fvalue[n]);
+            }
+        }
+        ns[lib][1] = test_ns() - start;
+    }
+    printf("printf.c (ntoa %s, ftoa %s): %6.1f ns per integer, %6.1f ns per %%f\n",
+#if defined(PRINTF_FAST_NTOA)
+           "fast",
+#else
+           "old",
+#endif
+#if defined(PRINTF_FAST_FTOA)
+           "fast",
+#else
+           "old",
+#endif
+           (double)ns[0][0] / (4.0 * TEST_BENCH_NUM), (double)ns[0][1] / TEST_BENCH_NUM);
+    printf("glibc                        : %6.1f ns per integer, %6.1f ns per %%f\n",
+           (double)ns[1][0] / (4.0 * TEST_BENCH_NUM), (double)ns[1][1] / TEST_BENCH_NUM);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t int_num = 3000000U;
+    uint32_t float_num = 2000000U;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:f:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            int_num = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'f':
+            float_num = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-n integer values] [-f float values]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    test_ints(int_num);
+    test_floats(float_num);
+    test_bench();
+    printf("%s, %u checks, %u errors\n", (test_error == 0U) ? "PASS" : "FAIL", test_check_num, test_error);
+    return (test_error == 0U) ? 0 : 1;
+}
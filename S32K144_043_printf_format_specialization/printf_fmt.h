@@ -0,0 +1,23 @@
+/* generated by tools/printf_fmt_gen from printf_fmt.def, do not edit */
+#ifndef _PRINTF_FMT_H_
+#define _PRINTF_FMT_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// "adcMax: %d\n"
+int printf_fmt_adc_max(int a0);
+
+// "adc channel: %d\n"
+int printf_fmt_adc_channel(int a0);
+
+// "adc value is: %fV\n"
+int printf_fmt_adc_value(double a0);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _PRINTF_FMT_H_
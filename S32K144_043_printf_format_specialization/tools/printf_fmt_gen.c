@@ -0,0 +1,674 @@
+/* Host side generator for the pre-parsed printf formats.
+ *
+ * Every PRINTF_FMT(name, "format") line of printf_fmt.def becomes a function
+ * printf_fmt_name() with one typed parameter per argument of the format. The
+ * generated body calls the printf.c conversion routines with flags, width and
+ * precision already resolved, so the format is never parsed on the target.
+ * printf.c includes the generated printf_fmt.inc at its end, formats which are
+ * built at run time keep using printf().
+ *
+ * build: gcc -O2 -o printf_fmt_gen printf_fmt_gen.c
+ * usage: printf_fmt_gen printf_fmt.def printf_fmt.h printf_fmt.inc
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#define LINE_SIZE 512U
+#define NAME_SIZE 64U
+#define FORMAT_SIZE 256U
+#define PARAM_SIZE 512U
+#define ARG_NUM_MAX 16U
+
+/* same bits as the FLAGS_* of printf.c, only the names are generated */
+#define FLAGS_ZEROPAD (1U << 0U)
+#define FLAGS_LEFT (1U << 1U)
+#define FLAGS_PLUS (1U << 2U)
+#define FLAGS_SPACE (1U << 3U)
+#define FLAGS_HASH (1U << 4U)
+#define FLAGS_UPPERCASE (1U << 5U)
+#define FLAGS_CHAR (1U << 6U)
+#define FLAGS_SHORT (1U << 7U)
+#define FLAGS_LONG (1U << 8U)
+#define FLAGS_LONG_LONG (1U << 9U)
+#define FLAGS_PRECISION (1U << 10U)
+#define FLAGS_ADAPT_EXP (1U << 11U)
+
+static const char *const flag_names[] = {
+    "FLAGS_ZEROPAD", "FLAGS_LEFT", "FLAGS_PLUS", "FLAGS_SPACE",
+    "FLAGS_HASH", "FLAGS_UPPERCASE", "FLAGS_CHAR", "FLAGS_SHORT",
+    "FLAGS_LONG", "FLAGS_LONG_LONG", "FLAGS_PRECISION", "FLAGS_ADAPT_EXP"};
+
+typedef struct
+{
+    char name[NAME_SIZE];
+    char format[FORMAT_SIZE];
+    size_t len;
+    char params[PARAM_SIZE];
+    unsigned int arg_num;
+} fmt_t;
+
+static const char *def_path;
+static unsigned int def_line;
+
+static void fail(const char *msg)
+{
+    fprintf(stderr, "%s:%u: %s\n", def_path, def_line, msg);
+    exit(1);
+}
+
+static void write_escaped(FILE *fp, const char *str, size_t len)
+{
+    size_t i;
+
+    for (i = 0U; i < len; i++)
+    {
+        const unsigned char ch = (unsigned char)str[i];
+        switch (ch)
+        {
+        case '\n':
+            fputs("\\n", fp);
+            break;
+        case '\r':
+            fputs("\\r", fp);
+            break;
+        case '\t':
+            fputs("\\t", fp);
+            break;
+        case '\\':
+            fputs("\\\\", fp);
+            break;
+        case '"':
+            fputs("\\\"", fp);
+            break;
+        default:
+            if ((ch < 0x20U) || (ch >= 0x7FU))
+            {
+                fprintf(fp, "\\%03o", ch);
+            }
+            else
+            {
+                fputc(ch, fp);
+            }
+            break;
+        }
+    }
+}
+
+static void write_flags(FILE *fp, unsigned int flags)
+{
+    unsigned int i;
+    bool first = true;
+
+    for (i = 0U; i < (sizeof(flag_names) / sizeof(flag_names[0])); i++)
+    {
+        if (flags & (1U << i))
+        {
+            fprintf(fp, "%s%s", first ? "" : " | ", flag_names[i]);
+            first = false;
+        }
+    }
+    if (first)
+    {
+        fputs("0U", fp);
+    }
+}
+
+/* one C string literal, adjacent literals are joined */
+static const char *parse_string(const char *p, fmt_t *fmt)
+{
+    while (*p == '"')
+    {
+        p++;
+        while (*p != '"')
+        {
+            char ch = *p++;
+            if (ch == '\0')
+            {
+                fail("unterminated string");
+            }
+            if (ch == '\\')
+            {
+                ch = *p++;
+                switch (ch)
+                {
+                case 'n':
+                    ch = '\n';
+                    break;
+                case 'r':
+                    ch = '\r';
+                    break;
+                case 't':
+                    ch = '\t';
+                    break;
+                case 'x':
+                    ch = (char)strtoul(p, (char **)&p, 16);
+                    break;
+                case '\\':
+                case '"':
+                case '\'':
+                case '?':
+                    break;
+                default:
+                    if ((ch >= '0') && (ch <= '7'))
+                    {
+                        unsigned int value = (unsigned int)(ch - '0');
+                        unsigned int n;
+                        for (n = 1U; (n < 3U) && (*p >= '0') && (*p <= '7'); n++)
+                        {
+                            value = (value * 8U) + (unsigned int)(*p++ - '0');
+                        }
+                        ch = (char)value;
+                    }
+                    else
+                    {
+                        fail("unknown escape sequence");
+                    }
+                    break;
+                }
+            }
+            if (fmt->len >= (FORMAT_SIZE - 1U))
+            {
+                fail("format too long");
+            }
+            fmt->format[fmt->len++] = ch;
+        }
+        p++;
+        while (isspace((unsigned char)*p))
+        {
+            p++;
+        }
+    }
+    return p;
+}
+
+/* PRINTF_FMT(name, "format"), anything else is skipped */
+static bool parse_line(const char *line, fmt_t *fmt)
+{
+    const char *p = line;
+    size_t n = 0U;
+
+    memset(fmt, 0, sizeof(*fmt));
+    while (isspace((unsigned char)*p))
+    {
+        p++;
+    }
+    if (strncmp(p, "PRINTF_FMT(", 11U) != 0)
+    {
+        return false;
+    }
+    p += 11U;
+    while (isspace((unsigned char)*p))
+    {
+        p++;
+    }
+    while (isalnum((unsigned char)*p) || (*p == '_'))
+    {
+        if (n >= (NAME_SIZE - 1U))
+        {
+            fail("name too long");
+        }
+        fmt->name[n++] = *p++;
+    }
+    if (n == 0U)
+    {
+        fail("missing name");
+    }
+    while (isspace((unsigned char)*p))
+    {
+        p++;
+    }
+    if (*p++ != ',')
+    {
+        fail("expected ','");
+    }
+    while (isspace((unsigned char)*p))
+    {
+        p++;
+    }
+    if (*p != '"')
+    {
+        fail("expected a string literal");
+    }
+    p = parse_string(p, fmt);
+    if (*p != ')')
+    {
+        fail("expected ')'");
+    }
+    return true;
+}
+
+/* adds a parameter, returns its index */
+static unsigned int add_param(fmt_t *fmt, const char *type)
+{
+    char param[64];
+
+    if (fmt->arg_num >= ARG_NUM_MAX)
+    {
+        fail("too many arguments");
+    }
+    snprintf(param, sizeof(param), "%s%s%sa%u", fmt->arg_num ? ", " : "", type,
+             (type[strlen(type) - 1U] == '*') ? "" : " ", fmt->arg_num);
+    if ((strlen(fmt->params) + strlen(param)) >= PARAM_SIZE)
+    {
+        fail("too many arguments");
+    }
+    strcat(fmt->params, param);
+    return fmt->arg_num++;
+}
+
+static void flush_text(FILE *fp, const char *text, size_t *len)
+{
+    if (*len == 1U)
+    {
+        fputs("    _out_char('", fp);
+        if (text[0] == '\'')
+        {
+            fputs("\\'", fp);
+        }
+        else
+        {
+            write_escaped(fp, text, 1U);
+        }
+        fputs("', buffer, idx++, (size_t)-1);\n", fp);
+    }
+    else if (*len > 1U)
+    {
+        fputs("    idx = _out_str(_out_char, buffer, idx, (size_t)-1, \"", fp);
+        write_escaped(fp, text, *len);
+        fprintf(fp, "\", %uU);\n", (unsigned int)*len);
+    }
+    *len = 0U;
+}
+
+/* walks the format like _vsnprintf does and writes one call per conversion,
+ * the parameter list is collected on the way */
+static void gen_body(FILE *fp, fmt_t *fmt)
+{
+    const char *format = fmt->format;
+    const char *end = fmt->format + fmt->len;
+    char text[FORMAT_SIZE];
+    size_t text_len = 0U;
+
+    while (format < end)
+    {
+        unsigned int flags = 0U;
+        unsigned int width = 0U;
+        unsigned int precision = 0U;
+        int width_arg = -1;
+        int precision_arg = -1;
+        unsigned int base = 10U;
+        char width_expr[32];
+        char precision_expr[32];
+        bool runtime_flags;
+        unsigned int arg;
+        char spec;
+
+        if (*format != '%')
+        {
+            text[text_len++] = *format++;
+            continue;
+        }
+        format++;
+
+        // flags
+        for (;;)
+        {
+            if (*format == '0')
+                flags |= FLAGS_ZEROPAD;
+            else if (*format == '-')
+                flags |= FLAGS_LEFT;
+            else if (*format == '+')
+                flags |= FLAGS_PLUS;
+            else if (*format == ' ')
+                flags |= FLAGS_SPACE;
+            else if (*format == '#')
+                flags |= FLAGS_HASH;
+            else
+                break;
+            format++;
+        }
+
+        // width
+        if (isdigit((unsigned char)*format))
+        {
+            while (isdigit((unsigned char)*format))
+            {
+                width = (width * 10U) + (unsigned int)(*format++ - '0');
+            }
+        }
+        else if (*format == '*')
+        {
+            width_arg = (int)add_param(fmt, "int");
+            format++;
+        }
+
+        // precision
+        if (*format == '.')
+        {
+            flags |= FLAGS_PRECISION;
+            format++;
+            if (isdigit((unsigned char)*format))
+            {
+                while (isdigit((unsigned char)*format))
+                {
+                    precision = (precision * 10U) + (unsigned int)(*format++ - '0');
+                }
+            }
+            else if (*format == '*')
+            {
+                precision_arg = (int)add_param(fmt, "int");
+                format++;
+            }
+        }
+
+        // length
+        if (*format == 'l')
+        {
+            flags |= FLAGS_LONG;
+            if (*++format == 'l')
+            {
+                flags |= FLAGS_LONG_LONG;
+                format++;
+            }
+        }
+        else if (*format == 'h')
+        {
+            flags |= FLAGS_SHORT;
+            if (*++format == 'h')
+            {
+                flags |= FLAGS_CHAR;
+                format++;
+            }
+        }
+        else if ((*format == 't') || (*format == 'j') || (*format == 'z'))
+        {
+            fail("length fields t, j and z are not supported, use printf()");
+        }
+
+        if (format >= end)
+        {
+            fail("incomplete conversion at the end of the format");
+        }
+        spec = *format++;
+
+        if (spec == '%')
+        {
+            if ((width_arg >= 0) || (precision_arg >= 0))
+            {
+                fail("'*' with %% is not supported");
+            }
+            text[text_len++] = '%';
+            continue;
+        }
+
+        // same flag rules as in _vsnprintf
+        switch (spec)
+        {
+        case 'd':
+        case 'i':
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+        case 'b':
+            if ((spec == 'x') || (spec == 'X'))
+                base = 16U;
+            else if (spec == 'o')
+                base = 8U;
+            else if (spec == 'b')
+                base = 2U;
+            else
+                flags &= ~FLAGS_HASH;
+            if (spec == 'X')
+                flags |= FLAGS_UPPERCASE;
+            if ((spec != 'i') && (spec != 'd'))
+                flags &= ~(FLAGS_PLUS | FLAGS_SPACE);
+            if (flags & FLAGS_PRECISION)
+                flags &= ~FLAGS_ZEROPAD;
+            break;
+        case 'F':
+        case 'E':
+            flags |= FLAGS_UPPERCASE;
+            break;
+        case 'G':
+            flags |= FLAGS_UPPERCASE | FLAGS_ADAPT_EXP;
+            break;
+        case 'g':
+            flags |= FLAGS_ADAPT_EXP;
+            break;
+        case 'p':
+            if (width_arg >= 0)
+            {
+                fail("'*' width with %p is not supported");
+            }
+            flags |= FLAGS_ZEROPAD | FLAGS_UPPERCASE;
+            break;
+        case 'f':
+        case 'e':
+        case 'c':
+        case 's':
+            break;
+        default:
+            fail("unknown conversion");
+            break;
+        }
+
+        flush_text(fp, text, &text_len);
+
+        // '*' values are only known at run time, they get locals in a block
+        runtime_flags = (width_arg >= 0);
+        if (width_arg >= 0)
+        {
+            snprintf(width_expr, sizeof(width_expr), "width");
+        }
+        else if (spec == 'p')
+        {
+            snprintf(width_expr, sizeof(width_expr), "sizeof(void *) * 2U");
+        }
+        else
+        {
+            snprintf(width_expr, sizeof(width_expr), "%uU", width);
+        }
+        if (precision_arg >= 0)
+        {
+            snprintf(precision_expr, sizeof(precision_expr), "precision");
+        }
+        else
+        {
+            snprintf(precision_expr, sizeof(precision_expr), "%uU", precision);
+        }
+
+        if ((width_arg >= 0) || (precision_arg >= 0))
+        {
+            fputs("    {\n", fp);
+            if (width_arg >= 0)
+            {
+                fprintf(fp, "        const unsigned int width = (a%d < 0) ? (unsigned int)-a%d : (unsigned int)a%d;\n",
+                        width_arg, width_arg, width_arg);
+                fprintf(fp, "        const unsigned int flags = (a%d < 0) ? (", width_arg);
+                write_flags(fp, flags | FLAGS_LEFT);
+                fputs(") : (", fp);
+                write_flags(fp, flags);
+                fputs(");\n", fp);
+            }
+            if (precision_arg >= 0)
+            {
+                fprintf(fp, "        const unsigned int precision = (a%d > 0) ? (unsigned int)a%d : 0U;\n",
+                        precision_arg, precision_arg);
+            }
+        }
+
+        switch (spec)
+        {
+        case 'd':
+        case 'i':
+            if (flags & FLAGS_LONG_LONG)
+            {
+                arg = add_param(fmt, "long long");
+                fputs("#if defined(PRINTF_SUPPORT_LONG_LONG)\n", fp);
+                fprintf(fp, "    idx = _ntoa_long_long(_out_char, buffer, idx, (size_t)-1, (unsigned long long)(a%u > 0 ? a%u : 0 - a%u), a%u < 0, %uU, %s, %s, ",
+                        arg, arg, arg, arg, base, precision_expr, width_expr);
+            }
+            else
+            {
+                arg = add_param(fmt, (flags & FLAGS_LONG) ? "long" : ((flags & FLAGS_CHAR) ? "char" : ((flags & FLAGS_SHORT) ? "short int" : "int")));
+                fprintf(fp, "    idx = _ntoa_long(_out_char, buffer, idx, (size_t)-1, (%s)(a%u > 0 ? a%u : 0 - a%u), a%u < 0, %uU, %s, %s, ",
+                        (flags & FLAGS_LONG) ? "unsigned long" : "unsigned int", arg, arg, arg, arg, base, precision_expr, width_expr);
+            }
+            break;
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+        case 'b':
+            if (flags & FLAGS_LONG_LONG)
+            {
+                arg = add_param(fmt, "unsigned long long");
+                fputs("#if defined(PRINTF_SUPPORT_LONG_LONG)\n", fp);
+                fprintf(fp, "    idx = _ntoa_long_long(_out_char, buffer, idx, (size_t)-1, a%u, false, %uU, %s, %s, ",
+                        arg, base, precision_expr, width_expr);
+            }
+            else
+            {
+                arg = add_param(fmt, (flags & FLAGS_LONG) ? "unsigned long" : ((flags & FLAGS_CHAR) ? "unsigned char" : ((flags & FLAGS_SHORT) ? "unsigned short int" : "unsigned int")));
+                fprintf(fp, "    idx = _ntoa_long(_out_char, buffer, idx, (size_t)-1, a%u, false, %uU, %s, %s, ",
+                        arg, base, precision_expr, width_expr);
+            }
+            break;
+        case 'f':
+        case 'F':
+            arg = add_param(fmt, "double");
+            fputs("#if defined(PRINTF_SUPPORT_FLOAT)\n", fp);
+            fprintf(fp, "    idx = _ftoa(_out_char, buffer, idx, (size_t)-1, a%u, %s, %s, ", arg, precision_expr, width_expr);
+            break;
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+            arg = add_param(fmt, "double");
+            fputs("#if defined(PRINTF_SUPPORT_FLOAT) && defined(PRINTF_SUPPORT_EXPONENTIAL)\n", fp);
+            fprintf(fp, "    idx = _etoa(_out_char, buffer, idx, (size_t)-1, a%u, %s, %s, ", arg, precision_expr, width_expr);
+            break;
+        case 'c':
+            arg = add_param(fmt, "int");
+            fprintf(fp, "    idx = _ctoa(_out_char, buffer, idx, (size_t)-1, (char)a%u, %s, ", arg, width_expr);
+            break;
+        case 's':
+            arg = add_param(fmt, "const char *");
+            fprintf(fp, "    idx = _stoa(_out_char, buffer, idx, (size_t)-1, a%u, %s, %s, ", arg, precision_expr, width_expr);
+            break;
+        default: // 'p'
+            arg = add_param(fmt, "const void *");
+            fprintf(fp, "    idx = _ntoa_long(_out_char, buffer, idx, (size_t)-1, (unsigned long)((uintptr_t)a%u), false, 16U, %s, %s, ",
+                    arg, precision_expr, width_expr);
+            break;
+        }
+        if (runtime_flags)
+        {
+            fputs("flags", fp);
+        }
+        else
+        {
+            write_flags(fp, flags);
+        }
+        fputs(");\n", fp);
+
+        if (((spec == 'd') || (spec == 'i') || (spec == 'u') || (spec == 'x') || (spec == 'X') || (spec == 'o') || (spec == 'b')) &&
+            (flags & FLAGS_LONG_LONG))
+        {
+            fprintf(fp, "#else\n    (void)a%u;\n#endif\n", arg);
+        }
+        else if ((spec == 'f') || (spec == 'F') || (spec == 'e') || (spec == 'E') || (spec == 'g') || (spec == 'G'))
+        {
+            fprintf(fp, "#else\n    (void)a%u;\n#endif\n", arg);
+        }
+        if ((width_arg >= 0) || (precision_arg >= 0))
+        {
+            fputs("    }\n", fp);
+        }
+    }
+    flush_text(fp, text, &text_len);
+}
+
+int main(int argc, char *argv[])
+{
+    FILE *def;
+    FILE *hdr;
+    FILE *inc;
+    FILE *body;
+    bool ok = true;
+    char line[LINE_SIZE];
+    fmt_t fmt;
+    int ch;
+
+    if (argc != 4)
+    {
+        fprintf(stderr, "usage: %s printf_fmt.def printf_fmt.h printf_fmt.inc\n", argv[0]);
+        return 1;
+    }
+
+    def_path = argv[1];
+    def = fopen(argv[1], "r");
+    hdr = fopen(argv[2], "w");
+    inc = fopen(argv[3], "w");
+    if ((def == NULL) || (hdr == NULL) || (inc == NULL))
+    {
+        perror("printf_fmt_gen");
+        return 1;
+    }
+
+    fprintf(hdr, "/* generated by tools/printf_fmt_gen from printf_fmt.def, do not edit */\n");
+    fprintf(hdr, "#ifndef _PRINTF_FMT_H_\n#define _PRINTF_FMT_H_\n\n");
+    fprintf(hdr, "#ifdef __cplusplus\nextern \"C\"\n{\n#endif\n\n");
+    fprintf(inc, "/* generated by tools/printf_fmt_gen from printf_fmt.def, do not edit */\n");
+
+    while (fgets(line, sizeof(line), def) != NULL)
+    {
+        def_line++;
+        if (!parse_line(line, &fmt))
+        {
+            continue;
+        }
+
+        // the body is written first, it collects the parameter list
+        body = tmpfile();
+        if (body == NULL)
+        {
+            perror("printf_fmt_gen");
+            return 1;
+        }
+        gen_body(body, &fmt);
+        rewind(body);
+
+        fprintf(hdr, "// \"");
+        write_escaped(hdr, fmt.format, fmt.len);
+        fprintf(hdr, "\"\nint printf_fmt_%s(%s);\n\n", fmt.name, fmt.arg_num ? fmt.params : "void");
+
+        fprintf(inc, "\n// \"");
+        write_escaped(inc, fmt.format, fmt.len);
+        fprintf(inc, "\"\nint printf_fmt_%s(%s)\n{\n", fmt.name, fmt.arg_num ? fmt.params : "void");
+        fprintf(inc, "    char buffer[1];\n    size_t idx = 0U;\n\n");
+        while ((ch = fgetc(body)) != EOF)
+        {
+            fputc(ch, inc);
+        }
+        fprintf(inc, "    return (int)idx;\n}\n");
+        fclose(body);
+    }
+
+    fprintf(hdr, "#ifdef __cplusplus\n}\n#endif\n\n#endif // _PRINTF_FMT_H_\n");
+
+    fclose(def);
+    ok = (fclose(hdr) == 0) && ok;
+    ok = (fclose(inc) == 0) && ok;
+    if (!ok)
+    {
+        perror("printf_fmt_gen");
+        return 1;
+    }
+    return 0;
+}
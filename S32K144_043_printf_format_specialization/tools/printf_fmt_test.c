@@ -0,0 +1,363 @@
+/* Host test and benchmark of the functions made by printf_fmt_gen. A random
+ * corpus of formats is generated, every format is turned into a function by
+ * printf_fmt_gen and called with random arguments next to printf_() with the
+ * same format and arguments. The chars sent and the return values must be
+ * the same. The corpus covers all flags, fixed and '*' width and precision,
+ * the hh/h/l/ll lengths and all conversions. Then three formats of the board
+ * are timed through both paths. Exit status 1 on a failed check.
+ *
+ * The corpus is made in two steps, the first build writes it:
+ * build: gcc -O2 -Wall -I.. -I../../S32K144_041_printf_per_task_line_buffer
+ *            -I../../S32K144_040_printf_deferred_binary_log -I../../S32K144_057_CAN_socketcan/host
+ *            -o printf_fmt_test printf_fmt_test.c
+ *        ./printf_fmt_test -g 600
+ *        ./printf_fmt_gen printf_fmt_test.def printf_fmt_test.h printf_fmt_test.inc
+ *        gcc <same flags> -DPRINTF_FMT_TEST_CORPUS -o printf_fmt_test printf_fmt_test.c
+ * usage: printf_fmt_test [-g formats] [-n calls]
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+/* the functions of the lesson are not built, the corpus is included below */
+#define PRINTF_DISABLE_SUPPORT_FMT
+#include "printf.c"
+#if defined(PRINTF_FMT_TEST_CORPUS)
+#include "printf_fmt_test.h"
+#include "printf_fmt_test.inc"
+#endif
+/* the output of the test goes to stdout, not to the printf under test */
+#undef printf
+
+#define TEST_OUT_SIZE 512U
+#define TEST_ARG_SIZE 256U
+
+static char test_out[TEST_OUT_SIZE];
+static uint32_t test_out_len;
+static uint64_t test_seed = 88172645463325252ULL;
+static uint32_t test_error = 0U;
+static uint32_t test_check_num = 0U;
+
+#define TEST_CHECK(cond, ...) do { test_check_num++; if (!(cond)) { printf("FAIL: " __VA_ARGS__); printf("\n"); test_error++; } } while (0)
+
+/* the output path of printf.c, _putchar() lands here */
+
+void printf_lld_putchar(uint8_t data)
+{
+    if (test_out_len < (TEST_OUT_SIZE - 1U))
+    {
+        test_out[test_out_len++] = (char)data;
+    }
+}
+
+void lpuart_lld_tx_put(uint8_t data)
+{
+    printf_lld_putchar(data);
+}
+
+bool lpuart_lld_tx_write(const uint8_t *data, uint32_t len)
+{
+    (void)data;
+    (void)len;
+    return true;
+}
+
+TickType_t xTaskGetTickCountFromISR(void)
+{
+    return 0U;
+}
+
+static uint64_t test_rand(void)
+{
+    test_seed ^= test_seed << 13;
+    test_seed ^= test_seed >> 7;
+    test_seed ^= test_seed << 17;
+    return test_seed;
+}
+
+static uint64_t test_ns(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return ((uint64_t)t.tv_sec * 1000000000ULL) + (uint64_t)t.tv_nsec;
+}
+
+#define TEST_PICK(table) (table[test_rand() % (sizeof(table) / sizeof(table[0]))])
+
+typedef enum
+{
+    TEST_INT = 0,
+    TEST_UINT,
+    TEST_LONG,
+    TEST_ULONG,
+    TEST_LONG_LONG,
+    TEST_ULONG_LONG,
+    TEST_DOUBLE,
+    TEST_CHAR,
+    TEST_STRING,
+    TEST_POINTER
+} test_type_t;
+
+typedef struct
+{
+    const char *conv;
+    test_type_t type;
+    const char *cast;           /* the parameter type of hh and h */
+} test_conv_t;
+
+/* one random argument of the type as C source */
+static void test_arg(char *arg, size_t size, test_type_t type)
+{
+    static const char *const ints[] = {"0", "1", "-1", "2147483647", "-2147483647", "-100000", "99999"};
+    static const char *const uints[] = {"0U", "1U", "4294967295U", "999U", "65535U", "256U"};
+    static const char *const doubles[] =
+    {
+        "0.0", "-0.0", "1.5", "2.5", "-3.25", "0.125", "123456789.123", "1e12", "-1e15", "9.999999e-5"
+    };
+    static const char *const strings[] = {"\"\"", "\"a\"", "\"hello\"", "\"longer string here\""};
+
+    switch (type)
+    {
+    case TEST_INT:
+        if ((test_rand() % 2U) == 0U)
+        {
+            (void)snprintf(arg, size, "%s", TEST_PICK(ints));
+        }
+        else
+        {
+            (void)snprintf(arg, size, "%d", (int)(uint32_t)test_rand() | 1);
+        }
+        break;
+    case TEST_UINT:
+        if ((test_rand() % 2U) == 0U)
+        {
+            (void)snprintf(arg, size, "%s", TEST_PICK(uints));
+        }
+        else
+        {
+            (void)snprintf(arg, size, "%uU", (uint32_t)test_rand());
+        }
+        break;
+    case TEST_LONG:
+        (void)snprintf(arg, size, "%dL", (int32_t)((uint32_t)test_rand() | 1U));
+        break;
+    case TEST_ULONG:
+        (void)snprintf(arg, size, "%uUL", (uint32_t)test_rand());
+        break;
+    case TEST_LONG_LONG:
+        (void)snprintf(arg, size, "%lldLL", (long long)(test_rand() >> (test_rand() % 64U)) - 5LL);
+        break;
+    case TEST_ULONG_LONG:
+        (void)snprintf(arg, size, "%lluULL", (unsigned long long)(test_rand() >> (test_rand() % 64U)));
+        break;
+    case TEST_DOUBLE:
+        if ((test_rand() % 2U) == 0U)
+        {
+            (void)snprintf(arg, size, "%s", TEST_PICK(doubles));
+        }
+        else
+        {
+            (void)snprintf(arg, size, "%.17g", ((double)(int64_t)test_rand() / 9.223372036854775807e18) *
+                           (double)(1U << (test_rand() % 24U)));
+        }
+        break;
+    case TEST_CHAR:
+        (void)snprintf(arg, size, "'%c'", (char)('A' + (test_rand() % 26U)));
+        break;
+    case TEST_STRING:
+        (void)snprintf(arg, size, "%s", TEST_PICK(strings));
+        break;
+    default:
+        (void)snprintf(arg, size, "(const void *)0x%08xUL", (uint32_t)test_rand());
+        break;
+    }
+}
+
+/* @brief: Write the corpus, the formats to printf_fmt_test.def and the
+ *         checks to printf_fmt_test_calls.inc
+ * @param num : number of random formats
+ * @return    : false if a file can not be written
+ */
+static bool test_generate(uint32_t num)
+{
+    static const char *const flags[] = {"", "-", "0", "+", " ", "#", "-+", "0#", "+ "};
+    static const char *const widths[] = {"", "5", "12", "*"};
+    static const char *const precisions[] = {"", ".0", ".3", ".8", ".*", "."};
+    static const char *const literals[] = {"", "x=", "val ", "it's ", "\\\"q\\\" ", "100%% ", "tab\\t"};
+    static const char *const separators[] = {"", " ", "|", "\\n"};
+    static const test_conv_t convs[] =
+    {
+        {"d", TEST_INT, ""}, {"i", TEST_INT, ""}, {"u", TEST_UINT, ""}, {"x", TEST_UINT, ""}, {"X", TEST_UINT, ""},
+        {"o", TEST_UINT, ""}, {"b", TEST_UINT, ""}, {"ld", TEST_LONG, ""}, {"lu", TEST_ULONG, ""},
+        {"lx", TEST_ULONG, ""}, {"lld", TEST_LONG_LONG, ""}, {"llu", TEST_ULONG_LONG, ""},
+        {"llX", TEST_ULONG_LONG, ""}, {"hd", TEST_INT, "(short)"}, {"hhd", TEST_INT, "(signed char)"},
+        {"hu", TEST_UINT, "(unsigned short)"}, {"hhx", TEST_UINT, "(unsigned char)"}, {"f", TEST_DOUBLE, ""},
+        {"F", TEST_DOUBLE, ""}, {"e", TEST_DOUBLE, ""}, {"E", TEST_DOUBLE, ""}, {"g", TEST_DOUBLE, ""},
+        {"G", TEST_DOUBLE, ""}, {"c", TEST_CHAR, ""}, {"s", TEST_STRING, ""}, {"p", TEST_POINTER, ""}
+    };
+    char format[TEST_ARG_SIZE];
+    char args[TEST_ARG_SIZE * 4U];
+    char arg[TEST_ARG_SIZE];
+    const test_conv_t *conv;
+    const char *width;
+    const char *precision;
+    FILE *def = fopen("printf_fmt_test.def", "w");
+    FILE *calls = fopen("printf_fmt_test_calls.inc", "w");
+    uint32_t n;
+    uint32_t i;
+    uint32_t conv_num;
+
+    if ((def == NULL) || (calls == NULL))
+    {
+        return false;
+    }
+    fprintf(def, "/* random corpus of tools/printf_fmt_test.c */\n");
+    for (n = 0U; n < num; n++)
+    {
+        (void)snprintf(format, sizeof(format), "%s", TEST_PICK(literals));
+        args[0] = '\0';
+        conv_num = 1U + (uint32_t)(test_rand() % 3U);
+        for (i = 0U; i < conv_num; i++)
+        {
+            conv = &TEST_PICK(convs);
+            width = TEST_PICK(widths);
+            precision = TEST_PICK(precisions);
+            if ((conv->type == TEST_POINTER) && (width[0] == '*'))
+            {
+                width = "";
+            }
+            if ((conv->type == TEST_CHAR) || (conv->type == TEST_POINTER))
+            {
+                precision = "";
+            }
+            (void)snprintf(&format[strlen(format)], sizeof(format) - strlen(format), "%%%s%s%s%s%s",
+                           TEST_PICK(flags), width, precision, conv->conv, TEST_PICK(separators));
+            if (width[0] == '*')
+            {
+                (void)snprintf(&args[strlen(args)], sizeof(args) - strlen(args), ", %d",
+                               (int)(test_rand() % 31U) - 15);
+            }
+            if (strcmp(precision, ".*") == 0)
+            {
+                (void)snprintf(&args[strlen(args)], sizeof(args) - strlen(args), ", %d",
+                               (int)(test_rand() % 15U) - 2);
+            }
+            test_arg(arg, sizeof(arg), conv->type);
+            (void)snprintf(&args[strlen(args)], sizeof(args) - strlen(args), ", %s%s", conv->cast, arg);
+        }
+        fprintf(def, "PRINTF_FMT(t%u, \"%s\")\n", n, format);
+        fprintf(calls, "    TEST_FMT(printf_fmt_t%u(%s), printf_(\"%s\"%s), \"%s\");\n", n, &args[2], format, args,
+                format);
+    }
+    fprintf(def, "PRINTF_FMT(noarg, \"plain %%%% text\\n\")\n");
+    fprintf(calls, "    TEST_FMT(printf_fmt_noarg(), printf_(\"plain %%%% text\\n\"), \"noarg\");\n");
+    /* the formats of the benchmark, as printed by the board */
+    fprintf(def, "PRINTF_FMT(bench_int, \"adcMax: %%d\\n\")\n");
+    fprintf(def, "PRINTF_FMT(bench_float, \"adc value is: %%fV\\n\")\n");
+    fprintf(def, "PRINTF_FMT(bench_string, \"%%s: %%d\\n\")\n");
+    return (fclose(def) == 0) && (fclose(calls) == 0);
+}
+
+#if defined(PRINTF_FMT_TEST_CORPUS)
+
+/* the chars and the return value of the generated function, then those of
+ * printf_() */
+#define TEST_FMT(fmt_call, printf_call, format) do \
+    { \
+        char fmt_out[TEST_OUT_SIZE]; \
+        int fmt_ret; \
+        int printf_ret; \
+        test_out_len = 0U; \
+        fmt_ret = (fmt_call); \
+        test_out[test_out_len] = '\0'; \
+        memcpy(fmt_out, test_out, test_out_len + 1U); \
+        test_out_len = 0U; \
+        printf_ret = (printf_call); \
+        test_out[test_out_len] = '\0'; \
+        TEST_CHECK((strcmp(fmt_out, test_out) == 0) && (fmt_ret == printf_ret), \
+                   "%s: \"%s\" %d, printf_ \"%s\" %d", format, fmt_out, fmt_ret, test_out, printf_ret); \
+    } while (0)
+
+static void test_corpus(void)
+{
+#include "printf_fmt_test_calls.inc"
+}
+
+static void test_bench(uint32_t num)
+{
+    uint64_t start;
+    uint64_t ns[2];
+    uint32_t path;
+    uint32_t n;
+
+    for (path = 0U; path < 2U; path++)
+    {
+        start = test_ns();
+        for (n = 0U; n < num; n++)
+        {
+            test_out_len = 0U;
+            if (path == 0U)
+            {
+                (void)printf_("adcMax: %d\n", (int)n);
+                (void)printf_("adc value is: %fV\n", (double)n * 0.001);
+                (void)printf_("%s: %d\n", "can_lld_error_num", (int)n);
+            }
+            else
+            {
+                (void)printf_fmt_bench_int((int)n);
+                (void)printf_fmt_bench_float((double)n * 0.001);
+                (void)printf_fmt_bench_string("can_lld_error_num", (int)n);
+            }
+        }
+        ns[path] = test_ns() - start;
+    }
+    printf("printf_    %6.1f ns per call\n", (double)ns[0] / (3.0 * num));
+    printf("printf_fmt %6.1f ns per call\n", (double)ns[1] / (3.0 * num));
+}
+
+#endif // PRINTF_FMT_TEST_CORPUS
+
+int main(int argc, char **argv)
+{
+    uint32_t num = 1000000U;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "g:n:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'g':
+            if (!test_generate((uint32_t)strtoul(optarg, NULL, 0)))
+            {
+                perror("printf_fmt_test");
+                return 1;
+            }
+            printf("printf_fmt_test.def and printf_fmt_test_calls.inc written\n");
+            return 0;
+        case 'n':
+            num = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-g formats] [-n calls]\n", argv[0]);
+            return 2;
+        }
+    }
+
+#if defined(PRINTF_FMT_TEST_CORPUS)
+    test_corpus();
+    printf("%u formats checked against printf_\n", test_check_num);
+    test_bench(num);
+    printf("%s, %u checks, %u errors\n", (test_error == 0U) ? "PASS" : "FAIL", test_check_num, test_error);
+    return (test_error == 0U) ? 0 : 1;
+#else
+    (void)num;
+    (void)test_ns;
+    (void)test_error;
+    (void)test_check_num;
+    fprintf(stderr, "no corpus built in, write it with -g and build with -DPRINTF_FMT_TEST_CORPUS\n");
+    return 2;
+#endif
+}
@@ -0,0 +1,253 @@
+#include "gps_lld.h"
+
+/* longest sentence handed to minmea, "$...*hh" plus "\r\n" */
+#define GPS_LLD_SENTENCE_MAX_LEN (MINMEA_MAX_LENGTH + 3U)
+
+struct minmea_sentence_rmc gps_lld_rmc_last;
+uint32_t gps_lld_rmc_num = 0U;
+uint32_t gps_lld_sentence_num = 0U;
+uint32_t gps_lld_invalid_num = 0U;
+uint32_t gps_lld_unknown_num = 0U;
+uint32_t gps_lld_too_long_num = 0U;
+uint32_t gps_lld_overrun_num = 0U;
+
+static void gps_lld_rmc_cbk(const struct minmea_sentence_rmc *frame);
+static void gps_lld_dispatch(uint32_t start, uint32_t len);
+
+static gps_lld_cbk_t gps_lld_cbk = {
+    .rmc = gps_lld_rmc_cbk,
+};
+
+/* framer state, all positions are free running RX ring buffer counts */
+static uint32_t gps_lld_read_pos = 0U;
+static uint32_t gps_lld_line_start = 0U;
+static bool gps_lld_in_line = false;
+
+void gps_lld_display_msg_type(enum minmea_sentence_id type)
+{
+    switch (type)
+    {
+    case MINMEA_INVALID:
+        printf("message type is MINMEA_INVALID\n");
+        break;
+    case MINMEA_UNKNOWN:
+        printf("message type is MINMEA_UNKNOWN\n");
+        break;
+    case MINMEA_SENTENCE_RMC:
+        printf("message type is MINMEA_SENTENCE_RMC\n");
+        break;
+    case MINMEA_SENTENCE_GGA:
+        printf("message type is MINMEA_SENTENCE_GGA\n");
+        break;
+    case MINMEA_SENTENCE_GSA:
+        printf("message type is MINMEA_SENTENCE_GSA\n");
+        break;
+    case MINMEA_SENTENCE_GLL:
+        printf("message type is MINMEA_SENTENCE_GLL\n");
+        break;
+    case MINMEA_SENTENCE_GST:
+        printf("message type is MINMEA_SENTENCE_GST\n");
+        break;
+    case MINMEA_SENTENCE_GSV:
+        printf("message type is MINMEA_SENTENCE_GSV\n");
+        break;
+    case MINMEA_SENTENCE_VTG:
+        printf("message type is MINMEA_SENTENCE_VTG\n");
+        break;
+    case MINMEA_SENTENCE_ZDA:
+        printf("message type is MINMEA_SENTENCE_ZDA\n");
+        break;
+    default:
+        printf("wrong type is input!\n");
+        break;
+    }
+}
+
+/* @brief: Replace the sentence handlers
+ * @param cbk : handler table, copied
+ * @return    : None
+ */
+void gps_lld_set_cbk(const gps_lld_cbk_t *cbk)
+{
+    gps_lld_cbk = *cbk;
+}
+
+/* @brief: Frame the NMEA sentences received since the last call and hand them
+ *         to minmea, the sentences are parsed in place in the RX ring buffer
+ * @return: None
+ */
+void gps_lld_step(void)
+{
+    const uint32_t write_pos = lpuart_lld_rx_count();
+    uint32_t pos = gps_lld_read_pos;
+    uint8_t data;
+
+    if ((write_pos - pos) > LPUART_LLD_RX_BUF_SIZE)
+    {
+        /* the DMA has lapped the reader, resync on the next '$' */
+        gps_lld_overrun_num++;
+        pos = write_pos - LPUART_LLD_RX_BUF_SIZE;
+        gps_lld_in_line = false;
+    }
+
+    while (pos != write_pos)
+    {
+        data = lpuart_lld_rx_buf[pos & LPUART_LLD_RX_BUF_MASK];
+        if (data == '$')
+        {
+            gps_lld_line_start = pos;
+            gps_lld_in_line = true;
+        }
+        else if (gps_lld_in_line)
+        {
+            if (data == '\n')
+            {
+                gps_lld_in_line = false;
+                gps_lld_dispatch(gps_lld_line_start, (pos + 1U) - gps_lld_line_start);
+            }
+            else if (((pos + 1U) - gps_lld_line_start) >= GPS_LLD_SENTENCE_MAX_LEN)
+            {
+                gps_lld_in_line = false;
+                gps_lld_too_long_num++;
+            }
+        }
+        pos++;
+    }
+
+    gps_lld_read_pos = pos;
+}
+
+void freertos_task_gps(void *pvParameters)
+{
+    const TickType_t delay_tick = pdMS_TO_TICKS(GPS_LLD_TASK_PERIOD_MS);
+    TickType_t last_wake_time = xTaskGetTickCount();
+
+    (void)pvParameters;
+
+    for (;;)
+    {
+        gps_lld_step();
+        vTaskDelayUntil(&last_wake_time, delay_tick);
+    }
+}
+
+static void gps_lld_rmc_cbk(const struct minmea_sentence_rmc *frame)
+{
+    gps_lld_rmc_last = *frame;
+    gps_lld_rmc_num++;
+}
+
+/* @brief: Check one framed sentence, parse it and call its handler
+ * @param start : position of the '$'
+ * @param len   : length up to and including the '\n'
+ * @return      : None
+ */
+static void gps_lld_dispatch(uint32_t start, uint32_t len)
+{
+    union
+    {
+        struct minmea_sentence_rmc rmc;
+        struct minmea_sentence_gga gga;
+        struct minmea_sentence_gsa gsa;
+        struct minmea_sentence_gll gll;
+        struct minmea_sentence_gst gst;
+        struct minmea_sentence_gsv gsv;
+        struct minmea_sentence_vtg vtg;
+        struct minmea_sentence_zda zda;
+    } frame;
+    char *sentence = (char *)lpuart_lld_rx_linear(start, len);
+    enum minmea_sentence_id id;
+    bool parsed = false;
+
+    /* terminate the sentence in place, the "\r\n" is not needed by minmea */
+    sentence[len - 1U] = '\0';
+    if ((len > 1U) && (sentence[len - 2U] == '\r'))
+    {
+        sentence[len - 2U] = '\0';
+    }
+
+    /* checks the checksum as well */
+    id = minmea_sentence_id(sentence, false);
+    switch (id)
+    {
+    case MINMEA_SENTENCE_RMC:
+        parsed = (gps_lld_cbk.rmc != NULL) && minmea_parse_rmc(&frame.rmc, sentence);
+        break;
+    case MINMEA_SENTENCE_GGA:
+        parsed = (gps_lld_cbk.gga != NULL) && minmea_parse_gga(&frame.gga, sentence);
+        break;
+    case MINMEA_SENTENCE_GSA:
+        parsed = (gps_lld_cbk.gsa != NULL) && minmea_parse_gsa(&frame.gsa, sentence);
+        break;
+    case MINMEA_SENTENCE_GLL:
+        parsed = (gps_lld_cbk.gll != NULL) && minmea_parse_gll(&frame.gll, sentence);
+        break;
+    case MINMEA_SENTENCE_GST:
+        parsed = (gps_lld_cbk.gst != NULL) && minmea_parse_gst(&frame.gst, sentence);
+        break;
+    case MINMEA_SENTENCE_GSV:
+        parsed = (gps_lld_cbk.gsv != NULL) && minmea_parse_gsv(&frame.gsv, sentence);
+        break;
+    case MINMEA_SENTENCE_VTG:
+        parsed = (gps_lld_cbk.vtg != NULL) && minmea_parse_vtg(&frame.vtg, sentence);
+        break;
+    case MINMEA_SENTENCE_ZDA:
+        parsed = (gps_lld_cbk.zda != NULL) && minmea_parse_zda(&frame.zda, sentence);
+        break;
+    default:
+        break;
+    }
+
+    /* the DMA may have overwritten the sentence while it was parsed */
+    if ((lpuart_lld_rx_count() - start) > LPUART_LLD_RX_BUF_SIZE)
+    {
+        gps_lld_overrun_num++;
+        return;
+    }
+
+    if (id == MINMEA_INVALID)
+    {
+        gps_lld_invalid_num++;
+        return;
+    }
+    if (id == MINMEA_UNKNOWN)
+    {
+        gps_lld_unknown_num++;
+        return;
+    }
+    gps_lld_sentence_num++;
+    if (!parsed)
+    {
+        return;
+    }
+
+    switch (id)
+    {
+    case MINMEA_SENTENCE_RMC:
+        gps_lld_cbk.rmc(&frame.rmc);
+        break;
+    case MINMEA_SENTENCE_GGA:
+        gps_lld_cbk.gga(&frame.gga);
+        break;
+    case MINMEA_SENTENCE_GSA:
+        gps_lld_cbk.gsa(&frame.gsa);
+        break;
+    case MINMEA_SENTENCE_GLL:
+        gps_lld_cbk.gll(&frame.gll);
+        break;
+    case MINMEA_SENTENCE_GST:
+        gps_lld_cbk.gst(&frame.gst);
+        break;
+    case MINMEA_SENTENCE_GSV:
+        gps_lld_cbk.gsv(&frame.gsv);
+        break;
+    case MINMEA_SENTENCE_VTG:
+        gps_lld_cbk.vtg(&frame.vtg);
+        break;
+    case MINMEA_SENTENCE_ZDA:
+        gps_lld_cbk.zda(&frame.zda);
+        break;
+    default:
+        break;
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef GPS_LLD_H
+#define GPS_LLD_H
+
+#include "minmea.h"
+#include "printf.h"
+#include "lpuart_lld.h"
+
+/* period of freertos_task_gps, 115200 baud fills about 58 bytes in 5ms */
+#define GPS_LLD_TASK_PERIOD_MS 5U
+
+/* handlers called by gps_lld_step() for every valid sentence, NULL entries
+ * are not parsed at all */
+typedef struct
+{
+    void (*rmc)(const struct minmea_sentence_rmc *frame);
+    void (*gga)(const struct minmea_sentence_gga *frame);
+    void (*gsa)(const struct minmea_sentence_gsa *frame);
+    void (*gll)(const struct minmea_sentence_gll *frame);
+    void (*gst)(const struct minmea_sentence_gst *frame);
+    void (*gsv)(const struct minmea_sentence_gsv *frame);
+    void (*vtg)(const struct minmea_sentence_vtg *frame);
+    void (*zda)(const struct minmea_sentence_zda *frame);
+} gps_lld_cbk_t;
+
+extern struct minmea_sentence_rmc gps_lld_rmc_last;
+extern uint32_t gps_lld_rmc_num;
+extern uint32_t gps_lld_sentence_num;
+extern uint32_t gps_lld_invalid_num;
+extern uint32_t gps_lld_unknown_num;
+extern uint32_t gps_lld_too_long_num;
+extern uint32_t gps_lld_overrun_num;
+
+void gps_lld_display_msg_type(enum minmea_sentence_id type);
+void gps_lld_set_cbk(const gps_lld_cbk_t *cbk);
+void gps_lld_step(void);
+
+#endif
@@ -0,0 +1,498 @@
+/* Host replay benchmark of the NMEA framing of gps_lld.c on the RX ring of
+ * lpuart_lld.c. Both are built as they are, a mock DMA channel writes the
+ * log into the 32 byte chunks of the ring and calls the RX_FULL callback,
+ * gps_lld_step() runs after every step bytes, 58 bytes are 5 ms at 115200
+ * baud.
+ *
+ * Without -f a log of a 10 Hz receiver is generated: RMC, GGA, 2x GSA,
+ * 11 GSV and VTG per epoch, 0.2% of the sentences with a broken checksum,
+ * one hour by default, about 38 MB. For this log the counters of gps_lld
+ * are checked against what was generated: every sentence framed and
+ * classified, no overrun, and the last RMC fix is the one of the last
+ * epoch. A step longer than the ring must be counted as overrun. -w
+ * writes the log to a file, e.g. for nmea_index of S32K144_047. Exit
+ * status 1 on a failed check.
+ *
+ * build: gcc -O2 -Wall -I.. -I../../S32K144_040_printf_deferred_binary_log
+ *            -I../../S32K144_057_CAN_socketcan/host -I../../S32K144_028_CAN_Transmit/Sources/minmea
+ *            -o gps_replay gps_replay.c ../gps_lld.c ../lpuart_lld.c
+ *            ../../S32K144_028_CAN_Transmit/Sources/minmea/minmea.c
+ * usage: gps_replay [-f log] [-w log] [-e epochs] [-s step bytes] [-a]
+ *        -a sets all handlers, so every sentence is parsed, not only RMC
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "gps_lld.h"
+/* the output of the benchmark goes to stdout, not to the printf of the board */
+#undef printf
+#undef snprintf
+
+#define REPLAY_SENTENCE_SIZE 128U
+
+static uint8_t *replay_dst;
+static uint8_t *replay_next_dst;
+static uint32_t replay_size;
+static uint32_t replay_next_size;
+static uint32_t replay_filled;
+static bool replay_busy = false;
+static uart_callback_t replay_rx_cbk = NULL;
+
+static uint32_t replay_gga_num;
+static uint32_t replay_gsa_num;
+static uint32_t replay_gsv_num;
+static uint32_t replay_vtg_num;
+
+static uint64_t replay_seed = 88172645463325252ULL;
+static uint32_t test_error = 0U;
+static uint32_t test_check_num = 0U;
+
+#define TEST_CHECK(cond, ...) do { test_check_num++; if (!(cond)) { printf("FAIL: " __VA_ARGS__); printf("\n"); test_error++; } } while (0)
+
+/* what the generated log holds */
+typedef struct
+{
+    char *data;
+    size_t len;
+    size_t size;
+    uint32_t valid;
+    uint32_t broken;
+    uint32_t rmc;
+    uint32_t gga;
+    uint32_t gsa;
+    uint32_t gsv;
+    uint32_t vtg;
+    int last_hours;
+    int last_minutes;
+    int last_seconds;
+} replay_log_t;
+
+lpuart_state_t lpuart1_State;
+const lpuart_user_config_t lpuart1_InitConfig0 = {115200U};
+static S32_SCB_Type replay_scb;
+S32_SCB_Type *const S32_SCB = &replay_scb;
+
+/* LPUART driver, only the RX DMA does something */
+
+status_t LPUART_DRV_ReceiveData(uint32_t instance, uint8_t *rxBuff, uint32_t rxSize)
+{
+    (void)instance;
+    replay_dst = rxBuff;
+    replay_size = rxSize;
+    replay_filled = 0U;
+    replay_busy = true;
+    return STATUS_SUCCESS;
+}
+
+status_t LPUART_DRV_SetRxBuffer(uint32_t instance, uint8_t *rxBuff, uint32_t rxSize)
+{
+    (void)instance;
+    replay_next_dst = rxBuff;
+    replay_next_size = rxSize;
+    return STATUS_SUCCESS;
+}
+
+status_t LPUART_DRV_GetReceiveStatus(uint32_t instance, uint32_t *bytesRemaining)
+{
+    (void)instance;
+    *bytesRemaining = replay_busy ? (replay_size - replay_filled) : 0U;
+    return replay_busy ? STATUS_BUSY : STATUS_SUCCESS;
+}
+
+uart_callback_t LPUART_DRV_InstallRxCallback(uint32_t instance, uart_callback_t function, void *callbackParam)
+{
+    (void)instance;
+    (void)callbackParam;
+    replay_rx_cbk = function;
+    return NULL;
+}
+
+uart_callback_t LPUART_DRV_InstallTxCallback(uint32_t instance, uart_callback_t function, void *callbackParam)
+{
+    (void)instance;
+    (void)function;
+    (void)callbackParam;
+    return NULL;
+}
+
+status_t LPUART_DRV_Init(uint32_t instance, lpuart_state_t *lpuartStatePtr,
+                         const lpuart_user_config_t *lpuartUserConfig)
+{
+    (void)instance;
+    (void)lpuartStatePtr;
+    (void)lpuartUserConfig;
+    return STATUS_SUCCESS;
+}
+
+status_t LPUART_DRV_SendData(uint32_t instance, const uint8_t *txBuff, uint32_t txSize)
+{
+    (void)instance;
+    (void)txBuff;
+    (void)txSize;
+    return STATUS_SUCCESS;
+}
+
+status_t LPUART_DRV_SendDataBlocking(uint32_t instance, const uint8_t *txBuff, uint32_t txSize, uint32_t timeout)
+{
+    (void)instance;
+    (void)txBuff;
+    (void)txSize;
+    (void)timeout;
+    return STATUS_SUCCESS;
+}
+
+status_t LPUART_DRV_SetTxBuffer(uint32_t instance, const uint8_t *txBuff, uint32_t txSize)
+{
+    (void)instance;
+    (void)txBuff;
+    (void)txSize;
+    return STATUS_SUCCESS;
+}
+
+status_t LPUART_DRV_GetTransmitStatus(uint32_t instance, uint32_t *bytesRemaining)
+{
+    (void)instance;
+    *bytesRemaining = 0U;
+    return STATUS_SUCCESS;
+}
+
+status_t LPUART_DRV_ReceiveDataPolling(uint32_t instance, uint8_t *rxBuff, uint32_t rxSize)
+{
+    (void)instance;
+    (void)rxBuff;
+    (void)rxSize;
+    return STATUS_BUSY;
+}
+
+void INT_SYS_SetPriority(IRQn_Type irqNumber, uint8_t priority)
+{
+    (void)irqNumber;
+    (void)priority;
+}
+
+/* FreeRTOS and printf */
+
+BaseType_t xTaskGetSchedulerState(void)
+{
+    return taskSCHEDULER_RUNNING;
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return 0U;
+}
+
+TickType_t xTaskGetTickCountFromISR(void)
+{
+    return 0U;
+}
+
+void vTaskDelay(TickType_t xTicksToDelay)
+{
+    (void)xTicksToDelay;
+}
+
+void vTaskDelayUntil(TickType_t *pxPreviousWakeTime, TickType_t xTimeIncrement)
+{
+    (void)pxPreviousWakeTime;
+    (void)xTimeIncrement;
+}
+
+int printf_(const char *format, ...)
+{
+    (void)format;
+    return 0;
+}
+
+/* one byte through the DMA channel, the RX_FULL callback chains the next chunk */
+static void replay_dma_byte(uint8_t data)
+{
+    if (!replay_busy)
+    {
+        return;
+    }
+    replay_dst[replay_filled++] = data;
+    if (replay_filled == replay_size)
+    {
+        replay_next_size = 0U;
+        replay_rx_cbk(NULL, UART_EVENT_RX_FULL, NULL);
+        if (replay_next_size != 0U)
+        {
+            replay_dst = replay_next_dst;
+            replay_size = replay_next_size;
+            replay_filled = 0U;
+        }
+        else
+        {
+            replay_busy = false;
+        }
+    }
+}
+
+static void replay_rmc(const struct minmea_sentence_rmc *frame)
+{
+    gps_lld_rmc_last = *frame;
+    gps_lld_rmc_num++;
+}
+
+static void replay_gga(const struct minmea_sentence_gga *frame)
+{
+    (void)frame;
+    replay_gga_num++;
+}
+
+static void replay_gsa(const struct minmea_sentence_gsa *frame)
+{
+    (void)frame;
+    replay_gsa_num++;
+}
+
+static void replay_gsv(const struct minmea_sentence_gsv *frame)
+{
+    (void)frame;
+    replay_gsv_num++;
+}
+
+static void replay_vtg(const struct minmea_sentence_vtg *frame)
+{
+    (void)frame;
+    replay_vtg_num++;
+}
+
+static uint32_t replay_rand(uint32_t range)
+{
+    replay_seed ^= replay_seed << 13;
+    replay_seed ^= replay_seed >> 7;
+    replay_seed ^= replay_seed << 17;
+    return (uint32_t)(replay_seed % range);
+}
+
+/* $body*CS\r\n into the log, one in 500 with a broken checksum */
+static void replay_add(replay_log_t *log, const char *body, uint32_t *type_num)
+{
+    char sentence[REPLAY_SENTENCE_SIZE];
+    uint8_t cs = 0U;
+    size_t len;
+    size_t i;
+
+    for (i = 0U; body[i] != '\0'; i++)
+    {
+        cs ^= (uint8_t)body[i];
+    }
+    len = (size_t)snprintf(sentence, sizeof(sentence), "$%s*%02X\r\n", body, cs);
+    if (replay_rand(1000U) < 2U)
+    {
+        sentence[10] = (sentence[10] == 'X') ? 'Y' : 'X';
+        log->broken++;
+    }
+    else
+    {
+        log->valid++;
+        (*type_num)++;
+    }
+    if ((log->len + len) > log->size)
+    {
+        log->size = (log->size * 2U) + len;
+        log->data = realloc(log->data, log->size);
+    }
+    memcpy(&log->data[log->len], sentence, len);
+    log->len += len;
+}
+
+static void replay_generate(replay_log_t *log, uint32_t epochs)
+{
+    static const char *const talker[4] = {"GP", "GL", "GA", "BD"};
+    static const uint32_t gsv_num[4] = {3U, 3U, 2U, 3U};
+    char body[REPLAY_SENTENCE_SIZE];
+    char time_text[16];
+    uint32_t epoch;
+    uint32_t t;
+    uint32_t i;
+    uint32_t s;
+    int len;
+
+    memset(log, 0, sizeof(*log));
+    for (epoch = 0U; epoch < epochs; epoch++)
+    {
+        log->last_hours = (int)((epoch / 36000U) % 24U);
+        log->last_minutes = (int)((epoch / 600U) % 60U);
+        log->last_seconds = (int)((epoch / 10U) % 60U);
+        (void)snprintf(time_text, sizeof(time_text), "%02d%02d%02d.%02u0", log->last_hours, log->last_minutes,
+                       log->last_seconds, (epoch % 10U) * 10U);
+
+        (void)snprintf(body, sizeof(body), "GNRMC,%s,A,3150.%04u,N,11711.%04u,E,0.%02u,181.50,030119,,,A", time_text,
+                       replay_rand(10000U), replay_rand(10000U), replay_rand(100U));
+        replay_add(log, body, &log->rmc);
+        (void)snprintf(body, sizeof(body), "GNGGA,%s,3150.7827,N,11711.8695,E,1,12,0.9,35.2,M,-2.1,M,,", time_text);
+        replay_add(log, body, &log->gga);
+        replay_add(log, "GNGSA,A,3,01,02,03,04,05,06,07,08,09,10,11,12,1.5,0.9,1.2", &log->gsa);
+        replay_add(log, "GNGSA,A,3,65,66,67,68,,,,,,,,,1.5,0.9,1.2", &log->gsa);
+        for (t = 0U; t < 4U; t++)
+        {
+            for (i = 0U; i < gsv_num[t]; i++)
+            {
+                len = snprintf(body, sizeof(body), "%sGSV,%u,%u,%u", talker[t], gsv_num[t], i + 1U, gsv_num[t] * 4U);
+                for (s = 0U; s < 4U; s++)
+                {
+                    len += snprintf(&body[len], sizeof(body) - (size_t)len, ",%02u,%02u,%03u,%02u",
+                                    1U + replay_rand(32U), replay_rand(91U), replay_rand(360U), 10U + replay_rand(41U));
+                }
+                replay_add(log, body, &log->gsv);
+            }
+        }
+        replay_add(log, "GNVTG,181.50,T,,M,0.14,N,0.26,K,A", &log->vtg);
+    }
+}
+
+static bool replay_read(replay_log_t *log, const char *path)
+{
+    FILE *fp = fopen(path, "rb");
+    long len;
+
+    memset(log, 0, sizeof(*log));
+    if ((fp == NULL) || (fseek(fp, 0L, SEEK_END) != 0) || ((len = ftell(fp)) < 0L))
+    {
+        return false;
+    }
+    rewind(fp);
+    log->size = (size_t)len;
+    log->data = malloc(log->size + 1U);
+    log->len = fread(log->data, 1U, log->size, fp);
+    fclose(fp);
+    return log->len == log->size;
+}
+
+int main(int argc, char **argv)
+{
+    const char *read_path = NULL;
+    const char *write_path = NULL;
+    uint32_t epochs = 36000U;
+    uint32_t step = 58U;
+    bool all = false;
+    gps_lld_cbk_t cbk;
+    replay_log_t log;
+    struct timespec start;
+    struct timespec end;
+    double ns;
+    size_t i;
+    size_t j;
+    FILE *fp;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "f:w:e:s:a")) != -1)
+    {
+        switch (opt)
+        {
+        case 'f':
+            read_path = optarg;
+            break;
+        case 'w':
+            write_path = optarg;
+            break;
+        case 'e':
+            epochs = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            step = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'a':
+            all = true;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-f log] [-w log] [-e epochs] [-s step bytes] [-a]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (step == 0U)
+    {
+        step = 1U;
+    }
+
+    if (read_path != NULL)
+    {
+        if (!replay_read(&log, read_path))
+        {
+            perror(read_path);
+            return 1;
+        }
+    }
+    else
+    {
+        replay_generate(&log, epochs);
+    }
+    if (write_path != NULL)
+    {
+        fp = fopen(write_path, "wb");
+        if ((fp == NULL) || (fwrite(log.data, 1U, log.len, fp) != log.len) || (fclose(fp) != 0))
+        {
+            perror(write_path);
+            return 1;
+        }
+    }
+
+    memset(&cbk, 0, sizeof(cbk));
+    cbk.rmc = replay_rmc;
+    if (all)
+    {
+        cbk.gga = replay_gga;
+        cbk.gsa = replay_gsa;
+        cbk.gsv = replay_gsv;
+        cbk.vtg = replay_vtg;
+    }
+    lpuart_lld_init();
+    gps_lld_set_cbk(&cbk);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0U; i < log.len; i += step)
+    {
+        for (j = i; (j < (i + step)) && (j < log.len); j++)
+        {
+            replay_dma_byte((uint8_t)log.data[j]);
+        }
+        gps_lld_step();
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    ns = ((double)(end.tv_sec - start.tv_sec) * 1e9) + (double)(end.tv_nsec - start.tv_nsec);
+
+    printf("%zu bytes, %u bytes per step, handlers: %s\n", log.len, step, all ? "all" : "RMC");
+    printf("sentences %u, invalid %u, unknown %u, too long %u, overrun %u\n", gps_lld_sentence_num,
+           gps_lld_invalid_num, gps_lld_unknown_num, gps_lld_too_long_num, gps_lld_overrun_num);
+    printf("parsed: RMC %u, GGA %u, GSA %u, GSV %u, VTG %u, last fix %02d:%02d:%02d\n", gps_lld_rmc_num,
+           replay_gga_num, replay_gsa_num, replay_gsv_num, replay_vtg_num, gps_lld_rmc_last.time.hours,
+           gps_lld_rmc_last.time.minutes, gps_lld_rmc_last.time.seconds);
+    printf("%.2f ns per byte, %.2f us per sentence\n", ns / (double)log.len,
+           ns / (1000.0 * (double)(gps_lld_sentence_num + gps_lld_invalid_num)));
+
+    /* a step of more than half the ring may overrun while a sentence is
+     * still open, a step longer than the ring must overrun */
+    if ((read_path == NULL) && (step <= (LPUART_LLD_RX_BUF_SIZE / 2U)))
+    {
+        TEST_CHECK(gps_lld_sentence_num == log.valid, "%u sentences framed, %u generated", gps_lld_sentence_num,
+                   log.valid);
+        TEST_CHECK(gps_lld_invalid_num == log.broken, "%u invalid, %u broken", gps_lld_invalid_num, log.broken);
+        TEST_CHECK((gps_lld_unknown_num == 0U) && (gps_lld_too_long_num == 0U) && (gps_lld_overrun_num == 0U),
+                   "%u unknown, %u too long, %u overruns", gps_lld_unknown_num, gps_lld_too_long_num,
+                   gps_lld_overrun_num);
+        TEST_CHECK(gps_lld_rmc_num == log.rmc, "%u RMC parsed, %u generated", gps_lld_rmc_num, log.rmc);
+        TEST_CHECK((gps_lld_rmc_last.time.hours == log.last_hours) &&
+                   (gps_lld_rmc_last.time.minutes == log.last_minutes) &&
+                   (gps_lld_rmc_last.time.seconds == log.last_seconds), "last fix is not the last epoch");
+        if (all)
+        {
+            TEST_CHECK((replay_gga_num == log.gga) && (replay_gsa_num == log.gsa) && (replay_gsv_num == log.gsv) &&
+                       (replay_vtg_num == log.vtg), "GGA %u/%u, GSA %u/%u, GSV %u/%u, VTG %u/%u parsed",
+                       replay_gga_num, log.gga, replay_gsa_num, log.gsa, replay_gsv_num, log.gsv, replay_vtg_num,
+                       log.vtg);
+        }
+    }
+    else if ((read_path == NULL) && (step > LPUART_LLD_RX_BUF_SIZE))
+    {
+        TEST_CHECK(gps_lld_overrun_num != 0U, "no overrun with %u bytes per step", step);
+    }
+    free(log.data);
+    printf("%s, %u checks, %u errors\n", (test_error == 0U) ? "PASS" : "FAIL", test_check_num, test_error);
+    return (test_error == 0U) ? 0 : 1;
+}
@@ -0,0 +1,420 @@
+/* Host differential fuzz and benchmark of minmea_fast.c against minmea.c.
+ *
+ * Sentences of every type minmea knows, with and without checksum, are
+ * mutated at random: chars replaced, inserted and deleted, long digit runs,
+ * doubled commas, most of them then get a correct checksum again so the
+ * parsers see them. Both sides must return the same id, strict and not
+ * strict, the same parse result and the same frame, byte for byte.
+ *
+ * Then the sentences of one 10 Hz epoch (or the lines of -f, e.g. a log
+ * written by gps_replay -w of S32K144_044) are identified and parsed by
+ * both, and the ns per sentence are printed. Exit status 1 on a mismatch.
+ *
+ * The same file checks the minmea_fast.c of S32K144_046, build it with
+ * -I../../S32K144_046_NMEA_SWAR_scan and that minmea_fast.c.
+ *
+ * build: gcc -O2 -Wall -I.. -I../../S32K144_028_CAN_Transmit/Sources/minmea
+ *            -o minmea_fast_test minmea_fast_test.c ../minmea_fast.c
+ *            ../../S32K144_028_CAN_Transmit/Sources/minmea/minmea.c
+ * usage: minmea_fast_test [-n mutated sentences] [-r bench rounds] [-f log]
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "minmea.h"
+#include "minmea_fast.h"
+
+#define TEST_SENTENCE_SIZE 256U
+#define TEST_BENCH_MAX 200000U
+#define TEST_ID_NUM 10U
+
+/* the checksum of the ones ending in '*' is filled in */
+static const char *const test_template[] =
+{
+    "$GPRMC,081836,A,3751.65,S,14507.36,E,000.0,360.0,130998,011.3,E*62",
+    "$GNRMC,123519.123,A,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W*",
+    "$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47",
+    "$GPGGA,,,,,,0,00,99.99,,,,,,*48",
+    "$GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1*39",
+    "$GPGLL,3723.2475,N,12158.3416,W,161229.487,A,A*41",
+    "$GPGLL,3723.2475,N,12158.3416,W,161229.487,A*",
+    "$GPGST,024603.00,3.2,6.6,4.7,47.3,5.8,5.6,22.0*58",
+    "$GPGSV,3,1,11,03,03,111,00,04,15,270,00,06,01,010,00,13,06,292,00*74",
+    "$GPGSV,3,3,11,22,42,067,42,24,14,311,43,27,05,244,00,,,,*4D",
+    "$GPGSV,4,4,13*7B",
+    "$GPVTG,054.7,T,034.4,M,005.5,N,010.2,K*48",
+    "$GPVTG,188.36,T,,M,0.820,N,1.519,K,A*3F",
+    "$GPZDA,201530.00,04,07,2002,00,00*60",
+    "$GPXYZ,1,2,3*"
+};
+#define TEST_TEMPLATE_NUM (sizeof(test_template) / sizeof(test_template[0]))
+
+/* the chars a receiver sends, a quarter of the mutations take any byte */
+static const char test_alphabet[] = ",*.-+ 0123456789NSEWAMKTV\r\n$xaf";
+
+/* one epoch of a multi constellation receiver */
+static const char *const test_epoch[] =
+{
+    "$GNRMC,000000.000,A,3150.7827,N,11711.8695,E,0.14,181.50,030119,,,A*",
+    "$GNGGA,000000.000,3150.7827,N,11711.8695,E,1,12,0.9,35.2,M,-2.1,M,,*",
+    "$GNGSA,A,3,01,02,03,04,05,06,07,08,09,10,11,12,1.5,0.9,1.2*",
+    "$GNGSA,A,3,65,66,67,68,,,,,,,,,1.5,0.9,1.2*",
+    "$GPGSV,3,1,12,01,40,083,46,02,17,308,41,12,07,344,39,14,22,228,45*",
+    "$GPGSV,3,2,12,15,55,149,42,17,11,036,38,19,35,296,44,24,68,170,49*",
+    "$GPGSV,3,3,12,25,05,001,30,29,30,101,43,31,13,212,36,32,21,045,41*",
+    "$GLGSV,3,1,12,65,34,052,44,66,76,297,40,67,32,218,42,72,20,152,39*",
+    "$GLGSV,3,2,12,73,14,299,35,74,06,348,33,75,40,050,46,81,28,111,44*",
+    "$GLGSV,3,3,12,82,64,199,48,83,27,317,41,84,02,279,20,85,11,011,30*",
+    "$GAGSV,2,1,08,02,30,201,40,07,61,081,45,08,12,148,36,11,45,310,43*",
+    "$GAGSV,2,2,08,12,07,099,31,19,22,255,38,25,36,052,42,27,70,180,47*",
+    "$BDGSV,3,1,12,01,46,123,40,02,38,236,38,03,54,190,41,04,33,112,37*",
+    "$BDGSV,3,2,12,05,17,251,33,06,63,014,44,07,69,181,45,08,60,313,43*",
+    "$BDGSV,3,3,12,09,47,219,40,10,59,298,42,13,57,006,43,16,71,181,46*",
+    "$GNVTG,181.50,T,,M,0.14,N,0.26,K,A*"
+};
+#define TEST_EPOCH_NUM (sizeof(test_epoch) / sizeof(test_epoch[0]))
+
+typedef union
+{
+    struct minmea_sentence_rmc rmc;
+    struct minmea_sentence_gga gga;
+    struct minmea_sentence_gsa gsa;
+    struct minmea_sentence_gll gll;
+    struct minmea_sentence_gst gst;
+    struct minmea_sentence_gsv gsv;
+    struct minmea_sentence_vtg vtg;
+    struct minmea_sentence_zda zda;
+} test_frame_t;
+
+static uint64_t test_seed = 88172645463325252ULL;
+static uint32_t test_error = 0U;
+static uint32_t test_check_num = 0U;
+
+#define TEST_CHECK(cond, ...) do { test_check_num++; if (!(cond)) { printf("FAIL: " __VA_ARGS__); printf("\n"); test_error++; } } while (0)
+
+static uint32_t test_rand(uint32_t range)
+{
+    test_seed ^= test_seed << 13;
+    test_seed ^= test_seed >> 7;
+    test_seed ^= test_seed << 17;
+    return (uint32_t)(test_seed % range);
+}
+
+static uint64_t test_ns(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return ((uint64_t)t.tv_sec * 1000000000ULL) + (uint64_t)t.tv_nsec;
+}
+
+/* the checksum after '*', if there is room for it */
+static void test_fix_checksum(char *s)
+{
+    char *star = strchr(s, '*');
+    char text[4];
+
+    if ((star != NULL) && ((star - s) < 200))
+    {
+        (void)snprintf(text, sizeof(text), "%02X", minmea_checksum(s));
+        star[1] = text[0];
+        star[2] = text[1];
+        star[3] = '\0';
+    }
+}
+
+static void test_mutate(char *s)
+{
+    uint32_t num = test_rand(6U);
+    uint32_t len;
+    uint32_t at;
+    uint32_t run;
+    uint32_t i;
+    char *comma;
+    char c;
+
+    for (i = 0U; i < num; i++)
+    {
+        len = (uint32_t)strlen(s);
+        at = (len != 0U) ? test_rand(len) : 0U;
+        c = (test_rand(4U) != 0U) ? test_alphabet[test_rand(sizeof(test_alphabet) - 1U)] : (char)test_rand(256U);
+        switch (test_rand(5U))
+        {
+        case 0U:
+            if (len != 0U)
+            {
+                s[at] = c;
+            }
+            break;
+        case 1U:
+            if (len < 110U)
+            {
+                memmove(&s[at + 1U], &s[at], (len - at) + 1U);
+                s[at] = c;
+            }
+            break;
+        case 2U:
+            if (len != 0U)
+            {
+                memmove(&s[at], &s[at + 1U], len - at);
+            }
+            break;
+        case 3U:
+            /* a long digit run, for the overflow corners of the number parsers */
+            if (len < 90U)
+            {
+                run = test_rand(14U);
+                memmove(&s[at + run], &s[at], (len - at) + 1U);
+                for (len = 0U; len < run; len++)
+                {
+                    s[at + len] = ((len == 0U) && (test_rand(3U) == 0U)) ? '.' : (char)('0' + test_rand(10U));
+                }
+            }
+            break;
+        default:
+            comma = strchr(&s[at], ',');
+            if ((comma != NULL) && (len < 110U))
+            {
+                memmove(&comma[1], comma, strlen(comma) + 1U);
+            }
+            break;
+        }
+    }
+}
+
+/* both parsers from a frame filled with the same garbage, the frames must
+ * match byte for byte */
+#define TEST_PARSE(type) do \
+    { \
+        memset(&frame_a, 0x5A, sizeof(frame_a)); \
+        memset(&frame_b, 0x5A, sizeof(frame_b)); \
+        ok_a = minmea_parse_##type(&frame_a.type, s); \
+        ok_b = minmea_fast_parse_##type(&frame_b.type, &tok); \
+        TEST_CHECK((ok_a == ok_b) && (!ok_a || (memcmp(&frame_a.type, &frame_b.type, sizeof(frame_a.type)) == 0)), \
+                   #type " %d %d [%s]", ok_a, ok_b, s); \
+        parsed += ok_a ? 1U : 0U; \
+    } while (0)
+
+static void test_fuzz(uint32_t num)
+{
+    char s[TEST_SENTENCE_SIZE];
+    struct minmea_fast_tokens tok;
+    test_frame_t frame_a;
+    test_frame_t frame_b;
+    enum minmea_sentence_id id_a;
+    enum minmea_sentence_id id_b;
+    uint32_t ids[TEST_ID_NUM] = {0U};
+    uint32_t parsed = 0U;
+    uint32_t error = test_error;
+    uint32_t strict;
+    uint32_t n;
+    bool ok_a;
+    bool ok_b;
+
+    for (n = 0U; (n < num) && ((test_error - error) < 20U); n++)
+    {
+        (void)snprintf(s, sizeof(s), "%s", test_template[test_rand(TEST_TEMPLATE_NUM)]);
+        test_mutate(s);
+        if (test_rand(8U) != 0U)
+        {
+            test_fix_checksum(s);
+        }
+        if (test_rand(2U) != 0U)
+        {
+            strcat(s, (test_rand(2U) != 0U) ? "\r\n" : "\n");
+        }
+        for (strict = 0U; strict < 2U; strict++)
+        {
+            id_a = minmea_sentence_id(s, strict != 0U);
+            id_b = minmea_fast_sentence_id(&tok, s, strict != 0U);
+            TEST_CHECK(id_a == id_b, "id %d %d [%s]", id_a, id_b, s);
+            if (id_a != id_b)
+            {
+                continue;
+            }
+            ids[id_a + 1]++;
+            switch (id_a)
+            {
+            case MINMEA_SENTENCE_RMC:
+                TEST_PARSE(rmc);
+                break;
+            case MINMEA_SENTENCE_GGA:
+                TEST_PARSE(gga);
+                break;
+            case MINMEA_SENTENCE_GSA:
+                TEST_PARSE(gsa);
+                break;
+            case MINMEA_SENTENCE_GLL:
+                TEST_PARSE(gll);
+                break;
+            case MINMEA_SENTENCE_GST:
+                TEST_PARSE(gst);
+                break;
+            case MINMEA_SENTENCE_GSV:
+                TEST_PARSE(gsv);
+                break;
+            case MINMEA_SENTENCE_VTG:
+                TEST_PARSE(vtg);
+                break;
+            case MINMEA_SENTENCE_ZDA:
+                TEST_PARSE(zda);
+                break;
+            default:
+                break;
+            }
+        }
+    }
+    printf("%u mutated sentences, strict and not: %u invalid, %u unknown, %u parsed by both, %u mismatches\n", n,
+           ids[0], ids[1], parsed, test_error - error);
+}
+
+/* sentence id and parse, as gps_lld does it */
+static bool test_parse_minmea(const char *s, test_frame_t *frame)
+{
+    switch (minmea_sentence_id(s, false))
+    {
+    case MINMEA_SENTENCE_RMC:
+        return minmea_parse_rmc(&frame->rmc, s);
+    case MINMEA_SENTENCE_GGA:
+        return minmea_parse_gga(&frame->gga, s);
+    case MINMEA_SENTENCE_GSA:
+        return minmea_parse_gsa(&frame->gsa, s);
+    case MINMEA_SENTENCE_GLL:
+        return minmea_parse_gll(&frame->gll, s);
+    case MINMEA_SENTENCE_GST:
+        return minmea_parse_gst(&frame->gst, s);
+    case MINMEA_SENTENCE_GSV:
+        return minmea_parse_gsv(&frame->gsv, s);
+    case MINMEA_SENTENCE_VTG:
+        return minmea_parse_vtg(&frame->vtg, s);
+    case MINMEA_SENTENCE_ZDA:
+        return minmea_parse_zda(&frame->zda, s);
+    default:
+        return false;
+    }
+}
+
+static bool test_parse_fast(const char *s, test_frame_t *frame)
+{
+    struct minmea_fast_tokens tok;
+
+    switch (minmea_fast_sentence_id(&tok, s, false))
+    {
+    case MINMEA_SENTENCE_RMC:
+        return minmea_fast_parse_rmc(&frame->rmc, &tok);
+    case MINMEA_SENTENCE_GGA:
+        return minmea_fast_parse_gga(&frame->gga, &tok);
+    case MINMEA_SENTENCE_GSA:
+        return minmea_fast_parse_gsa(&frame->gsa, &tok);
+    case MINMEA_SENTENCE_GLL:
+        return minmea_fast_parse_gll(&frame->gll, &tok);
+    case MINMEA_SENTENCE_GST:
+        return minmea_fast_parse_gst(&frame->gst, &tok);
+    case MINMEA_SENTENCE_GSV:
+        return minmea_fast_parse_gsv(&frame->gsv, &tok);
+    case MINMEA_SENTENCE_VTG:
+        return minmea_fast_parse_vtg(&frame->vtg, &tok);
+    case MINMEA_SENTENCE_ZDA:
+        return minmea_fast_parse_zda(&frame->zda, &tok);
+    default:
+        return false;
+    }
+}
+
+static void test_bench(const char *path, uint32_t rounds)
+{
+    static char lines[TEST_BENCH_MAX][TEST_SENTENCE_SIZE / 2U];
+    char line[TEST_SENTENCE_SIZE];
+    const char *dollar;
+    test_frame_t frame;
+    uint32_t num = 0U;
+    uint32_t parsed[2];
+    uint64_t ns[2];
+    uint64_t start;
+    uint32_t mode;
+    uint32_t r;
+    uint32_t i;
+    FILE *fp;
+
+    if (path != NULL)
+    {
+        fp = fopen(path, "r");
+        if (fp == NULL)
+        {
+            perror(path);
+            exit(1);
+        }
+        while ((num < TEST_BENCH_MAX) && (fgets(line, sizeof(line), fp) != NULL))
+        {
+            dollar = strchr(line, '$');
+            if ((dollar != NULL) && (strlen(dollar) < sizeof(lines[0])))
+            {
+                strcpy(lines[num++], dollar);
+            }
+        }
+        fclose(fp);
+    }
+    else
+    {
+        for (num = 0U; num < TEST_EPOCH_NUM; num++)
+        {
+            (void)snprintf(lines[num], sizeof(lines[0]), "%s", test_epoch[num]);
+            test_fix_checksum(lines[num]);
+            strcat(lines[num], "\r\n");
+        }
+        rounds *= TEST_BENCH_MAX / TEST_EPOCH_NUM;
+    }
+
+    for (mode = 0U; mode < 2U; mode++)
+    {
+        parsed[mode] = 0U;
+        start = test_ns();
+        for (r = 0U; r < rounds; r++)
+        {
+            for (i = 0U; i < num; i++)
+            {
+                parsed[mode] += ((mode == 0U) ? test_parse_minmea(lines[i], &frame) :
+                                 test_parse_fast(lines[i], &frame)) ? 1U : 0U;
+            }
+        }
+        ns[mode] = test_ns() - start;
+    }
+    printf("%u sentences x %u: minmea %.1f ns, minmea_fast %.1f ns per sentence\n", num, rounds,
+           (double)ns[0] / ((double)num * rounds), (double)ns[1] / ((double)num * rounds));
+    TEST_CHECK(parsed[0] == parsed[1], "%u sentences parsed by minmea, %u by minmea_fast", parsed[0], parsed[1]);
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = NULL;
+    uint32_t num = 1000000U;
+    uint32_t rounds = 10U;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:r:f:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            num = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'r':
+            rounds = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'f':
+            path = optarg;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-n mutated sentences] [-r bench rounds] [-f log]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    test_fuzz(num);
+    test_bench(path, rounds);
+    printf("%s, %u checks, %u errors\n", (test_error == 0U) ? "PASS" : "FAIL", test_check_num, test_error);
+    return (test_error == 0U) ? 0 : 1;
+}
@@ -0,0 +1,900 @@
+/*
+ * Single pass variant of the minmea sentence parsers, see minmea_fast.h.
+ *
+ * Every field parser here follows the matching minmea_scan() format type
+ * character by character, including its corner cases (leading spaces and
+ * truncated precision in 'f', strtol rules in 'i', trailing junk after 'T'
+ * and 'D'), so both parsers accept and reject the same sentences.
+ */
+
+#include "minmea_fast.h"
+
+#include "stdlib.h"
+#include "string.h"
+#include "limits.h"
+
+#if defined(__AVX2__) && !defined(MINMEA_FAST_DISABLE_SIMD)
+#include "immintrin.h"
+#elif defined(__SSE2__) && !defined(MINMEA_FAST_DISABLE_SIMD)
+#include "emmintrin.h"
+#endif
+
+#define minmea_fast_isdigit(c) ((unsigned char)((c) - '0') < 10U)
+
+// sentence type letters packed as in minmea_fast_type()
+#define MINMEA_FAST_TYPE(a, b, c) (((uint32_t)(a) << 16) | ((uint32_t)(b) << 8) | (uint32_t)(c))
+
+static inline int minmea_fast_hex2int(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    return -1;
+}
+
+static inline uint32_t minmea_fast_type(const char *type)
+{
+    return MINMEA_FAST_TYPE(type[0], type[1], type[2]);
+}
+
+/*
+ * Block scanning. The sentence is read one aligned block at a time, a block
+ * is a 32-bit word (SWAR) on the MCU and an SSE2/AVX2 register on the host.
+ * For every block a mask with one entry per byte tells where the "," and the
+ * end of the body are, and the checksum is folded over whole blocks.
+ *
+ * The loads are aligned so they never cross into the next page or memory
+ * region, but they may read up to one block past the terminating NUL. Bytes
+ * outside the sentence are masked out. Little endian is assumed, byte i of
+ * a block is the lowest entry i of its mask.
+ */
+#if defined(__AVX2__) && !defined(MINMEA_FAST_DISABLE_SIMD)
+
+typedef __m256i minmea_fast_block_t;
+#define MINMEA_FAST_BLOCK_SIZE 32U
+// one mask bit per byte
+#define MINMEA_FAST_MASK_SHIFT 0U
+
+static inline minmea_fast_block_t minmea_fast_load(const char *p)
+{
+    return _mm256_load_si256((const __m256i *)p);
+}
+
+static inline minmea_fast_block_t minmea_fast_loadu(const uint8_t *p)
+{
+    return _mm256_loadu_si256((const __m256i *)p);
+}
+
+static inline uint32_t minmea_fast_mask_eq(minmea_fast_block_t b, char c)
+{
+    return (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(b, _mm256_set1_epi8(c)));
+}
+
+static inline uint32_t minmea_fast_mask_nonprint(minmea_fast_block_t b)
+{
+    // bytes are signed here, 0x80..0xFF are below ' ' as well
+    __m256i low = _mm256_cmpgt_epi8(_mm256_set1_epi8(' '), b);
+    __m256i del = _mm256_cmpeq_epi8(b, _mm256_set1_epi8(0x7F));
+    return (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(low, del));
+}
+
+static inline minmea_fast_block_t minmea_fast_and(minmea_fast_block_t a, minmea_fast_block_t b)
+{
+    return _mm256_and_si256(a, b);
+}
+
+static inline minmea_fast_block_t minmea_fast_andnot(minmea_fast_block_t a, minmea_fast_block_t b)
+{
+    return _mm256_andnot_si256(a, b);
+}
+
+static inline minmea_fast_block_t minmea_fast_xor(minmea_fast_block_t a, minmea_fast_block_t b)
+{
+    return _mm256_xor_si256(a, b);
+}
+
+static inline minmea_fast_block_t minmea_fast_zero(void)
+{
+    return _mm256_setzero_si256();
+}
+
+static inline uint8_t minmea_fast_fold(minmea_fast_block_t b)
+{
+    __m128i x = _mm_xor_si128(_mm256_castsi256_si128(b), _mm256_extracti128_si256(b, 1));
+    x = _mm_xor_si128(x, _mm_srli_si128(x, 8));
+    x = _mm_xor_si128(x, _mm_srli_si128(x, 4));
+    x = _mm_xor_si128(x, _mm_srli_si128(x, 2));
+    x = _mm_xor_si128(x, _mm_srli_si128(x, 1));
+    return (uint8_t)_mm_cvtsi128_si32(x);
+}
+
+#elif defined(__SSE2__) && !defined(MINMEA_FAST_DISABLE_SIMD)
+
+typedef __m128i minmea_fast_block_t;
+#define MINMEA_FAST_BLOCK_SIZE 16U
+#define MINMEA_FAST_MASK_SHIFT 0U
+
+static inline minmea_fast_block_t minmea_fast_load(const char *p)
+{
+    return _mm_load_si128((const __m128i *)p);
+}
+
+static inline minmea_fast_block_t minmea_fast_loadu(const uint8_t *p)
+{
+    return _mm_loadu_si128((const __m128i *)p);
+}
+
+static inline uint32_t minmea_fast_mask_eq(minmea_fast_block_t b, char c)
+{
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(b, _mm_set1_epi8(c)));
+}
+
+static inline uint32_t minmea_fast_mask_nonprint(minmea_fast_block_t b)
+{
+    __m128i low = _mm_cmplt_epi8(b, _mm_set1_epi8(' '));
+    __m128i del = _mm_cmpeq_epi8(b, _mm_set1_epi8(0x7F));
+    return (uint32_t)_mm_movemask_epi8(_mm_or_si128(low, del));
+}
+
+static inline minmea_fast_block_t minmea_fast_and(minmea_fast_block_t a, minmea_fast_block_t b)
+{
+    return _mm_and_si128(a, b);
+}
+
+static inline minmea_fast_block_t minmea_fast_andnot(minmea_fast_block_t a, minmea_fast_block_t b)
+{
+    return _mm_andnot_si128(a, b);
+}
+
+static inline minmea_fast_block_t minmea_fast_xor(minmea_fast_block_t a, minmea_fast_block_t b)
+{
+    return _mm_xor_si128(a, b);
+}
+
+static inline minmea_fast_block_t minmea_fast_zero(void)
+{
+    return _mm_setzero_si128();
+}
+
+static inline uint8_t minmea_fast_fold(minmea_fast_block_t b)
+{
+    b = _mm_xor_si128(b, _mm_srli_si128(b, 8));
+    b = _mm_xor_si128(b, _mm_srli_si128(b, 4));
+    b = _mm_xor_si128(b, _mm_srli_si128(b, 2));
+    b = _mm_xor_si128(b, _mm_srli_si128(b, 1));
+    return (uint8_t)_mm_cvtsi128_si32(b);
+}
+
+#else
+
+typedef uint32_t minmea_fast_block_t;
+#define MINMEA_FAST_BLOCK_SIZE 4U
+// the mask keeps bit 7 of each byte
+#define MINMEA_FAST_MASK_SHIFT 3U
+
+#define MINMEA_FAST_BYTES(c) (0x01010101U * (uint8_t)(c))
+
+static inline minmea_fast_block_t minmea_fast_load(const char *p)
+{
+    return *(const uint32_t *)(const void *)p;
+}
+
+static inline minmea_fast_block_t minmea_fast_loadu(const uint8_t *p)
+{
+    uint32_t b;
+
+    memcpy(&b, p, sizeof(b));
+    return b;
+}
+
+#if defined(__ARM_FEATURE_SIMD32) && !defined(MINMEA_FAST_DISABLE_SIMD)
+// 0xFF in every byte where b + add carries out of the byte, UADD8 sets the
+// GE flags per byte and SEL turns them into a byte mask
+static inline uint32_t minmea_fast_carry(uint32_t b, uint32_t add)
+{
+    uint32_t r;
+
+    __asm__("uadd8 %0, %1, %2\n\t"
+            "sel %0, %3, %4"
+            : "=&r"(r)
+            : "r"(b), "r"(add), "r"(0xFFFFFFFFU), "r"(0U)
+            : "cc");
+    return r;
+}
+
+static inline uint32_t minmea_fast_mask_eq(minmea_fast_block_t b, char c)
+{
+    // only a zero byte does not carry when 0xFF is added
+    return ~minmea_fast_carry(b ^ MINMEA_FAST_BYTES(c), 0xFFFFFFFFU) & 0x80808080U;
+}
+
+static inline uint32_t minmea_fast_mask_nonprint(minmea_fast_block_t b)
+{
+    // carries for b >= 0x20 and for b >= 0x7F
+    return (~minmea_fast_carry(b, 0xE0E0E0E0U) | minmea_fast_carry(b, 0x81818181U)) & 0x80808080U;
+}
+#else
+static inline uint32_t minmea_fast_mask_eq(minmea_fast_block_t b, char c)
+{
+    // exact zero byte test, no borrow runs into the next byte
+    uint32_t x = b ^ MINMEA_FAST_BYTES(c);
+    return ~(((x & 0x7F7F7F7FU) + 0x7F7F7F7FU) | x | 0x7F7F7F7FU);
+}
+
+static inline uint32_t minmea_fast_mask_nonprint(minmea_fast_block_t b)
+{
+    // on the low 7 bits, +0x60 sets bit 7 for >= 0x20 and +0x01 for 0x7F
+    uint32_t low = b & 0x7F7F7F7FU;
+    return (b | ~(low + 0x60606060U) | (low + 0x01010101U)) & 0x80808080U;
+}
+#endif
+
+static inline minmea_fast_block_t minmea_fast_and(minmea_fast_block_t a, minmea_fast_block_t b)
+{
+    return a & b;
+}
+
+static inline minmea_fast_block_t minmea_fast_andnot(minmea_fast_block_t a, minmea_fast_block_t b)
+{
+    return ~a & b;
+}
+
+static inline minmea_fast_block_t minmea_fast_xor(minmea_fast_block_t a, minmea_fast_block_t b)
+{
+    return a ^ b;
+}
+
+static inline minmea_fast_block_t minmea_fast_zero(void)
+{
+    return 0U;
+}
+
+static inline uint8_t minmea_fast_fold(minmea_fast_block_t b)
+{
+    b ^= b >> 16;
+    b ^= b >> 8;
+    return (uint8_t)b;
+}
+
+#endif
+
+// 0xFF for the first block, 0x00 for the second one
+static const uint8_t minmea_fast_ones[2U * MINMEA_FAST_BLOCK_SIZE] = {
+    [0 ... MINMEA_FAST_BLOCK_SIZE - 1U] = 0xFFU,
+};
+
+// Bytes [from, to) of a block, the others are cleared.
+static inline minmea_fast_block_t minmea_fast_keep(minmea_fast_block_t b, uint32_t from, uint32_t to)
+{
+    b = minmea_fast_and(b, minmea_fast_loadu(&minmea_fast_ones[MINMEA_FAST_BLOCK_SIZE - to]));
+    return minmea_fast_andnot(minmea_fast_loadu(&minmea_fast_ones[MINMEA_FAST_BLOCK_SIZE - from]), b);
+}
+
+// Mask entries of bytes >= from.
+static inline uint32_t minmea_fast_mask_from(uint32_t from)
+{
+    return 0xFFFFFFFFU << (from << MINMEA_FAST_MASK_SHIFT);
+}
+
+// Mask entries of bytes < to, to is below the block size.
+static inline uint32_t minmea_fast_mask_below(uint32_t to)
+{
+    return (1U << (to << MINMEA_FAST_MASK_SHIFT)) - 1U;
+}
+
+static inline uint32_t minmea_fast_mask_index(uint32_t mask)
+{
+    return (uint32_t)__builtin_ctz(mask) >> MINMEA_FAST_MASK_SHIFT;
+}
+
+static inline const char *minmea_fast_align(const char *p)
+{
+    return (const char *)((uintptr_t)p & ~(uintptr_t)(MINMEA_FAST_BLOCK_SIZE - 1U));
+}
+
+uint8_t minmea_fast_checksum(const char *sentence)
+{
+    minmea_fast_block_t acc = minmea_fast_zero();
+    minmea_fast_block_t b;
+    const char *p;
+    uint32_t from;
+    uint32_t stop;
+
+    // Support senteces with or without the starting dollar sign.
+    if (*sentence == '$')
+        sentence++;
+
+    p = minmea_fast_align(sentence);
+    from = (uint32_t)(sentence - p);
+    for (;;)
+    {
+        // The checksum is an XOR of all bytes up to the "*" or the end.
+        b = minmea_fast_load(p);
+        stop = (minmea_fast_mask_eq(b, '\0') | minmea_fast_mask_eq(b, '*')) & minmea_fast_mask_from(from);
+        if (stop)
+        {
+            acc = minmea_fast_xor(acc, minmea_fast_keep(b, from, minmea_fast_mask_index(stop)));
+            break;
+        }
+        if (from)
+            b = minmea_fast_keep(b, from, MINMEA_FAST_BLOCK_SIZE);
+        acc = minmea_fast_xor(acc, b);
+        p += MINMEA_FAST_BLOCK_SIZE;
+        from = 0;
+    }
+
+    return minmea_fast_fold(acc);
+}
+
+enum minmea_sentence_id minmea_fast_sentence_id(struct minmea_fast_tokens *tok, const char *sentence, bool strict)
+{
+    minmea_fast_block_t acc = minmea_fast_zero();
+    minmea_fast_block_t b;
+    const char *p;
+    uint8_t checksum;
+    uint32_t pos;
+    uint32_t fields = 1;
+    uint32_t from;
+    uint32_t to;
+    uint32_t stop;
+    uint32_t comma;
+    char c;
+
+    // A valid sentence starts with "$".
+    if (sentence[0] != '$')
+        return MINMEA_INVALID;
+
+    tok->sentence = sentence;
+    tok->id = MINMEA_INVALID;
+    tok->start[0] = 0;
+
+    // Checksum and field split in the same walk, the body ends at the first
+    // "*" or non printable character.
+    p = minmea_fast_align(sentence + 1);
+    from = (uint32_t)(sentence + 1 - p);
+    for (;;)
+    {
+        b = minmea_fast_load(p);
+        stop = (minmea_fast_mask_nonprint(b) | minmea_fast_mask_eq(b, '*')) & minmea_fast_mask_from(from);
+        comma = minmea_fast_mask_eq(b, ',') & minmea_fast_mask_from(from);
+        to = MINMEA_FAST_BLOCK_SIZE;
+        if (stop)
+        {
+            to = minmea_fast_mask_index(stop);
+            comma &= minmea_fast_mask_below(to);
+        }
+        // only the first and the last block are partial
+        if (from || stop)
+            b = minmea_fast_keep(b, from, to);
+        acc = minmea_fast_xor(acc, b);
+        while (comma)
+        {
+            if (fields <= MINMEA_FAST_MAX_FIELDS)
+                tok->start[fields] = (uint8_t)((p - sentence) + minmea_fast_mask_index(comma) + 1);
+            fields++;
+            comma &= comma - 1;
+        }
+        if (stop)
+            break;
+        p += MINMEA_FAST_BLOCK_SIZE;
+        from = 0;
+        // Sequence length is limited.
+        if (p - sentence > MINMEA_MAX_LENGTH + 3)
+            return MINMEA_INVALID;
+    }
+    pos = (uint32_t)(p - sentence) + to;
+    c = sentence[pos];
+    checksum = minmea_fast_fold(acc);
+
+    if (fields <= MINMEA_FAST_MAX_FIELDS)
+    {
+        tok->start[fields] = (uint8_t)(pos + 1);
+        tok->num = (uint8_t)fields;
+    }
+    else
+    {
+        tok->num = MINMEA_FAST_MAX_FIELDS;
+    }
+
+    // If checksum is present...
+    if (c == '*')
+    {
+        int upper = minmea_fast_hex2int(sentence[pos + 1]);
+        if (upper == -1)
+            return MINMEA_INVALID;
+        int lower = minmea_fast_hex2int(sentence[pos + 2]);
+        if (lower == -1)
+            return MINMEA_INVALID;
+        if (checksum != (upper << 4 | lower))
+            return MINMEA_INVALID;
+        pos += 3;
+    }
+    else if (strict)
+    {
+        // Discard non-checksummed frames in strict mode.
+        return MINMEA_INVALID;
+    }
+
+    // The only stuff allowed at this point is a newline.
+    if (sentence[pos] == '\r' && sentence[pos + 1] == '\n')
+        pos += 2;
+    else if (sentence[pos] == '\n')
+        pos += 1;
+    if (sentence[pos] != '\0' || pos > MINMEA_MAX_LENGTH + 3)
+        return MINMEA_INVALID;
+
+    // Talker and type take five characters after the "$".
+    if (tok->start[1] < 7)
+        return MINMEA_INVALID;
+
+    switch (minmea_fast_type(sentence + 3))
+    {
+    case MINMEA_FAST_TYPE('R', 'M', 'C'):
+        tok->id = MINMEA_SENTENCE_RMC;
+        break;
+    case MINMEA_FAST_TYPE('G', 'G', 'A'):
+        tok->id = MINMEA_SENTENCE_GGA;
+        break;
+    case MINMEA_FAST_TYPE('G', 'S', 'A'):
+        tok->id = MINMEA_SENTENCE_GSA;
+        break;
+    case MINMEA_FAST_TYPE('G', 'L', 'L'):
+        tok->id = MINMEA_SENTENCE_GLL;
+        break;
+    case MINMEA_FAST_TYPE('G', 'S', 'T'):
+        tok->id = MINMEA_SENTENCE_GST;
+        break;
+    case MINMEA_FAST_TYPE('G', 'S', 'V'):
+        tok->id = MINMEA_SENTENCE_GSV;
+        break;
+    case MINMEA_FAST_TYPE('V', 'T', 'G'):
+        tok->id = MINMEA_SENTENCE_VTG;
+        break;
+    case MINMEA_FAST_TYPE('Z', 'D', 'A'):
+        tok->id = MINMEA_SENTENCE_ZDA;
+        break;
+    default:
+        tok->id = MINMEA_UNKNOWN;
+        break;
+    }
+
+    return tok->id;
+}
+
+// Field i as [*field, *end), missing optional fields come back empty.
+static inline void minmea_fast_field(const struct minmea_fast_tokens *tok, uint32_t i,
+                                     const char **field, const char **end)
+{
+    if (i < tok->num)
+    {
+        *field = tok->sentence + tok->start[i];
+        *end = tok->sentence + tok->start[i + 1] - 1;
+    }
+    else
+    {
+        *field = tok->sentence;
+        *end = tok->sentence;
+    }
+}
+
+// Single character field, minmea_scan() 'c'.
+static inline char minmea_fast_char(const struct minmea_fast_tokens *tok, uint32_t i)
+{
+    const char *field, *end;
+
+    minmea_fast_field(tok, i, &field, &end);
+    return (field < end) ? *field : '\0';
+}
+
+// Direction field, minmea_scan() 'd'.
+static inline bool minmea_fast_direction(int *direction, const struct minmea_fast_tokens *tok, uint32_t i)
+{
+    const char *field, *end;
+
+    minmea_fast_field(tok, i, &field, &end);
+    *direction = 0;
+    if (field < end)
+    {
+        switch (*field)
+        {
+        case 'N':
+        case 'E':
+            *direction = 1;
+            break;
+        case 'S':
+        case 'W':
+            *direction = -1;
+            break;
+        default:
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Fractional value, minmea_scan() 'f'.
+static bool minmea_fast_float(struct minmea_float *f, const struct minmea_fast_tokens *tok, uint32_t i)
+{
+    const char *field, *end;
+    int sign = 0;
+    int_least32_t value = -1;
+    // the original int_least32_t scale wraps the same way past 10 decimals
+    uint32_t scale = 0;
+    char c;
+
+    minmea_fast_field(tok, i, &field, &end);
+    for (; field < end; field++)
+    {
+        c = *field;
+        if (minmea_fast_isdigit(c))
+        {
+            int digit = c - '0';
+            if (value == -1)
+                value = 0;
+            // value > (INT_LEAST32_MAX - digit) / 10 without the division
+            if (value > INT_LEAST32_MAX / 10 ||
+                (value == INT_LEAST32_MAX / 10 && digit > INT_LEAST32_MAX % 10))
+            {
+                // truncate extra precision, an integer overflow is an error
+                if (scale)
+                    break;
+                return false;
+            }
+            value = (10 * value) + digit;
+            if (scale)
+                scale *= 10;
+        }
+        else if ((c == '+' || c == '-') && !sign && value == -1)
+        {
+            sign = (c == '+') ? 1 : -1;
+        }
+        else if (c == '.' && scale == 0)
+        {
+            scale = 1;
+        }
+        else if (c == ' ')
+        {
+            // Spaces are allowed at the start of the field only.
+            if (sign != 0 || value != -1 || scale != 0)
+                return false;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    if ((sign || scale) && value == -1)
+        return false;
+
+    if (value == -1)
+    {
+        // No digits were scanned.
+        value = 0;
+        scale = 0;
+    }
+    else if (scale == 0)
+    {
+        // No decimal point.
+        scale = 1;
+    }
+    if (sign)
+        value *= sign;
+
+    f->value = value;
+    f->scale = (int_least32_t)scale;
+    return true;
+}
+
+// Decimal value, minmea_scan() 'i' which is strtol() on the field.
+static bool minmea_fast_int(int *out, const struct minmea_fast_tokens *tok, uint32_t i)
+{
+    const char *field, *end, *p;
+    unsigned long value = 0;
+    unsigned long limit = LONG_MAX;
+    bool negative = false;
+    bool overflow = false;
+    bool digits = false;
+
+    minmea_fast_field(tok, i, &field, &end);
+    p = field;
+    // a field can only hold printable characters, the only space is ' '
+    while (p < end && *p == ' ')
+        p++;
+    if (p < end && (*p == '+' || *p == '-'))
+    {
+        negative = (*p == '-');
+        limit = (unsigned long)LONG_MAX + 1UL;
+        p++;
+    }
+    for (; p < end && minmea_fast_isdigit(*p); p++)
+    {
+        unsigned long digit = (unsigned long)(*p - '0');
+        digits = true;
+        if (value > (limit - digit) / 10)
+            overflow = true;
+        else
+            value = (10 * value) + digit;
+    }
+
+    *out = 0;
+    if (!digits)
+    {
+        // Nothing converted, strtol() leaves endptr at the field start.
+        return field == end;
+    }
+    if (p != end)
+        return false;
+
+    // strtol() saturates, the long is then narrowed to int
+    if (overflow)
+        *out = (int)(negative ? LONG_MIN : LONG_MAX);
+    else
+        *out = (int)(negative ? (long)(0UL - value) : (long)value);
+
+    return true;
+}
+
+// Time field, minmea_scan() 'T'.
+static bool minmea_fast_time(struct minmea_time *time_, const struct minmea_fast_tokens *tok, uint32_t i)
+{
+    const char *field, *end;
+    int h = -1, m = -1, s = -1, u = -1;
+
+    minmea_fast_field(tok, i, &field, &end);
+    if (field < end)
+    {
+        // Minimum required: integer time, the field end is not a digit.
+        for (int f = 0; f < 6; f++)
+            if (!minmea_fast_isdigit(field[f]))
+                return false;
+
+        h = (field[0] - '0') * 10 + (field[1] - '0');
+        m = (field[2] - '0') * 10 + (field[3] - '0');
+        s = (field[4] - '0') * 10 + (field[5] - '0');
+        field += 6;
+
+        // Extra: fractional time. Saved as microseconds.
+        if (*field++ == '.')
+        {
+            uint32_t value = 0;
+            uint32_t scale = 1000000LU;
+            while (minmea_fast_isdigit(*field) && scale > 1)
+            {
+                value = (value * 10) + (*field++ - '0');
+                scale /= 10;
+            }
+            u = value * scale;
+        }
+        else
+        {
+            u = 0;
+        }
+    }
+
+    time_->hours = h;
+    time_->minutes = m;
+    time_->seconds = s;
+    time_->microseconds = u;
+    return true;
+}
+
+// Date field, minmea_scan() 'D'.
+static bool minmea_fast_date(struct minmea_date *date, const struct minmea_fast_tokens *tok, uint32_t i)
+{
+    const char *field, *end;
+    int d = -1, m = -1, y = -1;
+
+    minmea_fast_field(tok, i, &field, &end);
+    if (field < end)
+    {
+        // Always six digits.
+        for (int f = 0; f < 6; f++)
+            if (!minmea_fast_isdigit(field[f]))
+                return false;
+
+        d = (field[0] - '0') * 10 + (field[1] - '0');
+        m = (field[2] - '0') * 10 + (field[3] - '0');
+        y = (field[4] - '0') * 10 + (field[5] - '0');
+    }
+
+    date->day = d;
+    date->month = m;
+    date->year = y;
+    return true;
+}
+
+bool minmea_fast_parse_rmc(struct minmea_sentence_rmc *frame, const struct minmea_fast_tokens *tok)
+{
+    // $GPRMC,081836,A,3751.65,S,14507.36,E,000.0,360.0,130998,011.3,E*62
+    int latitude_direction;
+    int longitude_direction;
+    int variation_direction;
+
+    if (tok->id != MINMEA_SENTENCE_RMC || tok->num < 12)
+        return false;
+    if (!minmea_fast_time(&frame->time, tok, 1) ||
+        !minmea_fast_float(&frame->latitude, tok, 3) ||
+        !minmea_fast_direction(&latitude_direction, tok, 4) ||
+        !minmea_fast_float(&frame->longitude, tok, 5) ||
+        !minmea_fast_direction(&longitude_direction, tok, 6) ||
+        !minmea_fast_float(&frame->speed, tok, 7) ||
+        !minmea_fast_float(&frame->course, tok, 8) ||
+        !minmea_fast_date(&frame->date, tok, 9) ||
+        !minmea_fast_float(&frame->variation, tok, 10) ||
+        !minmea_fast_direction(&variation_direction, tok, 11))
+        return false;
+
+    frame->valid = (minmea_fast_char(tok, 2) == 'A');
+    frame->latitude.value *= latitude_direction;
+    frame->longitude.value *= longitude_direction;
+    frame->variation.value *= variation_direction;
+
+    return true;
+}
+
+bool minmea_fast_parse_gga(struct minmea_sentence_gga *frame, const struct minmea_fast_tokens *tok)
+{
+    // $GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47
+    int latitude_direction;
+    int longitude_direction;
+
+    // the last field is skipped but must be there
+    if (tok->id != MINMEA_SENTENCE_GGA || tok->num < 15)
+        return false;
+    if (!minmea_fast_time(&frame->time, tok, 1) ||
+        !minmea_fast_float(&frame->latitude, tok, 2) ||
+        !minmea_fast_direction(&latitude_direction, tok, 3) ||
+        !minmea_fast_float(&frame->longitude, tok, 4) ||
+        !minmea_fast_direction(&longitude_direction, tok, 5) ||
+        !minmea_fast_int(&frame->fix_quality, tok, 6) ||
+        !minmea_fast_int(&frame->satellites_tracked, tok, 7) ||
+        !minmea_fast_float(&frame->hdop, tok, 8) ||
+        !minmea_fast_float(&frame->altitude, tok, 9) ||
+        !minmea_fast_float(&frame->height, tok, 11) ||
+        !minmea_fast_float(&frame->dgps_age, tok, 13))
+        return false;
+
+    frame->altitude_units = minmea_fast_char(tok, 10);
+    frame->height_units = minmea_fast_char(tok, 12);
+    frame->latitude.value *= latitude_direction;
+    frame->longitude.value *= longitude_direction;
+
+    return true;
+}
+
+bool minmea_fast_parse_gsa(struct minmea_sentence_gsa *frame, const struct minmea_fast_tokens *tok)
+{
+    // $GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1*39
+    if (tok->id != MINMEA_SENTENCE_GSA || tok->num < 18)
+        return false;
+
+    frame->mode = minmea_fast_char(tok, 1);
+    if (!minmea_fast_int(&frame->fix_type, tok, 2))
+        return false;
+    for (uint32_t i = 0; i < 12; i++)
+        if (!minmea_fast_int(&frame->sats[i], tok, 3 + i))
+            return false;
+    if (!minmea_fast_float(&frame->pdop, tok, 15) ||
+        !minmea_fast_float(&frame->hdop, tok, 16) ||
+        !minmea_fast_float(&frame->vdop, tok, 17))
+        return false;
+
+    return true;
+}
+
+bool minmea_fast_parse_gll(struct minmea_sentence_gll *frame, const struct minmea_fast_tokens *tok)
+{
+    // $GPGLL,3723.2475,N,12158.3416,W,161229.487,A,A*41$;
+    int latitude_direction;
+    int longitude_direction;
+
+    // the mode field is optional
+    if (tok->id != MINMEA_SENTENCE_GLL || tok->num < 7)
+        return false;
+    if (!minmea_fast_float(&frame->latitude, tok, 1) ||
+        !minmea_fast_direction(&latitude_direction, tok, 2) ||
+        !minmea_fast_float(&frame->longitude, tok, 3) ||
+        !minmea_fast_direction(&longitude_direction, tok, 4) ||
+        !minmea_fast_time(&frame->time, tok, 5))
+        return false;
+
+    frame->status = minmea_fast_char(tok, 6);
+    frame->mode = minmea_fast_char(tok, 7);
+    frame->latitude.value *= latitude_direction;
+    frame->longitude.value *= longitude_direction;
+
+    return true;
+}
+
+bool minmea_fast_parse_gst(struct minmea_sentence_gst *frame, const struct minmea_fast_tokens *tok)
+{
+    // $GPGST,024603.00,3.2,6.6,4.7,47.3,5.8,5.6,22.0*58
+    if (tok->id != MINMEA_SENTENCE_GST || tok->num < 9)
+        return false;
+    if (!minmea_fast_time(&frame->time, tok, 1) ||
+        !minmea_fast_float(&frame->rms_deviation, tok, 2) ||
+        !minmea_fast_float(&frame->semi_major_deviation, tok, 3) ||
+        !minmea_fast_float(&frame->semi_minor_deviation, tok, 4) ||
+        !minmea_fast_float(&frame->semi_major_orientation, tok, 5) ||
+        !minmea_fast_float(&frame->latitude_error_deviation, tok, 6) ||
+        !minmea_fast_float(&frame->longitude_error_deviation, tok, 7) ||
+        !minmea_fast_float(&frame->altitude_error_deviation, tok, 8))
+        return false;
+
+    return true;
+}
+
+bool minmea_fast_parse_gsv(struct minmea_sentence_gsv *frame, const struct minmea_fast_tokens *tok)
+{
+    // $GPGSV,3,1,11,03,03,111,00,04,15,270,00,06,01,010,00,13,06,292,00*74
+    // $GPGSV,4,4,13*7B
+    // the satellite fields are optional
+    if (tok->id != MINMEA_SENTENCE_GSV || tok->num < 4)
+        return false;
+    if (!minmea_fast_int(&frame->total_msgs, tok, 1) ||
+        !minmea_fast_int(&frame->msg_nr, tok, 2) ||
+        !minmea_fast_int(&frame->total_sats, tok, 3))
+        return false;
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        if (!minmea_fast_int(&frame->sats[i].nr, tok, 4 + 4 * i) ||
+            !minmea_fast_int(&frame->sats[i].elevation, tok, 5 + 4 * i) ||
+            !minmea_fast_int(&frame->sats[i].azimuth, tok, 6 + 4 * i) ||
+            !minmea_fast_int(&frame->sats[i].snr, tok, 7 + 4 * i))
+            return false;
+    }
+
+    return true;
+}
+
+bool minmea_fast_parse_vtg(struct minmea_sentence_vtg *frame, const struct minmea_fast_tokens *tok)
+{
+    // $GPVTG,054.7,T,034.4,M,005.5,N,010.2,K*48
+    // $GPVTG,188.36,T,,M,0.820,N,1.519,K,A*3F
+    // the FAA mode field is optional
+    if (tok->id != MINMEA_SENTENCE_VTG || tok->num < 9)
+        return false;
+    // check chars
+    if (minmea_fast_char(tok, 2) != 'T' ||
+        minmea_fast_char(tok, 4) != 'M' ||
+        minmea_fast_char(tok, 6) != 'N' ||
+        minmea_fast_char(tok, 8) != 'K')
+        return false;
+    if (!minmea_fast_float(&frame->true_track_degrees, tok, 1) ||
+        !minmea_fast_float(&frame->magnetic_track_degrees, tok, 3) ||
+        !minmea_fast_float(&frame->speed_knots, tok, 5) ||
+        !minmea_fast_float(&frame->speed_kph, tok, 7))
+        return false;
+    frame->faa_mode = (enum minmea_faa_mode)minmea_fast_char(tok, 9);
+
+    return true;
+}
+
+bool minmea_fast_parse_zda(struct minmea_sentence_zda *frame, const struct minmea_fast_tokens *tok)
+{
+    // $GPZDA,201530.00,04,07,2002,00,00*60
+    if (tok->id != MINMEA_SENTENCE_ZDA || tok->num < 7)
+        return false;
+    if (!minmea_fast_time(&frame->time, tok, 1) ||
+        !minmea_fast_int(&frame->date.day, tok, 2) ||
+        !minmea_fast_int(&frame->date.month, tok, 3) ||
+        !minmea_fast_int(&frame->date.year, tok, 4) ||
+        !minmea_fast_int(&frame->hour_offset, tok, 5) ||
+        !minmea_fast_int(&frame->minute_offset, tok, 6))
+        return false;
+
+    // check offsets
+    if (abs(frame->hour_offset) > 13 ||
+        frame->minute_offset > 59 ||
+        frame->minute_offset < 0)
+        return false;
+
+    return true;
+}
+
+/* vim: set ts=4 sw=4 et: */
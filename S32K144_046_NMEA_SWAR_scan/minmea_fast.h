@@ -0,0 +1,69 @@
+/*
+ * Single pass variant of the minmea sentence parsers.
+ *
+ * minmea_fast_sentence_id() checks the sentence, computes the checksum and
+ * splits it into fields in one walk over the characters. The parsers below
+ * then read the fields straight from that index, there is no format string,
+ * no va_arg and no strtol. The results are the same as the minmea_parse_*
+ * functions give for the same sentence.
+ *
+ * The checksum and the "," search go several bytes at a time: 32-bit SWAR
+ * words on the Cortex-M4 (UADD8/SEL when the DSP extension is there), SSE2
+ * or AVX2 registers on the host. Define MINMEA_FAST_DISABLE_SIMD to keep the
+ * portable SWAR code only.
+ */
+
+#ifndef MINMEA_FAST_H
+#define MINMEA_FAST_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "minmea.h"
+
+/* GSV has the most fields that are used, fields after this are ignored */
+#define MINMEA_FAST_MAX_FIELDS 20U
+
+    struct minmea_fast_tokens
+    {
+        const char *sentence;
+        enum minmea_sentence_id id;
+        // number of fields, at most MINMEA_FAST_MAX_FIELDS
+        uint8_t num;
+        // offset of each field, start[i + 1] - 1 is where field i ends
+        uint8_t start[MINMEA_FAST_MAX_FIELDS + 1U];
+    };
+
+    /**
+ * Same as minmea_checksum(), several bytes at a time.
+ */
+    uint8_t minmea_fast_checksum(const char *sentence);
+
+    /**
+ * Check the sentence like minmea_check() and split it into fields.
+ * Returns the same as minmea_sentence_id(), tok is valid unless
+ * MINMEA_INVALID is returned.
+ */
+    enum minmea_sentence_id minmea_fast_sentence_id(struct minmea_fast_tokens *tok, const char *sentence, bool strict);
+
+    /*
+ * Parse a sentence split by minmea_fast_sentence_id(). Return true on success.
+ */
+    bool minmea_fast_parse_rmc(struct minmea_sentence_rmc *frame, const struct minmea_fast_tokens *tok);
+    bool minmea_fast_parse_gga(struct minmea_sentence_gga *frame, const struct minmea_fast_tokens *tok);
+    bool minmea_fast_parse_gsa(struct minmea_sentence_gsa *frame, const struct minmea_fast_tokens *tok);
+    bool minmea_fast_parse_gll(struct minmea_sentence_gll *frame, const struct minmea_fast_tokens *tok);
+    bool minmea_fast_parse_gst(struct minmea_sentence_gst *frame, const struct minmea_fast_tokens *tok);
+    bool minmea_fast_parse_gsv(struct minmea_sentence_gsv *frame, const struct minmea_fast_tokens *tok);
+    bool minmea_fast_parse_vtg(struct minmea_sentence_vtg *frame, const struct minmea_fast_tokens *tok);
+    bool minmea_fast_parse_zda(struct minmea_sentence_zda *frame, const struct minmea_fast_tokens *tok);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MINMEA_FAST_H */
+
+/* vim: set ts=4 sw=4 et: */
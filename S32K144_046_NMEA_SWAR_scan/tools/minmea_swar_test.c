@@ -0,0 +1,308 @@
+/* Host test and benchmark of the block scan of minmea_fast.c.
+ *
+ * minmea_fast_checksum() and minmea_fast_sentence_id() must give exactly
+ * what minmea_checksum() and minmea_sentence_id() give, strict and not
+ * strict, for
+ *   - the sentences of a 10 Hz receiver, at every alignment
+ *   - random strings of up to 200 chars at random alignments, printable or
+ *     not, with '$', '*' and the NUL anywhere
+ * Then the checksum and the tokenizer are timed over a log, generated or
+ * read with -f (e.g. written by gps_replay -w of S32K144_044), and the
+ * MB/s are printed next to the byte loop of minmea_checksum().
+ *
+ * The block path is picked at build time like on the target: AVX2 with
+ * -mavx2, SSE2 by default on x86-64, the 32 bit SWAR code of the M4 with
+ * -DMINMEA_FAST_DISABLE_SIMD. The UADD8/SEL variant of the M4 needs the
+ * ARM DSP instructions and is not built here. The parsers on top are
+ * checked by minmea_fast_test of S32K144_045. Exit status 1 on a mismatch.
+ *
+ * build: gcc -O2 -Wall -I.. -I../../S32K144_028_CAN_Transmit/Sources/minmea
+ *            -o minmea_swar_test minmea_swar_test.c ../minmea_fast.c
+ *            ../../S32K144_028_CAN_Transmit/Sources/minmea/minmea.c
+ * usage: minmea_swar_test [-n random strings] [-e epochs] [-f log]
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "minmea.h"
+#include "minmea_fast.h"
+
+#define TEST_SENTENCE_SIZE 256U
+#define TEST_ALIGN_NUM 64U
+#define TEST_BENCH_ROUNDS 5U
+
+/* one epoch of a multi constellation receiver, the checksum is filled in */
+static const char *const test_epoch[] =
+{
+    "$GNRMC,%02u%02u%02u.%u00,A,3150.78%02u,N,11711.86%02u,E,0.14,181.50,030119,,,A*",
+    "$GNGGA,%02u%02u%02u.%u00,3150.78%02u,N,11711.86%02u,E,1,12,0.9,35.2,M,-2.1,M,,*",
+    "$GNGSA,A,3,01,02,03,04,05,06,07,08,09,10,11,12,1.5,0.9,1.2*",
+    "$GNGSA,A,3,65,66,67,68,,,,,,,,,1.5,0.9,1.2*",
+    "$GPGSV,3,1,12,01,40,083,46,02,17,308,41,12,07,344,39,14,22,228,45*",
+    "$GPGSV,3,2,12,15,55,149,42,17,11,036,38,19,35,296,44,24,68,170,49*",
+    "$GPGSV,3,3,12,25,05,001,30,29,30,101,43,31,13,212,36,32,21,045,41*",
+    "$GLGSV,3,1,12,65,34,052,44,66,76,297,40,67,32,218,42,72,20,152,39*",
+    "$GLGSV,3,2,12,73,14,299,35,74,06,348,33,75,40,050,46,81,28,111,44*",
+    "$GLGSV,3,3,12,82,64,199,48,83,27,317,41,84,02,279,20,85,11,011,30*",
+    "$GAGSV,2,1,08,02,30,201,40,07,61,081,45,08,12,148,36,11,45,310,43*",
+    "$GAGSV,2,2,08,12,07,099,31,19,22,255,38,25,36,052,42,27,70,180,47*",
+    "$BDGSV,3,1,12,01,46,123,40,02,38,236,38,03,54,190,41,04,33,112,37*",
+    "$BDGSV,3,2,12,05,17,251,33,06,63,014,44,07,69,181,45,08,60,313,43*",
+    "$BDGSV,3,3,12,09,47,219,40,10,59,298,42,13,57,006,43,16,71,181,46*",
+    "$GNVTG,181.50,T,,M,0.14,N,0.26,K,A*"
+};
+#define TEST_EPOCH_NUM (sizeof(test_epoch) / sizeof(test_epoch[0]))
+
+static uint64_t test_seed = 88172645463325252ULL;
+static uint32_t test_error = 0U;
+static uint32_t test_check_num = 0U;
+static volatile uint32_t test_sink;
+
+#define TEST_CHECK(cond, ...) do { test_check_num++; if (!(cond)) { printf("FAIL: " __VA_ARGS__); printf("\n"); test_error++; } } while (0)
+
+static uint32_t test_rand(uint32_t range)
+{
+    test_seed ^= test_seed << 13;
+    test_seed ^= test_seed >> 7;
+    test_seed ^= test_seed << 17;
+    return (uint32_t)(test_seed % range);
+}
+
+static uint64_t test_ns(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return ((uint64_t)t.tv_sec * 1000000000ULL) + (uint64_t)t.tv_nsec;
+}
+
+/* sentence n of the log, with its checksum and "\r\n" */
+static size_t test_sentence(char *s, size_t size, uint32_t n)
+{
+    const uint32_t epoch = n / TEST_EPOCH_NUM;
+    size_t len;
+
+    len = (size_t)snprintf(s, size, test_epoch[n % TEST_EPOCH_NUM], (epoch / 36000U) % 24U, (epoch / 600U) % 60U,
+                           (epoch / 10U) % 60U, epoch % 10U, test_rand(100U), test_rand(100U));
+    len += (size_t)snprintf(&s[len], size - len, "%02X\r\n", minmea_checksum(s));
+    return len;
+}
+
+static bool test_same(const char *s)
+{
+    struct minmea_fast_tokens tok;
+    const uint8_t cs = minmea_checksum(s);
+    const uint8_t cs_fast = minmea_fast_checksum(s);
+    uint32_t strict;
+
+    if (cs != cs_fast)
+    {
+        printf("checksum %02X, fast %02X [%s]\n", cs, cs_fast, s);
+        return false;
+    }
+    for (strict = 0U; strict < 2U; strict++)
+    {
+        if (minmea_sentence_id(s, strict != 0U) != minmea_fast_sentence_id(&tok, s, strict != 0U))
+        {
+            printf("id %d, fast %d, strict %u [%s]\n", minmea_sentence_id(s, strict != 0U),
+                   minmea_fast_sentence_id(&tok, s, strict != 0U), strict, s);
+            return false;
+        }
+    }
+    return true;
+}
+
+static void test_exact(uint32_t num)
+{
+    static char buf[TEST_ALIGN_NUM + TEST_SENTENCE_SIZE] __attribute__((aligned(64)));
+    char s[TEST_SENTENCE_SIZE];
+    uint32_t mismatch = 0U;
+    uint32_t checked = 0U;
+    uint32_t offset;
+    uint32_t len;
+    uint32_t n;
+    uint32_t i;
+    uint32_t r;
+
+    /* every sentence of one epoch at every alignment, also cut short */
+    for (n = 0U; n < TEST_EPOCH_NUM; n++)
+    {
+        len = (uint32_t)test_sentence(s, sizeof(s), n);
+        for (offset = 0U; offset < TEST_ALIGN_NUM; offset++)
+        {
+            for (i = 0U; i <= len; i++)
+            {
+                memcpy(&buf[offset], s, i);
+                buf[offset + i] = '\0';
+                mismatch += test_same(&buf[offset]) ? 0U : 1U;
+                checked++;
+            }
+        }
+    }
+    for (n = 0U; (n < num) && (mismatch < 20U); n++)
+    {
+        offset = test_rand(TEST_ALIGN_NUM);
+        len = test_rand(200U);
+        for (i = 0U; i < len; i++)
+        {
+            r = test_rand(1024U);
+            buf[offset + i] = (r < 768U) ? (char)(0x20U + (r % 95U)) : (char)(test_rand(255U) + 1U);
+        }
+        buf[offset + len] = '\0';
+        if (test_rand(2U) != 0U)
+        {
+            buf[offset] = '$';
+        }
+        if ((len > 4U) && (test_rand(2U) != 0U))
+        {
+            buf[offset + len - 3U - test_rand(2U)] = '*';
+        }
+        mismatch += test_same(&buf[offset]) ? 0U : 1U;
+        checked++;
+    }
+    printf("%u strings checked, %u mismatches\n", checked, mismatch);
+    TEST_CHECK(mismatch == 0U, "%u strings differ from minmea", mismatch);
+}
+
+static void test_bench(const char *path, uint32_t epochs)
+{
+    static const char *const name[3] = {"minmea_checksum", "minmea_fast_checksum", "minmea_fast_sentence_id"};
+    struct minmea_fast_tokens tok;
+    char **lines;
+    char *data;
+    char *p;
+    char *end;
+    size_t size;
+    size_t bytes = 0U;
+    uint32_t num = 0U;
+    uint32_t n;
+    uint32_t r;
+    uint32_t mode;
+    uint32_t x;
+    uint64_t start;
+    uint64_t ns;
+    FILE *fp;
+
+    if (path != NULL)
+    {
+        fp = fopen(path, "rb");
+        if ((fp == NULL) || (fseek(fp, 0L, SEEK_END) != 0))
+        {
+            perror(path);
+            exit(1);
+        }
+        size = (size_t)ftell(fp);
+        rewind(fp);
+        data = malloc(size + 64U);
+        size = fread(data, 1U, size, fp);
+        fclose(fp);
+    }
+    else
+    {
+        size = (size_t)epochs * TEST_EPOCH_NUM * 80U;
+        data = malloc(size + 64U);
+        for (n = 0U; n < (epochs * TEST_EPOCH_NUM); n++)
+        {
+            bytes += test_sentence(&data[bytes], size - bytes, n);
+        }
+        size = bytes;
+    }
+    data[size] = '\0';
+
+    /* one NUL terminated sentence per line, without "\r\n" */
+    lines = malloc(sizeof(char *) * ((size / 8U) + 1U));
+    bytes = 0U;
+    for (p = data; *p != '\0'; p = end + 1)
+    {
+        end = strchr(p, '\n');
+        if (end == NULL)
+        {
+            break;
+        }
+        *end = '\0';
+        if ((end > p) && (end[-1] == '\r'))
+        {
+            end[-1] = '\0';
+        }
+        if (*p == '$')
+        {
+            lines[num++] = p;
+            bytes += strlen(p);
+        }
+    }
+
+    for (mode = 0U; mode < 3U; mode++)
+    {
+        x = 0U;
+        start = test_ns();
+        for (r = 0U; r < TEST_BENCH_ROUNDS; r++)
+        {
+            for (n = 0U; n < num; n++)
+            {
+                if (mode == 0U)
+                {
+                    x += minmea_checksum(lines[n]);
+                }
+                else if (mode == 1U)
+                {
+                    x += minmea_fast_checksum(lines[n]);
+                }
+                else
+                {
+                    x += (uint32_t)minmea_fast_sentence_id(&tok, lines[n], false) + tok.num;
+                }
+            }
+        }
+        ns = test_ns() - start;
+        test_sink = x;
+        printf("%-24s %.1f MB, %u sentences: %7.1f MB/s, %5.1f ns per sentence\n", name[mode], (double)size / 1e6,
+               num, ((double)bytes * TEST_BENCH_ROUNDS * 1000.0) / (double)ns,
+               (double)ns / ((double)num * TEST_BENCH_ROUNDS));
+    }
+    free(lines);
+    free(data);
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = NULL;
+    uint32_t num = 5000000U;
+    uint32_t epochs = 36000U;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:e:f:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            num = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'e':
+            epochs = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'f':
+            path = optarg;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-n random strings] [-e epochs] [-f log]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    printf("block scan: %s\n",
+#if defined(MINMEA_FAST_DISABLE_SIMD) || !(defined(__AVX2__) || defined(__SSE2__))
+           "32 bit SWAR"
+#elif defined(__AVX2__)
+           "AVX2"
+#else
+           "SSE2"
+#endif
+           );
+    test_exact(num);
+    test_bench(path, epochs);
+    printf("%s, %u checks, %u errors\n", (test_error == 0U) ? "PASS" : "FAIL", test_check_num, test_error);
+    return (test_error == 0U) ? 0 : 1;
+}
@@ -0,0 +1,616 @@
+/* Host side indexer for NMEA recordings.
+ *
+ * The log is memory mapped and cut into one chunk per thread, every cut is
+ * moved to the next line start so no sentence is split. The threads check
+ * and parse their chunk with minmea_fast and keep the RMC fixes, the chunks
+ * are joined in file order at the end.
+ *
+ * The index file is columnar, all values little endian:
+ *   header, 64 bytes
+ *     0  "NMEAIDX1"
+ *     8  u32 version (1)
+ *     12 u32 records per time block (INDEX_BLOCK_SIZE)
+ *     16 u64 record count n
+ *     24 u64 time block count b
+ *     32 u64 size of the source log
+ *   i64 time_us[n]   UTC, microseconds since 1970
+ *   i32 lat[n]       degrees * 1e7, south negative
+ *   i32 lon[n]       degrees * 1e7, west negative
+ *   i32 speed[n]     knots * 1000, INDEX_UNKNOWN if empty
+ *   i32 course[n]    degrees * 100, INDEX_UNKNOWN if empty
+ *   u64 offset[n]    position of the sentence in the source log
+ *   i64 block[b][2]  min and max time_us of each block of records
+ * The block table is the seekable time index, a reader checks the blocks and
+ * only touches the records of the blocks that overlap the wanted time range.
+ *
+ * build: gcc -O2 -pthread -I../../S32K144_028_CAN_Transmit/Sources/minmea
+ *            -I../../S32K144_046_NMEA_SWAR_scan -o nmea_index nmea_index.c
+ *            ../../S32K144_028_CAN_Transmit/Sources/minmea/minmea.c
+ *            ../../S32K144_046_NMEA_SWAR_scan/minmea_fast.c
+ *        add -mavx2 or -msse2 for the vector checksum scan
+ * usage: nmea_index [-j threads] [-o index.bin] [-c fixes.csv] capture.nmea
+ *        nmea_index -q index.bin from_s to_s
+ *        the query prints the fixes between two UTC unix times as CSV
+ */
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "minmea.h"
+#include "minmea_fast.h"
+
+#define INDEX_MAGIC "NMEAIDX1"
+#define INDEX_VERSION 1U
+#define INDEX_HEADER_SIZE 64U
+#define INDEX_BLOCK_SIZE 1024U
+#define INDEX_UNKNOWN INT32_MIN
+#define INDEX_MAX_THREADS 256U
+
+/* minmea limit plus "\r\n", the same as on the target */
+#define SENTENCE_MAX_LEN (MINMEA_MAX_LENGTH + 3U)
+
+typedef struct
+{
+    int64_t time_us;
+    int32_t lat;
+    int32_t lon;
+    int32_t speed;
+    int32_t course;
+    uint64_t offset;
+} fix_t;
+
+typedef struct
+{
+    const char *base;
+    uint64_t begin;
+    uint64_t end;
+    fix_t *fix;
+    uint64_t fix_num;
+    uint64_t fix_cap;
+    uint64_t line_num;
+    uint64_t sentence_num;
+    uint64_t invalid_num;
+    uint64_t too_long_num;
+    uint64_t rmc_num;
+} chunk_t;
+
+static void put_le(uint8_t *p, uint64_t value, uint32_t size)
+{
+    while (size--)
+    {
+        *p++ = (uint8_t)value;
+        value >>= 8U;
+    }
+}
+
+static uint64_t get_le(const uint8_t *p, uint32_t size)
+{
+    uint64_t value = 0U;
+
+    while (size--)
+    {
+        value = (value << 8U) | p[size];
+    }
+    return value;
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* ddmm.mmmm as minmea gives it to degrees * 1e7, no float rounding */
+static int32_t coord_1e7(const struct minmea_float *f)
+{
+    int64_t unit = (int64_t)f->scale * 100;
+    int64_t degrees = f->value / unit;
+    int64_t minutes = f->value % unit;
+
+    return (int32_t)(degrees * 10000000 + minutes * 10000000 / (60 * (int64_t)f->scale));
+}
+
+static int32_t rescale_or_unknown(struct minmea_float *f, int32_t scale)
+{
+    if (f->scale == 0)
+    {
+        return INDEX_UNKNOWN;
+    }
+    return minmea_rescale(f, scale);
+}
+
+static bool chunk_add(chunk_t *chunk, const fix_t *fix)
+{
+    if (chunk->fix_num == chunk->fix_cap)
+    {
+        uint64_t cap = chunk->fix_cap ? chunk->fix_cap * 2U : 4096U;
+        fix_t *p = realloc(chunk->fix, cap * sizeof(fix_t));
+
+        if (p == NULL)
+        {
+            return false;
+        }
+        chunk->fix = p;
+        chunk->fix_cap = cap;
+    }
+    chunk->fix[chunk->fix_num++] = *fix;
+    return true;
+}
+
+static void chunk_sentence(chunk_t *chunk, const char *sentence, uint64_t offset)
+{
+    struct minmea_fast_tokens tok;
+    struct minmea_sentence_rmc rmc;
+    struct timespec ts;
+    fix_t fix;
+
+    switch (minmea_fast_sentence_id(&tok, sentence, false))
+    {
+    case MINMEA_INVALID:
+        chunk->invalid_num++;
+        return;
+    case MINMEA_SENTENCE_RMC:
+        chunk->sentence_num++;
+        break;
+    default:
+        chunk->sentence_num++;
+        return;
+    }
+
+    chunk->rmc_num++;
+    if (!minmea_fast_parse_rmc(&rmc, &tok) || !rmc.valid ||
+        (rmc.latitude.scale == 0) || (rmc.longitude.scale == 0) ||
+        (minmea_gettime(&ts, &rmc.date, &rmc.time) != 0))
+    {
+        return;
+    }
+
+    fix.time_us = (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+    fix.lat = coord_1e7(&rmc.latitude);
+    fix.lon = coord_1e7(&rmc.longitude);
+    fix.speed = rescale_or_unknown(&rmc.speed, 1000);
+    fix.course = rescale_or_unknown(&rmc.course, 100);
+    fix.offset = offset;
+    if (!chunk_add(chunk, &fix))
+    {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+}
+
+static void *chunk_thread(void *arg)
+{
+    chunk_t *chunk = arg;
+    /* aligned copy, minmea_fast reads whole vector blocks */
+    _Alignas(64) char sentence[SENTENCE_MAX_LEN + 64U];
+    const char *p = chunk->base + chunk->begin;
+    const char *end = chunk->base + chunk->end;
+    const char *line_end;
+    const char *dollar;
+    const char *nl;
+    size_t len;
+
+    while (p < end)
+    {
+        nl = memchr(p, '\n', (size_t)(end - p));
+        line_end = (nl != NULL) ? nl + 1 : end;
+        chunk->line_num++;
+
+        /* junk in front of the "$" is skipped like the framer on the target does */
+        dollar = memchr(p, '$', (size_t)(line_end - p));
+        if (dollar != NULL)
+        {
+            len = (size_t)(line_end - dollar);
+            if (len <= SENTENCE_MAX_LEN)
+            {
+                memcpy(sentence, dollar, len);
+                sentence[len] = '\0';
+                chunk_sentence(chunk, sentence, (uint64_t)(dollar - chunk->base));
+            }
+            else
+            {
+                chunk->too_long_num++;
+            }
+        }
+        p = line_end;
+    }
+
+    return NULL;
+}
+
+static bool write_index(const char *path, const chunk_t *chunk, uint32_t chunk_num, uint64_t fix_num, uint64_t log_size)
+{
+    uint64_t block_num = (fix_num + INDEX_BLOCK_SIZE - 1U) / INDEX_BLOCK_SIZE;
+    uint8_t header[INDEX_HEADER_SIZE] = {0};
+    int64_t (*block)[2] = calloc(block_num ? block_num : 1U, sizeof(*block));
+    FILE *fp = fopen(path, "wb");
+    uint32_t column;
+    uint32_t c;
+    uint64_t i;
+    uint64_t n;
+    uint8_t value[8];
+
+    if ((fp == NULL) || (block == NULL))
+    {
+        fprintf(stderr, "cannot write %s\n", path);
+        return false;
+    }
+
+    memcpy(header, INDEX_MAGIC, 8U);
+    put_le(&header[8], INDEX_VERSION, 4U);
+    put_le(&header[12], INDEX_BLOCK_SIZE, 4U);
+    put_le(&header[16], fix_num, 8U);
+    put_le(&header[24], block_num, 8U);
+    put_le(&header[32], log_size, 8U);
+    fwrite(header, 1U, sizeof(header), fp);
+
+    /* one pass over the records per column */
+    for (column = 0U; column < 6U; column++)
+    {
+        n = 0U;
+        for (c = 0U; c < chunk_num; c++)
+        {
+            for (i = 0U; i < chunk[c].fix_num; i++, n++)
+            {
+                const fix_t *fix = &chunk[c].fix[i];
+
+                switch (column)
+                {
+                case 0U:
+                    put_le(value, (uint64_t)fix->time_us, 8U);
+                    fwrite(value, 1U, 8U, fp);
+                    if ((n % INDEX_BLOCK_SIZE) == 0U)
+                    {
+                        block[n / INDEX_BLOCK_SIZE][0] = fix->time_us;
+                        block[n / INDEX_BLOCK_SIZE][1] = fix->time_us;
+                    }
+                    else if (fix->time_us < block[n / INDEX_BLOCK_SIZE][0])
+                    {
+                        block[n / INDEX_BLOCK_SIZE][0] = fix->time_us;
+                    }
+                    else if (fix->time_us > block[n / INDEX_BLOCK_SIZE][1])
+                    {
+                        block[n / INDEX_BLOCK_SIZE][1] = fix->time_us;
+                    }
+                    break;
+                case 1U:
+                    put_le(value, (uint32_t)fix->lat, 4U);
+                    fwrite(value, 1U, 4U, fp);
+                    break;
+                case 2U:
+                    put_le(value, (uint32_t)fix->lon, 4U);
+                    fwrite(value, 1U, 4U, fp);
+                    break;
+                case 3U:
+                    put_le(value, (uint32_t)fix->speed, 4U);
+                    fwrite(value, 1U, 4U, fp);
+                    break;
+                case 4U:
+                    put_le(value, (uint32_t)fix->course, 4U);
+                    fwrite(value, 1U, 4U, fp);
+                    break;
+                default:
+                    put_le(value, fix->offset, 8U);
+                    fwrite(value, 1U, 8U, fp);
+                    break;
+                }
+            }
+        }
+    }
+
+    for (i = 0U; i < block_num; i++)
+    {
+        put_le(value, (uint64_t)block[i][0], 8U);
+        fwrite(value, 1U, 8U, fp);
+        put_le(value, (uint64_t)block[i][1], 8U);
+        fwrite(value, 1U, 8U, fp);
+    }
+
+    free(block);
+    if ((fflush(fp) != 0) || (fclose(fp) != 0))
+    {
+        fprintf(stderr, "cannot write %s\n", path);
+        return false;
+    }
+    return true;
+}
+
+static void print_csv_header(FILE *fp)
+{
+    fprintf(fp, "time_us,lat,lon,speed_kn,course_deg,offset\n");
+}
+
+static void print_csv(FILE *fp, int64_t time_us, int32_t lat, int32_t lon, int32_t speed, int32_t course, uint64_t offset)
+{
+    fprintf(fp, "%lld,%.7f,%.7f,", (long long)time_us, lat * 1e-7, lon * 1e-7);
+    if (speed != INDEX_UNKNOWN)
+    {
+        fprintf(fp, "%.3f", speed * 1e-3);
+    }
+    fputc(',', fp);
+    if (course != INDEX_UNKNOWN)
+    {
+        fprintf(fp, "%.2f", course * 1e-2);
+    }
+    fprintf(fp, ",%llu\n", (unsigned long long)offset);
+}
+
+static bool write_csv(const char *path, const chunk_t *chunk, uint32_t chunk_num)
+{
+    FILE *fp = fopen(path, "w");
+    uint32_t c;
+    uint64_t i;
+
+    if (fp == NULL)
+    {
+        fprintf(stderr, "cannot write %s\n", path);
+        return false;
+    }
+
+    print_csv_header(fp);
+    for (c = 0U; c < chunk_num; c++)
+    {
+        for (i = 0U; i < chunk[c].fix_num; i++)
+        {
+            const fix_t *fix = &chunk[c].fix[i];
+
+            print_csv(fp, fix->time_us, fix->lat, fix->lon, fix->speed, fix->course, fix->offset);
+        }
+    }
+
+    if (fclose(fp) != 0)
+    {
+        fprintf(stderr, "cannot write %s\n", path);
+        return false;
+    }
+    return true;
+}
+
+static const uint8_t *map_file(const char *path, uint64_t *size)
+{
+    struct stat st;
+    void *p;
+    int fd = open(path, O_RDONLY);
+
+    if ((fd < 0) || (fstat(fd, &st) != 0))
+    {
+        fprintf(stderr, "cannot open %s\n", path);
+        return NULL;
+    }
+
+    *size = (uint64_t)st.st_size;
+    if (*size == 0U)
+    {
+        close(fd);
+        return (const uint8_t *)"";
+    }
+    p = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED)
+    {
+        fprintf(stderr, "cannot map %s\n", path);
+        return NULL;
+    }
+    (void)madvise(p, *size, MADV_SEQUENTIAL | MADV_WILLNEED);
+    return p;
+}
+
+static int query(const char *path, double from_s, double to_s)
+{
+    uint64_t size;
+    const uint8_t *p = map_file(path, &size);
+    uint64_t n;
+    uint64_t block_num;
+    uint64_t b;
+    uint64_t i;
+    uint64_t last;
+    int64_t from = (int64_t)(from_s * 1e6);
+    int64_t to = (int64_t)(to_s * 1e6);
+    const uint8_t *time_col;
+    const uint8_t *lat_col;
+    const uint8_t *lon_col;
+    const uint8_t *speed_col;
+    const uint8_t *course_col;
+    const uint8_t *offset_col;
+    const uint8_t *block_col;
+
+    if (p == NULL)
+    {
+        return 1;
+    }
+    if ((size < INDEX_HEADER_SIZE) || (memcmp(p, INDEX_MAGIC, 8U) != 0) ||
+        (get_le(&p[8], 4U) != INDEX_VERSION) || (get_le(&p[12], 4U) != INDEX_BLOCK_SIZE))
+    {
+        fprintf(stderr, "%s is not an index file\n", path);
+        return 1;
+    }
+    n = get_le(&p[16], 8U);
+    block_num = get_le(&p[24], 8U);
+    if (size != INDEX_HEADER_SIZE + n * 32U + block_num * 16U)
+    {
+        fprintf(stderr, "%s is truncated\n", path);
+        return 1;
+    }
+
+    time_col = p + INDEX_HEADER_SIZE;
+    lat_col = time_col + n * 8U;
+    lon_col = lat_col + n * 4U;
+    speed_col = lon_col + n * 4U;
+    course_col = speed_col + n * 4U;
+    offset_col = course_col + n * 4U;
+    block_col = offset_col + n * 8U;
+
+    print_csv_header(stdout);
+    for (b = 0U; b < block_num; b++)
+    {
+        /* the logs are not always sorted, so every block is checked */
+        if (((int64_t)get_le(&block_col[b * 16U], 8U) > to) ||
+            ((int64_t)get_le(&block_col[b * 16U + 8U], 8U) < from))
+        {
+            continue;
+        }
+        last = (b + 1U) * INDEX_BLOCK_SIZE;
+        if (last > n)
+        {
+            last = n;
+        }
+        for (i = b * INDEX_BLOCK_SIZE; i < last; i++)
+        {
+            int64_t t = (int64_t)get_le(&time_col[i * 8U], 8U);
+
+            if ((t >= from) && (t <= to))
+            {
+                print_csv(stdout, t,
+                          (int32_t)get_le(&lat_col[i * 4U], 4U),
+                          (int32_t)get_le(&lon_col[i * 4U], 4U),
+                          (int32_t)get_le(&speed_col[i * 4U], 4U),
+                          (int32_t)get_le(&course_col[i * 4U], 4U),
+                          get_le(&offset_col[i * 8U], 8U));
+            }
+        }
+    }
+    return 0;
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: nmea_index [-j threads] [-o index.bin] [-c fixes.csv] capture.nmea\n"
+                    "       nmea_index -q index.bin from_s to_s\n");
+}
+
+int main(int argc, char **argv)
+{
+    const char *index_path = NULL;
+    const char *csv_path = NULL;
+    const char *base;
+    uint64_t size;
+    uint32_t thread_num = (uint32_t)sysconf(_SC_NPROCESSORS_ONLN);
+    pthread_t thread[INDEX_MAX_THREADS];
+    chunk_t chunk[INDEX_MAX_THREADS];
+    chunk_t total = {0};
+    uint32_t t;
+    uint64_t cut;
+    const char *nl;
+    double start;
+    double elapsed;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "j:o:c:q:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'j':
+            thread_num = (uint32_t)strtoul(optarg, NULL, 10);
+            break;
+        case 'o':
+            index_path = optarg;
+            break;
+        case 'c':
+            csv_path = optarg;
+            break;
+        case 'q':
+            if ((argc - optind) != 2)
+            {
+                usage();
+                return 1;
+            }
+            return query(optarg, strtod(argv[optind], NULL), strtod(argv[optind + 1], NULL));
+        default:
+            usage();
+            return 1;
+        }
+    }
+    if ((argc - optind) != 1)
+    {
+        usage();
+        return 1;
+    }
+    if (thread_num == 0U)
+    {
+        thread_num = 1U;
+    }
+    if (thread_num > INDEX_MAX_THREADS)
+    {
+        thread_num = INDEX_MAX_THREADS;
+    }
+
+    start = now_s();
+    base = (const char *)map_file(argv[optind], &size);
+    if (base == NULL)
+    {
+        return 1;
+    }
+
+    /* cut the log in equal parts, each cut moved behind the next '\n' */
+    memset(chunk, 0, sizeof(chunk));
+    for (t = 0U; t < thread_num; t++)
+    {
+        chunk[t].base = base;
+        chunk[t].begin = (t == 0U) ? 0U : chunk[t - 1U].end;
+        cut = (t == thread_num - 1U) ? size : (size / thread_num) * (t + 1U);
+        if (cut < chunk[t].begin)
+        {
+            cut = chunk[t].begin;
+        }
+        if (cut < size)
+        {
+            nl = memchr(base + cut, '\n', size - cut);
+            cut = (nl != NULL) ? (uint64_t)(nl - base) + 1U : size;
+        }
+        chunk[t].end = cut;
+    }
+
+    for (t = 0U; t < thread_num; t++)
+    {
+        if (pthread_create(&thread[t], NULL, chunk_thread, &chunk[t]) != 0)
+        {
+            fprintf(stderr, "cannot start thread %u\n", t);
+            return 1;
+        }
+    }
+    for (t = 0U; t < thread_num; t++)
+    {
+        pthread_join(thread[t], NULL);
+        total.fix_num += chunk[t].fix_num;
+        total.line_num += chunk[t].line_num;
+        total.sentence_num += chunk[t].sentence_num;
+        total.invalid_num += chunk[t].invalid_num;
+        total.too_long_num += chunk[t].too_long_num;
+        total.rmc_num += chunk[t].rmc_num;
+    }
+    elapsed = now_s() - start;
+
+    fprintf(stderr, "%llu bytes, %llu lines, %llu sentences, %llu invalid, %llu too long, %llu RMC, %llu fixes\n",
+            (unsigned long long)size, (unsigned long long)total.line_num,
+            (unsigned long long)total.sentence_num, (unsigned long long)total.invalid_num,
+            (unsigned long long)total.too_long_num, (unsigned long long)total.rmc_num,
+            (unsigned long long)total.fix_num);
+    fprintf(stderr, "parsed in %.3f s with %u threads, %.1f MB/s\n",
+            elapsed, thread_num, (elapsed > 0.0) ? (double)size / elapsed / 1e6 : 0.0);
+
+    if ((index_path != NULL) && !write_index(index_path, chunk, thread_num, total.fix_num, size))
+    {
+        return 1;
+    }
+    if ((csv_path != NULL) && !write_csv(csv_path, chunk, thread_num))
+    {
+        return 1;
+    }
+
+    for (t = 0U; t < thread_num; t++)
+    {
+        free(chunk[t].fix);
+    }
+    return 0;
+}
@@ -0,0 +1,363 @@
+#include "can_lld.h"
+#include "string.h"
+#include "lpspiCom1.h"
+#include "sbc_uja116x1.h"
+#include "printf.h"
+
+status_t can_lld_debug_tx_ret_val;
+flexcan_data_info_t can_lld_rx_data_info;
+flexcan_msgbuff_t can_lld_rx_test_msg;
+flexcan_user_config_t can_lld_config_data_1;
+flexcan_user_config_t can_lld_config_data_0;
+static uint8_t can_tx_data[8];
+flexcan_id_table_t can_lld_fifo_filter_table[8];
+uint32_t can_lld_event_num;
+uint32_t can_lld_rx_complete_num;
+uint32_t can_lld_rx_fifo_compete_num;
+uint32_t can_lld_rx_fifo_warning_num;
+uint32_t can_lld_rx_fifo_overflow_num;
+uint32_t can_lld_tx_complete_num;
+uint32_t can_lld_wake_up_timeout_num;
+uint32_t can_lld_wake_up_match_num;
+uint32_t can_lld_self_wake_up_num;
+uint32_t can_lld_dma_complete_num;
+uint32_t can_lld_dma_error_num;
+uint32_t can_lld_error_num;
+uint32_t can_lld_default1_num;
+uint32_t can_lld_default2_num;
+uint32_t can_lld_error_value;
+uint32_t can_lld_rx_frame_num;
+uint32_t can_lld_rx_queue_overflow_num;
+uint32_t can_lld_rx_queue_peak;
+
+/* the driver copies every RX FIFO frame here before RXFIFO_COMPLETE */
+flexcan_msgbuff_t can_lld_rx_fifo_msg;
+
+#define CAN_LLD_RX_QUEUE_MASK (CAN_LLD_RX_QUEUE_SIZE - 1U)
+
+/* single producer single consumer ring, the CAN interrupt only moves the head
+ * and freertos_task_can_rx only moves the tail. The indexes are free running,
+ * a full ring drops the new frame and counts it */
+static can_lld_rx_frame_t can_lld_rx_queue[CAN_LLD_RX_QUEUE_SIZE];
+static volatile uint32_t can_lld_rx_queue_head = 0U;
+static volatile uint32_t can_lld_rx_queue_tail = 0U;
+/* consumer blocked in can_lld_rx_wait(), NULL if none */
+static TaskHandle_t volatile can_lld_rx_waiter = NULL;
+
+static void can_lld_rx_push(const flexcan_msgbuff_t *msg);
+static void can_lld_rx_process(const can_lld_rx_frame_t *frame);
+
+void can_lld_init(void)
+{
+    uint8_t i = 0U;
+
+    for (i = 0U; i < 8U; i++)
+    {
+        can_lld_fifo_filter_table[i].isRemoteFrame = false;
+        can_lld_fifo_filter_table[i].isExtendedFrame = false;
+        can_lld_fifo_filter_table[i].id = i + 1;
+    }
+
+    FLEXCAN_DRV_GetDefaultConfig(&can_lld_config_data_0);
+    LPSPI_DRV_MasterInit(LPSPICOM1, &lpspiCom1State, &lpspiCom1_MasterConfig0);
+    INT_SYS_SetPriority(LPSPI1_IRQn, configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY);
+    SBC_Init(&sbc_uja116x1_InitConfig0, LPSPICOM1);
+    FLEXCAN_DRV_Init(INST_CANCOM1, &canCom1_State, &canCom1_InitConfig0);
+    INT_SYS_SetPriority(CAN0_ORed_0_15_MB_IRQn, configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY);
+    /* Configure RX message buffer with index RX_MSG_ID and RX_MAILBOX */
+    can_lld_rx_data_info.msg_id_type = FLEXCAN_MSG_ID_STD;
+    can_lld_rx_data_info.fd_enable = 0;
+    can_lld_rx_data_info.is_remote = 0;
+    /* FLEXCAN_DRV_ConfigRxMb(INST_CANCOM1, 0, &can_lld_rx_data_info, RX_MSG_ID); */
+    FLEXCAN_DRV_ConfigRxFifo(INST_CANCOM1, FLEXCAN_RX_FIFO_ID_FORMAT_A, can_lld_fifo_filter_table);
+    FLEXCAN_DRV_SetRxFifoGlobalMask(INST_CANCOM1, FLEXCAN_RX_FIFO_ID_FORMAT_A, 0);
+    FLEXCAN_DRV_GetDefaultConfig(&can_lld_config_data_1);
+    FLEXCAN_DRV_InstallEventCallback(INST_CANCOM1, can_lld_cbk_func, NULL);
+    /* armed once here, the callback re-arms it for every frame */
+    (void)FLEXCAN_DRV_RxFifo(INST_CANCOM1, &can_lld_rx_fifo_msg);
+}
+
+/* @brief: Handle all frames waiting in the RX queue, never blocks
+ * @return: None
+ */
+void can_lld_fifo_rx_func(void)
+{
+    can_lld_rx_frame_t frame;
+
+    while (can_lld_rx_get(&frame))
+    {
+        can_lld_rx_process(&frame);
+    }
+}
+
+/* @brief: Take the oldest frame out of the RX queue, never blocks
+ * @param frame : destination of the frame
+ * @return      : true if a frame was taken
+ */
+bool can_lld_rx_get(can_lld_rx_frame_t *frame)
+{
+    uint32_t tail = can_lld_rx_queue_tail;
+
+    if (tail == __atomic_load_n(&can_lld_rx_queue_head, __ATOMIC_ACQUIRE))
+    {
+        return false;
+    }
+
+    *frame = can_lld_rx_queue[tail & CAN_LLD_RX_QUEUE_MASK];
+    /* the slot goes back to the interrupt only after it is copied */
+    __atomic_store_n(&can_lld_rx_queue_tail, tail + 1U, __ATOMIC_RELEASE);
+    return true;
+}
+
+/* @brief: Take the oldest frame out of the RX queue, wait for one if it is
+ *         empty. Only one task may consume the queue, its task notification
+ *         is used for the wake up
+ * @param frame   : destination of the frame
+ * @param timeout : ticks to wait, portMAX_DELAY for ever
+ * @return        : true if a frame was taken, false on timeout
+ */
+bool can_lld_rx_wait(can_lld_rx_frame_t *frame, TickType_t timeout)
+{
+    bool ret;
+
+    if (can_lld_rx_get(frame))
+    {
+        return true;
+    }
+
+    /* the handle must be visible before the queue is checked again, else a
+     * frame pushed in between would not wake us up */
+    __atomic_store_n(&can_lld_rx_waiter, xTaskGetCurrentTaskHandle(), __ATOMIC_SEQ_CST);
+    for (;;)
+    {
+        if (can_lld_rx_get(frame))
+        {
+            ret = true;
+            break;
+        }
+        /* a late notification for an already taken frame only costs a loop */
+        if (0U == ulTaskNotifyTake(pdTRUE, timeout))
+        {
+            ret = can_lld_rx_get(frame);
+            break;
+        }
+    }
+    __atomic_store_n(&can_lld_rx_waiter, NULL, __ATOMIC_RELEASE);
+
+    return ret;
+}
+
+/* @brief: Number of frames waiting in the RX queue
+ * @return: waiting frames
+ */
+uint32_t can_lld_rx_pending(void)
+{
+    return __atomic_load_n(&can_lld_rx_queue_head, __ATOMIC_ACQUIRE) -
+           __atomic_load_n(&can_lld_rx_queue_tail, __ATOMIC_ACQUIRE);
+}
+
+void freertos_task_can_rx(void *pvParameters)
+{
+    can_lld_rx_frame_t frame;
+
+    (void)pvParameters;
+
+    for (;;)
+    {
+        if (can_lld_rx_wait(&frame, portMAX_DELAY))
+        {
+            can_lld_rx_process(&frame);
+            can_lld_fifo_rx_func();
+        }
+    }
+}
+
+void can_lld_step(void)
+{
+    can_lld_tx(10, 0x77, can_tx_data, 8);
+    *(uint32_t *)can_tx_data += 1U;
+
+#if CAN_LLD_EVENT_COUNTER_DISPLAY_ENABLE
+    printf_defer("CAN event number: %d\n", can_lld_event_num);
+    printf_defer("can_lld_rx_complete_num: %d\n", can_lld_rx_complete_num);
+    printf_defer("can_lld_rx_fifo_compete_num: %d\n", can_lld_rx_fifo_compete_num);
+    printf_defer("can_lld_rx_fifo_warning_num: %d\n", can_lld_rx_fifo_warning_num);
+    printf_defer("can_lld_rx_fifo_overflow_num: %d\n", can_lld_rx_fifo_overflow_num);
+    printf_defer("can_lld_tx_complete_num: %d\n", can_lld_tx_complete_num);
+    printf_defer("can_lld_wake_up_timeout_num: %d\n", can_lld_wake_up_timeout_num);
+    printf_defer("can_lld_wake_up_match_num: %d\n", can_lld_wake_up_match_num);
+    printf_defer("can_lld_self_wake_up_num: %d\n", can_lld_self_wake_up_num);
+    printf_defer("can_lld_dma_complete_num: %d\n", can_lld_dma_complete_num);
+    printf_defer("can_lld_dma_error_num: %d\n", can_lld_dma_error_num);
+    printf_defer("can_lld_error_num: %d\n", can_lld_error_num);
+    printf_defer("can_lld_default1_num: %d\n", can_lld_default1_num);
+    printf_defer("can_lld_default2_num: %d\n", can_lld_default2_num);
+#endif
+
+#if CAN_LLD_ERROR_PRINT_ENABLE
+    can_lld_error_value = FLEXCAN_DRV_GetErrorStatus(INST_CANCOM1);
+    printf("can error information: %b\n", can_lld_error_value);
+
+    if(can_lld_error_value & CAN_ESR1_ERRINT_MASK)
+    {
+        printf("ERR flag is %d\n", (can_lld_error_value & CAN_ESR1_ERRINT_MASK) >> CAN_ESR1_ERRINT_SHIFT);
+    }
+
+    if(can_lld_error_value & CAN_ESR1_BOFFINT_MASK)
+    {
+        printf("busoff flag is %d\n", (can_lld_error_value & CAN_ESR1_BOFFINT_MASK) >> CAN_ESR1_BOFFINT_SHIFT);
+    }
+
+/* #define FLEXCAN_ALL_INT                                  (0x3B0006U) */
+    if((can_lld_error_value & 0x3B0006U) != 0)
+    {
+        printf("try to clear error flags.\n");
+        FLEXCAN_ClearErrIntStatusFlag(CAN0);
+    }
+#endif
+}
+
+/* @brief: Send data via CAN to the specified mailbox with the specified message id
+ * @param mailbox   : Destination mailbox number
+ * @param messageId : Message ID
+ * @param data      : Pointer to the TX data
+ * @param len       : Length of the TX data
+ * @return          : None
+ */
+void can_lld_tx(uint32_t mailbox, uint32_t messageId, uint8_t *data, uint32_t len)
+{
+    /* Set information about the data to be sent
+     *  - 1 byte in length
+     *  - Standard message ID
+     *  - Bit rate switch enabled to use a different bitrate for the data segment
+     *  - Flexible data rate enabled
+     *  - Use zeros for FD padding
+     */
+    static flexcan_data_info_t dataInfo;
+
+    dataInfo.data_length = len;
+    dataInfo.fd_enable = 0;
+    dataInfo.msg_id_type = FLEXCAN_MSG_ID_STD;
+    dataInfo.is_remote = 0;
+
+    /* Configure TX message buffer with index TX_MSG_ID and TX_MAILBOX*/
+    FLEXCAN_DRV_ConfigTxMb(INST_CANCOM1, mailbox, &dataInfo, messageId);
+    FLEXCAN_DRV_AbortTransfer(INST_CANCOM1, mailbox);
+
+    /* Execute send non-blocking */
+    can_lld_debug_tx_ret_val = FLEXCAN_DRV_Send(INST_CANCOM1, mailbox, &dataInfo, messageId, data);
+}
+
+
+void can_lld_cbk_func(uint8_t instance, flexcan_event_type_t eventType,
+                      uint32_t buffIdx, flexcan_state_t *flexcanState)
+{
+    can_lld_event_num++;
+
+    switch (instance)
+    {
+    case INST_CANCOM1:
+        switch (eventType)
+        {
+        case FLEXCAN_EVENT_RX_COMPLETE:
+            can_lld_rx_complete_num++;
+            break;
+        case FLEXCAN_EVENT_RXFIFO_COMPLETE:
+            can_lld_rx_fifo_compete_num++;
+            can_lld_rx_push(&can_lld_rx_fifo_msg);
+            /* take the next frame as soon as the FIFO has one */
+            (void)FLEXCAN_DRV_RxFifo(INST_CANCOM1, &can_lld_rx_fifo_msg);
+            break;
+        case FLEXCAN_EVENT_RXFIFO_WARNING:
+            can_lld_rx_fifo_warning_num++;
+            break;
+        case FLEXCAN_EVENT_RXFIFO_OVERFLOW:
+            can_lld_rx_fifo_overflow_num++;
+            break;
+        case FLEXCAN_EVENT_TX_COMPLETE:
+            can_lld_tx_complete_num++;
+            break;
+        case FLEXCAN_EVENT_WAKEUP_TIMEOUT:
+            can_lld_wake_up_timeout_num++;
+            break;
+        case FLEXCAN_EVENT_WAKEUP_MATCH:
+            can_lld_wake_up_match_num++;
+            break;
+        case FLEXCAN_EVENT_SELF_WAKEUP:
+            can_lld_self_wake_up_num++;
+            break;
+        case FLEXCAN_EVENT_DMA_COMPLETE:
+            can_lld_dma_complete_num++;
+            break;
+        case FLEXCAN_EVENT_DMA_ERROR:
+            can_lld_dma_error_num++;
+            break;
+        case FLEXCAN_EVENT_ERROR:
+            can_lld_error_num++;
+            break;
+        default:
+            can_lld_default2_num++;
+            break;
+        }
+        break;
+    default:
+        can_lld_default1_num++;
+        break;
+    }
+}
+
+/* @brief: Copy a frame into the RX queue, called from the CAN interrupt
+ * @param msg : frame read from the RX FIFO
+ * @return    : None
+ */
+static void can_lld_rx_push(const flexcan_msgbuff_t *msg)
+{
+    uint32_t head = can_lld_rx_queue_head;
+    uint32_t used = head - __atomic_load_n(&can_lld_rx_queue_tail, __ATOMIC_ACQUIRE);
+    can_lld_rx_frame_t *frame;
+    TaskHandle_t waiter;
+    BaseType_t woken = pdFALSE;
+
+    if (used >= CAN_LLD_RX_QUEUE_SIZE)
+    {
+        can_lld_rx_queue_overflow_num++;
+        return;
+    }
+
+    frame = &can_lld_rx_queue[head & CAN_LLD_RX_QUEUE_MASK];
+    frame->tick = xTaskGetTickCountFromISR();
+    frame->cs = msg->cs;
+    frame->msgId = msg->msgId;
+    frame->dataLen = (msg->dataLen > 8U) ? 8U : msg->dataLen;
+    memcpy(frame->data, msg->data, 8U);
+    __atomic_store_n(&can_lld_rx_queue_head, head + 1U, __ATOMIC_SEQ_CST);
+
+    can_lld_rx_frame_num++;
+    if ((used + 1U) > can_lld_rx_queue_peak)
+    {
+        can_lld_rx_queue_peak = used + 1U;
+    }
+
+    waiter = __atomic_load_n(&can_lld_rx_waiter, __ATOMIC_SEQ_CST);
+    if (waiter != NULL)
+    {
+        vTaskNotifyGiveFromISR(waiter, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+}
+
+/* @brief: Application handling of one received frame
+ * @param frame : received frame
+ * @return      : None
+ */
+static void can_lld_rx_process(const can_lld_rx_frame_t *frame)
+{
+#if CAN_LLD_PRINTF_TEST_ENABLE
+    if (frame->msgId == 0x10)
+    {
+        printf("%.8s\n", frame->data);
+    }
+#else
+    (void)frame;
+#endif
+}
@@ -0,0 +1,46 @@
+#ifndef CAN_LLD_H
+#define CAN_LLD_H
+
+#include "canCom1.h"
+#include "flexcan_hw_access.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define RX_MSG_ID 0x100U
+#define CAN_LLD_PRINTF_TEST_ENABLE 0
+#define CAN_LLD_EVENT_COUNTER_DISPLAY_ENABLE 0
+#define CAN_LLD_ERROR_PRINT_ENABLE 1
+
+/* frames drained from the RX FIFO in the interrupt and kept for
+ * freertos_task_can_rx, must be a power of 2. 500kbit/s at full load is
+ * at most about 4500 frames/s with 8 data bytes */
+#define CAN_LLD_RX_QUEUE_SIZE 256U
+
+/* the FlexCAN free running timer in the CS word, one count per CAN bit */
+#define CAN_LLD_CS_TIME_STAMP_MASK 0xFFFFU
+
+typedef struct
+{
+    uint32_t tick;      /* FreeRTOS tick when the frame left the RX FIFO */
+    uint32_t cs;        /* CS word, IDE, RTR, DLC and the FlexCAN time stamp */
+    uint32_t msgId;
+    uint8_t dataLen;
+    uint8_t data[8];
+} can_lld_rx_frame_t;
+
+extern uint32_t can_lld_rx_frame_num;
+extern uint32_t can_lld_rx_queue_overflow_num;
+extern uint32_t can_lld_rx_queue_peak;
+extern uint32_t can_lld_rx_fifo_overflow_num;
+
+void can_lld_init(void);
+void can_lld_step(void);
+void can_lld_tx(uint32_t mailbox, uint32_t messageId, uint8_t * data, uint32_t len);
+void can_lld_cbk_func(uint8_t instance, flexcan_event_type_t eventType,
+                                   uint32_t buffIdx, flexcan_state_t *flexcanState);
+void can_lld_fifo_rx_func(void);
+bool can_lld_rx_get(can_lld_rx_frame_t *frame);
+bool can_lld_rx_wait(can_lld_rx_frame_t *frame, TickType_t timeout);
+uint32_t can_lld_rx_pending(void);
+
+#endif
@@ -0,0 +1,437 @@
+/* Host simulation of the CAN RX queue of can_lld.c.
+ *
+ * can_lld.c is built as it is, the FlexCAN driver below it is a stub whose
+ * RX FIFO holds one armed buffer: every frame of the simulated bus is copied
+ * into it and RXFIFO_COMPLETE is raised, like the driver does from the CAN
+ * interrupt. The bus runs at 100% load at 500 kbit/s, 8 byte standard
+ * frames back to back with 0..24 stuff bits. Each frame carries a sequence
+ * number, so the consumer sees every lost or reordered frame.
+ *
+ *   - polling every 100 ms like the old can_lld_step() and every 10 ms
+ *   - an event driven task that runs at most 1, 20 or 60 ms after the frame
+ *     that woke it up
+ *   - real threads: the producer pushes from its own thread like the CAN
+ *     interrupt, the consumer blocks in can_lld_rx_wait()
+ *
+ * Every run must be exact: the taken frames plus the counted overflows are
+ * the frames sent, the gaps in the sequence are the overflows and nothing is
+ * reordered. A consumer that comes back within the time the queue holds
+ * must not lose a frame. Exit status 1 on a failed check.
+ *
+ * build: gcc -O2 -Wall -pthread -I.. -I../../S32K144_057_CAN_socketcan/host
+ *            -o can_rx_queue_sim can_rx_queue_sim.c ../can_lld.c
+ * usage: can_rx_queue_sim [-t seconds] [-n thread frames]
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include "can_lld.h"
+#include "lpspiCom1.h"
+#include "sbc_uja116x1.h"
+#include "Cpu.h"
+
+/* 500 kbit/s */
+#define SIM_BIT_US 2U
+/* 8 byte standard data frame without stuff bits, and the stuff bits at most */
+#define SIM_FRAME_BITS 111U
+#define SIM_STUFF_BITS 24U
+#define SIM_NO_WAKE 0xFFFFFFFFU
+
+static uint64_t test_seed = 88172645463325252ULL;
+static uint32_t test_error = 0U;
+static uint32_t test_check_num = 0U;
+
+#define TEST_CHECK(cond, ...) do { test_check_num++; if (!(cond)) { printf("FAIL: " __VA_ARGS__); printf("\n"); test_error++; } } while (0)
+
+static uint32_t test_rand(uint32_t range)
+{
+    test_seed ^= test_seed << 13;
+    test_seed ^= test_seed >> 7;
+    test_seed ^= test_seed << 17;
+    return (uint32_t)(test_seed % range);
+}
+
+/* SDK and FreeRTOS, as far as can_lld.c uses them */
+
+flexcan_state_t canCom1_State;
+const flexcan_user_config_t canCom1_InitConfig0;
+lpspi_state_t lpspiCom1State;
+const lpspi_master_config_t lpspiCom1_MasterConfig0;
+const sbc_int_config_t sbc_uja116x1_InitConfig0;
+static CAN_Type sim_can0;
+static flexcan_callback_t sim_callback;
+static flexcan_msgbuff_t *volatile sim_fifo_buffer;
+static volatile uint32_t sim_tick;
+static pthread_mutex_t sim_notify_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sim_notify_cond = PTHREAD_COND_INITIALIZER;
+static uint32_t sim_notify_value;
+
+CAN_Type *flexcan_host_regs(void)
+{
+    return &sim_can0;
+}
+
+status_t LPSPI_DRV_MasterInit(uint32_t instance, lpspi_state_t *lpspiState, const lpspi_master_config_t *spiConfig)
+{
+    (void)instance;
+    (void)lpspiState;
+    (void)spiConfig;
+    return STATUS_SUCCESS;
+}
+
+status_t SBC_Init(const sbc_int_config_t *const config, const uint32_t lpspiInstance)
+{
+    (void)config;
+    (void)lpspiInstance;
+    return STATUS_SUCCESS;
+}
+
+void INT_SYS_SetPriority(IRQn_Type irqNumber, uint8_t priority)
+{
+    (void)irqNumber;
+    (void)priority;
+}
+
+void FLEXCAN_DRV_GetDefaultConfig(flexcan_user_config_t *config)
+{
+    memset(config, 0, sizeof(*config));
+}
+
+status_t FLEXCAN_DRV_Init(uint8_t instance, flexcan_state_t *state, const flexcan_user_config_t *data)
+{
+    (void)instance;
+    (void)state;
+    (void)data;
+    return STATUS_SUCCESS;
+}
+
+void FLEXCAN_DRV_ConfigRxFifo(uint8_t instance, flexcan_rx_fifo_id_element_format_t id_format,
+                              const flexcan_id_table_t *id_filter_table)
+{
+    (void)instance;
+    (void)id_format;
+    (void)id_filter_table;
+}
+
+void FLEXCAN_DRV_SetRxFifoGlobalMask(uint8_t instance, flexcan_msgbuff_id_type_t id_type, uint32_t mask)
+{
+    (void)instance;
+    (void)id_type;
+    (void)mask;
+}
+
+void FLEXCAN_DRV_InstallEventCallback(uint8_t instance, flexcan_callback_t callback, void *callbackParam)
+{
+    (void)instance;
+    (void)callbackParam;
+    sim_callback = callback;
+}
+
+/* one buffer is armed at a time, the next frame is copied into it */
+status_t FLEXCAN_DRV_RxFifo(uint8_t instance, flexcan_msgbuff_t *data)
+{
+    (void)instance;
+    if (sim_fifo_buffer != NULL)
+    {
+        return STATUS_BUSY;
+    }
+    sim_fifo_buffer = data;
+    return STATUS_SUCCESS;
+}
+
+status_t FLEXCAN_DRV_ConfigTxMb(uint8_t instance, uint8_t mb_idx, const flexcan_data_info_t *tx_info, uint32_t msg_id)
+{
+    (void)instance;
+    (void)mb_idx;
+    (void)tx_info;
+    (void)msg_id;
+    return STATUS_SUCCESS;
+}
+
+status_t FLEXCAN_DRV_AbortTransfer(uint8_t instance, uint8_t mb_idx)
+{
+    (void)instance;
+    (void)mb_idx;
+    return STATUS_SUCCESS;
+}
+
+status_t FLEXCAN_DRV_Send(uint8_t instance, uint8_t mb_idx, const flexcan_data_info_t *tx_info, uint32_t msg_id,
+                          const uint8_t *mb_data)
+{
+    (void)instance;
+    (void)mb_idx;
+    (void)tx_info;
+    (void)msg_id;
+    (void)mb_data;
+    return STATUS_SUCCESS;
+}
+
+uint32_t FLEXCAN_DRV_GetErrorStatus(uint8_t instance)
+{
+    (void)instance;
+    return 0U;
+}
+
+void FLEXCAN_ClearErrIntStatusFlag(CAN_Type *base)
+{
+    (void)base;
+}
+
+TickType_t xTaskGetTickCountFromISR(void)
+{
+    return sim_tick;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return (TaskHandle_t)&sim_notify_value;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    (void)xTaskToNotify;
+    pthread_mutex_lock(&sim_notify_mutex);
+    sim_notify_value++;
+    pthread_cond_signal(&sim_notify_cond);
+    pthread_mutex_unlock(&sim_notify_mutex);
+    *pxHigherPriorityTaskWoken = pdTRUE;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait)
+{
+    struct timespec t;
+    uint64_t ns;
+    uint32_t value;
+
+    clock_gettime(CLOCK_REALTIME, &t);
+    ns = (uint64_t)t.tv_nsec + (((uint64_t)xTicksToWait * 1000000000ULL) / configTICK_RATE_HZ);
+    t.tv_sec += (time_t)(ns / 1000000000ULL);
+    t.tv_nsec = (long)(ns % 1000000000ULL);
+    pthread_mutex_lock(&sim_notify_mutex);
+    while (sim_notify_value == 0U)
+    {
+        if (pthread_cond_timedwait(&sim_notify_cond, &sim_notify_mutex, &t) != 0)
+        {
+            break;
+        }
+    }
+    value = sim_notify_value;
+    sim_notify_value = (xClearCountOnExit != pdFALSE) ? 0U : (value - ((value != 0U) ? 1U : 0U));
+    pthread_mutex_unlock(&sim_notify_mutex);
+    return value;
+}
+
+/* the bus and the consumer */
+
+static uint32_t sim_next_seq;
+static uint32_t sim_got;
+static uint32_t sim_gap;
+static uint32_t sim_order_error;
+static uint32_t sim_fifo_lost;
+
+/* one frame off the bus: the driver copies it into the armed buffer and
+ * calls back from the CAN interrupt */
+static void sim_bus_frame(uint32_t seq, uint32_t t_us)
+{
+    flexcan_msgbuff_t *msg = sim_fifo_buffer;
+
+    if (msg == NULL)
+    {
+        sim_fifo_lost++;
+        return;
+    }
+    sim_fifo_buffer = NULL;
+    msg->msgId = RX_MSG_ID + (seq & 0xFFU);
+    msg->dataLen = 8U;
+    msg->cs = (t_us / SIM_BIT_US) & CAN_LLD_CS_TIME_STAMP_MASK;
+    memset(msg->data, 0, 8U);
+    memcpy(msg->data, &seq, sizeof(seq));
+    sim_callback(INST_CANCOM1, FLEXCAN_EVENT_RXFIFO_COMPLETE, 0U, &canCom1_State);
+}
+
+static void sim_take(const can_lld_rx_frame_t *frame)
+{
+    uint32_t seq;
+
+    memcpy(&seq, frame->data, sizeof(seq));
+    if (seq < sim_next_seq)
+    {
+        sim_order_error++;
+    }
+    else
+    {
+        sim_gap += seq - sim_next_seq;
+    }
+    sim_next_seq = seq + 1U;
+    sim_got++;
+}
+
+static void sim_drain(void)
+{
+    can_lld_rx_frame_t frame;
+
+    while (can_lld_rx_get(&frame))
+    {
+        sim_take(&frame);
+    }
+}
+
+static void sim_reset(void)
+{
+    sim_drain();
+    can_lld_rx_frame_num = 0U;
+    can_lld_rx_queue_overflow_num = 0U;
+    can_lld_rx_queue_peak = 0U;
+    sim_next_seq = 0U;
+    sim_got = 0U;
+    sim_gap = 0U;
+    sim_order_error = 0U;
+    sim_fifo_lost = 0U;
+}
+
+static void sim_result(const char *name, uint32_t sent, double seconds, bool lossless)
+{
+    printf("%-26s %8u frames (%.0f/s): %8u taken, %7u overflow, %7u gaps, %u reordered, peak %u\n", name, sent,
+           (double)sent / seconds, sim_got, can_lld_rx_queue_overflow_num, sim_gap, sim_order_error,
+           can_lld_rx_queue_peak);
+    TEST_CHECK(sim_fifo_lost == 0U, "%s: %u frames found no armed RX FIFO buffer", name, sim_fifo_lost);
+    TEST_CHECK((sim_got + can_lld_rx_queue_overflow_num) == sent, "%s: %u taken + %u overflow != %u sent", name,
+               sim_got, can_lld_rx_queue_overflow_num, sent);
+    TEST_CHECK(sim_gap == can_lld_rx_queue_overflow_num, "%s: %u gaps, %u overflow", name, sim_gap,
+               can_lld_rx_queue_overflow_num);
+    TEST_CHECK(sim_order_error == 0U, "%s: %u frames reordered", name, sim_order_error);
+    if (lossless)
+    {
+        TEST_CHECK(can_lld_rx_queue_overflow_num == 0U, "%s: %u frames lost", name, can_lld_rx_queue_overflow_num);
+    }
+}
+
+/* @brief: Run the bus at full load with a consumer in the same thread
+ * @param name      : name of the run
+ * @param seconds   : bus time
+ * @param period_us : polling period, 0 for a task woken by the frames
+ * @param wake_us   : longest time from the frame that woke the task to its
+ *                    run, the time is random up to it
+ * @return          : None
+ */
+static void sim_run(const char *name, uint32_t seconds, uint32_t period_us, uint32_t wake_us)
+{
+    const uint32_t end = seconds * 1000000U;
+    const uint32_t queue_us = CAN_LLD_RX_QUEUE_SIZE * SIM_FRAME_BITS * SIM_BIT_US;
+    uint32_t next_run = period_us;
+    uint32_t wake_at = SIM_NO_WAKE;
+    uint32_t seq = 0U;
+    uint32_t t = 0U;
+
+    sim_reset();
+    while (t < end)
+    {
+        t += SIM_BIT_US * (SIM_FRAME_BITS + test_rand(SIM_STUFF_BITS + 1U));
+        sim_tick = (uint32_t)(((uint64_t)t * configTICK_RATE_HZ) / 1000000U);
+        if (period_us != 0U)
+        {
+            while (next_run <= t)
+            {
+                sim_drain();
+                next_run += period_us;
+            }
+        }
+        else if ((wake_at != SIM_NO_WAKE) && (t >= wake_at))
+        {
+            sim_drain();
+            wake_at = SIM_NO_WAKE;
+        }
+        sim_bus_frame(seq++, t);
+        if ((period_us == 0U) && (wake_at == SIM_NO_WAKE))
+        {
+            wake_at = t + test_rand(wake_us + 1U);
+        }
+    }
+    sim_drain();
+    /* the queue holds at least queue_us of frames without stuff bits */
+    sim_result(name, seq, (double)seconds, ((period_us != 0U) ? period_us : wake_us) < queue_us);
+}
+
+static volatile bool sim_producer_done;
+
+static void *sim_producer(void *arg)
+{
+    const uint32_t num = *(const uint32_t *)arg;
+    uint32_t i;
+
+    for (i = 0U; i < num; i++)
+    {
+        sim_bus_frame(i, i);
+        if ((i & 1023U) == 0U)
+        {
+            sched_yield();
+        }
+    }
+    sim_producer_done = true;
+    return NULL;
+}
+
+static void sim_threads(uint32_t num)
+{
+    can_lld_rx_frame_t frame;
+    pthread_t thread;
+    struct timespec start;
+    struct timespec end;
+    double s;
+
+    sim_reset();
+    sim_producer_done = false;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    pthread_create(&thread, NULL, sim_producer, &num);
+    while (!sim_producer_done || (can_lld_rx_pending() != 0U))
+    {
+        if (can_lld_rx_wait(&frame, pdMS_TO_TICKS(1U)))
+        {
+            sim_take(&frame);
+        }
+    }
+    pthread_join(thread, NULL);
+    sim_drain();
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    s = (double)(end.tv_sec - start.tv_sec) + ((double)(end.tv_nsec - start.tv_nsec) / 1e9);
+    /* the producer does not wait for the bus, the queue overflows */
+    sim_result("threads, blocking consumer", num, s, false);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t seconds = 10U;
+    uint32_t num = 20000000U;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:n:")) != -1)
+    {
+        switch (opt)
+        {
+        case 't':
+            seconds = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'n':
+            num = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-t seconds] [-n thread frames]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    can_lld_init();
+    sim_run("poll every 100 ms", seconds, 100000U, 0U);
+    sim_run("poll every 10 ms", seconds, 10000U, 0U);
+    sim_run("task, wake up <= 1 ms", seconds, 0U, 1000U);
+    sim_run("task, wake up <= 20 ms", seconds, 0U, 20000U);
+    sim_run("task, wake up <= 60 ms", seconds, 0U, 60000U);
+    sim_threads(num);
+    printf("%s, %u checks, %u errors\n", (test_error == 0U) ? "PASS" : "FAIL", test_check_num, test_error);
+    return (test_error == 0U) ? 0 : 1;
+}
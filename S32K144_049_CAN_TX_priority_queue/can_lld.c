@@ -0,0 +1,624 @@
+#include "can_lld.h"
+#include "string.h"
+#include "lpspiCom1.h"
+#include "sbc_uja116x1.h"
+#include "printf.h"
+
+status_t can_lld_debug_tx_ret_val;
+flexcan_data_info_t can_lld_rx_data_info;
+flexcan_msgbuff_t can_lld_rx_test_msg;
+flexcan_user_config_t can_lld_config_data_1;
+flexcan_user_config_t can_lld_config_data_0;
+static uint8_t can_tx_data[8];
+flexcan_id_table_t can_lld_fifo_filter_table[8];
+uint32_t can_lld_event_num;
+uint32_t can_lld_rx_complete_num;
+uint32_t can_lld_rx_fifo_compete_num;
+uint32_t can_lld_rx_fifo_warning_num;
+uint32_t can_lld_rx_fifo_overflow_num;
+uint32_t can_lld_tx_complete_num;
+uint32_t can_lld_wake_up_timeout_num;
+uint32_t can_lld_wake_up_match_num;
+uint32_t can_lld_self_wake_up_num;
+uint32_t can_lld_dma_complete_num;
+uint32_t can_lld_dma_error_num;
+uint32_t can_lld_error_num;
+uint32_t can_lld_default1_num;
+uint32_t can_lld_default2_num;
+uint32_t can_lld_error_value;
+uint32_t can_lld_rx_frame_num;
+uint32_t can_lld_rx_queue_overflow_num;
+uint32_t can_lld_rx_queue_peak;
+uint32_t can_lld_tx_frame_num;
+uint32_t can_lld_tx_queue_full_num;
+uint32_t can_lld_tx_queue_peak;
+uint32_t can_lld_tx_cancel_num;
+uint32_t can_lld_tx_error_num;
+
+/* the driver copies every RX FIFO frame here before RXFIFO_COMPLETE */
+flexcan_msgbuff_t can_lld_rx_fifo_msg;
+
+#define CAN_LLD_RX_QUEUE_MASK (CAN_LLD_RX_QUEUE_SIZE - 1U)
+
+/* single producer single consumer ring, the CAN interrupt only moves the head
+ * and freertos_task_can_rx only moves the tail. The indexes are free running,
+ * a full ring drops the new frame and counts it */
+static can_lld_rx_frame_t can_lld_rx_queue[CAN_LLD_RX_QUEUE_SIZE];
+static volatile uint32_t can_lld_rx_queue_head = 0U;
+static volatile uint32_t can_lld_rx_queue_tail = 0U;
+/* consumer blocked in can_lld_rx_wait(), NULL if none */
+static TaskHandle_t volatile can_lld_rx_waiter = NULL;
+
+#define CAN_LLD_TX_MB_ALL ((1UL << CAN_LLD_TX_MB_NUM) - 1UL)
+
+typedef struct
+{
+    uint32_t key;       /* arbitration order, the lower key wins the bus */
+    uint32_t seq;       /* keeps frames with the same key in queue order */
+    uint32_t msgId;
+    uint8_t dataLen;
+    uint8_t data[8];
+} can_lld_tx_frame_t;
+
+/* TX queue, a binary min heap on (key, seq). Frames leave it only to enter a
+ * mailbox of the pool, so the pool always holds the highest priority frames
+ * and FlexCAN (CTRL1[LBUF] = 0, the reset value kept by FLEXCAN_DRV_Init)
+ * arbitrates between them by ID. Shared by the tasks calling can_lld_tx()
+ * and the CAN interrupt, the tasks use a critical section */
+static can_lld_tx_frame_t can_lld_tx_queue[CAN_LLD_TX_QUEUE_SIZE];
+static uint32_t can_lld_tx_queue_num = 0U;
+static uint32_t can_lld_tx_seq = 0U;
+/* frame loaded into each pool mailbox, valid while its bit is set */
+static can_lld_tx_frame_t can_lld_tx_mb_frame[CAN_LLD_TX_MB_NUM];
+static uint32_t can_lld_tx_mb_busy = 0U;
+
+static void can_lld_rx_push(const flexcan_msgbuff_t *msg);
+static void can_lld_rx_process(const can_lld_rx_frame_t *frame);
+static uint32_t can_lld_tx_key(uint32_t messageId);
+static bool can_lld_tx_before(const can_lld_tx_frame_t *a, const can_lld_tx_frame_t *b);
+static void can_lld_tx_queue_push(const can_lld_tx_frame_t *frame);
+static void can_lld_tx_queue_pop(can_lld_tx_frame_t *frame);
+static void can_lld_tx_refill(void);
+#if CAN_LLD_TX_CANCEL_ENABLE
+static void can_lld_tx_cancel(void);
+#endif
+
+void can_lld_init(void)
+{
+    static flexcan_data_info_t tx_data_info;
+    uint8_t i = 0U;
+
+    for (i = 0U; i < 8U; i++)
+    {
+        can_lld_fifo_filter_table[i].isRemoteFrame = false;
+        can_lld_fifo_filter_table[i].isExtendedFrame = false;
+        can_lld_fifo_filter_table[i].id = i + 1;
+    }
+
+    FLEXCAN_DRV_GetDefaultConfig(&can_lld_config_data_0);
+    LPSPI_DRV_MasterInit(LPSPICOM1, &lpspiCom1State, &lpspiCom1_MasterConfig0);
+    INT_SYS_SetPriority(LPSPI1_IRQn, configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY);
+    SBC_Init(&sbc_uja116x1_InitConfig0, LPSPICOM1);
+    FLEXCAN_DRV_Init(INST_CANCOM1, &canCom1_State, &canCom1_InitConfig0);
+    INT_SYS_SetPriority(CAN0_ORed_0_15_MB_IRQn, configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY);
+    /* Configure RX message buffer with index RX_MSG_ID and RX_MAILBOX */
+    can_lld_rx_data_info.msg_id_type = FLEXCAN_MSG_ID_STD;
+    can_lld_rx_data_info.fd_enable = 0;
+    can_lld_rx_data_info.is_remote = 0;
+    /* FLEXCAN_DRV_ConfigRxMb(INST_CANCOM1, 0, &can_lld_rx_data_info, RX_MSG_ID); */
+    FLEXCAN_DRV_ConfigRxFifo(INST_CANCOM1, FLEXCAN_RX_FIFO_ID_FORMAT_A, can_lld_fifo_filter_table);
+    FLEXCAN_DRV_SetRxFifoGlobalMask(INST_CANCOM1, FLEXCAN_RX_FIFO_ID_FORMAT_A, 0);
+    FLEXCAN_DRV_GetDefaultConfig(&can_lld_config_data_1);
+    FLEXCAN_DRV_InstallEventCallback(INST_CANCOM1, can_lld_cbk_func, NULL);
+    /* the TX pool mailboxes start inactive, the ID is set for every frame */
+    tx_data_info.data_length = 8U;
+    tx_data_info.msg_id_type = FLEXCAN_MSG_ID_STD;
+    for (i = 0U; i < CAN_LLD_TX_MB_NUM; i++)
+    {
+        (void)FLEXCAN_DRV_ConfigTxMb(INST_CANCOM1, CAN_LLD_TX_MB_FIRST + i, &tx_data_info, 0U);
+    }
+    /* armed once here, the callback re-arms it for every frame */
+    (void)FLEXCAN_DRV_RxFifo(INST_CANCOM1, &can_lld_rx_fifo_msg);
+}
+
+/* @brief: Handle all frames waiting in the RX queue, never blocks
+ * @return: None
+ */
+void can_lld_fifo_rx_func(void)
+{
+    can_lld_rx_frame_t frame;
+
+    while (can_lld_rx_get(&frame))
+    {
+        can_lld_rx_process(&frame);
+    }
+}
+
+/* @brief: Take the oldest frame out of the RX queue, never blocks
+ * @param frame : destination of the frame
+ * @return      : true if a frame was taken
+ */
+bool can_lld_rx_get(can_lld_rx_frame_t *frame)
+{
+    uint32_t tail = can_lld_rx_queue_tail;
+
+    if (tail == __atomic_load_n(&can_lld_rx_queue_head, __ATOMIC_ACQUIRE))
+    {
+        return false;
+    }
+
+    *frame = can_lld_rx_queue[tail & CAN_LLD_RX_QUEUE_MASK];
+    /* the slot goes back to the interrupt only after it is copied */
+    __atomic_store_n(&can_lld_rx_queue_tail, tail + 1U, __ATOMIC_RELEASE);
+    return true;
+}
+
+/* @brief: Take the oldest frame out of the RX queue, wait for one if it is
+ *         empty. Only one task may consume the queue, its task notification
+ *         is used for the wake up
+ * @param frame   : destination of the frame
+ * @param timeout : ticks to wait, portMAX_DELAY for ever
+ * @return        : true if a frame was taken, false on timeout
+ */
+bool can_lld_rx_wait(can_lld_rx_frame_t *frame, TickType_t timeout)
+{
+    bool ret;
+
+    if (can_lld_rx_get(frame))
+    {
+        return true;
+    }
+
+    /* the handle must be visible before the queue is checked again, else a
+     * frame pushed in between would not wake us up */
+    __atomic_store_n(&can_lld_rx_waiter, xTaskGetCurrentTaskHandle(), __ATOMIC_SEQ_CST);
+    for (;;)
+    {
+        if (can_lld_rx_get(frame))
+        {
+            ret = true;
+            break;
+        }
+        /* a late notification for an already taken frame only costs a loop */
+        if (0U == ulTaskNotifyTake(pdTRUE, timeout))
+        {
+            ret = can_lld_rx_get(frame);
+            break;
+        }
+    }
+    __atomic_store_n(&can_lld_rx_waiter, NULL, __ATOMIC_RELEASE);
+
+    return ret;
+}
+
+/* @brief: Number of frames waiting in the RX queue
+ * @return: waiting frames
+ */
+uint32_t can_lld_rx_pending(void)
+{
+    return __atomic_load_n(&can_lld_rx_queue_head, __ATOMIC_ACQUIRE) -
+           __atomic_load_n(&can_lld_rx_queue_tail, __ATOMIC_ACQUIRE);
+}
+
+void freertos_task_can_rx(void *pvParameters)
+{
+    can_lld_rx_frame_t frame;
+
+    (void)pvParameters;
+
+    for (;;)
+    {
+        if (can_lld_rx_wait(&frame, portMAX_DELAY))
+        {
+            can_lld_rx_process(&frame);
+            can_lld_fifo_rx_func();
+        }
+    }
+}
+
+void can_lld_step(void)
+{
+    (void)can_lld_tx(0x77, can_tx_data, 8);
+    *(uint32_t *)can_tx_data += 1U;
+
+#if CAN_LLD_EVENT_COUNTER_DISPLAY_ENABLE
+    printf_defer("CAN event number: %d\n", can_lld_event_num);
+    printf_defer("can_lld_rx_complete_num: %d\n", can_lld_rx_complete_num);
+    printf_defer("can_lld_rx_fifo_compete_num: %d\n", can_lld_rx_fifo_compete_num);
+    printf_defer("can_lld_rx_fifo_warning_num: %d\n", can_lld_rx_fifo_warning_num);
+    printf_defer("can_lld_rx_fifo_overflow_num: %d\n", can_lld_rx_fifo_overflow_num);
+    printf_defer("can_lld_tx_complete_num: %d\n", can_lld_tx_complete_num);
+    printf_defer("can_lld_wake_up_timeout_num: %d\n", can_lld_wake_up_timeout_num);
+    printf_defer("can_lld_wake_up_match_num: %d\n", can_lld_wake_up_match_num);
+    printf_defer("can_lld_self_wake_up_num: %d\n", can_lld_self_wake_up_num);
+    printf_defer("can_lld_dma_complete_num: %d\n", can_lld_dma_complete_num);
+    printf_defer("can_lld_dma_error_num: %d\n", can_lld_dma_error_num);
+    printf_defer("can_lld_error_num: %d\n", can_lld_error_num);
+    printf_defer("can_lld_default1_num: %d\n", can_lld_default1_num);
+    printf_defer("can_lld_default2_num: %d\n", can_lld_default2_num);
+#endif
+
+#if CAN_LLD_ERROR_PRINT_ENABLE
+    can_lld_error_value = FLEXCAN_DRV_GetErrorStatus(INST_CANCOM1);
+    printf("can error information: %b\n", can_lld_error_value);
+
+    if(can_lld_error_value & CAN_ESR1_ERRINT_MASK)
+    {
+        printf("ERR flag is %d\n", (can_lld_error_value & CAN_ESR1_ERRINT_MASK) >> CAN_ESR1_ERRINT_SHIFT);
+    }
+
+    if(can_lld_error_value & CAN_ESR1_BOFFINT_MASK)
+    {
+        printf("busoff flag is %d\n", (can_lld_error_value & CAN_ESR1_BOFFINT_MASK) >> CAN_ESR1_BOFFINT_SHIFT);
+    }
+
+/* #define FLEXCAN_ALL_INT                                  (0x3B0006U) */
+    if((can_lld_error_value & 0x3B0006U) != 0)
+    {
+        printf("try to clear error flags.\n");
+        FLEXCAN_ClearErrIntStatusFlag(CAN0);
+    }
+#endif
+}
+
+/* @brief: Queue a frame for sending, it is loaded into a TX mailbox as soon
+ *         as one is free and no higher priority frame is waiting. Frames with
+ *         the same ID are sent in call order. Must not be called from an ISR
+ * @param messageId : Message ID, or'ed with CAN_LLD_TX_ID_EXT for a 29 bit ID
+ * @param data      : Pointer to the TX data, copied before the call returns
+ * @param len       : Length of the TX data, 8 at most
+ * @return          : STATUS_SUCCESS, STATUS_BUSY if the TX queue is full,
+ *                    STATUS_ERROR if len is more than 8
+ */
+status_t can_lld_tx(uint32_t messageId, const uint8_t *data, uint32_t len)
+{
+    can_lld_tx_frame_t frame;
+    status_t ret = STATUS_SUCCESS;
+
+    if (len > 8U)
+    {
+        return STATUS_ERROR;
+    }
+    frame.key = can_lld_tx_key(messageId);
+    frame.msgId = messageId;
+    frame.dataLen = (uint8_t)len;
+    memcpy(frame.data, data, frame.dataLen);
+
+    taskENTER_CRITICAL();
+    if (can_lld_tx_queue_num >= CAN_LLD_TX_QUEUE_SIZE)
+    {
+        can_lld_tx_queue_full_num++;
+        ret = STATUS_BUSY;
+    }
+    else
+    {
+        frame.seq = can_lld_tx_seq++;
+        can_lld_tx_queue_push(&frame);
+        can_lld_tx_frame_num++;
+        if (can_lld_tx_queue_num > can_lld_tx_queue_peak)
+        {
+            can_lld_tx_queue_peak = can_lld_tx_queue_num;
+        }
+#if CAN_LLD_TX_CANCEL_ENABLE
+        can_lld_tx_cancel();
+#endif
+        can_lld_tx_refill();
+    }
+    taskEXIT_CRITICAL();
+
+    return ret;
+}
+
+/* @brief: Number of frames not sent yet, queued or loaded into a mailbox
+ * @return: pending frames
+ */
+uint32_t can_lld_tx_pending(void)
+{
+    uint32_t busy;
+    uint32_t num;
+
+    taskENTER_CRITICAL();
+    num = can_lld_tx_queue_num;
+    for (busy = can_lld_tx_mb_busy; busy != 0U; busy &= busy - 1U)
+    {
+        num++;
+    }
+    taskEXIT_CRITICAL();
+
+    return num;
+}
+
+void can_lld_cbk_func(uint8_t instance, flexcan_event_type_t eventType,
+                      uint32_t buffIdx, flexcan_state_t *flexcanState)
+{
+    can_lld_event_num++;
+
+    switch (instance)
+    {
+    case INST_CANCOM1:
+        switch (eventType)
+        {
+        case FLEXCAN_EVENT_RX_COMPLETE:
+            can_lld_rx_complete_num++;
+            break;
+        case FLEXCAN_EVENT_RXFIFO_COMPLETE:
+            can_lld_rx_fifo_compete_num++;
+            can_lld_rx_push(&can_lld_rx_fifo_msg);
+            /* take the next frame as soon as the FIFO has one */
+            (void)FLEXCAN_DRV_RxFifo(INST_CANCOM1, &can_lld_rx_fifo_msg);
+            break;
+        case FLEXCAN_EVENT_RXFIFO_WARNING:
+            can_lld_rx_fifo_warning_num++;
+            break;
+        case FLEXCAN_EVENT_RXFIFO_OVERFLOW:
+            can_lld_rx_fifo_overflow_num++;
+            break;
+        case FLEXCAN_EVENT_TX_COMPLETE:
+            can_lld_tx_complete_num++;
+            if ((buffIdx >= CAN_LLD_TX_MB_FIRST) && (buffIdx < (CAN_LLD_TX_MB_FIRST + CAN_LLD_TX_MB_NUM)))
+            {
+                can_lld_tx_mb_busy &= ~(1UL << (buffIdx - CAN_LLD_TX_MB_FIRST));
+                can_lld_tx_refill();
+            }
+            break;
+        case FLEXCAN_EVENT_WAKEUP_TIMEOUT:
+            can_lld_wake_up_timeout_num++;
+            break;
+        case FLEXCAN_EVENT_WAKEUP_MATCH:
+            can_lld_wake_up_match_num++;
+            break;
+        case FLEXCAN_EVENT_SELF_WAKEUP:
+            can_lld_self_wake_up_num++;
+            break;
+        case FLEXCAN_EVENT_DMA_COMPLETE:
+            can_lld_dma_complete_num++;
+            break;
+        case FLEXCAN_EVENT_DMA_ERROR:
+            can_lld_dma_error_num++;
+            break;
+        case FLEXCAN_EVENT_ERROR:
+            can_lld_error_num++;
+            break;
+        default:
+            can_lld_default2_num++;
+            break;
+        }
+        break;
+    default:
+        can_lld_default1_num++;
+        break;
+    }
+}
+
+/* @brief: Copy a frame into the RX queue, called from the CAN interrupt
+ * @param msg : frame read from the RX FIFO
+ * @return    : None
+ */
+static void can_lld_rx_push(const flexcan_msgbuff_t *msg)
+{
+    uint32_t head = can_lld_rx_queue_head;
+    uint32_t used = head - __atomic_load_n(&can_lld_rx_queue_tail, __ATOMIC_ACQUIRE);
+    can_lld_rx_frame_t *frame;
+    TaskHandle_t waiter;
+    BaseType_t woken = pdFALSE;
+
+    if (used >= CAN_LLD_RX_QUEUE_SIZE)
+    {
+        can_lld_rx_queue_overflow_num++;
+        return;
+    }
+
+    frame = &can_lld_rx_queue[head & CAN_LLD_RX_QUEUE_MASK];
+    frame->tick = xTaskGetTickCountFromISR();
+    frame->cs = msg->cs;
+    frame->msgId = msg->msgId;
+    frame->dataLen = (msg->dataLen > 8U) ? 8U : msg->dataLen;
+    memcpy(frame->data, msg->data, 8U);
+    __atomic_store_n(&can_lld_rx_queue_head, head + 1U, __ATOMIC_SEQ_CST);
+
+    can_lld_rx_frame_num++;
+    if ((used + 1U) > can_lld_rx_queue_peak)
+    {
+        can_lld_rx_queue_peak = used + 1U;
+    }
+
+    waiter = __atomic_load_n(&can_lld_rx_waiter, __ATOMIC_SEQ_CST);
+    if (waiter != NULL)
+    {
+        vTaskNotifyGiveFromISR(waiter, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+}
+
+/* @brief: Arbitration order of a message ID, the lower key wins the bus.
+ *         The 11 base ID bits are compared first, a standard frame beats an
+ *         extended one with the same base ID (RTR against the recessive SRR,
+ *         then IDE), then the 18 extended ID bits
+ * @param messageId : Message ID as passed to can_lld_tx()
+ * @return          : key
+ */
+static uint32_t can_lld_tx_key(uint32_t messageId)
+{
+    uint32_t id;
+
+    if ((messageId & CAN_LLD_TX_ID_EXT) != 0U)
+    {
+        id = messageId & 0x1FFFFFFFU;
+        return ((id >> 18) << 19) | (1UL << 18) | (id & 0x3FFFFU);
+    }
+
+    return (messageId & 0x7FFU) << 19;
+}
+
+static bool can_lld_tx_before(const can_lld_tx_frame_t *a, const can_lld_tx_frame_t *b)
+{
+    if (a->key != b->key)
+    {
+        return a->key < b->key;
+    }
+    return (int32_t)(a->seq - b->seq) < 0;
+}
+
+static void can_lld_tx_queue_push(const can_lld_tx_frame_t *frame)
+{
+    uint32_t i = can_lld_tx_queue_num++;
+    uint32_t parent;
+
+    while (i > 0U)
+    {
+        parent = (i - 1U) / 2U;
+        if (!can_lld_tx_before(frame, &can_lld_tx_queue[parent]))
+        {
+            break;
+        }
+        can_lld_tx_queue[i] = can_lld_tx_queue[parent];
+        i = parent;
+    }
+    can_lld_tx_queue[i] = *frame;
+}
+
+static void can_lld_tx_queue_pop(can_lld_tx_frame_t *frame)
+{
+    const can_lld_tx_frame_t *last;
+    uint32_t i = 0U;
+    uint32_t child;
+
+    *frame = can_lld_tx_queue[0];
+    last = &can_lld_tx_queue[--can_lld_tx_queue_num];
+
+    for (;;)
+    {
+        child = 2U * i + 1U;
+        if (child >= can_lld_tx_queue_num)
+        {
+            break;
+        }
+        if (((child + 1U) < can_lld_tx_queue_num) &&
+            can_lld_tx_before(&can_lld_tx_queue[child + 1U], &can_lld_tx_queue[child]))
+        {
+            child++;
+        }
+        if (!can_lld_tx_before(&can_lld_tx_queue[child], last))
+        {
+            break;
+        }
+        can_lld_tx_queue[i] = can_lld_tx_queue[child];
+        i = child;
+    }
+    can_lld_tx_queue[i] = *last;
+}
+
+/* @brief: Load free pool mailboxes from the head of the TX queue. Called from
+ *         the CAN interrupt or with it masked
+ * @return: None
+ */
+static void can_lld_tx_refill(void)
+{
+    static flexcan_data_info_t dataInfo;
+    can_lld_tx_frame_t *frame;
+    uint32_t slot;
+    uint32_t busy;
+
+    dataInfo.fd_enable = 0;
+    dataInfo.is_remote = 0;
+
+    while ((can_lld_tx_queue_num > 0U) && (can_lld_tx_mb_busy != CAN_LLD_TX_MB_ALL))
+    {
+        /* FlexCAN sends equal IDs lowest mailbox first, which is not the queue
+         * order, so a frame waits until the one with its ID has left */
+        for (busy = can_lld_tx_mb_busy; busy != 0U; busy &= busy - 1U)
+        {
+            slot = (uint32_t)__builtin_ctz(busy);
+            if (can_lld_tx_mb_frame[slot].key == can_lld_tx_queue[0].key)
+            {
+                return;
+            }
+        }
+
+        slot = (uint32_t)__builtin_ctz(~can_lld_tx_mb_busy);
+        frame = &can_lld_tx_mb_frame[slot];
+        can_lld_tx_queue_pop(frame);
+
+        dataInfo.data_length = frame->dataLen;
+        if ((frame->msgId & CAN_LLD_TX_ID_EXT) != 0U)
+        {
+            dataInfo.msg_id_type = FLEXCAN_MSG_ID_EXT;
+        }
+        else
+        {
+            dataInfo.msg_id_type = FLEXCAN_MSG_ID_STD;
+        }
+
+        can_lld_debug_tx_ret_val = FLEXCAN_DRV_Send(INST_CANCOM1, CAN_LLD_TX_MB_FIRST + slot, &dataInfo,
+                                                    frame->msgId & ~CAN_LLD_TX_ID_EXT, frame->data);
+        if (can_lld_debug_tx_ret_val == STATUS_SUCCESS)
+        {
+            can_lld_tx_mb_busy |= 1UL << slot;
+        }
+        else
+        {
+            can_lld_tx_error_num++;
+        }
+    }
+}
+
+#if CAN_LLD_TX_CANCEL_ENABLE
+/* @brief: Make room for the head of the TX queue if the pool is full of lower
+ *         priority frames. Called with the CAN interrupt masked, the abort
+ *         waits at most for the end of the frame on the wire
+ * @return: None
+ */
+static void can_lld_tx_cancel(void)
+{
+    uint32_t slot;
+    uint32_t worst = 0U;
+
+    if ((can_lld_tx_mb_busy != CAN_LLD_TX_MB_ALL) || (can_lld_tx_queue_num == 0U) ||
+        (can_lld_tx_queue_num >= CAN_LLD_TX_QUEUE_SIZE))
+    {
+        return;
+    }
+
+    for (slot = 1U; slot < CAN_LLD_TX_MB_NUM; slot++)
+    {
+        if (can_lld_tx_before(&can_lld_tx_mb_frame[worst], &can_lld_tx_mb_frame[slot]))
+        {
+            worst = slot;
+        }
+    }
+    /* same key: the queued frame is the younger one and has to wait anyway */
+    if (can_lld_tx_queue[0].key >= can_lld_tx_mb_frame[worst].key)
+    {
+        return;
+    }
+
+    can_lld_tx_mb_busy &= ~(1UL << worst);
+    if (STATUS_SUCCESS == FLEXCAN_DRV_AbortTransfer(INST_CANCOM1, CAN_LLD_TX_MB_FIRST + worst))
+    {
+        /* it lost arbitration until now, back into the queue with its seq */
+        can_lld_tx_cancel_num++;
+        can_lld_tx_queue_push(&can_lld_tx_mb_frame[worst]);
+    }
+    else
+    {
+        /* it was on the wire and went out, the abort ate TX_COMPLETE */
+        can_lld_tx_complete_num++;
+    }
+}
+#endif
+
+/* @brief: Application handling of one received frame
+ * @param frame : received frame
+ * @return      : None
+ */
+static void can_lld_rx_process(const can_lld_rx_frame_t *frame)
+{
+#if CAN_LLD_PRINTF_TEST_ENABLE
+    if (frame->msgId == 0x10)
+    {
+        printf("%.8s\n", frame->data);
+    }
+#else
+    (void)frame;
+#endif
+}
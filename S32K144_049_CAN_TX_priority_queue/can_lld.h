@@ -0,0 +1,71 @@
+#ifndef CAN_LLD_H
+#define CAN_LLD_H
+
+#include "canCom1.h"
+#include "flexcan_hw_access.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define RX_MSG_ID 0x100U
+#define CAN_LLD_PRINTF_TEST_ENABLE 0
+#define CAN_LLD_EVENT_COUNTER_DISPLAY_ENABLE 0
+#define CAN_LLD_ERROR_PRINT_ENABLE 1
+
+/* frames drained from the RX FIFO in the interrupt and kept for
+ * freertos_task_can_rx, must be a power of 2. 500kbit/s at full load is
+ * at most about 4500 frames/s with 8 data bytes */
+#define CAN_LLD_RX_QUEUE_SIZE 256U
+
+/* TX mailbox pool. With the RX FIFO and 8 ID filters the FIFO owns MB0-5 and
+ * the filter table MB6-7, the rest of max_num_mb (16) is used for TX */
+#define CAN_LLD_TX_MB_FIRST 8U
+#define CAN_LLD_TX_MB_NUM 8U
+
+/* frames waiting for a free TX mailbox, kept in CAN ID priority order */
+#define CAN_LLD_TX_QUEUE_SIZE 32U
+
+/* when the pool is full, abort the lowest priority mailbox that is still
+ * waiting for arbitration to make room for a higher priority frame. A frame
+ * already on the wire is never aborted, FlexCAN finishes it */
+#ifndef CAN_LLD_TX_CANCEL_ENABLE
+#define CAN_LLD_TX_CANCEL_ENABLE 1
+#endif
+
+/* or'ed into the messageId of can_lld_tx() to send a 29 bit ID */
+#define CAN_LLD_TX_ID_EXT 0x80000000U
+
+/* the FlexCAN free running timer in the CS word, one count per CAN bit */
+#define CAN_LLD_CS_TIME_STAMP_MASK 0xFFFFU
+
+typedef struct
+{
+    uint32_t tick;      /* FreeRTOS tick when the frame left the RX FIFO */
+    uint32_t cs;        /* CS word, IDE, RTR, DLC and the FlexCAN time stamp */
+    uint32_t msgId;
+    uint8_t dataLen;
+    uint8_t data[8];
+} can_lld_rx_frame_t;
+
+extern uint32_t can_lld_rx_frame_num;
+extern uint32_t can_lld_rx_queue_overflow_num;
+extern uint32_t can_lld_rx_queue_peak;
+extern uint32_t can_lld_rx_fifo_overflow_num;
+extern uint32_t can_lld_tx_frame_num;
+extern uint32_t can_lld_tx_complete_num;
+extern uint32_t can_lld_tx_queue_full_num;
+extern uint32_t can_lld_tx_queue_peak;
+extern uint32_t can_lld_tx_cancel_num;
+extern uint32_t can_lld_tx_error_num;
+
+void can_lld_init(void);
+void can_lld_step(void);
+status_t can_lld_tx(uint32_t messageId, const uint8_t *data, uint32_t len);
+uint32_t can_lld_tx_pending(void);
+void can_lld_cbk_func(uint8_t instance, flexcan_event_type_t eventType,
+                                   uint32_t buffIdx, flexcan_state_t *flexcanState);
+void can_lld_fifo_rx_func(void);
+bool can_lld_rx_get(can_lld_rx_frame_t *frame);
+bool can_lld_rx_wait(can_lld_rx_frame_t *frame, TickType_t timeout);
+uint32_t can_lld_rx_pending(void);
+
+#endif
@@ -0,0 +1,675 @@
+/* Host simulation of the TX mailbox pool and the priority queue of can_lld.c.
+ *
+ * can_lld.c is built as it is on a stub FlexCAN driver whose TX mailboxes
+ * take part in a discrete event model of a 500 kbit/s bus: the lowest
+ * arbitration key of all pending mailboxes and of the foreign nodes wins,
+ * a frame takes its length with worst case stuffing plus the intermission
+ * (276 us for 8 bytes), and an abort of the mailbox on the wire fails and
+ * lets the frame finish like on FlexCAN. The old can_lld_tx() with one
+ * mailbox, aborted before every send, is modelled next to it.
+ *
+ *   - saturated: 40 IDs every 5 ms, 8000 frames/s for a bus of about 3600
+ *   - an ECU set of 16 periodic IDs with a burst of 20 diagnostic frames
+ *     every 50 ms, alone and with foreign nodes whose IDs lie in between
+ *
+ * Each frame carries a number, so the bus sees every duplicate, every
+ * frame lost in a mailbox and every reorder within an ID. With the pool a
+ * frame is either sent or refused with STATUS_BUSY, never lost, and the bus
+ * is busy all the time when saturated. With CAN_LLD_TX_CANCEL_ENABLE the
+ * highest priority ID waits at most for the frame on the wire. A frame
+ * longer than 8 bytes must be refused. Exit status 1 on a failed check.
+ *
+ * build: gcc -O2 -Wall -I.. -I../../S32K144_057_CAN_socketcan/host
+ *            -o can_tx_bus_sim can_tx_bus_sim.c ../can_lld.c
+ *        add -DCAN_LLD_TX_CANCEL_ENABLE=0 for the pool without cancel
+ * usage: can_tx_bus_sim [-t seconds]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "can_lld.h"
+#include "lpspiCom1.h"
+#include "sbc_uja116x1.h"
+#include "Cpu.h"
+
+/* 500 kbit/s */
+#define SIM_BIT_US 2U
+/* intermission between two frames */
+#define SIM_IFS_BITS 3U
+#define SIM_MB_NUM 16U
+/* the mailbox of the old can_lld_tx() */
+#define SIM_OLD_MB 10U
+#define SIM_MSG_MAX 64U
+#define SIM_UID_MAX 4000000U
+#define SIM_NO_MB 0xFFFFFFFFU
+
+typedef struct
+{
+    bool pending;
+    bool ext;
+    uint32_t key;
+    uint32_t len;
+    uint32_t uid;
+} sim_mb_t;
+
+typedef struct
+{
+    uint32_t id;
+    bool ext;
+    uint32_t period_us;
+    uint64_t next;
+    uint32_t sent;
+    uint64_t latency_sum;
+    uint64_t latency_max;
+    bool seen;
+    uint32_t last_uid;
+} sim_msg_t;
+
+typedef struct
+{
+    uint32_t id;
+    uint32_t period_us;
+    uint64_t next;
+    bool pending;
+} sim_foreign_t;
+
+typedef enum
+{
+    SIM_UID_WAITING = 0,
+    SIM_UID_SENT,
+    SIM_UID_LOST,
+    SIM_UID_REFUSED
+} sim_uid_state_t;
+
+static uint32_t test_error = 0U;
+static uint32_t test_check_num = 0U;
+
+#define TEST_CHECK(cond, ...) do { test_check_num++; if (!(cond)) { printf("FAIL: " __VA_ARGS__); printf("\n"); test_error++; } } while (0)
+
+/* SDK and FreeRTOS, as far as can_lld.c uses them */
+
+flexcan_state_t canCom1_State;
+const flexcan_user_config_t canCom1_InitConfig0;
+lpspi_state_t lpspiCom1State;
+const lpspi_master_config_t lpspiCom1_MasterConfig0;
+const sbc_int_config_t sbc_uja116x1_InitConfig0;
+static CAN_Type sim_can0;
+static flexcan_callback_t sim_callback;
+
+static sim_mb_t sim_mb[SIM_MB_NUM];
+static uint32_t sim_wire_mb = SIM_NO_MB;    /* our mailbox on the wire */
+static bool sim_wire_aborted;               /* its abort took TX_COMPLETE */
+static uint64_t sim_now;                    /* us */
+
+static sim_msg_t sim_msg[SIM_MSG_MAX];
+static uint32_t sim_msg_num;
+static sim_foreign_t sim_foreign[SIM_MSG_MAX];
+static uint32_t sim_foreign_num;
+static uint64_t *sim_uid_time;
+static uint16_t *sim_uid_msg;
+static uint8_t *sim_uid_state;
+static uint32_t sim_uid_num;
+static uint32_t sim_sent;
+static uint32_t sim_foreign_sent;
+static uint32_t sim_dup;
+static uint32_t sim_lost;
+static uint32_t sim_order_error;
+static bool sim_old;
+
+CAN_Type *flexcan_host_regs(void)
+{
+    return &sim_can0;
+}
+
+status_t LPSPI_DRV_MasterInit(uint32_t instance, lpspi_state_t *lpspiState, const lpspi_master_config_t *spiConfig)
+{
+    (void)instance;
+    (void)lpspiState;
+    (void)spiConfig;
+    return STATUS_SUCCESS;
+}
+
+status_t SBC_Init(const sbc_int_config_t *const config, const uint32_t lpspiInstance)
+{
+    (void)config;
+    (void)lpspiInstance;
+    return STATUS_SUCCESS;
+}
+
+void INT_SYS_SetPriority(IRQn_Type irqNumber, uint8_t priority)
+{
+    (void)irqNumber;
+    (void)priority;
+}
+
+void vPortEnterCritical(void)
+{
+}
+
+void vPortExitCritical(void)
+{
+}
+
+void FLEXCAN_DRV_GetDefaultConfig(flexcan_user_config_t *config)
+{
+    memset(config, 0, sizeof(*config));
+}
+
+status_t FLEXCAN_DRV_Init(uint8_t instance, flexcan_state_t *state, const flexcan_user_config_t *data)
+{
+    (void)instance;
+    (void)state;
+    (void)data;
+    return STATUS_SUCCESS;
+}
+
+void FLEXCAN_DRV_ConfigRxFifo(uint8_t instance, flexcan_rx_fifo_id_element_format_t id_format,
+                              const flexcan_id_table_t *id_filter_table)
+{
+    (void)instance;
+    (void)id_format;
+    (void)id_filter_table;
+}
+
+void FLEXCAN_DRV_SetRxFifoGlobalMask(uint8_t instance, flexcan_msgbuff_id_type_t id_type, uint32_t mask)
+{
+    (void)instance;
+    (void)id_type;
+    (void)mask;
+}
+
+void FLEXCAN_DRV_InstallEventCallback(uint8_t instance, flexcan_callback_t callback, void *callbackParam)
+{
+    (void)instance;
+    (void)callbackParam;
+    sim_callback = callback;
+}
+
+status_t FLEXCAN_DRV_RxFifo(uint8_t instance, flexcan_msgbuff_t *data)
+{
+    (void)instance;
+    (void)data;
+    return STATUS_SUCCESS;
+}
+
+uint32_t FLEXCAN_DRV_GetErrorStatus(uint8_t instance)
+{
+    (void)instance;
+    return 0U;
+}
+
+void FLEXCAN_ClearErrIntStatusFlag(CAN_Type *base)
+{
+    (void)base;
+}
+
+TickType_t xTaskGetTickCountFromISR(void)
+{
+    return (TickType_t)((sim_now * configTICK_RATE_HZ) / 1000000U);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return NULL;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    (void)xTaskToNotify;
+    (void)pxHigherPriorityTaskWoken;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait)
+{
+    (void)xClearCountOnExit;
+    (void)xTicksToWait;
+    return 0U;
+}
+
+/* arbitration key: the 11 base bits, then IDE, then the 18 extended bits */
+static uint32_t sim_key(uint32_t id, bool ext)
+{
+    return ext ? (((id >> 18) << 19) | (1UL << 18) | (id & 0x3FFFFU)) : ((id & 0x7FFU) << 19);
+}
+
+status_t FLEXCAN_DRV_ConfigTxMb(uint8_t instance, uint8_t mb_idx, const flexcan_data_info_t *tx_info, uint32_t msg_id)
+{
+    (void)instance;
+    (void)mb_idx;
+    (void)tx_info;
+    (void)msg_id;
+    return STATUS_SUCCESS;
+}
+
+status_t FLEXCAN_DRV_Send(uint8_t instance, uint8_t mb_idx, const flexcan_data_info_t *tx_info, uint32_t msg_id,
+                          const uint8_t *mb_data)
+{
+    sim_mb_t *mb = &sim_mb[mb_idx];
+
+    (void)instance;
+    if (mb->pending || ((sim_wire_mb == mb_idx) && !sim_wire_aborted))
+    {
+        return STATUS_BUSY;
+    }
+    mb->pending = true;
+    mb->ext = tx_info->msg_id_type == FLEXCAN_MSG_ID_EXT;
+    mb->key = sim_key(msg_id, mb->ext);
+    mb->len = tx_info->data_length;
+    memcpy(&mb->uid, mb_data, sizeof(mb->uid));
+    return STATUS_SUCCESS;
+}
+
+/* a frame on the wire is finished by FlexCAN, the abort fails */
+status_t FLEXCAN_DRV_AbortTransfer(uint8_t instance, uint8_t mb_idx)
+{
+    (void)instance;
+    if (sim_wire_mb == mb_idx)
+    {
+        sim_wire_aborted = true;
+        return STATUS_CAN_NO_TRANSFER_IN_PROGRESS;
+    }
+    if (!sim_mb[mb_idx].pending)
+    {
+        return STATUS_CAN_NO_TRANSFER_IN_PROGRESS;
+    }
+    sim_mb[mb_idx].pending = false;
+    return STATUS_SUCCESS;
+}
+
+/* the bus */
+
+/* bits of a data frame with worst case stuffing, without the intermission */
+static uint32_t sim_frame_bits(bool ext, uint32_t len)
+{
+    const uint32_t bits = (ext ? 67U : 47U) + (8U * len);
+    const uint32_t stuffed = (ext ? 54U : 34U) + (8U * len);
+
+    return bits + ((stuffed - 1U) / 4U);
+}
+
+/* the old can_lld_tx(): MB10 only, whatever still waits in it is aborted */
+static void sim_old_tx(uint32_t id, const uint8_t *data)
+{
+    flexcan_data_info_t info;
+
+    memset(&info, 0, sizeof(info));
+    info.msg_id_type = FLEXCAN_MSG_ID_STD;
+    info.data_length = 8U;
+    if (sim_mb[SIM_OLD_MB].pending)
+    {
+        sim_mb[SIM_OLD_MB].pending = false;
+        sim_uid_state[sim_mb[SIM_OLD_MB].uid] = SIM_UID_LOST;
+        sim_lost++;
+    }
+    else if (sim_wire_mb == SIM_OLD_MB)
+    {
+        sim_wire_aborted = true;
+    }
+    (void)FLEXCAN_DRV_Send(INST_CANCOM1, SIM_OLD_MB, &info, id, data);
+}
+
+static void sim_release(uint32_t i)
+{
+    uint8_t data[8] = {0U};
+    const uint32_t uid = sim_uid_num++;
+
+    memcpy(data, &uid, sizeof(uid));
+    sim_uid_time[uid] = sim_now;
+    sim_uid_msg[uid] = (uint16_t)i;
+    sim_uid_state[uid] = SIM_UID_WAITING;
+    if (sim_old)
+    {
+        sim_old_tx(sim_msg[i].id, data);
+    }
+    else if (can_lld_tx(sim_msg[i].id | (sim_msg[i].ext ? CAN_LLD_TX_ID_EXT : 0U), data, 8U) != STATUS_SUCCESS)
+    {
+        sim_uid_state[uid] = SIM_UID_REFUSED;
+    }
+}
+
+static void sim_done(uint32_t uid)
+{
+    sim_msg_t *msg = &sim_msg[sim_uid_msg[uid]];
+    uint64_t latency;
+
+    if (sim_uid_state[uid] != SIM_UID_WAITING)
+    {
+        sim_dup++;
+        return;
+    }
+    sim_uid_state[uid] = SIM_UID_SENT;
+    sim_sent++;
+    if (msg->seen && (uid < msg->last_uid))
+    {
+        sim_order_error++;
+    }
+    msg->seen = true;
+    msg->last_uid = uid;
+    latency = sim_now - sim_uid_time[uid];
+    msg->sent++;
+    msg->latency_sum += latency;
+    if (latency > msg->latency_max)
+    {
+        msg->latency_max = latency;
+    }
+}
+
+static uint64_t sim_next_event(void)
+{
+    uint64_t t = UINT64_MAX;
+    uint32_t i;
+
+    for (i = 0U; i < sim_msg_num; i++)
+    {
+        t = (sim_msg[i].next < t) ? sim_msg[i].next : t;
+    }
+    for (i = 0U; i < sim_foreign_num; i++)
+    {
+        t = (sim_foreign[i].next < t) ? sim_foreign[i].next : t;
+    }
+    return t;
+}
+
+/* release all frames due up to and including until */
+static void sim_events(uint64_t until)
+{
+    uint64_t t;
+    uint32_t i;
+
+    for (t = sim_next_event(); t <= until; t = sim_next_event())
+    {
+        sim_now = t;
+        for (i = 0U; i < sim_msg_num; i++)
+        {
+            if (sim_msg[i].next == t)
+            {
+                sim_release(i);
+                sim_msg[i].next += sim_msg[i].period_us;
+            }
+        }
+        for (i = 0U; i < sim_foreign_num; i++)
+        {
+            if (sim_foreign[i].next == t)
+            {
+                sim_foreign[i].pending = true;
+                sim_foreign[i].next += sim_foreign[i].period_us;
+            }
+        }
+    }
+    sim_now = until;
+}
+
+static void sim_add(uint32_t id, uint32_t period_us, uint64_t first)
+{
+    sim_msg_t *msg = &sim_msg[sim_msg_num++];
+
+    memset(msg, 0, sizeof(*msg));
+    msg->id = id;
+    msg->period_us = period_us;
+    msg->next = first;
+}
+
+/* @brief: Set up a message set, the driver and the bus
+ * @param set : 0 saturated, 1 ECU set, 2 ECU set with foreign nodes
+ * @return    : None
+ */
+static void sim_setup(uint32_t set)
+{
+    static const uint32_t ecu_id[16] = {0x080U, 0x0C0U, 0x180U, 0x200U, 0x280U, 0x300U, 0x380U, 0x400U,
+                                        0x480U, 0x500U, 0x580U, 0x600U, 0x680U, 0x700U, 0x780U, 0x7C0U};
+    static const uint32_t ecu_period_ms[16] = {2U, 4U, 10U, 10U, 20U, 20U, 20U, 40U,
+                                               40U, 40U, 100U, 100U, 200U, 200U, 200U, 200U};
+    uint32_t i;
+
+    sim_msg_num = 0U;
+    sim_foreign_num = 0U;
+    if (set == 0U)
+    {
+        for (i = 0U; i < 40U; i++)
+        {
+            sim_add(0x100U + (i * 8U), 5000U, (i % 5U) * 1000U);
+        }
+    }
+    else
+    {
+        for (i = 0U; i < 16U; i++)
+        {
+            sim_add(ecu_id[i], ecu_period_ms[i] * 1000U, 0U);
+        }
+        for (i = 0U; i < 20U; i++)
+        {
+            sim_add(0x7E0U + (i % 8U), 50000U, 3000U);
+        }
+    }
+    if (set == 2U)
+    {
+        for (i = 0U; i < 12U; i++)
+        {
+            sim_foreign[i].id = 0x0A0U + (i * 0x80U);
+            sim_foreign[i].period_us = 10000U + (i * 173U);
+            sim_foreign[i].next = 137U * i;
+            sim_foreign[i].pending = false;
+        }
+        sim_foreign_num = 12U;
+    }
+
+    memset(sim_mb, 0, sizeof(sim_mb));
+    sim_wire_mb = SIM_NO_MB;
+    sim_wire_aborted = false;
+    sim_now = 0U;
+    sim_uid_num = 0U;
+    sim_sent = 0U;
+    sim_foreign_sent = 0U;
+    sim_dup = 0U;
+    sim_lost = 0U;
+    sim_order_error = 0U;
+    can_lld_tx_frame_num = 0U;
+    can_lld_tx_complete_num = 0U;
+    can_lld_tx_queue_full_num = 0U;
+    can_lld_tx_queue_peak = 0U;
+    can_lld_tx_cancel_num = 0U;
+    can_lld_tx_error_num = 0U;
+}
+
+/* @brief: Put the next frame on the bus, or wait for the next release
+ * @return: bus time of the frame, 0 if the bus was idle
+ */
+static uint32_t sim_bus_step(void)
+{
+    uint32_t mb_best = SIM_NO_MB;
+    int32_t foreign_best = -1;
+    uint32_t key_best = UINT32_MAX;
+    uint32_t duration;
+    uint32_t i;
+    sim_mb_t frame;
+
+    sim_events(sim_now);
+    /* arbitration, lowest mailbox first on a tie like FlexCAN */
+    for (i = 0U; i < SIM_MB_NUM; i++)
+    {
+        if (sim_mb[i].pending && (sim_mb[i].key < key_best))
+        {
+            key_best = sim_mb[i].key;
+            mb_best = i;
+        }
+    }
+    for (i = 0U; i < sim_foreign_num; i++)
+    {
+        if (sim_foreign[i].pending && (sim_key(sim_foreign[i].id, false) < key_best))
+        {
+            key_best = sim_key(sim_foreign[i].id, false);
+            foreign_best = (int32_t)i;
+        }
+    }
+
+    if (foreign_best >= 0)
+    {
+        sim_foreign[foreign_best].pending = false;
+        duration = SIM_BIT_US * (sim_frame_bits(false, 8U) + SIM_IFS_BITS);
+        sim_events(sim_now + duration);
+        sim_foreign_sent++;
+    }
+    else if (mb_best != SIM_NO_MB)
+    {
+        frame = sim_mb[mb_best];
+        sim_mb[mb_best].pending = false;
+        sim_wire_mb = mb_best;
+        sim_wire_aborted = false;
+        duration = SIM_BIT_US * (sim_frame_bits(frame.ext, frame.len) + SIM_IFS_BITS);
+        sim_events(sim_now + duration);
+        sim_wire_mb = SIM_NO_MB;
+        sim_done(frame.uid);
+        if (!sim_wire_aborted && !sim_old)
+        {
+            sim_callback(INST_CANCOM1, FLEXCAN_EVENT_TX_COMPLETE, mb_best, &canCom1_State);
+        }
+    }
+    else
+    {
+        sim_now = sim_next_event();
+        duration = 0U;
+    }
+    return duration;
+}
+
+/* @brief: Run the bus, then stop the releases and send what is left so the
+ *         driver is idle for the next run
+ * @param set     : message set, see sim_setup()
+ * @param old     : the old single mailbox can_lld_tx() instead of the pool
+ * @param seconds : bus time
+ * @return        : None
+ */
+static void sim_run(uint32_t set, bool old, uint32_t seconds)
+{
+    static const char *const set_name[3] = {"saturated", "ECU set", "ECU set + foreign"};
+    const uint64_t end = (uint64_t)seconds * 1000000U;
+    const uint32_t wire_max = SIM_BIT_US * (sim_frame_bits(false, 8U) + SIM_IFS_BITS);
+    uint64_t busy = 0U;
+    uint64_t bus_time;
+    uint32_t sent;
+    uint32_t refused = 0U;
+    uint32_t waiting = 0U;
+    uint32_t uid;
+    uint32_t i;
+
+    sim_old = old;
+    sim_setup(set);
+    while (sim_now < end)
+    {
+        busy += sim_bus_step();
+    }
+    bus_time = sim_now;
+    sent = sim_sent;
+
+    for (i = 0U; i < sim_msg_num; i++)
+    {
+        sim_msg[i].next = UINT64_MAX;
+    }
+    for (i = 0U; i < sim_foreign_num; i++)
+    {
+        sim_foreign[i].next = UINT64_MAX;
+        sim_foreign[i].pending = false;
+    }
+    for (i = 0U; i < SIM_MB_NUM; i++)
+    {
+        if (sim_mb[i].pending)
+        {
+            (void)sim_bus_step();
+            i = UINT32_MAX;
+        }
+    }
+
+    for (uid = 0U; uid < sim_uid_num; uid++)
+    {
+        refused += (sim_uid_state[uid] == SIM_UID_REFUSED) ? 1U : 0U;
+        waiting += (sim_uid_state[uid] == SIM_UID_WAITING) ? 1U : 0U;
+    }
+    printf("%-17s %-6s: %7u frames (%.0f/s), %u foreign, load %5.1f%%, %u lost, %u refused, %u cancelled, "
+           "%u dup, %u reordered, %u driver errors\n",
+           set_name[set], old ? "old" : "pool", sent, (double)sent / (double)seconds, sim_foreign_sent,
+           (100.0 * (double)busy) / (double)bus_time, sim_lost, refused, can_lld_tx_cancel_num, sim_dup,
+           sim_order_error, can_lld_tx_error_num);
+    if (set != 0U)
+    {
+        printf("    ID   period   sent     avg us   worst us\n");
+        for (i = 0U; i < 16U; i++)
+        {
+            printf("  0x%03X %6u %7u %10.0f %10llu\n", sim_msg[i].id, sim_msg[i].period_us, sim_msg[i].sent,
+                   (sim_msg[i].sent != 0U) ? ((double)sim_msg[i].latency_sum / (double)sim_msg[i].sent) : 0.0,
+                   (unsigned long long)sim_msg[i].latency_max);
+        }
+    }
+    if (old)
+    {
+        return;
+    }
+
+    TEST_CHECK(sim_dup == 0U, "%s: %u frames sent twice", set_name[set], sim_dup);
+    TEST_CHECK(sim_lost == 0U, "%s: %u frames lost", set_name[set], sim_lost);
+    TEST_CHECK(sim_order_error == 0U, "%s: %u frames reordered within their ID", set_name[set], sim_order_error);
+    TEST_CHECK(can_lld_tx_error_num == 0U, "%s: %u driver errors", set_name[set], can_lld_tx_error_num);
+    /* after the releases stop, everything not refused has been sent */
+    TEST_CHECK((waiting == 0U) && (can_lld_tx_pending() == 0U), "%s: %u frames never sent, %u pending",
+               set_name[set], waiting, can_lld_tx_pending());
+    if (set == 0U)
+    {
+        TEST_CHECK(busy >= (bus_time - wire_max), "%s: bus idle for %llu us", set_name[set],
+                   (unsigned long long)(bus_time - busy));
+    }
+    else
+    {
+        TEST_CHECK(refused == 0U, "%s: %u frames refused", set_name[set], refused);
+#if CAN_LLD_TX_CANCEL_ENABLE
+        /* the highest priority ID waits for the frame on the wire at most */
+        TEST_CHECK(sim_msg[0].latency_max <= (2U * wire_max), "%s: 0x%03X waited %llu us", set_name[set],
+                   sim_msg[0].id, (unsigned long long)sim_msg[0].latency_max);
+#endif
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const uint8_t data[CAN_LLD_TX_QUEUE_SIZE] = {0U};
+    uint32_t seconds = 10U;
+    uint32_t set;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:")) != -1)
+    {
+        switch (opt)
+        {
+        case 't':
+            seconds = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-t seconds]\n", argv[0]);
+            return 2;
+        }
+    }
+    sim_uid_time = calloc(SIM_UID_MAX, sizeof(*sim_uid_time));
+    sim_uid_msg = calloc(SIM_UID_MAX, sizeof(*sim_uid_msg));
+    sim_uid_state = calloc(SIM_UID_MAX, sizeof(*sim_uid_state));
+    if ((sim_uid_time == NULL) || (sim_uid_msg == NULL) || (sim_uid_state == NULL) ||
+        (((uint64_t)seconds * 8000U) >= SIM_UID_MAX))
+    {
+        fprintf(stderr, "%u s do not fit\n", seconds);
+        return 2;
+    }
+
+    printf("TX pool of %u mailboxes, queue of %u, cancel %s\n", CAN_LLD_TX_MB_NUM, CAN_LLD_TX_QUEUE_SIZE,
+           CAN_LLD_TX_CANCEL_ENABLE ? "on" : "off");
+    can_lld_init();
+    TEST_CHECK(can_lld_tx(0x123U, data, 9U) == STATUS_ERROR, "9 bytes not refused");
+    TEST_CHECK(can_lld_tx_pending() == 0U, "a refused frame was queued");
+    for (set = 0U; set < 3U; set++)
+    {
+        sim_run(set, true, seconds);
+        sim_run(set, false, seconds);
+    }
+    free(sim_uid_time);
+    free(sim_uid_msg);
+    free(sim_uid_state);
+    printf("%s, %u checks, %u errors\n", (test_error == 0U) ? "PASS" : "FAIL", test_check_num, test_error);
+    return (test_error == 0U) ? 0 : 1;
+}
@@ -0,0 +1,14 @@
+/* generated by tools/can_filter_gen from can_filter.def, do not edit */
+#ifndef CAN_LLD_FILTER_H
+#define CAN_LLD_FILTER_H
+
+/* 0 of 1955 unsubscribed standard IDs and 0 extended IDs pass */
+#define CAN_LLD_FILTER_FORMAT FLEXCAN_RX_FIFO_ID_FORMAT_A
+/* ID filter table elements, num_id_filters of the FlexCAN configuration */
+#define CAN_LLD_FILTER_ELEMENT_NUM 8U
+/* entries of can_lld_filter_table, 1 per element */
+#define CAN_LLD_FILTER_ID_NUM 8U
+/* dedicated RX mailboxes, taken from the top of the TX pool */
+#define CAN_LLD_FILTER_RX_MB_NUM 2U
+
+#endif
@@ -0,0 +1,1040 @@
+/* Host side compiler for the FlexCAN RX FIFO acceptance filters.
+ *
+ * can_filter.def lists the CAN IDs and ID ranges the application reads. They
+ * are turned into the RX FIFO ID filter table, one individual mask per table
+ * element (MCR[IRMQ] = 1) and optionally a few dedicated RX mailboxes. Format
+ * A, B and C are all tried within the same number of table elements, the one
+ * which lets the fewest unwanted IDs through is written out. A subscribed ID
+ * is never rejected, filters are only widened to fit the budget.
+ *
+ * With -r the result is replayed against a bus capture (candump -L format) on
+ * a model of the FlexCAN matching that works on the generated register words.
+ * Frames of the capture weigh more than the plain ID space when filters are
+ * merged, and the report shows how many RX interrupts the hardware saves.
+ *
+ * build: gcc -O2 -o can_filter_gen can_filter_gen.c
+ * usage: can_filter_gen [-e elements] [-m rx_mb] [-r capture.log] [-c irq_us]
+ *                       can_filter.def can_lld_filter.h can_lld_filter.inc
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#define LINE_SIZE 256U
+#define PATTERN_MAX 1024U
+
+/* IDs are kept in 29 bits, a standard ID sits in the base ID bits 28:18 of an
+ * extended one. All three FIFO formats compare the top bits of this layout */
+#define ID_STD_SHIFT 18U
+#define ID_EXT_ALL 0x1FFFFFFFU
+#define ID_STD_ALL (0x7FFU << ID_STD_SHIFT)
+
+typedef struct
+{
+    bool ext;           /* IDE of the frames it accepts */
+    bool any;           /* IDE is not compared, format C */
+    uint32_t value;
+    uint32_t mask;      /* 1 = bit compared */
+} pattern_t;
+
+typedef struct
+{
+    const char *name;
+    const char *sdk;
+    uint32_t per_element;   /* IDs per table element */
+    uint32_t std_bits;      /* compared bits of a standard ID */
+    uint32_t ext_bits;      /* compared bits of an extended ID */
+    bool ide;               /* IDE and RTR are compared */
+} format_t;
+
+static const format_t formats[] = {
+    {"A", "FLEXCAN_RX_FIFO_ID_FORMAT_A", 1U, 11U, 29U, true},
+    {"B", "FLEXCAN_RX_FIFO_ID_FORMAT_B", 2U, 11U, 14U, true},
+    {"C", "FLEXCAN_RX_FIFO_ID_FORMAT_C", 4U, 8U, 8U, false},
+};
+
+/* false accepts, capture frames first, then the plain ID space */
+typedef struct
+{
+    int64_t frames;
+    int64_t ids;
+} cost_t;
+
+typedef struct
+{
+    bool ext;
+    bool rtr;
+    uint32_t id;        /* 29 bit layout */
+    uint64_t num;
+    bool subscribed;
+} capture_id_t;
+
+typedef struct
+{
+    const format_t *fmt;
+    pattern_t fifo[PATTERN_MAX];
+    uint32_t fifo_num;
+    pattern_t mb[PATTERN_MAX];
+    uint32_t mb_num;
+    cost_t cost;
+    uint64_t std_false;
+    uint64_t ext_false;
+} result_t;
+
+static pattern_t subs[PATTERN_MAX];
+static uint32_t subs_num;
+static uint64_t subs_std_num;
+static uint64_t subs_ext_num;
+static capture_id_t *cap;
+static uint32_t cap_num;
+static uint64_t cap_frames;
+static double cap_first_ts;
+static double cap_last_ts;
+
+static const char *def_path;
+static unsigned int def_line;
+
+static void fail(const char *msg)
+{
+    fprintf(stderr, "%s:%u: %s\n", def_path, def_line, msg);
+    exit(1);
+}
+
+static uint32_t top_bits(uint32_t bits)
+{
+    return ID_EXT_ALL & ~((1UL << (29U - bits)) - 1UL);
+}
+
+static bool pattern_in_space(const pattern_t *p, bool ext)
+{
+    return p->any || (p->ext == ext);
+}
+
+static bool pattern_match(const pattern_t *p, bool ext, uint32_t id)
+{
+    return pattern_in_space(p, ext) && (((id ^ p->value) & p->mask) == 0U);
+}
+
+/* number of IDs of the space (bits of rem) accepted by at least one pattern,
+ * the patterns are split on their highest compared bit */
+static uint64_t union_count(const pattern_t *set, uint32_t n, uint32_t rem)
+{
+    uint32_t used = 0U;
+    uint32_t bit;
+    uint32_t i;
+    uint32_t n0 = 0U;
+    uint32_t n1 = 0U;
+    pattern_t *half;
+    uint64_t count;
+
+    if (n == 0U)
+    {
+        return 0U;
+    }
+    for (i = 0U; i < n; i++)
+    {
+        if ((set[i].mask & rem) == 0U)
+        {
+            return 1ULL << __builtin_popcount(rem);
+        }
+        used |= set[i].mask & rem;
+    }
+
+    bit = 1UL << (31 - __builtin_clz(used));
+    half = malloc(2U * n * sizeof(pattern_t));
+    for (i = 0U; i < n; i++)
+    {
+        if (((set[i].mask & bit) == 0U) || ((set[i].value & bit) == 0U))
+        {
+            half[n0++] = set[i];
+        }
+        if (((set[i].mask & bit) == 0U) || ((set[i].value & bit) != 0U))
+        {
+            half[n + n1++] = set[i];
+        }
+    }
+    count = union_count(half, n0, used & ~bit) + union_count(&half[n], n1, used & ~bit);
+    free(half);
+
+    return count << __builtin_popcount(rem & ~used);
+}
+
+/* patterns of set that can match in the space, restricted to its bits. A
+ * standard frame has zeros below the base ID */
+static uint32_t space_select(const pattern_t *set, uint32_t n, bool ext, pattern_t *out)
+{
+    uint32_t space = ext ? ID_EXT_ALL : ID_STD_ALL;
+    uint32_t num = 0U;
+    uint32_t i;
+
+    for (i = 0U; i < n; i++)
+    {
+        if (!pattern_in_space(&set[i], ext) || ((set[i].value & set[i].mask & ~space) != 0U))
+        {
+            continue;
+        }
+        out[num] = set[i];
+        out[num].mask &= space;
+        num++;
+    }
+    return num;
+}
+
+static uint64_t set_count(const pattern_t *set, uint32_t n, bool ext)
+{
+    static pattern_t tmp[2U * PATTERN_MAX];
+    uint32_t num = space_select(set, n, ext, tmp);
+
+    return union_count(tmp, num, ext ? ID_EXT_ALL : ID_STD_ALL);
+}
+
+/* unsubscribed IDs accepted by one pattern */
+static uint64_t pattern_false_ids(const pattern_t *p)
+{
+    static pattern_t tmp[PATTERN_MAX];
+    uint64_t total = 0U;
+    uint32_t num;
+    uint32_t i;
+    int space;
+
+    for (space = 0; space < 2; space++)
+    {
+        if (!pattern_in_space(p, space != 0))
+        {
+            continue;
+        }
+        total += set_count(p, 1U, space != 0);
+        num = 0U;
+        for (i = 0U; i < subs_num; i++)
+        {
+            /* intersection of two ternary patterns */
+            if (!pattern_in_space(&subs[i], space != 0) ||
+                (((subs[i].value ^ p->value) & subs[i].mask & p->mask) != 0U))
+            {
+                continue;
+            }
+            tmp[num] = subs[i];
+            tmp[num].value = (subs[i].value & subs[i].mask) | (p->value & p->mask);
+            tmp[num].mask = subs[i].mask | p->mask;
+            num++;
+        }
+        total -= set_count(tmp, num, space != 0);
+    }
+    return total;
+}
+
+static uint64_t pattern_false_frames(const pattern_t *p)
+{
+    uint64_t total = 0U;
+    uint32_t i;
+
+    for (i = 0U; i < cap_num; i++)
+    {
+        if (!cap[i].subscribed && !cap[i].rtr && pattern_match(p, cap[i].ext, cap[i].id))
+        {
+            total += cap[i].num;
+        }
+    }
+    return total;
+}
+
+static cost_t pattern_cost(const pattern_t *p)
+{
+    cost_t cost;
+
+    cost.frames = (int64_t)pattern_false_frames(p);
+    cost.ids = (int64_t)pattern_false_ids(p);
+    return cost;
+}
+
+static bool cost_less(cost_t a, cost_t b)
+{
+    return (a.frames < b.frames) || ((a.frames == b.frames) && (a.ids < b.ids));
+}
+
+static bool pattern_covers(const pattern_t *outer, const pattern_t *inner)
+{
+    return (outer->any || (!inner->any && (outer->ext == inner->ext))) &&
+           ((outer->mask & ~inner->mask) == 0U) &&
+           (((outer->value ^ inner->value) & outer->mask) == 0U);
+}
+
+static bool pattern_merge(const pattern_t *a, const pattern_t *b, pattern_t *out)
+{
+    if (!a->any && !b->any && (a->ext != b->ext))
+    {
+        /* IDE stays compared in format A and B */
+        return false;
+    }
+    out->ext = a->ext;
+    out->any = a->any || b->any;
+    out->mask = a->mask & b->mask & ~(a->value ^ b->value);
+    out->value = a->value & out->mask;
+    return true;
+}
+
+/* drop duplicates and patterns covered by another one */
+static uint32_t pattern_reduce(pattern_t *set, uint32_t n)
+{
+    uint32_t i;
+    uint32_t j;
+    uint32_t num = 0U;
+    bool covered;
+
+    for (i = 0U; i < n; i++)
+    {
+        covered = false;
+        for (j = 0U; j < n; j++)
+        {
+            if ((i != j) && pattern_covers(&set[j], &set[i]) &&
+                (!pattern_covers(&set[i], &set[j]) || (j < i)))
+            {
+                covered = true;
+                break;
+            }
+        }
+        if (!covered)
+        {
+            set[num++] = set[i];
+        }
+    }
+    return num;
+}
+
+/* merge the pair that adds the fewest false accepts until n <= target */
+static uint32_t pattern_cluster(pattern_t *set, uint32_t n, uint32_t target)
+{
+    static cost_t alone[PATTERN_MAX];
+    pattern_t merged;
+    pattern_t best_merged;
+    cost_t cost;
+    cost_t best_cost;
+    uint32_t best_i;
+    uint32_t best_j;
+    uint32_t i;
+    uint32_t j;
+    bool found;
+
+    n = pattern_reduce(set, n);
+    while (n > target)
+    {
+        for (i = 0U; i < n; i++)
+        {
+            alone[i] = pattern_cost(&set[i]);
+        }
+        found = false;
+        best_i = 0U;
+        best_j = 0U;
+        best_cost.frames = INT64_MAX;
+        best_cost.ids = INT64_MAX;
+        for (i = 0U; i < n; i++)
+        {
+            for (j = i + 1U; j < n; j++)
+            {
+                if (!pattern_merge(&set[i], &set[j], &merged))
+                {
+                    continue;
+                }
+                cost = pattern_cost(&merged);
+                /* false accepts added by the merge, an overlap of i and j
+                 * is counted twice */
+                cost.frames -= alone[i].frames + alone[j].frames;
+                cost.ids -= alone[i].ids + alone[j].ids;
+                if (!found || cost_less(cost, best_cost))
+                {
+                    found = true;
+                    best_cost = cost;
+                    best_merged = merged;
+                    best_i = i;
+                    best_j = j;
+                }
+            }
+        }
+        if (!found)
+        {
+            break;
+        }
+        set[best_i] = best_merged;
+        set[best_j] = set[--n];
+        n = pattern_reduce(set, n);
+    }
+    return n;
+}
+
+static pattern_t pattern_truncate(const pattern_t *p, const format_t *fmt)
+{
+    pattern_t t = *p;
+
+    t.mask &= top_bits(p->ext ? fmt->ext_bits : fmt->std_bits);
+    t.value &= t.mask;
+    t.any = !fmt->ide;
+    return t;
+}
+
+static void result_cost(result_t *res)
+{
+    static pattern_t all[2U * PATTERN_MAX];
+    uint32_t num = 0U;
+    uint32_t i;
+    uint32_t j;
+
+    memcpy(all, res->fifo, res->fifo_num * sizeof(pattern_t));
+    num = res->fifo_num;
+    memcpy(&all[num], res->mb, res->mb_num * sizeof(pattern_t));
+    num += res->mb_num;
+
+    res->std_false = set_count(all, num, false) - subs_std_num;
+    res->ext_false = set_count(all, num, true) - subs_ext_num;
+    res->cost.ids = (int64_t)(res->std_false + res->ext_false);
+    res->cost.frames = 0;
+    for (i = 0U; i < cap_num; i++)
+    {
+        if (cap[i].subscribed || cap[i].rtr)
+        {
+            continue;
+        }
+        for (j = 0U; j < num; j++)
+        {
+            if (pattern_match(&all[j], cap[i].ext, cap[i].id))
+            {
+                res->cost.frames += (int64_t)cap[i].num;
+                break;
+            }
+        }
+    }
+}
+
+static void compile(const format_t *fmt, uint32_t elements, uint32_t mb_num, result_t *res)
+{
+    static pattern_t set[PATTERN_MAX];
+    static cost_t loss[PATTERN_MAX];
+    uint32_t slots = elements * fmt->per_element;
+    uint32_t n;
+    uint32_t i;
+    uint32_t j;
+    pattern_t t;
+    cost_t full;
+
+    res->fmt = fmt;
+    res->fifo_num = 0U;
+    res->mb_num = 0U;
+    memcpy(set, subs, subs_num * sizeof(pattern_t));
+
+    if (mb_num == 0U)
+    {
+        for (i = 0U; i < subs_num; i++)
+        {
+            set[i] = pattern_truncate(&subs[i], fmt);
+        }
+        res->fifo_num = pattern_cluster(set, subs_num, slots);
+        memcpy(res->fifo, set, res->fifo_num * sizeof(pattern_t));
+    }
+    else
+    {
+        /* cluster with full precision for FIFO slots and mailboxes together,
+         * the patterns which lose most in the FIFO format get a mailbox */
+        n = pattern_cluster(set, subs_num, slots + mb_num);
+        for (i = 0U; i < n; i++)
+        {
+            t = pattern_truncate(&set[i], fmt);
+            loss[i] = pattern_cost(&t);
+            full = pattern_cost(&set[i]);
+            loss[i].frames -= full.frames;
+            loss[i].ids -= full.ids;
+        }
+        while ((res->mb_num < mb_num) && (n > 0U))
+        {
+            j = 0U;
+            for (i = 1U; i < n; i++)
+            {
+                if (cost_less(loss[j], loss[i]))
+                {
+                    j = i;
+                }
+            }
+            if ((loss[j].frames == 0) && (loss[j].ids == 0) && (n <= slots))
+            {
+                /* nothing to gain, keep the mailbox for TX */
+                break;
+            }
+            res->mb[res->mb_num] = set[j];
+            res->mb[res->mb_num].any = false;
+            res->mb_num++;
+            set[j] = set[--n];
+            loss[j] = loss[n];
+        }
+        for (i = 0U; i < n; i++)
+        {
+            set[i] = pattern_truncate(&set[i], fmt);
+        }
+        res->fifo_num = pattern_cluster(set, n, slots);
+        memcpy(res->fifo, set, res->fifo_num * sizeof(pattern_t));
+    }
+
+    result_cost(res);
+}
+
+/* ---- register words, same layout as the RX FIFO filter table ---- */
+
+static uint32_t std_id(const pattern_t *p)
+{
+    return p->value >> ID_STD_SHIFT;
+}
+
+/* the word of one table slot, filter == NULL builds the word of a received
+ * frame. The mask word uses the same bits */
+static uint32_t fifo_word(const format_t *fmt, uint32_t slot, bool ext, bool rtr, uint32_t id, bool mask)
+{
+    uint32_t word = 0U;
+    uint32_t flags = (rtr ? 2U : 0U) | (ext ? 1U : 0U);
+
+    if (mask)
+    {
+        flags = 3U;
+    }
+    if (fmt->per_element == 1U)
+    {
+        word = (flags << 30) | (ext ? (id << 1) : ((id >> ID_STD_SHIFT) << 19));
+    }
+    else if (fmt->per_element == 2U)
+    {
+        if (slot == 0U)
+        {
+            word = (flags << 30) | (ext ? ((id >> 15) << 16) : ((id >> ID_STD_SHIFT) << 19));
+        }
+        else
+        {
+            word = (flags << 14) | (ext ? (id >> 15) : ((id >> ID_STD_SHIFT) << 3));
+        }
+    }
+    else
+    {
+        word = ((id >> 21) & 0xFFU) << (24U - 8U * slot);
+    }
+    return word;
+}
+
+static uint32_t fifo_field(const format_t *fmt, uint32_t slot)
+{
+    if (fmt->per_element == 1U)
+    {
+        return 0xFFFFFFFFU;
+    }
+    if (fmt->per_element == 2U)
+    {
+        return (slot == 0U) ? 0xFFFF0000U : 0x0000FFFFU;
+    }
+    return 0xFFUL << (24U - 8U * slot);
+}
+
+typedef struct
+{
+    const format_t *fmt;
+    uint32_t elements;
+    uint32_t filter[256];
+    uint32_t mask[256];
+    bool mb_ext[PATTERN_MAX];
+    uint32_t mb_id[PATTERN_MAX];
+    uint32_t mb_mask[PATTERN_MAX];
+    uint32_t mb_num;
+} regs_t;
+
+/* pattern of a table slot, unused slots repeat the first one */
+static const pattern_t *slot_pattern(const result_t *res, uint32_t index)
+{
+    return (index < res->fifo_num) ? &res->fifo[index] : &res->fifo[0];
+}
+
+static void regs_build(const result_t *res, uint32_t elements, regs_t *regs)
+{
+    const format_t *fmt = res->fmt;
+    const pattern_t *p;
+    uint32_t e;
+    uint32_t s;
+    uint32_t i;
+
+    regs->fmt = fmt;
+    regs->elements = elements;
+    for (e = 0U; e < elements; e++)
+    {
+        regs->filter[e] = 0U;
+        regs->mask[e] = 0U;
+        for (s = 0U; s < fmt->per_element; s++)
+        {
+            p = slot_pattern(res, e * fmt->per_element + s);
+            regs->filter[e] |= fifo_word(fmt, s, p->ext, false, p->value, false);
+            regs->mask[e] |= fifo_word(fmt, s, p->ext, false, p->mask, true);
+        }
+    }
+    regs->mb_num = res->mb_num;
+    for (i = 0U; i < res->mb_num; i++)
+    {
+        p = &res->mb[i];
+        regs->mb_ext[i] = p->ext;
+        regs->mb_id[i] = p->ext ? p->value : std_id(p);
+        regs->mb_mask[i] = p->ext ? p->mask : (p->mask >> ID_STD_SHIFT);
+    }
+}
+
+/* 1 = RX FIFO, 2 = mailbox, 0 = rejected by the hardware */
+static int regs_accept(const regs_t *regs, bool ext, bool rtr, uint32_t id)
+{
+    const format_t *fmt = regs->fmt;
+    uint32_t frame;
+    uint32_t field;
+    uint32_t e;
+    uint32_t s;
+    uint32_t i;
+
+    for (e = 0U; e < regs->elements; e++)
+    {
+        for (s = 0U; s < fmt->per_element; s++)
+        {
+            field = fifo_field(fmt, s);
+            frame = fifo_word(fmt, s, ext, rtr, id, false);
+            if (((frame ^ regs->filter[e]) & regs->mask[e] & field) == 0U)
+            {
+                return 1;
+            }
+        }
+    }
+    for (i = 0U; i < regs->mb_num; i++)
+    {
+        if ((regs->mb_ext[i] == ext) && !rtr &&
+            (((ext ? id : (id >> ID_STD_SHIFT)) ^ regs->mb_id[i]) & regs->mb_mask[i]) == 0U)
+        {
+            return 2;
+        }
+    }
+    return 0;
+}
+
+/* ---- input ---- */
+
+static uint32_t parse_id(const char **p, uint32_t max)
+{
+    char *end;
+    unsigned long value = strtoul(*p, &end, 0);
+
+    if ((end == *p) || (value > max))
+    {
+        fail("bad CAN ID");
+    }
+    *p = end;
+    return (uint32_t)value;
+}
+
+/* a range becomes the aligned power of 2 blocks that cover it exactly */
+static void add_range(bool ext, uint32_t lo, uint32_t hi)
+{
+    uint32_t width = ext ? 29U : 11U;
+    uint32_t all = (1UL << width) - 1UL;
+    uint64_t size;
+    pattern_t *p;
+
+    while (lo <= hi)
+    {
+        size = (lo == 0U) ? (1ULL << width) : (uint64_t)(lo & (~lo + 1U));
+        while ((lo + size - 1U) > hi)
+        {
+            size >>= 1;
+        }
+        if (subs_num >= PATTERN_MAX)
+        {
+            fail("too many ID blocks");
+        }
+        p = &subs[subs_num++];
+        p->ext = ext;
+        p->any = false;
+        p->mask = all & ~(uint32_t)(size - 1U);
+        p->value = lo & p->mask;
+        if (!ext)
+        {
+            p->mask <<= ID_STD_SHIFT;
+            p->value <<= ID_STD_SHIFT;
+        }
+        if ((uint64_t)lo + size > all)
+        {
+            break;
+        }
+        lo += (uint32_t)size;
+    }
+}
+
+/* one ID or range per line, "x:" for 29 bit IDs, '#' starts a comment:
+ *   0x100-0x10F
+ *   x:0x18FEF100 */
+static void load_def(FILE *def)
+{
+    char line[LINE_SIZE];
+    const char *p;
+    bool ext;
+    uint32_t lo;
+    uint32_t hi;
+
+    while (fgets(line, sizeof(line), def) != NULL)
+    {
+        def_line++;
+        p = line;
+        while (isspace((unsigned char)*p))
+        {
+            p++;
+        }
+        if ((*p == '\0') || (*p == '#'))
+        {
+            continue;
+        }
+        ext = false;
+        if ((p[0] == 'x') && (p[1] == ':'))
+        {
+            ext = true;
+            p += 2;
+        }
+        lo = parse_id(&p, ext ? ID_EXT_ALL : 0x7FFU);
+        hi = lo;
+        if (*p == '-')
+        {
+            p++;
+            hi = parse_id(&p, ext ? ID_EXT_ALL : 0x7FFU);
+        }
+        while (isspace((unsigned char)*p))
+        {
+            p++;
+        }
+        if (((*p != '\0') && (*p != '#')) || (hi < lo))
+        {
+            fail("expected ID or ID-ID");
+        }
+        add_range(ext, lo, hi);
+    }
+    if (subs_num == 0U)
+    {
+        fail("no CAN ID subscribed");
+    }
+}
+
+static int capture_cmp(const void *a, const void *b)
+{
+    const capture_id_t *x = a;
+    const capture_id_t *y = b;
+
+    if (x->ext != y->ext)
+    {
+        return x->ext ? 1 : -1;
+    }
+    if (x->rtr != y->rtr)
+    {
+        return x->rtr ? 1 : -1;
+    }
+    return (x->id > y->id) - (x->id < y->id);
+}
+
+/* candump -L lines: "(1436509052.249713) can0 123#DEADBEEF", a 3 digit ID
+ * is standard, 8 digits extended, "#R" a remote frame */
+static void load_capture(const char *path)
+{
+    FILE *fp = fopen(path, "r");
+    char line[LINE_SIZE];
+    char frame[LINE_SIZE];
+    char *hash;
+    double ts;
+    uint32_t cap_size = 0U;
+    uint32_t raw = 0U;
+    capture_id_t key;
+    capture_id_t *found;
+    uint32_t i;
+    uint32_t j;
+
+    if (fp == NULL)
+    {
+        perror(path);
+        exit(1);
+    }
+    while (fgets(line, sizeof(line), fp) != NULL)
+    {
+        if ((sscanf(line, "(%lf) %*s %255s", &ts, frame) != 2) || ((hash = strchr(frame, '#')) == NULL))
+        {
+            continue;
+        }
+        key.ext = (hash - frame) > 3;
+        key.rtr = hash[1] == 'R';
+        key.id = (uint32_t)strtoul(frame, NULL, 16) & ID_EXT_ALL;
+        if (!key.ext)
+        {
+            key.id = (key.id & 0x7FFU) << ID_STD_SHIFT;
+        }
+        if (cap_frames == 0U)
+        {
+            cap_first_ts = ts;
+        }
+        cap_last_ts = ts;
+        cap_frames++;
+
+        /* unsorted tail, sorted and merged every 4096 new IDs */
+        if (raw >= cap_size)
+        {
+            cap_size = (cap_size == 0U) ? 8192U : (cap_size * 2U);
+            cap = realloc(cap, cap_size * sizeof(capture_id_t));
+        }
+        found = bsearch(&key, cap, cap_num, sizeof(capture_id_t), capture_cmp);
+        if (found == NULL)
+        {
+            for (i = cap_num; i < raw; i++)
+            {
+                if (capture_cmp(&key, &cap[i]) == 0)
+                {
+                    found = &cap[i];
+                    break;
+                }
+            }
+        }
+        if (found != NULL)
+        {
+            found->num++;
+            continue;
+        }
+        key.num = 1U;
+        cap[raw++] = key;
+        if ((raw - cap_num) >= 4096U)
+        {
+            qsort(cap, raw, sizeof(capture_id_t), capture_cmp);
+            cap_num = raw;
+        }
+    }
+    fclose(fp);
+    qsort(cap, raw, sizeof(capture_id_t), capture_cmp);
+    cap_num = raw;
+
+    for (i = 0U; i < cap_num; i++)
+    {
+        cap[i].subscribed = false;
+        for (j = 0U; j < subs_num; j++)
+        {
+            if (!cap[i].rtr && pattern_match(&subs[j], cap[i].ext, cap[i].id))
+            {
+                cap[i].subscribed = true;
+                break;
+            }
+        }
+    }
+}
+
+/* ---- output ---- */
+
+static void print_result(const result_t *res, uint32_t elements)
+{
+    printf("format %s: %u/%u slots, %u mailbox, false accept: %llu of %llu std IDs (%.2f%%), %llu ext IDs",
+           res->fmt->name, res->fifo_num, elements * res->fmt->per_element, res->mb_num,
+           (unsigned long long)res->std_false, (unsigned long long)(2048U - subs_std_num),
+           (2048U == subs_std_num) ? 0.0 : (100.0 * (double)res->std_false / (double)(2048U - subs_std_num)),
+           (unsigned long long)res->ext_false);
+    if (cap_frames > 0U)
+    {
+        printf(", %llu capture frames (%.2f%%)", (unsigned long long)res->cost.frames,
+               100.0 * (double)res->cost.frames / (double)cap_frames);
+    }
+    printf("\n");
+}
+
+static void write_output(const result_t *res, const regs_t *regs, uint32_t elements, FILE *hdr, FILE *inc)
+{
+    const format_t *fmt = res->fmt;
+    const pattern_t *p;
+    uint32_t i;
+
+    fprintf(hdr, "/* generated by tools/can_filter_gen from can_filter.def, do not edit */\n");
+    fprintf(hdr, "#ifndef CAN_LLD_FILTER_H\n#define CAN_LLD_FILTER_H\n\n");
+    fprintf(hdr, "/* %llu of %llu unsubscribed standard IDs and %llu extended IDs pass */\n",
+            (unsigned long long)res->std_false, (unsigned long long)(2048U - subs_std_num),
+            (unsigned long long)res->ext_false);
+    fprintf(hdr, "#define CAN_LLD_FILTER_FORMAT %s\n", fmt->sdk);
+    fprintf(hdr, "/* ID filter table elements, num_id_filters of the FlexCAN configuration */\n");
+    fprintf(hdr, "#define CAN_LLD_FILTER_ELEMENT_NUM %uU\n", elements);
+    fprintf(hdr, "/* entries of can_lld_filter_table, %u per element */\n", fmt->per_element);
+    fprintf(hdr, "#define CAN_LLD_FILTER_ID_NUM %uU\n", elements * fmt->per_element);
+    fprintf(hdr, "/* dedicated RX mailboxes, taken from the top of the TX pool */\n");
+    fprintf(hdr, "#define CAN_LLD_FILTER_RX_MB_NUM %uU\n\n", res->mb_num);
+    fprintf(hdr, "#endif\n");
+
+    fprintf(inc, "/* generated by tools/can_filter_gen from can_filter.def, do not edit */\n");
+    fprintf(inc, "static const flexcan_id_table_t can_lld_filter_table[CAN_LLD_FILTER_ID_NUM] =\n{\n");
+    for (i = 0U; i < (elements * fmt->per_element); i++)
+    {
+        p = slot_pattern(res, i);
+        fprintf(inc, "    {false, %s, 0x%0*XU},\n", p->ext ? "true" : "false", p->ext ? 8 : 3,
+                p->ext ? p->value : std_id(p));
+    }
+    fprintf(inc, "};\n\n");
+    fprintf(inc, "/* RXIMR of each table element, same bit layout as the element */\n");
+    fprintf(inc, "static const uint32_t can_lld_filter_mask[CAN_LLD_FILTER_ELEMENT_NUM] =\n{\n");
+    for (i = 0U; i < elements; i++)
+    {
+        fprintf(inc, "    0x%08XU,\n", regs->mask[i]);
+    }
+    fprintf(inc, "};\n");
+    if (res->mb_num > 0U)
+    {
+        fprintf(inc, "\n/* ID and individual mask of each dedicated RX mailbox */\n");
+        fprintf(inc, "static const can_lld_filter_mb_t can_lld_filter_mb[CAN_LLD_FILTER_RX_MB_NUM] =\n{\n");
+        for (i = 0U; i < res->mb_num; i++)
+        {
+            fprintf(inc, "    {%s, 0x%0*XU, 0x%0*XU},\n", regs->mb_ext[i] ? "true" : "false",
+                    regs->mb_ext[i] ? 8 : 3, regs->mb_id[i], regs->mb_ext[i] ? 8 : 3, regs->mb_mask[i]);
+        }
+        fprintf(inc, "};\n");
+    }
+}
+
+/* replay the capture on the register model, a subscribed frame which the
+ * hardware rejects is an error */
+static bool replay(const regs_t *regs, double irq_us)
+{
+    uint64_t fifo = 0U;
+    uint64_t mb = 0U;
+    uint64_t wanted = 0U;
+    uint64_t missed = 0U;
+    uint64_t accepted;
+    double seconds = cap_last_ts - cap_first_ts;
+    uint32_t i;
+    int where;
+
+    for (i = 0U; i < cap_num; i++)
+    {
+        where = regs_accept(regs, cap[i].ext, cap[i].rtr, cap[i].id);
+        if (where == 1)
+        {
+            fifo += cap[i].num;
+        }
+        else if (where == 2)
+        {
+            mb += cap[i].num;
+        }
+        if (cap[i].subscribed)
+        {
+            wanted += cap[i].num;
+            if (where == 0)
+            {
+                missed += cap[i].num;
+                fprintf(stderr, "subscribed %s ID 0x%X rejected\n", cap[i].ext ? "ext" : "std",
+                        cap[i].ext ? cap[i].id : (cap[i].id >> ID_STD_SHIFT));
+            }
+        }
+    }
+    accepted = fifo + mb;
+
+    printf("replay: %llu frames, %u IDs, %.1f s\n", (unsigned long long)cap_frames, cap_num, seconds);
+    printf("  subscribed %llu, accepted %llu (FIFO %llu, mailbox %llu), false accept %llu, missed %llu\n",
+           (unsigned long long)wanted, (unsigned long long)accepted, (unsigned long long)fifo,
+           (unsigned long long)mb, (unsigned long long)(accepted - (wanted - missed)),
+           (unsigned long long)missed);
+    if (seconds > 0.0)
+    {
+        printf("  RX interrupts: %.0f/s accept all, %.0f/s filtered, %.1f%% removed\n",
+               (double)cap_frames / seconds, (double)accepted / seconds,
+               100.0 * (double)(cap_frames - accepted) / (double)cap_frames);
+        if (irq_us > 0.0)
+        {
+            printf("  CPU load at %.1f us per frame: %.2f%% -> %.2f%%\n", irq_us,
+                   (double)cap_frames / seconds * irq_us / 1e4, (double)accepted / seconds * irq_us / 1e4);
+        }
+    }
+    return missed == 0U;
+}
+
+int main(int argc, char *argv[])
+{
+    static result_t results[3];
+    static regs_t regs;
+    uint32_t elements = 8U;
+    uint32_t mb_num = 0U;
+    const char *capture = NULL;
+    double irq_us = 0.0;
+    uint32_t best = 0U;
+    uint32_t i;
+    int arg = 1;
+    FILE *def;
+    FILE *hdr;
+    FILE *inc;
+    bool ok = true;
+
+    for (; (arg < argc) && (argv[arg][0] == '-') && ((arg + 1) < argc); arg += 2)
+    {
+        switch (argv[arg][1])
+        {
+        case 'e':
+            elements = (uint32_t)strtoul(argv[arg + 1], NULL, 0);
+            break;
+        case 'm':
+            mb_num = (uint32_t)strtoul(argv[arg + 1], NULL, 0);
+            break;
+        case 'r':
+            capture = argv[arg + 1];
+            break;
+        case 'c':
+            irq_us = strtod(argv[arg + 1], NULL);
+            break;
+        default:
+            arg = argc;
+            break;
+        }
+    }
+    /* 8 * (RFFN + 1) elements, the first 32 at most get an individual mask */
+    if (((argc - arg) != 3) || (elements == 0U) || ((elements % 8U) != 0U) || (elements > 32U))
+    {
+        fprintf(stderr, "usage: %s [-e elements] [-m rx_mb] [-r capture.log] [-c irq_us] "
+                "can_filter.def can_lld_filter.h can_lld_filter.inc\n", argv[0]);
+        return 1;
+    }
+
+    def_path = argv[arg];
+    def = fopen(argv[arg], "r");
+    if (def == NULL)
+    {
+        perror(argv[arg]);
+        return 1;
+    }
+    load_def(def);
+    fclose(def);
+    subs_num = pattern_reduce(subs, subs_num);
+    subs_std_num = set_count(subs, subs_num, false);
+    subs_ext_num = set_count(subs, subs_num, true);
+    printf("%u ID blocks, %llu std IDs, %llu ext IDs subscribed\n", subs_num,
+           (unsigned long long)subs_std_num, (unsigned long long)subs_ext_num);
+    if (capture != NULL)
+    {
+        load_capture(capture);
+    }
+
+    for (i = 0U; i < 3U; i++)
+    {
+        compile(&formats[i], elements, mb_num, &results[i]);
+        print_result(&results[i], elements);
+        if (cost_less(results[i].cost, results[best].cost))
+        {
+            best = i;
+        }
+    }
+    printf("format %s selected\n", results[best].fmt->name);
+
+    regs_build(&results[best], elements, &regs);
+    if (capture != NULL)
+    {
+        ok = replay(&regs, irq_us);
+    }
+
+    hdr = fopen(argv[arg + 1], "w");
+    inc = fopen(argv[arg + 2], "w");
+    if ((hdr == NULL) || (inc == NULL))
+    {
+        perror("can_filter_gen");
+        return 1;
+    }
+    write_output(&results[best], &regs, elements, hdr, inc);
+    fclose(hdr);
+    fclose(inc);
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,398 @@
+/* Host test of can_filter_gen.
+ *
+ * Random subscription sets of up to 25 IDs and ID ranges, standard and
+ * extended, are compiled with 8 or 16 table elements and 0 to 3 dedicated
+ * mailboxes and replayed with -r against a capture of every standard ID and
+ * of extended IDs in and around each extended range. can_filter_gen must
+ * not reject a subscribed frame, and the false accepts of the capture that
+ * its pattern model reports for the selected format must be the ones of the
+ * replay on the register words.
+ *
+ * Then a 20 s capture of a vehicle bus is written for the can_filter.def of
+ * this lesson, 20 of its standard IDs and 3 of its extended ones next to
+ * about 55 foreign IDs at 10 ms to 1 s, and replayed with 0 and 2 mailboxes
+ * to show the RX interrupts the filters remove.
+ *
+ * The test files are written to the current directory. Exit status 1 on a
+ * failed check.
+ *
+ * build: gcc -O2 -Wall -o can_filter_gen can_filter_gen.c
+ *        gcc -O2 -Wall -o can_filter_test can_filter_test.c
+ * usage: can_filter_test [-g can_filter_gen] [-n sets] [-d can_filter.def]
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#define TEST_DEF "can_filter_test.def"
+#define TEST_CAPTURE "can_filter_test.log"
+#define TEST_HDR "can_filter_test.h"
+#define TEST_INC "can_filter_test.inc"
+#define TEST_OUTPUT_SIZE 8192U
+#define TEST_RANGE_MAX 25U
+#define TEST_ID_STD_NUM 0x800U
+#define TEST_ID_EXT_NUM 0x20000000U
+/* the vehicle bus */
+#define TEST_BUS_SECONDS 20U
+#define TEST_BUS_FOREIGN 55U
+#define TEST_BUS_SUBSCRIBED 20U
+#define TEST_BUS_MSG_MAX 128U
+#define TEST_BUS_EPOCH 1700000000.0
+
+typedef struct
+{
+    uint32_t id;
+    bool ext;
+    uint32_t period_ms;
+} test_msg_t;
+
+typedef struct
+{
+    double t;
+    uint32_t id;
+    bool ext;
+} test_frame_t;
+
+static uint64_t test_seed = 88172645463325252ULL;
+static uint32_t test_error = 0U;
+static uint32_t test_check_num = 0U;
+static const char *test_gen = "./can_filter_gen";
+static char test_output[TEST_OUTPUT_SIZE];
+
+#define TEST_CHECK(cond, ...) do { test_check_num++; if (!(cond)) { printf("FAIL: " __VA_ARGS__); printf("\n"); test_error++; } } while (0)
+
+static uint32_t test_rand(uint32_t range)
+{
+    test_seed ^= test_seed << 13;
+    test_seed ^= test_seed >> 7;
+    test_seed ^= test_seed << 17;
+    return (uint32_t)(test_seed % range);
+}
+
+/* @brief: Run can_filter_gen on the test files, its report is kept in
+ *         test_output
+ * @param options : options before the file names
+ * @param def     : subscription file
+ * @return        : exit status of can_filter_gen
+ */
+static int test_gen_run(const char *options, const char *def)
+{
+    char cmd[512];
+    size_t len = 0U;
+    size_t n;
+    FILE *fp;
+    int status;
+
+    snprintf(cmd, sizeof(cmd), "%s %s %s %s %s 2>&1", test_gen, options, def, TEST_HDR, TEST_INC);
+    fp = popen(cmd, "r");
+    if (fp == NULL)
+    {
+        perror(test_gen);
+        exit(2);
+    }
+    while ((len < (TEST_OUTPUT_SIZE - 1U)) && ((n = fread(&test_output[len], 1U, TEST_OUTPUT_SIZE - 1U - len, fp)) > 0U))
+    {
+        len += n;
+    }
+    test_output[len] = '\0';
+    status = pclose(fp);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+/* @brief: The numbers of the report of the selected format
+ * @param capture_frames : false accepts of the capture by the pattern model
+ * @param false_accept   : false accepts of the replay on the register words
+ * @param missed         : subscribed frames the replay rejected
+ * @return               : true if the report has all of them
+ */
+static bool test_gen_report(uint32_t *capture_frames, uint32_t *false_accept, uint32_t *missed)
+{
+    char line[32];
+    char name;
+    const char *p;
+
+    p = strstr(test_output, " selected\n");
+    if ((p == NULL) || (p < &test_output[8]))
+    {
+        return false;
+    }
+    name = p[-1];
+    snprintf(line, sizeof(line), "format %c:", name);
+    p = strstr(test_output, line);
+    p = (p != NULL) ? strstr(p, " ext IDs, ") : NULL;
+    if ((p == NULL) || (sscanf(p, " ext IDs, %u capture frames", capture_frames) != 1))
+    {
+        return false;
+    }
+    p = strstr(test_output, "false accept ");
+    return (p != NULL) && (sscanf(p, "false accept %u, missed %u", false_accept, missed) == 2);
+}
+
+static void test_capture_frame(FILE *fp, double *t, uint32_t id, bool ext)
+{
+    *t += 0.001;
+    if (ext)
+    {
+        fprintf(fp, "(%.6f) can0 %08X#00\n", *t, id);
+    }
+    else
+    {
+        fprintf(fp, "(%.6f) can0 %03X#00\n", *t, id);
+    }
+}
+
+static void test_random_set(uint32_t sets)
+{
+    static const uint32_t std_span[10] = {0U, 0U, 0U, 1U, 3U, 7U, 15U, 40U, 100U, 300U};
+    static const uint32_t ext_span[5] = {0U, 0U, 255U, 1000U, 65535U};
+    static const uint32_t mb_num[4] = {0U, 0U, 1U, 3U};
+    static const uint32_t elements[3] = {8U, 8U, 16U};
+    uint32_t ext_first[TEST_RANGE_MAX];
+    uint32_t ext_last[TEST_RANGE_MAX];
+    uint32_t ext_num;
+    uint32_t range_num;
+    uint32_t capture_frames;
+    uint32_t false_accept;
+    uint32_t missed;
+    uint32_t first;
+    uint32_t last;
+    uint32_t set;
+    uint32_t i;
+    uint32_t k;
+    int32_t d;
+    char options[64];
+    double t;
+    FILE *def;
+    FILE *cap;
+    int ret;
+
+    for (set = 0U; (set < sets) && (test_error == 0U); set++)
+    {
+        def = fopen(TEST_DEF, "w");
+        cap = fopen(TEST_CAPTURE, "w");
+        if ((def == NULL) || (cap == NULL))
+        {
+            perror(TEST_DEF);
+            exit(2);
+        }
+        ext_num = 0U;
+        range_num = 1U + test_rand(TEST_RANGE_MAX);
+        for (i = 0U; i < range_num; i++)
+        {
+            if (test_rand(10U) < 7U)
+            {
+                first = test_rand(TEST_ID_STD_NUM);
+                last = first + std_span[test_rand(10U)];
+                last = (last >= TEST_ID_STD_NUM) ? (TEST_ID_STD_NUM - 1U) : last;
+                fprintf(def, (last > first) ? "0x%X-0x%X\n" : "0x%X\n", first, last);
+            }
+            else
+            {
+                first = test_rand(TEST_ID_EXT_NUM);
+                last = first + ext_span[test_rand(5U)];
+                last = (last >= TEST_ID_EXT_NUM) ? (TEST_ID_EXT_NUM - 1U) : last;
+                fprintf(def, "x:0x%X-0x%X\n", first, last);
+                ext_first[ext_num] = first;
+                ext_last[ext_num] = last;
+                ext_num++;
+            }
+        }
+
+        /* every standard ID, extended IDs at and around the ranges, and
+         * random extended IDs */
+        t = TEST_BUS_EPOCH;
+        for (i = 0U; i < TEST_ID_STD_NUM; i++)
+        {
+            for (k = test_rand(3U); k < 3U; k++)
+            {
+                test_capture_frame(cap, &t, i, false);
+            }
+        }
+        for (i = 0U; i < ext_num; i++)
+        {
+            const int32_t span = (int32_t)(ext_last[i] - ext_first[i]);
+            const int32_t offset[10] = {-300, -1, 0, 1, 77, span / 2, span, span + 1, span + 5000, 1 << 20};
+
+            for (k = 0U; k < 10U; k++)
+            {
+                d = offset[k];
+                test_capture_frame(cap, &t, (uint32_t)((int32_t)ext_first[i] + d) & (TEST_ID_EXT_NUM - 1U), true);
+            }
+        }
+        for (i = 0U; i < 300U; i++)
+        {
+            test_capture_frame(cap, &t, test_rand(TEST_ID_EXT_NUM), true);
+        }
+        fclose(def);
+        fclose(cap);
+
+        snprintf(options, sizeof(options), "-e %u -m %u -r %s", elements[test_rand(3U)], mb_num[test_rand(4U)],
+                 TEST_CAPTURE);
+        ret = test_gen_run(options, TEST_DEF);
+        TEST_CHECK(ret == 0, "set %u: can_filter_gen %s exit %d\n%s", set, options, ret, test_output);
+        if (!test_gen_report(&capture_frames, &false_accept, &missed))
+        {
+            TEST_CHECK(false, "set %u: no report\n%s", set, test_output);
+            continue;
+        }
+        TEST_CHECK(missed == 0U, "set %u: %u subscribed frames rejected\n%s", set, missed, test_output);
+        TEST_CHECK(capture_frames == false_accept, "set %u: pattern model %u, register words %u false accepts\n%s",
+                   set, capture_frames, false_accept, test_output);
+    }
+    printf("%u random subscription sets compiled and replayed\n", set);
+}
+
+static int test_frame_compare(const void *a, const void *b)
+{
+    const double ta = ((const test_frame_t *)a)->t;
+    const double tb = ((const test_frame_t *)b)->t;
+
+    return (ta < tb) ? -1 : ((ta > tb) ? 1 : 0);
+}
+
+static bool test_msg_known(const test_msg_t *msg, uint32_t num, uint32_t id, bool ext)
+{
+    uint32_t i;
+
+    for (i = 0U; i < num; i++)
+    {
+        if ((msg[i].id == id) && (msg[i].ext == ext))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* the standard IDs of can_filter.def, its extended ones are below */
+static bool test_bus_subscribed(uint32_t id)
+{
+    return (id == 0x010U) || ((id >= 0x100U) && (id <= 0x10FU)) || (id == 0x180U) ||
+           ((id >= 0x1A0U) && (id <= 0x1A7U)) || ((id >= 0x300U) && (id <= 0x33FU)) || (id == 0x352U) ||
+           (id == 0x7DFU) || (id == 0x7E0U);
+}
+
+static void test_bus(const char *def)
+{
+    static const uint32_t period_ms[8] = {10U, 20U, 50U, 100U, 100U, 200U, 500U, 1000U};
+    static const uint32_t ext_id[5] = {0x0CF00400U, 0x18FEEE00U, 0x18FEEE17U, 0x0CF00300U, 0x18FEEF00U};
+    static test_msg_t msg[TEST_BUS_MSG_MAX];
+    test_frame_t *frame;
+    uint32_t frame_num = 0U;
+    uint32_t frame_max = 0U;
+    uint32_t msg_num = 0U;
+    uint32_t subscribed = 0U;
+    uint32_t i;
+    uint32_t id;
+    double t;
+    FILE *cap;
+    int ret;
+
+    while (subscribed < TEST_BUS_SUBSCRIBED)
+    {
+        id = test_rand(TEST_ID_STD_NUM);
+        if (test_bus_subscribed(id) && !test_msg_known(msg, msg_num, id, false))
+        {
+            msg[msg_num++] = (test_msg_t){id, false, 0U};
+            subscribed++;
+        }
+    }
+    while (msg_num < (TEST_BUS_SUBSCRIBED + TEST_BUS_FOREIGN))
+    {
+        id = 0x020U + test_rand(0x7F0U - 0x020U);
+        if (!test_bus_subscribed(id) && !test_msg_known(msg, msg_num, id, false))
+        {
+            msg[msg_num++] = (test_msg_t){id, false, 0U};
+        }
+    }
+    for (i = 0U; i < 5U; i++)
+    {
+        msg[msg_num++] = (test_msg_t){ext_id[i], true, 0U};
+    }
+    for (i = 0U; i < 10U; i++)
+    {
+        msg[msg_num++] = (test_msg_t){0x18F00000U | test_rand(0x10000U), true, 0U};
+    }
+    for (i = 0U; i < msg_num; i++)
+    {
+        msg[i].period_ms = period_ms[test_rand(8U)];
+        frame_max += ((TEST_BUS_SECONDS * 1000U) / msg[i].period_ms) + 2U;
+    }
+
+    /* periods with 1% jitter, random phases */
+    frame = malloc(sizeof(*frame) * frame_max);
+    for (i = 0U; i < msg_num; i++)
+    {
+        t = ((double)test_rand(1000000U) / 1e6) * (double)msg[i].period_ms / 1000.0;
+        while ((t < (double)TEST_BUS_SECONDS) && (frame_num < frame_max))
+        {
+            frame[frame_num++] = (test_frame_t){t, msg[i].id, msg[i].ext};
+            t += ((double)msg[i].period_ms / 1000.0) * (0.99 + ((double)test_rand(20001U) / 1e6));
+        }
+    }
+    qsort(frame, frame_num, sizeof(*frame), test_frame_compare);
+    cap = fopen(TEST_CAPTURE, "w");
+    if (cap == NULL)
+    {
+        perror(TEST_CAPTURE);
+        exit(2);
+    }
+    for (i = 0U; i < frame_num; i++)
+    {
+        fprintf(cap, frame[i].ext ? "(%.6f) can0 %08X#0000000000000000\n" : "(%.6f) can0 %03X#0000000000000000\n",
+                TEST_BUS_EPOCH + frame[i].t, frame[i].id);
+    }
+    fclose(cap);
+    free(frame);
+
+    printf("\n%s, %u s vehicle bus, %u IDs, %u frames\n", def, TEST_BUS_SECONDS, msg_num, frame_num);
+    for (i = 0U; i <= 2U; i += 2U)
+    {
+        char options[64];
+        uint32_t capture_frames;
+        uint32_t false_accept;
+        uint32_t missed;
+
+        snprintf(options, sizeof(options), "-m %u -c 5 -r %s", i, TEST_CAPTURE);
+        ret = test_gen_run(options, def);
+        printf("can_filter_gen %s\n%s", options, test_output);
+        TEST_CHECK(ret == 0, "%s: can_filter_gen %s exit %d", def, options, ret);
+        TEST_CHECK(test_gen_report(&capture_frames, &false_accept, &missed) && (missed == 0U),
+                   "%s: can_filter_gen %s rejected subscribed frames", def, options);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *def = "../can_filter.def";
+    uint32_t sets = 300U;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "g:n:d:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'g':
+            test_gen = optarg;
+            break;
+        case 'n':
+            sets = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'd':
+            def = optarg;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-g can_filter_gen] [-n sets] [-d can_filter.def]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    test_random_set(sets);
+    test_bus(def);
+    printf("%s, %u checks, %u errors\n", (test_error == 0U) ? "PASS" : "FAIL", test_check_num, test_error);
+    return (test_error == 0U) ? 0 : 1;
+}
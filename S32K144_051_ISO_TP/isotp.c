@@ -0,0 +1,596 @@
+#include "isotp.h"
+#include "string.h"
+
+/* protocol control information, high nibble of the first byte */
+#define ISOTP_PCI_SF 0x00U
+#define ISOTP_PCI_FF 0x10U
+#define ISOTP_PCI_CF 0x20U
+#define ISOTP_PCI_FC 0x30U
+#define ISOTP_PCI_MASK 0xF0U
+
+/* flow status of a flow control */
+#define ISOTP_FS_CTS 0U
+#define ISOTP_FS_WAIT 1U
+#define ISOTP_FS_OVFLW 2U
+
+/* a longer message needs the escape first frame with a 32 bit FF_DL */
+#define ISOTP_FF_DL_12BIT_MAX 4095U
+
+/* IDE bit of the FlexCAN CS word */
+#define ISOTP_CS_IDE_MASK 0x00200000UL
+
+#define ISOTP_TIMEOUT_TICKS pdMS_TO_TICKS(ISOTP_TIMEOUT_MS)
+
+typedef enum
+{
+    ISOTP_TX_IDLE = 0,
+    ISOTP_TX_REQUEST,       /* isotp_send() called, first frame not sent yet */
+    ISOTP_TX_WAIT_FC,
+    ISOTP_TX_CF
+} isotp_tx_state_t;
+
+typedef enum
+{
+    ISOTP_RX_IDLE = 0,
+    ISOTP_RX_CF
+} isotp_rx_state_t;
+
+typedef struct
+{
+    const isotp_channel_config_t *config;
+
+    volatile isotp_tx_state_t tx_state;
+    const uint8_t *tx_data;
+    uint32_t tx_len;
+    uint32_t tx_pos;
+    uint8_t tx_sn;
+    uint8_t tx_bs;              /* BS of the receiver, 0 = no more flow control */
+    uint8_t tx_block_left;
+    uint8_t tx_wft;
+    TickType_t tx_st_min;       /* ticks between two consecutive frames */
+    TickType_t tx_last;         /* tick of the last consecutive frame */
+    TickType_t tx_timer;        /* N_Bs deadline */
+
+    isotp_rx_state_t rx_state;
+    uint8_t *rx_data;
+    uint32_t rx_len;
+    uint32_t rx_pos;
+    uint8_t rx_sn;
+    uint8_t rx_block_left;
+    bool rx_fc_pending;         /* FC.CTS not sent yet, the TX queue was full */
+    TickType_t rx_timer;        /* N_Cr deadline */
+} isotp_channel_t;
+
+uint32_t isotp_rx_msg_num;
+uint32_t isotp_tx_msg_num;
+uint32_t isotp_rx_error_num;
+uint32_t isotp_tx_error_num;
+
+static isotp_channel_t isotp_channels[ISOTP_CHANNEL_NUM];
+
+static bool isotp_expired(TickType_t now, TickType_t deadline);
+static TickType_t isotp_st_min_ticks(uint8_t st_min);
+static bool isotp_tx_frame(const isotp_channel_t *ch, uint8_t *frame, uint32_t len);
+static bool isotp_tx_fc(const isotp_channel_t *ch, uint8_t fs);
+static void isotp_tx_finish(uint8_t channel, isotp_result_t result);
+static void isotp_rx_finish(uint8_t channel, isotp_result_t result);
+static TickType_t isotp_tx_step(uint8_t channel, TickType_t now);
+static TickType_t isotp_rx_step(uint8_t channel, TickType_t now);
+static void isotp_rx_sf(uint8_t channel, const can_lld_rx_frame_t *frame);
+static void isotp_rx_ff(uint8_t channel, const can_lld_rx_frame_t *frame);
+static void isotp_rx_cf(uint8_t channel, const can_lld_rx_frame_t *frame);
+static void isotp_rx_fc(uint8_t channel, const can_lld_rx_frame_t *frame);
+
+void isotp_init(void)
+{
+    memset(isotp_channels, 0, sizeof(isotp_channels));
+}
+
+/* @brief: Serve a channel, rx_buf and rx_done are needed to receive,
+ *         tx_done may be NULL
+ * @param channel : channel number, below ISOTP_CHANNEL_NUM
+ * @param config  : IDs, flow control parameters and callbacks, kept
+ * @return        : None
+ */
+void isotp_channel_open(uint8_t channel, const isotp_channel_config_t *config)
+{
+    if (channel < ISOTP_CHANNEL_NUM)
+    {
+        memset(&isotp_channels[channel], 0, sizeof(isotp_channel_t));
+        isotp_channels[channel].config = config;
+    }
+}
+
+/* @brief: Start sending a message. The data is sent from where it is, it
+ *         must stay untouched until tx_done is called
+ * @param channel : channel number
+ * @param data    : payload
+ * @param len     : payload length, 1 to 2^32 - 1
+ * @return        : STATUS_SUCCESS, STATUS_BUSY while the channel still sends
+ *                  the last message, STATUS_ERROR for a bad argument
+ */
+status_t isotp_send(uint8_t channel, const uint8_t *data, uint32_t len)
+{
+    isotp_channel_t *ch;
+    status_t ret = STATUS_SUCCESS;
+
+    if ((channel >= ISOTP_CHANNEL_NUM) || (isotp_channels[channel].config == NULL) || (len == 0U))
+    {
+        return STATUS_ERROR;
+    }
+
+    ch = &isotp_channels[channel];
+    taskENTER_CRITICAL();
+    if (ch->tx_state != ISOTP_TX_IDLE)
+    {
+        ret = STATUS_BUSY;
+    }
+    else
+    {
+        ch->tx_data = data;
+        ch->tx_len = len;
+        ch->tx_state = ISOTP_TX_REQUEST;
+    }
+    taskEXIT_CRITICAL();
+
+    if (ret == STATUS_SUCCESS)
+    {
+        /* the first frame is sent by freertos_task_can_rx */
+        can_lld_rx_wake();
+    }
+    return ret;
+}
+
+/* @brief: Handle a received CAN frame
+ * @param frame : received frame
+ * @return      : true if the frame belongs to an ISO-TP channel
+ */
+bool isotp_rx_frame(const can_lld_rx_frame_t *frame)
+{
+    uint32_t id = frame->msgId;
+    uint8_t channel;
+
+    if ((frame->cs & ISOTP_CS_IDE_MASK) != 0U)
+    {
+        id |= CAN_LLD_TX_ID_EXT;
+    }
+    for (channel = 0U; channel < ISOTP_CHANNEL_NUM; channel++)
+    {
+        if ((isotp_channels[channel].config != NULL) && (isotp_channels[channel].config->rx_id == id))
+        {
+            break;
+        }
+    }
+    if (channel >= ISOTP_CHANNEL_NUM)
+    {
+        return false;
+    }
+    if (frame->dataLen == 0U)
+    {
+        return true;
+    }
+
+    switch (frame->data[0] & ISOTP_PCI_MASK)
+    {
+    case ISOTP_PCI_SF:
+        isotp_rx_sf(channel, frame);
+        break;
+    case ISOTP_PCI_FF:
+        isotp_rx_ff(channel, frame);
+        break;
+    case ISOTP_PCI_CF:
+        isotp_rx_cf(channel, frame);
+        break;
+    case ISOTP_PCI_FC:
+        isotp_rx_fc(channel, frame);
+        break;
+    default:
+        break;
+    }
+    return true;
+}
+
+/* @brief: Send what is due and check the timeouts of all channels
+ * @return: ticks until the next call is needed, portMAX_DELAY if only a
+ *          received frame or isotp_send() can bring new work
+ */
+TickType_t isotp_step(void)
+{
+    TickType_t now = xTaskGetTickCount();
+    TickType_t next = portMAX_DELAY;
+    TickType_t wait;
+    uint8_t channel;
+
+    for (channel = 0U; channel < ISOTP_CHANNEL_NUM; channel++)
+    {
+        if (isotp_channels[channel].config == NULL)
+        {
+            continue;
+        }
+        wait = isotp_tx_step(channel, now);
+        if (wait < next)
+        {
+            next = wait;
+        }
+        wait = isotp_rx_step(channel, now);
+        if (wait < next)
+        {
+            next = wait;
+        }
+    }
+    return next;
+}
+
+static bool isotp_expired(TickType_t now, TickType_t deadline)
+{
+    return (int32_t)(now - deadline) >= 0;
+}
+
+/* @brief: Ticks to wait between two consecutive frames
+ * @param st_min : STmin of a flow control, 0x00-0x7F ms, 0xF1-0xF9 100-900us
+ * @return       : ticks, one more than STmin as the last frame may have been
+ *                 sent at the end of its tick
+ */
+static TickType_t isotp_st_min_ticks(uint8_t st_min)
+{
+    uint32_t us;
+
+    if (st_min <= 0x7FU)
+    {
+        us = (uint32_t)st_min * 1000U;
+    }
+    else if ((st_min >= 0xF1U) && (st_min <= 0xF9U))
+    {
+        us = (uint32_t)(st_min - 0xF0U) * 100U;
+    }
+    else
+    {
+        /* reserved values mean the longest STmin */
+        us = 127000U;
+    }
+
+    if (us == 0U)
+    {
+        return 0U;
+    }
+    return (TickType_t)(((us * configTICK_RATE_HZ) + 999999U) / 1000000U) + 1U;
+}
+
+static bool isotp_tx_frame(const isotp_channel_t *ch, uint8_t *frame, uint32_t len)
+{
+#if ISOTP_PADDING_ENABLE
+    memset(&frame[len], ISOTP_PADDING_BYTE, 8U - len);
+    len = 8U;
+#endif
+    return STATUS_SUCCESS == can_lld_tx(ch->config->tx_id, frame, len);
+}
+
+static bool isotp_tx_fc(const isotp_channel_t *ch, uint8_t fs)
+{
+    uint8_t frame[8];
+
+    frame[0] = ISOTP_PCI_FC | fs;
+    frame[1] = ch->config->block_size;
+    frame[2] = ch->config->st_min;
+    return isotp_tx_frame(ch, frame, 3U);
+}
+
+static void isotp_tx_finish(uint8_t channel, isotp_result_t result)
+{
+    isotp_channel_t *ch = &isotp_channels[channel];
+    const uint8_t *data = ch->tx_data;
+
+    if (result == ISOTP_RESULT_OK)
+    {
+        isotp_tx_msg_num++;
+    }
+    else
+    {
+        isotp_tx_error_num++;
+    }
+    /* isotp_send() may start the next message from here on */
+    ch->tx_state = ISOTP_TX_IDLE;
+    if (ch->config->tx_done != NULL)
+    {
+        ch->config->tx_done(channel, data, result);
+    }
+}
+
+static void isotp_rx_finish(uint8_t channel, isotp_result_t result)
+{
+    isotp_channel_t *ch = &isotp_channels[channel];
+
+    if (result == ISOTP_RESULT_OK)
+    {
+        isotp_rx_msg_num++;
+    }
+    else
+    {
+        isotp_rx_error_num++;
+    }
+    ch->rx_state = ISOTP_RX_IDLE;
+    ch->rx_fc_pending = false;
+    ch->config->rx_done(channel, ch->rx_data, ch->rx_pos, result);
+}
+
+static TickType_t isotp_tx_step(uint8_t channel, TickType_t now)
+{
+    isotp_channel_t *ch = &isotp_channels[channel];
+    uint8_t frame[8];
+    uint32_t n;
+
+    switch (ch->tx_state)
+    {
+    case ISOTP_TX_REQUEST:
+        if (ch->tx_len <= 7U)
+        {
+            frame[0] = ISOTP_PCI_SF | (uint8_t)ch->tx_len;
+            memcpy(&frame[1], ch->tx_data, ch->tx_len);
+            if (!isotp_tx_frame(ch, frame, ch->tx_len + 1U))
+            {
+                return 1U;
+            }
+            isotp_tx_finish(channel, ISOTP_RESULT_OK);
+            return portMAX_DELAY;
+        }
+
+        if (ch->tx_len <= ISOTP_FF_DL_12BIT_MAX)
+        {
+            frame[0] = ISOTP_PCI_FF | (uint8_t)(ch->tx_len >> 8);
+            frame[1] = (uint8_t)ch->tx_len;
+            n = 2U;
+        }
+        else
+        {
+            frame[0] = ISOTP_PCI_FF;
+            frame[1] = 0U;
+            frame[2] = (uint8_t)(ch->tx_len >> 24);
+            frame[3] = (uint8_t)(ch->tx_len >> 16);
+            frame[4] = (uint8_t)(ch->tx_len >> 8);
+            frame[5] = (uint8_t)ch->tx_len;
+            n = 6U;
+        }
+        memcpy(&frame[n], ch->tx_data, 8U - n);
+        if (!isotp_tx_frame(ch, frame, 8U))
+        {
+            return 1U;
+        }
+        ch->tx_pos = 8U - n;
+        ch->tx_sn = 1U;
+        ch->tx_wft = 0U;
+        ch->tx_timer = now + ISOTP_TIMEOUT_TICKS;
+        ch->tx_state = ISOTP_TX_WAIT_FC;
+        return ISOTP_TIMEOUT_TICKS;
+
+    case ISOTP_TX_WAIT_FC:
+        if (isotp_expired(now, ch->tx_timer))
+        {
+            isotp_tx_finish(channel, ISOTP_RESULT_TIMEOUT_BS);
+            return portMAX_DELAY;
+        }
+        return ch->tx_timer - now;
+
+    case ISOTP_TX_CF:
+        for (;;)
+        {
+            if (!isotp_expired(now, ch->tx_last + ch->tx_st_min))
+            {
+                return ch->tx_last + ch->tx_st_min - now;
+            }
+            if (can_lld_tx_pending() >= ISOTP_TX_PENDING_MAX)
+            {
+                return 1U;
+            }
+
+            n = ch->tx_len - ch->tx_pos;
+            if (n > 7U)
+            {
+                n = 7U;
+            }
+            frame[0] = ISOTP_PCI_CF | ch->tx_sn;
+            memcpy(&frame[1], &ch->tx_data[ch->tx_pos], n);
+            if (!isotp_tx_frame(ch, frame, n + 1U))
+            {
+                return 1U;
+            }
+            ch->tx_pos += n;
+            ch->tx_sn = (ch->tx_sn + 1U) & 0x0FU;
+            ch->tx_last = now;
+
+            if (ch->tx_pos >= ch->tx_len)
+            {
+                isotp_tx_finish(channel, ISOTP_RESULT_OK);
+                return portMAX_DELAY;
+            }
+            if ((ch->tx_bs != 0U) && (--ch->tx_block_left == 0U))
+            {
+                ch->tx_wft = 0U;
+                ch->tx_timer = now + ISOTP_TIMEOUT_TICKS;
+                ch->tx_state = ISOTP_TX_WAIT_FC;
+                return ISOTP_TIMEOUT_TICKS;
+            }
+        }
+
+    default:
+        return portMAX_DELAY;
+    }
+}
+
+static TickType_t isotp_rx_step(uint8_t channel, TickType_t now)
+{
+    isotp_channel_t *ch = &isotp_channels[channel];
+
+    if (ch->rx_state != ISOTP_RX_CF)
+    {
+        return portMAX_DELAY;
+    }
+    if (ch->rx_fc_pending)
+    {
+        if (!isotp_tx_fc(ch, ISOTP_FS_CTS))
+        {
+            return 1U;
+        }
+        ch->rx_fc_pending = false;
+        ch->rx_timer = now + ISOTP_TIMEOUT_TICKS;
+    }
+    if (isotp_expired(now, ch->rx_timer))
+    {
+        isotp_rx_finish(channel, ISOTP_RESULT_TIMEOUT_CR);
+        return portMAX_DELAY;
+    }
+    return ch->rx_timer - now;
+}
+
+static void isotp_rx_sf(uint8_t channel, const can_lld_rx_frame_t *frame)
+{
+    isotp_channel_t *ch = &isotp_channels[channel];
+    uint32_t len = frame->data[0] & 0x0FU;
+    uint8_t *buf;
+
+    if ((len == 0U) || (len > 7U) || (len >= frame->dataLen))
+    {
+        return;
+    }
+    if (ch->rx_state != ISOTP_RX_IDLE)
+    {
+        isotp_rx_finish(channel, ISOTP_RESULT_UNEXP_PDU);
+    }
+
+    buf = ch->config->rx_buf(channel, len);
+    if (buf == NULL)
+    {
+        isotp_rx_error_num++;
+        return;
+    }
+    memcpy(buf, &frame->data[1], len);
+    isotp_rx_msg_num++;
+    ch->config->rx_done(channel, buf, len, ISOTP_RESULT_OK);
+}
+
+static void isotp_rx_ff(uint8_t channel, const can_lld_rx_frame_t *frame)
+{
+    isotp_channel_t *ch = &isotp_channels[channel];
+    const uint8_t *data = frame->data;
+    uint32_t len;
+    uint32_t n = 2U;
+    uint8_t *buf;
+
+    if (frame->dataLen < 8U)
+    {
+        return;
+    }
+    len = ((uint32_t)(data[0] & 0x0FU) << 8) | data[1];
+    if (len == 0U)
+    {
+        len = ((uint32_t)data[2] << 24) | ((uint32_t)data[3] << 16) | ((uint32_t)data[4] << 8) | data[5];
+        n = 6U;
+        if (len <= ISOTP_FF_DL_12BIT_MAX)
+        {
+            return;
+        }
+    }
+    else if (len < 8U)
+    {
+        return;
+    }
+    if (ch->rx_state != ISOTP_RX_IDLE)
+    {
+        isotp_rx_finish(channel, ISOTP_RESULT_UNEXP_PDU);
+    }
+
+    buf = ch->config->rx_buf(channel, len);
+    if (buf == NULL)
+    {
+        isotp_rx_error_num++;
+        (void)isotp_tx_fc(ch, ISOTP_FS_OVFLW);
+        return;
+    }
+    memcpy(buf, &data[n], 8U - n);
+    ch->rx_data = buf;
+    ch->rx_len = len;
+    ch->rx_pos = 8U - n;
+    ch->rx_sn = 1U;
+    ch->rx_block_left = ch->config->block_size;
+    ch->rx_timer = xTaskGetTickCount() + ISOTP_TIMEOUT_TICKS;
+    ch->rx_state = ISOTP_RX_CF;
+    ch->rx_fc_pending = !isotp_tx_fc(ch, ISOTP_FS_CTS);
+}
+
+static void isotp_rx_cf(uint8_t channel, const can_lld_rx_frame_t *frame)
+{
+    isotp_channel_t *ch = &isotp_channels[channel];
+    uint32_t n;
+
+    if (ch->rx_state != ISOTP_RX_CF)
+    {
+        return;
+    }
+    if ((frame->data[0] & 0x0FU) != ch->rx_sn)
+    {
+        isotp_rx_finish(channel, ISOTP_RESULT_WRONG_SN);
+        return;
+    }
+
+    n = ch->rx_len - ch->rx_pos;
+    if (n > 7U)
+    {
+        n = 7U;
+    }
+    if ((n + 1U) > frame->dataLen)
+    {
+        return;
+    }
+    memcpy(&ch->rx_data[ch->rx_pos], &frame->data[1], n);
+    ch->rx_pos += n;
+    ch->rx_sn = (ch->rx_sn + 1U) & 0x0FU;
+    ch->rx_timer = xTaskGetTickCount() + ISOTP_TIMEOUT_TICKS;
+
+    if (ch->rx_pos >= ch->rx_len)
+    {
+        isotp_rx_finish(channel, ISOTP_RESULT_OK);
+    }
+    else if ((ch->config->block_size != 0U) && (--ch->rx_block_left == 0U))
+    {
+        ch->rx_block_left = ch->config->block_size;
+        ch->rx_fc_pending = !isotp_tx_fc(ch, ISOTP_FS_CTS);
+    }
+}
+
+static void isotp_rx_fc(uint8_t channel, const can_lld_rx_frame_t *frame)
+{
+    isotp_channel_t *ch = &isotp_channels[channel];
+    TickType_t now = xTaskGetTickCount();
+
+    if ((ch->tx_state != ISOTP_TX_WAIT_FC) || (frame->dataLen < 3U))
+    {
+        return;
+    }
+
+    switch (frame->data[0] & 0x0FU)
+    {
+    case ISOTP_FS_CTS:
+        ch->tx_bs = frame->data[1];
+        ch->tx_block_left = frame->data[1];
+        ch->tx_st_min = isotp_st_min_ticks(frame->data[2]);
+        /* the first consecutive frame goes at once */
+        ch->tx_last = now - ch->tx_st_min;
+        ch->tx_state = ISOTP_TX_CF;
+        break;
+    case ISOTP_FS_WAIT:
+        if (++ch->tx_wft > ISOTP_WFT_MAX)
+        {
+            isotp_tx_finish(channel, ISOTP_RESULT_WFT_OVRN);
+        }
+        else
+        {
+            ch->tx_timer = now + ISOTP_TIMEOUT_TICKS;
+        }
+        break;
+    case ISOTP_FS_OVFLW:
+        isotp_tx_finish(channel, ISOTP_RESULT_BUFFER_OVFLW);
+        break;
+    default:
+        isotp_tx_finish(channel, ISOTP_RESULT_INVALID_FS);
+        break;
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef ISOTP_H
+#define ISOTP_H
+
+#include "can_lld.h"
+
+/* ISO 15765-2 transport on classic CAN, normal addressing. The protocol runs
+ * in freertos_task_can_rx: frames come in through isotp_rx_frame() and the
+ * timers are served by isotp_step() */
+
+#define ISOTP_CHANNEL_NUM 2U
+
+/* pad every frame to 8 bytes, frames without padding are accepted anyway */
+#define ISOTP_PADDING_ENABLE 1
+#define ISOTP_PADDING_BYTE 0xCCU
+
+/* N_Bs (waiting for a flow control) and N_Cr (waiting for a consecutive
+ * frame) */
+#define ISOTP_TIMEOUT_MS 1000U
+
+/* FC.WAIT frames accepted in a row before the sender gives up, N_WFTmax */
+#define ISOTP_WFT_MAX 8U
+
+/* consecutive frames are only queued while the CAN TX queue holds less than
+ * this, a transfer with STmin 0 must not fill it up for everybody else */
+#define ISOTP_TX_PENDING_MAX 4U
+
+/* N_Result of ISO 15765-2 */
+typedef enum
+{
+    ISOTP_RESULT_OK = 0,
+    ISOTP_RESULT_TIMEOUT_BS,
+    ISOTP_RESULT_TIMEOUT_CR,
+    ISOTP_RESULT_WRONG_SN,
+    ISOTP_RESULT_INVALID_FS,
+    ISOTP_RESULT_UNEXP_PDU,
+    ISOTP_RESULT_WFT_OVRN,
+    ISOTP_RESULT_BUFFER_OVFLW
+} isotp_result_t;
+
+/* Buffers are handed over, never copied by the stack:
+ *  - rx_buf  : a message of len bytes starts, return where it goes or NULL
+ *              to refuse it (the sender gets an overflow flow control)
+ *  - rx_done : the buffer of rx_buf belongs to the application again, data
+ *              is complete if result is ISOTP_RESULT_OK
+ *  - tx_done : the data of isotp_send() is not read any more */
+typedef uint8_t *(*isotp_rx_buf_func_t)(uint8_t channel, uint32_t len);
+typedef void (*isotp_rx_done_func_t)(uint8_t channel, uint8_t *data, uint32_t len, isotp_result_t result);
+typedef void (*isotp_tx_done_func_t)(uint8_t channel, const uint8_t *data, isotp_result_t result);
+
+typedef struct
+{
+    uint32_t rx_id;         /* or'ed with CAN_LLD_TX_ID_EXT for a 29 bit ID */
+    uint32_t tx_id;
+    uint8_t block_size;     /* BS of our flow control, 0 = whole message */
+    uint8_t st_min;         /* STmin of our flow control, ISO 15765-2 coding */
+    isotp_rx_buf_func_t rx_buf;
+    isotp_rx_done_func_t rx_done;
+    isotp_tx_done_func_t tx_done;
+} isotp_channel_config_t;
+
+extern uint32_t isotp_rx_msg_num;
+extern uint32_t isotp_tx_msg_num;
+extern uint32_t isotp_rx_error_num;
+extern uint32_t isotp_tx_error_num;
+
+void isotp_init(void);
+void isotp_channel_open(uint8_t channel, const isotp_channel_config_t *config);
+status_t isotp_send(uint8_t channel, const uint8_t *data, uint32_t len);
+bool isotp_rx_frame(const can_lld_rx_frame_t *frame);
+TickType_t isotp_step(void);
+
+#endif
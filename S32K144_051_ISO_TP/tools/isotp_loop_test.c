@@ -0,0 +1,385 @@
+/* Host loopback test of isotp.c.
+ *
+ * Two channels with crossed IDs talk over a model of a 500 kbit/s bus:
+ * can_lld_tx() queues the frame, the bus sends the lowest ID first, 276 us
+ * per 8 byte frame with worst case stuffing, and hands it to
+ * isotp_rx_frame(). isotp_step() runs on every received frame, on
+ * can_lld_rx_wake() and at the deadline it returns, with a 100 us tick like
+ * the board.
+ *
+ *   - messages of 1 to 65535 bytes at the frame type limits, then 2000 of
+ *     random length with random BS and STmin, must all arrive intact
+ *   - with 1% and 5% of the frames lost no corrupt message may be
+ *     delivered, and the next 100 messages without loss must all pass
+ *   - 4095 byte messages for BS 0, 8, 16 and STmin 0, 100 us, 1 ms, 5 ms,
+ *     STmin 0 must keep the bus busy
+ *
+ * Exit status 1 on a failed check.
+ *
+ * build: gcc -O2 -Wall -I.. -I../../S32K144_050_CAN_filter_compiler -I../../S32K144_057_CAN_socketcan/host
+ *            -o isotp_loop_test isotp_loop_test.c ../isotp.c
+ * usage: isotp_loop_test [-n random messages]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "isotp.h"
+
+/* 500 kbit/s, 8 byte standard frame with worst case stuffing */
+#define TEST_FRAME_US 276U
+#define TEST_TICK_US (1000000U / configTICK_RATE_HZ)
+#define TEST_STEP_US 10U
+#define TEST_BUS_QUEUE_SIZE 32U
+#define TEST_MSG_MAX 65535U
+#define TEST_BENCH_MSG_NUM 20U
+#define TEST_BENCH_LEN 4095U
+
+typedef struct
+{
+    uint32_t id;
+    uint32_t len;
+    uint32_t seq;
+    uint8_t data[8];
+} test_frame_t;
+
+static uint64_t test_seed = 88172645463325252ULL;
+static uint32_t test_error = 0U;
+static uint32_t test_check_num = 0U;
+
+#define TEST_CHECK(cond, ...) do { test_check_num++; if (!(cond)) { printf("FAIL: " __VA_ARGS__); printf("\n"); test_error++; } } while (0)
+
+static uint32_t test_rand(uint32_t range)
+{
+    test_seed ^= test_seed << 13;
+    test_seed ^= test_seed >> 7;
+    test_seed ^= test_seed << 17;
+    return (uint32_t)(test_seed % range);
+}
+
+/* the bus */
+static uint64_t test_now;               /* us */
+static test_frame_t test_queue[TEST_BUS_QUEUE_SIZE];
+static uint32_t test_queue_num;
+static uint32_t test_seq;
+static test_frame_t test_wire;
+static bool test_wire_busy;
+static uint64_t test_wire_end;
+static bool test_wake;
+static uint32_t test_drop_per_mille;
+static uint64_t test_bus_frame_num;
+
+/* the messages, channel 0 sends and channel 1 receives */
+static uint8_t test_tx_buf[TEST_MSG_MAX];
+static uint8_t test_rx_buf[TEST_MSG_MAX];
+static uint32_t test_tx_len;
+static bool test_tx_done_flag;
+static bool test_rx_done_flag;
+static isotp_result_t test_tx_result;
+static uint32_t test_rx_ok;
+static uint32_t test_rx_bad;
+static uint32_t test_rx_error;
+static uint32_t test_tx_ok;
+static uint32_t test_tx_error;
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(test_now / TEST_TICK_US);
+}
+
+void vPortEnterCritical(void)
+{
+}
+
+void vPortExitCritical(void)
+{
+}
+
+status_t can_lld_tx(uint32_t messageId, const uint8_t *data, uint32_t len)
+{
+    test_frame_t *frame;
+
+    if (len > 8U)
+    {
+        return STATUS_ERROR;
+    }
+    if (test_queue_num >= TEST_BUS_QUEUE_SIZE)
+    {
+        return STATUS_BUSY;
+    }
+    frame = &test_queue[test_queue_num++];
+    frame->id = messageId;
+    frame->len = len;
+    frame->seq = test_seq++;
+    memcpy(frame->data, data, len);
+    return STATUS_SUCCESS;
+}
+
+uint32_t can_lld_tx_pending(void)
+{
+    return test_queue_num + (test_wire_busy ? 1U : 0U);
+}
+
+void can_lld_rx_wake(void)
+{
+    test_wake = true;
+}
+
+static uint8_t *test_rx_buf_func(uint8_t channel, uint32_t len)
+{
+    (void)channel;
+    return (len <= sizeof(test_rx_buf)) ? test_rx_buf : NULL;
+}
+
+static void test_rx_done(uint8_t channel, uint8_t *data, uint32_t len, isotp_result_t result)
+{
+    (void)channel;
+    test_rx_done_flag = true;
+    if (result != ISOTP_RESULT_OK)
+    {
+        test_rx_error++;
+    }
+    else if ((len == test_tx_len) && (0 == memcmp(data, test_tx_buf, len)))
+    {
+        test_rx_ok++;
+    }
+    else
+    {
+        test_rx_bad++;
+    }
+}
+
+static void test_tx_done(uint8_t channel, const uint8_t *data, isotp_result_t result)
+{
+    (void)channel;
+    (void)data;
+    test_tx_done_flag = true;
+    test_tx_result = result;
+    if (result == ISOTP_RESULT_OK)
+    {
+        test_tx_ok++;
+    }
+    else
+    {
+        test_tx_error++;
+    }
+}
+
+static isotp_channel_config_t test_channel_0 = {0x7E8U, 0x7E0U, 0U, 0U, test_rx_buf_func, test_rx_done, test_tx_done};
+static isotp_channel_config_t test_channel_1 = {0x7E0U, 0x7E8U, 0U, 0U, test_rx_buf_func, test_rx_done, NULL};
+
+/* @brief: Run the bus and both channels until the message is through. A
+ *         failed transfer may leave the receiver waiting for N_Cr, the next
+ *         first frame restarts it
+ * @return: None
+ */
+static void test_run(void)
+{
+    can_lld_rx_frame_t frame;
+    uint64_t next_step = test_now;
+    TickType_t wait;
+    bool received;
+    uint32_t best;
+    uint32_t i;
+
+    test_tx_done_flag = false;
+    test_rx_done_flag = false;
+    while (!test_tx_done_flag ||
+           (!test_rx_done_flag && (test_tx_result == ISOTP_RESULT_OK) && (test_drop_per_mille == 0U)) ||
+           test_wire_busy || (test_queue_num != 0U))
+    {
+        received = false;
+        if (test_wire_busy && (test_now >= test_wire_end))
+        {
+            test_wire_busy = false;
+            test_bus_frame_num++;
+            if (test_rand(1000U) >= test_drop_per_mille)
+            {
+                memset(&frame, 0, sizeof(frame));
+                frame.msgId = test_wire.id;
+                frame.dataLen = (uint8_t)test_wire.len;
+                memcpy(frame.data, test_wire.data, 8U);
+                (void)isotp_rx_frame(&frame);
+                received = true;
+            }
+        }
+        /* arbitration, equal IDs in queue order */
+        if (!test_wire_busy && (test_queue_num != 0U))
+        {
+            best = 0U;
+            for (i = 1U; i < test_queue_num; i++)
+            {
+                if ((test_queue[i].id < test_queue[best].id) ||
+                    ((test_queue[i].id == test_queue[best].id) && (test_queue[i].seq < test_queue[best].seq)))
+                {
+                    best = i;
+                }
+            }
+            test_wire = test_queue[best];
+            test_queue[best] = test_queue[--test_queue_num];
+            test_wire_busy = true;
+            test_wire_end = test_now + TEST_FRAME_US;
+        }
+        if (received || test_wake || (test_now >= next_step))
+        {
+            test_wake = false;
+            wait = isotp_step();
+            next_step = (wait == portMAX_DELAY) ? UINT64_MAX : ((uint64_t)(xTaskGetTickCount() + wait) * TEST_TICK_US);
+        }
+        if (!received && !test_wake)
+        {
+            test_now += TEST_STEP_US;
+        }
+    }
+}
+
+static void test_send(uint32_t len)
+{
+    uint32_t i;
+    status_t ret;
+
+    for (i = 0U; i < len; i++)
+    {
+        test_tx_buf[i] = (uint8_t)test_rand(256U);
+    }
+    test_tx_len = len;
+    ret = isotp_send(0U, test_tx_buf, len);
+    TEST_CHECK(ret == STATUS_SUCCESS, "isotp_send() of %u bytes refused", len);
+    if (ret == STATUS_SUCCESS)
+    {
+        test_run();
+    }
+}
+
+static void test_counts_reset(void)
+{
+    test_rx_ok = 0U;
+    test_rx_bad = 0U;
+    test_rx_error = 0U;
+    test_tx_ok = 0U;
+    test_tx_error = 0U;
+}
+
+static void test_intact(uint32_t num)
+{
+    static const uint32_t len[] = {1U, 6U, 7U, 8U, 13U, 14U, 15U, 111U, 112U, 113U, 4095U, 4096U, 5000U, 65535U};
+    static const uint8_t block_size[4] = {0U, 1U, 8U, 19U};
+    uint32_t sent = 0U;
+    uint32_t i;
+
+    test_counts_reset();
+    for (i = 0U; i < (sizeof(len) / sizeof(len[0])); i++)
+    {
+        test_send(len[i]);
+        sent++;
+    }
+    for (i = 0U; i < num; i++)
+    {
+        /* STmin 0, 100..900 us or 1..2 ms */
+        test_channel_1.block_size = (test_rand(4U) != 0U) ? block_size[test_rand(4U)] : 0U;
+        test_channel_1.st_min = (test_rand(3U) != 0U) ? 0U : ((test_rand(2U) != 0U) ? (uint8_t)(0xF1U + test_rand(9U))
+                                                                                    : (uint8_t)(1U + test_rand(2U)));
+        test_send(1U + test_rand(4095U));
+        sent++;
+    }
+    printf("intact: %u messages, tx ok %u error %u, rx ok %u bad %u error %u\n", sent, test_tx_ok, test_tx_error,
+           test_rx_ok, test_rx_bad, test_rx_error);
+    TEST_CHECK((test_tx_ok == sent) && (test_rx_ok == sent) && (test_tx_error == 0U) && (test_rx_bad == 0U) &&
+               (test_rx_error == 0U), "not every message arrived intact");
+}
+
+static void test_loss(uint32_t per_mille)
+{
+    uint32_t ok;
+    uint32_t i;
+
+    test_counts_reset();
+    test_channel_1.block_size = 8U;
+    test_channel_1.st_min = 0U;
+    test_drop_per_mille = per_mille;
+    for (i = 0U; i < 2000U; i++)
+    {
+        test_send(1U + test_rand(1000U));
+    }
+    test_drop_per_mille = 0U;
+    ok = test_rx_ok;
+    for (i = 0U; i < 100U; i++)
+    {
+        test_send(1U + test_rand(1000U));
+    }
+    printf("%u.%u%% frame loss: tx ok %u error %u, rx ok %u bad %u error %u, then %u/100 without loss\n",
+           per_mille / 10U, per_mille % 10U, test_tx_ok, test_tx_error, test_rx_ok, test_rx_bad, test_rx_error,
+           test_rx_ok - ok);
+    TEST_CHECK(test_rx_bad == 0U, "%u corrupt messages delivered at %u per mille loss", test_rx_bad, per_mille);
+    TEST_CHECK((test_rx_ok - ok) == 100U, "only %u of 100 messages passed after the loss", test_rx_ok - ok);
+}
+
+static void test_bench(void)
+{
+    static const uint8_t block_size[3] = {0U, 8U, 16U};
+    static const uint8_t st_min[4] = {0U, 0xF1U, 1U, 5U};
+    static const char *const st_min_name[4] = {"0", "100 us", "1 ms", "5 ms"};
+    const double frame_limit = 1e6 / (double)TEST_FRAME_US;
+    uint64_t start;
+    uint64_t frames;
+    double us;
+    uint32_t b;
+    uint32_t s;
+    uint32_t i;
+
+    printf("%u byte messages, payload bytes/s and bus frames/s, the bus carries %.0f frames/s\n", TEST_BENCH_LEN,
+           frame_limit);
+    for (b = 0U; b < 3U; b++)
+    {
+        printf("  BS %2u:", block_size[b]);
+        for (s = 0U; s < 4U; s++)
+        {
+            test_channel_1.block_size = block_size[b];
+            test_channel_1.st_min = st_min[s];
+            start = test_now;
+            frames = test_bus_frame_num;
+            for (i = 0U; i < TEST_BENCH_MSG_NUM; i++)
+            {
+                test_send(TEST_BENCH_LEN);
+            }
+            us = (double)(test_now - start);
+            printf("  STmin %s %6.0f (%4.0f)", st_min_name[s], ((double)TEST_BENCH_MSG_NUM * TEST_BENCH_LEN * 1e6) / us,
+                   ((double)(test_bus_frame_num - frames) * 1e6) / us);
+            if (st_min[s] == 0U)
+            {
+                TEST_CHECK(((double)(test_bus_frame_num - frames) * 1e6 / us) > (0.95 * frame_limit),
+                           "BS %u STmin 0 leaves the bus idle", block_size[b]);
+            }
+        }
+        printf("\n");
+    }
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t num = 2000U;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            num = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-n random messages]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    isotp_init();
+    isotp_channel_open(0U, &test_channel_0);
+    isotp_channel_open(1U, &test_channel_1);
+    test_intact(num);
+    test_loss(10U);
+    test_loss(50U);
+    test_bench();
+    printf("%s, %u checks, %u errors\n", (test_error == 0U) ? "PASS" : "FAIL", test_check_num, test_error);
+    return (test_error == 0U) ? 0 : 1;
+}
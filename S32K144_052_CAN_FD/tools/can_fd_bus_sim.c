@@ -0,0 +1,721 @@
+/* Host model of the TX throughput of can_lld.c in classic CAN and CAN FD.
+ *
+ * can_lld.c is built as it is on a stub FlexCAN driver that checks what the
+ * driver asks for: the configuration of each mode (FD: no RX FIFO, 7
+ * mailboxes of 64 bytes; classic: RX FIFO and 16 mailboxes), every frame
+ * handed to FLEXCAN_DRV_Send() (no FD frame in classic mode, no classic
+ * frame longer than 8 bytes, only DLC lengths in FD) and the padding behind
+ * the payload. The TX mailboxes take part in a discrete event model of the
+ * bus at 500 kbit/s nominal: the lowest arbitration key wins, a frame takes
+ * its length with worst case stuffing, an FD frame with BRS sends from the
+ * ESI bit to the CRC delimiter at the data bitrate.
+ *
+ *   - saturated: 40 IDs every 5 ms, 8000 frames/s, more than any mode
+ *     carries; classic 8 bytes, FD 8/16/32/64 bytes at a 1 Mbit/s data
+ *     phase and FD 64 bytes at 2 Mbit/s (the driver keeps its 1 Mbit/s
+ *     timing, only the model sends faster)
+ *   - switch: FD 64 bytes with every 4th ID classic 8 bytes, back to
+ *     classic in the middle of the run
+ *
+ * Each frame carries a number, so the bus sees every duplicate and every
+ * reorder within an ID. After the switch no FD frame may reach the bus, the
+ * FD frames still queued are dropped and counted in can_lld_tx_error_num,
+ * and the classic frames keep going. Exit status 1 on a failed check.
+ *
+ * build: gcc -O2 -Wall -I.. -I../../S32K144_051_ISO_TP -I../../S32K144_050_CAN_filter_compiler
+ *            -I../../S32K144_057_CAN_socketcan/host -o can_fd_bus_sim can_fd_bus_sim.c
+ *            ../can_lld.c ../../S32K144_051_ISO_TP/isotp.c
+ * usage: can_fd_bus_sim [-t seconds]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "can_lld.h"
+#include "lpspiCom1.h"
+#include "sbc_uja116x1.h"
+#include "Cpu.h"
+
+/* 500 kbit/s nominal */
+#define SIM_BIT_NS 2000U
+/* intermission between two frames */
+#define SIM_IFS_BITS 3U
+#define SIM_MB_NUM 32U
+#define SIM_MSG_NUM 40U
+#define SIM_UID_MAX 4000000U
+#define SIM_NO_MB 0xFFFFFFFFU
+/* byte of the test payload that holds the length asked for */
+#define SIM_LEN_BYTE 4U
+
+typedef struct
+{
+    bool pending;
+    bool ext;
+    bool fd;
+    bool brs;
+    uint32_t key;
+    uint32_t len;
+    uint32_t uid;
+} sim_mb_t;
+
+typedef struct
+{
+    uint32_t id;
+    uint32_t len;
+    bool fd;
+    uint64_t period_ns;
+    uint64_t next;
+    bool seen;
+    uint32_t last_uid;
+} sim_msg_t;
+
+typedef enum
+{
+    SIM_UID_WAITING = 0,
+    SIM_UID_SENT,
+    SIM_UID_REFUSED
+} sim_uid_state_t;
+
+static uint32_t test_error = 0U;
+static uint32_t test_check_num = 0U;
+
+#define TEST_CHECK(cond, ...) do { test_check_num++; if (!(cond)) { printf("FAIL: " __VA_ARGS__); printf("\n"); test_error++; } } while (0)
+
+/* SDK and FreeRTOS, as far as can_lld.c uses them */
+
+flexcan_state_t canCom1_State;
+const flexcan_user_config_t canCom1_InitConfig0 =
+{
+    .max_num_mb = 16U,
+    .is_rx_fifo_needed = true,
+    .payload = FLEXCAN_PAYLOAD_SIZE_8,
+    .fd_enable = false
+};
+lpspi_state_t lpspiCom1State;
+const lpspi_master_config_t lpspiCom1_MasterConfig0;
+const sbc_int_config_t sbc_uja116x1_InitConfig0;
+static CAN_Type sim_can0;
+static flexcan_callback_t sim_callback;
+static flexcan_user_config_t sim_config;
+static bool sim_running;
+static uint32_t sim_init_num;
+static uint32_t sim_config_error;
+static uint32_t sim_send_error;
+static uint32_t sim_pad_error;
+static uint32_t sim_rx_mb;
+static uint8_t sim_tdc_offset;
+
+static sim_mb_t sim_mb[SIM_MB_NUM];
+static uint32_t sim_wire_mb = SIM_NO_MB;    /* our mailbox on the wire */
+static bool sim_wire_aborted;               /* its abort took TX_COMPLETE */
+static uint64_t sim_now;                    /* ns */
+static uint32_t sim_data_bps;
+
+static sim_msg_t sim_msg[SIM_MSG_NUM];
+static uint16_t *sim_uid_msg;
+static uint8_t *sim_uid_state;
+static uint32_t sim_uid_num;
+static uint32_t sim_sent;
+static uint32_t sim_fd_sent;
+static uint64_t sim_payload;
+static uint32_t sim_dup;
+static uint32_t sim_order_error;
+
+CAN_Type *flexcan_host_regs(void)
+{
+    return &sim_can0;
+}
+
+status_t LPSPI_DRV_MasterInit(uint32_t instance, lpspi_state_t *lpspiState, const lpspi_master_config_t *spiConfig)
+{
+    (void)instance;
+    (void)lpspiState;
+    (void)spiConfig;
+    return STATUS_SUCCESS;
+}
+
+status_t SBC_Init(const sbc_int_config_t *const config, const uint32_t lpspiInstance)
+{
+    (void)config;
+    (void)lpspiInstance;
+    return STATUS_SUCCESS;
+}
+
+void INT_SYS_SetPriority(IRQn_Type irqNumber, uint8_t priority)
+{
+    (void)irqNumber;
+    (void)priority;
+}
+
+void vPortEnterCritical(void)
+{
+}
+
+void vPortExitCritical(void)
+{
+}
+
+void FLEXCAN_DRV_GetDefaultConfig(flexcan_user_config_t *config)
+{
+    memset(config, 0, sizeof(*config));
+}
+
+status_t FLEXCAN_DRV_Init(uint8_t instance, flexcan_state_t *state, const flexcan_user_config_t *data)
+{
+    (void)instance;
+    (void)state;
+    sim_config = *data;
+    sim_running = true;
+    sim_init_num++;
+    sim_rx_mb = 0U;
+    sim_tdc_offset = 0U;
+    if (data->fd_enable && (data->is_rx_fifo_needed || (data->max_num_mb != CAN_LLD_FD_MB_NUM) ||
+                            (data->payload != FLEXCAN_PAYLOAD_SIZE_64)))
+    {
+        sim_config_error++;
+    }
+    if (!data->fd_enable && (!data->is_rx_fifo_needed || (data->max_num_mb != 16U)))
+    {
+        sim_config_error++;
+    }
+    return STATUS_SUCCESS;
+}
+
+status_t FLEXCAN_DRV_Deinit(uint8_t instance)
+{
+    (void)instance;
+    sim_running = false;
+    memset(sim_mb, 0, sizeof(sim_mb));
+    return STATUS_SUCCESS;
+}
+
+void FLEXCAN_DRV_SetTDCOffset(uint8_t instance, bool enable, uint8_t offset)
+{
+    (void)instance;
+    sim_tdc_offset = enable ? offset : 0U;
+}
+
+void FLEXCAN_DRV_ConfigRxFifo(uint8_t instance, flexcan_rx_fifo_id_element_format_t id_format,
+                              const flexcan_id_table_t *id_filter_table)
+{
+    (void)instance;
+    (void)id_format;
+    (void)id_filter_table;
+    sim_config_error += sim_config.fd_enable ? 1U : 0U;
+}
+
+void FLEXCAN_DRV_SetRxFifoGlobalMask(uint8_t instance, flexcan_msgbuff_id_type_t id_type, uint32_t mask)
+{
+    (void)instance;
+    (void)id_type;
+    (void)mask;
+}
+
+void FLEXCAN_DRV_InstallEventCallback(uint8_t instance, flexcan_callback_t callback, void *callbackParam)
+{
+    (void)instance;
+    (void)callbackParam;
+    sim_callback = callback;
+}
+
+status_t FLEXCAN_DRV_RxFifo(uint8_t instance, flexcan_msgbuff_t *data)
+{
+    (void)instance;
+    (void)data;
+    sim_config_error += sim_config.fd_enable ? 1U : 0U;
+    return STATUS_SUCCESS;
+}
+
+void FLEXCAN_DRV_SetRxMaskType(uint8_t instance, flexcan_rx_mask_type_t type)
+{
+    (void)instance;
+    (void)type;
+}
+
+status_t FLEXCAN_DRV_ConfigRxMb(uint8_t instance, uint8_t mb_idx, const flexcan_data_info_t *rx_info, uint32_t msg_id)
+{
+    (void)instance;
+    (void)rx_info;
+    (void)msg_id;
+    sim_config_error += (mb_idx >= sim_config.max_num_mb) ? 1U : 0U;
+    sim_rx_mb |= 1UL << mb_idx;
+    return STATUS_SUCCESS;
+}
+
+status_t FLEXCAN_DRV_SetRxIndividualMask(uint8_t instance, flexcan_msgbuff_id_type_t id_type, uint8_t mb_idx,
+                                         uint32_t mask)
+{
+    (void)instance;
+    (void)id_type;
+    (void)mb_idx;
+    (void)mask;
+    return STATUS_SUCCESS;
+}
+
+status_t FLEXCAN_DRV_Receive(uint8_t instance, uint8_t mb_idx, flexcan_msgbuff_t *data)
+{
+    (void)instance;
+    (void)mb_idx;
+    (void)data;
+    return STATUS_SUCCESS;
+}
+
+uint32_t FLEXCAN_DRV_GetErrorStatus(uint8_t instance)
+{
+    (void)instance;
+    return 0U;
+}
+
+void FLEXCAN_ClearErrIntStatusFlag(CAN_Type *base)
+{
+    (void)base;
+}
+
+void FLEXCAN_EnterFreezeMode(CAN_Type *base)
+{
+    (void)base;
+}
+
+void FLEXCAN_ExitFreezeMode(CAN_Type *base)
+{
+    (void)base;
+}
+
+TickType_t xTaskGetTickCountFromISR(void)
+{
+    return (TickType_t)((sim_now / 1000U * configTICK_RATE_HZ) / 1000000U);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return xTaskGetTickCountFromISR();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return NULL;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    (void)xTaskToNotify;
+    (void)pxHigherPriorityTaskWoken;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify)
+{
+    (void)xTaskToNotify;
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait)
+{
+    (void)xClearCountOnExit;
+    (void)xTicksToWait;
+    return 0U;
+}
+
+/* arbitration key: the 11 base bits, then IDE, then the 18 extended bits */
+static uint32_t sim_key(uint32_t id, bool ext)
+{
+    return ext ? (((id >> 18) << 19) | (1UL << 18) | (id & 0x3FFFFU)) : ((id & 0x7FFU) << 19);
+}
+
+static bool sim_fd_len_valid(uint32_t len)
+{
+    return (len <= 8U) || (len == 12U) || (len == 16U) || (len == 20U) || (len == 24U) || (len == 32U) ||
+           (len == 48U) || (len == 64U);
+}
+
+status_t FLEXCAN_DRV_ConfigTxMb(uint8_t instance, uint8_t mb_idx, const flexcan_data_info_t *tx_info, uint32_t msg_id)
+{
+    (void)instance;
+    (void)tx_info;
+    (void)msg_id;
+    sim_config_error += (mb_idx >= sim_config.max_num_mb) ? 1U : 0U;
+    sim_config_error += ((sim_rx_mb & (1UL << mb_idx)) != 0U) ? 1U : 0U;
+    return STATUS_SUCCESS;
+}
+
+status_t FLEXCAN_DRV_Send(uint8_t instance, uint8_t mb_idx, const flexcan_data_info_t *tx_info, uint32_t msg_id,
+                          const uint8_t *mb_data)
+{
+    sim_mb_t *mb = &sim_mb[mb_idx];
+    uint32_t i;
+
+    (void)instance;
+    if (!sim_running)
+    {
+        sim_send_error++;
+        return STATUS_ERROR;
+    }
+    if (mb->pending || ((sim_wire_mb == mb_idx) && !sim_wire_aborted))
+    {
+        return STATUS_BUSY;
+    }
+    sim_send_error += (tx_info->fd_enable && !sim_config.fd_enable) ? 1U : 0U;
+    sim_send_error += (!tx_info->fd_enable && (tx_info->data_length > 8U)) ? 1U : 0U;
+    sim_send_error += (tx_info->fd_enable && !sim_fd_len_valid(tx_info->data_length)) ? 1U : 0U;
+    mb->pending = true;
+    mb->ext = tx_info->msg_id_type == FLEXCAN_MSG_ID_EXT;
+    mb->fd = tx_info->fd_enable;
+    mb->brs = tx_info->enable_brs;
+    mb->key = sim_key(msg_id, mb->ext);
+    mb->len = tx_info->data_length;
+    memcpy(&mb->uid, mb_data, sizeof(mb->uid));
+    for (i = mb_data[SIM_LEN_BYTE]; i < tx_info->data_length; i++)
+    {
+        sim_pad_error += (mb_data[i] != CAN_LLD_FD_PADDING_BYTE) ? 1U : 0U;
+    }
+    return STATUS_SUCCESS;
+}
+
+/* a frame on the wire is finished by FlexCAN, the abort fails */
+status_t FLEXCAN_DRV_AbortTransfer(uint8_t instance, uint8_t mb_idx)
+{
+    (void)instance;
+    if (sim_wire_mb == mb_idx)
+    {
+        sim_wire_aborted = true;
+        return STATUS_CAN_NO_TRANSFER_IN_PROGRESS;
+    }
+    if (!sim_mb[mb_idx].pending)
+    {
+        return STATUS_CAN_NO_TRANSFER_IN_PROGRESS;
+    }
+    sim_mb[mb_idx].pending = false;
+    return STATUS_SUCCESS;
+}
+
+/* the bus */
+
+/* @brief: Bus time of a data frame with worst case stuffing and the
+ *         intermission
+ * @param mb : frame in a mailbox
+ * @return   : ns
+ */
+static uint64_t sim_frame_ns(const sim_mb_t *mb)
+{
+    uint32_t arb;
+    uint32_t dat;
+    uint32_t bits;
+
+    if (!mb->fd)
+    {
+        bits = (mb->ext ? 67U : 47U) + (8U * mb->len);
+        bits += ((mb->ext ? 54U : 34U) + (8U * mb->len) - 1U) / 4U;
+        return (uint64_t)SIM_BIT_NS * (bits + SIM_IFS_BITS);
+    }
+    /* nominal: SOF, ID, RRS, IDE, FDF, res, BRS (SRR and 18 more ID bits
+     * when extended) stuffed, then CRC delimiter, ACK, EOF */
+    arb = mb->ext ? 36U : 17U;
+    arb += (arb - 1U) / 4U;
+    arb += 1U + 2U + 7U + SIM_IFS_BITS;
+    /* data phase: ESI, DLC and data stuffed, stuff count and CRC with
+     * their fixed stuff bits */
+    dat = 5U + (8U * mb->len);
+    dat += (dat - 1U) / 4U;
+    dat += (mb->len > 16U) ? (4U + 21U + 7U) : (4U + 17U + 6U);
+    return ((uint64_t)SIM_BIT_NS * arb) +
+           (mb->brs ? (((uint64_t)dat * 1000000000U) / sim_data_bps) : ((uint64_t)SIM_BIT_NS * dat));
+}
+
+static void sim_release(uint32_t i)
+{
+    uint8_t data[CAN_LLD_PAYLOAD_MAX];
+    const uint32_t uid = sim_uid_num++;
+
+    memset(data, 0x55, sizeof(data));
+    memcpy(data, &uid, sizeof(uid));
+    data[SIM_LEN_BYTE] = (uint8_t)sim_msg[i].len;
+    sim_uid_msg[uid] = (uint16_t)i;
+    sim_uid_state[uid] = SIM_UID_WAITING;
+    if (can_lld_tx(sim_msg[i].id | (sim_msg[i].fd ? CAN_LLD_TX_ID_FD : 0U), data, sim_msg[i].len) != STATUS_SUCCESS)
+    {
+        sim_uid_state[uid] = SIM_UID_REFUSED;
+    }
+}
+
+static void sim_done(uint32_t uid)
+{
+    sim_msg_t *msg = &sim_msg[sim_uid_msg[uid]];
+
+    if (sim_uid_state[uid] != SIM_UID_WAITING)
+    {
+        sim_dup++;
+        return;
+    }
+    sim_uid_state[uid] = SIM_UID_SENT;
+    sim_sent++;
+    sim_payload += msg->len;
+    if (msg->seen && (uid < msg->last_uid))
+    {
+        sim_order_error++;
+    }
+    msg->seen = true;
+    msg->last_uid = uid;
+}
+
+static uint64_t sim_next_event(void)
+{
+    uint64_t t = UINT64_MAX;
+    uint32_t i;
+
+    for (i = 0U; i < SIM_MSG_NUM; i++)
+    {
+        t = (sim_msg[i].next < t) ? sim_msg[i].next : t;
+    }
+    return t;
+}
+
+/* release all frames due up to and including until */
+static void sim_events(uint64_t until)
+{
+    uint64_t t;
+    uint32_t i;
+
+    for (t = sim_next_event(); t <= until; t = sim_next_event())
+    {
+        sim_now = t;
+        for (i = 0U; i < SIM_MSG_NUM; i++)
+        {
+            if (sim_msg[i].next == t)
+            {
+                sim_release(i);
+                sim_msg[i].next += sim_msg[i].period_ns;
+            }
+        }
+    }
+    sim_now = until;
+}
+
+/* @brief: Put the next frame on the bus, or wait for the next release
+ * @return: bus time of the frame in ns, 0 if the bus was idle
+ */
+static uint64_t sim_bus_step(void)
+{
+    uint32_t mb_best = SIM_NO_MB;
+    uint32_t key_best = UINT32_MAX;
+    uint64_t duration;
+    uint32_t i;
+    sim_mb_t frame;
+
+    sim_events(sim_now);
+    /* arbitration, lowest mailbox first on a tie like FlexCAN */
+    for (i = 0U; i < SIM_MB_NUM; i++)
+    {
+        if (sim_mb[i].pending && (sim_mb[i].key < key_best))
+        {
+            key_best = sim_mb[i].key;
+            mb_best = i;
+        }
+    }
+    if (mb_best == SIM_NO_MB)
+    {
+        sim_now = sim_next_event();
+        return 0U;
+    }
+
+    frame = sim_mb[mb_best];
+    sim_mb[mb_best].pending = false;
+    sim_wire_mb = mb_best;
+    sim_wire_aborted = false;
+    duration = sim_frame_ns(&frame);
+    sim_events(sim_now + duration);
+    sim_wire_mb = SIM_NO_MB;
+    sim_done(frame.uid);
+    sim_fd_sent += frame.fd ? 1U : 0U;
+    if (!sim_wire_aborted)
+    {
+        sim_callback(INST_CANCOM1, FLEXCAN_EVENT_TX_COMPLETE, mb_best, &canCom1_State);
+    }
+    return duration;
+}
+
+/* @brief: Run the bus, then stop the releases and send what is left so the
+ *         driver is idle for the next run
+ * @param len      : payload of every ID, 8 bytes or less as FD frames too
+ * @param fd       : run in CAN FD mode
+ * @param data_bps : data phase bitrate of the model
+ * @param sw       : every 4th ID classic 8 bytes, back to classic halfway
+ * @param seconds  : bus time
+ * @return         : payload B/s
+ */
+static double sim_run(uint32_t len, bool fd, uint32_t data_bps, bool sw, uint32_t seconds)
+{
+    char name[32];
+    const uint64_t end = (uint64_t)seconds * 1000000000U;
+    uint64_t busy = 0U;
+    uint64_t bus_time;
+    uint32_t sent;
+    uint32_t fd_sent_switch = 0U;
+    uint32_t sent_switch = 0U;
+    uint32_t dropped = 0U;
+    uint32_t refused = 0U;
+    uint32_t waiting = 0U;
+    bool switched = false;
+    double payload;
+    uint32_t uid;
+    uint32_t i;
+
+    (void)snprintf(name, sizeof(name), "%-7s %2u B%s", sw ? "switch" : (fd ? "FD" : "classic"), len,
+                   fd ? ((data_bps == 2000000U) ? " @2M" : " @1M") : "");
+    for (i = 0U; i < SIM_MSG_NUM; i++)
+    {
+        memset(&sim_msg[i], 0, sizeof(sim_msg[i]));
+        sim_msg[i].id = 0x100U + (i * 8U);
+        sim_msg[i].period_ns = 5000000U;
+        sim_msg[i].next = (i % 5U) * 1000000U;
+        sim_msg[i].len = (sw && ((i % 4U) == 0U)) ? 8U : len;
+        sim_msg[i].fd = fd && !(sw && ((i % 4U) == 0U)) && (len <= 8U);
+    }
+    memset(sim_mb, 0, sizeof(sim_mb));
+    sim_wire_mb = SIM_NO_MB;
+    sim_wire_aborted = false;
+    sim_now = 0U;
+    sim_data_bps = data_bps;
+    sim_uid_num = 0U;
+    sim_sent = 0U;
+    sim_fd_sent = 0U;
+    sim_payload = 0U;
+    sim_dup = 0U;
+    sim_order_error = 0U;
+    sim_config_error = 0U;
+    sim_send_error = 0U;
+    sim_pad_error = 0U;
+    can_lld_tx_error_num = 0U;
+    TEST_CHECK(can_lld_set_mode(fd ? CAN_LLD_MODE_FD : CAN_LLD_MODE_CLASSIC) == STATUS_SUCCESS,
+               "%s: mode not set", name);
+    sim_init_num = 0U;
+
+    while (sim_now < end)
+    {
+        if (sw && !switched && (sim_now >= (end / 2U)))
+        {
+            dropped = can_lld_tx_error_num;
+            TEST_CHECK(can_lld_set_mode(CAN_LLD_MODE_CLASSIC) == STATUS_SUCCESS, "%s: no switch to classic", name);
+            dropped = can_lld_tx_error_num - dropped;
+            switched = true;
+            fd_sent_switch = sim_fd_sent;
+            sent_switch = sim_sent;
+        }
+        busy += sim_bus_step();
+    }
+    bus_time = sim_now;
+    sent = sim_sent;
+    payload = ((double)sim_payload * 1000000000.0) / (double)bus_time;
+
+    for (i = 0U; i < SIM_MSG_NUM; i++)
+    {
+        sim_msg[i].next = UINT64_MAX;
+    }
+    for (i = 0U; i < SIM_MB_NUM; i++)
+    {
+        if (sim_mb[i].pending)
+        {
+            (void)sim_bus_step();
+            i = UINT32_MAX;
+        }
+    }
+    for (uid = 0U; uid < sim_uid_num; uid++)
+    {
+        refused += (sim_uid_state[uid] == SIM_UID_REFUSED) ? 1U : 0U;
+        waiting += (sim_uid_state[uid] == SIM_UID_WAITING) ? 1U : 0U;
+    }
+
+    printf("%-16s: %5.0f frames/s, %7.0f payload B/s, load %5.1f%%, %u refused, %u dup, %u reordered, "
+           "%u send errors, %u padding errors, %u config errors, tdc %u\n",
+           name, ((double)sent * 1000000000.0) / (double)bus_time, payload, (100.0 * (double)busy) / (double)bus_time,
+           refused, sim_dup, sim_order_error, sim_send_error, sim_pad_error, sim_config_error, sim_tdc_offset);
+    TEST_CHECK(sim_dup == 0U, "%s: %u frames sent twice", name, sim_dup);
+    TEST_CHECK(sim_order_error == 0U, "%s: %u frames reordered within their ID", name, sim_order_error);
+    TEST_CHECK(sim_send_error == 0U, "%s: %u bad frames handed to FlexCAN", name, sim_send_error);
+    TEST_CHECK(sim_pad_error == 0U, "%s: %u bytes of padding not 0x%02X", name, sim_pad_error,
+               CAN_LLD_FD_PADDING_BYTE);
+    TEST_CHECK(sim_config_error == 0U, "%s: %u configuration errors", name, sim_config_error);
+    TEST_CHECK(can_lld_tx_pending() == 0U, "%s: %u frames pending at the end", name, can_lld_tx_pending());
+    if (!sw)
+    {
+        TEST_CHECK(busy >= (bus_time / 100U * 99U), "%s: bus idle for %llu ns", name,
+                   (unsigned long long)(bus_time - busy));
+        TEST_CHECK(waiting == 0U, "%s: %u frames never sent", name, waiting);
+        TEST_CHECK(can_lld_tx_error_num == 0U, "%s: %u frames dropped", name, can_lld_tx_error_num);
+        TEST_CHECK(sim_fd_sent == (fd ? sim_sent : 0U), "%s: %u of %u frames sent as FD", name, sim_fd_sent,
+                   sim_sent);
+    }
+    else
+    {
+        printf("    after the switch: %u frames sent, %u as FD, %u queued FD frames dropped, %u inits\n",
+               sent - sent_switch, sim_fd_sent - fd_sent_switch, dropped, sim_init_num);
+        TEST_CHECK(sim_fd_sent == fd_sent_switch, "%s: %u FD frames sent after the switch", name,
+                   sim_fd_sent - fd_sent_switch);
+        TEST_CHECK(sent > sent_switch, "%s: no classic frame sent after the switch", name);
+        /* what neither reached the bus nor was refused was dropped */
+        TEST_CHECK(waiting == dropped, "%s: %u frames never sent, %u dropped", name, waiting, dropped);
+        TEST_CHECK(sim_init_num == 1U, "%s: FlexCAN started %u times", name, sim_init_num);
+    }
+    return payload;
+}
+
+int main(int argc, char **argv)
+{
+    static const uint32_t fd_len[4] = {8U, 16U, 32U, 64U};
+    uint8_t data[CAN_LLD_PAYLOAD_MAX + 1U] = {0U};
+    uint32_t seconds = 10U;
+    double classic;
+    double fd;
+    uint32_t i;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:")) != -1)
+    {
+        switch (opt)
+        {
+        case 't':
+            seconds = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-t seconds]\n", argv[0]);
+            return 2;
+        }
+    }
+    sim_uid_msg = calloc(SIM_UID_MAX, sizeof(*sim_uid_msg));
+    sim_uid_state = calloc(SIM_UID_MAX, sizeof(*sim_uid_state));
+    if ((sim_uid_msg == NULL) || (sim_uid_state == NULL) || (((uint64_t)seconds * 8000U) >= SIM_UID_MAX))
+    {
+        fprintf(stderr, "%u s do not fit\n", seconds);
+        return 2;
+    }
+
+    printf("FD: %u mailboxes of %u bytes, %u for TX, padding 0x%02X\n", CAN_LLD_FD_MB_NUM, CAN_LLD_FD_PAYLOAD,
+           CAN_LLD_FD_TX_MB_NUM, CAN_LLD_FD_PADDING_BYTE);
+    can_lld_init();
+    TEST_CHECK(can_lld_get_mode() == CAN_LLD_MODE_INIT, "not started in the default mode");
+    TEST_CHECK(can_lld_tx(0x123U | CAN_LLD_TX_ID_FD, data, 8U) == STATUS_ERROR, "FD frame taken in classic mode");
+    TEST_CHECK(can_lld_tx(0x123U, data, 12U) == STATUS_ERROR, "12 bytes taken in classic mode");
+    TEST_CHECK(can_lld_tx(0x123U, data, CAN_LLD_PAYLOAD_MAX + 1U) == STATUS_ERROR, "%u bytes taken",
+               CAN_LLD_PAYLOAD_MAX + 1U);
+    TEST_CHECK(can_lld_tx_pending() == 0U, "a refused frame was queued");
+    for (i = 0U; i <= CAN_LLD_PAYLOAD_MAX; i++)
+    {
+        TEST_CHECK(can_lld_dlc_to_len(can_lld_len_to_dlc(i)) >= i, "%u bytes do not fit DLC %u", i,
+                   can_lld_len_to_dlc(i));
+    }
+
+    classic = sim_run(8U, false, 0U, false, seconds);
+    fd = 0.0;
+    for (i = 0U; i < 4U; i++)
+    {
+        fd = sim_run(fd_len[i], true, 1000000U, false, seconds);
+    }
+    printf("    FD 64 B @1M: %.1fx classic\n", fd / classic);
+    TEST_CHECK(fd > (2.0 * classic), "FD 64 bytes carries %.0f B/s, classic %.0f B/s", fd, classic);
+    fd = sim_run(64U, true, 2000000U, false, seconds);
+    printf("    FD 64 B @2M: %.1fx classic\n", fd / classic);
+    (void)sim_run(64U, true, 1000000U, true, seconds);
+
+    free(sim_uid_msg);
+    free(sim_uid_state);
+    printf("%s, %u checks, %u errors\n", (test_error == 0U) ? "PASS" : "FAIL", test_check_num, test_error);
+    return (test_error == 0U) ? 0 : 1;
+}
@@ -0,0 +1,153 @@
+#ifndef CAN_LLD_H
+#define CAN_LLD_H
+
+#include "canCom1.h"
+#include "flexcan_hw_access.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "can_lld_filter.h"
+
+#define RX_MSG_ID 0x100U
+#define CAN_LLD_PRINTF_TEST_ENABLE 0
+#define CAN_LLD_EVENT_COUNTER_DISPLAY_ENABLE 0
+#define CAN_LLD_ERROR_PRINT_ENABLE 1
+
+/* frames drained from the RX FIFO in the interrupt and kept for
+ * freertos_task_can_rx, must be a power of 2. 500kbit/s at full load is
+ * at most about 4500 frames/s with 8 data bytes. A slot holds a whole FD
+ * payload, 128 slots of 64 bytes are 10 KB of RAM */
+#define CAN_LLD_RX_QUEUE_SIZE 128U
+
+/* classic mode: the RX FIFO is emptied by eDMA channel 2 into a ring of raw
+ * FIFO entries instead of one interrupt per frame. The DMA interrupts at half
+ * and full ring only, freertos_task_can_rx also looks at the ring every
+ * CAN_LLD_RX_DMA_POLL_MS. A DMA error goes back to the interrupt path */
+#define CAN_LLD_RX_DMA_ENABLE 1
+/* FIFO entries of 16 bytes, must be a power of 2 */
+#define CAN_LLD_RX_DMA_SLOTS 128U
+#define CAN_LLD_RX_DMA_POLL_MS 1U
+
+/* TX mailbox pool in classic mode. With the RX FIFO and 8 ID filters the FIFO owns MB0-5 and
+ * the filter table MB6-7, the rest of max_num_mb (16) is used for TX except
+ * the dedicated RX mailboxes of can_lld_filter.inc at the top */
+#define CAN_LLD_TX_MB_FIRST 8U
+#define CAN_LLD_TX_MB_NUM (8U - CAN_LLD_FILTER_RX_MB_NUM)
+#define CAN_LLD_RX_MB_FIRST (CAN_LLD_TX_MB_FIRST + CAN_LLD_TX_MB_NUM)
+
+#if (CAN_LLD_FILTER_ELEMENT_NUM != 8U) || (CAN_LLD_FILTER_RX_MB_NUM > 7U)
+#error "can_lld_filter.h does not fit FLEXCAN_RX_FIFO_ID_FILTERS_8 and the TX pool"
+#endif
+
+/* mailbox RAM of CAN0, 32 mailboxes with 8 data bytes. In CAN FD mode every
+ * mailbox has CAN_LLD_FD_PAYLOAD data bytes and there are fewer of them:
+ * 16 bytes 21, 32 bytes 12, 64 bytes 7 */
+#define CAN_LLD_MB_RAM_SIZE 512U
+
+/* CAN FD mode, see can_lld_set_mode(). FlexCAN has no RX FIFO with FD
+ * enabled, the low mailboxes receive and the rest is the TX pool */
+#define CAN_LLD_FD_PAYLOAD 64U
+#define CAN_LLD_FD_MB_NUM (CAN_LLD_MB_RAM_SIZE / (8U + CAN_LLD_FD_PAYLOAD))
+
+/* RX mailboxes always compare IDE, standard and extended frames need their
+ * own. Two standard ones, one is read while the next frame fills the other */
+#define CAN_LLD_FD_RX_MB_STD_NUM 2U
+#define CAN_LLD_FD_RX_MB_NUM 3U
+#define CAN_LLD_FD_TX_MB_FIRST CAN_LLD_FD_RX_MB_NUM
+#define CAN_LLD_FD_TX_MB_NUM (CAN_LLD_FD_MB_NUM - CAN_LLD_FD_RX_MB_NUM)
+
+/* send the data phase of FD frames with the bitrate_cbt timing */
+#define CAN_LLD_FD_BRS_ENABLE 1
+
+/* fills a FD frame up to the next length a DLC can code */
+#define CAN_LLD_FD_PADDING_BYTE 0xCCU
+
+#if (CAN_LLD_FD_PAYLOAD != 8U) && (CAN_LLD_FD_PAYLOAD != 16U) && \
+    (CAN_LLD_FD_PAYLOAD != 32U) && (CAN_LLD_FD_PAYLOAD != 64U)
+#error "CAN_LLD_FD_PAYLOAD must be 8, 16, 32 or 64"
+#endif
+
+#define CAN_LLD_PAYLOAD_MAX CAN_LLD_FD_PAYLOAD
+#define CAN_LLD_TX_MB_MAX ((CAN_LLD_TX_MB_NUM > CAN_LLD_FD_TX_MB_NUM) ? CAN_LLD_TX_MB_NUM : CAN_LLD_FD_TX_MB_NUM)
+#define CAN_LLD_RX_MB_MAX ((CAN_LLD_FILTER_RX_MB_NUM > CAN_LLD_FD_RX_MB_NUM) ? CAN_LLD_FILTER_RX_MB_NUM : CAN_LLD_FD_RX_MB_NUM)
+
+/* frames waiting for a free TX mailbox, kept in CAN ID priority order */
+#define CAN_LLD_TX_QUEUE_SIZE 32U
+
+/* when the pool is full, abort the lowest priority mailbox that is still
+ * waiting for arbitration to make room for a higher priority frame. A frame
+ * already on the wire is never aborted, FlexCAN finishes it */
+#ifndef CAN_LLD_TX_CANCEL_ENABLE
+#define CAN_LLD_TX_CANCEL_ENABLE 1
+#endif
+
+/* or'ed into the messageId of can_lld_tx() to send a 29 bit ID */
+#define CAN_LLD_TX_ID_EXT 0x80000000U
+/* or'ed into the messageId of can_lld_tx() to send 8 bytes or less as a FD
+ * frame, longer frames are always FD frames */
+#define CAN_LLD_TX_ID_FD 0x40000000U
+
+/* the FlexCAN free running timer in the CS word, one count per CAN bit */
+#define CAN_LLD_CS_TIME_STAMP_MASK 0xFFFFU
+/* extended data length bit of the CS word, set for a FD frame */
+#define CAN_LLD_CS_EDL_MASK 0x80000000U
+
+typedef enum
+{
+    CAN_LLD_MODE_CLASSIC = 0,
+    CAN_LLD_MODE_FD
+} can_lld_mode_t;
+
+/* mode after can_lld_init() */
+#define CAN_LLD_MODE_INIT CAN_LLD_MODE_CLASSIC
+
+typedef struct
+{
+    uint32_t tick;      /* FreeRTOS tick when the frame left the RX FIFO or
+                         * the RX DMA ring */
+    uint32_t cs;        /* CS word, IDE, RTR, DLC and the FlexCAN time stamp */
+    uint32_t msgId;
+    uint8_t dataLen;
+    uint8_t data[CAN_LLD_PAYLOAD_MAX];
+} can_lld_rx_frame_t;
+
+/* a dedicated RX mailbox of can_lld_filter.inc */
+typedef struct
+{
+    bool ext;
+    uint32_t id;
+    uint32_t mask;      /* individual mask, 1 = bit compared */
+} can_lld_filter_mb_t;
+
+extern uint32_t can_lld_rx_frame_num;
+extern uint32_t can_lld_rx_queue_overflow_num;
+extern uint32_t can_lld_rx_queue_peak;
+extern uint32_t can_lld_rx_fifo_overflow_num;
+extern uint32_t can_lld_tx_frame_num;
+extern uint32_t can_lld_tx_complete_num;
+extern uint32_t can_lld_tx_queue_full_num;
+extern uint32_t can_lld_tx_queue_peak;
+extern uint32_t can_lld_tx_cancel_num;
+extern uint32_t can_lld_tx_error_num;
+extern uint32_t can_lld_tx_fd_frame_num;
+extern uint32_t can_lld_rx_fd_frame_num;
+extern uint32_t can_lld_dma_complete_num;
+extern uint32_t can_lld_dma_error_num;
+
+void can_lld_init(void);
+void can_lld_step(void);
+status_t can_lld_tx(uint32_t messageId, const uint8_t *data, uint32_t len);
+uint32_t can_lld_tx_pending(void);
+status_t can_lld_set_mode(can_lld_mode_t mode);
+can_lld_mode_t can_lld_get_mode(void);
+uint8_t can_lld_len_to_dlc(uint32_t len);
+uint32_t can_lld_dlc_to_len(uint8_t dlc);
+void can_lld_cbk_func(uint8_t instance, flexcan_event_type_t eventType,
+                                   uint32_t buffIdx, flexcan_state_t *flexcanState);
+void can_lld_fifo_rx_func(void);
+bool can_lld_rx_get(can_lld_rx_frame_t *frame);
+bool can_lld_rx_wait(can_lld_rx_frame_t *frame, TickType_t timeout);
+uint32_t can_lld_rx_pending(void);
+bool can_lld_rx_dma_running(void);
+void can_lld_rx_wake(void);
+
+#endif
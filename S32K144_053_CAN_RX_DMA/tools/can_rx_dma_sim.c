@@ -0,0 +1,792 @@
+/* Host model of the FlexCAN RX FIFO emptied by eDMA channel 2 against the
+ * interrupt per frame path. can_lld.c is built as it is into this file, so
+ * the model writes the DMA ring and sees the waiter of freertos_task_can_rx.
+ *
+ * A 6 deep RX FIFO receives 8 byte standard frames at 500 kbit/s, back to
+ * back at 100% load (228 us with worst case stuffing) or spread out at 50%
+ * and 25%, for a number of seconds each. With the DMA ring every frame goes
+ * into the next ring entry, the channel interrupts at half and full ring and
+ * the task also runs every CAN_LLD_RX_DMA_POLL_MS. On the interrupt path the
+ * stub driver copies the entry into the buffer of FLEXCAN_DRV_RxFifo() and
+ * calls the RXFIFO_COMPLETE event, the FIFO stays full until it is armed
+ * again. The CPU work is counted in cycles per event, estimated for the
+ * Cortex-M4F at 112 MHz (see the C_ defines).
+ *
+ *   - DMA ring at 25%, 50% and 100% load
+ *   - the task one ring behind the DMA: the ring full and the DMA in the
+ *     minor loop of one more frame, over the oldest entry, while the task
+ *     copies it. Once with the interrupts on time, once with the interrupt
+ *     of the last half still to come
+ *   - a DMA error after frame 20000 at 100% load, which restarts FlexCAN
+ *     with the FIFO interrupt
+ *   - the interrupt path at 25%, 50% and 100% load, which the driver keeps
+ *     after the error
+ *
+ * Every frame must arrive once and in order, without a FIFO or ring
+ * overflow, also across the restart, and the DMA ring must take fewer
+ * interrupts and fewer cycles than the interrupt path at the same load.
+ * One ring behind, frames are lost, but every frame taken must be the one
+ * written to its entry and every lost one counted.
+ * Exit status 1 on a failed check.
+ *
+ * build: gcc -O2 -Wall -Wno-pointer-to-int-cast -I.. -I../../S32K144_051_ISO_TP
+ *            -I../../S32K144_050_CAN_filter_compiler -I../../S32K144_057_CAN_socketcan/host
+ *            -o can_rx_dma_sim can_rx_dma_sim.c
+ *        (the DMA addresses of can_lld.c are 32 bit, the model writes the
+ *        ring itself)
+ * usage: can_rx_dma_sim [-t seconds]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "can_lld.c"
+
+/* 500 kbit/s, 8 byte standard frame with worst case stuffing and the
+ * intermission: 111 + 3 bits */
+#define SIM_FRAME_NS 228000U
+#define SIM_FIFO_DEPTH 6U
+#define SIM_CPU_HZ 112000000.0
+#define SIM_TICK_NS (1000000000U / configTICK_RATE_HZ)
+/* frame after which the DMA error is injected */
+#define SIM_ERROR_FRAME 20000U
+/* CITER reads a minor loop takes in sim_behind(): from the check before the
+ * copy of an entry to the one before the next */
+#define SIM_TEAR_READS 3U
+/* sequence numbers of sim_behind(), above those of the runs */
+#define SIM_BEHIND_SEQ 0x1000000U
+
+/* cycle costs, Cortex-M4F */
+#define C_IRQ          30U  /* exception entry and exit */
+#define C_CAN_IRQ     220U  /* SDK FlexCAN handler: flag scan, FIFO read and swap, state */
+#define C_CAN_CBK     110U  /* can_lld_cbk_func and can_lld_rx_push */
+#define C_REARM       120U  /* FLEXCAN_DRV_RxFifo */
+#define C_NOTIFY      150U  /* vTaskNotifyGiveFromISR to a blocked task */
+#define C_WAKE        360U  /* PendSV in and out, ulTaskNotifyTake blocking again */
+#define C_TICK_WAKE   100U  /* tick interrupt work to end a timeout */
+#define C_GET_Q        40U  /* can_lld_rx_get from the queue, per frame */
+#define C_GET_DMA      60U  /* one ring entry converted, per frame */
+#define C_CITER        40U  /* EDMA_DRV_GetRemainingMajorIterationsCount */
+#define C_DMA_IRQ     150U  /* SDK eDMA handler and can_lld_rx_dma_cbk */
+
+typedef struct
+{
+    uint32_t cs;
+    uint32_t id;
+    uint32_t data[2];
+} sim_fifo_entry_t;
+
+typedef struct
+{
+    double cpu;
+    double irq;
+} sim_result_t;
+
+static uint32_t test_error = 0U;
+static uint32_t test_check_num = 0U;
+
+#define TEST_CHECK(cond, ...) do { test_check_num++; if (!(cond)) { printf("FAIL: " __VA_ARGS__); printf("\n"); test_error++; } } while (0)
+
+/* SDK and FreeRTOS, as far as can_lld.c uses them */
+
+flexcan_state_t canCom1_State;
+const flexcan_user_config_t canCom1_InitConfig0 =
+{
+    .max_num_mb = 16U,
+    .is_rx_fifo_needed = true
+};
+lpspi_state_t lpspiCom1State;
+const lpspi_master_config_t lpspiCom1_MasterConfig0;
+const sbc_int_config_t sbc_uja116x1_InitConfig0;
+static CAN_Type sim_can0;
+static flexcan_callback_t sim_callback;
+static flexcan_rxfifo_transfer_type_t sim_transfer_type;
+static uint32_t sim_init_num;
+static bool sim_fifo_armed;
+static flexcan_msgbuff_t *sim_fifo_buf;
+
+static sim_fifo_entry_t sim_fifo[SIM_FIFO_DEPTH];
+static uint32_t sim_fifo_num;
+static uint32_t sim_fifo_overflow;
+
+static edma_callback_t sim_dma_callback;
+static bool sim_dma_run;
+static uint32_t sim_dma_citer;
+static uint64_t sim_citer_reads;
+static bool sim_irq_hold;
+static uint32_t sim_irq_late;
+static uint32_t sim_tear;
+
+static uint64_t sim_now;                    /* ns */
+static bool sim_notified;
+static uint64_t sim_cycles;
+static uint32_t sim_irq_num;
+static uint32_t sim_wake_num;
+static uint32_t sim_delivered;
+static uint32_t sim_order_error;
+static uint32_t sim_last_seq;
+static bool sim_seen;
+
+CAN_Type *flexcan_host_regs(void)
+{
+    return &sim_can0;
+}
+
+status_t LPSPI_DRV_MasterInit(uint32_t instance, lpspi_state_t *lpspiState, const lpspi_master_config_t *spiConfig)
+{
+    (void)instance;
+    (void)lpspiState;
+    (void)spiConfig;
+    return STATUS_SUCCESS;
+}
+
+status_t SBC_Init(const sbc_int_config_t *const config, const uint32_t lpspiInstance)
+{
+    (void)config;
+    (void)lpspiInstance;
+    return STATUS_SUCCESS;
+}
+
+void INT_SYS_SetPriority(IRQn_Type irqNumber, uint8_t priority)
+{
+    (void)irqNumber;
+    (void)priority;
+}
+
+void vPortEnterCritical(void)
+{
+}
+
+void vPortExitCritical(void)
+{
+}
+
+void FLEXCAN_DRV_GetDefaultConfig(flexcan_user_config_t *config)
+{
+    memset(config, 0, sizeof(*config));
+}
+
+status_t FLEXCAN_DRV_Init(uint8_t instance, flexcan_state_t *state, const flexcan_user_config_t *data)
+{
+    (void)instance;
+    (void)state;
+    sim_transfer_type = data->transfer_type;
+    sim_fifo_armed = false;
+    sim_init_num++;
+    return STATUS_SUCCESS;
+}
+
+status_t FLEXCAN_DRV_Deinit(uint8_t instance)
+{
+    (void)instance;
+    return STATUS_SUCCESS;
+}
+
+void FLEXCAN_DRV_SetTDCOffset(uint8_t instance, bool enable, uint8_t offset)
+{
+    (void)instance;
+    (void)enable;
+    (void)offset;
+}
+
+void FLEXCAN_DRV_ConfigRxFifo(uint8_t instance, flexcan_rx_fifo_id_element_format_t id_format,
+                              const flexcan_id_table_t *id_filter_table)
+{
+    (void)instance;
+    (void)id_format;
+    (void)id_filter_table;
+}
+
+void FLEXCAN_DRV_SetRxFifoGlobalMask(uint8_t instance, flexcan_msgbuff_id_type_t id_type, uint32_t mask)
+{
+    (void)instance;
+    (void)id_type;
+    (void)mask;
+}
+
+void FLEXCAN_DRV_InstallEventCallback(uint8_t instance, flexcan_callback_t callback, void *callbackParam)
+{
+    (void)instance;
+    (void)callbackParam;
+    sim_callback = callback;
+}
+
+status_t FLEXCAN_DRV_RxFifo(uint8_t instance, flexcan_msgbuff_t *data)
+{
+    (void)instance;
+    sim_fifo_armed = true;
+    sim_fifo_buf = data;
+    return STATUS_SUCCESS;
+}
+
+uint32_t FLEXCAN_DRV_GetErrorStatus(uint8_t instance)
+{
+    (void)instance;
+    return 0U;
+}
+
+void FLEXCAN_ClearErrIntStatusFlag(CAN_Type *base)
+{
+    (void)base;
+}
+
+void FLEXCAN_EnterFreezeMode(CAN_Type *base)
+{
+    (void)base;
+}
+
+void FLEXCAN_ExitFreezeMode(CAN_Type *base)
+{
+    (void)base;
+}
+
+void FLEXCAN_DRV_SetRxMaskType(uint8_t instance, flexcan_rx_mask_type_t type)
+{
+    (void)instance;
+    (void)type;
+}
+
+status_t FLEXCAN_DRV_ConfigRxMb(uint8_t instance, uint8_t mb_idx, const flexcan_data_info_t *rx_info, uint32_t msg_id)
+{
+    (void)instance;
+    (void)mb_idx;
+    (void)rx_info;
+    (void)msg_id;
+    return STATUS_SUCCESS;
+}
+
+status_t FLEXCAN_DRV_SetRxIndividualMask(uint8_t instance, flexcan_msgbuff_id_type_t id_type, uint8_t mb_idx,
+                                         uint32_t mask)
+{
+    (void)instance;
+    (void)id_type;
+    (void)mb_idx;
+    (void)mask;
+    return STATUS_SUCCESS;
+}
+
+status_t FLEXCAN_DRV_Receive(uint8_t instance, uint8_t mb_idx, flexcan_msgbuff_t *data)
+{
+    (void)instance;
+    (void)mb_idx;
+    (void)data;
+    return STATUS_SUCCESS;
+}
+
+status_t FLEXCAN_DRV_ConfigTxMb(uint8_t instance, uint8_t mb_idx, const flexcan_data_info_t *tx_info, uint32_t msg_id)
+{
+    (void)instance;
+    (void)mb_idx;
+    (void)tx_info;
+    (void)msg_id;
+    return STATUS_SUCCESS;
+}
+
+status_t FLEXCAN_DRV_Send(uint8_t instance, uint8_t mb_idx, const flexcan_data_info_t *tx_info, uint32_t msg_id,
+                          const uint8_t *mb_data)
+{
+    (void)instance;
+    (void)mb_idx;
+    (void)tx_info;
+    (void)msg_id;
+    (void)mb_data;
+    return STATUS_SUCCESS;
+}
+
+status_t FLEXCAN_DRV_AbortTransfer(uint8_t instance, uint8_t mb_idx)
+{
+    (void)instance;
+    (void)mb_idx;
+    return STATUS_SUCCESS;
+}
+
+TickType_t xTaskGetTickCountFromISR(void)
+{
+    return (TickType_t)(sim_now / SIM_TICK_NS);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(sim_now / SIM_TICK_NS);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return (TaskHandle_t)1;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    (void)xTaskToNotify;
+    (void)pxHigherPriorityTaskWoken;
+    sim_notified = true;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify)
+{
+    (void)xTaskToNotify;
+    sim_notified = true;
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait)
+{
+    (void)xClearCountOnExit;
+    (void)xTicksToWait;
+    return 0U;
+}
+
+/* ISO-TP is not part of this measurement */
+void isotp_init(void)
+{
+}
+
+void isotp_channel_open(uint8_t channel, const isotp_channel_config_t *config)
+{
+    (void)channel;
+    (void)config;
+}
+
+bool isotp_rx_frame(const can_lld_rx_frame_t *frame)
+{
+    (void)frame;
+    return false;
+}
+
+status_t isotp_send(uint8_t channel, const uint8_t *data, uint32_t len)
+{
+    (void)channel;
+    (void)data;
+    (void)len;
+    return STATUS_SUCCESS;
+}
+
+TickType_t isotp_step(void)
+{
+    return portMAX_DELAY;
+}
+
+/* eDMA channel 2 */
+
+status_t EDMA_DRV_ConfigLoopTransfer(uint8_t channel, const edma_transfer_config_t *transferConfig)
+{
+    (void)channel;
+    sim_dma_citer = transferConfig->loopTransferConfig->majorLoopIterationCount;
+    return STATUS_SUCCESS;
+}
+
+void EDMA_DRV_DisableRequestsOnTransferComplete(uint8_t channel, bool disable)
+{
+    (void)channel;
+    (void)disable;
+}
+
+void EDMA_DRV_ConfigureInterrupt(uint8_t channel, edma_channel_interrupt_t intSrc, bool enable)
+{
+    (void)channel;
+    (void)intSrc;
+    (void)enable;
+}
+
+status_t EDMA_DRV_InstallCallback(uint8_t channel, edma_callback_t callback, void *parameter)
+{
+    (void)channel;
+    (void)parameter;
+    sim_dma_callback = callback;
+    return STATUS_SUCCESS;
+}
+
+status_t EDMA_DRV_StartChannel(uint8_t channel)
+{
+    (void)channel;
+    sim_dma_run = true;
+    return STATUS_SUCCESS;
+}
+
+status_t EDMA_DRV_StopChannel(uint8_t channel)
+{
+    (void)channel;
+    sim_dma_run = false;
+    return STATUS_SUCCESS;
+}
+
+static void sim_dma_minor_start(void);
+static void sim_dma_minor_end(void);
+
+uint32_t EDMA_DRV_GetRemainingMajorIterationsCount(uint8_t channel)
+{
+    (void)channel;
+    sim_citer_reads++;
+    if (sim_tear != 0U)
+    {
+        /* the minor loop of the FIFO output runs across the reads */
+        if (sim_tear == SIM_TEAR_READS)
+        {
+            sim_dma_minor_start();
+        }
+        sim_tear--;
+        if (sim_tear == 0U)
+        {
+            sim_dma_minor_end();
+        }
+    }
+    return sim_dma_citer;
+}
+
+/* the model */
+
+static void sim_fifo_pop(void)
+{
+    sim_fifo_num--;
+    memmove(&sim_fifo[0], &sim_fifo[1], sizeof(sim_fifo[0]) * sim_fifo_num);
+}
+
+static void sim_dma_irq(edma_chn_status_t status)
+{
+    sim_cycles += C_IRQ + C_DMA_IRQ;
+    sim_irq_num++;
+    sim_dma_callback(NULL, status);
+    sim_cycles += sim_notified ? C_NOTIFY : 0U;
+}
+
+/* @brief: First words of a minor loop, CS and ID of the FIFO output go to
+ *         the next entry, CITER does not count it yet
+ * @return: None
+ */
+static void sim_dma_minor_start(void)
+{
+    can_lld_rx_dma_slot_t *slot = &can_lld_rx_dma_buf[CAN_LLD_RX_DMA_SLOTS - sim_dma_citer];
+
+    slot->cs = sim_fifo[0].cs;
+    slot->id = sim_fifo[0].id;
+}
+
+/* @brief: Rest of the minor loop, the data words, then CITER and the
+ *         interrupt at half and full ring. With sim_irq_hold the interrupt
+ *         waits in sim_irq_late
+ * @return: None
+ */
+static void sim_dma_minor_end(void)
+{
+    can_lld_rx_dma_slot_t *slot = &can_lld_rx_dma_buf[CAN_LLD_RX_DMA_SLOTS - sim_dma_citer];
+
+    slot->data[0] = sim_fifo[0].data[0];
+    slot->data[1] = sim_fifo[0].data[1];
+    sim_fifo_pop();
+    sim_dma_citer--;
+    if (sim_dma_citer == 0U)
+    {
+        sim_dma_citer = CAN_LLD_RX_DMA_SLOTS;
+    }
+    else if (sim_dma_citer != CAN_LLD_RX_DMA_HALF)
+    {
+        return;
+    }
+    if (sim_irq_hold)
+    {
+        sim_irq_late++;
+    }
+    else
+    {
+        sim_dma_irq(EDMA_CHN_NORMAL);
+    }
+}
+
+/* @brief: Move the FIFO entries on, by DMA or by the FIFO interrupt
+ * @return: None
+ */
+static void sim_fifo_service(void)
+{
+    uint32_t data;
+
+    while (sim_fifo_num != 0U)
+    {
+        if (sim_dma_run)
+        {
+            sim_dma_minor_start();
+            sim_dma_minor_end();
+        }
+        else if ((sim_transfer_type == FLEXCAN_RXFIFO_USING_INTERRUPTS) && sim_fifo_armed)
+        {
+            sim_fifo_armed = false;
+            sim_fifo_buf->cs = sim_fifo[0].cs;
+            sim_fifo_buf->msgId = (sim_fifo[0].id >> CAN_LLD_ID_STD_SHIFT) & 0x7FFU;
+            sim_fifo_buf->dataLen = 8U;
+            /* the SDK swaps the bytes of the data words */
+            data = __builtin_bswap32(sim_fifo[0].data[0]);
+            memcpy(&sim_fifo_buf->data[0], &data, sizeof(data));
+            data = __builtin_bswap32(sim_fifo[0].data[1]);
+            memcpy(&sim_fifo_buf->data[4], &data, sizeof(data));
+            sim_fifo_pop();
+            sim_cycles += C_IRQ + C_CAN_IRQ + C_CAN_CBK + C_REARM;
+            sim_irq_num++;
+            sim_callback(INST_CANCOM1, FLEXCAN_EVENT_RXFIFO_COMPLETE, 0U, &canCom1_State);
+            sim_cycles += sim_notified ? C_NOTIFY : 0U;
+        }
+        else
+        {
+            break;
+        }
+    }
+}
+
+static void sim_fifo_rx(uint32_t seq)
+{
+    sim_fifo_entry_t *entry = &sim_fifo[sim_fifo_num];
+
+    if (sim_fifo_num == SIM_FIFO_DEPTH)
+    {
+        sim_fifo_overflow++;
+        return;
+    }
+    entry->cs = 8UL << CAN_LLD_CS_DLC_SHIFT;
+    /* 5 is no divisor of the ring size, an entry written again a ring later
+     * gets another ID */
+    entry->id = (0x100UL + (seq % 5U)) << CAN_LLD_ID_STD_SHIFT;
+    /* the FIFO holds the data big endian */
+    entry->data[0] = __builtin_bswap32(seq);
+    entry->data[1] = 0U;
+    sim_fifo_num++;
+}
+
+/* @brief: One pass of freertos_task_can_rx between two waits
+ * @return: None
+ */
+static void sim_task(void)
+{
+    can_lld_rx_frame_t frame;
+    const uint64_t reads = sim_citer_reads;
+    uint32_t seq;
+
+    can_lld_rx_waiter = NULL;
+    while (can_lld_rx_get(&frame))
+    {
+        memcpy(&seq, frame.data, sizeof(seq));
+        if (sim_seen && (seq <= sim_last_seq))
+        {
+            sim_order_error++;
+        }
+        sim_seen = true;
+        sim_last_seq = seq;
+        sim_delivered++;
+        sim_cycles += can_lld_rx_dma_on ? C_GET_DMA : C_GET_Q;
+    }
+    can_lld_rx_dma_check();
+    sim_cycles += (sim_citer_reads - reads) * C_CITER;
+    can_lld_rx_waiter = (TaskHandle_t)1;
+}
+
+/* @brief: Receive frames at a load for a time, the driver stays in the
+ *         state the run before left it
+ * @param percent : bus load
+ * @param inject  : DMA error after SIM_ERROR_FRAME
+ * @param seconds : bus time
+ * @return        : CPU load and interrupts per second
+ */
+static sim_result_t sim_run(uint32_t percent, bool inject, uint32_t seconds)
+{
+    const uint64_t poll_ns = (uint64_t)pdMS_TO_TICKS(CAN_LLD_RX_DMA_POLL_MS) * SIM_TICK_NS;
+    const uint64_t frame_ns = ((uint64_t)SIM_FRAME_NS * 100U) / percent;
+    const uint64_t end = sim_now + ((uint64_t)seconds * 1000000000U);
+    const bool dma = can_lld_rx_dma_on;
+    const uint32_t init_num = sim_init_num;
+    uint64_t next_frame = sim_now + frame_ns;
+    uint64_t next_poll = dma ? (sim_now + poll_ns) : UINT64_MAX;
+    uint32_t sent = 0U;
+    sim_result_t result;
+    uint64_t t;
+
+    sim_notified = false;
+    sim_cycles = 0U;
+    sim_irq_num = 0U;
+    sim_wake_num = 0U;
+    sim_delivered = 0U;
+    sim_order_error = 0U;
+    sim_seen = false;
+    sim_fifo_overflow = 0U;
+    can_lld_rx_queue_overflow_num = 0U;
+    can_lld_rx_queue_peak = 0U;
+    can_lld_rx_waiter = (TaskHandle_t)1;
+
+    while (sim_now < end)
+    {
+        t = (next_frame < next_poll) ? next_frame : next_poll;
+        sim_now = t;
+        if (t == next_frame)
+        {
+            if (inject && (sent == SIM_ERROR_FRAME))
+            {
+                /* the channel stops with the error */
+                sim_dma_run = false;
+                sim_dma_irq(EDMA_CHN_ERROR);
+            }
+            sim_fifo_rx(sent);
+            sent++;
+            next_frame += frame_ns;
+            sim_fifo_service();
+        }
+        if (t == next_poll)
+        {
+            /* the timeout of the wait ends in the tick interrupt */
+            sim_cycles += C_IRQ + C_TICK_WAKE;
+            sim_notified = true;
+        }
+        if (sim_notified)
+        {
+            sim_notified = false;
+            sim_wake_num++;
+            sim_cycles += C_WAKE;
+            sim_task();
+            /* the interrupt path armed the FIFO again */
+            sim_fifo_service();
+            next_poll = can_lld_rx_dma_on ? (sim_now + poll_ns) : UINT64_MAX;
+        }
+    }
+    /* what the last poll period left in the ring */
+    sim_task();
+
+    result.cpu = (100.0 * (double)sim_cycles) / (SIM_CPU_HZ * (double)seconds);
+    result.irq = (double)sim_irq_num / (double)seconds;
+    printf("%-10s %3u%%: %5.0f frames/s, %u/%u delivered, %u reordered, FIFO overflow %u, ring overflow %u, "
+           "%5.0f irq/s, %5.0f wakes/s, CPU %5.2f%% (%4.0f cycles/frame)\n",
+           inject ? "DMA+error" : (dma ? "DMA ring" : "interrupt"), percent, (double)sent / (double)seconds,
+           sim_delivered, sent, sim_order_error, sim_fifo_overflow, can_lld_rx_queue_overflow_num, result.irq,
+           (double)sim_wake_num / (double)seconds, result.cpu, (double)sim_cycles / (double)sent);
+    TEST_CHECK(sim_delivered == sent, "%u%%: %u of %u frames delivered", percent, sim_delivered, sent);
+    TEST_CHECK(sim_order_error == 0U, "%u%%: %u frames reordered", percent, sim_order_error);
+    TEST_CHECK(sim_fifo_overflow == 0U, "%u%%: %u FIFO overflows", percent, sim_fifo_overflow);
+    TEST_CHECK(can_lld_rx_queue_overflow_num == 0U, "%u%%: %u ring or queue overflows", percent,
+               can_lld_rx_queue_overflow_num);
+    if (inject)
+    {
+        printf("    DMA error after frame %u: %u restart, now on %s\n", SIM_ERROR_FRAME, sim_init_num - init_num,
+               can_lld_rx_dma_on ? "the DMA ring" : "interrupts");
+        TEST_CHECK(sim_init_num == (init_num + 1U), "FlexCAN started %u times after the DMA error",
+                   sim_init_num - init_num);
+        TEST_CHECK(!can_lld_rx_dma_on && (sim_transfer_type == FLEXCAN_RXFIFO_USING_INTERRUPTS),
+                   "still on the DMA after the DMA error");
+    }
+    return result;
+}
+
+/* @brief: The task one ring behind the DMA. The ring is full and the DMA
+ *         starts the minor loop of one more frame, over the oldest entry,
+ *         when the task reads CITER before it copies that entry. Frames are
+ *         lost, every one taken must be the one written to its entry
+ * @param late : the interrupt of the last half comes after the task
+ * @return     : None
+ */
+static void sim_behind(bool late)
+{
+    can_lld_rx_frame_t frame;
+    uint32_t seq = SIM_BEHIND_SEQ + (late ? CAN_LLD_RX_DMA_SLOTS * 2U : 0U);
+    uint32_t first;
+    uint32_t last;
+    uint32_t overflow;
+    uint32_t taken = 0U;
+    uint32_t torn = 0U;
+    uint32_t n;
+    uint32_t i;
+
+    /* the DMA in the middle of a half, a ring from there takes the
+     * interrupts of two halves and the last of them may wait */
+    sim_task();
+    while ((sim_dma_citer % CAN_LLD_RX_DMA_HALF) != (CAN_LLD_RX_DMA_HALF / 2U))
+    {
+        sim_fifo_rx(seq++);
+        sim_fifo_service();
+        sim_task();
+    }
+    sim_notified = false;
+    overflow = can_lld_rx_queue_overflow_num;
+
+    first = seq;
+    for (i = 0U; i < CAN_LLD_RX_DMA_SLOTS; i++)
+    {
+        sim_irq_hold = late && (i >= CAN_LLD_RX_DMA_HALF);
+        sim_fifo_rx(seq++);
+        sim_fifo_service();
+    }
+    sim_fifo_rx(seq++);
+    sim_tear = SIM_TEAR_READS;
+
+    last = first - 1U;
+    while (can_lld_rx_get(&frame))
+    {
+        memcpy(&n, frame.data, sizeof(n));
+        if ((n <= last) || (n >= seq) || (frame.msgId != (0x100U + (n % 5U))))
+        {
+            torn++;
+        }
+        last = n;
+        taken++;
+    }
+    overflow = can_lld_rx_queue_overflow_num - overflow;
+
+    sim_irq_hold = false;
+    for (; sim_irq_late != 0U; sim_irq_late--)
+    {
+        sim_dma_irq(EDMA_CHN_NORMAL);
+    }
+    sim_notified = false;
+    TEST_CHECK(!can_lld_rx_get(&frame), "one ring behind: a frame after the late interrupt");
+
+    printf("one ring behind%s: %u of %u frames taken, %u lost, %u torn\n",
+           late ? ", half interrupt late" : "", taken, seq - first, overflow, torn);
+    TEST_CHECK(sim_tear == 0U, "one ring behind: the minor loop did not end");
+    TEST_CHECK(torn == 0U, "one ring behind: %u frames taken from entries written again", torn);
+    TEST_CHECK(overflow != 0U, "one ring behind: no frame lost");
+    TEST_CHECK((taken + overflow) == (seq - first), "one ring behind: %u taken and %u lost of %u", taken, overflow,
+               seq - first);
+}
+
+int main(int argc, char **argv)
+{
+    static const uint32_t load[3] = {25U, 50U, 100U};
+    sim_result_t dma[3];
+    sim_result_t irq;
+    uint32_t seconds = 10U;
+    uint32_t i;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:")) != -1)
+    {
+        switch (opt)
+        {
+        case 't':
+            seconds = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-t seconds]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (((uint64_t)seconds * 1000000000U / SIM_FRAME_NS) <= SIM_ERROR_FRAME)
+    {
+        fprintf(stderr, "%u s do not reach frame %u\n", seconds, SIM_ERROR_FRAME);
+        return 2;
+    }
+
+    printf("RX FIFO of %u entries, DMA ring of %u, poll every %u ms, %.0f MHz\n", SIM_FIFO_DEPTH,
+           CAN_LLD_RX_DMA_SLOTS, CAN_LLD_RX_DMA_POLL_MS, SIM_CPU_HZ / 1e6);
+    can_lld_init();
+    TEST_CHECK(can_lld_rx_dma_running(), "RX DMA not running after can_lld_init()");
+    TEST_CHECK(sim_transfer_type == FLEXCAN_RXFIFO_USING_DMA, "FlexCAN not started for the DMA");
+    for (i = 0U; i < 3U; i++)
+    {
+        dma[i] = sim_run(load[i], false, seconds);
+    }
+    sim_behind(false);
+    sim_behind(true);
+    (void)sim_run(100U, true, seconds);
+    for (i = 0U; i < 3U; i++)
+    {
+        irq = sim_run(load[i], false, seconds);
+        TEST_CHECK(dma[i].irq < (irq.irq / 10.0), "%u%%: %.0f DMA irq/s, %.0f FIFO irq/s", load[i], dma[i].irq,
+                   irq.irq);
+        TEST_CHECK(dma[i].cpu < irq.cpu, "%u%%: DMA ring %.2f%% CPU, interrupts %.2f%%", load[i], dma[i].cpu,
+                   irq.cpu);
+    }
+
+    printf("%s, %u checks, %u errors\n", (test_error == 0U) ? "PASS" : "FAIL", test_check_num, test_error);
+    return (test_error == 0U) ? 0 : 1;
+}
@@ -0,0 +1,274 @@
+/* Host side reader of the CAN statistics snapshots of can_stats_export().
+ *
+ * The input is a raw capture of the UART, the snapshot packets sit between
+ * the printf lines. Every packet with a good CRC is decoded, a summary packet
+ * starts a new snapshot and the ID packets after it are printed as a table.
+ * With -c the same is written as CSV, one line per ID and snapshot, to size a
+ * bus schedule from a long capture in a spreadsheet.
+ *
+ * build: gcc -O2 -o can_stats_dump can_stats_dump.c
+ * usage: can_stats_dump [-t tick_hz] [-c] [capture.bin]
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* must match can_stats.h */
+#define PACKET_SUMMARY 0x01U
+#define PACKET_ID 0x02U
+#define PACKET_VERSION 1U
+#define PACKET_OVERHEAD 6U
+#define HIST_NUM 16U
+#define ERROR_NUM 19U
+#define SUMMARY_SIZE (24U + (4U * ERROR_NUM))
+#define ID_SIZE (30U + (2U * HIST_NUM))
+#define ID_EXT 0x80000000U
+
+static const char *const error_names[ERROR_NUM] = {
+    "bit0", "bit1", "stuff", "form", "crc", "ack",
+    "bit0 fast", "bit1 fast", "stuff fast", "form fast", "crc fast",
+    "rx warning", "tx warning", "error passive", "bus off",
+    "rx fifo overflow", "rx queue overflow", "tx queue full", "dma",
+};
+
+static double tick_ms = 0.1;
+static bool csv = false;
+static uint32_t snapshot_num = 0U;
+static uint32_t snapshot_tick = 0U;
+static uint32_t bad_crc_num = 0U;
+
+static uint32_t get16(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8);
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+    return get16(p) | (get16(&p[2]) << 16);
+}
+
+/* CRC-16/CCITT-FALSE */
+static uint16_t crc16(const uint8_t *data, uint32_t len)
+{
+    uint16_t crc = 0xFFFFU;
+    uint32_t i;
+    uint32_t bit;
+
+    for (i = 0U; i < len; i++)
+    {
+        crc ^= (uint16_t)(data[i] << 8);
+        for (bit = 0U; bit < 8U; bit++)
+        {
+            crc = (crc & 0x8000U) ? (uint16_t)((crc << 1) ^ 0x1021U) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static void print_summary(const uint8_t *p)
+{
+    uint32_t i;
+
+    snapshot_num++;
+    snapshot_tick = get32(&p[4]);
+    if (csv)
+    {
+        return;
+    }
+    printf("snapshot %u at %.1f s, window %u ms, %u IDs\n", snapshot_num, snapshot_tick * tick_ms / 1000.0,
+           get16(&p[2]), p[1]);
+    printf("  bus load %.2f %% (peak %.2f %%), with worst case stuffing %.2f %% (peak %.2f %%)\n",
+           get16(&p[8]) / 100.0, get16(&p[10]) / 100.0, get16(&p[12]) / 100.0, get16(&p[14]) / 100.0);
+    printf("  frames %u, without a table entry %u\n", get32(&p[16]), get32(&p[20]));
+    for (i = 0U; i < ERROR_NUM; i++)
+    {
+        if (get32(&p[24U + (4U * i)]) != 0U)
+        {
+            printf("  %-18s %u\n", error_names[i], get32(&p[24U + (4U * i)]));
+        }
+    }
+    printf("  %-10s %10s %7s %9s %9s %8s %8s %8s  %s\n", "ID", "frames", "rate/s", "min ms", "max ms",
+           "lat ms", "lat min", "lat max", "jitter histogram, ticks above min 0 1 2-3 4-7 ...");
+}
+
+static void print_id(const uint8_t *p)
+{
+    uint32_t id = get32(p);
+    uint32_t period_min = get32(&p[10]);
+    uint32_t period_max = get32(&p[14]);
+    uint32_t latency_num = get32(&p[18]);
+    uint32_t latency_sum = get32(&p[22]);
+    uint32_t latency_min = get16(&p[26]);
+    uint32_t latency_max = get16(&p[28]);
+    char name[16];
+    uint32_t i;
+
+    if (id & ID_EXT)
+    {
+        snprintf(name, sizeof(name), "%08Xx", id & ~ID_EXT);
+    }
+    else
+    {
+        snprintf(name, sizeof(name), "%03X", id);
+    }
+
+    if (csv)
+    {
+        printf("%u,%.4f,%s,%u,%u,", snapshot_num, snapshot_tick * tick_ms / 1000.0, name, get32(&p[4]), get16(&p[8]));
+        if (period_min != 0xFFFFFFFFU)
+        {
+            printf("%.1f,%.1f", period_min * tick_ms, period_max * tick_ms);
+        }
+        else
+        {
+            printf(",");
+        }
+        if (latency_num != 0U)
+        {
+            printf(",%.2f,%.1f,%.1f", latency_sum * tick_ms / latency_num, latency_min * tick_ms,
+                   latency_max * tick_ms);
+        }
+        else
+        {
+            printf(",,,");
+        }
+        for (i = 0U; i < HIST_NUM; i++)
+        {
+            printf(",%u", get16(&p[30U + (2U * i)]));
+        }
+        printf("\n");
+        return;
+    }
+
+    printf("  %-10s %10u %7u ", name, get32(&p[4]), get16(&p[8]));
+    if (period_min != 0xFFFFFFFFU)
+    {
+        printf("%9.1f %9.1f ", period_min * tick_ms, period_max * tick_ms);
+    }
+    else
+    {
+        printf("%9s %9s ", "-", "-");
+    }
+    if (latency_num != 0U)
+    {
+        printf("%8.2f %8.1f %8.1f ", latency_sum * tick_ms / latency_num, latency_min * tick_ms,
+               latency_max * tick_ms);
+    }
+    else
+    {
+        printf("%8s %8s %8s ", "-", "-", "-");
+    }
+    for (i = 0U; i < HIST_NUM; i++)
+    {
+        printf(" %u", get16(&p[30U + (2U * i)]));
+    }
+    printf("\n");
+}
+
+int main(int argc, char *argv[])
+{
+    FILE *in = stdin;
+    uint8_t *buf = NULL;
+    size_t size = 0U;
+    size_t cap = 0U;
+    size_t n;
+    size_t pos;
+    uint32_t len;
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if ((strcmp(argv[i], "-t") == 0) && ((i + 1) < argc))
+        {
+            tick_ms = 1000.0 / atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-c") == 0)
+        {
+            csv = true;
+        }
+        else if ((argv[i][0] != '-') && (in == stdin))
+        {
+            in = fopen(argv[i], "rb");
+            if (in == NULL)
+            {
+                perror(argv[i]);
+                return 1;
+            }
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-t tick_hz] [-c] [capture.bin]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    do
+    {
+        if ((cap - size) < 4096U)
+        {
+            cap = (cap == 0U) ? 65536U : (cap * 2U);
+            buf = realloc(buf, cap);
+            if (buf == NULL)
+            {
+                fprintf(stderr, "out of memory\n");
+                return 1;
+            }
+        }
+        n = fread(&buf[size], 1U, cap - size, in);
+        size += n;
+    } while (n != 0U);
+
+    if (csv)
+    {
+        printf("snapshot,time_s,id,frames,rate,period_min_ms,period_max_ms,latency_avg_ms,latency_min_ms,"
+               "latency_max_ms");
+        for (i = 0; i < (int)HIST_NUM; i++)
+        {
+            printf(",jitter%d", i);
+        }
+        printf("\n");
+    }
+
+    for (pos = 0U; (pos + PACKET_OVERHEAD) <= size; pos++)
+    {
+        if ((buf[pos] != 'C') || (buf[pos + 1U] != 'S'))
+        {
+            continue;
+        }
+        len = buf[pos + 3U];
+        if (((pos + PACKET_OVERHEAD + len) > size) ||
+            !(((buf[pos + 2U] == PACKET_SUMMARY) && (len == SUMMARY_SIZE)) ||
+              ((buf[pos + 2U] == PACKET_ID) && (len == ID_SIZE))))
+        {
+            continue;
+        }
+        if (crc16(&buf[pos + 2U], len + 2U) != get16(&buf[pos + 4U + len]))
+        {
+            bad_crc_num++;
+            continue;
+        }
+        if (buf[pos + 2U] == PACKET_SUMMARY)
+        {
+            if (buf[pos + 4U] != PACKET_VERSION)
+            {
+                fprintf(stderr, "snapshot version %u, expected %u\n", buf[pos + 4U], PACKET_VERSION);
+                return 1;
+            }
+            print_summary(&buf[pos + 4U]);
+        }
+        else if (snapshot_num != 0U)
+        {
+            print_id(&buf[pos + 4U]);
+        }
+        pos += PACKET_OVERHEAD + len - 1U;
+    }
+
+    if (bad_crc_num != 0U)
+    {
+        fprintf(stderr, "%u packets with a bad CRC skipped\n", bad_crc_num);
+    }
+    free(buf);
+    return (snapshot_num != 0U) ? 0 : 1;
+}
@@ -0,0 +1,439 @@
+/* Host test of can_stats.c with synthetic traffic. can_stats.c is built as it
+ * is into this file, so the test sees the ID table.
+ *
+ *   schedule  60 s of a bus with a 10 ms ID with +-1 tick jitter, a 100 ms
+ *             one, an extended 20 ms one, a 5 ms CAN FD 64 byte one with
+ *             BRS, an own TX ID every 10 ms with 0 to 5 ticks of queue
+ *             latency, and 40 IDs once a second more than the table holds.
+ *             The counts, periods, jitter histograms and latencies of every
+ *             ID must be exact, the bus load of the last window must match
+ *             the frame lengths written out from ISO 11898-1
+ *   errors    ESR1 values must land in their error classes
+ *   export    a snapshot is written twice into a capture between printf
+ *             lines, the second copy with one broken ID packet, and read
+ *             back with can_stats_dump -c, which must skip that packet
+ *   threads   4 threads count 2M frames each on 48 IDs at once, no frame
+ *             may be lost and no key may be taken twice
+ *
+ * The capture is written to the current directory. Exit status 1 on a
+ * failed check.
+ *
+ * build: gcc -O2 -Wall -pthread -I.. -I../../S32K144_050_CAN_filter_compiler
+ *            -I../../S32K144_057_CAN_socketcan/host -o can_stats_test can_stats_test.c
+ *        gcc -O2 -o can_stats_dump can_stats_dump.c
+ * usage: can_stats_test [-d can_stats_dump]
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "can_stats.c"
+
+#define TEST_CAPTURE "can_stats_test.bin"
+#define TEST_OUTPUT_SIZE 65536U
+/* 60 s of 0.1 ms ticks */
+#define TEST_TICKS 600000U
+#define TEST_WINDOW_TICKS 10000U
+#define TEST_THREAD_NUM 4U
+#define TEST_THREAD_FRAMES 2000000U
+/* a CRC error every 1024 frames of a thread */
+#define TEST_THREAD_CRC_NUM ((TEST_THREAD_FRAMES + 1023U) / 1024U)
+/* byte of the export inside its second ID packet */
+#define TEST_BROKEN_BYTE 200U
+
+/* CS word of a received frame */
+#define TEST_CS(ext, fd, brs, dlc) (((fd) ? CAN_LLD_CS_EDL_MASK : 0U) | ((brs) ? 0x40000000U : 0U) | \
+                                    ((ext) ? 0x200000U : 0U) | ((uint32_t)(dlc) << 16))
+
+typedef struct
+{
+    uint32_t id;
+    uint32_t cs;
+    uint32_t period;
+    uint32_t next;
+    bool jitter;
+    bool tx;
+    uint32_t len;
+    double bits;        /* nominal bit times without stuff bits */
+    double stuff;       /* worst case stuff bits, in nominal bit times */
+    uint32_t sent;
+} test_src_t;
+
+static uint64_t test_seed = 88172645463325252ULL;
+static uint32_t test_error = 0U;
+static uint32_t test_check_num = 0U;
+static const char *test_dump = "./can_stats_dump";
+static char test_output[TEST_OUTPUT_SIZE];
+static uint32_t test_tick;
+
+#define TEST_CHECK(cond, ...) do { test_check_num++; if (!(cond)) { printf("FAIL: " __VA_ARGS__); printf("\n"); test_error++; } } while (0)
+
+static uint32_t test_rand(uint32_t range)
+{
+    test_seed ^= test_seed << 13;
+    test_seed ^= test_seed >> 7;
+    test_seed ^= test_seed << 17;
+    return (uint32_t)(test_seed % range);
+}
+
+/* FreeRTOS and can_lld.c, as far as can_stats.c uses them */
+
+TickType_t xTaskGetTickCount(void)
+{
+    return test_tick;
+}
+
+uint32_t can_lld_dlc_to_len(uint8_t dlc)
+{
+    static const uint8_t len[16] = {0U, 1U, 2U, 3U, 4U, 5U, 6U, 7U, 8U, 12U, 16U, 20U, 24U, 32U, 48U, 64U};
+
+    return len[dlc & 0x0FU];
+}
+
+static can_stats_entry_t *test_find(uint32_t key)
+{
+    uint32_t i;
+
+    for (i = 0U; i < CAN_STATS_ID_NUM; i++)
+    {
+        if (can_stats_table[i].key == (key | CAN_STATS_KEY_USED))
+        {
+            return &can_stats_table[i];
+        }
+    }
+    return NULL;
+}
+
+static uint32_t test_hist_sum(const can_stats_entry_t *entry)
+{
+    uint32_t sum = 0U;
+    uint32_t i;
+
+    for (i = 0U; i < CAN_STATS_HIST_NUM; i++)
+    {
+        sum += entry->hist[i];
+    }
+    return sum;
+}
+
+/* @brief: 60 s of a synthetic bus, the IDs and the bus load are checked
+ * @return: None
+ */
+static void test_schedule(void)
+{
+    /* bit times from ISO 11898-1: SOF to EOF without the intermission, the
+     * FD data phase at CAN_LLD_FD_DATA_BITRATE counts half a nominal bit */
+    test_src_t src[] =
+    {
+        {0x100U, TEST_CS(0, 0, 0, 8), 100U, 0U, true, false, 8U, 47.0 + 64.0, (34 + 64 - 1) / 4},
+        {0x200U, TEST_CS(0, 0, 0, 4), 1000U, 3U, false, false, 4U, 47.0 + 32.0, (34 + 32 - 1) / 4},
+        {0x18FF0001U, TEST_CS(1, 0, 0, 8), 200U, 7U, false, false, 8U, 67.0 + 64.0, (54 + 64 - 1) / 4},
+        {0x300U, TEST_CS(0, 1, 1, 15), 50U, 11U, false, false, 64U, 17.0 + 13.0 + ((5.0 + 512.0 + 4.0 + 21.0 + 7.0) / 2.0),
+         4.0 + (((5 + 512) / 4) / 2.0)},
+        {0x77U, 0U, 100U, 13U, false, true, 8U, 47.0 + 64.0, (34 + 64 - 1) / 4},
+    };
+    const uint32_t src_num = sizeof(src) / sizeof(src[0]);
+    double bits = 0.0;
+    double stuff = 0.0;
+    double window_bits = 0.0;
+    double window_stuff = 0.0;
+    double load;
+    double load_worst;
+    double rate;
+    uint32_t latency;
+    uint32_t latency_min = UINT32_MAX;
+    uint32_t latency_max = 0U;
+    uint32_t latency_sum = 0U;
+    can_stats_entry_t *entry;
+    uint32_t key;
+    uint32_t i;
+    uint32_t k;
+
+    can_stats_step();
+    for (test_tick = 0U; test_tick < TEST_TICKS; test_tick++)
+    {
+        for (i = 0U; i < src_num; i++)
+        {
+            if (test_tick < src[i].next)
+            {
+                continue;
+            }
+            if (src[i].tx)
+            {
+                latency = test_rand(6U);
+                can_stats_tx(src[i].id, src[i].len, false, test_tick - latency, test_tick);
+                latency_sum += latency;
+                latency_min = (latency < latency_min) ? latency : latency_min;
+                latency_max = (latency > latency_max) ? latency : latency_max;
+            }
+            else
+            {
+                can_stats_rx(src[i].id, src[i].cs, test_tick);
+            }
+            src[i].sent++;
+            bits += src[i].bits;
+            stuff += src[i].stuff;
+            src[i].next = test_tick + src[i].period;
+            if (src[i].jitter)
+            {
+                src[i].next = src[i].next + test_rand(3U) - 1U;
+            }
+        }
+        if ((test_tick % TEST_WINDOW_TICKS) == (TEST_WINDOW_TICKS / 2U))
+        {
+            for (k = 0U; k < 40U; k++)
+            {
+                can_stats_rx(0x600U + k, TEST_CS(0, 0, 0, 0), test_tick);
+                bits += 47.0;
+                stuff += (34 - 1) / 4;
+            }
+        }
+        if ((test_tick % TEST_WINDOW_TICKS) == (TEST_WINDOW_TICKS - 1U))
+        {
+            /* can_stats_step() at the first tick of the next window */
+            test_tick++;
+            can_stats_step();
+            test_tick--;
+            window_bits = bits;
+            window_stuff = stuff;
+            bits = 0.0;
+            stuff = 0.0;
+        }
+    }
+
+    printf("IDs in the table %u, frames without an entry %u\n", can_stats_id_num(), can_stats_no_entry_num);
+    TEST_CHECK(can_stats_id_num() == CAN_STATS_ID_NUM, "%u IDs in the table", can_stats_id_num());
+    for (i = 0U; i < src_num; i++)
+    {
+        key = src[i].id | (((src[i].cs & 0x200000U) != 0U) ? CAN_LLD_TX_ID_EXT : 0U);
+        entry = test_find(key);
+        TEST_CHECK(entry != NULL, "no entry for 0x%X", src[i].id);
+        if (entry == NULL)
+        {
+            continue;
+        }
+        rate = (double)TEST_WINDOW_TICKS / (double)src[i].period;
+        printf("ID %8X: %6u/%6u frames, %4u/s (%4.0f), period %u..%u ticks", src[i].id, entry->frame_num,
+               src[i].sent, entry->rate, rate, ~entry->period_min_inv, entry->period_max);
+        TEST_CHECK(entry->frame_num == src[i].sent, "0x%X: %u of %u frames", src[i].id, entry->frame_num,
+                   src[i].sent);
+        TEST_CHECK(test_hist_sum(entry) == (src[i].sent - 1U), "0x%X: %u periods in the histogram", src[i].id,
+                   test_hist_sum(entry));
+        TEST_CHECK(abs((int)entry->rate - (int)rate) <= 1, "0x%X: rate %u/s", src[i].id, entry->rate);
+        if (src[i].jitter)
+        {
+            printf(", jitter %u %u %u", entry->hist[0], entry->hist[1], entry->hist[2]);
+            TEST_CHECK((~entry->period_min_inv == (src[i].period - 1U)) && (entry->period_max == (src[i].period + 1U)),
+                       "0x%X: period %u..%u", src[i].id, ~entry->period_min_inv, entry->period_max);
+            TEST_CHECK(((entry->hist[0] + entry->hist[1] + entry->hist[2]) == (src[i].sent - 1U)) &&
+                       (entry->hist[2] != 0U), "0x%X: jitter outside 0..2 ticks", src[i].id);
+        }
+        else
+        {
+            TEST_CHECK((~entry->period_min_inv == src[i].period) && (entry->period_max == src[i].period) &&
+                       (entry->hist[0] == (src[i].sent - 1U)), "0x%X: period %u..%u", src[i].id,
+                       ~entry->period_min_inv, entry->period_max);
+        }
+        if (src[i].tx)
+        {
+            printf(", latency %u..%u avg %.2f", ~entry->latency_min_inv, entry->latency_max,
+                   (double)entry->latency_sum / (double)entry->latency_num);
+            TEST_CHECK((~entry->latency_min_inv == latency_min) && (entry->latency_max == latency_max) &&
+                       (entry->latency_sum == latency_sum), "0x%X: latency %u..%u", src[i].id,
+                       ~entry->latency_min_inv, entry->latency_max);
+        }
+        printf("\n");
+    }
+
+    load = (window_bits * 100.0) / (double)CAN_LLD_BITRATE;
+    load_worst = ((window_bits + window_stuff) * 100.0) / (double)CAN_LLD_BITRATE;
+    printf("bus load of the last window %.2f%% (%.2f%%), worst case stuffing %.2f%% (%.2f%%)\n",
+           can_stats_bus_load / 100.0, load, can_stats_bus_load_worst / 100.0, load_worst);
+    TEST_CHECK(abs((int)can_stats_bus_load - (int)(load * 100.0)) <= 2, "bus load %u", can_stats_bus_load);
+    TEST_CHECK(abs((int)can_stats_bus_load_worst - (int)(load_worst * 100.0)) <= 2, "worst case bus load %u",
+               can_stats_bus_load_worst);
+}
+
+static void test_errors(void)
+{
+    can_stats_esr1(CAN_ESR1_BIT0ERR_MASK | CAN_ESR1_ACKERR_MASK | CAN_ESR1_CRCERR_FAST_MASK |
+                   (1UL << CAN_ESR1_FLTCONF_SHIFT));
+    can_stats_esr1(CAN_ESR1_ACKERR_MASK | (1UL << CAN_ESR1_FLTCONF_SHIFT));
+    can_stats_esr1(CAN_ESR1_BOFFINT_MASK | (2UL << CAN_ESR1_FLTCONF_SHIFT));
+    TEST_CHECK(can_stats_error_num[CAN_STATS_ERROR_ACK] == 2U, "%u ACK errors", can_stats_error_num[CAN_STATS_ERROR_ACK]);
+    TEST_CHECK(can_stats_error_num[CAN_STATS_ERROR_BIT0] == 1U, "%u bit0 errors",
+               can_stats_error_num[CAN_STATS_ERROR_BIT0]);
+    TEST_CHECK(can_stats_error_num[CAN_STATS_ERROR_CRC_FAST] == 1U, "%u fast CRC errors",
+               can_stats_error_num[CAN_STATS_ERROR_CRC_FAST]);
+    TEST_CHECK(can_stats_error_num[CAN_STATS_ERROR_PASSIVE] == 1U, "error passive %u times",
+               can_stats_error_num[CAN_STATS_ERROR_PASSIVE]);
+    TEST_CHECK(can_stats_error_num[CAN_STATS_ERROR_BUS_OFF] == 1U, "bus off %u times",
+               can_stats_error_num[CAN_STATS_ERROR_BUS_OFF]);
+}
+
+/* @brief: Count the lines of the output that start with a text
+ * @param start : start of the line
+ * @return      : lines
+ */
+static uint32_t test_output_lines(const char *start)
+{
+    const size_t len = strlen(start);
+    uint32_t num = 0U;
+    const char *p;
+
+    for (p = test_output; p != NULL; p = strchr(p, '\n'))
+    {
+        p += (*p == '\n') ? 1 : 0;
+        num += (strncmp(p, start, len) == 0) ? 1U : 0U;
+    }
+    return num;
+}
+
+/* @brief: Export a snapshot twice into a capture, the second one broken, and
+ *         read it back with can_stats_dump
+ * @return: None
+ */
+static void test_export(void)
+{
+    char cmd[512];
+    size_t len = 0U;
+    size_t n;
+    uint32_t export_len;
+    uint32_t pos;
+    FILE *fp;
+    int status;
+
+    export_len = can_stats_export(can_stats_export_buf, sizeof(can_stats_export_buf));
+    printf("snapshot %u bytes, buffer %u\n", export_len, (uint32_t)sizeof(can_stats_export_buf));
+    TEST_CHECK(export_len == CAN_STATS_EXPORT_SIZE, "snapshot of %u bytes", export_len);
+    fp = fopen(TEST_CAPTURE, "wb");
+    if (fp == NULL)
+    {
+        perror(TEST_CAPTURE);
+        exit(2);
+    }
+    fputs("running time: 13s\n13. test for CAN statistics.\nCS text CS\n", fp);
+    for (pos = 0U; pos < export_len; pos += CAN_STATS_PACKET_OVERHEAD + can_stats_export_buf[pos + 3U])
+    {
+        fwrite(&can_stats_export_buf[pos], 1U, CAN_STATS_PACKET_OVERHEAD + can_stats_export_buf[pos + 3U], fp);
+        if (pos == 0U)
+        {
+            fputs("running time: 14s\n", fp);
+        }
+    }
+    can_stats_export_buf[TEST_BROKEN_BYTE] ^= 1U;
+    fwrite(can_stats_export_buf, 1U, export_len, fp);
+    fclose(fp);
+
+    snprintf(cmd, sizeof(cmd), "%s -c %s 2>&1", test_dump, TEST_CAPTURE);
+    fp = popen(cmd, "r");
+    if (fp == NULL)
+    {
+        perror(test_dump);
+        exit(2);
+    }
+    while ((len < (TEST_OUTPUT_SIZE - 1U)) && ((n = fread(&test_output[len], 1U, TEST_OUTPUT_SIZE - 1U - len, fp)) > 0U))
+    {
+        len += n;
+    }
+    test_output[len] = '\0';
+    status = pclose(fp);
+    printf("can_stats_dump: %u and %u IDs in the two snapshots, bad CRC reported %s\n", test_output_lines("1,"),
+           test_output_lines("2,"), (strstr(test_output, "bad CRC") != NULL) ? "yes" : "no");
+    TEST_CHECK(WIFEXITED(status) && (WEXITSTATUS(status) == 0), "%s failed", cmd);
+    TEST_CHECK(test_output_lines("1,") == CAN_STATS_ID_NUM, "%u IDs in the first snapshot", test_output_lines("1,"));
+    TEST_CHECK(test_output_lines("2,") == (CAN_STATS_ID_NUM - 1U), "%u IDs in the broken snapshot",
+               test_output_lines("2,"));
+    TEST_CHECK(test_output_lines("3,") == 0U, "a third snapshot");
+    TEST_CHECK(strstr(test_output, "1 packets with a bad CRC skipped") != NULL, "broken packet not skipped");
+}
+
+static void *test_thread(void *arg)
+{
+    unsigned int seed = (unsigned int)(uintptr_t)arg;
+    uint32_t i;
+
+    for (i = 0U; i < TEST_THREAD_FRAMES; i++)
+    {
+        can_stats_rx(0x400U + ((uint32_t)rand_r(&seed) % 48U), TEST_CS(0, 0, 0, 8), (TickType_t)i);
+        if ((i & 1023U) == 0U)
+        {
+            can_stats_error(CAN_STATS_ERROR_CRC, 1U);
+        }
+    }
+    return NULL;
+}
+
+/* @brief: Threads on more IDs than the table holds, all at once
+ * @return: None
+ */
+static void test_threads(void)
+{
+    pthread_t thread[TEST_THREAD_NUM];
+    uint64_t sum;
+    uint32_t dup = 0U;
+    uint32_t hist_error = 0U;
+    uint32_t i;
+    uint32_t j;
+
+    memset(can_stats_table, 0, sizeof(can_stats_table));
+    memset(can_stats_error_num, 0, sizeof(can_stats_error_num));
+    can_stats_no_entry_num = 0U;
+    can_stats_frame_num = 0U;
+    for (i = 0U; i < TEST_THREAD_NUM; i++)
+    {
+        (void)pthread_create(&thread[i], NULL, test_thread, (void *)(uintptr_t)(i + 1U));
+    }
+    for (i = 0U; i < TEST_THREAD_NUM; i++)
+    {
+        (void)pthread_join(thread[i], NULL);
+    }
+
+    sum = can_stats_no_entry_num;
+    for (i = 0U; i < CAN_STATS_ID_NUM; i++)
+    {
+        sum += can_stats_table[i].frame_num;
+        hist_error += ((test_hist_sum(&can_stats_table[i]) + 1U) != can_stats_table[i].frame_num) ? 1U : 0U;
+        for (j = i + 1U; j < CAN_STATS_ID_NUM; j++)
+        {
+            dup += (can_stats_table[i].key == can_stats_table[j].key) ? 1U : 0U;
+        }
+    }
+    printf("threads: %llu of %u frames counted, %u without an entry, %u duplicate keys, %u CRC errors\n",
+           (unsigned long long)sum, TEST_THREAD_NUM * TEST_THREAD_FRAMES, can_stats_no_entry_num, dup,
+           can_stats_error_num[CAN_STATS_ERROR_CRC]);
+    TEST_CHECK(sum == (TEST_THREAD_NUM * TEST_THREAD_FRAMES), "%llu frames counted", (unsigned long long)sum);
+    TEST_CHECK(can_stats_frame_num == (TEST_THREAD_NUM * TEST_THREAD_FRAMES), "frame counter %u",
+               can_stats_frame_num);
+    TEST_CHECK(dup == 0U, "%u keys taken twice", dup);
+    TEST_CHECK(hist_error == 0U, "%u entries with a histogram off their count", hist_error);
+    TEST_CHECK(can_stats_error_num[CAN_STATS_ERROR_CRC] == (TEST_THREAD_NUM * TEST_THREAD_CRC_NUM), "%u CRC errors",
+               can_stats_error_num[CAN_STATS_ERROR_CRC]);
+}
+
+int main(int argc, char **argv)
+{
+    int opt;
+
+    while ((opt = getopt(argc, argv, "d:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'd':
+            test_dump = optarg;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-d can_stats_dump]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    test_schedule();
+    test_errors();
+    test_export();
+    test_threads();
+    printf("%s, %u checks, %u errors\n", (test_error == 0U) ? "PASS" : "FAIL", test_check_num, test_error);
+    return (test_error == 0U) ? 0 : 1;
+}
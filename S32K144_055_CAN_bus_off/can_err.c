@@ -0,0 +1,224 @@
+#include "can_err.h"
+
+/* the CAN error interrupts and the ESR1 poll of can_lld_step() run with the
+ * CAN interrupts masked, can_err_update() is never entered twice */
+volatile can_err_state_t can_err_state = CAN_ERR_STATE_ACTIVE;
+uint32_t can_err_state_num[CAN_ERR_STATE_NUM];
+uint32_t can_err_recovery_num;
+uint32_t can_err_recovery_last;
+uint32_t can_err_recovery_max;
+uint32_t can_err_recovery_sum;
+
+/* tick of the last bus off and of the end of its recovery delay */
+static TickType_t can_err_bus_off_tick = 0U;
+static TickType_t can_err_deadline = 0U;
+/* bus offs without a frame sent in between */
+static uint32_t can_err_bus_off_run = 0U;
+
+static const char *const can_err_state_names[CAN_ERR_STATE_NUM] =
+{
+    "error active",
+    "warning",
+    "error passive",
+    "bus off",
+    "recovering"
+};
+
+static can_err_state_t can_err_level(uint32_t esr1);
+static void can_err_enter(can_err_state_t state);
+static void can_err_bus_off(TickType_t tick);
+static void can_err_release(void);
+static void can_err_recovered(TickType_t tick);
+
+/* @brief: Take over bus off recovery after FLEXCAN_DRV_Init(), FlexCAN starts
+ *         error active. A bus off still in recovery ends here
+ * @return: None
+ */
+void can_err_start(void)
+{
+    CAN0->CTRL1 |= CAN_CTRL1_BOFFREC_MASK;
+    CAN0->CTRL2 |= CAN_CTRL2_BOFFDONEMSK_MASK;
+
+    if (can_err_state >= CAN_ERR_STATE_BUS_OFF)
+    {
+        taskENTER_CRITICAL();
+        can_err_recovered(xTaskGetTickCount());
+        taskEXIT_CRITICAL();
+    }
+    can_err_enter(CAN_ERR_STATE_ACTIVE);
+}
+
+/* @brief: Follow the fault confinement state of FlexCAN. Called from the CAN
+ *         error interrupts or with them masked
+ * @param esr1 : ESR1 as returned by FLEXCAN_DRV_GetErrorStatus(), before its
+ *               interrupt flags are cleared
+ * @param tick : FreeRTOS tick of the read
+ * @return     : None
+ */
+void can_err_update(uint32_t esr1, TickType_t tick)
+{
+    can_err_state_t level = can_err_level(esr1);
+
+    if (can_err_state >= CAN_ERR_STATE_BUS_OFF)
+    {
+        /* with BOFFREC set FlexCAN stays bus off until we release it. Done
+         * and bus off in one read is a new bus off right after the last */
+        if ((level == CAN_ERR_STATE_BUS_OFF) && ((esr1 & CAN_ESR1_BOFFDONEINT_MASK) == 0U))
+        {
+            return;
+        }
+        can_err_recovered(tick);
+    }
+
+    if (level == CAN_ERR_STATE_BUS_OFF)
+    {
+        can_err_bus_off(tick);
+    }
+    else
+    {
+        can_err_enter(level);
+    }
+}
+
+/* @brief: A frame went out, the bus works. Called from the CAN interrupt
+ * @return: None
+ */
+void can_err_tx_ok(void)
+{
+    can_err_bus_off_run = 0U;
+}
+
+/* @brief: Start the recovery when the delay of a bus off is over, called by
+ *         freertos_task_can_rx
+ * @return: ticks until the next call is needed, portMAX_DELAY if only a CAN
+ *          error interrupt can bring new work
+ */
+TickType_t can_err_step(void)
+{
+    TickType_t now;
+    TickType_t wait = portMAX_DELAY;
+
+    if (can_err_state != CAN_ERR_STATE_BUS_OFF)
+    {
+        return wait;
+    }
+
+    now = xTaskGetTickCount();
+    taskENTER_CRITICAL();
+    if (can_err_state == CAN_ERR_STATE_BUS_OFF)
+    {
+        if ((int32_t)(now - can_err_deadline) >= 0)
+        {
+            can_err_release();
+        }
+        else
+        {
+            wait = can_err_deadline - now;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    return wait;
+}
+
+const char *can_err_state_name(can_err_state_t state)
+{
+    return (state < CAN_ERR_STATE_NUM) ? can_err_state_names[state] : "?";
+}
+
+/* @brief: State of the error counters. RXWRN and TXWRN are status bits and
+ *         valid without MCR[WRNEN], only their interrupts need it
+ * @param esr1 : ESR1 value
+ * @return     : state, CAN_ERR_STATE_BUS_OFF for any bus off
+ */
+static can_err_state_t can_err_level(uint32_t esr1)
+{
+    uint32_t fltconf = (esr1 & CAN_ESR1_FLTCONF_MASK) >> CAN_ESR1_FLTCONF_SHIFT;
+
+    if (fltconf >= 2U)
+    {
+        return CAN_ERR_STATE_BUS_OFF;
+    }
+    if (fltconf == 1U)
+    {
+        return CAN_ERR_STATE_PASSIVE;
+    }
+    if ((esr1 & (CAN_ESR1_RXWRN_MASK | CAN_ESR1_TXWRN_MASK)) != 0U)
+    {
+        return CAN_ERR_STATE_WARNING;
+    }
+    return CAN_ERR_STATE_ACTIVE;
+}
+
+static void can_err_enter(can_err_state_t state)
+{
+    if (state != can_err_state)
+    {
+        can_err_state_num[state]++;
+        can_err_state = state;
+    }
+}
+
+/* @brief: FlexCAN went bus off. The TX mailboxes are emptied and the
+ *         recovery waits the fast or the slow delay
+ * @param tick : FreeRTOS tick of the bus off
+ * @return     : None
+ */
+static void can_err_bus_off(TickType_t tick)
+{
+    TickType_t delay;
+
+    can_err_enter(CAN_ERR_STATE_BUS_OFF);
+    can_err_bus_off_tick = tick;
+    if (can_err_bus_off_run < CAN_ERR_BUS_OFF_FAST_NUM)
+    {
+        delay = pdMS_TO_TICKS(CAN_ERR_BUS_OFF_FAST_MS);
+    }
+    else
+    {
+        delay = pdMS_TO_TICKS(CAN_ERR_BUS_OFF_SLOW_MS);
+    }
+    can_err_bus_off_run++;
+
+    can_lld_tx_quarantine();
+    if (delay == 0U)
+    {
+        can_err_release();
+    }
+    else
+    {
+        can_err_deadline = tick + delay;
+        can_lld_rx_wake_from_isr();
+    }
+}
+
+/* @brief: Let FlexCAN leave bus off. It is back on the bus after 128 times
+ *         11 recessive bits counted from the bus off, or 11 more if they are
+ *         already over, and sets BOFFDONEINT
+ * @return: None
+ */
+static void can_err_release(void)
+{
+    can_err_enter(CAN_ERR_STATE_RECOVERING);
+    CAN0->CTRL1 &= ~CAN_CTRL1_BOFFREC_MASK;
+}
+
+/* @brief: FlexCAN is back on the bus, error active with both counters at 0
+ * @param tick : FreeRTOS tick it was seen
+ * @return     : None
+ */
+static void can_err_recovered(TickType_t tick)
+{
+    uint32_t time = (uint32_t)(tick - can_err_bus_off_tick);
+
+    CAN0->CTRL1 |= CAN_CTRL1_BOFFREC_MASK;
+    can_err_recovery_num++;
+    can_err_recovery_last = time;
+    can_err_recovery_sum += time;
+    if (time > can_err_recovery_max)
+    {
+        can_err_recovery_max = time;
+    }
+    can_err_enter(CAN_ERR_STATE_ACTIVE);
+    can_lld_tx_release(pdMS_TO_TICKS(CAN_ERR_TX_STALE_MS));
+}
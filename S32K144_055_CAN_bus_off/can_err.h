@@ -0,0 +1,52 @@
+#ifndef CAN_ERR_H
+#define CAN_ERR_H
+
+#include "can_lld.h"
+
+/* CAN fault confinement of the node. The FlexCAN error interrupts feed
+ * can_err_update() with ESR1, can_lld_step() polls it as well for the way
+ * back from warning and error passive, which raises no interrupt.
+ *
+ * Automatic bus off recovery is switched off (CTRL1[BOFFREC] = 1). After a
+ * bus off the TX mailboxes are emptied back into the TX queue and nothing is
+ * loaded (quarantine), freertos_task_can_rx lets FlexCAN recover after the
+ * delay below and the queue is released once FlexCAN is back on the bus */
+
+/* the first bus offs in a row wait the fast delay, the next ones the slow
+ * one. A frame sent after a recovery ends the row */
+#define CAN_ERR_BUS_OFF_FAST_NUM 5U
+#define CAN_ERR_BUS_OFF_FAST_MS 10U
+#define CAN_ERR_BUS_OFF_SLOW_MS 1000U
+
+/* frames queued longer than this when the bus is back are dropped instead of
+ * sent late, 0 keeps them all */
+#define CAN_ERR_TX_STALE_MS 100U
+
+typedef enum
+{
+    CAN_ERR_STATE_ACTIVE = 0,   /* both error counters below 96 */
+    CAN_ERR_STATE_WARNING,      /* an error counter at 96 or more */
+    CAN_ERR_STATE_PASSIVE,      /* an error counter above 127 */
+    CAN_ERR_STATE_BUS_OFF,      /* TX error counter above 255, waiting for
+                                 * the recovery delay */
+    CAN_ERR_STATE_RECOVERING,   /* BOFFREC released, FlexCAN waits for 128
+                                 * times 11 recessive bits */
+    CAN_ERR_STATE_NUM
+} can_err_state_t;
+
+extern volatile can_err_state_t can_err_state;
+/* times each state was entered */
+extern uint32_t can_err_state_num[CAN_ERR_STATE_NUM];
+/* bus off to back on the bus, FreeRTOS ticks */
+extern uint32_t can_err_recovery_num;
+extern uint32_t can_err_recovery_last;
+extern uint32_t can_err_recovery_max;
+extern uint32_t can_err_recovery_sum;
+
+void can_err_start(void);
+void can_err_update(uint32_t esr1, TickType_t tick);
+void can_err_tx_ok(void);
+TickType_t can_err_step(void);
+const char *can_err_state_name(can_err_state_t state);
+
+#endif
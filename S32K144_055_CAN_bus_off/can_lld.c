@@ -0,0 +1,1459 @@
+#include "can_lld.h"
+#include "isotp.h"
+#include "can_stats.h"
+#include "can_err.h"
+#include "string.h"
+#include "lpspiCom1.h"
+#include "sbc_uja116x1.h"
+#include "dmaController1.h"
+#include "printf.h"
+
+status_t can_lld_debug_tx_ret_val;
+flexcan_data_info_t can_lld_rx_data_info;
+flexcan_msgbuff_t can_lld_rx_test_msg;
+flexcan_user_config_t can_lld_config_data_1;
+flexcan_user_config_t can_lld_config_data_0;
+static uint8_t can_tx_data[CAN_LLD_PAYLOAD_MAX];
+uint32_t can_lld_event_num;
+uint32_t can_lld_rx_complete_num;
+uint32_t can_lld_rx_fifo_compete_num;
+uint32_t can_lld_rx_fifo_warning_num;
+uint32_t can_lld_rx_fifo_overflow_num;
+uint32_t can_lld_tx_complete_num;
+uint32_t can_lld_wake_up_timeout_num;
+uint32_t can_lld_wake_up_match_num;
+uint32_t can_lld_self_wake_up_num;
+uint32_t can_lld_dma_complete_num;
+uint32_t can_lld_dma_error_num;
+uint32_t can_lld_error_num;
+uint32_t can_lld_default1_num;
+uint32_t can_lld_default2_num;
+uint32_t can_lld_error_value;
+uint32_t can_lld_rx_frame_num;
+uint32_t can_lld_rx_queue_overflow_num;
+uint32_t can_lld_rx_queue_peak;
+uint32_t can_lld_tx_frame_num;
+uint32_t can_lld_tx_queue_full_num;
+uint32_t can_lld_tx_queue_peak;
+uint32_t can_lld_tx_cancel_num;
+uint32_t can_lld_tx_error_num;
+uint32_t can_lld_tx_stale_num;
+uint32_t can_lld_tx_fd_frame_num;
+uint32_t can_lld_rx_fd_frame_num;
+
+/* the driver copies every RX FIFO frame here before RXFIFO_COMPLETE */
+flexcan_msgbuff_t can_lld_rx_fifo_msg;
+
+/* filter table, masks and RX mailboxes made by tools/can_filter_gen */
+#include "can_lld_filter.inc"
+
+/* same for the RX mailboxes before RX_COMPLETE, the dedicated ones of the
+ * filter table in classic mode, all RX mailboxes in FD mode */
+static flexcan_msgbuff_t can_lld_rx_mb_msg[CAN_LLD_RX_MB_MAX];
+
+/* FD length of each DLC, a classic frame stops at 8 */
+static const uint8_t can_lld_dlc_len[16] = {0U, 1U, 2U, 3U, 4U, 5U, 6U, 7U, 8U, 12U, 16U, 20U, 24U, 32U, 48U, 64U};
+
+/* FD mode timing. The PE clock stays SOSCDIV2 (8 MHz) of canCom1_InitConfig0,
+ * the nominal bitrate keeps its 500 kbit/s and 16 tq. Data phase 1 Mbit/s,
+ * 8 tq, sample point at 6 tq = 75%. 2 Mbit/s needs a faster PE clock than
+ * the crystal gives */
+static const flexcan_time_segment_t can_lld_fd_data_bitrate =
+{
+    .propSeg = 2,
+    .phaseSeg1 = 2,
+    .phaseSeg2 = 1,
+    .preDivider = 0,
+    .rJumpwidth = 1
+};
+/* transmitter delay compensation: secondary sample point at the sample
+ * point, (FPROPSEG + FPSEG1 + 2) * (FPRESDIV + 1) PE clocks */
+#define CAN_LLD_FD_TDC_OFFSET 6U
+
+#if (CAN_LLD_FD_PAYLOAD == 64U)
+#define CAN_LLD_FD_PAYLOAD_SIZE FLEXCAN_PAYLOAD_SIZE_64
+#elif (CAN_LLD_FD_PAYLOAD == 32U)
+#define CAN_LLD_FD_PAYLOAD_SIZE FLEXCAN_PAYLOAD_SIZE_32
+#elif (CAN_LLD_FD_PAYLOAD == 16U)
+#define CAN_LLD_FD_PAYLOAD_SIZE FLEXCAN_PAYLOAD_SIZE_16
+#else
+#define CAN_LLD_FD_PAYLOAD_SIZE FLEXCAN_PAYLOAD_SIZE_8
+#endif
+
+#define CAN_LLD_RX_QUEUE_MASK (CAN_LLD_RX_QUEUE_SIZE - 1U)
+
+/* single producer single consumer ring, the CAN interrupt only moves the head
+ * and freertos_task_can_rx only moves the tail. The indexes are free running,
+ * a full ring drops the new frame and counts it */
+static can_lld_rx_frame_t can_lld_rx_queue[CAN_LLD_RX_QUEUE_SIZE];
+static volatile uint32_t can_lld_rx_queue_head = 0U;
+static volatile uint32_t can_lld_rx_queue_tail = 0U;
+/* consumer blocked in can_lld_rx_wait(), NULL if none */
+static TaskHandle_t volatile can_lld_rx_waiter = NULL;
+/* set by can_lld_rx_wake(), makes can_lld_rx_wait() return without a frame */
+static volatile uint32_t can_lld_rx_wake_flag = 0U;
+
+/* FLEXCAN_ALL_INT, the interrupt flags of ESR1, write 1 to clear */
+#define CAN_LLD_ESR1_INT_MASK 0x3B0006U
+
+#define CAN_LLD_RX_DMA_CHANNEL EDMA_CHN2_NUMBER
+#define CAN_LLD_RX_DMA_HALF (CAN_LLD_RX_DMA_SLOTS / 2U)
+/* entries behind the DMA that may be read, the one after them may be in a
+ * minor loop the DMA has not counted yet */
+#define CAN_LLD_RX_DMA_READABLE (CAN_LLD_RX_DMA_SLOTS - 1U)
+
+/* fields of the ID word of a mailbox */
+#define CAN_LLD_ID_STD_SHIFT 18U
+#define CAN_LLD_ID_EXT_MASK 0x1FFFFFFFUL
+
+/* one RX FIFO entry as FlexCAN keeps it at MB0, the data words are big
+ * endian */
+typedef struct
+{
+    uint32_t cs;
+    uint32_t id;
+    uint32_t data[2];
+} can_lld_rx_dma_slot_t;
+
+/* ring written by eDMA channel 2 without the CPU. The DMA interrupt counts
+ * finished halves, with the DMA position they give the free running number
+ * of entries written. freertos_task_can_rx owns the tail */
+static can_lld_rx_dma_slot_t can_lld_rx_dma_buf[CAN_LLD_RX_DMA_SLOTS];
+static volatile uint32_t can_lld_rx_dma_half_num = 0U;
+static uint32_t can_lld_rx_dma_tail = 0U;
+/* the DMA ring is used in classic mode until a DMA error */
+static bool can_lld_rx_dma_enable = (CAN_LLD_RX_DMA_ENABLE != 0);
+static volatile bool can_lld_rx_dma_on = false;
+static volatile bool can_lld_rx_dma_failed = false;
+
+typedef struct
+{
+    uint32_t key;       /* arbitration order, the lower key wins the bus */
+    uint32_t seq;       /* keeps frames with the same key in queue order */
+    uint32_t msgId;
+    uint32_t tick;      /* FreeRTOS tick of can_lld_tx(), for the TX latency */
+    bool fd;
+    uint8_t dataLen;    /* a length a DLC can code, padded for FD frames */
+    uint8_t data[CAN_LLD_PAYLOAD_MAX];
+} can_lld_tx_frame_t;
+
+/* TX queue, a binary min heap on (key, seq). Frames leave it only to enter a
+ * mailbox of the pool, so the pool always holds the highest priority frames
+ * and FlexCAN (CTRL1[LBUF] = 0, the reset value kept by FLEXCAN_DRV_Init)
+ * arbitrates between them by ID. Shared by the tasks calling can_lld_tx()
+ * and the CAN interrupt, the tasks use a critical section */
+static can_lld_tx_frame_t can_lld_tx_queue[CAN_LLD_TX_QUEUE_SIZE];
+static uint32_t can_lld_tx_queue_num = 0U;
+static uint32_t can_lld_tx_seq = 0U;
+/* frame loaded into each pool mailbox, valid while its bit is set */
+static can_lld_tx_frame_t can_lld_tx_mb_frame[CAN_LLD_TX_MB_MAX];
+static uint32_t can_lld_tx_mb_busy = 0U;
+
+/* mailbox layout of the current mode, changed by can_lld_set_mode() only
+ * while FlexCAN is stopped */
+static volatile can_lld_mode_t can_lld_mode = CAN_LLD_MODE_CLASSIC;
+static uint8_t can_lld_tx_mb_first = CAN_LLD_TX_MB_FIRST;
+static uint8_t can_lld_tx_mb_num = CAN_LLD_TX_MB_NUM;
+static uint32_t can_lld_tx_mb_all = (1UL << CAN_LLD_TX_MB_NUM) - 1UL;
+static uint8_t can_lld_rx_mb_first = CAN_LLD_RX_MB_FIRST;
+static uint8_t can_lld_rx_mb_num = CAN_LLD_FILTER_RX_MB_NUM;
+/* no mailbox is loaded while the mode changes, can_lld_tx() only queues */
+static bool can_lld_tx_stopped = false;
+/* the same from a bus off until can_lld_tx_release() */
+static bool can_lld_tx_quarantined = false;
+
+static status_t can_lld_start(can_lld_mode_t mode);
+static status_t can_lld_restart(can_lld_mode_t mode);
+static void can_lld_rx_dma_start(void);
+static void can_lld_rx_dma_stop(void);
+static void can_lld_rx_dma_cbk(void *parameter, edma_chn_status_t status);
+static uint32_t can_lld_rx_dma_written(void);
+static bool can_lld_rx_dma_get(can_lld_rx_frame_t *frame);
+static void can_lld_rx_dma_check(void);
+static void can_lld_filter_init(void);
+static void can_lld_fd_rx_init(void);
+static void can_lld_rx_push(const flexcan_msgbuff_t *msg);
+static void can_lld_rx_process(const can_lld_rx_frame_t *frame);
+static uint32_t can_lld_tx_key(uint32_t messageId);
+static bool can_lld_tx_before(const can_lld_tx_frame_t *a, const can_lld_tx_frame_t *b);
+static void can_lld_tx_queue_push(const can_lld_tx_frame_t *frame);
+static void can_lld_tx_queue_pop(can_lld_tx_frame_t *frame);
+static void can_lld_tx_refill(void);
+#if CAN_LLD_TX_CANCEL_ENABLE
+static void can_lld_tx_cancel(void);
+#endif
+static void can_lld_tx_unload(void);
+static void can_lld_tx_queue_drop(bool fd, TickType_t age);
+static void can_lld_tx_done(const can_lld_tx_frame_t *frame);
+static void can_lld_error_cbk(uint8_t instance, flexcan_event_type_t eventType, flexcan_state_t *flexcanState);
+static uint8_t *can_lld_isotp_rx_buf(uint8_t channel, uint32_t len);
+static void can_lld_isotp_rx_done(uint8_t channel, uint8_t *data, uint32_t len, isotp_result_t result);
+static void can_lld_isotp_tx_done(uint8_t channel, const uint8_t *data, isotp_result_t result);
+
+#define CAN_LLD_ISOTP_PRINT_CHANNEL 0U
+#define CAN_LLD_ISOTP_ECHO_CHANNEL 1U
+#define CAN_LLD_ISOTP_BUF_SIZE 512U
+
+/* demo channels: 0x010 is printed as text, 0x7E0 is sent back on 0x7E8 */
+static const isotp_channel_config_t can_lld_isotp_config[ISOTP_CHANNEL_NUM] =
+{
+    {0x010U, 0x018U, 8U, 0U, can_lld_isotp_rx_buf, can_lld_isotp_rx_done, NULL},
+    {0x7E0U, 0x7E8U, 0U, 0U, can_lld_isotp_rx_buf, can_lld_isotp_rx_done, can_lld_isotp_tx_done}
+};
+static uint8_t can_lld_isotp_buf[ISOTP_CHANNEL_NUM][CAN_LLD_ISOTP_BUF_SIZE];
+/* the echo buffer is sent from where it is, no new message until tx_done */
+static volatile bool can_lld_isotp_echo_busy = false;
+
+void can_lld_init(void)
+{
+    uint8_t i = 0U;
+
+    FLEXCAN_DRV_GetDefaultConfig(&can_lld_config_data_0);
+    LPSPI_DRV_MasterInit(LPSPICOM1, &lpspiCom1State, &lpspiCom1_MasterConfig0);
+    INT_SYS_SetPriority(LPSPI1_IRQn, configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY);
+    SBC_Init(&sbc_uja116x1_InitConfig0, LPSPICOM1);
+    /* Configure RX message buffer with index RX_MSG_ID and RX_MAILBOX */
+    can_lld_rx_data_info.msg_id_type = FLEXCAN_MSG_ID_STD;
+    can_lld_rx_data_info.fd_enable = 0;
+    can_lld_rx_data_info.is_remote = 0;
+    /* FLEXCAN_DRV_ConfigRxMb(INST_CANCOM1, 0, &can_lld_rx_data_info, RX_MSG_ID); */
+    FLEXCAN_DRV_GetDefaultConfig(&can_lld_config_data_1);
+    (void)can_lld_start(CAN_LLD_MODE_INIT);
+
+    isotp_init();
+    for (i = 0U; i < ISOTP_CHANNEL_NUM; i++)
+    {
+        isotp_channel_open(i, &can_lld_isotp_config[i]);
+    }
+}
+
+/* @brief: Handle all frames waiting in the RX queue, never blocks
+ * @return: None
+ */
+void can_lld_fifo_rx_func(void)
+{
+    can_lld_rx_frame_t frame;
+
+    while (can_lld_rx_get(&frame))
+    {
+        can_lld_rx_process(&frame);
+    }
+}
+
+/* @brief: Take the oldest frame out of the RX queue, never blocks
+ * @param frame : destination of the frame
+ * @return      : true if a frame was taken
+ */
+bool can_lld_rx_get(can_lld_rx_frame_t *frame)
+{
+    uint32_t tail;
+
+    /* the dedicated RX mailboxes still use the queue, their IDs are never in
+     * the FIFO so the order per ID holds */
+    if (can_lld_rx_dma_on && can_lld_rx_dma_get(frame))
+    {
+        return true;
+    }
+
+    tail = can_lld_rx_queue_tail;
+    if (tail == __atomic_load_n(&can_lld_rx_queue_head, __ATOMIC_ACQUIRE))
+    {
+        return false;
+    }
+
+    *frame = can_lld_rx_queue[tail & CAN_LLD_RX_QUEUE_MASK];
+    /* the slot goes back to the interrupt only after it is copied */
+    __atomic_store_n(&can_lld_rx_queue_tail, tail + 1U, __ATOMIC_RELEASE);
+    return true;
+}
+
+/* @brief: Take the oldest frame out of the RX queue, wait for one if it is
+ *         empty. Only one task may consume the queue, its task notification
+ *         is used for the wake up
+ * @param frame   : destination of the frame
+ * @param timeout : ticks to wait, portMAX_DELAY for ever
+ * @return        : true if a frame was taken, false on timeout or
+ *                  can_lld_rx_wake(). With the RX DMA running only every half
+ *                  ring wakes the task, poll with a short timeout
+ */
+bool can_lld_rx_wait(can_lld_rx_frame_t *frame, TickType_t timeout)
+{
+    bool ret;
+
+    if (can_lld_rx_get(frame))
+    {
+        return true;
+    }
+
+    /* the handle must be visible before the queue is checked again, else a
+     * frame pushed in between would not wake us up */
+    __atomic_store_n(&can_lld_rx_waiter, xTaskGetCurrentTaskHandle(), __ATOMIC_SEQ_CST);
+    for (;;)
+    {
+        if (can_lld_rx_get(frame))
+        {
+            ret = true;
+            break;
+        }
+        if (0U != __atomic_exchange_n(&can_lld_rx_wake_flag, 0U, __ATOMIC_SEQ_CST))
+        {
+            ret = false;
+            break;
+        }
+        /* a late notification for an already taken frame only costs a loop */
+        if (0U == ulTaskNotifyTake(pdTRUE, timeout))
+        {
+            ret = can_lld_rx_get(frame);
+            break;
+        }
+    }
+    __atomic_store_n(&can_lld_rx_waiter, NULL, __ATOMIC_RELEASE);
+
+    return ret;
+}
+
+/* @brief: Number of frames waiting in the RX queue
+ * @return: waiting frames
+ */
+uint32_t can_lld_rx_pending(void)
+{
+    uint32_t num = __atomic_load_n(&can_lld_rx_queue_head, __ATOMIC_ACQUIRE) -
+                   __atomic_load_n(&can_lld_rx_queue_tail, __ATOMIC_ACQUIRE);
+    uint32_t dma;
+
+    if (can_lld_rx_dma_on)
+    {
+        dma = can_lld_rx_dma_written() - can_lld_rx_dma_tail;
+        if ((int32_t)dma > 0)
+        {
+            num += dma;
+        }
+    }
+    return num;
+}
+
+/* @brief: The RX FIFO is emptied by the DMA, not by interrupts
+ * @return: true in classic mode until a DMA error
+ */
+bool can_lld_rx_dma_running(void)
+{
+    return can_lld_rx_dma_on;
+}
+
+/* @brief: Make the task blocked in can_lld_rx_wait() return, used when it
+ *         has work besides the received frames. Must not be called from an ISR
+ * @return: None
+ */
+void can_lld_rx_wake(void)
+{
+    TaskHandle_t waiter;
+
+    __atomic_store_n(&can_lld_rx_wake_flag, 1U, __ATOMIC_SEQ_CST);
+    waiter = __atomic_load_n(&can_lld_rx_waiter, __ATOMIC_SEQ_CST);
+    if (waiter != NULL)
+    {
+        xTaskNotifyGive(waiter);
+    }
+}
+
+/* @brief: can_lld_rx_wake() for interrupts and critical sections
+ * @return: None
+ */
+void can_lld_rx_wake_from_isr(void)
+{
+    TaskHandle_t waiter;
+    BaseType_t woken = pdFALSE;
+
+    __atomic_store_n(&can_lld_rx_wake_flag, 1U, __ATOMIC_SEQ_CST);
+    waiter = __atomic_load_n(&can_lld_rx_waiter, __ATOMIC_SEQ_CST);
+    if (waiter != NULL)
+    {
+        vTaskNotifyGiveFromISR(waiter, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+}
+
+void freertos_task_can_rx(void *pvParameters)
+{
+    can_lld_rx_frame_t frame;
+    /* frames in the DMA ring wake us only every half ring, already the
+     * first wait must not be without end */
+    TickType_t timeout = (CAN_LLD_RX_DMA_ENABLE != 0) ? pdMS_TO_TICKS(CAN_LLD_RX_DMA_POLL_MS) : portMAX_DELAY;
+    TickType_t wait;
+
+    (void)pvParameters;
+
+    for (;;)
+    {
+        if (can_lld_rx_wait(&frame, timeout))
+        {
+            can_lld_rx_process(&frame);
+            can_lld_fifo_rx_func();
+        }
+        can_lld_rx_dma_check();
+        /* ISO-TP sends its frames and checks its timers here */
+        timeout = isotp_step();
+        /* and the bus off recovery waits its delay */
+        wait = can_err_step();
+        if (wait < timeout)
+        {
+            timeout = wait;
+        }
+        /* frames in the DMA ring wake us only every half ring */
+        if (can_lld_rx_dma_on && (timeout > pdMS_TO_TICKS(CAN_LLD_RX_DMA_POLL_MS)))
+        {
+            timeout = pdMS_TO_TICKS(CAN_LLD_RX_DMA_POLL_MS);
+        }
+    }
+}
+
+void can_lld_step(void)
+{
+    (void)can_lld_tx(0x77, can_tx_data, 8);
+    if (can_lld_mode == CAN_LLD_MODE_FD)
+    {
+        (void)can_lld_tx(0x78, can_tx_data, CAN_LLD_PAYLOAD_MAX);
+    }
+    *(uint32_t *)can_tx_data += 1U;
+
+#if CAN_LLD_EVENT_COUNTER_DISPLAY_ENABLE
+    printf_defer("CAN event number: %d\n", can_lld_event_num);
+    printf_defer("can_lld_rx_complete_num: %d\n", can_lld_rx_complete_num);
+    printf_defer("can_lld_rx_fifo_compete_num: %d\n", can_lld_rx_fifo_compete_num);
+    printf_defer("can_lld_rx_fifo_warning_num: %d\n", can_lld_rx_fifo_warning_num);
+    printf_defer("can_lld_rx_fifo_overflow_num: %d\n", can_lld_rx_fifo_overflow_num);
+    printf_defer("can_lld_tx_complete_num: %d\n", can_lld_tx_complete_num);
+    printf_defer("can_lld_wake_up_timeout_num: %d\n", can_lld_wake_up_timeout_num);
+    printf_defer("can_lld_wake_up_match_num: %d\n", can_lld_wake_up_match_num);
+    printf_defer("can_lld_self_wake_up_num: %d\n", can_lld_self_wake_up_num);
+    printf_defer("can_lld_dma_complete_num: %d\n", can_lld_dma_complete_num);
+    printf_defer("can_lld_dma_error_num: %d\n", can_lld_dma_error_num);
+    printf_defer("can_lld_error_num: %d\n", can_lld_error_num);
+    printf_defer("can_lld_default1_num: %d\n", can_lld_default1_num);
+    printf_defer("can_lld_default2_num: %d\n", can_lld_default2_num);
+#endif
+
+    /* the error interrupts miss the way back from warning and error passive.
+     * Reading ESR1 clears its error bits, the statistics see every read. The
+     * interrupt flags read are cleared here, else the error interrupt would
+     * take them a second time */
+    taskENTER_CRITICAL();
+    can_lld_error_value = FLEXCAN_DRV_GetErrorStatus(INST_CANCOM1);
+    can_stats_esr1(can_lld_error_value);
+    can_err_update(can_lld_error_value, xTaskGetTickCount());
+    CAN0->ESR1 = can_lld_error_value & CAN_LLD_ESR1_INT_MASK;
+    taskEXIT_CRITICAL();
+
+#if CAN_LLD_ERROR_PRINT_ENABLE
+    printf("can error information: %b\n", can_lld_error_value);
+
+    if(can_lld_error_value & CAN_ESR1_ERRINT_MASK)
+    {
+        printf("ERR flag is %d\n", (can_lld_error_value & CAN_ESR1_ERRINT_MASK) >> CAN_ESR1_ERRINT_SHIFT);
+    }
+
+    if(can_lld_error_value & CAN_ESR1_BOFFINT_MASK)
+    {
+        printf("busoff flag is %d\n", (can_lld_error_value & CAN_ESR1_BOFFINT_MASK) >> CAN_ESR1_BOFFINT_SHIFT);
+    }
+
+    printf("can error state: %s\n", can_err_state_name(can_err_state));
+#endif
+}
+
+/* @brief: Queue a frame for sending, it is loaded into a TX mailbox as soon
+ *         as one is free and no higher priority frame is waiting. Frames with
+ *         the same ID are sent in call order. Must not be called from an ISR
+ * @param messageId : Message ID, or'ed with CAN_LLD_TX_ID_EXT for a 29 bit ID
+ *                    and with CAN_LLD_TX_ID_FD for a short FD frame
+ * @param data      : Pointer to the TX data, copied before the call returns
+ * @param len       : Length of the TX data, more than 8 makes a FD frame,
+ *                    CAN_LLD_PAYLOAD_MAX at most. A FD frame is padded up to
+ *                    the next DLC length with CAN_LLD_FD_PADDING_BYTE
+ * @return          : STATUS_SUCCESS, STATUS_BUSY if the TX queue is full,
+ *                    STATUS_ERROR for a FD frame in classic mode or if
+ *                    len is more than CAN_LLD_PAYLOAD_MAX
+ */
+status_t can_lld_tx(uint32_t messageId, const uint8_t *data, uint32_t len)
+{
+    can_lld_tx_frame_t frame;
+    uint32_t padded;
+    status_t ret = STATUS_SUCCESS;
+
+    if (len > CAN_LLD_PAYLOAD_MAX)
+    {
+        return STATUS_ERROR;
+    }
+    frame.fd = ((messageId & CAN_LLD_TX_ID_FD) != 0U) || (len > 8U);
+    messageId &= ~CAN_LLD_TX_ID_FD;
+    padded = frame.fd ? can_lld_dlc_to_len(can_lld_len_to_dlc(len)) : len;
+
+    frame.key = can_lld_tx_key(messageId);
+    frame.msgId = messageId;
+    frame.tick = xTaskGetTickCount();
+    frame.dataLen = (uint8_t)padded;
+    memcpy(frame.data, data, len);
+    memset(&frame.data[len], CAN_LLD_FD_PADDING_BYTE, padded - len);
+
+    taskENTER_CRITICAL();
+    if (frame.fd && (can_lld_mode != CAN_LLD_MODE_FD))
+    {
+        can_lld_tx_error_num++;
+        ret = STATUS_ERROR;
+    }
+    else if (can_lld_tx_queue_num >= CAN_LLD_TX_QUEUE_SIZE)
+    {
+        can_lld_tx_queue_full_num++;
+        can_stats_error(CAN_STATS_ERROR_TX_QUEUE_FULL, 1U);
+        ret = STATUS_BUSY;
+    }
+    else
+    {
+        frame.seq = can_lld_tx_seq++;
+        can_lld_tx_queue_push(&frame);
+        can_lld_tx_frame_num++;
+        if (frame.fd)
+        {
+            can_lld_tx_fd_frame_num++;
+        }
+        if (can_lld_tx_queue_num > can_lld_tx_queue_peak)
+        {
+            can_lld_tx_queue_peak = can_lld_tx_queue_num;
+        }
+#if CAN_LLD_TX_CANCEL_ENABLE
+        can_lld_tx_cancel();
+#endif
+        can_lld_tx_refill();
+    }
+    taskEXIT_CRITICAL();
+
+    return ret;
+}
+
+/* @brief: Number of frames not sent yet, queued or loaded into a mailbox
+ * @return: pending frames
+ */
+uint32_t can_lld_tx_pending(void)
+{
+    uint32_t busy;
+    uint32_t num;
+
+    taskENTER_CRITICAL();
+    num = can_lld_tx_queue_num;
+    for (busy = can_lld_tx_mb_busy; busy != 0U; busy &= busy - 1U)
+    {
+        num++;
+    }
+    taskEXIT_CRITICAL();
+
+    return num;
+}
+
+/* @brief: Switch between classic CAN and CAN FD. FlexCAN is stopped and
+ *         initialized again with the mailbox layout of the mode, frames on
+ *         the bus meanwhile are lost. Frames still to send are kept, except
+ *         FD frames when going back to classic. Must not be called from an ISR
+ * @param mode : CAN_LLD_MODE_CLASSIC or CAN_LLD_MODE_FD
+ * @return     : STATUS_SUCCESS or the error of FLEXCAN_DRV_Init()
+ */
+status_t can_lld_set_mode(can_lld_mode_t mode)
+{
+    if (mode == can_lld_mode)
+    {
+        return STATUS_SUCCESS;
+    }
+    return can_lld_restart(mode);
+}
+
+can_lld_mode_t can_lld_get_mode(void)
+{
+    return can_lld_mode;
+}
+
+/* @brief: Stop FlexCAN and start it again in a mode, see can_lld_set_mode()
+ * @param mode : CAN_LLD_MODE_CLASSIC or CAN_LLD_MODE_FD
+ * @return     : STATUS_SUCCESS or the error of FLEXCAN_DRV_Init()
+ */
+static status_t can_lld_restart(can_lld_mode_t mode)
+{
+    status_t ret;
+
+    taskENTER_CRITICAL();
+    can_lld_mode = mode;
+    can_lld_tx_stopped = true;
+    can_lld_tx_unload();
+    if (mode == CAN_LLD_MODE_CLASSIC)
+    {
+        can_lld_tx_queue_drop(true, 0U);
+    }
+    taskEXIT_CRITICAL();
+
+    can_lld_rx_dma_stop();
+    (void)FLEXCAN_DRV_Deinit(INST_CANCOM1);
+    ret = can_lld_start(mode);
+
+    if (ret == STATUS_SUCCESS)
+    {
+        taskENTER_CRITICAL();
+        can_lld_tx_stopped = false;
+        can_lld_tx_refill();
+        taskEXIT_CRITICAL();
+    }
+    return ret;
+}
+
+/* @brief: Smallest DLC for a payload, FD coding
+ * @param len : payload length, 64 at most
+ * @return    : DLC, 0 to 15
+ */
+uint8_t can_lld_len_to_dlc(uint32_t len)
+{
+    uint8_t dlc = 0U;
+
+    while ((dlc < 15U) && (can_lld_dlc_len[dlc] < len))
+    {
+        dlc++;
+    }
+    return dlc;
+}
+
+/* @brief: Payload length of a FD frame, a classic frame with DLC 9-15 has 8
+ * @param dlc : DLC, 0 to 15
+ * @return    : payload length
+ */
+uint32_t can_lld_dlc_to_len(uint8_t dlc)
+{
+    return can_lld_dlc_len[dlc & 0x0FU];
+}
+
+void can_lld_cbk_func(uint8_t instance, flexcan_event_type_t eventType,
+                      uint32_t buffIdx, flexcan_state_t *flexcanState)
+{
+    can_lld_event_num++;
+
+    switch (instance)
+    {
+    case INST_CANCOM1:
+        switch (eventType)
+        {
+        case FLEXCAN_EVENT_RX_COMPLETE:
+            can_lld_rx_complete_num++;
+            if ((buffIdx >= can_lld_rx_mb_first) && (buffIdx < (can_lld_rx_mb_first + can_lld_rx_mb_num)))
+            {
+                can_lld_rx_push(&can_lld_rx_mb_msg[buffIdx - can_lld_rx_mb_first]);
+                (void)FLEXCAN_DRV_Receive(INST_CANCOM1, buffIdx, &can_lld_rx_mb_msg[buffIdx - can_lld_rx_mb_first]);
+            }
+            break;
+        case FLEXCAN_EVENT_RXFIFO_COMPLETE:
+            can_lld_rx_fifo_compete_num++;
+            can_lld_rx_push(&can_lld_rx_fifo_msg);
+            /* take the next frame as soon as the FIFO has one */
+            (void)FLEXCAN_DRV_RxFifo(INST_CANCOM1, &can_lld_rx_fifo_msg);
+            break;
+        case FLEXCAN_EVENT_RXFIFO_WARNING:
+            can_lld_rx_fifo_warning_num++;
+            break;
+        case FLEXCAN_EVENT_RXFIFO_OVERFLOW:
+            can_lld_rx_fifo_overflow_num++;
+            can_stats_error(CAN_STATS_ERROR_RX_FIFO_OVERFLOW, 1U);
+            break;
+        case FLEXCAN_EVENT_TX_COMPLETE:
+            can_lld_tx_complete_num++;
+            if ((buffIdx >= can_lld_tx_mb_first) && (buffIdx < (can_lld_tx_mb_first + can_lld_tx_mb_num)))
+            {
+                can_lld_tx_done(&can_lld_tx_mb_frame[buffIdx - can_lld_tx_mb_first]);
+                can_lld_tx_mb_busy &= ~(1UL << (buffIdx - can_lld_tx_mb_first));
+                can_err_tx_ok();
+                can_lld_tx_refill();
+            }
+            break;
+        case FLEXCAN_EVENT_WAKEUP_TIMEOUT:
+            can_lld_wake_up_timeout_num++;
+            break;
+        case FLEXCAN_EVENT_WAKEUP_MATCH:
+            can_lld_wake_up_match_num++;
+            break;
+        case FLEXCAN_EVENT_SELF_WAKEUP:
+            can_lld_self_wake_up_num++;
+            break;
+        case FLEXCAN_EVENT_DMA_COMPLETE:
+            can_lld_dma_complete_num++;
+            break;
+        case FLEXCAN_EVENT_DMA_ERROR:
+            can_lld_dma_error_num++;
+            break;
+        case FLEXCAN_EVENT_ERROR:
+            can_lld_error_num++;
+            break;
+        default:
+            can_lld_default2_num++;
+            break;
+        }
+        break;
+    default:
+        can_lld_default1_num++;
+        break;
+    }
+}
+
+/* @brief: FlexCAN error, bus off, bus off done or warning interrupt. The
+ *         driver clears the interrupt flags of ESR1 after the call
+ * @return: None
+ */
+static void can_lld_error_cbk(uint8_t instance, flexcan_event_type_t eventType, flexcan_state_t *flexcanState)
+{
+    (void)eventType;
+    (void)flexcanState;
+
+    if (instance != INST_CANCOM1)
+    {
+        can_lld_default1_num++;
+        return;
+    }
+    can_lld_error_num++;
+    can_lld_error_value = FLEXCAN_DRV_GetErrorStatus(INST_CANCOM1);
+    can_stats_esr1(can_lld_error_value);
+    can_err_update(can_lld_error_value, xTaskGetTickCountFromISR());
+}
+
+/* @brief: Initialize FlexCAN for a mode and set up its mailboxes. The FD
+ *         configuration is canCom1_InitConfig0 with FD enabled, FD payload
+ *         mailboxes and no RX FIFO
+ * @param mode : CAN_LLD_MODE_CLASSIC or CAN_LLD_MODE_FD
+ * @return     : STATUS_SUCCESS or the error of FLEXCAN_DRV_Init()
+ */
+static status_t can_lld_start(can_lld_mode_t mode)
+{
+    static flexcan_user_config_t config;
+    static flexcan_data_info_t tx_data_info;
+    status_t ret;
+    uint8_t i;
+
+    config = canCom1_InitConfig0;
+    if (mode == CAN_LLD_MODE_FD)
+    {
+        config.fd_enable = true;
+        config.payload = CAN_LLD_FD_PAYLOAD_SIZE;
+        config.max_num_mb = CAN_LLD_FD_MB_NUM;
+        config.is_rx_fifo_needed = false;
+        config.bitrate_cbt = can_lld_fd_data_bitrate;
+        can_lld_tx_mb_first = CAN_LLD_FD_TX_MB_FIRST;
+        can_lld_tx_mb_num = CAN_LLD_FD_TX_MB_NUM;
+        can_lld_rx_mb_first = 0U;
+        can_lld_rx_mb_num = CAN_LLD_FD_RX_MB_NUM;
+    }
+    else
+    {
+        can_lld_tx_mb_first = CAN_LLD_TX_MB_FIRST;
+        can_lld_tx_mb_num = CAN_LLD_TX_MB_NUM;
+        can_lld_rx_mb_first = CAN_LLD_RX_MB_FIRST;
+        can_lld_rx_mb_num = CAN_LLD_FILTER_RX_MB_NUM;
+        if (can_lld_rx_dma_enable)
+        {
+            /* sets MCR[DMA], FLEXCAN_DRV_RxFifo() is never called */
+            config.transfer_type = FLEXCAN_RXFIFO_USING_DMA;
+            config.rxFifoDMAChannel = CAN_LLD_RX_DMA_CHANNEL;
+        }
+        else
+        {
+            config.transfer_type = FLEXCAN_RXFIFO_USING_INTERRUPTS;
+        }
+    }
+    can_lld_tx_mb_all = (1UL << can_lld_tx_mb_num) - 1UL;
+
+    ret = FLEXCAN_DRV_Init(INST_CANCOM1, &canCom1_State, &config);
+    if (ret != STATUS_SUCCESS)
+    {
+        return ret;
+    }
+    INT_SYS_SetPriority(CAN0_ORed_0_15_MB_IRQn, configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY);
+    /* the RX DMA callback wakes the RX task through FreeRTOS as well */
+    INT_SYS_SetPriority(DMA2_IRQn, configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY);
+    /* the error interrupts share the TX queue with the mailbox one */
+    INT_SYS_SetPriority(CAN0_ORed_IRQn, configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY);
+    INT_SYS_SetPriority(CAN0_Error_IRQn, configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY);
+
+    if (mode == CAN_LLD_MODE_FD)
+    {
+        FLEXCAN_DRV_SetTDCOffset(INST_CANCOM1, true, CAN_LLD_FD_TDC_OFFSET);
+        can_lld_fd_rx_init();
+    }
+    else
+    {
+        can_lld_filter_init();
+    }
+    FLEXCAN_DRV_InstallEventCallback(INST_CANCOM1, can_lld_cbk_func, NULL);
+    /* unmasks ERRINT, BOFFINT and the warnings, can_err_start() takes over
+     * the bus off recovery */
+    FLEXCAN_DRV_InstallErrorCallback(INST_CANCOM1, can_lld_error_cbk, NULL);
+    can_lld_tx_quarantined = false;
+    can_err_start();
+
+    /* the TX pool mailboxes start inactive, the ID is set for every frame */
+    tx_data_info.data_length = 8U;
+    tx_data_info.msg_id_type = FLEXCAN_MSG_ID_STD;
+    tx_data_info.fd_enable = (mode == CAN_LLD_MODE_FD);
+    for (i = 0U; i < can_lld_tx_mb_num; i++)
+    {
+        (void)FLEXCAN_DRV_ConfigTxMb(INST_CANCOM1, can_lld_tx_mb_first + i, &tx_data_info, 0U);
+    }
+
+    if ((mode == CAN_LLD_MODE_CLASSIC) && can_lld_rx_dma_enable)
+    {
+        can_lld_rx_dma_start();
+    }
+    else if (mode == CAN_LLD_MODE_CLASSIC)
+    {
+        /* armed once here, the callback re-arms it for every frame */
+        (void)FLEXCAN_DRV_RxFifo(INST_CANCOM1, &can_lld_rx_fifo_msg);
+    }
+    return STATUS_SUCCESS;
+}
+
+/* @brief: Let eDMA channel 2 copy every RX FIFO entry into the ring. FlexCAN
+ *         requests the DMA while the FIFO is not empty, one request moves the
+ *         16 bytes at MB0 and reading them pops the FIFO
+ * @return: None
+ */
+static void can_lld_rx_dma_start(void)
+{
+    static edma_loop_transfer_config_t loop_config;
+    static edma_transfer_config_t transfer_config;
+
+    can_lld_rx_dma_half_num = 0U;
+    can_lld_rx_dma_tail = 0U;
+
+    loop_config.majorLoopIterationCount = CAN_LLD_RX_DMA_SLOTS;
+    loop_config.srcOffsetEnable = false;
+    loop_config.dstOffsetEnable = false;
+    loop_config.minorLoopOffset = 0;
+    loop_config.minorLoopChnLinkEnable = false;
+    loop_config.majorLoopChnLinkEnable = false;
+
+    /* the source wraps inside the 16 bytes of MB0, the destination goes
+     * back to the start of the ring after the major loop */
+    transfer_config.srcAddr = (uint32_t)&CAN0->RAMn[0];
+    transfer_config.destAddr = (uint32_t)can_lld_rx_dma_buf;
+    transfer_config.srcTransferSize = EDMA_TRANSFER_SIZE_4B;
+    transfer_config.destTransferSize = EDMA_TRANSFER_SIZE_4B;
+    transfer_config.srcOffset = 4;
+    transfer_config.destOffset = 4;
+    transfer_config.srcLastAddrAdjust = 0;
+    transfer_config.destLastAddrAdjust = -(int32_t)sizeof(can_lld_rx_dma_buf);
+    transfer_config.srcModulo = EDMA_MODULO_16B;
+    transfer_config.destModulo = EDMA_MODULO_OFF;
+    transfer_config.minorByteTransferCount = sizeof(can_lld_rx_dma_slot_t);
+    transfer_config.scatterGatherEnable = false;
+    transfer_config.interruptEnable = true;
+    transfer_config.loopTransferConfig = &loop_config;
+
+    (void)EDMA_DRV_ConfigLoopTransfer(CAN_LLD_RX_DMA_CHANNEL, &transfer_config);
+    /* runs for ever, interrupts at half and full ring */
+    EDMA_DRV_DisableRequestsOnTransferComplete(CAN_LLD_RX_DMA_CHANNEL, false);
+    EDMA_DRV_ConfigureInterrupt(CAN_LLD_RX_DMA_CHANNEL, EDMA_CHN_HALF_MAJOR_LOOP_INT, true);
+    EDMA_DRV_ConfigureInterrupt(CAN_LLD_RX_DMA_CHANNEL, EDMA_CHN_ERR_INT, true);
+    (void)EDMA_DRV_InstallCallback(CAN_LLD_RX_DMA_CHANNEL, can_lld_rx_dma_cbk, NULL);
+    can_lld_rx_dma_on = true;
+    (void)EDMA_DRV_StartChannel(CAN_LLD_RX_DMA_CHANNEL);
+}
+
+static void can_lld_rx_dma_stop(void)
+{
+    if (can_lld_rx_dma_on)
+    {
+        (void)EDMA_DRV_StopChannel(CAN_LLD_RX_DMA_CHANNEL);
+        can_lld_rx_dma_on = false;
+    }
+}
+
+/* @brief: eDMA channel 2 interrupt, half or full ring written or a DMA error
+ * @return: None
+ */
+static void can_lld_rx_dma_cbk(void *parameter, edma_chn_status_t status)
+{
+    TaskHandle_t waiter;
+    BaseType_t woken = pdFALSE;
+
+    (void)parameter;
+
+    if (status == EDMA_CHN_ERROR)
+    {
+        /* the channel stopped, freertos_task_can_rx goes back to interrupts */
+        can_lld_dma_error_num++;
+        can_stats_error(CAN_STATS_ERROR_DMA, 1U);
+        can_lld_rx_dma_failed = true;
+    }
+    else
+    {
+        can_lld_dma_complete_num++;
+        __atomic_store_n(&can_lld_rx_dma_half_num, can_lld_rx_dma_half_num + 1U, __ATOMIC_RELEASE);
+    }
+
+    waiter = __atomic_load_n(&can_lld_rx_waiter, __ATOMIC_SEQ_CST);
+    if (waiter != NULL)
+    {
+        vTaskNotifyGiveFromISR(waiter, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+}
+
+/* @brief: Free running number of FIFO entries the DMA has written, without
+ *         the one in its minor loop. A half the interrupt has not counted
+ *         yet shows in the position of the DMA, right while the interrupt
+ *         comes within the next half
+ * @return: entries written
+ */
+static uint32_t can_lld_rx_dma_written(void)
+{
+    uint32_t half;
+    uint32_t pos;
+    uint32_t written;
+
+    do
+    {
+        half = __atomic_load_n(&can_lld_rx_dma_half_num, __ATOMIC_ACQUIRE);
+        pos = CAN_LLD_RX_DMA_SLOTS - EDMA_DRV_GetRemainingMajorIterationsCount(CAN_LLD_RX_DMA_CHANNEL);
+    } while (half != __atomic_load_n(&can_lld_rx_dma_half_num, __ATOMIC_ACQUIRE));
+
+    written = (half * CAN_LLD_RX_DMA_HALF) + (pos % CAN_LLD_RX_DMA_HALF);
+    if (((pos / CAN_LLD_RX_DMA_HALF) & 1U) != (half & 1U))
+    {
+        /* the DMA is in the other half, its interrupt is still to come */
+        written += CAN_LLD_RX_DMA_HALF;
+    }
+    return written;
+}
+
+/* @brief: Take the oldest frame out of the DMA ring
+ * @param frame : destination of the frame
+ * @return      : true if a frame was taken
+ */
+static bool can_lld_rx_dma_get(can_lld_rx_frame_t *frame)
+{
+    const can_lld_rx_dma_slot_t *slot;
+    uint32_t written = can_lld_rx_dma_written();
+    uint32_t used = written - can_lld_rx_dma_tail;
+    uint32_t dlc;
+    uint32_t age;
+    uint32_t word;
+
+    if ((int32_t)used <= 0)
+    {
+        return false;
+    }
+    if (used > can_lld_rx_queue_peak)
+    {
+        can_lld_rx_queue_peak = used;
+    }
+    if (used > CAN_LLD_RX_DMA_READABLE)
+    {
+        /* the DMA went round the ring over frames not read yet */
+        (void)__atomic_fetch_add(&can_lld_rx_queue_overflow_num, used - CAN_LLD_RX_DMA_READABLE, __ATOMIC_RELAXED);
+        can_stats_error(CAN_STATS_ERROR_RX_QUEUE_OVERFLOW, used - CAN_LLD_RX_DMA_READABLE);
+        can_lld_rx_dma_tail = written - CAN_LLD_RX_DMA_READABLE;
+    }
+
+    slot = &can_lld_rx_dma_buf[can_lld_rx_dma_tail & (CAN_LLD_RX_DMA_SLOTS - 1U)];
+    /* the frame waited in the ring, the FlexCAN timer dates it back to when
+     * it was received. Right for waits below one timer round, 131 ms */
+    age = (CAN0->TIMER - slot->cs) & CAN_LLD_CS_TIME_STAMP_MASK;
+    frame->tick = xTaskGetTickCount() - (age / (CAN_LLD_BITRATE / configTICK_RATE_HZ));
+    frame->cs = slot->cs;
+    if ((slot->cs & CAN_LLD_CS_IDE_MASK) != 0U)
+    {
+        frame->msgId = slot->id & CAN_LLD_ID_EXT_MASK;
+    }
+    else
+    {
+        frame->msgId = (slot->id >> CAN_LLD_ID_STD_SHIFT) & 0x7FFU;
+    }
+    dlc = (slot->cs & CAN_LLD_CS_DLC_MASK) >> CAN_LLD_CS_DLC_SHIFT;
+    frame->dataLen = (dlc > 8U) ? 8U : (uint8_t)dlc;
+    /* frame->data is not word aligned, and two word stores next to each
+     * other may become an STRD, which faults on an unaligned address */
+    word = __builtin_bswap32(slot->data[0]);
+    memcpy(&frame->data[0], &word, sizeof(word));
+    word = __builtin_bswap32(slot->data[1]);
+    memcpy(&frame->data[4], &word, sizeof(word));
+
+    /* the slot may have been written again while it was copied */
+    if ((can_lld_rx_dma_written() - can_lld_rx_dma_tail) > CAN_LLD_RX_DMA_READABLE)
+    {
+        (void)__atomic_fetch_add(&can_lld_rx_queue_overflow_num, 1U, __ATOMIC_RELAXED);
+        can_stats_error(CAN_STATS_ERROR_RX_QUEUE_OVERFLOW, 1U);
+        can_lld_rx_dma_tail++;
+        return false;
+    }
+    can_lld_rx_dma_tail++;
+    /* the RX mailbox interrupt counts frames too */
+    (void)__atomic_fetch_add(&can_lld_rx_frame_num, 1U, __ATOMIC_RELAXED);
+    can_stats_rx(frame->msgId, frame->cs, frame->tick);
+    return true;
+}
+
+/* @brief: After a DMA error start FlexCAN again with the RX FIFO interrupt.
+ *         Called by freertos_task_can_rx once the ring is drained
+ * @return: None
+ */
+static void can_lld_rx_dma_check(void)
+{
+    if (can_lld_rx_dma_failed)
+    {
+        can_lld_rx_dma_failed = false;
+        can_lld_rx_dma_enable = false;
+        if (can_lld_mode == CAN_LLD_MODE_CLASSIC)
+        {
+            (void)can_lld_restart(CAN_LLD_MODE_CLASSIC);
+        }
+    }
+}
+
+/* @brief: Load the acceptance filters of can_lld_filter.inc. Every table
+ *         element and RX mailbox gets its own mask (MCR[IRMQ] = 1), the old
+ *         global mask of 0 let every frame on the bus interrupt the CPU
+ * @return: None
+ */
+static void can_lld_filter_init(void)
+{
+    uint32_t i;
+#if (CAN_LLD_FILTER_RX_MB_NUM > 0U)
+    flexcan_data_info_t rx_info;
+    flexcan_msgbuff_id_type_t id_type;
+#endif
+
+    FLEXCAN_DRV_ConfigRxFifo(INST_CANCOM1, CAN_LLD_FILTER_FORMAT, can_lld_filter_table);
+    FLEXCAN_DRV_SetRxMaskType(INST_CANCOM1, FLEXCAN_RX_MASK_INDIVIDUAL);
+
+    /* the element masks carry RTR, IDE and the ID fields of the table format,
+     * FLEXCAN_DRV_SetRxIndividualMask() only writes the mailbox layout */
+    FLEXCAN_EnterFreezeMode(CAN0);
+    for (i = 0U; i < CAN_LLD_FILTER_ELEMENT_NUM; i++)
+    {
+        CAN0->RXIMR[i] = can_lld_filter_mask[i];
+    }
+    FLEXCAN_ExitFreezeMode(CAN0);
+
+#if (CAN_LLD_FILTER_RX_MB_NUM > 0U)
+    rx_info.data_length = 8U;
+    rx_info.fd_enable = 0;
+    rx_info.is_remote = 0;
+    for (i = 0U; i < CAN_LLD_FILTER_RX_MB_NUM; i++)
+    {
+        id_type = can_lld_filter_mb[i].ext ? FLEXCAN_MSG_ID_EXT : FLEXCAN_MSG_ID_STD;
+        rx_info.msg_id_type = id_type;
+        (void)FLEXCAN_DRV_ConfigRxMb(INST_CANCOM1, CAN_LLD_RX_MB_FIRST + i, &rx_info, can_lld_filter_mb[i].id);
+        (void)FLEXCAN_DRV_SetRxIndividualMask(INST_CANCOM1, id_type, CAN_LLD_RX_MB_FIRST + i, can_lld_filter_mb[i].mask);
+        (void)FLEXCAN_DRV_Receive(INST_CANCOM1, CAN_LLD_RX_MB_FIRST + i, &can_lld_rx_mb_msg[i]);
+    }
+#else
+    (void)i;
+#endif
+}
+
+/* @brief: RX mailboxes of FD mode. They take every frame, the filter table
+ *         needs the RX FIFO. The interrupt empties a mailbox long before the
+ *         next frame is complete, so frames stay in bus order
+ * @return: None
+ */
+static void can_lld_fd_rx_init(void)
+{
+    flexcan_data_info_t rx_info;
+    uint8_t i;
+
+    rx_info.data_length = CAN_LLD_FD_PAYLOAD;
+    rx_info.fd_enable = 1;
+    rx_info.is_remote = 0;
+    FLEXCAN_DRV_SetRxMaskType(INST_CANCOM1, FLEXCAN_RX_MASK_INDIVIDUAL);
+    for (i = 0U; i < CAN_LLD_FD_RX_MB_NUM; i++)
+    {
+        rx_info.msg_id_type = (i < CAN_LLD_FD_RX_MB_STD_NUM) ? FLEXCAN_MSG_ID_STD : FLEXCAN_MSG_ID_EXT;
+        (void)FLEXCAN_DRV_ConfigRxMb(INST_CANCOM1, i, &rx_info, 0U);
+        (void)FLEXCAN_DRV_SetRxIndividualMask(INST_CANCOM1, rx_info.msg_id_type, i, 0U);
+        (void)FLEXCAN_DRV_Receive(INST_CANCOM1, i, &can_lld_rx_mb_msg[i]);
+    }
+}
+
+/* @brief: Copy a frame into the RX queue, called from the CAN interrupt
+ * @param msg : frame read from the RX FIFO
+ * @return    : None
+ */
+static void can_lld_rx_push(const flexcan_msgbuff_t *msg)
+{
+    uint32_t head = can_lld_rx_queue_head;
+    uint32_t used = head - __atomic_load_n(&can_lld_rx_queue_tail, __ATOMIC_ACQUIRE);
+    can_lld_rx_frame_t *frame;
+    TaskHandle_t waiter;
+    BaseType_t woken = pdFALSE;
+
+    can_stats_rx(msg->msgId, msg->cs, xTaskGetTickCountFromISR());
+    if (used >= CAN_LLD_RX_QUEUE_SIZE)
+    {
+        can_lld_rx_queue_overflow_num++;
+        can_stats_error(CAN_STATS_ERROR_RX_QUEUE_OVERFLOW, 1U);
+        return;
+    }
+
+    frame = &can_lld_rx_queue[head & CAN_LLD_RX_QUEUE_MASK];
+    frame->tick = xTaskGetTickCountFromISR();
+    frame->cs = msg->cs;
+    frame->msgId = msg->msgId;
+    frame->dataLen = (msg->dataLen > CAN_LLD_PAYLOAD_MAX) ? CAN_LLD_PAYLOAD_MAX : msg->dataLen;
+    memcpy(frame->data, msg->data, frame->dataLen);
+    __atomic_store_n(&can_lld_rx_queue_head, head + 1U, __ATOMIC_SEQ_CST);
+
+    can_lld_rx_frame_num++;
+    if ((msg->cs & CAN_LLD_CS_EDL_MASK) != 0U)
+    {
+        can_lld_rx_fd_frame_num++;
+    }
+    if ((used + 1U) > can_lld_rx_queue_peak)
+    {
+        can_lld_rx_queue_peak = used + 1U;
+    }
+
+    waiter = __atomic_load_n(&can_lld_rx_waiter, __ATOMIC_SEQ_CST);
+    if (waiter != NULL)
+    {
+        vTaskNotifyGiveFromISR(waiter, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+}
+
+/* @brief: Arbitration order of a message ID, the lower key wins the bus.
+ *         The 11 base ID bits are compared first, a standard frame beats an
+ *         extended one with the same base ID (RTR against the recessive SRR,
+ *         then IDE), then the 18 extended ID bits
+ * @param messageId : Message ID as passed to can_lld_tx()
+ * @return          : key
+ */
+static uint32_t can_lld_tx_key(uint32_t messageId)
+{
+    uint32_t id;
+
+    if ((messageId & CAN_LLD_TX_ID_EXT) != 0U)
+    {
+        id = messageId & 0x1FFFFFFFU;
+        return ((id >> 18) << 19) | (1UL << 18) | (id & 0x3FFFFU);
+    }
+
+    return (messageId & 0x7FFU) << 19;
+}
+
+static bool can_lld_tx_before(const can_lld_tx_frame_t *a, const can_lld_tx_frame_t *b)
+{
+    if (a->key != b->key)
+    {
+        return a->key < b->key;
+    }
+    return (int32_t)(a->seq - b->seq) < 0;
+}
+
+static void can_lld_tx_queue_push(const can_lld_tx_frame_t *frame)
+{
+    uint32_t i = can_lld_tx_queue_num++;
+    uint32_t parent;
+
+    while (i > 0U)
+    {
+        parent = (i - 1U) / 2U;
+        if (!can_lld_tx_before(frame, &can_lld_tx_queue[parent]))
+        {
+            break;
+        }
+        can_lld_tx_queue[i] = can_lld_tx_queue[parent];
+        i = parent;
+    }
+    can_lld_tx_queue[i] = *frame;
+}
+
+static void can_lld_tx_queue_pop(can_lld_tx_frame_t *frame)
+{
+    const can_lld_tx_frame_t *last;
+    uint32_t i = 0U;
+    uint32_t child;
+
+    *frame = can_lld_tx_queue[0];
+    last = &can_lld_tx_queue[--can_lld_tx_queue_num];
+
+    for (;;)
+    {
+        child = 2U * i + 1U;
+        if (child >= can_lld_tx_queue_num)
+        {
+            break;
+        }
+        if (((child + 1U) < can_lld_tx_queue_num) &&
+            can_lld_tx_before(&can_lld_tx_queue[child + 1U], &can_lld_tx_queue[child]))
+        {
+            child++;
+        }
+        if (!can_lld_tx_before(&can_lld_tx_queue[child], last))
+        {
+            break;
+        }
+        can_lld_tx_queue[i] = can_lld_tx_queue[child];
+        i = child;
+    }
+    can_lld_tx_queue[i] = *last;
+}
+
+/* @brief: Load free pool mailboxes from the head of the TX queue. Called from
+ *         the CAN interrupt or with it masked
+ * @return: None
+ */
+static void can_lld_tx_refill(void)
+{
+    static flexcan_data_info_t dataInfo;
+    can_lld_tx_frame_t *frame;
+    uint32_t slot;
+    uint32_t busy;
+
+    dataInfo.is_remote = 0;
+    dataInfo.fd_padding = CAN_LLD_FD_PADDING_BYTE;
+
+    if (can_lld_tx_stopped || can_lld_tx_quarantined)
+    {
+        return;
+    }
+
+    while ((can_lld_tx_queue_num > 0U) && (can_lld_tx_mb_busy != can_lld_tx_mb_all))
+    {
+        /* FlexCAN sends equal IDs lowest mailbox first, which is not the queue
+         * order, so a frame waits until the one with its ID has left */
+        for (busy = can_lld_tx_mb_busy; busy != 0U; busy &= busy - 1U)
+        {
+            slot = (uint32_t)__builtin_ctz(busy);
+            if (can_lld_tx_mb_frame[slot].key == can_lld_tx_queue[0].key)
+            {
+                return;
+            }
+        }
+
+        slot = (uint32_t)__builtin_ctz(~can_lld_tx_mb_busy);
+        frame = &can_lld_tx_mb_frame[slot];
+        can_lld_tx_queue_pop(frame);
+
+        dataInfo.data_length = frame->dataLen;
+        dataInfo.fd_enable = frame->fd;
+        dataInfo.enable_brs = frame->fd && (CAN_LLD_FD_BRS_ENABLE != 0);
+        if ((frame->msgId & CAN_LLD_TX_ID_EXT) != 0U)
+        {
+            dataInfo.msg_id_type = FLEXCAN_MSG_ID_EXT;
+        }
+        else
+        {
+            dataInfo.msg_id_type = FLEXCAN_MSG_ID_STD;
+        }
+
+        can_lld_debug_tx_ret_val = FLEXCAN_DRV_Send(INST_CANCOM1, can_lld_tx_mb_first + slot, &dataInfo,
+                                                    frame->msgId & ~CAN_LLD_TX_ID_EXT, frame->data);
+        if (can_lld_debug_tx_ret_val == STATUS_SUCCESS)
+        {
+            can_lld_tx_mb_busy |= 1UL << slot;
+        }
+        else
+        {
+            can_lld_tx_error_num++;
+        }
+    }
+}
+
+#if CAN_LLD_TX_CANCEL_ENABLE
+/* @brief: Make room for the head of the TX queue if the pool is full of lower
+ *         priority frames. Called with the CAN interrupt masked, the abort
+ *         waits at most for the end of the frame on the wire
+ * @return: None
+ */
+static void can_lld_tx_cancel(void)
+{
+    uint32_t slot;
+    uint32_t worst = 0U;
+
+    if (can_lld_tx_stopped || can_lld_tx_quarantined || (can_lld_tx_mb_busy != can_lld_tx_mb_all) || (can_lld_tx_queue_num == 0U) ||
+        (can_lld_tx_queue_num >= CAN_LLD_TX_QUEUE_SIZE))
+    {
+        return;
+    }
+
+    for (slot = 1U; slot < can_lld_tx_mb_num; slot++)
+    {
+        if (can_lld_tx_before(&can_lld_tx_mb_frame[worst], &can_lld_tx_mb_frame[slot]))
+        {
+            worst = slot;
+        }
+    }
+    /* same key: the queued frame is the younger one and has to wait anyway */
+    if (can_lld_tx_queue[0].key >= can_lld_tx_mb_frame[worst].key)
+    {
+        return;
+    }
+
+    can_lld_tx_mb_busy &= ~(1UL << worst);
+    if (STATUS_SUCCESS == FLEXCAN_DRV_AbortTransfer(INST_CANCOM1, can_lld_tx_mb_first + worst))
+    {
+        /* it lost arbitration until now, back into the queue with its seq */
+        can_lld_tx_cancel_num++;
+        can_lld_tx_queue_push(&can_lld_tx_mb_frame[worst]);
+    }
+    else
+    {
+        /* it was on the wire and went out, the abort ate TX_COMPLETE */
+        can_lld_tx_complete_num++;
+        can_lld_tx_done(&can_lld_tx_mb_frame[worst]);
+    }
+}
+#endif
+
+/* @brief: A frame left its mailbox on the wire, called from the CAN
+ *         interrupt or with it masked
+ * @param frame : the frame of the mailbox
+ * @return      : None
+ */
+static void can_lld_tx_done(const can_lld_tx_frame_t *frame)
+{
+    can_stats_tx(frame->msgId, frame->dataLen, frame->fd, frame->tick, xTaskGetTickCountFromISR());
+}
+
+/* @brief: Take the frames loaded into the pool mailboxes back into the TX
+ *         queue, like can_lld_tx_cancel(). Called from the CAN interrupts or
+ *         with them masked
+ * @return: None
+ */
+static void can_lld_tx_unload(void)
+{
+    uint32_t busy;
+    uint32_t slot;
+
+    for (busy = can_lld_tx_mb_busy; busy != 0U; busy &= busy - 1U)
+    {
+        slot = (uint32_t)__builtin_ctz(busy);
+        if (STATUS_SUCCESS != FLEXCAN_DRV_AbortTransfer(INST_CANCOM1, can_lld_tx_mb_first + slot))
+        {
+            can_lld_tx_complete_num++;
+            can_lld_tx_done(&can_lld_tx_mb_frame[slot]);
+        }
+        else if (can_lld_tx_queue_num < CAN_LLD_TX_QUEUE_SIZE)
+        {
+            can_lld_tx_queue_push(&can_lld_tx_mb_frame[slot]);
+        }
+        else
+        {
+            can_lld_tx_error_num++;
+        }
+    }
+    can_lld_tx_mb_busy = 0U;
+}
+
+/* @brief: Remove frames from the TX queue. Called with the CAN interrupts
+ *         masked
+ * @param fd  : remove the FD frames, they cannot be sent in classic mode
+ * @param age : remove the frames queued this many ticks ago or earlier, 0
+ *              for none
+ * @return    : None
+ */
+static void can_lld_tx_queue_drop(bool fd, TickType_t age)
+{
+    can_lld_tx_frame_t frame;
+    TickType_t now = xTaskGetTickCountFromISR();
+    uint32_t num = can_lld_tx_queue_num;
+    uint32_t i;
+
+    /* the heap is built again in place, a frame is always pushed to an index
+     * below the one it is read from */
+    can_lld_tx_queue_num = 0U;
+    for (i = 0U; i < num; i++)
+    {
+        frame = can_lld_tx_queue[i];
+        if (fd && frame.fd)
+        {
+            can_lld_tx_error_num++;
+        }
+        else if ((age != 0U) && ((TickType_t)(now - frame.tick) >= age))
+        {
+            can_lld_tx_stale_num++;
+        }
+        else
+        {
+            can_lld_tx_queue_push(&frame);
+        }
+    }
+}
+
+/* @brief: Bus off, nothing can be sent. The loaded frames go back into the
+ *         TX queue and no mailbox is loaded until can_lld_tx_release().
+ *         Called from the CAN error interrupts or with them masked
+ * @return: None
+ */
+void can_lld_tx_quarantine(void)
+{
+    can_lld_tx_quarantined = true;
+    can_lld_tx_unload();
+}
+
+/* @brief: Back on the bus, send the TX queue again. Called from the CAN
+ *         error interrupts or with them masked
+ * @param age : frames queued this many ticks ago or earlier are dropped, 0
+ *              keeps them all
+ * @return    : None
+ */
+void can_lld_tx_release(TickType_t age)
+{
+    can_lld_tx_quarantined = false;
+    if (age != 0U)
+    {
+        can_lld_tx_queue_drop(false, age);
+    }
+    can_lld_tx_refill();
+}
+
+/* @brief: Application handling of one received frame
+ * @param frame : received frame
+ * @return      : None
+ */
+static void can_lld_rx_process(const can_lld_rx_frame_t *frame)
+{
+    (void)isotp_rx_frame(frame);
+}
+
+static uint8_t *can_lld_isotp_rx_buf(uint8_t channel, uint32_t len)
+{
+    if ((len > CAN_LLD_ISOTP_BUF_SIZE) ||
+        ((channel == CAN_LLD_ISOTP_ECHO_CHANNEL) && can_lld_isotp_echo_busy))
+    {
+        return NULL;
+    }
+    return can_lld_isotp_buf[channel];
+}
+
+static void can_lld_isotp_rx_done(uint8_t channel, uint8_t *data, uint32_t len, isotp_result_t result)
+{
+    if (result != ISOTP_RESULT_OK)
+    {
+        return;
+    }
+
+    if (channel == CAN_LLD_ISOTP_ECHO_CHANNEL)
+    {
+        if (STATUS_SUCCESS == isotp_send(channel, data, len))
+        {
+            can_lld_isotp_echo_busy = true;
+        }
+    }
+    else
+    {
+#if CAN_LLD_PRINTF_TEST_ENABLE
+        printf("%.*s\n", (int)len, (const char *)data);
+#endif
+    }
+}
+
+static void can_lld_isotp_tx_done(uint8_t channel, const uint8_t *data, isotp_result_t result)
+{
+    (void)data;
+    (void)result;
+
+    if (channel == CAN_LLD_ISOTP_ECHO_CHANNEL)
+    {
+        can_lld_isotp_echo_busy = false;
+    }
+}
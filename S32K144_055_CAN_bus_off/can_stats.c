@@ -0,0 +1,501 @@
+#include "can_stats.h"
+
+#define CAN_STATS_ID_MASK (CAN_STATS_ID_NUM - 1U)
+/* set in every key, a standard ID 0 is not taken for a free entry */
+#define CAN_STATS_KEY_USED 0x40000000U
+
+/* bus load is counted in 1/8 nominal bit times, a FD data phase bit is a
+ * fraction of a nominal one */
+#define CAN_STATS_BIT_SCALE 8U
+#define CAN_STATS_DATA_BIT_UNITS ((CAN_STATS_BIT_SCALE * CAN_LLD_BITRATE) / CAN_LLD_FD_DATA_BITRATE)
+
+#if (CAN_STATS_ID_NUM & CAN_STATS_ID_MASK) != 0U || (CAN_STATS_ID_NUM > 256U)
+#error "CAN_STATS_ID_NUM must be a power of 2, 256 at most"
+#endif
+
+#if (CAN_STATS_DATA_BIT_UNITS == 0U) || \
+    ((CAN_STATS_DATA_BIT_UNITS * CAN_LLD_FD_DATA_BITRATE) != (CAN_STATS_BIT_SCALE * CAN_LLD_BITRATE))
+#error "CAN_LLD_FD_DATA_BITRATE must be CAN_LLD_BITRATE times 1, 2, 4 or 8"
+#endif
+
+/* One ID. The CAN interrupt and freertos_task_can_rx update it with atomic
+ * operations only, every field stays consistent on its own. Minimums are
+ * kept inverted, so 0 means no value yet and they are updated like maximums */
+typedef struct
+{
+    uint32_t key;               /* ID | CAN_LLD_TX_ID_EXT | CAN_STATS_KEY_USED, 0 = free */
+    uint32_t frame_num;
+    uint32_t last_tick;
+    uint32_t period_min_inv;
+    uint32_t period_max;
+    uint32_t hist[CAN_STATS_HIST_NUM];
+    uint32_t latency_num;
+    uint32_t latency_sum;
+    uint32_t latency_min_inv;
+    uint32_t latency_max;
+    /* can_stats_step() only */
+    uint32_t window_frame_num;
+    uint32_t rate;
+} can_stats_entry_t;
+
+/* 0.01 %, last window, without and with worst case stuffing */
+uint32_t can_stats_bus_load;
+uint32_t can_stats_bus_load_peak;
+uint32_t can_stats_bus_load_worst;
+uint32_t can_stats_bus_load_worst_peak;
+uint32_t can_stats_frame_num;
+uint32_t can_stats_no_entry_num;
+uint32_t can_stats_error_num[CAN_STATS_ERROR_NUM];
+/* last snapshot of can_stats_export(), FreeMASTER reads it from here */
+uint8_t can_stats_export_buf[CAN_STATS_EXPORT_SIZE];
+uint32_t can_stats_export_len;
+
+static can_stats_entry_t can_stats_table[CAN_STATS_ID_NUM];
+/* every frame counted, CAN_STATS_BIT_SCALE per nominal bit. The worst case
+ * stuff bits are kept apart */
+static uint32_t can_stats_bit_units = 0U;
+static uint32_t can_stats_stuff_units = 0U;
+
+/* ESR1 bit of each error class up to CAN_STATS_ERROR_TX_WARNING */
+static const uint32_t can_stats_esr1_mask[CAN_STATS_ERROR_TX_WARNING + 1U] =
+{
+    CAN_ESR1_BIT0ERR_MASK,
+    CAN_ESR1_BIT1ERR_MASK,
+    CAN_ESR1_STFERR_MASK,
+    CAN_ESR1_FRMERR_MASK,
+    CAN_ESR1_CRCERR_MASK,
+    CAN_ESR1_ACKERR_MASK,
+    CAN_ESR1_BIT0ERR_FAST_MASK,
+    CAN_ESR1_BIT1ERR_FAST_MASK,
+    CAN_ESR1_STFERR_FAST_MASK,
+    CAN_ESR1_FRMERR_FAST_MASK,
+    CAN_ESR1_CRCERR_FAST_MASK,
+    CAN_ESR1_RWRNINT_MASK,
+    CAN_ESR1_TWRNINT_MASK
+};
+
+static can_stats_entry_t *can_stats_entry(uint32_t key);
+static can_stats_entry_t *can_stats_frame(uint32_t key, bool ext, bool fd, bool brs, uint32_t len, TickType_t tick);
+static uint32_t can_stats_frame_bits(bool ext, bool fd, bool brs, uint32_t len, uint32_t *stuff);
+static uint32_t can_stats_load(uint32_t units, uint32_t ticks);
+static void can_stats_max(uint32_t *value, uint32_t sample);
+static uint8_t *can_stats_put16(uint8_t *p, uint32_t value);
+static uint8_t *can_stats_put32(uint8_t *p, uint32_t value);
+static uint32_t can_stats_packet(uint8_t *p, uint8_t type, uint32_t len);
+static uint16_t can_stats_crc16(const uint8_t *data, uint32_t len);
+
+/* @brief: Count a received frame, from the CAN interrupt or a task
+ * @param msgId : ID of the frame
+ * @param cs    : CS word of the mailbox, IDE, EDL, BRS and DLC are used
+ * @param tick  : FreeRTOS tick the frame arrived
+ * @return      : None
+ */
+void can_stats_rx(uint32_t msgId, uint32_t cs, TickType_t tick)
+{
+    bool ext = (cs & CAN_LLD_CS_IDE_MASK) != 0U;
+    bool fd = (cs & CAN_LLD_CS_EDL_MASK) != 0U;
+    uint32_t dlc = (cs & CAN_LLD_CS_DLC_MASK) >> CAN_LLD_CS_DLC_SHIFT;
+    uint32_t len = fd ? can_lld_dlc_to_len((uint8_t)dlc) : ((dlc > 8U) ? 8U : dlc);
+
+    (void)can_stats_frame(msgId | (ext ? CAN_LLD_TX_ID_EXT : 0U), ext, fd,
+                          fd && ((cs & CAN_LLD_CS_BRS_MASK) != 0U), len, tick);
+}
+
+/* @brief: Count a sent frame, from the TX_COMPLETE interrupt
+ * @param msgId  : ID as passed to can_lld_tx(), with CAN_LLD_TX_ID_EXT
+ * @param len    : payload length on the wire
+ * @param fd     : sent as a FD frame
+ * @param queued : FreeRTOS tick the frame was handed to can_lld_tx()
+ * @param tick   : FreeRTOS tick it was sent
+ * @return       : None
+ */
+void can_stats_tx(uint32_t msgId, uint32_t len, bool fd, TickType_t queued, TickType_t tick)
+{
+    can_stats_entry_t *entry;
+    uint32_t latency = (uint32_t)(tick - queued);
+
+    entry = can_stats_frame(msgId, (msgId & CAN_LLD_TX_ID_EXT) != 0U, fd,
+                            fd && (CAN_LLD_FD_BRS_ENABLE != 0), len, tick);
+    if (entry != NULL)
+    {
+        (void)__atomic_fetch_add(&entry->latency_num, 1U, __ATOMIC_RELAXED);
+        (void)__atomic_fetch_add(&entry->latency_sum, latency, __ATOMIC_RELAXED);
+        can_stats_max(&entry->latency_min_inv, ~latency);
+        can_stats_max(&entry->latency_max, latency);
+    }
+}
+
+/* @brief: Count errors of one class, from interrupts or tasks
+ * @param error : class
+ * @param num   : errors
+ * @return      : None
+ */
+void can_stats_error(can_stats_error_t error, uint32_t num)
+{
+    if (error < CAN_STATS_ERROR_NUM)
+    {
+        (void)__atomic_fetch_add(&can_stats_error_num[error], num, __ATOMIC_RELAXED);
+    }
+}
+
+/* @brief: Count the error flags of an ESR1 value. The error bits hold since
+ *         the last read of ESR1, so a class is counted once per read however
+ *         many errors there were. Error passive is counted when it is entered.
+ *         Called from the CAN error interrupts or with them masked
+ * @param esr1 : ESR1 as returned by FLEXCAN_DRV_GetErrorStatus()
+ * @return     : None
+ */
+void can_stats_esr1(uint32_t esr1)
+{
+    static bool passive = false;
+    uint32_t fltconf = (esr1 & CAN_ESR1_FLTCONF_MASK) >> CAN_ESR1_FLTCONF_SHIFT;
+    uint32_t i;
+
+    for (i = 0U; i <= (uint32_t)CAN_STATS_ERROR_TX_WARNING; i++)
+    {
+        if ((esr1 & can_stats_esr1_mask[i]) != 0U)
+        {
+            can_stats_error((can_stats_error_t)i, 1U);
+        }
+    }
+    if ((fltconf == 1U) && !passive)
+    {
+        can_stats_error(CAN_STATS_ERROR_PASSIVE, 1U);
+    }
+    passive = (fltconf == 1U);
+    if ((esr1 & CAN_ESR1_BOFFINT_MASK) != 0U)
+    {
+        can_stats_error(CAN_STATS_ERROR_BUS_OFF, 1U);
+    }
+}
+
+/* @brief: Close a window: frame rate of every ID and the bus load. Called
+ *         every CAN_STATS_WINDOW_MS by freertos_task_1000ms
+ * @return: None
+ */
+void can_stats_step(void)
+{
+    static TickType_t last_tick = 0U;
+    static uint32_t last_units = 0U;
+    static uint32_t last_stuff = 0U;
+    static bool started = false;
+    TickType_t now = xTaskGetTickCount();
+    uint32_t ticks = (uint32_t)(now - last_tick);
+    uint32_t units = __atomic_load_n(&can_stats_bit_units, __ATOMIC_RELAXED);
+    uint32_t stuff = __atomic_load_n(&can_stats_stuff_units, __ATOMIC_RELAXED);
+    uint32_t frame_num;
+    uint32_t i;
+
+    if (started && (ticks != 0U))
+    {
+        can_stats_bus_load = can_stats_load(units - last_units, ticks);
+        can_stats_bus_load_worst = can_stats_load((units - last_units) + (stuff - last_stuff), ticks);
+        if (can_stats_bus_load > can_stats_bus_load_peak)
+        {
+            can_stats_bus_load_peak = can_stats_bus_load;
+        }
+        if (can_stats_bus_load_worst > can_stats_bus_load_worst_peak)
+        {
+            can_stats_bus_load_worst_peak = can_stats_bus_load_worst;
+        }
+        for (i = 0U; i < CAN_STATS_ID_NUM; i++)
+        {
+            if (__atomic_load_n(&can_stats_table[i].key, __ATOMIC_ACQUIRE) != 0U)
+            {
+                frame_num = __atomic_load_n(&can_stats_table[i].frame_num, __ATOMIC_RELAXED);
+                can_stats_table[i].rate = (uint32_t)(((uint64_t)(frame_num - can_stats_table[i].window_frame_num) *
+                                                      configTICK_RATE_HZ) / ticks);
+                can_stats_table[i].window_frame_num = frame_num;
+            }
+        }
+    }
+    started = true;
+    last_tick = now;
+    last_units = units;
+    last_stuff = stuff;
+}
+
+/* @brief: IDs with a table entry
+ * @return: entries in use
+ */
+uint32_t can_stats_id_num(void)
+{
+    uint32_t num = 0U;
+    uint32_t i;
+
+    for (i = 0U; i < CAN_STATS_ID_NUM; i++)
+    {
+        if (__atomic_load_n(&can_stats_table[i].key, __ATOMIC_ACQUIRE) != 0U)
+        {
+            num++;
+        }
+    }
+    return num;
+}
+
+/* @brief: Write a snapshot as packets, see can_stats.h. Counters are read one
+ *         by one while the bus goes on, they are not from the same instant
+ * @param buf  : destination, CAN_STATS_EXPORT_SIZE always fits
+ * @param size : size of buf, ID packets which do not fit are left out
+ * @return     : bytes written
+ */
+uint32_t can_stats_export(uint8_t *buf, uint32_t size)
+{
+    const can_stats_entry_t *entry;
+    uint8_t *p = buf;
+    uint8_t *payload;
+    uint32_t id_num = can_stats_id_num();
+    uint32_t value;
+    uint32_t i;
+    uint32_t j;
+
+    if (size < (CAN_STATS_PACKET_OVERHEAD + CAN_STATS_SUMMARY_SIZE))
+    {
+        return 0U;
+    }
+    if (id_num > ((size - CAN_STATS_PACKET_OVERHEAD - CAN_STATS_SUMMARY_SIZE) /
+                  (CAN_STATS_PACKET_OVERHEAD + CAN_STATS_ID_SIZE)))
+    {
+        id_num = (size - CAN_STATS_PACKET_OVERHEAD - CAN_STATS_SUMMARY_SIZE) /
+                 (CAN_STATS_PACKET_OVERHEAD + CAN_STATS_ID_SIZE);
+    }
+
+    payload = &p[4];
+    *payload++ = CAN_STATS_PACKET_VERSION;
+    *payload++ = (uint8_t)id_num;
+    payload = can_stats_put16(payload, CAN_STATS_WINDOW_MS);
+    payload = can_stats_put32(payload, xTaskGetTickCount());
+    payload = can_stats_put16(payload, can_stats_bus_load);
+    payload = can_stats_put16(payload, can_stats_bus_load_peak);
+    payload = can_stats_put16(payload, can_stats_bus_load_worst);
+    payload = can_stats_put16(payload, can_stats_bus_load_worst_peak);
+    payload = can_stats_put32(payload, __atomic_load_n(&can_stats_frame_num, __ATOMIC_RELAXED));
+    payload = can_stats_put32(payload, __atomic_load_n(&can_stats_no_entry_num, __ATOMIC_RELAXED));
+    for (i = 0U; i < CAN_STATS_ERROR_NUM; i++)
+    {
+        payload = can_stats_put32(payload, __atomic_load_n(&can_stats_error_num[i], __ATOMIC_RELAXED));
+    }
+    p += can_stats_packet(p, CAN_STATS_PACKET_SUMMARY, CAN_STATS_SUMMARY_SIZE);
+
+    for (i = 0U; (i < CAN_STATS_ID_NUM) && (id_num > 0U); i++)
+    {
+        entry = &can_stats_table[i];
+        value = __atomic_load_n(&entry->key, __ATOMIC_ACQUIRE);
+        if (value == 0U)
+        {
+            continue;
+        }
+        id_num--;
+
+        payload = &p[4];
+        payload = can_stats_put32(payload, value & ~CAN_STATS_KEY_USED);
+        payload = can_stats_put32(payload, __atomic_load_n(&entry->frame_num, __ATOMIC_RELAXED));
+        payload = can_stats_put16(payload, entry->rate);
+        payload = can_stats_put32(payload, ~__atomic_load_n(&entry->period_min_inv, __ATOMIC_RELAXED));
+        payload = can_stats_put32(payload, __atomic_load_n(&entry->period_max, __ATOMIC_RELAXED));
+        payload = can_stats_put32(payload, __atomic_load_n(&entry->latency_num, __ATOMIC_RELAXED));
+        payload = can_stats_put32(payload, __atomic_load_n(&entry->latency_sum, __ATOMIC_RELAXED));
+        payload = can_stats_put16(payload, ~__atomic_load_n(&entry->latency_min_inv, __ATOMIC_RELAXED));
+        payload = can_stats_put16(payload, __atomic_load_n(&entry->latency_max, __ATOMIC_RELAXED));
+        for (j = 0U; j < CAN_STATS_HIST_NUM; j++)
+        {
+            payload = can_stats_put16(payload, __atomic_load_n(&entry->hist[j], __ATOMIC_RELAXED));
+        }
+        p += can_stats_packet(p, CAN_STATS_PACKET_ID, CAN_STATS_ID_SIZE);
+    }
+
+    return (uint32_t)(p - buf);
+}
+
+/* @brief: Entry of an ID, a free one is taken on the first frame
+ * @param key : ID | CAN_LLD_TX_ID_EXT | CAN_STATS_KEY_USED
+ * @return    : entry, NULL if the probed entries all belong to other IDs
+ */
+static can_stats_entry_t *can_stats_entry(uint32_t key)
+{
+    can_stats_entry_t *entry;
+    uint32_t hash = (key * 0x9E3779B1U) >> 24;
+    uint32_t cur;
+    uint32_t i;
+
+    for (i = 0U; i < CAN_STATS_PROBE_MAX; i++)
+    {
+        entry = &can_stats_table[(hash + i) & CAN_STATS_ID_MASK];
+        cur = __atomic_load_n(&entry->key, __ATOMIC_ACQUIRE);
+        if (cur == 0U)
+        {
+            /* an interrupt may take it first, maybe for the same ID */
+            if (__atomic_compare_exchange_n(&entry->key, &cur, key, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            {
+                return entry;
+            }
+        }
+        if (cur == key)
+        {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+/* @brief: Count one frame on the bus for its ID and the bus load
+ * @param key  : ID | CAN_LLD_TX_ID_EXT
+ * @param ext  : 29 bit ID
+ * @param fd   : FD frame
+ * @param brs  : FD frame with bitrate switch
+ * @param len  : payload length
+ * @param tick : FreeRTOS tick of the frame
+ * @return     : entry of the ID, NULL if the table is full
+ */
+static can_stats_entry_t *can_stats_frame(uint32_t key, bool ext, bool fd, bool brs, uint32_t len, TickType_t tick)
+{
+    can_stats_entry_t *e = can_stats_entry(key | CAN_STATS_KEY_USED);
+    uint32_t stuff;
+    uint32_t bits = can_stats_frame_bits(ext, fd, brs, len, &stuff);
+    uint32_t last;
+    uint32_t period;
+    uint32_t jitter;
+    uint32_t bucket;
+
+    (void)__atomic_fetch_add(&can_stats_bit_units, bits, __ATOMIC_RELAXED);
+    (void)__atomic_fetch_add(&can_stats_stuff_units, stuff, __ATOMIC_RELAXED);
+    (void)__atomic_fetch_add(&can_stats_frame_num, 1U, __ATOMIC_RELAXED);
+    if (e == NULL)
+    {
+        (void)__atomic_fetch_add(&can_stats_no_entry_num, 1U, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    last = __atomic_exchange_n(&e->last_tick, (uint32_t)tick, __ATOMIC_RELAXED);
+    if (__atomic_fetch_add(&e->frame_num, 1U, __ATOMIC_RELAXED) == 0U)
+    {
+        return e;
+    }
+    /* a frame dated back by the RX DMA may be older than the last one */
+    period = ((int32_t)((uint32_t)tick - last) > 0) ? ((uint32_t)tick - last) : 0U;
+    can_stats_max(&e->period_min_inv, ~period);
+    can_stats_max(&e->period_max, period);
+
+    /* jitter: how much longer than the shortest one the period was */
+    jitter = period - ~__atomic_load_n(&e->period_min_inv, __ATOMIC_RELAXED);
+    bucket = (jitter == 0U) ? 0U : (32U - (uint32_t)__builtin_clz(jitter));
+    if (bucket >= CAN_STATS_HIST_NUM)
+    {
+        bucket = CAN_STATS_HIST_NUM - 1U;
+    }
+    (void)__atomic_fetch_add(&e->hist[bucket], 1U, __ATOMIC_RELAXED);
+    return e;
+}
+
+/* @brief: Bits of a frame including the 3 bit intermission, ISO 11898-1.
+ *         The FD data phase is counted at the data bitrate
+ * @param ext   : 29 bit ID
+ * @param fd    : FD frame
+ * @param brs   : FD frame with bitrate switch
+ * @param len   : payload length
+ * @param stuff : the worst case number of stuff bits, one after every 4 bits
+ *                of the stuffed fields
+ * @return      : length without stuff bits, CAN_STATS_BIT_SCALE per nominal
+ *                bit
+ */
+static uint32_t can_stats_frame_bits(bool ext, bool fd, bool brs, uint32_t len, uint32_t *stuff)
+{
+    uint32_t arb = ext ? 36U : 17U;
+    uint32_t data_unit = brs ? CAN_STATS_DATA_BIT_UNITS : CAN_STATS_BIT_SCALE;
+    uint32_t data;
+    uint32_t crc;
+
+    if (!fd)
+    {
+        /* SOF to the end of the CRC is stuffed, then CRC delimiter, ACK, EOF
+         * and intermission */
+        data = (ext ? 54U : 34U) + (8U * len);
+        *stuff = ((data - 1U) / 4U) * CAN_STATS_BIT_SCALE;
+        return (data + 13U) * CAN_STATS_BIT_SCALE;
+    }
+
+    /* arbitration phase SOF to BRS, the data phase from ESI to the end of
+     * the data is stuffed. The stuff count and the CRC have their fixed stuff
+     * bits, counted in the length */
+    crc = (len > 16U) ? 21U : 17U;
+    data = 5U + (8U * len);
+    *stuff = (((arb - 1U) / 4U) * CAN_STATS_BIT_SCALE) + ((data / 4U) * data_unit);
+    data += 4U + crc + ((4U + crc) / 4U) + 1U;
+    return ((arb + 13U) * CAN_STATS_BIT_SCALE) + (data * data_unit);
+}
+
+/* @brief: Bus load of a window
+ * @param units : frame lengths, CAN_STATS_BIT_SCALE per nominal bit
+ * @param ticks : length of the window
+ * @return      : 0.01 %
+ */
+static uint32_t can_stats_load(uint32_t units, uint32_t ticks)
+{
+    return (uint32_t)(((uint64_t)units * 10000U * configTICK_RATE_HZ) /
+                      ((uint64_t)CAN_STATS_BIT_SCALE * CAN_LLD_BITRATE * ticks));
+}
+
+static void can_stats_max(uint32_t *value, uint32_t sample)
+{
+    uint32_t cur = __atomic_load_n(value, __ATOMIC_RELAXED);
+
+    while ((sample > cur) &&
+           !__atomic_compare_exchange_n(value, &cur, sample, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+    }
+}
+
+/* little endian, saturated at 0xFFFF */
+static uint8_t *can_stats_put16(uint8_t *p, uint32_t value)
+{
+    if (value > 0xFFFFU)
+    {
+        value = 0xFFFFU;
+    }
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    return &p[2];
+}
+
+static uint8_t *can_stats_put32(uint8_t *p, uint32_t value)
+{
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+    return &p[4];
+}
+
+/* @brief: Frame a payload already written at p + 4
+ * @param p    : start of the packet
+ * @param type : CAN_STATS_PACKET_SUMMARY or CAN_STATS_PACKET_ID
+ * @param len  : payload length
+ * @return     : packet length
+ */
+static uint32_t can_stats_packet(uint8_t *p, uint8_t type, uint32_t len)
+{
+    p[0] = 'C';
+    p[1] = 'S';
+    p[2] = type;
+    p[3] = (uint8_t)len;
+    (void)can_stats_put16(&p[4U + len], can_stats_crc16(&p[2], len + 2U));
+    return len + CAN_STATS_PACKET_OVERHEAD;
+}
+
+/* CRC-16/CCITT-FALSE, polynomial 0x1021, initial value 0xFFFF */
+static uint16_t can_stats_crc16(const uint8_t *data, uint32_t len)
+{
+    uint16_t crc = 0xFFFFU;
+    uint32_t i;
+    uint32_t bit;
+
+    for (i = 0U; i < len; i++)
+    {
+        crc ^= (uint16_t)((uint16_t)data[i] << 8);
+        for (bit = 0U; bit < 8U; bit++)
+        {
+            crc = ((crc & 0x8000U) != 0U) ? (uint16_t)((crc << 1) ^ 0x1021U) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
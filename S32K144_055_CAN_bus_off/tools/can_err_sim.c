@@ -0,0 +1,753 @@
+/* Host model of FlexCAN fault confinement around can_lld.c, can_err.c and
+ * can_stats.c. The three are built as they are into this file, so the model
+ * sees the RX task wake up flag and the quarantine of the TX mailboxes.
+ *
+ * The model steps 10 us at a time. A frame in a TX mailbox takes 250 us on
+ * the bus and takes TEC and REC down by one; while the bus is disturbed it
+ * fails with a bit error, an error frame and its retry (50 us) and TEC goes
+ * up by 8. Above 255 the node goes bus off. With CTRL1[BOFFREC] released it
+ * comes back after 128 x 11 recessive bits, which a stuck dominant bus never
+ * gives. The error and bus off interrupts call the error callback and clear
+ * their flags afterwards like the SDK, can_lld_step() runs every 100 ms,
+ * freertos_task_can_rx runs can_err_step() when woken or when its timeout
+ * ends. The application queues a frame every 1 ms.
+ *
+ *   1  5 ms of a stuck dominant bus: one bus off, released after the fast
+ *      delay, the recovery time of can_err matches the model
+ *   2  every frame of the node fails for 4 s on an idle bus: 5 fast
+ *      recoveries, then slow ones, stale frames dropped, a new fault is
+ *      fast again
+ *   3  warning and error passive from the interrupt, active again from the
+ *      poll, which is the only one to see it
+ *   4  BOFFINT read by the poll before the interrupt ran is counted once
+ *   5  a mode switch during bus off ends it
+ *   6  no mailbox is loaded during any bus off
+ *
+ * Exit status 1 on a failed check.
+ *
+ * build: gcc -O2 -Wall -Wno-pointer-to-int-cast -I.. -I../../S32K144_054_CAN_statistics
+ *            -I../../S32K144_051_ISO_TP -I../../S32K144_050_CAN_filter_compiler
+ *            -I../../S32K144_057_CAN_socketcan/host
+ *            -o can_err_sim can_err_sim.c
+ * usage: can_err_sim
+ *        (can_lld_step() prints the error state between the lines)
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "can_lld.c"
+#include "can_err.c"
+#include "can_stats.c"
+
+#define SIM_STEP_US 10U
+#define SIM_FRAME_US 250U
+/* bit error, error frame and the retry */
+#define SIM_ERROR_FRAME_US 50U
+/* recessive bits FlexCAN waits for after BOFFREC is released, and the time
+ * it needs at least from the release */
+#define SIM_RECOVERY_BITS (128U * 11U)
+#define SIM_RECOVERY_MIN_US 22U
+#define SIM_STEP_BITS (SIM_STEP_US / 2U)
+#define SIM_APP_PERIOD_US 1000U
+#define SIM_POLL_US 100000U
+#define SIM_TICK_US (1000000U / configTICK_RATE_HZ)
+#define SIM_EVENT_MAX 256U
+/* ESR1 flags the SDK error and bus off handlers clear */
+#define SIM_ESR1_INT_MASK (CAN_ESR1_ERRINT_MASK | CAN_ESR1_BOFFINT_MASK | CAN_ESR1_RWRNINT_MASK | \
+                           CAN_ESR1_TWRNINT_MASK | CAN_ESR1_BOFFDONEINT_MASK | CAN_ESR1_ERRINT_FAST_MASK | \
+                           CAN_ESR1_ERROVR_MASK)
+/* delays of can_err, with one tick of rounding */
+#define SIM_FAST_US (CAN_ERR_BUS_OFF_FAST_MS * 1000U)
+#define SIM_SLOW_US (CAN_ERR_BUS_OFF_SLOW_MS * 1000U)
+
+typedef struct
+{
+    bool busy;
+    uint32_t id;
+} sim_mb_t;
+
+static uint32_t test_error = 0U;
+static uint32_t test_check_num = 0U;
+
+#define TEST_CHECK(cond, ...) do { test_check_num++; if (!(cond)) { printf("FAIL: " __VA_ARGS__); printf("\n"); test_error++; } } while (0)
+
+/* SDK and FreeRTOS, as far as can_lld.c uses them */
+
+flexcan_state_t canCom1_State;
+const flexcan_user_config_t canCom1_InitConfig0 =
+{
+    .max_num_mb = 16U,
+    .is_rx_fifo_needed = true
+};
+lpspi_state_t lpspiCom1State;
+const lpspi_master_config_t lpspiCom1_MasterConfig0;
+const sbc_int_config_t sbc_uja116x1_InitConfig0;
+static CAN_Type sim_can0;
+static flexcan_callback_t sim_callback;
+static flexcan_error_callback_t sim_error_callback;
+
+/* fault confinement */
+static uint32_t sim_tec;
+static uint32_t sim_rec;
+static uint32_t sim_flags;                  /* ESR1 interrupt flags */
+static uint32_t sim_error_bits;             /* ESR1 error bits, cleared by a read */
+static bool sim_bus_off;
+static uint32_t sim_recessive_bits;         /* seen in bus off */
+static uint64_t sim_release_us;
+
+static sim_mb_t sim_mb[32];
+static int32_t sim_wire_mb = -1;
+static uint32_t sim_sent;
+static uint64_t sim_bus_free_us;
+static uint32_t sim_mb_loaded_bus_off;
+
+/* the disturbance, every frame fails */
+static uint64_t sim_disturb_from;
+static uint64_t sim_disturb_to;
+static bool sim_disturb_stuck = true;       /* stuck dominant, else only our frames fail */
+
+static uint64_t sim_now;                    /* us */
+static uint64_t sim_task_next = UINT64_MAX;
+static uint64_t sim_bus_off_at[SIM_EVENT_MAX];
+static uint64_t sim_release_at[SIM_EVENT_MAX];
+static uint64_t sim_done_at[SIM_EVENT_MAX];
+static uint32_t sim_bus_off_num;
+static uint32_t sim_release_num;
+static uint32_t sim_done_num;
+static uint32_t sim_app_busy;
+
+CAN_Type *flexcan_host_regs(void)
+{
+    return &sim_can0;
+}
+
+status_t LPSPI_DRV_MasterInit(uint32_t instance, lpspi_state_t *lpspiState, const lpspi_master_config_t *spiConfig)
+{
+    (void)instance;
+    (void)lpspiState;
+    (void)spiConfig;
+    return STATUS_SUCCESS;
+}
+
+status_t SBC_Init(const sbc_int_config_t *const config, const uint32_t lpspiInstance)
+{
+    (void)config;
+    (void)lpspiInstance;
+    return STATUS_SUCCESS;
+}
+
+void INT_SYS_SetPriority(IRQn_Type irqNumber, uint8_t priority)
+{
+    (void)irqNumber;
+    (void)priority;
+}
+
+void vPortEnterCritical(void)
+{
+}
+
+void vPortExitCritical(void)
+{
+}
+
+void FLEXCAN_DRV_GetDefaultConfig(flexcan_user_config_t *config)
+{
+    memset(config, 0, sizeof(*config));
+}
+
+/* a soft reset, error active */
+status_t FLEXCAN_DRV_Init(uint8_t instance, flexcan_state_t *state, const flexcan_user_config_t *data)
+{
+    (void)instance;
+    (void)state;
+    (void)data;
+    sim_tec = 0U;
+    sim_rec = 0U;
+    sim_bus_off = false;
+    sim_flags = 0U;
+    sim_error_bits = 0U;
+    sim_can0.CTRL1 = 0U;
+    sim_can0.CTRL2 = 0U;
+    return STATUS_SUCCESS;
+}
+
+status_t FLEXCAN_DRV_Deinit(uint8_t instance)
+{
+    (void)instance;
+    return STATUS_SUCCESS;
+}
+
+void FLEXCAN_DRV_SetTDCOffset(uint8_t instance, bool enable, uint8_t offset)
+{
+    (void)instance;
+    (void)enable;
+    (void)offset;
+}
+
+void FLEXCAN_DRV_ConfigRxFifo(uint8_t instance, flexcan_rx_fifo_id_element_format_t id_format,
+                              const flexcan_id_table_t *id_filter_table)
+{
+    (void)instance;
+    (void)id_format;
+    (void)id_filter_table;
+}
+
+void FLEXCAN_DRV_SetRxFifoGlobalMask(uint8_t instance, flexcan_msgbuff_id_type_t id_type, uint32_t mask)
+{
+    (void)instance;
+    (void)id_type;
+    (void)mask;
+}
+
+void FLEXCAN_DRV_InstallEventCallback(uint8_t instance, flexcan_callback_t callback, void *callbackParam)
+{
+    (void)instance;
+    (void)callbackParam;
+    sim_callback = callback;
+}
+
+void FLEXCAN_DRV_InstallErrorCallback(uint8_t instance, flexcan_error_callback_t callback, void *callbackParam)
+{
+    (void)instance;
+    (void)callbackParam;
+    sim_error_callback = callback;
+}
+
+status_t FLEXCAN_DRV_RxFifo(uint8_t instance, flexcan_msgbuff_t *data)
+{
+    (void)instance;
+    (void)data;
+    return STATUS_SUCCESS;
+}
+
+static uint32_t sim_esr1(void)
+{
+    uint32_t esr1 = sim_flags | sim_error_bits;
+
+    if (sim_bus_off)
+    {
+        esr1 |= 2UL << CAN_ESR1_FLTCONF_SHIFT;
+    }
+    else if ((sim_tec > 127U) || (sim_rec > 127U))
+    {
+        esr1 |= 1UL << CAN_ESR1_FLTCONF_SHIFT;
+    }
+    esr1 |= (sim_rec >= 96U) ? CAN_ESR1_RXWRN_MASK : 0U;
+    esr1 |= (sim_tec >= 96U) ? CAN_ESR1_TXWRN_MASK : 0U;
+    return esr1;
+}
+
+uint32_t FLEXCAN_DRV_GetErrorStatus(uint8_t instance)
+{
+    const uint32_t esr1 = sim_esr1();
+
+    (void)instance;
+    sim_error_bits = 0U;
+    return esr1;
+}
+
+void FLEXCAN_ClearErrIntStatusFlag(CAN_Type *base)
+{
+    (void)base;
+}
+
+void FLEXCAN_EnterFreezeMode(CAN_Type *base)
+{
+    (void)base;
+}
+
+void FLEXCAN_ExitFreezeMode(CAN_Type *base)
+{
+    (void)base;
+}
+
+void FLEXCAN_DRV_SetRxMaskType(uint8_t instance, flexcan_rx_mask_type_t type)
+{
+    (void)instance;
+    (void)type;
+}
+
+status_t FLEXCAN_DRV_ConfigRxMb(uint8_t instance, uint8_t mb_idx, const flexcan_data_info_t *rx_info, uint32_t msg_id)
+{
+    (void)instance;
+    (void)mb_idx;
+    (void)rx_info;
+    (void)msg_id;
+    return STATUS_SUCCESS;
+}
+
+status_t FLEXCAN_DRV_SetRxIndividualMask(uint8_t instance, flexcan_msgbuff_id_type_t id_type, uint8_t mb_idx,
+                                         uint32_t mask)
+{
+    (void)instance;
+    (void)id_type;
+    (void)mb_idx;
+    (void)mask;
+    return STATUS_SUCCESS;
+}
+
+status_t FLEXCAN_DRV_Receive(uint8_t instance, uint8_t mb_idx, flexcan_msgbuff_t *data)
+{
+    (void)instance;
+    (void)mb_idx;
+    (void)data;
+    return STATUS_SUCCESS;
+}
+
+status_t FLEXCAN_DRV_ConfigTxMb(uint8_t instance, uint8_t mb_idx, const flexcan_data_info_t *tx_info, uint32_t msg_id)
+{
+    (void)instance;
+    (void)mb_idx;
+    (void)tx_info;
+    (void)msg_id;
+    return STATUS_SUCCESS;
+}
+
+/* FlexCAN takes a frame in bus off too, it just never wins */
+status_t FLEXCAN_DRV_Send(uint8_t instance, uint8_t mb_idx, const flexcan_data_info_t *tx_info, uint32_t msg_id,
+                          const uint8_t *mb_data)
+{
+    (void)instance;
+    (void)tx_info;
+    (void)mb_data;
+    sim_mb[mb_idx].busy = true;
+    sim_mb[mb_idx].id = msg_id;
+    return STATUS_SUCCESS;
+}
+
+/* frames end within one step, only the completion callback sees the wire */
+status_t FLEXCAN_DRV_AbortTransfer(uint8_t instance, uint8_t mb_idx)
+{
+    (void)instance;
+    if ((int32_t)mb_idx == sim_wire_mb)
+    {
+        return STATUS_CAN_NO_TRANSFER_IN_PROGRESS;
+    }
+    sim_mb[mb_idx].busy = false;
+    return STATUS_SUCCESS;
+}
+
+TickType_t xTaskGetTickCountFromISR(void)
+{
+    return (TickType_t)(sim_now / SIM_TICK_US);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(sim_now / SIM_TICK_US);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return (TaskHandle_t)1;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    (void)xTaskToNotify;
+    (void)pxHigherPriorityTaskWoken;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify)
+{
+    (void)xTaskToNotify;
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait)
+{
+    (void)xClearCountOnExit;
+    (void)xTicksToWait;
+    return 0U;
+}
+
+/* ISO-TP and the RX DMA are not part of this model */
+void isotp_init(void)
+{
+}
+
+void isotp_channel_open(uint8_t channel, const isotp_channel_config_t *config)
+{
+    (void)channel;
+    (void)config;
+}
+
+bool isotp_rx_frame(const can_lld_rx_frame_t *frame)
+{
+    (void)frame;
+    return false;
+}
+
+status_t isotp_send(uint8_t channel, const uint8_t *data, uint32_t len)
+{
+    (void)channel;
+    (void)data;
+    (void)len;
+    return STATUS_SUCCESS;
+}
+
+TickType_t isotp_step(void)
+{
+    return portMAX_DELAY;
+}
+
+status_t EDMA_DRV_ConfigLoopTransfer(uint8_t channel, const edma_transfer_config_t *transferConfig)
+{
+    (void)channel;
+    (void)transferConfig;
+    return STATUS_SUCCESS;
+}
+
+void EDMA_DRV_DisableRequestsOnTransferComplete(uint8_t channel, bool disable)
+{
+    (void)channel;
+    (void)disable;
+}
+
+void EDMA_DRV_ConfigureInterrupt(uint8_t channel, edma_channel_interrupt_t intSrc, bool enable)
+{
+    (void)channel;
+    (void)intSrc;
+    (void)enable;
+}
+
+status_t EDMA_DRV_InstallCallback(uint8_t channel, edma_callback_t callback, void *parameter)
+{
+    (void)channel;
+    (void)callback;
+    (void)parameter;
+    return STATUS_SUCCESS;
+}
+
+status_t EDMA_DRV_StartChannel(uint8_t channel)
+{
+    (void)channel;
+    return STATUS_SUCCESS;
+}
+
+status_t EDMA_DRV_StopChannel(uint8_t channel)
+{
+    (void)channel;
+    return STATUS_SUCCESS;
+}
+
+uint32_t EDMA_DRV_GetRemainingMajorIterationsCount(uint8_t channel)
+{
+    (void)channel;
+    return CAN_LLD_RX_DMA_SLOTS;
+}
+
+/* the model */
+
+/* the SDK error and bus off handlers: the callback, then W1C of the flags */
+static void sim_error_irq(void)
+{
+    if ((sim_flags & SIM_ESR1_INT_MASK) == 0U)
+    {
+        return;
+    }
+    sim_error_callback(INST_CANCOM1, FLEXCAN_EVENT_ERROR, &canCom1_State);
+    sim_flags &= ~SIM_ESR1_INT_MASK;
+}
+
+/* can_lld_step() writes the flags it read to ESR1 to clear them */
+static void sim_poll(void)
+{
+    sim_can0.ESR1 = 0U;
+    can_lld_step();
+    sim_flags &= ~sim_can0.ESR1;
+}
+
+static bool sim_disturbed(void)
+{
+    return (sim_now >= sim_disturb_from) && (sim_now < sim_disturb_to);
+}
+
+static void sim_enter_bus_off(void)
+{
+    sim_bus_off = true;
+    sim_recessive_bits = 0U;
+    sim_release_us = 0U;
+    sim_flags |= CAN_ESR1_BOFFINT_MASK;
+    sim_bus_off_at[sim_bus_off_num++ % SIM_EVENT_MAX] = sim_now;
+}
+
+/* @brief: One step of the bus and of fault confinement
+ * @return: None
+ */
+static void sim_bus(void)
+{
+    const bool recessive = !sim_disturbed() || !sim_disturb_stuck;
+    int32_t best = -1;
+    uint32_t i;
+
+    if (sim_bus_off)
+    {
+        for (i = 0U; i < 32U; i++)
+        {
+            sim_mb_loaded_bus_off += sim_mb[i].busy ? 1U : 0U;
+        }
+        sim_recessive_bits += recessive ? SIM_STEP_BITS : 0U;
+        if ((sim_can0.CTRL1 & CAN_CTRL1_BOFFREC_MASK) != 0U)
+        {
+            return;
+        }
+        if (sim_release_us == 0U)
+        {
+            sim_release_us = sim_now;
+            sim_release_at[sim_release_num++ % SIM_EVENT_MAX] = sim_now;
+        }
+        if ((sim_recessive_bits >= SIM_RECOVERY_BITS) && (sim_now >= sim_release_us + SIM_RECOVERY_MIN_US) && recessive)
+        {
+            sim_bus_off = false;
+            sim_tec = 0U;
+            sim_rec = 0U;
+            sim_flags |= CAN_ESR1_BOFFDONEINT_MASK;
+            sim_done_at[sim_done_num++ % SIM_EVENT_MAX] = sim_now;
+            sim_error_irq();
+        }
+        return;
+    }
+
+    if (sim_now < sim_bus_free_us)
+    {
+        return;
+    }
+    for (i = 0U; i < 32U; i++)
+    {
+        if (sim_mb[i].busy && ((best < 0) || (sim_mb[i].id < sim_mb[best].id)))
+        {
+            best = (int32_t)i;
+        }
+    }
+    if (best < 0)
+    {
+        return;
+    }
+    if (sim_disturbed())
+    {
+        sim_bus_free_us = sim_now + SIM_ERROR_FRAME_US;
+        sim_error_bits |= CAN_ESR1_BIT0ERR_MASK;
+        sim_flags |= CAN_ESR1_ERRINT_MASK;
+        sim_tec += 8U;
+        if (sim_tec > 255U)
+        {
+            sim_enter_bus_off();
+        }
+        sim_error_irq();
+        return;
+    }
+    sim_bus_free_us = sim_now + SIM_FRAME_US;
+    sim_tec -= (sim_tec > 0U) ? 1U : 0U;
+    sim_rec -= (sim_rec > 0U) ? 1U : 0U;
+    sim_mb[best].busy = false;
+    sim_sent++;
+    sim_wire_mb = best;
+    sim_callback(INST_CANCOM1, FLEXCAN_EVENT_TX_COMPLETE, (uint32_t)best, &canCom1_State);
+    sim_wire_mb = -1;
+}
+
+/* freertos_task_can_rx: woken by can_lld_rx_wake_from_isr() or its timeout */
+static void sim_task(void)
+{
+    TickType_t wait;
+
+    if ((__atomic_exchange_n(&can_lld_rx_wake_flag, 0U, __ATOMIC_SEQ_CST) == 0U) && (sim_now < sim_task_next))
+    {
+        return;
+    }
+    wait = can_err_step();
+    sim_task_next = (wait == portMAX_DELAY) ? UINT64_MAX : (((sim_now / SIM_TICK_US) + wait) * SIM_TICK_US);
+}
+
+static void sim_run(uint64_t until)
+{
+    const uint8_t data[8] = {0U};
+
+    for (; sim_now < until; sim_now += SIM_STEP_US)
+    {
+        if ((sim_now % SIM_APP_PERIOD_US) == 0U)
+        {
+            sim_app_busy += (can_lld_tx(0x100U, data, 8U) != STATUS_SUCCESS) ? 1U : 0U;
+        }
+        if ((sim_now % SIM_POLL_US) == 0U)
+        {
+            sim_poll();
+        }
+        sim_bus();
+        sim_task();
+    }
+}
+
+static void sim_events_clear(void)
+{
+    sim_bus_off_num = 0U;
+    sim_release_num = 0U;
+    sim_done_num = 0U;
+}
+
+/* 1: 5 ms of a stuck dominant bus at 100 ms */
+static void test_short(void)
+{
+    uint32_t ticks;
+
+    sim_disturb_from = 100000U;
+    sim_disturb_to = 105000U;
+    sim_run(300000U);
+    printf("1. short disturbance: %u bus offs, %u releases, %u recoveries, row %u\n", sim_bus_off_num,
+           sim_release_num, can_err_recovery_num, can_err_bus_off_run);
+    TEST_CHECK((sim_bus_off_num == 1U) && (sim_done_num == 1U) && (can_err_recovery_num == 1U),
+               "%u bus offs, %u recoveries", sim_bus_off_num, can_err_recovery_num);
+    if (sim_done_num != 1U)
+    {
+        return;
+    }
+    printf("   bus off at %.3f ms, released %.3f ms later, back on the bus %.3f ms later, can_err says %.1f ms\n",
+           sim_bus_off_at[0] / 1000.0, (sim_release_at[0] - sim_bus_off_at[0]) / 1000.0,
+           (sim_done_at[0] - sim_bus_off_at[0]) / 1000.0, can_err_recovery_last / 10.0);
+    ticks = (uint32_t)((sim_done_at[0] - sim_bus_off_at[0]) / SIM_TICK_US);
+    TEST_CHECK((can_err_recovery_last + 1U >= ticks) && (can_err_recovery_last <= ticks + 1U),
+               "recovery of %u ticks, model %u", can_err_recovery_last, ticks);
+    TEST_CHECK(((sim_release_at[0] - sim_bus_off_at[0]) + SIM_TICK_US >= SIM_FAST_US) &&
+               ((sim_release_at[0] - sim_bus_off_at[0]) <= SIM_FAST_US + SIM_TICK_US),
+               "released after %llu us", (unsigned long long)(sim_release_at[0] - sim_bus_off_at[0]));
+    TEST_CHECK(can_err_state == CAN_ERR_STATE_ACTIVE, "state %s", can_err_state_name(can_err_state));
+    TEST_CHECK(can_err_bus_off_run == 0U, "a sent frame did not end the row");
+    TEST_CHECK(can_stats_error_num[CAN_STATS_ERROR_BUS_OFF] == 1U, "can_stats counted %u bus offs",
+               can_stats_error_num[CAN_STATS_ERROR_BUS_OFF]);
+    printf("   %u stale frames dropped, TX queue full %u times, %u frames sent\n", can_lld_tx_stale_num, sim_app_busy,
+           sim_sent);
+}
+
+/* 2: the frames of the node fail for 4 s, the bus idles recessive */
+static void test_long(void)
+{
+    uint64_t delay;
+    uint32_t i;
+
+    sim_events_clear();
+    sim_disturb_stuck = false;
+    sim_disturb_from = 400000U;
+    sim_disturb_to = 4400000U;
+    sim_run(6000000U);
+    printf("2. every frame fails for 4 s: %u bus offs, %u releases\n   delay from bus off to release, ms:",
+           sim_bus_off_num, sim_release_num);
+    for (i = 0U; (i < sim_release_num) && (i < SIM_EVENT_MAX); i++)
+    {
+        delay = sim_release_at[i] - sim_bus_off_at[i];
+        printf(" %.1f", delay / 1000.0);
+        if (i < CAN_ERR_BUS_OFF_FAST_NUM)
+        {
+            TEST_CHECK((delay + SIM_TICK_US >= SIM_FAST_US) && (delay <= SIM_FAST_US + SIM_TICK_US),
+                       "bus off %u released after %llu us", i, (unsigned long long)delay);
+        }
+        else
+        {
+            TEST_CHECK((delay + SIM_TICK_US >= SIM_SLOW_US) && (delay <= SIM_SLOW_US + SIM_TICK_US),
+                       "bus off %u released after %llu us", i, (unsigned long long)delay);
+        }
+    }
+    printf("\n   %u recoveries, last %.1f ms, max %.1f ms, state %s, %u stale frames dropped, TX queue full %u times\n",
+           can_err_recovery_num, can_err_recovery_last / 10.0, can_err_recovery_max / 10.0,
+           can_err_state_name(can_err_state), can_lld_tx_stale_num, sim_app_busy);
+    TEST_CHECK(sim_release_num > CAN_ERR_BUS_OFF_FAST_NUM, "only %u bus offs", sim_release_num);
+    TEST_CHECK((can_err_state == CAN_ERR_STATE_ACTIVE) && (can_err_bus_off_run == 0U), "not back, state %s row %u",
+               can_err_state_name(can_err_state), can_err_bus_off_run);
+    TEST_CHECK(can_lld_tx_stale_num != 0U, "no stale frame dropped");
+
+    /* a new fault is fast again */
+    sim_events_clear();
+    sim_disturb_from = 6500000U;
+    sim_disturb_to = 6502000U;
+    sim_run(6800000U);
+    sim_disturb_stuck = true;
+    delay = sim_release_at[0] - sim_bus_off_at[0];
+    printf("   next fault: released after %.1f ms\n", delay / 1000.0);
+    TEST_CHECK((sim_release_num == 1U) && (delay <= SIM_FAST_US + SIM_TICK_US), "row not ended, %u releases",
+               sim_release_num);
+}
+
+/* 3: warning and error passive from the interrupt, active from the poll */
+static void test_passive(void)
+{
+    const uint32_t warning = can_err_state_num[CAN_ERR_STATE_WARNING];
+    const uint32_t passive = can_err_state_num[CAN_ERR_STATE_PASSIVE];
+    const uint32_t active = can_err_state_num[CAN_ERR_STATE_ACTIVE];
+
+    sim_rec = 100U;
+    sim_error_bits |= CAN_ESR1_CRCERR_MASK;
+    sim_flags |= CAN_ESR1_ERRINT_MASK;
+    sim_error_irq();
+    TEST_CHECK(can_err_state == CAN_ERR_STATE_WARNING, "REC 100: %s", can_err_state_name(can_err_state));
+    sim_rec = 130U;
+    sim_error_bits |= CAN_ESR1_CRCERR_MASK;
+    sim_flags |= CAN_ESR1_ERRINT_MASK;
+    sim_error_irq();
+    TEST_CHECK(can_err_state == CAN_ERR_STATE_PASSIVE, "REC 130: %s", can_err_state_name(can_err_state));
+    /* the sent frames take REC down, only the poll sees it */
+    sim_run(7000000U);
+    printf("3. warning %u, passive %u, active %u times, now %s, REC %u\n",
+           can_err_state_num[CAN_ERR_STATE_WARNING] - warning, can_err_state_num[CAN_ERR_STATE_PASSIVE] - passive,
+           can_err_state_num[CAN_ERR_STATE_ACTIVE] - active, can_err_state_name(can_err_state), sim_rec);
+    TEST_CHECK(can_err_state == CAN_ERR_STATE_ACTIVE, "not back to active, %s", can_err_state_name(can_err_state));
+}
+
+/* 4: the poll reads BOFFINT before the interrupt runs */
+static void test_poll_first(void)
+{
+    const uint32_t counted = can_stats_error_num[CAN_STATS_ERROR_BUS_OFF];
+    const uint32_t entered = can_err_state_num[CAN_ERR_STATE_BUS_OFF];
+
+    sim_events_clear();
+    sim_tec = 256U;
+    sim_enter_bus_off();
+    sim_poll();
+    sim_error_irq();
+    printf("4. bus off seen by the poll first: counted %u, entered %u times\n",
+           can_stats_error_num[CAN_STATS_ERROR_BUS_OFF] - counted, can_err_state_num[CAN_ERR_STATE_BUS_OFF] - entered);
+    TEST_CHECK((can_stats_error_num[CAN_STATS_ERROR_BUS_OFF] - counted) == 1U, "bus off counted %u times",
+               can_stats_error_num[CAN_STATS_ERROR_BUS_OFF] - counted);
+    TEST_CHECK((can_err_state_num[CAN_ERR_STATE_BUS_OFF] - entered) == 1U, "bus off entered %u times",
+               can_err_state_num[CAN_ERR_STATE_BUS_OFF] - entered);
+    sim_run(7100000U);
+    TEST_CHECK(can_err_state == CAN_ERR_STATE_ACTIVE, "not back to active, %s", can_err_state_name(can_err_state));
+}
+
+/* 5: a mode switch during bus off ends it */
+static void test_mode_switch(void)
+{
+    const uint32_t recoveries = can_err_recovery_num;
+
+    sim_disturb_from = sim_now;
+    sim_disturb_to = sim_now + 100000U;
+    sim_run(sim_now + 5000U);
+    TEST_CHECK(can_err_state == CAN_ERR_STATE_BUS_OFF, "no bus off, %s", can_err_state_name(can_err_state));
+    (void)can_lld_set_mode(CAN_LLD_MODE_FD);
+    printf("5. mode switch in bus off: state %s, %u more recoveries, quarantined %s\n",
+           can_err_state_name(can_err_state), can_err_recovery_num - recoveries,
+           can_lld_tx_quarantined ? "yes" : "no");
+    TEST_CHECK(can_err_state == CAN_ERR_STATE_ACTIVE, "state %s after the switch", can_err_state_name(can_err_state));
+    TEST_CHECK(!can_lld_tx_quarantined, "still quarantined after the switch");
+    TEST_CHECK((sim_can0.CTRL1 & CAN_CTRL1_BOFFREC_MASK) != 0U, "automatic recovery on after the switch");
+    sim_disturb_to = 0U;
+}
+
+int main(void)
+{
+    can_lld_rx_dma_enable = false;
+    can_lld_init();
+    can_lld_rx_waiter = (TaskHandle_t)1;
+    TEST_CHECK((sim_can0.CTRL1 & CAN_CTRL1_BOFFREC_MASK) != 0U, "CTRL1[BOFFREC] not set after the start");
+    TEST_CHECK((sim_can0.CTRL2 & CAN_CTRL2_BOFFDONEMSK_MASK) != 0U, "CTRL2[BOFFDONEMSK] not set after the start");
+
+    test_short();
+    test_long();
+    test_passive();
+    test_poll_first();
+    test_mode_switch();
+    /* 6 */
+    printf("6. mailbox loads seen during bus off: %u\n", sim_mb_loaded_bus_off);
+    TEST_CHECK(sim_mb_loaded_bus_off == 0U, "%u mailbox loads during bus off", sim_mb_loaded_bus_off);
+
+    printf("%s, %u checks, %u errors\n", (test_error == 0U) ? "PASS" : "FAIL", test_check_num, test_error);
+    return (test_error == 0U) ? 0 : 1;
+}
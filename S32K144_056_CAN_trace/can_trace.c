@@ -0,0 +1,348 @@
+#include "can_trace.h"
+#include "string.h"
+
+/* the recorder runs from the CAN interrupts or with them masked, the task
+ * API masks them itself. can_trace_dump() only reads a stopped ring, which
+ * nothing writes */
+volatile can_trace_state_t can_trace_state = CAN_TRACE_STATE_IDLE;
+uint32_t can_trace_record_num;
+uint32_t can_trace_overwritten_num;
+uint32_t can_trace_trigger_num;
+
+#define CAN_TRACE_BUF_MASK (CAN_TRACE_BUF_SIZE - 1U)
+#define CAN_TRACE_SYNC_TICKS pdMS_TO_TICKS(CAN_TRACE_SYNC_MS)
+
+/* ESR1 bits worth a record: the error bits of both phases and the interrupt
+ * flags. FLTCONF and the status bits alone are not an event */
+#define CAN_TRACE_ESR1_EVENT_MASK 0xDC3BFC06U
+
+/* the ring, word aligned for the record headers. head and tail are free
+ * running byte positions, head - tail bytes hold records */
+static uint32_t can_trace_buf[CAN_TRACE_BUF_SIZE / 4U];
+static uint32_t can_trace_head = 0U;
+static uint32_t can_trace_tail = 0U;
+/* records in the ring, PAD records not counted */
+static uint32_t can_trace_count = 0U;
+static can_trace_config_t can_trace_config;
+/* bytes still recorded after the trigger */
+static int32_t can_trace_post_left = 0;
+static TickType_t can_trace_sync_tick = 0U;
+/* dump position, the header goes first */
+static uint32_t can_trace_dump_pos = 0U;
+static bool can_trace_dump_started = false;
+
+static can_trace_record_t *can_trace_put(uint8_t type, uint32_t id, uint32_t stamp, uint32_t len, TickType_t tick);
+static uint32_t can_trace_size_at(uint32_t pos);
+static void can_trace_fire(can_trace_record_t *record);
+
+/* @brief: Start a new trace, the ring is emptied. Must not be called from an
+ *         ISR
+ * @param config : trigger and post trigger window, NULL for the defaults of
+ *                 can_trace.h. The window is cut to keep the trigger record
+ * @return       : None
+ */
+void can_trace_arm(const can_trace_config_t *config)
+{
+    taskENTER_CRITICAL();
+    if (config != NULL)
+    {
+        can_trace_config = *config;
+    }
+    else
+    {
+        can_trace_config.id_enable = (CAN_TRACE_TRIGGER_ID_ENABLE != 0);
+        can_trace_config.id = CAN_TRACE_TRIGGER_ID;
+        can_trace_config.id_mask = CAN_TRACE_TRIGGER_ID_MASK;
+        can_trace_config.error_mask = CAN_TRACE_TRIGGER_ERROR_MASK;
+        can_trace_config.post_size = (CAN_TRACE_BUF_SIZE / 100U) * CAN_TRACE_POST_PERCENT;
+    }
+    /* the record ending the window, its padding and a sync before it run
+     * over the window, the trigger record must stay in the ring */
+    if (can_trace_config.post_size > (CAN_TRACE_BUF_SIZE - (4U * CAN_TRACE_RECORD_MAX)))
+    {
+        can_trace_config.post_size = CAN_TRACE_BUF_SIZE - (4U * CAN_TRACE_RECORD_MAX);
+    }
+
+    can_trace_head = 0U;
+    can_trace_tail = 0U;
+    can_trace_count = 0U;
+    can_trace_record_num = 0U;
+    can_trace_overwritten_num = 0U;
+    can_trace_dump_started = false;
+    can_trace_state = CAN_TRACE_STATE_ARMED;
+    can_trace_sync(false, xTaskGetTickCount());
+    taskEXIT_CRITICAL();
+}
+
+/* @brief: Fire the trigger by hand, marked by a sync record. Must not be
+ *         called from an ISR
+ * @return: None
+ */
+void can_trace_trigger(void)
+{
+    can_trace_record_t *record;
+
+    taskENTER_CRITICAL();
+    if (can_trace_state == CAN_TRACE_STATE_ARMED)
+    {
+        record = can_trace_put(CAN_TRACE_TYPE_SYNC, 0U, CAN0->TIMER, 0U, xTaskGetTickCount());
+        can_trace_fire(record);
+    }
+    taskEXIT_CRITICAL();
+}
+
+/* @brief: Record a frame received or sent. Called from the CAN interrupts or
+ *         with them masked
+ * @param type  : CAN_TRACE_TYPE_RX or CAN_TRACE_TYPE_TX
+ * @param msgId : ID of the frame, CAN_LLD_TX_ID_EXT is ignored
+ * @param cs    : CS word of the mailbox, IDE, EDL, BRS and the time stamp
+ *                are used
+ * @param data  : payload
+ * @param len   : payload length, CAN_LLD_PAYLOAD_MAX at most
+ * @param tick  : FreeRTOS tick of the frame
+ * @return      : None
+ */
+void can_trace_frame(uint8_t type, uint32_t msgId, uint32_t cs, const uint8_t *data, uint32_t len, TickType_t tick)
+{
+    can_trace_record_t *record;
+    uint32_t key;
+
+    if ((can_trace_state != CAN_TRACE_STATE_ARMED) && (can_trace_state != CAN_TRACE_STATE_TRIGGERED))
+    {
+        return;
+    }
+
+    if ((cs & CAN_LLD_CS_IDE_MASK) != 0U)
+    {
+        type |= CAN_TRACE_FLAG_EXT;
+        msgId &= 0x1FFFFFFFU;
+        key = msgId | CAN_LLD_TX_ID_EXT;
+    }
+    else
+    {
+        msgId &= 0x7FFU;
+        key = msgId;
+    }
+    if ((cs & CAN_LLD_CS_EDL_MASK) != 0U)
+    {
+        type |= CAN_TRACE_FLAG_FD;
+        if ((cs & CAN_LLD_CS_BRS_MASK) != 0U)
+        {
+            type |= CAN_TRACE_FLAG_BRS;
+        }
+    }
+    if (len > CAN_LLD_PAYLOAD_MAX)
+    {
+        len = CAN_LLD_PAYLOAD_MAX;
+    }
+
+    record = can_trace_put(type, msgId, cs, len, tick);
+    memcpy(&record[1], data, len);
+
+    if ((can_trace_state == CAN_TRACE_STATE_ARMED) && can_trace_config.id_enable &&
+        (((key ^ can_trace_config.id) & can_trace_config.id_mask) == 0U))
+    {
+        can_trace_fire(record);
+    }
+}
+
+/* @brief: Record an ESR1 read with an error or an interrupt flag in it.
+ *         Called from the CAN error interrupts or with them masked
+ * @param esr1 : ESR1 value
+ * @param tick : FreeRTOS tick of the read
+ * @return     : None
+ */
+void can_trace_error(uint32_t esr1, TickType_t tick)
+{
+    can_trace_record_t *record;
+
+    if (((can_trace_state != CAN_TRACE_STATE_ARMED) && (can_trace_state != CAN_TRACE_STATE_TRIGGERED)) ||
+        ((esr1 & CAN_TRACE_ESR1_EVENT_MASK) == 0U))
+    {
+        return;
+    }
+
+    record = can_trace_put(CAN_TRACE_TYPE_ERROR, esr1, CAN0->TIMER, 0U, tick);
+    if ((can_trace_state == CAN_TRACE_STATE_ARMED) && ((esr1 & can_trace_config.error_mask) != 0U))
+    {
+        can_trace_fire(record);
+    }
+}
+
+/* @brief: Record frames can_lld lost before they could be recorded. Called
+ *         from the CAN interrupts or with them masked
+ * @param num  : frames lost
+ * @param tick : FreeRTOS tick they were found lost
+ * @return     : None
+ */
+void can_trace_lost(uint32_t num, TickType_t tick)
+{
+    if ((can_trace_state == CAN_TRACE_STATE_ARMED) || (can_trace_state == CAN_TRACE_STATE_TRIGGERED))
+    {
+        (void)can_trace_put(CAN_TRACE_TYPE_LOST, num, CAN0->TIMER, 0U, tick);
+    }
+}
+
+/* @brief: Record the FlexCAN timer with the FreeRTOS tick. Called from the
+ *         CAN interrupts or with them masked
+ * @param restart : FlexCAN was just initialized, its timer starts again
+ * @param tick    : FreeRTOS tick now
+ * @return        : None
+ */
+void can_trace_sync(bool restart, TickType_t tick)
+{
+    if ((can_trace_state == CAN_TRACE_STATE_ARMED) || (can_trace_state == CAN_TRACE_STATE_TRIGGERED))
+    {
+        can_trace_sync_tick = tick;
+        (void)can_trace_put(CAN_TRACE_TYPE_SYNC | (restart ? CAN_TRACE_FLAG_RESTART : 0U), 0U, CAN0->TIMER, 0U, tick);
+    }
+}
+
+/* @brief: Write the next dump packet of a stopped trace, see can_trace.h.
+ *         Called by one task only
+ * @param buf : room for CAN_TRACE_PACKET_MAX bytes
+ * @return    : packet length, 0 when the whole trace was written or the
+ *              trace is not stopped
+ */
+uint32_t can_trace_dump(uint8_t *buf)
+{
+    const uint8_t *ring = (const uint8_t *)can_trace_buf;
+    const can_trace_record_t *record;
+    uint8_t *p = &buf[4];
+    uint32_t header[CAN_TRACE_HEADER_SIZE / 4U];
+    uint32_t len;
+
+    if (can_trace_state != CAN_TRACE_STATE_STOPPED)
+    {
+        return 0U;
+    }
+
+    if (!can_trace_dump_started)
+    {
+        can_trace_dump_started = true;
+        can_trace_dump_pos = can_trace_tail;
+        /* little endian like the records, which go out as they are */
+        header[0] = CAN_TRACE_PACKET_VERSION | (sizeof(can_trace_record_t) << 8) |
+                    ((CAN_TRACE_BUF_SIZE / 1024U) << 16);
+        header[1] = CAN_LLD_BITRATE;
+        header[2] = CAN_LLD_FD_DATA_BITRATE;
+        header[3] = configTICK_RATE_HZ;
+        header[4] = can_trace_count;
+        header[5] = can_trace_overwritten_num;
+        memcpy(p, header, CAN_TRACE_HEADER_SIZE);
+        return can_stats_packet(buf, CAN_TRACE_PACKET_HEADER, CAN_TRACE_HEADER_SIZE);
+    }
+
+    while ((can_trace_dump_pos != can_trace_head) &&
+           ((ring[can_trace_dump_pos & CAN_TRACE_BUF_MASK] & CAN_TRACE_TYPE_MASK) == CAN_TRACE_TYPE_PAD))
+    {
+        can_trace_dump_pos += can_trace_size_at(can_trace_dump_pos);
+    }
+    if (can_trace_dump_pos == can_trace_head)
+    {
+        return 0U;
+    }
+
+    record = (const can_trace_record_t *)&ring[can_trace_dump_pos & CAN_TRACE_BUF_MASK];
+    len = sizeof(can_trace_record_t) + record->len;
+    memcpy(p, record, len);
+    can_trace_dump_pos += can_trace_size_at(can_trace_dump_pos);
+    return can_stats_packet(buf, CAN_TRACE_PACKET_RECORD, len);
+}
+
+/* @brief: Make room for a record at the head and write its header. A record
+ *         which would cross the end of the ring starts at its beginning, the
+ *         rest is a PAD record. The oldest records are overwritten
+ * @param type  : CAN_TRACE_TYPE_x | CAN_TRACE_FLAG_x
+ * @param id    : id field
+ * @param stamp : FlexCAN time stamp, the low 16 bits are kept
+ * @param len   : data bytes the caller writes after the header
+ * @param tick  : FreeRTOS tick
+ * @return      : the record
+ */
+static can_trace_record_t *can_trace_put(uint8_t type, uint32_t id, uint32_t stamp, uint32_t len, TickType_t tick)
+{
+    uint8_t *ring = (uint8_t *)can_trace_buf;
+    can_trace_record_t *record;
+    uint32_t size = (sizeof(can_trace_record_t) + len + 3U) & ~3U;
+    uint32_t offset;
+    uint32_t pad;
+    uint32_t old;
+
+    /* a frame long after the last sync gets one first, frames of the DMA
+     * ring dated back before it do not */
+    if (((type & CAN_TRACE_TYPE_MASK) != CAN_TRACE_TYPE_SYNC) &&
+        ((int32_t)(tick - can_trace_sync_tick) >= (int32_t)CAN_TRACE_SYNC_TICKS))
+    {
+        can_trace_sync(false, xTaskGetTickCountFromISR());
+    }
+
+    offset = can_trace_head & CAN_TRACE_BUF_MASK;
+    pad = ((offset + size) > CAN_TRACE_BUF_SIZE) ? (CAN_TRACE_BUF_SIZE - offset) : 0U;
+    while (((can_trace_head + pad + size) - can_trace_tail) > CAN_TRACE_BUF_SIZE)
+    {
+        old = can_trace_tail & CAN_TRACE_BUF_MASK;
+        if ((ring[old] & CAN_TRACE_TYPE_MASK) != CAN_TRACE_TYPE_PAD)
+        {
+            can_trace_count--;
+            can_trace_overwritten_num++;
+        }
+        can_trace_tail += can_trace_size_at(can_trace_tail);
+    }
+    if (pad != 0U)
+    {
+        ring[offset] = CAN_TRACE_TYPE_PAD;
+        can_trace_head += pad;
+        offset = 0U;
+    }
+
+    record = (can_trace_record_t *)&ring[offset];
+    record->type = type;
+    record->len = (uint8_t)len;
+    record->stamp = (uint16_t)stamp;
+    record->tick = tick;
+    record->id = id;
+    can_trace_head += size;
+    can_trace_count++;
+    can_trace_record_num++;
+
+    /* a sync never ends the window, the record it was written for follows */
+    if (can_trace_state == CAN_TRACE_STATE_TRIGGERED)
+    {
+        can_trace_post_left -= (int32_t)(pad + size);
+        if ((can_trace_post_left <= 0) && ((type & CAN_TRACE_TYPE_MASK) != CAN_TRACE_TYPE_SYNC))
+        {
+            can_trace_state = CAN_TRACE_STATE_STOPPED;
+        }
+    }
+    return record;
+}
+
+/* @brief: Bytes taken by the record at a ring position
+ * @param pos : free running position of the record
+ * @return    : size with padding, up to the end of the ring for a PAD record
+ */
+static uint32_t can_trace_size_at(uint32_t pos)
+{
+    const uint8_t *ring = (const uint8_t *)can_trace_buf;
+    uint32_t offset = pos & CAN_TRACE_BUF_MASK;
+
+    if ((ring[offset] & CAN_TRACE_TYPE_MASK) == CAN_TRACE_TYPE_PAD)
+    {
+        return CAN_TRACE_BUF_SIZE - offset;
+    }
+    return (sizeof(can_trace_record_t) + ring[offset + 1U] + 3U) & ~3U;
+}
+
+/* @brief: The trigger fired on a record, the post trigger window starts
+ *         after it
+ * @param record : the record, already in the ring
+ * @return       : None
+ */
+static void can_trace_fire(can_trace_record_t *record)
+{
+    record->type |= CAN_TRACE_FLAG_TRIGGER;
+    can_trace_trigger_num++;
+    can_trace_post_left = (int32_t)can_trace_config.post_size;
+    can_trace_state = (can_trace_post_left > 0) ? CAN_TRACE_STATE_TRIGGERED : CAN_TRACE_STATE_STOPPED;
+}
@@ -0,0 +1,126 @@
+#ifndef CAN_TRACE_H
+#define CAN_TRACE_H
+
+#include "can_lld.h"
+#include "can_stats.h"
+
+/* CAN trace recorder. can_lld hands every frame received or sent, the CAN
+ * errors and the frames it lost to the recorder, which keeps them in a RAM
+ * ring with their FlexCAN time stamps. Armed, the oldest records make room
+ * for new ones. A trigger (an ID, an ESR1 error bit or can_trace_trigger())
+ * keeps the ring running for the post trigger window and then stops it, the
+ * ring then holds the frames before and after the trigger. The stopped trace
+ * is sent over the UART by freertos_task_100ms and armed again,
+ * tools/can_trace_dump turns it into a candump log or a pcap file.
+ *
+ * A record is written by the CAN interrupts or with them masked, it is a few
+ * stores and one copy of the payload. Nothing is ever dropped while the
+ * trace is armed or triggered: a full ring overwrites its oldest records */
+
+/* ring size in bytes, must be a power of 2. A classic frame with 8 bytes
+ * takes 20 bytes, 8 KB are about 400 frames or 0.8 s of a bus at 500 kbit/s
+ * and full load */
+#define CAN_TRACE_BUF_SIZE 8192U
+
+/* the FlexCAN time stamp counts CAN bits and wraps after 65536 of them,
+ * 131 ms at 500 kbit/s. A sync record with the FreeRTOS tick and the timer
+ * is written at least this often while frames come in, the host unwraps the
+ * time stamps with it */
+#define CAN_TRACE_SYNC_MS 20U
+
+/* trigger of can_trace_arm(NULL) */
+#define CAN_TRACE_TRIGGER_ID_ENABLE 0
+#define CAN_TRACE_TRIGGER_ID 0x7DFU
+#define CAN_TRACE_TRIGGER_ID_MASK (CAN_LLD_TX_ID_EXT | 0x7FFU)
+#define CAN_TRACE_TRIGGER_ERROR_MASK (CAN_ESR1_BOFFINT_MASK | CAN_ESR1_ERRINT_MASK)
+/* share of the ring recorded after the trigger, percent */
+#define CAN_TRACE_POST_PERCENT 25U
+
+/* send a stopped trace over the UART, see freertos_task_100ms */
+#define CAN_TRACE_UART_EXPORT_ENABLE 1
+
+/* record types, the low nibble of the first byte */
+#define CAN_TRACE_TYPE_PAD 0x00U        /* rest of the ring up to its end unused */
+#define CAN_TRACE_TYPE_RX 0x01U
+#define CAN_TRACE_TYPE_TX 0x02U
+#define CAN_TRACE_TYPE_ERROR 0x03U      /* id is ESR1 */
+#define CAN_TRACE_TYPE_LOST 0x04U       /* id is the number of frames can_lld
+                                         * lost, RX FIFO or DMA ring overflow */
+#define CAN_TRACE_TYPE_SYNC 0x05U       /* stamp is the FlexCAN timer at tick */
+#define CAN_TRACE_TYPE_MASK 0x0FU
+/* flags, the high nibble */
+#define CAN_TRACE_FLAG_EXT 0x10U        /* 29 bit ID */
+#define CAN_TRACE_FLAG_FD 0x20U
+#define CAN_TRACE_FLAG_BRS 0x40U
+#define CAN_TRACE_FLAG_RESTART 0x10U    /* sync: FlexCAN was started again,
+                                         * its timer started at 0 */
+#define CAN_TRACE_FLAG_TRIGGER 0x80U    /* the record which fired the trigger */
+
+/* record in the ring, followed by len data bytes and padded to 4 bytes. A
+ * record never wraps round the end of the ring */
+typedef struct
+{
+    uint8_t type;       /* CAN_TRACE_TYPE_x | CAN_TRACE_FLAG_x */
+    uint8_t len;        /* data bytes */
+    uint16_t stamp;     /* FlexCAN time stamp, CAN bits */
+    uint32_t tick;      /* FreeRTOS tick */
+    uint32_t id;        /* CAN ID, ESR1 or the lost frames */
+} can_trace_record_t;
+
+#define CAN_TRACE_RECORD_MAX (sizeof(can_trace_record_t) + CAN_LLD_PAYLOAD_MAX)
+
+/* dump packets, framed like the can_stats snapshot:
+ *   'C' 'S' type len payload[len] crc16
+ * A dump is one header packet followed by one record packet per record,
+ * oldest first, without the PAD records */
+#define CAN_TRACE_PACKET_HEADER 0x11U
+#define CAN_TRACE_PACKET_RECORD 0x12U
+#define CAN_TRACE_PACKET_VERSION 1U
+
+/* header payload, little endian:
+ *   u8  version          u8  size of the record header
+ *   u16 ring size in KB
+ *   u32 nominal bitrate  u32 FD data bitrate   u32 tick rate in Hz
+ *   u32 records following
+ *   u32 records overwritten since the trace was armed
+ * record payload: the record as in the ring, without its padding */
+#define CAN_TRACE_HEADER_SIZE 24U
+#define CAN_TRACE_PACKET_MAX (CAN_STATS_PACKET_OVERHEAD + CAN_TRACE_RECORD_MAX)
+
+#if ((CAN_TRACE_BUF_SIZE & (CAN_TRACE_BUF_SIZE - 1U)) != 0U) || (CAN_TRACE_BUF_SIZE < 1024U)
+#error "CAN_TRACE_BUF_SIZE must be a power of 2 and 1024 or more"
+#endif
+
+typedef enum
+{
+    CAN_TRACE_STATE_IDLE = 0,   /* not armed, nothing recorded */
+    CAN_TRACE_STATE_ARMED,      /* recording, waiting for the trigger */
+    CAN_TRACE_STATE_TRIGGERED,  /* recording the post trigger window */
+    CAN_TRACE_STATE_STOPPED     /* ring full of the trace, ready to dump */
+} can_trace_state_t;
+
+typedef struct
+{
+    bool id_enable;
+    uint32_t id;            /* or'ed with CAN_LLD_TX_ID_EXT for a 29 bit ID */
+    uint32_t id_mask;       /* 1 = bit compared, CAN_LLD_TX_ID_EXT compares
+                             * the ID type */
+    uint32_t error_mask;    /* ESR1 bits which fire the trigger, 0 for none */
+    uint32_t post_size;     /* bytes recorded after the trigger */
+} can_trace_config_t;
+
+extern volatile can_trace_state_t can_trace_state;
+/* records written and overwritten since the trace was armed */
+extern uint32_t can_trace_record_num;
+extern uint32_t can_trace_overwritten_num;
+extern uint32_t can_trace_trigger_num;
+
+void can_trace_arm(const can_trace_config_t *config);
+void can_trace_trigger(void);
+void can_trace_frame(uint8_t type, uint32_t msgId, uint32_t cs, const uint8_t *data, uint32_t len, TickType_t tick);
+void can_trace_error(uint32_t esr1, TickType_t tick);
+void can_trace_lost(uint32_t num, TickType_t tick);
+void can_trace_sync(bool restart, TickType_t tick);
+uint32_t can_trace_dump(uint8_t *buf);
+
+#endif
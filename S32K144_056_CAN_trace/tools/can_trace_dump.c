@@ -0,0 +1,618 @@
+/* Host side converter of the CAN trace dumps of can_trace_dump().
+ *
+ * The input is a raw capture of the UART, the dump packets sit between the
+ * printf lines like the can_stats snapshots. Every header packet starts a
+ * new trace, its records are put back on one time line and written as a
+ * candump log (default) or as a pcap file with the SocketCAN link type,
+ * which Wireshark and the can-utils read.
+ *
+ * Time: a record has the 16 bit FlexCAN time stamp, one count per nominal
+ * CAN bit, and the FreeRTOS tick. The sync records pair the tick with the
+ * timer, the time stamps are unwrapped from the last sync before them and
+ * the tick. The timer runs from the start of FlexCAN, its offset to the tick
+ * is the latest bound all syncs of a FlexCAN start give. Times are seconds
+ * since the start of the board. Records are sorted by time, frames of the
+ * RX DMA ring are recorded late by freertos_task_can_rx.
+ *
+ * Errors and lost frames become SocketCAN error frames.
+ *
+ * build: gcc -O2 -o can_trace_dump can_trace_dump.c -lm
+ * usage: can_trace_dump [-p] [-i ifname] [-b bitrate] [-o out] [capture.bin]
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/* must match can_stats.h and can_trace.h */
+#define PACKET_HEADER 0x11U
+#define PACKET_RECORD 0x12U
+#define PACKET_VERSION 1U
+#define PACKET_OVERHEAD 6U
+#define HEADER_SIZE 24U
+#define RECORD_HEADER_SIZE 12U
+#define PAYLOAD_MAX 64U
+
+#define TYPE_RX 0x01U
+#define TYPE_TX 0x02U
+#define TYPE_ERROR 0x03U
+#define TYPE_LOST 0x04U
+#define TYPE_SYNC 0x05U
+#define TYPE_MASK 0x0FU
+#define FLAG_EXT 0x10U
+#define FLAG_FD 0x20U
+#define FLAG_BRS 0x40U
+#define FLAG_RESTART 0x10U
+#define FLAG_TRIGGER 0x80U
+
+/* ESR1 of the S32K144 */
+#define ESR1_BOFFINT 0x00000004U
+#define ESR1_FLTCONF_SHIFT 4U
+#define ESR1_RXWRN 0x00000100U
+#define ESR1_TXWRN 0x00000200U
+#define ESR1_STFERR 0x00000400U
+#define ESR1_FRMERR 0x00000800U
+#define ESR1_CRCERR 0x00001000U
+#define ESR1_ACKERR 0x00002000U
+#define ESR1_BIT0ERR 0x00004000U
+#define ESR1_BIT1ERR 0x00008000U
+#define ESR1_BOFFDONEINT 0x00080000U
+#define ESR1_ERROVR 0x00200000U
+#define ESR1_FAST_SHIFT 16U     /* the FD data phase bits sit 16 bits higher */
+
+/* linux/can.h and linux/can/error.h */
+#define CAN_EFF_FLAG 0x80000000U
+#define CAN_ERR_FLAG 0x20000000U
+#define CAN_ERR_CRTL 0x00000004U
+#define CAN_ERR_PROT 0x00000008U
+#define CAN_ERR_ACK 0x00000020U
+#define CAN_ERR_BUSOFF 0x00000040U
+#define CAN_ERR_RESTARTED 0x00000100U
+#define CAN_ERR_CRTL_RX_OVERFLOW 0x01U
+#define CAN_ERR_CRTL_RX_WARNING 0x04U
+#define CAN_ERR_CRTL_TX_WARNING 0x08U
+#define CAN_ERR_CRTL_RX_PASSIVE 0x10U
+#define CAN_ERR_CRTL_TX_PASSIVE 0x20U
+#define CAN_ERR_PROT_FORM 0x02U
+#define CAN_ERR_PROT_STUFF 0x04U
+#define CAN_ERR_PROT_BIT0 0x08U
+#define CAN_ERR_PROT_BIT1 0x10U
+#define CAN_ERR_PROT_OVERLOAD 0x20U
+#define CAN_ERR_PROT_LOC_CRC_SEQ 0x08U
+#define CAN_ERR_DLC 8U
+#define CANFD_BRS 0x01U
+#define CANFD_FDF 0x04U
+
+#define LINKTYPE_CAN_SOCKETCAN 227U
+
+typedef struct
+{
+    uint8_t type;
+    uint8_t len;
+    uint16_t stamp;
+    uint32_t tick;
+    uint32_t id;
+    uint8_t data[PAYLOAD_MAX];
+    uint32_t seq;       /* ring order */
+    uint32_t epoch;     /* FlexCAN start the record belongs to */
+    double bits;        /* unwrapped time stamp, syncs only */
+    double time;        /* seconds */
+} record_t;
+
+static const char *ifname = "can0";
+static bool pcap = false;
+static uint32_t bitrate_override = 0U;
+static FILE *out;
+
+/* trace being collected */
+static bool trace_open = false;
+static uint32_t trace_num = 0U;
+static uint32_t trace_bitrate;
+static uint32_t trace_tick_hz;
+static uint32_t trace_expected;
+static uint32_t trace_overwritten;
+static record_t *records = NULL;
+static uint32_t record_num = 0U;
+static uint32_t record_cap = 0U;
+static uint32_t bad_crc_num = 0U;
+
+static uint32_t get16(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8);
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+    return get16(p) | (get16(&p[2]) << 16);
+}
+
+/* CRC-16/CCITT-FALSE */
+static uint16_t crc16(const uint8_t *data, uint32_t len)
+{
+    uint16_t crc = 0xFFFFU;
+    uint32_t i;
+    uint32_t bit;
+
+    for (i = 0U; i < len; i++)
+    {
+        crc ^= (uint16_t)(data[i] << 8);
+        for (bit = 0U; bit < 8U; bit++)
+        {
+            crc = (crc & 0x8000U) ? (uint16_t)((crc << 1) ^ 0x1021U) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+/* the 16 bit stamp nearest to an estimate of the unwrapped timer */
+static double unwrap(double estimate, uint16_t stamp)
+{
+    int64_t base = (int64_t)llround(estimate);
+
+    return (double)(base + (int16_t)(uint16_t)(stamp - (uint16_t)base));
+}
+
+static void put32be(uint8_t *p, uint32_t value)
+{
+    p[0] = (uint8_t)(value >> 24);
+    p[1] = (uint8_t)(value >> 16);
+    p[2] = (uint8_t)(value >> 8);
+    p[3] = (uint8_t)value;
+}
+
+/* SocketCAN error frame of an ESR1 read or of lost frames */
+static uint32_t error_frame(const record_t *r, uint8_t *data)
+{
+    uint32_t esr1 = r->id;
+    uint32_t errors = esr1 | (esr1 >> ESR1_FAST_SHIFT);
+    uint32_t fltconf = (esr1 >> ESR1_FLTCONF_SHIFT) & 3U;
+    uint32_t id = CAN_ERR_FLAG;
+
+    memset(data, 0, CAN_ERR_DLC);
+    if ((r->type & TYPE_MASK) == TYPE_LOST)
+    {
+        data[1] = CAN_ERR_CRTL_RX_OVERFLOW;
+        return id | CAN_ERR_CRTL;
+    }
+
+    if (errors & (ESR1_STFERR | ESR1_FRMERR | ESR1_CRCERR | ESR1_BIT0ERR | ESR1_BIT1ERR))
+    {
+        id |= CAN_ERR_PROT;
+        data[2] |= (errors & ESR1_FRMERR) ? CAN_ERR_PROT_FORM : 0U;
+        data[2] |= (errors & ESR1_STFERR) ? CAN_ERR_PROT_STUFF : 0U;
+        data[2] |= (errors & ESR1_BIT0ERR) ? CAN_ERR_PROT_BIT0 : 0U;
+        data[2] |= (errors & ESR1_BIT1ERR) ? CAN_ERR_PROT_BIT1 : 0U;
+        data[3] = (errors & ESR1_CRCERR) ? CAN_ERR_PROT_LOC_CRC_SEQ : 0U;
+    }
+    if (esr1 & ESR1_ERROVR)
+    {
+        id |= CAN_ERR_PROT;
+        data[2] |= CAN_ERR_PROT_OVERLOAD;
+    }
+    if (esr1 & ESR1_ACKERR)
+    {
+        id |= CAN_ERR_ACK;
+    }
+    if ((esr1 & (ESR1_RXWRN | ESR1_TXWRN)) || (fltconf == 1U))
+    {
+        id |= CAN_ERR_CRTL;
+        data[1] |= (esr1 & ESR1_RXWRN) ? CAN_ERR_CRTL_RX_WARNING : 0U;
+        data[1] |= (esr1 & ESR1_TXWRN) ? CAN_ERR_CRTL_TX_WARNING : 0U;
+        if (fltconf == 1U)
+        {
+            data[1] |= (esr1 & ESR1_TXWRN) ? CAN_ERR_CRTL_TX_PASSIVE : CAN_ERR_CRTL_RX_PASSIVE;
+        }
+    }
+    if ((esr1 & ESR1_BOFFINT) || (fltconf >= 2U))
+    {
+        id |= CAN_ERR_BUSOFF;
+    }
+    if (esr1 & ESR1_BOFFDONEINT)
+    {
+        id |= CAN_ERR_RESTARTED;
+    }
+    return id;
+}
+
+static void write_candump(const record_t *r)
+{
+    uint8_t err[CAN_ERR_DLC];
+    uint64_t usec = (uint64_t)llround(r->time * 1e6);
+    uint32_t i;
+
+    fprintf(out, "(%010llu.%06llu) %s ", (unsigned long long)(usec / 1000000U),
+            (unsigned long long)(usec % 1000000U), ifname);
+    switch (r->type & TYPE_MASK)
+    {
+    case TYPE_RX:
+    case TYPE_TX:
+        if (r->type & FLAG_EXT)
+        {
+            fprintf(out, "%08X", r->id);
+        }
+        else
+        {
+            fprintf(out, "%03X", r->id);
+        }
+        if (r->type & FLAG_FD)
+        {
+            fprintf(out, "##%X", (r->type & FLAG_BRS) ? CANFD_BRS : 0U);
+        }
+        else
+        {
+            fprintf(out, "#");
+        }
+        for (i = 0U; i < r->len; i++)
+        {
+            fprintf(out, "%02X", r->data[i]);
+        }
+        break;
+    default:
+        fprintf(out, "%08X#", error_frame(r, err));
+        for (i = 0U; i < CAN_ERR_DLC; i++)
+        {
+            fprintf(out, "%02X", err[i]);
+        }
+        break;
+    }
+    fprintf(out, "\n");
+}
+
+static void write_pcap_header(void)
+{
+    /* host byte order, version 2.4, microseconds */
+    uint16_t header[12] = {0xC3D4U, 0xA1B2U, 2U, 4U, 0U, 0U, 0U, 0U, 0xFFFFU, 0U, LINKTYPE_CAN_SOCKETCAN, 0U};
+
+    fwrite(header, sizeof(header), 1U, out);
+}
+
+static void write_pcap(const record_t *r)
+{
+    uint8_t frame[8U + PAYLOAD_MAX];
+    uint64_t usec = (uint64_t)llround(r->time * 1e6);
+    uint32_t header[4];
+    uint32_t size;
+    uint32_t id;
+
+    memset(frame, 0, sizeof(frame));
+    if (((r->type & TYPE_MASK) == TYPE_RX) || ((r->type & TYPE_MASK) == TYPE_TX))
+    {
+        id = r->id | ((r->type & FLAG_EXT) ? CAN_EFF_FLAG : 0U);
+        frame[4] = r->len;
+        memcpy(&frame[8], r->data, r->len);
+        if (r->type & FLAG_FD)
+        {
+            frame[5] = CANFD_FDF | ((r->type & FLAG_BRS) ? CANFD_BRS : 0U);
+            size = 8U + 64U;
+        }
+        else
+        {
+            size = 8U + 8U;
+        }
+    }
+    else
+    {
+        id = error_frame(r, &frame[8]);
+        frame[4] = CAN_ERR_DLC;
+        size = 8U + 8U;
+    }
+    /* the CAN ID and its flags are big endian in this link type */
+    put32be(frame, id);
+
+    header[0] = (uint32_t)(usec / 1000000U);
+    header[1] = (uint32_t)(usec % 1000000U);
+    header[2] = size;
+    header[3] = size;
+    fwrite(header, sizeof(header), 1U, out);
+    fwrite(frame, size, 1U, out);
+}
+
+static int compare_time(const void *a, const void *b)
+{
+    const record_t *ra = a;
+    const record_t *rb = b;
+
+    if (ra->time != rb->time)
+    {
+        return (ra->time < rb->time) ? -1 : 1;
+    }
+    return (ra->seq < rb->seq) ? -1 : 1;
+}
+
+/* put the records of the trace on one time line and write them */
+static void trace_close(void)
+{
+    double bits_per_tick;
+    double *offset;
+    double bits;
+    int32_t ref = -1;
+    int32_t first_sync = -1;
+    uint32_t epoch = 0U;
+    uint32_t i;
+    const record_t *sync;
+    double trigger = -1.0;
+
+    if (!trace_open)
+    {
+        return;
+    }
+    trace_open = false;
+    trace_num++;
+    if (record_num != trace_expected)
+    {
+        fprintf(stderr, "trace %u: %u of %u records, packets lost on the UART\n", trace_num, record_num,
+                trace_expected);
+    }
+    if ((trace_bitrate == 0U) || (trace_tick_hz == 0U))
+    {
+        fprintf(stderr, "trace %u: no bitrate or tick rate\n", trace_num);
+        record_num = 0U;
+        return;
+    }
+    bits_per_tick = (double)trace_bitrate / trace_tick_hz;
+
+    /* unwrap the syncs, each FlexCAN start is an epoch with its own offset */
+    offset = calloc(record_num + 1U, sizeof(double));
+    for (i = 0U; i < record_num; i++)
+    {
+        record_t *r = &records[i];
+
+        if ((r->type & TYPE_MASK) != TYPE_SYNC)
+        {
+            continue;
+        }
+        if ((ref < 0) || (r->type & FLAG_RESTART))
+        {
+            if (ref >= 0)
+            {
+                epoch++;
+            }
+            r->bits = r->stamp;
+            offset[epoch] = -INFINITY;
+        }
+        else
+        {
+            sync = &records[ref];
+            r->bits = unwrap(sync->bits + ((int32_t)(r->tick - sync->tick) * bits_per_tick), r->stamp);
+        }
+        r->epoch = epoch;
+        bits = ((double)r->tick / trace_tick_hz) - (r->bits / trace_bitrate);
+        if (bits > offset[epoch])
+        {
+            offset[epoch] = bits;
+        }
+        if (first_sync < 0)
+        {
+            first_sync = (int32_t)i;
+        }
+        ref = (int32_t)i;
+    }
+
+    /* every record from the last sync before it, the first ones in the ring
+     * from the first sync */
+    ref = first_sync;
+    for (i = 0U; i < record_num; i++)
+    {
+        record_t *r = &records[i];
+
+        if ((r->type & TYPE_MASK) == TYPE_SYNC)
+        {
+            ref = (int32_t)i;
+        }
+        if (ref < 0)
+        {
+            r->time = (double)r->tick / trace_tick_hz;
+        }
+        else
+        {
+            sync = &records[ref];
+            bits = unwrap(sync->bits + ((int32_t)(r->tick - sync->tick) * bits_per_tick), r->stamp);
+            r->time = offset[sync->epoch] + (bits / trace_bitrate);
+        }
+        if (r->type & FLAG_TRIGGER)
+        {
+            trigger = r->time;
+        }
+    }
+    free(offset);
+
+    qsort(records, record_num, sizeof(record_t), compare_time);
+    for (i = 0U; i < record_num; i++)
+    {
+        if ((records[i].type & TYPE_MASK) == TYPE_SYNC)
+        {
+            continue;
+        }
+        if (pcap)
+        {
+            write_pcap(&records[i]);
+        }
+        else
+        {
+            write_candump(&records[i]);
+        }
+    }
+
+    fprintf(stderr, "trace %u: %u records, %u overwritten before, %.6f s to %.6f s", trace_num, record_num,
+            trace_overwritten, (record_num != 0U) ? records[0].time : 0.0,
+            (record_num != 0U) ? records[record_num - 1U].time : 0.0);
+    if (trigger >= 0.0)
+    {
+        fprintf(stderr, ", trigger at %.6f s", trigger);
+    }
+    fprintf(stderr, "\n");
+    record_num = 0U;
+}
+
+static void trace_open_header(const uint8_t *p)
+{
+    trace_close();
+    trace_open = true;
+    trace_bitrate = (bitrate_override != 0U) ? bitrate_override : get32(&p[4]);
+    trace_tick_hz = get32(&p[12]);
+    trace_expected = get32(&p[16]);
+    trace_overwritten = get32(&p[20]);
+    record_num = 0U;
+}
+
+static void trace_add(const uint8_t *p, uint32_t len)
+{
+    record_t *r;
+
+    if (!trace_open || (len < RECORD_HEADER_SIZE) || (p[1] != (len - RECORD_HEADER_SIZE)) || (p[1] > PAYLOAD_MAX))
+    {
+        return;
+    }
+    if (record_num == record_cap)
+    {
+        record_cap = (record_cap == 0U) ? 1024U : (record_cap * 2U);
+        records = realloc(records, record_cap * sizeof(record_t));
+        if (records == NULL)
+        {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
+        }
+    }
+    r = &records[record_num];
+    r->type = p[0];
+    r->len = p[1];
+    r->stamp = (uint16_t)get16(&p[2]);
+    r->tick = get32(&p[4]);
+    r->id = get32(&p[8]);
+    memcpy(r->data, &p[RECORD_HEADER_SIZE], r->len);
+    r->seq = record_num;
+    r->epoch = 0U;
+    r->bits = 0.0;
+    r->time = 0.0;
+    record_num++;
+}
+
+int main(int argc, char *argv[])
+{
+    FILE *in = stdin;
+    const char *out_name = NULL;
+    uint8_t *buf = NULL;
+    size_t size = 0U;
+    size_t cap = 0U;
+    size_t n;
+    size_t pos;
+    uint32_t len;
+    uint8_t type;
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-p") == 0)
+        {
+            pcap = true;
+        }
+        else if ((strcmp(argv[i], "-i") == 0) && ((i + 1) < argc))
+        {
+            ifname = argv[++i];
+        }
+        else if ((strcmp(argv[i], "-b") == 0) && ((i + 1) < argc))
+        {
+            bitrate_override = (uint32_t)strtoul(argv[++i], NULL, 0);
+        }
+        else if ((strcmp(argv[i], "-o") == 0) && ((i + 1) < argc))
+        {
+            out_name = argv[++i];
+        }
+        else if ((argv[i][0] != '-') && (in == stdin))
+        {
+            in = fopen(argv[i], "rb");
+            if (in == NULL)
+            {
+                perror(argv[i]);
+                return 1;
+            }
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-p] [-i ifname] [-b bitrate] [-o out] [capture.bin]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    out = stdout;
+    if (out_name != NULL)
+    {
+        out = fopen(out_name, pcap ? "wb" : "w");
+        if (out == NULL)
+        {
+            perror(out_name);
+            return 1;
+        }
+    }
+
+    do
+    {
+        if ((cap - size) < 4096U)
+        {
+            cap = (cap == 0U) ? 65536U : (cap * 2U);
+            buf = realloc(buf, cap);
+            if (buf == NULL)
+            {
+                fprintf(stderr, "out of memory\n");
+                return 1;
+            }
+        }
+        n = fread(&buf[size], 1U, cap - size, in);
+        size += n;
+    } while (n != 0U);
+
+    if (pcap)
+    {
+        write_pcap_header();
+    }
+
+    for (pos = 0U; (pos + PACKET_OVERHEAD) <= size; pos++)
+    {
+        if ((buf[pos] != 'C') || (buf[pos + 1U] != 'S'))
+        {
+            continue;
+        }
+        type = buf[pos + 2U];
+        len = buf[pos + 3U];
+        if (((pos + PACKET_OVERHEAD + len) > size) ||
+            !(((type == PACKET_HEADER) && (len == HEADER_SIZE)) ||
+              ((type == PACKET_RECORD) && (len >= RECORD_HEADER_SIZE) && (len <= (RECORD_HEADER_SIZE + PAYLOAD_MAX)))))
+        {
+            continue;
+        }
+        if (crc16(&buf[pos + 2U], len + 2U) != get16(&buf[pos + 4U + len]))
+        {
+            bad_crc_num++;
+            continue;
+        }
+        if (type == PACKET_HEADER)
+        {
+            if ((buf[pos + 4U] != PACKET_VERSION) || (buf[pos + 5U] != RECORD_HEADER_SIZE))
+            {
+                fprintf(stderr, "trace version %u, expected %u\n", buf[pos + 4U], PACKET_VERSION);
+                return 1;
+            }
+            trace_open_header(&buf[pos + 4U]);
+        }
+        else
+        {
+            trace_add(&buf[pos + 4U], len);
+        }
+        pos += PACKET_OVERHEAD + len - 1U;
+    }
+    trace_close();
+
+    if (bad_crc_num != 0U)
+    {
+        fprintf(stderr, "%u packets with a bad CRC skipped\n", bad_crc_num);
+    }
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+    free(records);
+    free(buf);
+    return (trace_num != 0U) ? 0 : 1;
+}
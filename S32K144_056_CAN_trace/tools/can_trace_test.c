@@ -0,0 +1,881 @@
+/* Host test of the CAN trace recorder under a fully loaded 1 Mbit/s bus.
+ * can_lld.c, can_trace.c, can_stats.c and can_err.c are built as they are
+ * into this file. Frames go back to back with random stuff bits, with bursts
+ * of DLC 0 frames and about every tenth frame sent by the node, which wins
+ * the next arbitration. An error frame comes every 97 frames and an RX FIFO
+ * overflow every 149.
+ *
+ *   irq      frames recorded from the interrupts, the trigger fires on 0x7DF
+ *   late     RX frames recorded in batches by the task like the RX DMA ring,
+ *            dated back by the FlexCAN timer
+ *   restart  FlexCAN started again inside the window, the timer starts at 0
+ *   cost     time of one record with 8 data bytes on the host
+ *
+ * Each stopped trace is dumped into a capture between printf lines, turned
+ * into a candump log and a pcap by can_trace_dump and compared with the
+ * frames the model put on the bus: the log must be sorted, the frames must
+ * be the bus frames in bus order, contiguous unless recorded late, and the
+ * time stamps must be off by one offset, which may change by a tick at a
+ * restart. The pcap must hold the same frames with the SocketCAN link type.
+ *
+ * The captures, logs and pcaps are written to the current directory. Exit
+ * status 1 on a failed check.
+ *
+ * build: gcc -O2 -Wall -Wno-pointer-to-int-cast -I.. -I../../S32K144_055_CAN_bus_off
+ *            -I../../S32K144_051_ISO_TP -I../../S32K144_050_CAN_filter_compiler
+ *            -I../../S32K144_057_CAN_socketcan/host -o can_trace_test can_trace_test.c
+ *        gcc -O2 -o can_trace_dump can_trace_dump.c -lm
+ * usage: can_trace_test [-d can_trace_dump]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "can_lld.c"
+#include "can_err.c"
+#include "can_stats.c"
+#include "can_trace.c"
+
+#define TEST_BITRATE 1000000U
+#define TEST_GEN_MAX 200000U
+#define TEST_CAPTURE_MAX 2000000U
+#define TEST_PEND_MAX 256U
+#define TEST_TICK_US (1000000U / configTICK_RATE_HZ)
+#define TEST_TRIGGER_ID 0x7DFU
+/* interframe space, the interrupt comes at the end of the frame */
+#define TEST_IFS_BITS 3U
+/* the late task runs every 1 ms or when its batch is full */
+#define TEST_DRAIN_US 1000U
+#define TEST_DRAIN_NUM 200U
+#define TEST_COST_NUM 10000000U
+#define LINKTYPE_CAN_SOCKETCAN 227U
+#define TEST_CAN_EFF_FLAG 0x80000000U
+#define TEST_CAN_ERR_FLAG 0x20000000U
+
+typedef struct
+{
+    bool busy;
+    uint32_t id;
+    bool ext;
+    uint32_t len;
+    uint8_t data[8];
+} test_mb_t;
+
+/* a frame on the bus */
+typedef struct
+{
+    uint64_t sof;
+    uint32_t id;
+    bool ext;
+    uint8_t len;
+    uint8_t data[8];
+} test_gen_t;
+
+/* an RX frame the late task has not recorded yet */
+typedef struct
+{
+    uint32_t id;
+    uint32_t cs;
+    uint8_t len;
+    uint8_t data[8];
+} test_pend_t;
+
+static uint64_t test_seed = 88172645463325252ULL;
+static uint32_t test_error = 0U;
+static uint32_t test_check_num = 0U;
+static const char *test_dump = "./can_trace_dump";
+
+#define TEST_CHECK(cond, ...) do { test_check_num++; if (!(cond)) { printf("FAIL: " __VA_ARGS__); printf("\n"); test_error++; } } while (0)
+
+/* SDK and FreeRTOS, as far as can_lld.c uses them */
+
+flexcan_state_t canCom1_State;
+const flexcan_user_config_t canCom1_InitConfig0 =
+{
+    .max_num_mb = 16U,
+    .is_rx_fifo_needed = true
+};
+lpspi_state_t lpspiCom1State;
+const lpspi_master_config_t lpspiCom1_MasterConfig0;
+const sbc_int_config_t sbc_uja116x1_InitConfig0;
+static CAN_Type test_can0;
+static flexcan_callback_t test_callback;
+static flexcan_error_callback_t test_error_callback;
+static uint32_t test_esr1;
+
+static uint64_t test_now;                   /* us, one bit at 1 Mbit/s */
+static uint64_t test_timer_start;           /* us, last FlexCAN start */
+static test_mb_t test_mb[32];
+static test_gen_t test_gen[TEST_GEN_MAX];
+static uint32_t test_gen_num;
+static bool test_late;
+static test_pend_t test_pend[TEST_PEND_MAX];
+static uint32_t test_pend_num;
+static uint64_t test_drain_us;
+static uint32_t test_tx_seq;
+static uint32_t test_trigger_at = UINT32_MAX;
+static uint8_t test_capture[TEST_CAPTURE_MAX];
+
+CAN_Type *flexcan_host_regs(void)
+{
+    return &test_can0;
+}
+
+status_t LPSPI_DRV_MasterInit(uint32_t instance, lpspi_state_t *lpspiState, const lpspi_master_config_t *spiConfig)
+{
+    (void)instance;
+    (void)lpspiState;
+    (void)spiConfig;
+    return STATUS_SUCCESS;
+}
+
+status_t SBC_Init(const sbc_int_config_t *const config, const uint32_t lpspiInstance)
+{
+    (void)config;
+    (void)lpspiInstance;
+    return STATUS_SUCCESS;
+}
+
+void INT_SYS_SetPriority(IRQn_Type irqNumber, uint8_t priority)
+{
+    (void)irqNumber;
+    (void)priority;
+}
+
+void vPortEnterCritical(void)
+{
+}
+
+void vPortExitCritical(void)
+{
+}
+
+void FLEXCAN_DRV_GetDefaultConfig(flexcan_user_config_t *config)
+{
+    memset(config, 0, sizeof(*config));
+}
+
+/* the FlexCAN timer starts from 0 */
+status_t FLEXCAN_DRV_Init(uint8_t instance, flexcan_state_t *state, const flexcan_user_config_t *data)
+{
+    (void)instance;
+    (void)state;
+    (void)data;
+    test_timer_start = test_now;
+    test_can0.TIMER = 0U;
+    return STATUS_SUCCESS;
+}
+
+status_t FLEXCAN_DRV_Deinit(uint8_t instance)
+{
+    (void)instance;
+    return STATUS_SUCCESS;
+}
+
+void FLEXCAN_DRV_SetTDCOffset(uint8_t instance, bool enable, uint8_t offset)
+{
+    (void)instance;
+    (void)enable;
+    (void)offset;
+}
+
+void FLEXCAN_DRV_ConfigRxFifo(uint8_t instance, flexcan_rx_fifo_id_element_format_t id_format,
+                              const flexcan_id_table_t *id_filter_table)
+{
+    (void)instance;
+    (void)id_format;
+    (void)id_filter_table;
+}
+
+void FLEXCAN_DRV_InstallEventCallback(uint8_t instance, flexcan_callback_t callback, void *callbackParam)
+{
+    (void)instance;
+    (void)callbackParam;
+    test_callback = callback;
+}
+
+void FLEXCAN_DRV_InstallErrorCallback(uint8_t instance, flexcan_error_callback_t callback, void *callbackParam)
+{
+    (void)instance;
+    (void)callbackParam;
+    test_error_callback = callback;
+}
+
+status_t FLEXCAN_DRV_RxFifo(uint8_t instance, flexcan_msgbuff_t *data)
+{
+    (void)instance;
+    (void)data;
+    return STATUS_SUCCESS;
+}
+
+uint32_t FLEXCAN_DRV_GetErrorStatus(uint8_t instance)
+{
+    const uint32_t esr1 = test_esr1;
+
+    (void)instance;
+    test_esr1 = 0U;
+    return esr1;
+}
+
+void FLEXCAN_ClearErrIntStatusFlag(CAN_Type *base)
+{
+    (void)base;
+}
+
+void FLEXCAN_EnterFreezeMode(CAN_Type *base)
+{
+    (void)base;
+}
+
+void FLEXCAN_ExitFreezeMode(CAN_Type *base)
+{
+    (void)base;
+}
+
+void FLEXCAN_DRV_SetRxMaskType(uint8_t instance, flexcan_rx_mask_type_t type)
+{
+    (void)instance;
+    (void)type;
+}
+
+status_t FLEXCAN_DRV_ConfigRxMb(uint8_t instance, uint8_t mb_idx, const flexcan_data_info_t *rx_info, uint32_t msg_id)
+{
+    (void)instance;
+    (void)mb_idx;
+    (void)rx_info;
+    (void)msg_id;
+    return STATUS_SUCCESS;
+}
+
+status_t FLEXCAN_DRV_SetRxIndividualMask(uint8_t instance, flexcan_msgbuff_id_type_t id_type, uint8_t mb_idx,
+                                         uint32_t mask)
+{
+    (void)instance;
+    (void)id_type;
+    (void)mb_idx;
+    (void)mask;
+    return STATUS_SUCCESS;
+}
+
+status_t FLEXCAN_DRV_Receive(uint8_t instance, uint8_t mb_idx, flexcan_msgbuff_t *data)
+{
+    (void)instance;
+    (void)mb_idx;
+    (void)data;
+    return STATUS_SUCCESS;
+}
+
+status_t FLEXCAN_DRV_ConfigTxMb(uint8_t instance, uint8_t mb_idx, const flexcan_data_info_t *tx_info, uint32_t msg_id)
+{
+    (void)instance;
+    (void)mb_idx;
+    (void)tx_info;
+    (void)msg_id;
+    return STATUS_SUCCESS;
+}
+
+status_t FLEXCAN_DRV_Send(uint8_t instance, uint8_t mb_idx, const flexcan_data_info_t *tx_info, uint32_t msg_id,
+                          const uint8_t *mb_data)
+{
+    (void)instance;
+    test_mb[mb_idx].busy = true;
+    test_mb[mb_idx].id = msg_id;
+    test_mb[mb_idx].ext = (tx_info->msg_id_type == FLEXCAN_MSG_ID_EXT);
+    test_mb[mb_idx].len = tx_info->data_length;
+    memcpy(test_mb[mb_idx].data, mb_data, tx_info->data_length);
+    return STATUS_SUCCESS;
+}
+
+status_t FLEXCAN_DRV_AbortTransfer(uint8_t instance, uint8_t mb_idx)
+{
+    (void)instance;
+    test_mb[mb_idx].busy = false;
+    return STATUS_SUCCESS;
+}
+
+TickType_t xTaskGetTickCountFromISR(void)
+{
+    return (TickType_t)(test_now / TEST_TICK_US);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(test_now / TEST_TICK_US);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return (TaskHandle_t)1;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    (void)xTaskToNotify;
+    (void)pxHigherPriorityTaskWoken;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify)
+{
+    (void)xTaskToNotify;
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait)
+{
+    (void)xClearCountOnExit;
+    (void)xTicksToWait;
+    return 0U;
+}
+
+/* ISO-TP and the RX DMA are not part of this test */
+void isotp_init(void)
+{
+}
+
+void isotp_channel_open(uint8_t channel, const isotp_channel_config_t *config)
+{
+    (void)channel;
+    (void)config;
+}
+
+bool isotp_rx_frame(const can_lld_rx_frame_t *frame)
+{
+    (void)frame;
+    return false;
+}
+
+status_t isotp_send(uint8_t channel, const uint8_t *data, uint32_t len)
+{
+    (void)channel;
+    (void)data;
+    (void)len;
+    return STATUS_SUCCESS;
+}
+
+TickType_t isotp_step(void)
+{
+    return portMAX_DELAY;
+}
+
+status_t EDMA_DRV_ConfigLoopTransfer(uint8_t channel, const edma_transfer_config_t *transferConfig)
+{
+    (void)channel;
+    (void)transferConfig;
+    return STATUS_SUCCESS;
+}
+
+void EDMA_DRV_DisableRequestsOnTransferComplete(uint8_t channel, bool disable)
+{
+    (void)channel;
+    (void)disable;
+}
+
+void EDMA_DRV_ConfigureInterrupt(uint8_t channel, edma_channel_interrupt_t intSrc, bool enable)
+{
+    (void)channel;
+    (void)intSrc;
+    (void)enable;
+}
+
+status_t EDMA_DRV_InstallCallback(uint8_t channel, edma_callback_t callback, void *parameter)
+{
+    (void)channel;
+    (void)callback;
+    (void)parameter;
+    return STATUS_SUCCESS;
+}
+
+status_t EDMA_DRV_StartChannel(uint8_t channel)
+{
+    (void)channel;
+    return STATUS_SUCCESS;
+}
+
+status_t EDMA_DRV_StopChannel(uint8_t channel)
+{
+    (void)channel;
+    return STATUS_SUCCESS;
+}
+
+uint32_t EDMA_DRV_GetRemainingMajorIterationsCount(uint8_t channel)
+{
+    (void)channel;
+    return CAN_LLD_RX_DMA_SLOTS;
+}
+
+/* the bus */
+
+static uint32_t test_rand(uint32_t range)
+{
+    test_seed ^= test_seed << 13;
+    test_seed ^= test_seed >> 7;
+    test_seed ^= test_seed << 17;
+    return (uint32_t)(test_seed % range);
+}
+
+static void test_timer_set(void)
+{
+    test_can0.TIMER = (uint32_t)((test_now - test_timer_start) & 0xFFFFU);
+}
+
+/* @brief: The late task records the RX frames of its batch, dated back by
+ *         the FlexCAN timer like can_lld_rx_dma_get()
+ * @return: None
+ */
+static void test_drain(void)
+{
+    uint32_t age;
+    uint32_t i;
+
+    test_timer_set();
+    for (i = 0U; i < test_pend_num; i++)
+    {
+        age = (CAN0->TIMER - test_pend[i].cs) & CAN_LLD_CS_TIME_STAMP_MASK;
+        can_trace_frame(CAN_TRACE_TYPE_RX, test_pend[i].id, test_pend[i].cs, test_pend[i].data, test_pend[i].len,
+                        xTaskGetTickCount() - (age / TEST_TICK_US));
+    }
+    test_pend_num = 0U;
+    test_drain_us = test_now;
+}
+
+/* @brief: One frame slot of the fully loaded bus
+ * @return: None
+ */
+static void test_frame(void)
+{
+    test_gen_t *gen = &test_gen[test_gen_num];
+    const bool trigger = (test_gen_num == test_trigger_at);
+    uint8_t data[8];
+    uint32_t bits;
+    uint32_t stuff_max;
+    uint32_t cs;
+    uint32_t i;
+    int32_t mb = -1;
+
+    if ((test_rand(10U) == 0U) && !trigger)
+    {
+        for (i = 0U; i < 8U; i++)
+        {
+            data[i] = (uint8_t)test_rand(256U);
+        }
+        data[0] = (uint8_t)test_tx_seq++;
+        (void)can_lld_tx((test_rand(2U) != 0U) ? (0x18DA0000U | test_rand(0x10000U) | CAN_LLD_TX_ID_EXT) :
+                         (0x100U + test_rand(0x100U)), data, test_rand(9U));
+    }
+    for (i = 0U; i < 32U; i++)
+    {
+        if (test_mb[i].busy && ((mb < 0) || (test_mb[i].id < test_mb[mb].id)))
+        {
+            mb = (int32_t)i;
+        }
+    }
+
+    gen->sof = test_now;
+    if (mb >= 0)
+    {
+        gen->id = test_mb[mb].id;
+        gen->ext = test_mb[mb].ext;
+        gen->len = (uint8_t)test_mb[mb].len;
+        memcpy(gen->data, test_mb[mb].data, 8U);
+    }
+    else
+    {
+        gen->ext = (test_rand(3U) == 0U);
+        gen->id = gen->ext ? test_rand(0x20000000U) : test_rand(0x800U);
+        if (!gen->ext && (gen->id == TEST_TRIGGER_ID))
+        {
+            gen->id--;
+        }
+        if (trigger)
+        {
+            gen->ext = false;
+            gen->id = TEST_TRIGGER_ID;
+        }
+        /* bursts of empty frames, the highest frame rate the bus has */
+        gen->len = (((test_gen_num / 500U) % 4U) == 1U) ? 0U : (uint8_t)test_rand(9U);
+        for (i = 0U; i < 8U; i++)
+        {
+            gen->data[i] = (uint8_t)test_rand(256U);
+        }
+    }
+    bits = (gen->ext ? 64U : 44U) + (8U * gen->len);
+    stuff_max = (bits - 11U) / 4U;
+    bits += test_rand(stuff_max + 1U);
+    cs = (uint32_t)((gen->sof - test_timer_start) & 0xFFFFU) | ((uint32_t)gen->len << 16) |
+         (gen->ext ? CAN_LLD_CS_IDE_MASK : 0U);
+
+    test_now += bits;
+    test_timer_set();
+    if (mb >= 0)
+    {
+        test_can0.RAMn[mb * 4] = cs;
+        test_mb[mb].busy = false;
+        test_callback(INST_CANCOM1, FLEXCAN_EVENT_TX_COMPLETE, (uint32_t)mb, &canCom1_State);
+    }
+    else if (test_late)
+    {
+        test_pend[test_pend_num].id = gen->id;
+        test_pend[test_pend_num].cs = cs;
+        test_pend[test_pend_num].len = gen->len;
+        memcpy(test_pend[test_pend_num].data, gen->data, 8U);
+        test_pend_num++;
+    }
+    else
+    {
+        can_lld_rx_fifo_msg.msgId = gen->id;
+        can_lld_rx_fifo_msg.cs = cs;
+        can_lld_rx_fifo_msg.dataLen = gen->len;
+        memcpy(can_lld_rx_fifo_msg.data, gen->data, 8U);
+        test_callback(INST_CANCOM1, FLEXCAN_EVENT_RXFIFO_COMPLETE, 0U, &canCom1_State);
+    }
+    test_gen_num++;
+    test_now += TEST_IFS_BITS;
+    if (test_late && (((test_now - test_drain_us) >= TEST_DRAIN_US) || (test_pend_num >= TEST_DRAIN_NUM)))
+    {
+        test_drain();
+    }
+    /* the RX queue is emptied by the task */
+    can_lld_rx_queue_tail = can_lld_rx_queue_head;
+}
+
+/* @brief: Runs the bus until the trace stops, dumps it into a capture with
+ *         printf lines between the packets and converts it
+ * @param name : name of the run and of its files
+ * @param trigger : frames from the start to the trigger frame
+ * @return: number of frames on the bus
+ */
+static uint32_t test_run(const char *name, uint32_t trigger)
+{
+    uint8_t packet[CAN_TRACE_PACKET_MAX];
+    const uint32_t start = test_gen_num;
+    uint32_t record_num;
+    uint32_t packet_num = 0U;
+    uint32_t len = 0U;
+    uint32_t n;
+    uint32_t i;
+    char cmd[512];
+    FILE *fp;
+    int status;
+
+    test_trigger_at = start + trigger;
+    while ((can_trace_state != CAN_TRACE_STATE_STOPPED) && (test_gen_num < TEST_GEN_MAX))
+    {
+        test_frame();
+        if ((test_gen_num % 97U) == 0U)
+        {
+            test_esr1 = CAN_ESR1_ERRINT_MASK | CAN_ESR1_CRCERR_MASK;
+            test_error_callback(INST_CANCOM1, FLEXCAN_EVENT_ERROR, &canCom1_State);
+        }
+        if (((test_gen_num % 149U) == 0U) && !test_late)
+        {
+            test_callback(INST_CANCOM1, FLEXCAN_EVENT_RXFIFO_OVERFLOW, 0U, &canCom1_State);
+        }
+    }
+    TEST_CHECK(can_trace_state == CAN_TRACE_STATE_STOPPED, "%s: the trace did not stop", name);
+    if (test_late)
+    {
+        test_drain();
+    }
+    /* frames after the stop are not recorded */
+    record_num = can_trace_record_num;
+    for (i = 0U; (i < 50U) && (test_gen_num < TEST_GEN_MAX); i++)
+    {
+        test_frame();
+    }
+    if (test_late)
+    {
+        test_drain();
+    }
+    TEST_CHECK(can_trace_record_num == record_num, "%s: %u records after the stop", name,
+               can_trace_record_num - record_num);
+
+    while ((n = can_trace_dump(packet)) != 0U)
+    {
+        memcpy(&test_capture[len], packet, n);
+        len += n;
+        packet_num++;
+        if ((packet_num % 40U) == 0U)
+        {
+            len += (uint32_t)sprintf((char *)&test_capture[len], "CAN frames: %u CS text\n", packet_num);
+        }
+    }
+    snprintf(cmd, sizeof(cmd), "can_trace_test_%s.bin", name);
+    fp = fopen(cmd, "wb");
+    if (fp == NULL)
+    {
+        perror(cmd);
+        exit(2);
+    }
+    fwrite(test_capture, 1U, len, fp);
+    fclose(fp);
+    printf("%s: %u frames on the bus, %u records (%u overwritten), %u packets, %u bytes dumped\n", name,
+           test_gen_num - start, can_trace_record_num, can_trace_overwritten_num, packet_num, len);
+
+    snprintf(cmd, sizeof(cmd), "%s -b %u -o can_trace_test_%s.log can_trace_test_%s.bin 2>&1 && "
+             "%s -p -b %u -o can_trace_test_%s.pcap can_trace_test_%s.bin 2>&1", test_dump, TEST_BITRATE, name, name,
+             test_dump, TEST_BITRATE, name, name);
+    fp = popen(cmd, "r");
+    if (fp == NULL)
+    {
+        perror(test_dump);
+        exit(2);
+    }
+    while (fread(packet, 1U, sizeof(packet), fp) > 0U)
+    {
+    }
+    status = pclose(fp);
+    TEST_CHECK(WIFEXITED(status) && (WEXITSTATUS(status) == 0), "%s failed", cmd);
+    return test_gen_num - start;
+}
+
+static bool test_gen_match(uint32_t idx, uint32_t id, bool ext, const uint8_t *data, uint32_t len)
+{
+    return (test_gen[idx].id == id) && (test_gen[idx].ext == ext) && (test_gen[idx].len == len) &&
+           (memcmp(test_gen[idx].data, data, len) == 0);
+}
+
+/* @brief: Compares the candump log of a run with the bus
+ * @param name : name of the run
+ * @param from : first frame of the run on the bus
+ * @param contiguous : no frame may be missing
+ * @param jitter_max : allowed spread of the time stamp offset, us
+ * @return: number of frames in the log
+ */
+static uint32_t test_log(const char *name, uint32_t from, bool contiguous, int64_t jitter_max)
+{
+    char path[128];
+    char line[512];
+    char ifname[16];
+    char text[300];
+    uint8_t data[8];
+    unsigned long long sec;
+    unsigned long long usec;
+    unsigned int byte;
+    uint64_t time;
+    uint64_t time_last = 0U;
+    int64_t offset;
+    int64_t offset_min = INT64_MAX;
+    int64_t offset_max = INT64_MIN;
+    uint32_t first = UINT32_MAX;
+    uint32_t next = 0U;
+    uint32_t matched = 0U;
+    uint32_t error_lines = 0U;
+    uint32_t skipped = 0U;
+    uint32_t unsorted = 0U;
+    uint32_t id;
+    uint32_t len;
+    char *hash;
+    char *p;
+    bool ext;
+    FILE *fp;
+
+    snprintf(path, sizeof(path), "can_trace_test_%s.log", name);
+    fp = fopen(path, "r");
+    TEST_CHECK(fp != NULL, "%s: no log", name);
+    if (fp == NULL)
+    {
+        return 0U;
+    }
+    while (fgets(line, sizeof(line), fp) != NULL)
+    {
+        if ((sscanf(line, "(%llu.%llu) %15s %299s", &sec, &usec, ifname, text) != 4) ||
+            ((hash = strchr(text, '#')) == NULL))
+        {
+            TEST_CHECK(false, "%s: line %s", name, line);
+            continue;
+        }
+        time = (sec * 1000000ULL) + usec;
+        unsorted += (time < time_last) ? 1U : 0U;
+        time_last = time;
+        ext = ((hash - text) == 8);
+        id = (uint32_t)strtoul(text, NULL, 16);
+        if (ext && ((id & TEST_CAN_ERR_FLAG) != 0U))
+        {
+            error_lines++;
+            continue;
+        }
+        len = 0U;
+        for (p = hash + 1; (p[0] != '\0') && (p[1] != '\0') && (len < 8U); p += 2)
+        {
+            (void)sscanf(p, "%2x", &byte);
+            data[len++] = (uint8_t)byte;
+        }
+        if (first == UINT32_MAX)
+        {
+            /* the oldest frame of the ring, within a tick of its time */
+            for (next = from; next < test_gen_num; next++)
+            {
+                if (test_gen_match(next, id, ext, data, len) && ((time + 200U) > test_gen[next].sof) &&
+                    (time < (test_gen[next].sof + 200U)))
+                {
+                    break;
+                }
+            }
+            TEST_CHECK(next < test_gen_num, "%s: first frame not on the bus: %s", name, line);
+            if (next == test_gen_num)
+            {
+                break;
+            }
+            first = next;
+        }
+        while (!contiguous && (next < test_gen_num) && !test_gen_match(next, id, ext, data, len))
+        {
+            if (skipped == 0U)
+            {
+                printf("   first skipped frame %llu us after the start of the log\n",
+                       (unsigned long long)(test_gen[next].sof - test_gen[first].sof));
+            }
+            skipped++;
+            next++;
+        }
+        if ((next >= test_gen_num) || !test_gen_match(next, id, ext, data, len))
+        {
+            TEST_CHECK(false, "%s: frame %u of the log is not the next bus frame: %s", name, matched, line);
+            break;
+        }
+        offset = (int64_t)time - (int64_t)test_gen[next].sof;
+        offset_min = (offset < offset_min) ? offset : offset_min;
+        offset_max = (offset > offset_max) ? offset : offset_max;
+        matched++;
+        next++;
+    }
+    fclose(fp);
+    printf("   %u frames in the log are bus frames %u to %u in order, %u error lines, %u skipped\n", matched,
+           first - from, next - 1U - from, error_lines, skipped);
+    printf("   time stamps: log - bus = %lld to %lld us (jitter %lld us)\n", (long long)offset_min,
+           (long long)offset_max, (long long)(offset_max - offset_min));
+    TEST_CHECK(matched != 0U, "%s: no frame in the log", name);
+    TEST_CHECK(unsorted == 0U, "%s: log not sorted at %u lines", name, unsorted);
+    TEST_CHECK(error_lines != 0U, "%s: no error frame in the log", name);
+    TEST_CHECK((offset_max - offset_min) <= jitter_max, "%s: time stamps spread %lld us", name,
+               (long long)(offset_max - offset_min));
+    TEST_CHECK((offset_min >= -(int64_t)TEST_TICK_US) && (offset_max <= (int64_t)TEST_TICK_US),
+               "%s: absolute time more than a tick off", name);
+    TEST_CHECK(!contiguous || (skipped == 0U), "%s: %u frames missing", name, skipped);
+    return matched + error_lines;
+}
+
+/* @brief: Reads the pcap of a run back
+ * @param name : name of the run
+ * @param lines : lines of its candump log
+ * @return: None
+ */
+static void test_pcap(const char *name, uint32_t lines)
+{
+    char path[128];
+    uint32_t header[6];
+    uint32_t record[4];
+    uint8_t frame[8U + 64U];
+    uint32_t packet_num = 0U;
+    uint32_t eff_error = 0U;
+    uint32_t id;
+    FILE *fp;
+
+    snprintf(path, sizeof(path), "can_trace_test_%s.pcap", name);
+    fp = fopen(path, "rb");
+    TEST_CHECK((fp != NULL) && (fread(header, sizeof(header), 1U, fp) == 1U), "%s: no pcap", name);
+    if (fp == NULL)
+    {
+        return;
+    }
+    while ((fread(record, sizeof(record), 1U, fp) == 1U) && (record[2] <= sizeof(frame)) &&
+           (fread(frame, 1U, record[2], fp) == record[2]))
+    {
+        /* network byte order, EFF on 29 bit IDs */
+        id = ((uint32_t)frame[0] << 24) | ((uint32_t)frame[1] << 16) | ((uint32_t)frame[2] << 8) | frame[3];
+        if ((id & TEST_CAN_ERR_FLAG) == 0U)
+        {
+            eff_error += (((id & 0x1FFFF800U) != 0U) && ((id & TEST_CAN_EFF_FLAG) == 0U)) ? 1U : 0U;
+        }
+        packet_num++;
+    }
+    fclose(fp);
+    printf("   pcap: %u packets, link type %u\n", packet_num, header[5]);
+    TEST_CHECK(header[0] == 0xA1B2C3D4U, "%s: pcap magic %08X", name, header[0]);
+    TEST_CHECK(header[5] == LINKTYPE_CAN_SOCKETCAN, "%s: link type %u", name, header[5]);
+    TEST_CHECK(packet_num == lines, "%s: %u packets, %u log lines", name, packet_num, lines);
+    TEST_CHECK(eff_error == 0U, "%s: %u 29 bit IDs without EFF", name, eff_error);
+}
+
+int main(int argc, char **argv)
+{
+    can_trace_config_t config =
+    {
+        .id_enable = true,
+        .id = TEST_TRIGGER_ID,
+        .id_mask = CAN_LLD_TX_ID_EXT | 0x7FFU,
+        .error_mask = 0U,
+        .post_size = CAN_TRACE_BUF_SIZE / 4U
+    };
+    const uint8_t data[8] = {1U, 2U, 3U, 4U, 5U, 6U, 7U, 8U};
+    struct timespec t0;
+    struct timespec t1;
+    uint32_t from;
+    uint32_t lines;
+    uint32_t i;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "d:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'd':
+            test_dump = optarg;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-d can_trace_dump]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    test_now = 12345U;
+    can_lld_rx_dma_enable = false;
+    can_lld_init();
+    can_lld_rx_waiter = (TaskHandle_t)1;
+
+    /* the timer has wrapped many times */
+    test_now += 1000000U;
+    can_trace_arm(&config);
+    from = test_gen_num;
+    (void)test_run("irq", 30000U);
+    lines = test_log("irq", from, true, 1);
+    test_pcap("irq", lines);
+
+    test_late = true;
+    test_drain_us = test_now;
+    can_trace_arm(&config);
+    from = test_gen_num;
+    (void)test_run("late", 30000U);
+    lines = test_log("late", from, false, 1);
+    test_pcap("late", lines);
+
+    /* one offset per FlexCAN start, each within a tick */
+    test_late = false;
+    can_trace_arm(&config);
+    from = test_gen_num;
+    for (i = 0U; i < 100U; i++)
+    {
+        test_frame();
+    }
+    test_now += 777U;
+    (void)can_lld_restart(CAN_LLD_MODE_CLASSIC);
+    (void)test_run("restart", 150U);
+    lines = test_log("restart", from, true, (int64_t)TEST_TICK_US);
+    test_pcap("restart", lines);
+
+    config.id_enable = false;
+    can_trace_arm(&config);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i = 0U; i < TEST_COST_NUM; i++)
+    {
+        can_trace_frame(CAN_TRACE_TYPE_RX, 0x123U, 0x00080000U | i, data, 8U, (TickType_t)(i >> 4));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    printf("cost: %.1f ns per record on the host, %u overwritten\n",
+           (((t1.tv_sec - t0.tv_sec) * 1e9) + (t1.tv_nsec - t0.tv_nsec)) / TEST_COST_NUM, can_trace_overwritten_num);
+
+    printf("%s, %u checks, %u errors\n", (test_error == 0U) ? "PASS" : "FAIL", test_check_num, test_error);
+    return (test_error == 0U) ? 0 : 1;
+}
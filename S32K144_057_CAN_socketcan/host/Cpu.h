@@ -0,0 +1,33 @@
+#ifndef CPU_H
+#define CPU_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "status.h"
+
+/* interrupts of the S32K144 the drivers set the priority of, the host
+ * build has no NVIC and ignores them */
+typedef enum
+{
+    DMA2_IRQn = 2,
+    LPSPI1_IRQn = 27,
+    LPUART1_RxTx_IRQn = 33,
+    CAN0_ORed_IRQn = 78,
+    CAN0_Error_IRQn = 79,
+    CAN0_ORed_0_15_MB_IRQn = 81
+} IRQn_Type;
+
+/* system control block, VECTACTIVE tells an ISR from a task. The host
+ * tests keep it 0, a task */
+typedef struct
+{
+    volatile uint32_t ICSR;
+} S32_SCB_Type;
+
+#define S32_SCB_ICSR_VECTACTIVE_MASK 0x1FFu
+
+extern S32_SCB_Type *const S32_SCB;
+
+void INT_SYS_SetPriority(IRQn_Type irqNumber, uint8_t priority);
+
+#endif
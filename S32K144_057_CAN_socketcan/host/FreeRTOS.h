@@ -0,0 +1,31 @@
+#ifndef FREERTOS_H
+#define FREERTOS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* FreeRTOS subset of the host build, see freertos_host.c. The tick rate is
+ * the one of the board, the ticks follow CLOCK_MONOTONIC */
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+
+#define configTICK_RATE_HZ ((TickType_t)10000)
+#define configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY 1
+
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE ((BaseType_t)1)
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+#define pdMS_TO_TICKS(xTimeInMs) ((TickType_t)(((TickType_t)(xTimeInMs) * configTICK_RATE_HZ) / (TickType_t)1000U))
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFFUL)
+
+/* the CAN "interrupts" run in the backend thread with the critical section
+ * held, a task switch after them is the scheduler of the host */
+#define portYIELD_FROM_ISR(x) ((void)(x))
+
+void vPortEnterCritical(void);
+void vPortExitCritical(void);
+
+#endif
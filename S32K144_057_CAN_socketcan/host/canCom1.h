@@ -0,0 +1,14 @@
+#ifndef canCom1_H
+#define canCom1_H
+
+#include "dmaController1.h"
+#include "Cpu.h"
+#include "flexcan_hw_access.h"
+
+/* CAN0 of the board is the SocketCAN interface of the host build */
+#define INST_CANCOM1 (0U)
+
+extern flexcan_state_t canCom1_State;
+extern const flexcan_user_config_t canCom1_InitConfig0;
+
+#endif
@@ -0,0 +1,335 @@
+/* Benchmark of can_lld on SocketCAN: two processes, each one can_lld
+ * instance on the same interface. The echo side sends every request frame
+ * back, the measuring side gives
+ *   - the round trip latency, one request at a time, and
+ *   - the throughput, requests kept in flight up to a window,
+ * through the whole stack: TX queue, mailbox pool, RX FIFO filter, RX DMA
+ * ring or interrupt path, RX queue, on both sides.
+ *
+ * Requests are 0x100, replies 0x101, both in the filter of can_filter.def.
+ * In classic mode the RX DMA ring of can_lld only wakes the reader every
+ * half ring, it is polled every CAN_LLD_RX_DMA_POLL_MS like in
+ * freertos_task_can_rx, so its latency is the poll. -f runs both sides in
+ * CAN FD mode, where the frames come through RX mailbox interrupts.
+ *
+ * build: make (see Makefile), vcan0 up with mtu 72 for -f
+ * usage: can_bench -e [-i ifname] [-f]                 echo side
+ *        can_bench [-i ifname] [-f] [-l len] [-n pings] [-t frames] [-w window]
+ */
+#include "can_lld.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_REQUEST_ID 0x100U
+#define BENCH_REPLY_ID 0x101U
+#define BENCH_STOP_ID 0x102U
+/* a lost frame ends a phase after this */
+#define BENCH_TIMEOUT_MS 1000U
+#define BENCH_START_TIMEOUT_MS 5000U
+
+static bool fd_mode = false;
+static uint32_t frame_len = 8U;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+/* @brief: Wait for a frame as freertos_task_can_rx does, polling the RX DMA
+ *         ring while it runs
+ * @param frame : destination
+ * @param ms    : time to wait
+ * @return      : true if a frame was taken
+ */
+static bool bench_rx(can_lld_rx_frame_t *frame, uint32_t ms)
+{
+    uint64_t end = now_ns() + ((uint64_t)ms * 1000000ULL);
+    TickType_t timeout;
+
+    do
+    {
+        timeout = can_lld_rx_dma_running() ? pdMS_TO_TICKS(CAN_LLD_RX_DMA_POLL_MS) : pdMS_TO_TICKS(ms);
+        if (can_lld_rx_wait(frame, timeout))
+        {
+            return true;
+        }
+    } while (now_ns() < end);
+    return false;
+}
+
+static void bench_tx(uint32_t id, const uint8_t *data, uint32_t len)
+{
+    uint32_t flags = (fd_mode && (len <= 8U)) ? CAN_LLD_TX_ID_FD : 0U;
+
+    /* the TX queue is full only while the window is larger than it */
+    while (can_lld_tx(id | flags, data, len) == STATUS_BUSY)
+    {
+        vTaskDelay(1U);
+    }
+}
+
+static void bench_request(uint32_t seq)
+{
+    uint8_t data[CAN_LLD_PAYLOAD_MAX];
+
+    memset(data, 0x55, sizeof(data));
+    memcpy(data, &seq, sizeof(seq));
+    bench_tx(BENCH_REQUEST_ID, data, frame_len);
+}
+
+/* @brief: Sequence number of a reply
+ * @return: true for a reply
+ */
+static bool bench_reply(const can_lld_rx_frame_t *frame, uint32_t *seq)
+{
+    if ((frame->msgId != BENCH_REPLY_ID) || (frame->dataLen < sizeof(*seq)))
+    {
+        return false;
+    }
+    memcpy(seq, frame->data, sizeof(*seq));
+    return true;
+}
+
+static int bench_cmp(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+static void bench_print_counters(void)
+{
+    printf("can_lld: rx %u, tx %u, rx queue overflow %u, rx fifo overflow %u, tx queue full %u, dma halves %u\n",
+           can_lld_rx_frame_num, can_lld_tx_complete_num, can_lld_rx_queue_overflow_num,
+           can_lld_rx_fifo_overflow_num, can_lld_tx_queue_full_num, can_lld_dma_complete_num);
+    printf("backend: rejected %u, lost %u, tx retries %u\n",
+           flexcan_host_rx_reject_num, flexcan_host_rx_lost_num, flexcan_host_tx_retry_num);
+}
+
+static int bench_echo(void)
+{
+    can_lld_rx_frame_t frame;
+    uint32_t num = 0U;
+
+    printf("echo on, %s mode, rx path %s\n", fd_mode ? "FD" : "classic",
+           can_lld_rx_dma_running() ? "DMA ring" : "interrupt");
+    fflush(stdout);
+    for (;;)
+    {
+        if (!bench_rx(&frame, BENCH_TIMEOUT_MS))
+        {
+            continue;
+        }
+        if (frame.msgId == BENCH_STOP_ID)
+        {
+            break;
+        }
+        if (frame.msgId == BENCH_REQUEST_ID)
+        {
+            bench_tx(BENCH_REPLY_ID, frame.data, frame.dataLen);
+            num++;
+        }
+    }
+    printf("echo: %u frames sent back\n", num);
+    bench_print_counters();
+    return 0;
+}
+
+/* @brief: One request at a time, the first ones wait for the echo side
+ * @param num : requests
+ * @return    : 0, 1 if the echo side does not answer
+ */
+static int bench_latency(uint32_t num)
+{
+    can_lld_rx_frame_t frame;
+    uint64_t *rtt = calloc(num, sizeof(uint64_t));
+    uint64_t first = now_ns();
+    uint64_t start;
+    uint64_t sum = 0U;
+    uint32_t seq = 0U;
+    uint32_t got;
+    uint32_t done = 0U;
+    uint32_t lost = 0U;
+    bool answered = false;
+
+    if (rtt == NULL)
+    {
+        return 1;
+    }
+    while (done < num)
+    {
+        start = now_ns();
+        bench_request(seq);
+        for (;;)
+        {
+            if (!bench_rx(&frame, answered ? BENCH_TIMEOUT_MS : 100U))
+            {
+                if (answered && (++lost >= 10U))
+                {
+                    fprintf(stderr, "the echo side stopped answering\n");
+                    free(rtt);
+                    return 1;
+                }
+                if (!answered && ((now_ns() - first) > (BENCH_START_TIMEOUT_MS * 1000000ULL)))
+                {
+                    fprintf(stderr, "no answer, is can_bench -e running?\n");
+                    free(rtt);
+                    return 1;
+                }
+                break;
+            }
+            if (bench_reply(&frame, &got) && (got == seq))
+            {
+                if (answered)
+                {
+                    rtt[done++] = now_ns() - start;
+                }
+                answered = true;
+                break;
+            }
+        }
+        seq++;
+    }
+
+    qsort(rtt, num, sizeof(uint64_t), bench_cmp);
+    for (done = 0U; done < num; done++)
+    {
+        sum += rtt[done];
+    }
+    printf("round trip of %u frames, %u data bytes: min %.1f us, median %.1f us, 99%% %.1f us, max %.1f us, "
+           "mean %.1f us, lost %u\n",
+           num, frame_len, rtt[0] / 1000.0, rtt[num / 2U] / 1000.0, rtt[(num * 99U) / 100U] / 1000.0,
+           rtt[num - 1U] / 1000.0, (sum / (double)num) / 1000.0, lost);
+    free(rtt);
+    return 0;
+}
+
+/* @brief: Requests kept in flight up to the window until num replies came
+ * @param num    : requests
+ * @param window : requests in flight
+ * @return       : 0
+ */
+static int bench_throughput(uint32_t num, uint32_t window)
+{
+    can_lld_rx_frame_t frame;
+    uint64_t start = now_ns();
+    uint64_t elapsed;
+    uint32_t sent = 0U;
+    uint32_t received = 0U;
+    uint32_t expected = 0U;
+    uint32_t order = 0U;
+    uint32_t got;
+
+    while (received < num)
+    {
+        while ((sent < num) && ((sent - received) < window))
+        {
+            bench_request(sent++);
+        }
+        if (!bench_rx(&frame, BENCH_TIMEOUT_MS))
+        {
+            break;
+        }
+        if (bench_reply(&frame, &got))
+        {
+            if (got != expected)
+            {
+                order++;
+            }
+            expected = got + 1U;
+            received++;
+        }
+    }
+    elapsed = now_ns() - start;
+
+    printf("throughput: %u of %u requests answered in %.3f s, window %u: %.0f round trips/s, "
+           "%.0f frames/s on the bus, %u out of order\n",
+           received, num, elapsed / 1e9, window, received / (elapsed / 1e9), (2.0 * received) / (elapsed / 1e9),
+           order);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t pings = 1000U;
+    uint32_t frames = 20000U;
+    uint32_t window = 16U;
+    bool echo = false;
+    bool len_set = false;
+    int opt;
+    int ret;
+
+    while ((opt = getopt(argc, argv, "efi:l:n:t:w:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'e':
+            echo = true;
+            break;
+        case 'f':
+            fd_mode = true;
+            break;
+        case 'i':
+            flexcan_host_set_ifname(optarg);
+            break;
+        case 'l':
+            frame_len = (uint32_t)strtoul(optarg, NULL, 0);
+            len_set = true;
+            break;
+        case 'n':
+            pings = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 't':
+            frames = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'w':
+            window = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "usage: can_bench -e [-i ifname] [-f]\n"
+                            "       can_bench [-i ifname] [-f] [-l len] [-n pings] [-t frames] [-w window]\n");
+            return 2;
+        }
+    }
+    if (!len_set && fd_mode)
+    {
+        frame_len = CAN_LLD_PAYLOAD_MAX;
+    }
+    if ((frame_len < 4U) || (frame_len > (fd_mode ? CAN_LLD_PAYLOAD_MAX : 8U)) || (pings == 0U) || (window == 0U))
+    {
+        fprintf(stderr, "bad length, pings or window\n");
+        return 2;
+    }
+
+    can_lld_init();
+    if (fd_mode && (can_lld_set_mode(CAN_LLD_MODE_FD) != STATUS_SUCCESS))
+    {
+        fprintf(stderr, "CAN FD mode failed\n");
+        return 1;
+    }
+    if (echo)
+    {
+        return bench_echo();
+    }
+
+    printf("%s mode, rx path %s\n", fd_mode ? "FD" : "classic", can_lld_rx_dma_running() ? "DMA ring" : "interrupt");
+    ret = bench_latency(pings);
+    if (ret == 0)
+    {
+        ret = bench_throughput(frames, window);
+    }
+    bench_tx(BENCH_STOP_ID, (const uint8_t *)"stop", 4U);
+    while (can_lld_tx_pending() != 0U)
+    {
+        vTaskDelay(pdMS_TO_TICKS(1U));
+    }
+    bench_print_counters();
+    return ret;
+}
@@ -0,0 +1,88 @@
+#ifndef dmaController1_H
+#define dmaController1_H
+
+#include "Cpu.h"
+
+/* eDMA of the host build, only the loop transfer the RX FIFO of can_lld
+ * uses. flexcan_socketcan.c moves the RX FIFO entries into the ring */
+#define EDMA_CHN0_NUMBER 0U
+#define EDMA_CHN1_NUMBER 1U
+#define EDMA_CHN2_NUMBER 2U
+#define EDMA_CONFIGURED_CHANNELS_COUNT 3U
+
+typedef enum
+{
+    EDMA_TRANSFER_SIZE_1B = 0x0U,
+    EDMA_TRANSFER_SIZE_2B = 0x1U,
+    EDMA_TRANSFER_SIZE_4B = 0x2U,
+    EDMA_TRANSFER_SIZE_16B = 0x4U,
+    EDMA_TRANSFER_SIZE_32B = 0x5U
+} edma_transfer_size_t;
+
+typedef enum
+{
+    EDMA_MODULO_OFF = 0U,
+    EDMA_MODULO_2B,
+    EDMA_MODULO_4B,
+    EDMA_MODULO_8B,
+    EDMA_MODULO_16B,
+    EDMA_MODULO_32B
+} edma_modulo_t;
+
+typedef enum
+{
+    EDMA_CHN_ERR_INT = 0U,
+    EDMA_CHN_HALF_MAJOR_LOOP_INT,
+    EDMA_CHN_MAJOR_LOOP_INT
+} edma_channel_interrupt_t;
+
+typedef enum
+{
+    EDMA_CHN_NORMAL = 0U,
+    EDMA_CHN_ERROR
+} edma_chn_status_t;
+
+typedef void (*edma_callback_t)(void *parameter, edma_chn_status_t status);
+
+typedef struct
+{
+    uint32_t majorLoopIterationCount;
+    bool srcOffsetEnable;
+    bool dstOffsetEnable;
+    int32_t minorLoopOffset;
+    bool minorLoopChnLinkEnable;
+    uint8_t minorLoopChnLinkNumber;
+    bool majorLoopChnLinkEnable;
+    uint8_t majorLoopChnLinkNumber;
+} edma_loop_transfer_config_t;
+
+/* the addresses are 32 bit like on the board, the host build is linked
+ * without PIE so that the static buffers of can_lld have such addresses */
+typedef struct
+{
+    uint32_t srcAddr;
+    uint32_t destAddr;
+    edma_transfer_size_t srcTransferSize;
+    edma_transfer_size_t destTransferSize;
+    int16_t srcOffset;
+    int16_t destOffset;
+    int32_t srcLastAddrAdjust;
+    int32_t destLastAddrAdjust;
+    edma_modulo_t srcModulo;
+    edma_modulo_t destModulo;
+    uint32_t minorByteTransferCount;
+    bool scatterGatherEnable;
+    uint32_t scatterGatherNextDescAddr;
+    bool interruptEnable;
+    edma_loop_transfer_config_t *loopTransferConfig;
+} edma_transfer_config_t;
+
+status_t EDMA_DRV_ConfigLoopTransfer(uint8_t virtualChannel, const edma_transfer_config_t *transferConfig);
+void EDMA_DRV_DisableRequestsOnTransferComplete(uint8_t virtualChannel, bool disable);
+void EDMA_DRV_ConfigureInterrupt(uint8_t virtualChannel, edma_channel_interrupt_t intSrc, bool enable);
+status_t EDMA_DRV_InstallCallback(uint8_t virtualChannel, edma_callback_t callback, void *parameter);
+status_t EDMA_DRV_StartChannel(uint8_t virtualChannel);
+status_t EDMA_DRV_StopChannel(uint8_t virtualChannel);
+uint32_t EDMA_DRV_GetRemainingMajorIterationsCount(uint8_t virtualChannel);
+
+#endif
@@ -0,0 +1,282 @@
+#ifndef FLEXCAN_HW_ACCESS_H
+#define FLEXCAN_HW_ACCESS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "status.h"
+
+/* FlexCAN driver API of the S32 SDK as far as can_lld uses it, implemented
+ * by flexcan_socketcan.c on a Linux SocketCAN interface. The types and
+ * register masks are the ones of the SDK and of S32K144.h */
+
+/* CAN0 registers. CAN0 refreshes TIMER from the host clock at the nominal
+ * bitrate and applies the write 1 to clear of the ESR1 flags written since
+ * the last access, so register code of can_lld runs as it is */
+typedef struct
+{
+    volatile uint32_t MCR;
+    volatile uint32_t CTRL1;
+    volatile uint32_t TIMER;
+    volatile uint32_t RXMGMASK;
+    volatile uint32_t RX14MASK;
+    volatile uint32_t RX15MASK;
+    volatile uint32_t ECR;
+    volatile uint32_t ESR1;
+    volatile uint32_t IMASK1;
+    volatile uint32_t IFLAG1;
+    volatile uint32_t CTRL2;
+    volatile uint32_t ESR2;
+    volatile uint32_t CRCR;
+    volatile uint32_t RXFGMASK;
+    volatile uint32_t RXFIR;
+    volatile uint32_t CBT;
+    volatile uint32_t RAMn[128];
+    volatile uint32_t RXIMR[32];
+    volatile uint32_t CTRL1_PN;
+    volatile uint32_t FDCTRL;
+    volatile uint32_t FDCBT;
+    volatile uint32_t FDCRC;
+} CAN_Type;
+
+CAN_Type *flexcan_host_regs(void);
+#define CAN0 (flexcan_host_regs())
+
+/* SocketCAN interface, call before the first FLEXCAN_DRV_Init() */
+void flexcan_host_set_ifname(const char *name);
+/* frames no filter accepted, frames a full RX FIFO or a mailbox not read
+ * yet lost, writes the interface queue refused */
+extern uint32_t flexcan_host_rx_reject_num;
+extern uint32_t flexcan_host_rx_lost_num;
+extern uint32_t flexcan_host_tx_retry_num;
+
+#define CAN_MCR_IRMQ_MASK 0x10000U
+#define CAN_MCR_DMA_MASK 0x8000U
+#define CAN_MCR_FDEN_MASK 0x800U
+#define CAN_MCR_RFEN_MASK 0x20000000U
+#define CAN_MCR_FRZ_MASK 0x40000000U
+#define CAN_MCR_MDIS_MASK 0x80000000U
+#define CAN_CTRL1_BOFFREC_MASK 0x40U
+#define CAN_CTRL2_BOFFDONEMSK_MASK 0x40000000U
+#define CAN_ECR_TXERRCNT_MASK 0xFFU
+#define CAN_ECR_TXERRCNT_SHIFT 0U
+#define CAN_ECR_RXERRCNT_MASK 0xFF00U
+#define CAN_ECR_RXERRCNT_SHIFT 8U
+#define CAN_ESR1_ERRINT_MASK 0x2U
+#define CAN_ESR1_ERRINT_SHIFT 1U
+#define CAN_ESR1_BOFFINT_MASK 0x4U
+#define CAN_ESR1_BOFFINT_SHIFT 2U
+#define CAN_ESR1_FLTCONF_MASK 0x30U
+#define CAN_ESR1_FLTCONF_SHIFT 4U
+#define CAN_ESR1_RXWRN_MASK 0x100U
+#define CAN_ESR1_TXWRN_MASK 0x200U
+#define CAN_ESR1_STFERR_MASK 0x400U
+#define CAN_ESR1_FRMERR_MASK 0x800U
+#define CAN_ESR1_CRCERR_MASK 0x1000U
+#define CAN_ESR1_ACKERR_MASK 0x2000U
+#define CAN_ESR1_BIT0ERR_MASK 0x4000U
+#define CAN_ESR1_BIT1ERR_MASK 0x8000U
+#define CAN_ESR1_RWRNINT_MASK 0x10000U
+#define CAN_ESR1_TWRNINT_MASK 0x20000U
+#define CAN_ESR1_BOFFDONEINT_MASK 0x80000U
+#define CAN_ESR1_ERRINT_FAST_MASK 0x100000U
+#define CAN_ESR1_ERROVR_MASK 0x200000U
+#define CAN_ESR1_STFERR_FAST_MASK 0x4000000U
+#define CAN_ESR1_FRMERR_FAST_MASK 0x8000000U
+#define CAN_ESR1_CRCERR_FAST_MASK 0x10000000U
+#define CAN_ESR1_BIT0ERR_FAST_MASK 0x40000000U
+#define CAN_ESR1_BIT1ERR_FAST_MASK 0x80000000U
+
+typedef enum
+{
+    FLEXCAN_MSG_ID_STD,
+    FLEXCAN_MSG_ID_EXT
+} flexcan_msgbuff_id_type_t;
+
+typedef enum
+{
+    FLEXCAN_EVENT_RX_COMPLETE,
+    FLEXCAN_EVENT_RXFIFO_COMPLETE,
+    FLEXCAN_EVENT_RXFIFO_WARNING,
+    FLEXCAN_EVENT_RXFIFO_OVERFLOW,
+    FLEXCAN_EVENT_TX_COMPLETE,
+    FLEXCAN_EVENT_WAKEUP_TIMEOUT,
+    FLEXCAN_EVENT_WAKEUP_MATCH,
+    FLEXCAN_EVENT_SELF_WAKEUP,
+    FLEXCAN_EVENT_DMA_COMPLETE,
+    FLEXCAN_EVENT_DMA_ERROR,
+    FLEXCAN_EVENT_ERROR
+} flexcan_event_type_t;
+
+typedef enum
+{
+    FLEXCAN_RX_FIFO_ID_FORMAT_A,
+    FLEXCAN_RX_FIFO_ID_FORMAT_B,
+    FLEXCAN_RX_FIFO_ID_FORMAT_C,
+    FLEXCAN_RX_FIFO_ID_FORMAT_D
+} flexcan_rx_fifo_id_element_format_t;
+
+typedef enum
+{
+    FLEXCAN_RX_FIFO_ID_FILTERS_8 = 0x0,
+    FLEXCAN_RX_FIFO_ID_FILTERS_16 = 0x1,
+    FLEXCAN_RX_FIFO_ID_FILTERS_24 = 0x2,
+    FLEXCAN_RX_FIFO_ID_FILTERS_32 = 0x3,
+    FLEXCAN_RX_FIFO_ID_FILTERS_40 = 0x4,
+    FLEXCAN_RX_FIFO_ID_FILTERS_48 = 0x5,
+    FLEXCAN_RX_FIFO_ID_FILTERS_56 = 0x6,
+    FLEXCAN_RX_FIFO_ID_FILTERS_64 = 0x7,
+    FLEXCAN_RX_FIFO_ID_FILTERS_72 = 0x8,
+    FLEXCAN_RX_FIFO_ID_FILTERS_80 = 0x9,
+    FLEXCAN_RX_FIFO_ID_FILTERS_88 = 0xA,
+    FLEXCAN_RX_FIFO_ID_FILTERS_96 = 0xB,
+    FLEXCAN_RX_FIFO_ID_FILTERS_104 = 0xC,
+    FLEXCAN_RX_FIFO_ID_FILTERS_112 = 0xD,
+    FLEXCAN_RX_FIFO_ID_FILTERS_120 = 0xE,
+    FLEXCAN_RX_FIFO_ID_FILTERS_128 = 0xF
+} flexcan_rx_fifo_id_filter_num_t;
+
+typedef enum
+{
+    FLEXCAN_RXFIFO_USING_INTERRUPTS,
+    FLEXCAN_RXFIFO_USING_DMA
+} flexcan_rxfifo_transfer_type_t;
+
+typedef enum
+{
+    FLEXCAN_RX_MASK_GLOBAL,
+    FLEXCAN_RX_MASK_INDIVIDUAL
+} flexcan_rx_mask_type_t;
+
+typedef enum
+{
+    FLEXCAN_PAYLOAD_SIZE_8 = 0,
+    FLEXCAN_PAYLOAD_SIZE_16,
+    FLEXCAN_PAYLOAD_SIZE_32,
+    FLEXCAN_PAYLOAD_SIZE_64
+} flexcan_fd_payload_size_t;
+
+typedef enum
+{
+    FLEXCAN_NORMAL_MODE,
+    FLEXCAN_LISTEN_ONLY_MODE,
+    FLEXCAN_LOOPBACK_MODE,
+    FLEXCAN_FREEZE_MODE,
+    FLEXCAN_DISABLE_MODE
+} flexcan_operation_modes_t;
+
+typedef enum
+{
+    FLEXCAN_CLK_SOURCE_OSC = 0U,
+    FLEXCAN_CLK_SOURCE_PERIPH = 1U
+} flexcan_clk_source_t;
+
+typedef enum
+{
+    FLEXCAN_MB_IDLE,
+    FLEXCAN_MB_RX_BUSY,
+    FLEXCAN_MB_TX_BUSY,
+    FLEXCAN_MB_DMA_ERROR
+} flexcan_mb_state_t;
+
+typedef struct
+{
+    uint32_t cs;
+    uint32_t msgId;
+    uint8_t data[64];
+    uint8_t dataLen;
+} flexcan_msgbuff_t;
+
+typedef struct
+{
+    flexcan_msgbuff_id_type_t msg_id_type;
+    uint32_t data_length;
+    bool fd_enable;
+    uint8_t fd_padding;
+    bool enable_brs;
+    bool is_remote;
+} flexcan_data_info_t;
+
+typedef struct
+{
+    bool isRemoteFrame;
+    bool isExtendedFrame;
+    uint32_t id;
+} flexcan_id_table_t;
+
+typedef struct
+{
+    uint32_t propSeg;
+    uint32_t phaseSeg1;
+    uint32_t phaseSeg2;
+    uint32_t preDivider;
+    uint32_t rJumpwidth;
+} flexcan_time_segment_t;
+
+typedef struct
+{
+    uint32_t max_num_mb;
+    flexcan_rx_fifo_id_filter_num_t num_id_filters;
+    bool is_rx_fifo_needed;
+    flexcan_operation_modes_t flexcanMode;
+    flexcan_fd_payload_size_t payload;
+    bool fd_enable;
+    flexcan_clk_source_t pe_clock;
+    flexcan_time_segment_t bitrate;
+    flexcan_time_segment_t bitrate_cbt;
+    flexcan_rxfifo_transfer_type_t transfer_type;
+    uint8_t rxFifoDMAChannel;
+} flexcan_user_config_t;
+
+struct FlexCANState;
+
+typedef void (*flexcan_callback_t)(uint8_t instance, flexcan_event_type_t eventType,
+                                   uint32_t buffIdx, struct FlexCANState *driverState);
+typedef void (*flexcan_error_callback_t)(uint8_t instance, flexcan_event_type_t eventType,
+                                         struct FlexCANState *driverState);
+
+typedef struct
+{
+    flexcan_msgbuff_t *mb_message;
+    volatile flexcan_mb_state_t state;
+    bool isBlocking;
+    bool isRemote;
+} flexcan_mb_handle_t;
+
+typedef struct FlexCANState
+{
+    flexcan_mb_handle_t mbs[32];
+    void (*callback)(uint8_t instance, flexcan_event_type_t eventType,
+                     uint32_t buffIdx, struct FlexCANState *driverState);
+    void *callbackParam;
+    void (*error_callback)(uint8_t instance, flexcan_event_type_t eventType,
+                           struct FlexCANState *driverState);
+    void *errorCallbackParam;
+    uint8_t rxFifoDMAChannel;
+    flexcan_rxfifo_transfer_type_t transferType;
+} flexcan_state_t;
+
+void FLEXCAN_DRV_GetDefaultConfig(flexcan_user_config_t *config);
+status_t FLEXCAN_DRV_Init(uint8_t instance, flexcan_state_t *state, const flexcan_user_config_t *data);
+status_t FLEXCAN_DRV_Deinit(uint8_t instance);
+void FLEXCAN_DRV_SetTDCOffset(uint8_t instance, bool enable, uint8_t offset);
+status_t FLEXCAN_DRV_ConfigTxMb(uint8_t instance, uint8_t mb_idx, const flexcan_data_info_t *tx_info, uint32_t msg_id);
+status_t FLEXCAN_DRV_Send(uint8_t instance, uint8_t mb_idx, const flexcan_data_info_t *tx_info, uint32_t msg_id,
+                          const uint8_t *mb_data);
+status_t FLEXCAN_DRV_AbortTransfer(uint8_t instance, uint8_t mb_idx);
+status_t FLEXCAN_DRV_ConfigRxMb(uint8_t instance, uint8_t mb_idx, const flexcan_data_info_t *rx_info, uint32_t msg_id);
+status_t FLEXCAN_DRV_Receive(uint8_t instance, uint8_t mb_idx, flexcan_msgbuff_t *data);
+void FLEXCAN_DRV_ConfigRxFifo(uint8_t instance, flexcan_rx_fifo_id_element_format_t id_format,
+                              const flexcan_id_table_t *id_filter_table);
+status_t FLEXCAN_DRV_RxFifo(uint8_t instance, flexcan_msgbuff_t *data);
+void FLEXCAN_DRV_SetRxFifoGlobalMask(uint8_t instance, flexcan_msgbuff_id_type_t id_type, uint32_t mask);
+void FLEXCAN_DRV_SetRxMaskType(uint8_t instance, flexcan_rx_mask_type_t type);
+status_t FLEXCAN_DRV_SetRxIndividualMask(uint8_t instance, flexcan_msgbuff_id_type_t id_type, uint8_t mb_idx,
+                                         uint32_t mask);
+void FLEXCAN_DRV_InstallEventCallback(uint8_t instance, flexcan_callback_t callback, void *callbackParam);
+void FLEXCAN_DRV_InstallErrorCallback(uint8_t instance, flexcan_error_callback_t callback, void *callbackParam);
+uint32_t FLEXCAN_DRV_GetErrorStatus(uint8_t instance);
+void FLEXCAN_EnterFreezeMode(CAN_Type *base);
+void FLEXCAN_ExitFreezeMode(CAN_Type *base);
+void FLEXCAN_ClearErrIntStatusFlag(CAN_Type *base);
+
+#endif
@@ -0,0 +1,1317 @@
+#define _GNU_SOURCE
+#include "canCom1.h"
+#include "dmaController1.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <linux/can.h>
+#include <linux/can/error.h>
+#include <linux/can/raw.h>
+
+/* FlexCAN driver and eDMA channel of the host build on a SocketCAN raw
+ * socket, vcan works without hardware:
+ *   ip link add dev vcan0 type vcan && ip link set vcan0 mtu 72 up
+ * The interface is CAN_HOST_IFNAME or vcan0, or flexcan_host_set_ifname().
+ *
+ * The backend thread is the CAN interrupt. It waits on the socket and runs
+ * the driver callbacks inside the critical section of freertos_host.c, so
+ * can_lld sees them as it sees the FlexCAN interrupts on the board.
+ *
+ * RX: a frame goes through the RX FIFO ID filter table with the RXIMR or
+ * RXFGMASK masks (formats A, B and C) first and then to the first RX mailbox
+ * its ID and individual mask match, IDE always compared. The FIFO is 6
+ * frames deep with the warning at 5 and the overflow, with MCR[DMA] the eDMA
+ * channel empties it into the ring of EDMA_DRV_ConfigLoopTransfer().
+ * TX: the bus carries one frame at a time. The pending mailbox with the
+ * lowest ID wins, the lower mailbox on equal IDs (CTRL1[LBUF] = 0), and is
+ * written to the socket. Its own copy comes back with MSG_CONFIRM, that is
+ * TX_COMPLETE and the CS word gets its time stamp. An abort of the frame on
+ * the wire fails, it goes out and its confirmation is dropped.
+ * Errors: error frames of a real interface set the ESR1 bits, the error
+ * callback follows. Bus off recovery is the one of the interface
+ * (restart-ms), CTRL1[BOFFREC] is not looked at.
+ * TIMER counts nominal bits of the configured bitrate on the host clock */
+
+#define FLEXCAN_HOST_IFNAME_DEFAULT "vcan0"
+#define FLEXCAN_HOST_PE_CLOCK 8000000U
+#define FLEXCAN_HOST_MB_NUM 32U
+#define FLEXCAN_HOST_FIFO_DEPTH 6U
+#define FLEXCAN_HOST_FIFO_WARNING 5U
+#define FLEXCAN_HOST_FILTER_MAX 128U
+/* frames handled per turn of the backend thread before the tasks may take
+ * the critical section again */
+#define FLEXCAN_HOST_RX_BURST 32U
+#define FLEXCAN_HOST_POLL_MS 100
+
+/* CS word of a mailbox */
+#define FLEXCAN_HOST_CS_EDL 0x80000000U
+#define FLEXCAN_HOST_CS_BRS 0x40000000U
+#define FLEXCAN_HOST_CS_CODE_SHIFT 24U
+#define FLEXCAN_HOST_CS_SRR 0x00400000U
+#define FLEXCAN_HOST_CS_IDE 0x00200000U
+#define FLEXCAN_HOST_CS_RTR 0x00100000U
+#define FLEXCAN_HOST_CS_DLC_SHIFT 16U
+#define FLEXCAN_HOST_CODE_RX_FULL 0x2U
+#define FLEXCAN_HOST_CODE_TX_INACTIVE 0x8U
+#define FLEXCAN_HOST_ID_STD_SHIFT 18U
+#define FLEXCAN_HOST_ID_MASK 0x1FFFFFFFU
+
+/* ESR1 flags the error callback is run for and cleared after, and the
+ * error bits a read clears */
+#define FLEXCAN_HOST_ESR1_INT (CAN_ESR1_ERRINT_MASK | CAN_ESR1_BOFFINT_MASK | CAN_ESR1_RWRNINT_MASK | \
+                               CAN_ESR1_TWRNINT_MASK | CAN_ESR1_BOFFDONEINT_MASK | CAN_ESR1_ERRINT_FAST_MASK)
+#define FLEXCAN_HOST_ESR1_W1C (FLEXCAN_HOST_ESR1_INT | CAN_ESR1_ERROVR_MASK)
+#define FLEXCAN_HOST_ESR1_ERR 0xDC00FC00U
+/* the backend is always in step with the bus. The bit is never written, a
+ * written ESR1 thus always differs from the last value read */
+#define FLEXCAN_HOST_ESR1_SYNCH 0x40000U
+#define FLEXCAN_HOST_ESR1_FLTCONF_PASSIVE (1U << CAN_ESR1_FLTCONF_SHIFT)
+#define FLEXCAN_HOST_ESR1_FLTCONF_BUS_OFF (2U << CAN_ESR1_FLTCONF_SHIFT)
+
+typedef enum
+{
+    FLEXCAN_HOST_MB_INACTIVE = 0,
+    FLEXCAN_HOST_MB_RX,
+    FLEXCAN_HOST_MB_TX_PENDING,
+    FLEXCAN_HOST_MB_TX_WIRE
+} flexcan_host_mb_code_t;
+
+typedef struct
+{
+    flexcan_host_mb_code_t code;
+    bool ext;
+    uint32_t id;
+    /* RX: armed by FLEXCAN_DRV_Receive() */
+    flexcan_msgbuff_t *msg;
+    /* TX frame */
+    struct canfd_frame frame;
+    bool fd;
+} flexcan_host_mb_t;
+
+typedef struct
+{
+    bool configured;
+    bool started;
+    uint8_t *dest;
+    uint32_t count;
+    uint32_t pos;
+    uint32_t remaining;
+    edma_callback_t callback;
+    void *parameter;
+} flexcan_host_dma_t;
+
+uint32_t flexcan_host_rx_reject_num;
+uint32_t flexcan_host_rx_lost_num;
+uint32_t flexcan_host_tx_retry_num;
+
+static const char *flexcan_host_ifname = NULL;
+static int flexcan_host_fd = -1;
+static bool flexcan_host_fd_capable = false;
+static bool flexcan_host_thread_started = false;
+static pthread_t flexcan_host_thread;
+
+/* everything below is used inside the critical section */
+static CAN_Type flexcan_host_can0;
+static uint32_t flexcan_host_esr1 = 0U;
+static bool flexcan_host_running = false;
+static flexcan_state_t *flexcan_host_state = NULL;
+static flexcan_user_config_t flexcan_host_config;
+static uint32_t flexcan_host_bitrate = 500000U;
+static uint32_t flexcan_host_mb_words = 4U;
+static struct timespec flexcan_host_epoch;
+static flexcan_rx_mask_type_t flexcan_host_mask_type = FLEXCAN_RX_MASK_GLOBAL;
+static flexcan_host_mb_t flexcan_host_mb[FLEXCAN_HOST_MB_NUM];
+
+static bool flexcan_host_fifo_enable = false;
+static flexcan_rx_fifo_id_element_format_t flexcan_host_fifo_format = FLEXCAN_RX_FIFO_ID_FORMAT_A;
+static uint32_t flexcan_host_fifo_filter[FLEXCAN_HOST_FILTER_MAX];
+static uint32_t flexcan_host_fifo_element_num = 0U;
+static flexcan_msgbuff_t flexcan_host_fifo[FLEXCAN_HOST_FIFO_DEPTH];
+static uint32_t flexcan_host_fifo_id[FLEXCAN_HOST_FIFO_DEPTH];
+static uint32_t flexcan_host_fifo_head = 0U;
+static uint32_t flexcan_host_fifo_num = 0U;
+static flexcan_msgbuff_t *flexcan_host_fifo_msg = NULL;
+
+/* the frame on the bus, its confirmation is still to come */
+static bool flexcan_host_wire_busy = false;
+static bool flexcan_host_wire_dropped = false;
+static uint8_t flexcan_host_wire_mb = 0U;
+static bool flexcan_host_tx_blocked = false;
+
+static flexcan_host_dma_t flexcan_host_dma;
+
+static const uint8_t flexcan_host_dlc_len[16] = {0U, 1U, 2U, 3U, 4U, 5U, 6U, 7U, 8U, 12U, 16U, 20U, 24U, 32U, 48U, 64U};
+
+static void flexcan_host_sync(void);
+static uint16_t flexcan_host_timer(void);
+static status_t flexcan_host_open(bool fd);
+static void *flexcan_host_main(void *arg);
+static void flexcan_host_rx_all(void);
+static void flexcan_host_rx_frame(const struct canfd_frame *frame, bool fd);
+static void flexcan_host_error_frame(const struct canfd_frame *frame);
+static void flexcan_host_confirm(void);
+static void flexcan_host_tx_start(void);
+static uint32_t flexcan_host_key(const struct canfd_frame *frame);
+static uint8_t flexcan_host_len_to_dlc(uint32_t len);
+static void flexcan_host_msg(const struct canfd_frame *frame, bool fd, uint32_t code, flexcan_msgbuff_t *msg);
+static bool flexcan_host_fifo_accept(const struct canfd_frame *frame);
+static uint32_t flexcan_host_fifo_word(const flexcan_id_table_t *entry, uint32_t slot);
+static void flexcan_host_fifo_drain(void);
+static void flexcan_host_dma_write(const flexcan_msgbuff_t *msg, uint32_t id);
+static void flexcan_host_event(flexcan_event_type_t event, uint32_t buffIdx);
+
+/* @brief: SocketCAN interface of the next FLEXCAN_DRV_Init(), before
+ *         can_lld_init()
+ * @param name : interface name, e.g. vcan0
+ * @return     : None
+ */
+void flexcan_host_set_ifname(const char *name)
+{
+    flexcan_host_ifname = name;
+}
+
+CAN_Type *flexcan_host_regs(void)
+{
+    vPortEnterCritical();
+    flexcan_host_sync();
+    vPortExitCritical();
+    return &flexcan_host_can0;
+}
+
+/* @brief: Bring the register block up to date: TIMER from the host clock and
+ *         the ESR1 flags written 1 since the last access cleared
+ * @return: None
+ */
+static void flexcan_host_sync(void)
+{
+    uint32_t written = flexcan_host_can0.ESR1;
+
+    if (written != (flexcan_host_esr1 | FLEXCAN_HOST_ESR1_SYNCH))
+    {
+        flexcan_host_esr1 &= ~(written & FLEXCAN_HOST_ESR1_W1C);
+    }
+    flexcan_host_can0.ESR1 = flexcan_host_esr1 | FLEXCAN_HOST_ESR1_SYNCH;
+    if (flexcan_host_running)
+    {
+        flexcan_host_can0.TIMER = flexcan_host_timer();
+    }
+}
+
+/* @brief: FlexCAN timer, nominal bits since FLEXCAN_DRV_Init()
+ * @return: timer, 16 bits
+ */
+static uint16_t flexcan_host_timer(void)
+{
+    struct timespec now;
+    uint64_t ns;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    ns = ((uint64_t)(now.tv_sec - flexcan_host_epoch.tv_sec) * 1000000000ULL) +
+         (uint64_t)now.tv_nsec - (uint64_t)flexcan_host_epoch.tv_nsec;
+    return (uint16_t)((ns * flexcan_host_bitrate) / 1000000000ULL);
+}
+
+void FLEXCAN_DRV_GetDefaultConfig(flexcan_user_config_t *config)
+{
+    memset(config, 0, sizeof(*config));
+    config->max_num_mb = 16U;
+    config->num_id_filters = FLEXCAN_RX_FIFO_ID_FILTERS_8;
+    config->is_rx_fifo_needed = false;
+    config->flexcanMode = FLEXCAN_NORMAL_MODE;
+    config->payload = FLEXCAN_PAYLOAD_SIZE_8;
+    config->fd_enable = false;
+    config->pe_clock = FLEXCAN_CLK_SOURCE_OSC;
+    config->bitrate.propSeg = 7U;
+    config->bitrate.phaseSeg1 = 4U;
+    config->bitrate.phaseSeg2 = 1U;
+    config->bitrate.preDivider = 0U;
+    config->bitrate.rJumpwidth = 1U;
+    config->bitrate_cbt = config->bitrate;
+    config->transfer_type = FLEXCAN_RXFIFO_USING_INTERRUPTS;
+}
+
+/* @brief: Open the interface on the first call and start FlexCAN: mailboxes
+ *         inactive, RX FIFO empty, timer at 0
+ * @return: STATUS_SUCCESS, STATUS_ERROR if the interface cannot be opened or
+ *          is not FD capable for a FD configuration
+ */
+status_t FLEXCAN_DRV_Init(uint8_t instance, flexcan_state_t *state, const flexcan_user_config_t *data)
+{
+    uint32_t tq;
+    uint32_t i;
+    status_t ret;
+
+    if (instance != INST_CANCOM1)
+    {
+        return STATUS_ERROR;
+    }
+    ret = flexcan_host_open(data->fd_enable);
+    if (ret != STATUS_SUCCESS)
+    {
+        return ret;
+    }
+
+    vPortEnterCritical();
+    memset(&flexcan_host_can0, 0, sizeof(flexcan_host_can0));
+    memset(flexcan_host_mb, 0, sizeof(flexcan_host_mb));
+    memset(state, 0, sizeof(*state));
+    flexcan_host_state = state;
+    flexcan_host_config = *data;
+    flexcan_host_esr1 = 0U;
+    flexcan_host_can0.RXMGMASK = 0xFFFFFFFFU;
+    flexcan_host_can0.RX14MASK = 0xFFFFFFFFU;
+    flexcan_host_can0.RX15MASK = 0xFFFFFFFFU;
+    flexcan_host_can0.RXFGMASK = 0xFFFFFFFFU;
+    for (i = 0U; i < FLEXCAN_HOST_MB_NUM; i++)
+    {
+        flexcan_host_can0.RXIMR[i] = 0xFFFFFFFFU;
+    }
+    flexcan_host_mask_type = FLEXCAN_RX_MASK_GLOBAL;
+
+    /* 1 tq SYNC_SEG, the segments are coded minus 1 */
+    tq = 1U + (data->bitrate.propSeg + 1U) + (data->bitrate.phaseSeg1 + 1U) + (data->bitrate.phaseSeg2 + 1U);
+    flexcan_host_bitrate = FLEXCAN_HOST_PE_CLOCK / ((data->bitrate.preDivider + 1U) * tq);
+    flexcan_host_mb_words = 2U + ((8U << (uint32_t)(data->fd_enable ? data->payload : FLEXCAN_PAYLOAD_SIZE_8)) / 4U);
+    if (flexcan_host_config.max_num_mb > ((uint32_t)sizeof(flexcan_host_can0.RAMn) / 4U / flexcan_host_mb_words))
+    {
+        flexcan_host_config.max_num_mb = (uint32_t)sizeof(flexcan_host_can0.RAMn) / 4U / flexcan_host_mb_words;
+    }
+
+    /* FlexCAN has no RX FIFO with FD enabled */
+    flexcan_host_fifo_enable = data->is_rx_fifo_needed && !data->fd_enable;
+    flexcan_host_fifo_element_num = 0U;
+    flexcan_host_fifo_head = 0U;
+    flexcan_host_fifo_num = 0U;
+    flexcan_host_fifo_msg = NULL;
+    state->transferType = data->transfer_type;
+    state->rxFifoDMAChannel = data->rxFifoDMAChannel;
+    flexcan_host_can0.MCR = (flexcan_host_fifo_enable ? CAN_MCR_RFEN_MASK : 0U) |
+                            (data->fd_enable ? CAN_MCR_FDEN_MASK : 0U) |
+                            ((flexcan_host_fifo_enable && (data->transfer_type == FLEXCAN_RXFIFO_USING_DMA)) ?
+                             CAN_MCR_DMA_MASK : 0U);
+
+    /* a frame still on the wire belongs to the last start */
+    flexcan_host_wire_dropped = flexcan_host_wire_busy;
+    clock_gettime(CLOCK_MONOTONIC, &flexcan_host_epoch);
+    flexcan_host_running = true;
+    flexcan_host_sync();
+    vPortExitCritical();
+
+    return STATUS_SUCCESS;
+}
+
+status_t FLEXCAN_DRV_Deinit(uint8_t instance)
+{
+    if (instance != INST_CANCOM1)
+    {
+        return STATUS_ERROR;
+    }
+    vPortEnterCritical();
+    flexcan_host_sync();
+    flexcan_host_running = false;
+    flexcan_host_wire_dropped = flexcan_host_wire_busy;
+    memset(flexcan_host_mb, 0, sizeof(flexcan_host_mb));
+    flexcan_host_fifo_num = 0U;
+    flexcan_host_fifo_msg = NULL;
+    vPortExitCritical();
+    return STATUS_SUCCESS;
+}
+
+void FLEXCAN_DRV_SetTDCOffset(uint8_t instance, bool enable, uint8_t offset)
+{
+    /* the transceiver loop delay is the one of the interface */
+    (void)instance;
+    (void)enable;
+    (void)offset;
+}
+
+/* @brief: Open and bind the raw socket once, start the backend thread
+ * @param fd : FD frames are needed
+ * @return   : STATUS_SUCCESS or STATUS_ERROR
+ */
+static status_t flexcan_host_open(bool fd)
+{
+    struct sockaddr_can addr;
+    struct ifreq ifr;
+    can_err_mask_t err_mask = CAN_ERR_MASK;
+    int on = 1;
+    int sock;
+
+    if (flexcan_host_fd < 0)
+    {
+        if (flexcan_host_ifname == NULL)
+        {
+            flexcan_host_ifname = getenv("CAN_HOST_IFNAME");
+        }
+        if (flexcan_host_ifname == NULL)
+        {
+            flexcan_host_ifname = FLEXCAN_HOST_IFNAME_DEFAULT;
+        }
+
+        sock = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+        if (sock < 0)
+        {
+            perror("flexcan_host: socket");
+            return STATUS_ERROR;
+        }
+        memset(&ifr, 0, sizeof(ifr));
+        strncpy(ifr.ifr_name, flexcan_host_ifname, IFNAMSIZ - 1);
+        if (ioctl(sock, SIOCGIFINDEX, &ifr) < 0)
+        {
+            fprintf(stderr, "flexcan_host: no interface %s\n", flexcan_host_ifname);
+            close(sock);
+            return STATUS_ERROR;
+        }
+        memset(&addr, 0, sizeof(addr));
+        addr.can_family = AF_CAN;
+        addr.can_ifindex = ifr.ifr_ifindex;
+        if (ioctl(sock, SIOCGIFMTU, &ifr) == 0)
+        {
+            flexcan_host_fd_capable = (ifr.ifr_mtu == (int)CANFD_MTU) &&
+                                      (setsockopt(sock, SOL_CAN_RAW, CAN_RAW_FD_FRAMES, &on, sizeof(on)) == 0);
+        }
+        /* the own frames come back with MSG_CONFIRM, that is TX_COMPLETE */
+        (void)setsockopt(sock, SOL_CAN_RAW, CAN_RAW_RECV_OWN_MSGS, &on, sizeof(on));
+        (void)setsockopt(sock, SOL_CAN_RAW, CAN_RAW_ERR_FILTER, &err_mask, sizeof(err_mask));
+        (void)fcntl(sock, F_SETFL, fcntl(sock, F_GETFL) | O_NONBLOCK);
+        if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+        {
+            perror("flexcan_host: bind");
+            close(sock);
+            return STATUS_ERROR;
+        }
+        flexcan_host_fd = sock;
+    }
+
+    if (fd && !flexcan_host_fd_capable)
+    {
+        fprintf(stderr, "flexcan_host: %s is not CAN FD capable, set its mtu to 72\n", flexcan_host_ifname);
+        return STATUS_ERROR;
+    }
+
+    if (!flexcan_host_thread_started)
+    {
+        if (pthread_create(&flexcan_host_thread, NULL, flexcan_host_main, NULL) != 0)
+        {
+            return STATUS_ERROR;
+        }
+        flexcan_host_thread_started = true;
+    }
+    return STATUS_SUCCESS;
+}
+
+/* @brief: The CAN interrupt: wait for the socket, then handle what came in
+ *         and load the bus with the critical section held
+ * @return: never
+ */
+static void *flexcan_host_main(void *arg)
+{
+    struct pollfd pfd;
+
+    (void)arg;
+
+    for (;;)
+    {
+        pfd.fd = flexcan_host_fd;
+        pfd.events = POLLIN | (flexcan_host_tx_blocked ? POLLOUT : 0);
+        pfd.revents = 0;
+        (void)poll(&pfd, 1U, FLEXCAN_HOST_POLL_MS);
+
+        vPortEnterCritical();
+        flexcan_host_sync();
+        flexcan_host_rx_all();
+        flexcan_host_tx_start();
+        flexcan_host_fifo_drain();
+        vPortExitCritical();
+    }
+    return NULL;
+}
+
+static void flexcan_host_rx_all(void)
+{
+    struct canfd_frame frame;
+    struct iovec iov;
+    struct msghdr msg;
+    ssize_t len;
+    uint32_t i;
+
+    for (i = 0U; i < FLEXCAN_HOST_RX_BURST; i++)
+    {
+        iov.iov_base = &frame;
+        iov.iov_len = sizeof(frame);
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1U;
+        len = recvmsg(flexcan_host_fd, &msg, MSG_DONTWAIT);
+        if (len < 0)
+        {
+            break;
+        }
+        if ((len != (ssize_t)CAN_MTU) && (len != (ssize_t)CANFD_MTU))
+        {
+            continue;
+        }
+
+        if ((msg.msg_flags & MSG_CONFIRM) != 0)
+        {
+            flexcan_host_confirm();
+        }
+        else if ((frame.can_id & CAN_ERR_FLAG) != 0U)
+        {
+            flexcan_host_error_frame(&frame);
+        }
+        else if (flexcan_host_running)
+        {
+            flexcan_host_rx_frame(&frame, len == (ssize_t)CANFD_MTU);
+        }
+    }
+}
+
+/* @brief: Put a frame from the bus into the RX FIFO or an RX mailbox
+ * @param frame : frame read from the socket
+ * @param fd    : it is a FD frame
+ * @return      : None
+ */
+static void flexcan_host_rx_frame(const struct canfd_frame *frame, bool fd)
+{
+    flexcan_host_mb_t *mb;
+    bool ext = (frame->can_id & CAN_EFF_FLAG) != 0U;
+    uint32_t id = frame->can_id & (ext ? CAN_EFF_MASK : CAN_SFF_MASK);
+    uint32_t mask;
+    uint32_t i;
+
+    /* a classic FlexCAN sees a FD frame as a form error */
+    if (fd && !flexcan_host_config.fd_enable)
+    {
+        flexcan_host_rx_reject_num++;
+        return;
+    }
+
+    if (flexcan_host_fifo_enable && flexcan_host_fifo_accept(frame))
+    {
+        if (flexcan_host_fifo_num >= FLEXCAN_HOST_FIFO_DEPTH)
+        {
+            flexcan_host_rx_lost_num++;
+            if ((flexcan_host_can0.MCR & CAN_MCR_DMA_MASK) == 0U)
+            {
+                flexcan_host_event(FLEXCAN_EVENT_RXFIFO_OVERFLOW, 0U);
+            }
+            return;
+        }
+        i = (flexcan_host_fifo_head + flexcan_host_fifo_num) % FLEXCAN_HOST_FIFO_DEPTH;
+        flexcan_host_msg(frame, false, 0U, &flexcan_host_fifo[i]);
+        flexcan_host_fifo_id[i] = ext ? id : (id << FLEXCAN_HOST_ID_STD_SHIFT);
+        flexcan_host_fifo_num++;
+        if ((flexcan_host_fifo_num == FLEXCAN_HOST_FIFO_WARNING) && ((flexcan_host_can0.MCR & CAN_MCR_DMA_MASK) == 0U))
+        {
+            flexcan_host_event(FLEXCAN_EVENT_RXFIFO_WARNING, 0U);
+        }
+        flexcan_host_fifo_drain();
+        return;
+    }
+
+    for (i = 0U; i < flexcan_host_config.max_num_mb; i++)
+    {
+        mb = &flexcan_host_mb[i];
+        if ((mb->code != FLEXCAN_HOST_MB_RX) || (mb->ext != ext) || ((frame->can_id & CAN_RTR_FLAG) != 0U))
+        {
+            continue;
+        }
+        mask = (flexcan_host_mask_type == FLEXCAN_RX_MASK_INDIVIDUAL) ? flexcan_host_can0.RXIMR[i] :
+               flexcan_host_can0.RXMGMASK;
+        if (ext ? (((id ^ mb->id) & mask & FLEXCAN_HOST_ID_MASK) != 0U) :
+            ((((id ^ mb->id) << FLEXCAN_HOST_ID_STD_SHIFT) & mask & FLEXCAN_HOST_ID_MASK) != 0U))
+        {
+            continue;
+        }
+        if (mb->msg == NULL)
+        {
+            /* full and not read yet, the frame overruns it */
+            flexcan_host_rx_lost_num++;
+            return;
+        }
+        flexcan_host_msg(frame, fd, FLEXCAN_HOST_CODE_RX_FULL, mb->msg);
+        mb->msg = NULL;
+        flexcan_host_state->mbs[i].state = FLEXCAN_MB_IDLE;
+        flexcan_host_event(FLEXCAN_EVENT_RX_COMPLETE, i);
+        return;
+    }
+    flexcan_host_rx_reject_num++;
+}
+
+/* @brief: Error frame of the interface into ESR1 and ECR, then the error
+ *         callback. vcan never sends one
+ * @param frame : error frame, see linux/can/error.h
+ * @return      : None
+ */
+static void flexcan_host_error_frame(const struct canfd_frame *frame)
+{
+    uint32_t esr1 = flexcan_host_esr1;
+    canid_t err = frame->can_id;
+
+    if ((err & CAN_ERR_CRTL) != 0U)
+    {
+        if ((frame->data[1] & CAN_ERR_CRTL_RX_WARNING) != 0U)
+        {
+            esr1 |= CAN_ESR1_RXWRN_MASK | CAN_ESR1_RWRNINT_MASK;
+        }
+        if ((frame->data[1] & CAN_ERR_CRTL_TX_WARNING) != 0U)
+        {
+            esr1 |= CAN_ESR1_TXWRN_MASK | CAN_ESR1_TWRNINT_MASK;
+        }
+        if ((frame->data[1] & (CAN_ERR_CRTL_RX_PASSIVE | CAN_ERR_CRTL_TX_PASSIVE)) != 0U)
+        {
+            esr1 = (esr1 & ~CAN_ESR1_FLTCONF_MASK) | FLEXCAN_HOST_ESR1_FLTCONF_PASSIVE;
+        }
+        if ((frame->data[1] & CAN_ERR_CRTL_ACTIVE) != 0U)
+        {
+            esr1 &= ~(CAN_ESR1_FLTCONF_MASK | CAN_ESR1_RXWRN_MASK | CAN_ESR1_TXWRN_MASK);
+        }
+    }
+    if ((err & CAN_ERR_PROT) != 0U)
+    {
+        esr1 |= CAN_ESR1_ERRINT_MASK;
+        esr1 |= ((frame->data[2] & CAN_ERR_PROT_BIT0) != 0U) ? CAN_ESR1_BIT0ERR_MASK : 0U;
+        esr1 |= ((frame->data[2] & (CAN_ERR_PROT_BIT1 | CAN_ERR_PROT_BIT)) != 0U) ? CAN_ESR1_BIT1ERR_MASK : 0U;
+        esr1 |= ((frame->data[2] & CAN_ERR_PROT_FORM) != 0U) ? CAN_ESR1_FRMERR_MASK : 0U;
+        esr1 |= ((frame->data[2] & CAN_ERR_PROT_STUFF) != 0U) ? CAN_ESR1_STFERR_MASK : 0U;
+        esr1 |= ((frame->data[3] == CAN_ERR_PROT_LOC_CRC_SEQ) || (frame->data[3] == CAN_ERR_PROT_LOC_CRC_DEL)) ?
+                CAN_ESR1_CRCERR_MASK : 0U;
+    }
+    if ((err & CAN_ERR_ACK) != 0U)
+    {
+        esr1 |= CAN_ESR1_ERRINT_MASK | CAN_ESR1_ACKERR_MASK;
+    }
+    if ((err & CAN_ERR_BUSOFF) != 0U)
+    {
+        esr1 = (esr1 & ~CAN_ESR1_FLTCONF_MASK) | FLEXCAN_HOST_ESR1_FLTCONF_BUS_OFF | CAN_ESR1_BOFFINT_MASK;
+    }
+    if ((err & CAN_ERR_RESTARTED) != 0U)
+    {
+        esr1 &= ~(CAN_ESR1_FLTCONF_MASK | CAN_ESR1_RXWRN_MASK | CAN_ESR1_TXWRN_MASK);
+        if ((flexcan_host_can0.CTRL2 & CAN_CTRL2_BOFFDONEMSK_MASK) != 0U)
+        {
+            esr1 |= CAN_ESR1_BOFFDONEINT_MASK;
+        }
+    }
+    if ((err & CAN_ERR_CNT) != 0U)
+    {
+        flexcan_host_can0.ECR = ((uint32_t)frame->data[7] << CAN_ECR_RXERRCNT_SHIFT) |
+                                ((uint32_t)frame->data[6] << CAN_ECR_TXERRCNT_SHIFT);
+    }
+
+    flexcan_host_esr1 = esr1;
+    flexcan_host_sync();
+    if (flexcan_host_running && ((esr1 & FLEXCAN_HOST_ESR1_INT) != 0U) && (flexcan_host_state->error_callback != NULL))
+    {
+        flexcan_host_state->error_callback(INST_CANCOM1, FLEXCAN_EVENT_ERROR, flexcan_host_state);
+        /* as the driver does after the callback */
+        flexcan_host_esr1 &= ~FLEXCAN_HOST_ESR1_INT;
+        flexcan_host_sync();
+    }
+}
+
+/* @brief: The frame on the wire was sent, TX_COMPLETE for its mailbox
+ * @return: None
+ */
+static void flexcan_host_confirm(void)
+{
+    flexcan_host_mb_t *mb;
+    uint32_t i = flexcan_host_wire_mb;
+    uint32_t base = i * flexcan_host_mb_words;
+    const struct canfd_frame *frame;
+    uint32_t cs;
+
+    if (!flexcan_host_wire_busy)
+    {
+        return;
+    }
+    flexcan_host_wire_busy = false;
+    if (flexcan_host_wire_dropped)
+    {
+        flexcan_host_wire_dropped = false;
+        return;
+    }
+
+    mb = &flexcan_host_mb[i];
+    frame = &mb->frame;
+    cs = (FLEXCAN_HOST_CODE_TX_INACTIVE << FLEXCAN_HOST_CS_CODE_SHIFT) |
+         ((uint32_t)flexcan_host_len_to_dlc(frame->len) << FLEXCAN_HOST_CS_DLC_SHIFT) | flexcan_host_timer();
+    if (mb->fd)
+    {
+        cs |= FLEXCAN_HOST_CS_EDL | (((frame->flags & CANFD_BRS) != 0U) ? FLEXCAN_HOST_CS_BRS : 0U);
+    }
+    if (mb->ext)
+    {
+        cs |= FLEXCAN_HOST_CS_SRR | FLEXCAN_HOST_CS_IDE;
+    }
+    flexcan_host_can0.RAMn[base] = cs;
+    flexcan_host_can0.RAMn[base + 1U] = mb->ext ? mb->id : (mb->id << FLEXCAN_HOST_ID_STD_SHIFT);
+    mb->code = FLEXCAN_HOST_MB_INACTIVE;
+    flexcan_host_state->mbs[i].state = FLEXCAN_MB_IDLE;
+    flexcan_host_event(FLEXCAN_EVENT_TX_COMPLETE, i);
+}
+
+/* @brief: Arbitration: write the highest priority pending mailbox to the
+ *         socket if the bus is free
+ * @return: None
+ */
+static void flexcan_host_tx_start(void)
+{
+    flexcan_host_mb_t *mb;
+    uint32_t best = FLEXCAN_HOST_MB_NUM;
+    uint32_t i;
+    ssize_t len;
+
+    if (flexcan_host_wire_busy || !flexcan_host_running)
+    {
+        return;
+    }
+    for (i = 0U; i < flexcan_host_config.max_num_mb; i++)
+    {
+        if ((flexcan_host_mb[i].code == FLEXCAN_HOST_MB_TX_PENDING) &&
+            ((best == FLEXCAN_HOST_MB_NUM) ||
+             (flexcan_host_key(&flexcan_host_mb[i].frame) < flexcan_host_key(&flexcan_host_mb[best].frame))))
+        {
+            best = i;
+        }
+    }
+    if (best == FLEXCAN_HOST_MB_NUM)
+    {
+        return;
+    }
+
+    mb = &flexcan_host_mb[best];
+    len = write(flexcan_host_fd, &mb->frame, mb->fd ? CANFD_MTU : CAN_MTU);
+    if (len < 0)
+    {
+        /* the interface queue is full, the backend thread waits for room */
+        flexcan_host_tx_retry_num++;
+        flexcan_host_tx_blocked = true;
+        return;
+    }
+    flexcan_host_tx_blocked = false;
+    mb->code = FLEXCAN_HOST_MB_TX_WIRE;
+    flexcan_host_wire_busy = true;
+    flexcan_host_wire_dropped = false;
+    flexcan_host_wire_mb = (uint8_t)best;
+}
+
+/* @brief: Arbitration order of a frame, the lower key wins. The base ID
+ *         first, a standard frame before an extended one with the same base
+ *         ID, then the extended ID bits
+ * @param frame : SocketCAN frame
+ * @return      : key
+ */
+static uint32_t flexcan_host_key(const struct canfd_frame *frame)
+{
+    uint32_t id;
+
+    if ((frame->can_id & CAN_EFF_FLAG) != 0U)
+    {
+        id = frame->can_id & CAN_EFF_MASK;
+        return ((id >> 18) << 19) | (1UL << 18) | (id & 0x3FFFFU);
+    }
+    return (frame->can_id & CAN_SFF_MASK) << 19;
+}
+
+static uint8_t flexcan_host_len_to_dlc(uint32_t len)
+{
+    uint8_t dlc = 0U;
+
+    while ((dlc < 15U) && (flexcan_host_dlc_len[dlc] < len))
+    {
+        dlc++;
+    }
+    return dlc;
+}
+
+/* @brief: A frame as the driver hands it over, CS word with the time stamp
+ * @param frame : SocketCAN frame
+ * @param fd    : it is a FD frame
+ * @param code  : mailbox code of the CS word
+ * @param msg   : destination
+ * @return      : None
+ */
+static void flexcan_host_msg(const struct canfd_frame *frame, bool fd, uint32_t code, flexcan_msgbuff_t *msg)
+{
+    bool ext = (frame->can_id & CAN_EFF_FLAG) != 0U;
+    bool rtr = (frame->can_id & CAN_RTR_FLAG) != 0U;
+    uint8_t dlc = flexcan_host_len_to_dlc(frame->len);
+    uint32_t len = fd ? flexcan_host_dlc_len[dlc] : ((frame->len > 8U) ? 8U : frame->len);
+
+    msg->cs = (code << FLEXCAN_HOST_CS_CODE_SHIFT) | ((uint32_t)dlc << FLEXCAN_HOST_CS_DLC_SHIFT) | flexcan_host_timer();
+    if (fd)
+    {
+        msg->cs |= FLEXCAN_HOST_CS_EDL | (((frame->flags & CANFD_BRS) != 0U) ? FLEXCAN_HOST_CS_BRS : 0U);
+    }
+    if (ext)
+    {
+        msg->cs |= FLEXCAN_HOST_CS_SRR | FLEXCAN_HOST_CS_IDE;
+    }
+    if (rtr)
+    {
+        msg->cs |= FLEXCAN_HOST_CS_RTR;
+        len = 0U;
+    }
+    msg->msgId = frame->can_id & (ext ? CAN_EFF_MASK : CAN_SFF_MASK);
+    memset(msg->data, 0, sizeof(msg->data));
+    memcpy(msg->data, frame->data, (len < frame->len) ? len : frame->len);
+    msg->dataLen = (uint8_t)len;
+}
+
+/* @brief: RX FIFO ID filter table, the same compare as FlexCAN and
+ *         tools/can_filter_gen
+ * @param frame : received frame
+ * @return      : true if an element accepts the frame
+ */
+static bool flexcan_host_fifo_accept(const struct canfd_frame *frame)
+{
+    bool ext = (frame->can_id & CAN_EFF_FLAG) != 0U;
+    flexcan_id_table_t entry;
+    uint32_t per = 1U;
+    uint32_t field;
+    uint32_t mask;
+    uint32_t e;
+    uint32_t s;
+
+    if (flexcan_host_fifo_format == FLEXCAN_RX_FIFO_ID_FORMAT_B)
+    {
+        per = 2U;
+    }
+    else if (flexcan_host_fifo_format == FLEXCAN_RX_FIFO_ID_FORMAT_C)
+    {
+        per = 4U;
+    }
+    else if (flexcan_host_fifo_format == FLEXCAN_RX_FIFO_ID_FORMAT_D)
+    {
+        /* rejects every frame */
+        return false;
+    }
+
+    /* the frame as a table entry, its word is compared with the element */
+    entry.isRemoteFrame = (frame->can_id & CAN_RTR_FLAG) != 0U;
+    entry.isExtendedFrame = ext;
+    entry.id = frame->can_id & (ext ? CAN_EFF_MASK : CAN_SFF_MASK);
+    for (e = 0U; e < flexcan_host_fifo_element_num; e++)
+    {
+        /* the first elements have an individual mask each */
+        mask = ((flexcan_host_mask_type == FLEXCAN_RX_MASK_INDIVIDUAL) && (e < flexcan_host_config.max_num_mb)) ?
+               flexcan_host_can0.RXIMR[e] : flexcan_host_can0.RXFGMASK;
+        for (s = 0U; s < per; s++)
+        {
+            if (per == 1U)
+            {
+                field = 0xFFFFFFFFU;
+            }
+            else if (per == 2U)
+            {
+                field = (s == 0U) ? 0xFFFF0000U : 0x0000FFFFU;
+            }
+            else
+            {
+                field = 0xFFUL << (24U - (8U * s));
+            }
+            if (((flexcan_host_fifo_word(&entry, s) ^ flexcan_host_fifo_filter[e]) & mask & field) == 0U)
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/* @brief: Word of one table slot as the driver writes it
+ * @param entry : table entry
+ * @param slot  : slot in the element, 0 is the top
+ * @return      : word with the other slots 0
+ */
+static uint32_t flexcan_host_fifo_word(const flexcan_id_table_t *entry, uint32_t slot)
+{
+    uint32_t flags = (entry->isRemoteFrame ? 2U : 0U) | (entry->isExtendedFrame ? 1U : 0U);
+    uint32_t id = entry->id;
+
+    if (flexcan_host_fifo_format == FLEXCAN_RX_FIFO_ID_FORMAT_A)
+    {
+        return (flags << 30) | (entry->isExtendedFrame ? ((id << 1) & 0x3FFFFFFEU) : ((id & 0x7FFU) << 19));
+    }
+    if (flexcan_host_fifo_format == FLEXCAN_RX_FIFO_ID_FORMAT_B)
+    {
+        if (slot == 0U)
+        {
+            return (flags << 30) | (entry->isExtendedFrame ? (((id >> 15) & 0x3FFFU) << 16) : ((id & 0x7FFU) << 19));
+        }
+        return (flags << 14) | (entry->isExtendedFrame ? ((id >> 15) & 0x3FFFU) : ((id & 0x7FFU) << 3));
+    }
+    return (entry->isExtendedFrame ? ((id >> 21) & 0xFFU) : ((id >> 3) & 0xFFU)) << (24U - (8U * slot));
+}
+
+void FLEXCAN_DRV_ConfigRxFifo(uint8_t instance, flexcan_rx_fifo_id_element_format_t id_format,
+                              const flexcan_id_table_t *id_filter_table)
+{
+    uint32_t per = (id_format == FLEXCAN_RX_FIFO_ID_FORMAT_B) ? 2U : ((id_format == FLEXCAN_RX_FIFO_ID_FORMAT_C) ? 4U : 1U);
+    uint32_t e;
+    uint32_t s;
+
+    (void)instance;
+
+    vPortEnterCritical();
+    flexcan_host_fifo_format = id_format;
+    flexcan_host_fifo_element_num = 8U * ((uint32_t)flexcan_host_config.num_id_filters + 1U);
+    for (e = 0U; e < flexcan_host_fifo_element_num; e++)
+    {
+        flexcan_host_fifo_filter[e] = 0U;
+        if (id_format == FLEXCAN_RX_FIFO_ID_FORMAT_D)
+        {
+            continue;
+        }
+        for (s = 0U; s < per; s++)
+        {
+            flexcan_host_fifo_filter[e] |= flexcan_host_fifo_word(&id_filter_table[(e * per) + s], s);
+        }
+    }
+    vPortExitCritical();
+}
+
+/* @brief: Hand the frames of the RX FIFO to the armed FLEXCAN_DRV_RxFifo()
+ *         or with MCR[DMA] to the eDMA channel
+ * @return: None
+ */
+static void flexcan_host_fifo_drain(void)
+{
+    flexcan_msgbuff_t *msg;
+    uint32_t i;
+
+    while (flexcan_host_fifo_num > 0U)
+    {
+        i = flexcan_host_fifo_head;
+        if ((flexcan_host_can0.MCR & CAN_MCR_DMA_MASK) != 0U)
+        {
+            if (!flexcan_host_dma.started)
+            {
+                return;
+            }
+            flexcan_host_fifo_head = (i + 1U) % FLEXCAN_HOST_FIFO_DEPTH;
+            flexcan_host_fifo_num--;
+            flexcan_host_dma_write(&flexcan_host_fifo[i], flexcan_host_fifo_id[i]);
+            continue;
+        }
+        if (flexcan_host_fifo_msg == NULL)
+        {
+            return;
+        }
+        msg = flexcan_host_fifo_msg;
+        flexcan_host_fifo_msg = NULL;
+        *msg = flexcan_host_fifo[i];
+        flexcan_host_fifo_head = (i + 1U) % FLEXCAN_HOST_FIFO_DEPTH;
+        flexcan_host_fifo_num--;
+        flexcan_host_state->mbs[0].state = FLEXCAN_MB_IDLE;
+        /* the callback arms the FIFO again for the next frame */
+        flexcan_host_event(FLEXCAN_EVENT_RXFIFO_COMPLETE, 0U);
+    }
+}
+
+status_t FLEXCAN_DRV_RxFifo(uint8_t instance, flexcan_msgbuff_t *data)
+{
+    status_t ret = STATUS_SUCCESS;
+
+    (void)instance;
+
+    vPortEnterCritical();
+    if (!flexcan_host_fifo_enable || !flexcan_host_running)
+    {
+        ret = STATUS_ERROR;
+    }
+    else if (flexcan_host_fifo_msg != NULL)
+    {
+        ret = STATUS_BUSY;
+    }
+    else
+    {
+        flexcan_host_fifo_msg = data;
+        flexcan_host_state->mbs[0].state = FLEXCAN_MB_RX_BUSY;
+    }
+    vPortExitCritical();
+    return ret;
+}
+
+status_t FLEXCAN_DRV_ConfigRxMb(uint8_t instance, uint8_t mb_idx, const flexcan_data_info_t *rx_info, uint32_t msg_id)
+{
+    flexcan_host_mb_t *mb;
+
+    (void)instance;
+
+    if (mb_idx >= flexcan_host_config.max_num_mb)
+    {
+        return STATUS_CAN_BUFF_OUT_OF_RANGE;
+    }
+    vPortEnterCritical();
+    mb = &flexcan_host_mb[mb_idx];
+    mb->code = FLEXCAN_HOST_MB_RX;
+    mb->ext = (rx_info->msg_id_type == FLEXCAN_MSG_ID_EXT);
+    mb->id = msg_id & (mb->ext ? CAN_EFF_MASK : CAN_SFF_MASK);
+    mb->msg = NULL;
+    vPortExitCritical();
+    return STATUS_SUCCESS;
+}
+
+status_t FLEXCAN_DRV_Receive(uint8_t instance, uint8_t mb_idx, flexcan_msgbuff_t *data)
+{
+    status_t ret = STATUS_SUCCESS;
+
+    (void)instance;
+
+    if (mb_idx >= flexcan_host_config.max_num_mb)
+    {
+        return STATUS_CAN_BUFF_OUT_OF_RANGE;
+    }
+    vPortEnterCritical();
+    if (flexcan_host_mb[mb_idx].code != FLEXCAN_HOST_MB_RX)
+    {
+        ret = STATUS_ERROR;
+    }
+    else if (flexcan_host_mb[mb_idx].msg != NULL)
+    {
+        ret = STATUS_BUSY;
+    }
+    else
+    {
+        flexcan_host_mb[mb_idx].msg = data;
+        flexcan_host_state->mbs[mb_idx].state = FLEXCAN_MB_RX_BUSY;
+    }
+    vPortExitCritical();
+    return ret;
+}
+
+void FLEXCAN_DRV_SetRxMaskType(uint8_t instance, flexcan_rx_mask_type_t type)
+{
+    (void)instance;
+
+    vPortEnterCritical();
+    flexcan_host_mask_type = type;
+    if (type == FLEXCAN_RX_MASK_INDIVIDUAL)
+    {
+        flexcan_host_can0.MCR |= CAN_MCR_IRMQ_MASK;
+    }
+    else
+    {
+        flexcan_host_can0.MCR &= ~CAN_MCR_IRMQ_MASK;
+    }
+    vPortExitCritical();
+}
+
+status_t FLEXCAN_DRV_SetRxIndividualMask(uint8_t instance, flexcan_msgbuff_id_type_t id_type, uint8_t mb_idx,
+                                         uint32_t mask)
+{
+    (void)instance;
+
+    if (mb_idx >= FLEXCAN_HOST_MB_NUM)
+    {
+        return STATUS_CAN_BUFF_OUT_OF_RANGE;
+    }
+    vPortEnterCritical();
+    flexcan_host_can0.RXIMR[mb_idx] = (id_type == FLEXCAN_MSG_ID_EXT) ? (mask & FLEXCAN_HOST_ID_MASK) :
+                                      ((mask << FLEXCAN_HOST_ID_STD_SHIFT) & FLEXCAN_HOST_ID_MASK);
+    vPortExitCritical();
+    return STATUS_SUCCESS;
+}
+
+status_t FLEXCAN_DRV_ConfigTxMb(uint8_t instance, uint8_t mb_idx, const flexcan_data_info_t *tx_info, uint32_t msg_id)
+{
+    (void)instance;
+    (void)tx_info;
+    (void)msg_id;
+
+    if (mb_idx >= flexcan_host_config.max_num_mb)
+    {
+        return STATUS_CAN_BUFF_OUT_OF_RANGE;
+    }
+    vPortEnterCritical();
+    flexcan_host_mb[mb_idx].code = FLEXCAN_HOST_MB_INACTIVE;
+    flexcan_host_can0.RAMn[mb_idx * flexcan_host_mb_words] = FLEXCAN_HOST_CODE_TX_INACTIVE << FLEXCAN_HOST_CS_CODE_SHIFT;
+    vPortExitCritical();
+    return STATUS_SUCCESS;
+}
+
+/* @brief: Load a TX mailbox, the frame is on the bus as soon as it wins the
+ *         arbitration of the pending mailboxes
+ * @return: STATUS_SUCCESS, STATUS_BUSY if the mailbox still sends
+ */
+status_t FLEXCAN_DRV_Send(uint8_t instance, uint8_t mb_idx, const flexcan_data_info_t *tx_info, uint32_t msg_id,
+                          const uint8_t *mb_data)
+{
+    flexcan_host_mb_t *mb;
+    uint32_t len = tx_info->data_length;
+    uint32_t padded;
+    status_t ret = STATUS_SUCCESS;
+
+    (void)instance;
+
+    if (mb_idx >= flexcan_host_config.max_num_mb)
+    {
+        return STATUS_CAN_BUFF_OUT_OF_RANGE;
+    }
+    vPortEnterCritical();
+    mb = &flexcan_host_mb[mb_idx];
+    if (!flexcan_host_running || (tx_info->fd_enable && !flexcan_host_config.fd_enable))
+    {
+        ret = STATUS_ERROR;
+    }
+    else if ((mb->code == FLEXCAN_HOST_MB_TX_PENDING) || (mb->code == FLEXCAN_HOST_MB_TX_WIRE))
+    {
+        ret = STATUS_BUSY;
+    }
+    else
+    {
+        if (len > (tx_info->fd_enable ? 64U : 8U))
+        {
+            len = tx_info->fd_enable ? 64U : 8U;
+        }
+        padded = tx_info->fd_enable ? flexcan_host_dlc_len[flexcan_host_len_to_dlc(len)] : len;
+        memset(&mb->frame, 0, sizeof(mb->frame));
+        mb->ext = (tx_info->msg_id_type == FLEXCAN_MSG_ID_EXT);
+        mb->id = msg_id & (mb->ext ? CAN_EFF_MASK : CAN_SFF_MASK);
+        mb->fd = tx_info->fd_enable;
+        mb->frame.can_id = mb->id | (mb->ext ? CAN_EFF_FLAG : 0U) | (tx_info->is_remote ? CAN_RTR_FLAG : 0U);
+        mb->frame.len = (uint8_t)padded;
+        mb->frame.flags = (mb->fd && tx_info->enable_brs) ? CANFD_BRS : 0U;
+        if (mb_data != NULL)
+        {
+            memcpy(mb->frame.data, mb_data, len);
+        }
+        memset(&mb->frame.data[len], tx_info->fd_padding, padded - len);
+        mb->code = FLEXCAN_HOST_MB_TX_PENDING;
+        flexcan_host_state->mbs[mb_idx].state = FLEXCAN_MB_TX_BUSY;
+        flexcan_host_tx_start();
+    }
+    vPortExitCritical();
+    return ret;
+}
+
+/* @brief: Take a frame back out of its TX mailbox
+ * @return: STATUS_SUCCESS if it was not sent, STATUS_CAN_NO_TRANSFER_IN_PROGRESS
+ *          if it was already sent or is on the wire and will be
+ */
+status_t FLEXCAN_DRV_AbortTransfer(uint8_t instance, uint8_t mb_idx)
+{
+    flexcan_host_mb_t *mb;
+    status_t ret = STATUS_CAN_NO_TRANSFER_IN_PROGRESS;
+
+    (void)instance;
+
+    if (mb_idx >= flexcan_host_config.max_num_mb)
+    {
+        return STATUS_CAN_BUFF_OUT_OF_RANGE;
+    }
+    vPortEnterCritical();
+    mb = &flexcan_host_mb[mb_idx];
+    if (mb->code == FLEXCAN_HOST_MB_TX_PENDING)
+    {
+        ret = STATUS_SUCCESS;
+    }
+    else if (mb->code == FLEXCAN_HOST_MB_TX_WIRE)
+    {
+        /* it goes out, the time stamp is the one of now */
+        flexcan_host_wire_dropped = true;
+        flexcan_host_can0.RAMn[mb_idx * flexcan_host_mb_words] =
+            (FLEXCAN_HOST_CODE_TX_INACTIVE << FLEXCAN_HOST_CS_CODE_SHIFT) | flexcan_host_timer();
+    }
+    if (mb->code != FLEXCAN_HOST_MB_RX)
+    {
+        mb->code = FLEXCAN_HOST_MB_INACTIVE;
+        flexcan_host_state->mbs[mb_idx].state = FLEXCAN_MB_IDLE;
+    }
+    vPortExitCritical();
+    return ret;
+}
+
+void FLEXCAN_DRV_InstallEventCallback(uint8_t instance, flexcan_callback_t callback, void *callbackParam)
+{
+    (void)instance;
+
+    vPortEnterCritical();
+    flexcan_host_state->callback = callback;
+    flexcan_host_state->callbackParam = callbackParam;
+    vPortExitCritical();
+}
+
+void FLEXCAN_DRV_InstallErrorCallback(uint8_t instance, flexcan_error_callback_t callback, void *callbackParam)
+{
+    (void)instance;
+
+    vPortEnterCritical();
+    flexcan_host_state->error_callback = callback;
+    flexcan_host_state->errorCallbackParam = callbackParam;
+    vPortExitCritical();
+}
+
+/* @brief: ESR1, the error bits are cleared by the read like on FlexCAN
+ * @return: ESR1
+ */
+uint32_t FLEXCAN_DRV_GetErrorStatus(uint8_t instance)
+{
+    uint32_t esr1;
+
+    (void)instance;
+
+    vPortEnterCritical();
+    flexcan_host_sync();
+    esr1 = flexcan_host_can0.ESR1;
+    flexcan_host_esr1 &= ~FLEXCAN_HOST_ESR1_ERR;
+    flexcan_host_sync();
+    vPortExitCritical();
+    return esr1;
+}
+
+void FLEXCAN_EnterFreezeMode(CAN_Type *base)
+{
+    base->MCR |= CAN_MCR_FRZ_MASK;
+}
+
+void FLEXCAN_ExitFreezeMode(CAN_Type *base)
+{
+    base->MCR &= ~CAN_MCR_FRZ_MASK;
+}
+
+static void flexcan_host_event(flexcan_event_type_t event, uint32_t buffIdx)
+{
+    if ((flexcan_host_state != NULL) && (flexcan_host_state->callback != NULL))
+    {
+        flexcan_host_state->callback(INST_CANCOM1, event, buffIdx, flexcan_host_state);
+    }
+}
+
+/* ---- eDMA channel of the RX FIFO ---- */
+
+/* @brief: One minor loop: the 16 bytes of the FIFO output, CS, ID and the
+ *         data words big endian, to the next slot of the ring. The callback
+ *         runs at half and full ring
+ * @param msg : FIFO entry
+ * @param id  : its ID word
+ * @return    : None
+ */
+static void flexcan_host_dma_write(const flexcan_msgbuff_t *msg, uint32_t id)
+{
+    uint32_t word[4];
+    uint32_t pos = flexcan_host_dma.pos;
+
+    word[0] = msg->cs;
+    word[1] = id;
+    word[2] = ((uint32_t)msg->data[0] << 24) | ((uint32_t)msg->data[1] << 16) | ((uint32_t)msg->data[2] << 8) | msg->data[3];
+    word[3] = ((uint32_t)msg->data[4] << 24) | ((uint32_t)msg->data[5] << 16) | ((uint32_t)msg->data[6] << 8) | msg->data[7];
+    memcpy(&flexcan_host_dma.dest[pos * sizeof(word)], word, sizeof(word));
+
+    pos++;
+    if (pos == flexcan_host_dma.count)
+    {
+        pos = 0U;
+    }
+    flexcan_host_dma.pos = pos;
+    __atomic_store_n(&flexcan_host_dma.remaining, flexcan_host_dma.count - pos, __ATOMIC_RELEASE);
+    if (((pos == (flexcan_host_dma.count / 2U)) || (pos == 0U)) && (flexcan_host_dma.callback != NULL))
+    {
+        flexcan_host_dma.callback(flexcan_host_dma.parameter, EDMA_CHN_NORMAL);
+    }
+}
+
+/* @brief: Only the loop transfer of can_lld_rx_dma_start(): 16 byte minor
+ *         loops from the FIFO output into a ring. The 32 bit destination is
+ *         an address of the host process, the build is linked without PIE
+ * @return: STATUS_SUCCESS or STATUS_UNSUPPORTED
+ */
+status_t EDMA_DRV_ConfigLoopTransfer(uint8_t virtualChannel, const edma_transfer_config_t *transferConfig)
+{
+    if ((uintptr_t)&flexcan_host_can0 > UINT32_MAX)
+    {
+        fprintf(stderr, "flexcan_host: 32 bit DMA addresses need a build linked with -no-pie\n");
+        abort();
+    }
+    if ((virtualChannel >= EDMA_CONFIGURED_CHANNELS_COUNT) || (transferConfig->minorByteTransferCount != 16U) ||
+        (transferConfig->loopTransferConfig == NULL) || (transferConfig->destAddr == 0U))
+    {
+        return STATUS_UNSUPPORTED;
+    }
+
+    vPortEnterCritical();
+    flexcan_host_dma.dest = (uint8_t *)(uintptr_t)transferConfig->destAddr;
+    flexcan_host_dma.count = transferConfig->loopTransferConfig->majorLoopIterationCount;
+    flexcan_host_dma.pos = 0U;
+    flexcan_host_dma.remaining = flexcan_host_dma.count;
+    flexcan_host_dma.configured = true;
+    flexcan_host_dma.started = false;
+    vPortExitCritical();
+    return STATUS_SUCCESS;
+}
+
+void EDMA_DRV_DisableRequestsOnTransferComplete(uint8_t virtualChannel, bool disable)
+{
+    /* the ring runs for ever */
+    (void)virtualChannel;
+    (void)disable;
+}
+
+void EDMA_DRV_ConfigureInterrupt(uint8_t virtualChannel, edma_channel_interrupt_t intSrc, bool enable)
+{
+    (void)virtualChannel;
+    (void)intSrc;
+    (void)enable;
+}
+
+status_t EDMA_DRV_InstallCallback(uint8_t virtualChannel, edma_callback_t callback, void *parameter)
+{
+    (void)virtualChannel;
+
+    vPortEnterCritical();
+    flexcan_host_dma.callback = callback;
+    flexcan_host_dma.parameter = parameter;
+    vPortExitCritical();
+    return STATUS_SUCCESS;
+}
+
+status_t EDMA_DRV_StartChannel(uint8_t virtualChannel)
+{
+    status_t ret = STATUS_SUCCESS;
+
+    (void)virtualChannel;
+
+    vPortEnterCritical();
+    if (!flexcan_host_dma.configured)
+    {
+        ret = STATUS_ERROR;
+    }
+    else
+    {
+        flexcan_host_dma.started = true;
+        flexcan_host_fifo_drain();
+    }
+    vPortExitCritical();
+    return ret;
+}
+
+status_t EDMA_DRV_StopChannel(uint8_t virtualChannel)
+{
+    (void)virtualChannel;
+
+    vPortEnterCritical();
+    flexcan_host_dma.started = false;
+    vPortExitCritical();
+    return STATUS_SUCCESS;
+}
+
+uint32_t EDMA_DRV_GetRemainingMajorIterationsCount(uint8_t virtualChannel)
+{
+    (void)virtualChannel;
+
+    return __atomic_load_n(&flexcan_host_dma.remaining, __ATOMIC_ACQUIRE);
+}
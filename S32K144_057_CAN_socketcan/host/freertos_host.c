@@ -0,0 +1,165 @@
+#define _GNU_SOURCE
+#include "FreeRTOS.h"
+#include "task.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* FreeRTOS on POSIX threads, the calls can_lld and its modules make.
+ *
+ * Critical section: one recursive mutex. The SocketCAN backend thread takes
+ * it around its driver callbacks, so a callback never runs inside a
+ * taskENTER_CRITICAL() of a task, like the CAN interrupts masked by BASEPRI.
+ * Task notification: a counter with a condition variable per thread, the
+ * handle of a thread is made on its first xTaskGetCurrentTaskHandle() */
+
+struct tskTaskControlBlock
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t notify;
+};
+
+static pthread_once_t freertos_host_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t freertos_host_critical;
+static struct timespec freertos_host_start;
+static __thread struct tskTaskControlBlock *freertos_host_self = NULL;
+
+static void freertos_host_init(void);
+static uint64_t freertos_host_elapsed_ns(void);
+
+static void freertos_host_init(void)
+{
+    pthread_mutexattr_t attr;
+
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&freertos_host_critical, &attr);
+    pthread_mutexattr_destroy(&attr);
+    clock_gettime(CLOCK_MONOTONIC, &freertos_host_start);
+}
+
+static uint64_t freertos_host_elapsed_ns(void)
+{
+    struct timespec now;
+
+    pthread_once(&freertos_host_once, freertos_host_init);
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)(now.tv_sec - freertos_host_start.tv_sec) * 1000000000ULL) +
+           (uint64_t)now.tv_nsec - (uint64_t)freertos_host_start.tv_nsec;
+}
+
+void vPortEnterCritical(void)
+{
+    pthread_once(&freertos_host_once, freertos_host_init);
+    pthread_mutex_lock(&freertos_host_critical);
+}
+
+void vPortExitCritical(void)
+{
+    pthread_mutex_unlock(&freertos_host_critical);
+}
+
+/* @brief: Ticks since the first call into the host FreeRTOS, wraps like the
+ *         32 bit tick of the board
+ * @return: tick count
+ */
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(freertos_host_elapsed_ns() / (1000000000ULL / configTICK_RATE_HZ));
+}
+
+TickType_t xTaskGetTickCountFromISR(void)
+{
+    return xTaskGetTickCount();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    pthread_condattr_t attr;
+    struct tskTaskControlBlock *task = freertos_host_self;
+
+    if (task == NULL)
+    {
+        task = calloc(1U, sizeof(*task));
+        if (task == NULL)
+        {
+            abort();
+        }
+        pthread_mutex_init(&task->lock, NULL);
+        pthread_condattr_init(&attr);
+        pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+        pthread_cond_init(&task->cond, &attr);
+        pthread_condattr_destroy(&attr);
+        freertos_host_self = task;
+    }
+    return task;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify)
+{
+    pthread_mutex_lock(&xTaskToNotify->lock);
+    xTaskToNotify->notify++;
+    pthread_cond_signal(&xTaskToNotify->cond);
+    pthread_mutex_unlock(&xTaskToNotify->lock);
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    (void)xTaskNotifyGive(xTaskToNotify);
+    if (pxHigherPriorityTaskWoken != NULL)
+    {
+        *pxHigherPriorityTaskWoken = pdTRUE;
+    }
+}
+
+/* @brief: Wait for the notification of the calling thread
+ * @param xClearCountOnExit : pdTRUE to take all notifications, else one
+ * @param xTicksToWait      : ticks to wait, portMAX_DELAY for ever
+ * @return                  : notification count before it was taken, 0 on
+ *                            timeout
+ */
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait)
+{
+    struct tskTaskControlBlock *task = xTaskGetCurrentTaskHandle();
+    struct timespec deadline;
+    uint64_t ns;
+    uint32_t ret;
+
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    ns = (uint64_t)deadline.tv_nsec + ((uint64_t)xTicksToWait * (1000000000ULL / configTICK_RATE_HZ));
+    deadline.tv_sec += (time_t)(ns / 1000000000ULL);
+    deadline.tv_nsec = (long)(ns % 1000000000ULL);
+
+    pthread_mutex_lock(&task->lock);
+    while ((task->notify == 0U) && (xTicksToWait != 0U))
+    {
+        if (xTicksToWait == portMAX_DELAY)
+        {
+            pthread_cond_wait(&task->cond, &task->lock);
+        }
+        else if (pthread_cond_timedwait(&task->cond, &task->lock, &deadline) != 0)
+        {
+            break;
+        }
+    }
+    ret = task->notify;
+    if (ret != 0U)
+    {
+        task->notify = (xClearCountOnExit != pdFALSE) ? 0U : (ret - 1U);
+    }
+    pthread_mutex_unlock(&task->lock);
+
+    return ret;
+}
+
+void vTaskDelay(TickType_t xTicksToDelay)
+{
+    struct timespec delay;
+    uint64_t ns = (uint64_t)xTicksToDelay * (1000000000ULL / configTICK_RATE_HZ);
+
+    delay.tv_sec = (time_t)(ns / 1000000000ULL);
+    delay.tv_nsec = (long)(ns % 1000000000ULL);
+    (void)nanosleep(&delay, NULL);
+}
@@ -0,0 +1,24 @@
+#ifndef lpspiCom1_H
+#define lpspiCom1_H
+
+#include "Cpu.h"
+
+/* the SPI of the SBC, the host build has no SBC to talk to */
+typedef struct
+{
+    uint32_t unused;
+} lpspi_state_t;
+
+typedef struct
+{
+    uint32_t bitsPerSec;
+} lpspi_master_config_t;
+
+#define LPSPICOM1 (1U)
+
+extern lpspi_state_t lpspiCom1State;
+extern const lpspi_master_config_t lpspiCom1_MasterConfig0;
+
+status_t LPSPI_DRV_MasterInit(uint32_t instance, lpspi_state_t *lpspiState, const lpspi_master_config_t *spiConfig);
+
+#endif
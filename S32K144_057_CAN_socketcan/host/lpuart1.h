@@ -0,0 +1,48 @@
+#ifndef lpuart1_H
+#define lpuart1_H
+
+#include "dmaController1.h"
+#include "Cpu.h"
+
+/* LPUART1 driver of the SDK as far as lpuart_lld uses it. The host tests of
+ * the printf lessons put a mock UART behind these calls, the SocketCAN
+ * build has no UART */
+#define INST_LPUART1 (1U)
+
+typedef enum
+{
+    UART_EVENT_RX_FULL = 0x00U,
+    UART_EVENT_TX_EMPTY = 0x01U,
+    UART_EVENT_END_TRANSFER = 0x02U,
+    UART_EVENT_ERROR = 0x03U
+} uart_event_t;
+
+typedef void (*uart_callback_t)(void *driverState, uart_event_t event, void *userData);
+
+typedef struct
+{
+    uint32_t dummy;
+} lpuart_state_t;
+
+typedef struct
+{
+    uint32_t baudRate;
+} lpuart_user_config_t;
+
+extern lpuart_state_t lpuart1_State;
+extern const lpuart_user_config_t lpuart1_InitConfig0;
+
+status_t LPUART_DRV_Init(uint32_t instance, lpuart_state_t *lpuartStatePtr,
+                         const lpuart_user_config_t *lpuartUserConfig);
+status_t LPUART_DRV_SendData(uint32_t instance, const uint8_t *txBuff, uint32_t txSize);
+status_t LPUART_DRV_SendDataBlocking(uint32_t instance, const uint8_t *txBuff, uint32_t txSize, uint32_t timeout);
+status_t LPUART_DRV_SetTxBuffer(uint32_t instance, const uint8_t *txBuff, uint32_t txSize);
+status_t LPUART_DRV_GetTransmitStatus(uint32_t instance, uint32_t *bytesRemaining);
+status_t LPUART_DRV_ReceiveData(uint32_t instance, uint8_t *rxBuff, uint32_t rxSize);
+status_t LPUART_DRV_ReceiveDataPolling(uint32_t instance, uint8_t *rxBuff, uint32_t rxSize);
+status_t LPUART_DRV_SetRxBuffer(uint32_t instance, uint8_t *rxBuff, uint32_t rxSize);
+status_t LPUART_DRV_GetReceiveStatus(uint32_t instance, uint32_t *bytesRemaining);
+uart_callback_t LPUART_DRV_InstallTxCallback(uint32_t instance, uart_callback_t function, void *callbackParam);
+uart_callback_t LPUART_DRV_InstallRxCallback(uint32_t instance, uart_callback_t function, void *callbackParam);
+
+#endif
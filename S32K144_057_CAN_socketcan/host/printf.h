@@ -0,0 +1,10 @@
+#ifndef PRINTF_H
+#define PRINTF_H
+
+/* the board prints over the UART, the host build to stdout */
+#include <stdio.h>
+
+/* no decoder behind stdout, the deferred lines are rendered at once */
+#define printf_defer printf
+
+#endif
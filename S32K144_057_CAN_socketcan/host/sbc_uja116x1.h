@@ -0,0 +1,17 @@
+#ifndef sbc_uja116x1_H
+#define sbc_uja116x1_H
+
+#include "Cpu.h"
+
+/* the CAN transceiver of the EVB sits behind the SBC, SocketCAN brings its
+ * own */
+typedef struct
+{
+    uint32_t unused;
+} sbc_int_config_t;
+
+extern const sbc_int_config_t sbc_uja116x1_InitConfig0;
+
+status_t SBC_Init(const sbc_int_config_t *const config, const uint32_t lpspiInstance);
+
+#endif
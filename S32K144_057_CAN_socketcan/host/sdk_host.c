@@ -0,0 +1,62 @@
+#include "canCom1.h"
+#include "lpspiCom1.h"
+#include "sbc_uja116x1.h"
+
+/* configuration structures of Generated_Code and the peripherals around
+ * FlexCAN the host build does not have */
+
+flexcan_state_t canCom1_State;
+
+/* as canCom1.c of the board: 8 MHz SOSCDIV2, 16 tq, 500 kbit/s */
+const flexcan_user_config_t canCom1_InitConfig0 = {
+    .fd_enable = false,
+    .pe_clock = FLEXCAN_CLK_SOURCE_OSC,
+    .max_num_mb = 16,
+    .num_id_filters = FLEXCAN_RX_FIFO_ID_FILTERS_8,
+    .is_rx_fifo_needed = true,
+    .flexcanMode = FLEXCAN_NORMAL_MODE,
+    .payload = FLEXCAN_PAYLOAD_SIZE_8,
+    .bitrate = {
+        .propSeg = 7,
+        .phaseSeg1 = 4,
+        .phaseSeg2 = 1,
+        .preDivider = 0,
+        .rJumpwidth = 1
+    },
+    .bitrate_cbt = {
+        .propSeg = 7,
+        .phaseSeg1 = 4,
+        .phaseSeg2 = 1,
+        .preDivider = 0,
+        .rJumpwidth = 1
+    },
+    .transfer_type = FLEXCAN_RXFIFO_USING_INTERRUPTS,
+    .rxFifoDMAChannel = 0U
+};
+
+lpspi_state_t lpspiCom1State;
+const lpspi_master_config_t lpspiCom1_MasterConfig0 = {
+    .bitsPerSec = 1000000U
+};
+const sbc_int_config_t sbc_uja116x1_InitConfig0;
+
+void INT_SYS_SetPriority(IRQn_Type irqNumber, uint8_t priority)
+{
+    (void)irqNumber;
+    (void)priority;
+}
+
+status_t LPSPI_DRV_MasterInit(uint32_t instance, lpspi_state_t *lpspiState, const lpspi_master_config_t *spiConfig)
+{
+    (void)instance;
+    (void)lpspiState;
+    (void)spiConfig;
+    return STATUS_SUCCESS;
+}
+
+status_t SBC_Init(const sbc_int_config_t *const config, const uint32_t lpspiInstance)
+{
+    (void)config;
+    (void)lpspiInstance;
+    return STATUS_SUCCESS;
+}
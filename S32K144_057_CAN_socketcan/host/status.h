@@ -0,0 +1,16 @@
+#ifndef STATUS_H
+#define STATUS_H
+
+/* status_t of the S32 SDK, the codes the host build returns */
+typedef enum
+{
+    STATUS_SUCCESS = 0x000U,
+    STATUS_ERROR = 0x001U,
+    STATUS_BUSY = 0x002U,
+    STATUS_TIMEOUT = 0x003U,
+    STATUS_UNSUPPORTED = 0x004U,
+    STATUS_CAN_BUFF_OUT_OF_RANGE = 0x300U,
+    STATUS_CAN_NO_TRANSFER_IN_PROGRESS = 0x301U
+} status_t;
+
+#endif
@@ -0,0 +1,124 @@
+/* Emulated CAN bus for hosts without vcan or AF_CAN.
+ *
+ * The programs linked with vbus_wrap.o connect to this broker instead of
+ * opening a raw CAN socket. Every frame one of them writes goes to all the
+ * others and back to the writer marked as its own, like vcan0 with
+ * CAN_RAW_RECV_OWN_MSGS on. Frames are the struct can_frame or canfd_frame
+ * of the writer, the broker does not look into them and has no bitrate.
+ *
+ * build: make vbus
+ * usage: vbus [-s socket]
+ */
+#include "vbus.h"
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define VBUS_CLIENT_MAX 8U
+
+static struct pollfd vbus_pfd[1U + VBUS_CLIENT_MAX];
+static uint32_t vbus_client_num = 0U;
+
+/* @brief: Sends a frame to every client, the writer gets it as its own
+ * @param from : index of the writer in vbus_pfd
+ * @param frame : frame of the writer
+ * @param len : its length
+ * @return: None
+ */
+static void vbus_forward(uint32_t from, const uint8_t *frame, size_t len)
+{
+    uint8_t buf[1U + VBUS_FRAME_MAX];
+    uint32_t i;
+
+    memcpy(&buf[1], frame, len);
+    for (i = 1U; i <= vbus_client_num; i++)
+    {
+        buf[0] = (i == from) ? VBUS_OWN : VBUS_OTHER;
+        /* a client that does not read loses the frame, not the bus */
+        (void)send(vbus_pfd[i].fd, buf, 1U + len, MSG_DONTWAIT);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = VBUS_PATH_DEFAULT;
+    struct sockaddr_un addr;
+    uint8_t frame[VBUS_FRAME_MAX];
+    ssize_t len;
+    uint32_t i;
+    int opt;
+    int sock;
+
+    while ((opt = getopt(argc, argv, "s:")) != -1)
+    {
+        switch (opt)
+        {
+        case 's':
+            path = optarg;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-s socket]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1U);
+    (void)unlink(path);
+    sock = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if ((sock < 0) || (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) || (listen(sock, 4) < 0))
+    {
+        perror(path);
+        return 1;
+    }
+    vbus_pfd[0].fd = sock;
+    vbus_pfd[0].events = POLLIN;
+
+    for (;;)
+    {
+        if ((poll(vbus_pfd, 1U + vbus_client_num, -1) < 0) && (errno != EINTR))
+        {
+            perror("vbus: poll");
+            return 1;
+        }
+        for (i = 1U; i <= vbus_client_num; i++)
+        {
+            if (vbus_pfd[i].revents == 0)
+            {
+                continue;
+            }
+            len = recv(vbus_pfd[i].fd, frame, sizeof(frame), 0);
+            if (len > 0)
+            {
+                vbus_forward(i, frame, (size_t)len);
+                continue;
+            }
+            /* gone, the last client takes its place */
+            close(vbus_pfd[i].fd);
+            vbus_pfd[i] = vbus_pfd[vbus_client_num];
+            vbus_client_num--;
+            i--;
+        }
+        if ((vbus_pfd[0].revents & POLLIN) != 0)
+        {
+            sock = accept(vbus_pfd[0].fd, NULL, NULL);
+            if ((sock >= 0) && (vbus_client_num < VBUS_CLIENT_MAX))
+            {
+                vbus_client_num++;
+                vbus_pfd[vbus_client_num].fd = sock;
+                vbus_pfd[vbus_client_num].events = POLLIN;
+                vbus_pfd[vbus_client_num].revents = 0;
+            }
+            else if (sock >= 0)
+            {
+                close(sock);
+            }
+        }
+    }
+}
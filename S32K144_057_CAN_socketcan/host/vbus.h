@@ -0,0 +1,15 @@
+#ifndef VBUS_H
+#define VBUS_H
+
+#include <stdint.h>
+#include <linux/can.h>
+
+/* the emulated bus of vbus.c and vbus_wrap.c: a unix SOCK_SEQPACKET
+ * socket, one packet per frame with a byte in front of it telling a frame of
+ * the client itself from the frames of the others */
+#define VBUS_PATH_DEFAULT "/tmp/vbus_can"
+#define VBUS_FRAME_MAX CANFD_MTU
+#define VBUS_OTHER 0U
+#define VBUS_OWN 1U
+
+#endif
@@ -0,0 +1,141 @@
+#define _GNU_SOURCE
+#include "vbus.h"
+#include <errno.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/* Raw CAN sockets on the emulated bus of vbus.c, for hosts without vcan or
+ * AF_CAN. Linked with --wrap of the calls below, a PF_CAN socket becomes a
+ * connection to the broker at VBUS_SOCKET or /tmp/vbus_can and the calls
+ * flexcan_socketcan.c and uds_tester make on it are answered here:
+ *   - every interface name is index 1, its MTU is that of CAN FD, or of
+ *     classic CAN with VBUS_CLASSIC set
+ *   - bind and the socket options succeed and do nothing, the own frames
+ *     always come back and no filter is applied
+ *   - recvmsg() gives the own frames with MSG_CONFIRM, read() skips them
+ * Other sockets and files go to the real calls */
+
+int __real_socket(int domain, int type, int protocol);
+int __real_bind(int sockfd, const struct sockaddr *addr, socklen_t addrlen);
+int __real_setsockopt(int sockfd, int level, int optname, const void *optval, socklen_t optlen);
+int __real_ioctl(int fd, unsigned long request, ...);
+ssize_t __real_recvmsg(int sockfd, struct msghdr *msg, int flags);
+ssize_t __real_read(int fd, void *buf, size_t count);
+ssize_t __real_write(int fd, const void *buf, size_t count);
+
+static int vbus_fd = -1;
+
+int __wrap_socket(int domain, int type, int protocol)
+{
+    struct sockaddr_un addr;
+    const char *path = getenv("VBUS_SOCKET");
+    int sock;
+
+    if (domain != PF_CAN)
+    {
+        return __real_socket(domain, type, protocol);
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, (path != NULL) ? path : VBUS_PATH_DEFAULT, sizeof(addr.sun_path) - 1U);
+    sock = __real_socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if ((sock >= 0) && (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0))
+    {
+        close(sock);
+        sock = -1;
+    }
+    vbus_fd = sock;
+    return sock;
+}
+
+int __wrap_bind(int sockfd, const struct sockaddr *addr, socklen_t addrlen)
+{
+    return (sockfd == vbus_fd) ? 0 : __real_bind(sockfd, addr, addrlen);
+}
+
+int __wrap_setsockopt(int sockfd, int level, int optname, const void *optval, socklen_t optlen)
+{
+    return (sockfd == vbus_fd) ? 0 : __real_setsockopt(sockfd, level, optname, optval, optlen);
+}
+
+int __wrap_ioctl(int fd, unsigned long request, ...)
+{
+    struct ifreq *ifr;
+    va_list ap;
+
+    va_start(ap, request);
+    ifr = va_arg(ap, struct ifreq *);
+    va_end(ap);
+    if (fd != vbus_fd)
+    {
+        return __real_ioctl(fd, request, ifr);
+    }
+    if (request == SIOCGIFINDEX)
+    {
+        ifr->ifr_ifindex = 1;
+    }
+    else if (request == SIOCGIFMTU)
+    {
+        ifr->ifr_mtu = (getenv("VBUS_CLASSIC") != NULL) ? (int)CAN_MTU : (int)CANFD_MTU;
+    }
+    return 0;
+}
+
+ssize_t __wrap_recvmsg(int sockfd, struct msghdr *msg, int flags)
+{
+    uint8_t buf[1U + VBUS_FRAME_MAX];
+    ssize_t len;
+
+    if (sockfd != vbus_fd)
+    {
+        return __real_recvmsg(sockfd, msg, flags);
+    }
+    len = recv(sockfd, buf, sizeof(buf), flags);
+    if (len <= 0)
+    {
+        return (len < 0) ? -1 : 0;
+    }
+    len--;
+    if ((size_t)len > msg->msg_iov[0].iov_len)
+    {
+        len = (ssize_t)msg->msg_iov[0].iov_len;
+    }
+    memcpy(msg->msg_iov[0].iov_base, &buf[1], (size_t)len);
+    msg->msg_flags = (buf[0] == VBUS_OWN) ? MSG_CONFIRM : 0;
+    return len;
+}
+
+ssize_t __wrap_read(int fd, void *buf, size_t count)
+{
+    uint8_t frame[1U + VBUS_FRAME_MAX];
+    ssize_t len;
+
+    if (fd != vbus_fd)
+    {
+        return __real_read(fd, buf, count);
+    }
+    len = recv(fd, frame, sizeof(frame), 0);
+    if (len <= 0)
+    {
+        return len;
+    }
+    if (frame[0] == VBUS_OWN)
+    {
+        errno = EAGAIN;
+        return -1;
+    }
+    len--;
+    memcpy(buf, &frame[1], ((size_t)len < count) ? (size_t)len : count);
+    return len;
+}
+
+ssize_t __wrap_write(int fd, const void *buf, size_t count)
+{
+    return (fd == vbus_fd) ? send(fd, buf, count, MSG_DONTWAIT) : __real_write(fd, buf, count);
+}
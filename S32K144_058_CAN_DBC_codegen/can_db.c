@@ -0,0 +1,151 @@
+#include "can_db.h"
+#include "string.h"
+
+/* can_db_rx() runs in freertos_task_can_rx, can_db_get() and can_db_tx()
+ * in any task. A message value is only touched with the interrupts masked,
+ * an unpack or a copy of one struct */
+uint32_t can_db_rx_num;
+uint32_t can_db_rx_unknown_num;
+uint32_t can_db_rx_len_error_num;
+uint32_t can_db_tx_range_error_num;
+
+/* tick of the last frame received or sent of each message */
+static TickType_t can_db_tick[CAN_DB_MSG_NUM];
+static bool can_db_valid[CAN_DB_MSG_NUM];
+
+#include "can_db_msg.inc"
+
+static int32_t can_db_find(bool ext, uint32_t id);
+
+/* @brief: Take a received frame of a RX message of can_db.dbc, called from
+ *         can_lld_rx_process()
+ * @param frame : frame of the RX queue
+ * @return      : true if the ID belongs to a RX message
+ */
+bool can_db_rx(const can_lld_rx_frame_t *frame)
+{
+    const can_db_msg_t *msg;
+    int32_t index = can_db_find((frame->cs & CAN_LLD_CS_IDE_MASK) != 0U, frame->msgId);
+
+    if ((index < 0) || can_db_msg_table[index].tx)
+    {
+        can_db_rx_unknown_num++;
+        return false;
+    }
+    msg = &can_db_msg_table[index];
+    if (frame->dataLen < msg->len)
+    {
+        can_db_rx_len_error_num++;
+        return true;
+    }
+
+    taskENTER_CRITICAL();
+    msg->unpack(msg->value, frame->data);
+    can_db_tick[index] = frame->tick;
+    can_db_valid[index] = true;
+    taskEXIT_CRITICAL();
+    can_db_rx_num++;
+    return true;
+}
+
+/* @brief: Last value of a message, received or sent
+ * @param index : CAN_DB_<MSG>
+ * @param value : the can_db_<msg>_t of the message
+ * @param tick  : FreeRTOS tick of the frame, may be NULL
+ * @return      : false if no frame was received or sent yet, value is 0
+ */
+bool can_db_get(uint32_t index, void *value, TickType_t *tick)
+{
+    const can_db_msg_t *msg;
+    bool valid;
+
+    if (index >= CAN_DB_MSG_NUM)
+    {
+        return false;
+    }
+    msg = &can_db_msg_table[index];
+    taskENTER_CRITICAL();
+    memcpy(value, msg->value, msg->size);
+    valid = can_db_valid[index];
+    if (tick != NULL)
+    {
+        *tick = can_db_tick[index];
+    }
+    taskEXIT_CRITICAL();
+    return valid;
+}
+
+/* @brief: Send a TX message of can_db.dbc
+ * @param index : CAN_DB_<MSG>
+ * @param value : the can_db_<msg>_t of the message
+ * @return      : STATUS_ERROR for no TX message or a value out of its DBC
+ *                range, else as can_lld_tx()
+ */
+status_t can_db_tx(uint32_t index, const void *value)
+{
+    const can_db_msg_t *msg;
+    uint8_t data[CAN_DB_PAYLOAD_MAX];
+    uint32_t messageId;
+
+    if ((index >= CAN_DB_MSG_NUM) || !can_db_msg_table[index].tx)
+    {
+        return STATUS_ERROR;
+    }
+    msg = &can_db_msg_table[index];
+    if (!msg->check(value))
+    {
+        can_db_tx_range_error_num++;
+        return STATUS_ERROR;
+    }
+    msg->pack(data, value);
+
+    taskENTER_CRITICAL();
+    memcpy(msg->value, value, msg->size);
+    can_db_tick[index] = xTaskGetTickCount();
+    can_db_valid[index] = true;
+    taskEXIT_CRITICAL();
+
+    messageId = msg->id;
+    if (msg->ext)
+    {
+        messageId |= CAN_LLD_TX_ID_EXT;
+    }
+    if (msg->fd)
+    {
+        messageId |= CAN_LLD_TX_ID_FD;
+    }
+    return can_lld_tx(messageId, data, msg->len);
+}
+
+/* @brief: Binary search of can_db_msg_table, standard IDs come first
+ * @param ext : 29 bit ID
+ * @param id  : CAN ID
+ * @return    : index of the message, -1 if there is none
+ */
+static int32_t can_db_find(bool ext, uint32_t id)
+{
+    uint32_t key = ext ? (id | CAN_LLD_TX_ID_EXT) : id;
+    uint32_t lo = 0U;
+    uint32_t hi = CAN_DB_MSG_NUM;
+    uint32_t mid;
+    uint32_t mid_key;
+
+    while (lo < hi)
+    {
+        mid = (lo + hi) / 2U;
+        mid_key = can_db_msg_table[mid].ext ? (can_db_msg_table[mid].id | CAN_LLD_TX_ID_EXT) : can_db_msg_table[mid].id;
+        if (mid_key == key)
+        {
+            return (int32_t)mid;
+        }
+        if (mid_key < key)
+        {
+            lo = mid + 1U;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return -1;
+}
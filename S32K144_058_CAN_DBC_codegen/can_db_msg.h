@@ -0,0 +1,349 @@
+/* generated by tools/can_db_gen from can_db.dbc, do not edit */
+#ifndef CAN_DB_MSG_H
+#define CAN_DB_MSG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+/* messages of can_db_msg_table, standard IDs first, sorted by ID */
+#define CAN_DB_MSG_NUM 9U
+#define CAN_DB_SIGNAL_NUM 50U
+/* longest payload of a message */
+#define CAN_DB_PAYLOAD_MAX 64U
+
+/* index of a message in can_db_msg_table */
+#define CAN_DB_ECU_STATUS 0U
+#define CAN_DB_ECU_FD_STATUS 1U
+#define CAN_DB_BCM_STATUS 2U
+#define CAN_DB_GW_TIME 3U
+#define CAN_DB_GW_ODOMETER 4U
+#define CAN_DB_ESC_WHEEL_SPEEDS 5U
+#define CAN_DB_ESC_YAW_RATE 6U
+#define CAN_DB_EEC1 7U
+#define CAN_DB_ET1 8U
+
+typedef struct
+{
+    uint32_t id;
+    bool ext;           /* 29 bit ID */
+    bool fd;            /* CAN FD frame */
+    bool tx;            /* sent by this node, else received */
+    uint8_t len;        /* payload bytes */
+    uint16_t cycle_ms;  /* GenMsgCycleTime, 0 if not cyclic */
+    uint16_t size;      /* bytes of the message struct */
+    void *value;        /* last value sent or received */
+    void (*pack)(uint8_t *data, const void *msg);
+    void (*unpack)(void *msg, const uint8_t *data);
+    bool (*check)(const void *msg);
+} can_db_msg_t;
+
+/* a signal for generic code, see CAN_DB_SIGNAL_TABLE */
+typedef struct
+{
+    const char *name;
+    uint16_t msg;       /* index in can_db_msg_table */
+    uint16_t start;     /* DBC start bit */
+    uint8_t len;
+    bool motorola;
+    bool is_signed;
+    uint8_t field_size; /* bytes of the struct field */
+    uint16_t field;     /* offset of the struct field */
+    bool low_check;     /* raw limits compared by check() */
+    bool high_check;
+    int64_t low;
+    int64_t high;
+    float factor;
+    float offset;
+} can_db_signal_t;
+
+/* ECU_Status, 8 bytes, every 100 ms, sent by S32K144 */
+#define CAN_DB_ECU_STATUS_ID 0x77U
+#define CAN_DB_ECU_STATUS_LEN 8U
+#define CAN_DB_ECU_STATUS_CYCLE_MS 100U
+
+typedef struct
+{
+    uint32_t alive_counter;     /* 0|32@1+ */
+    uint8_t can_error_state;    /* 32|3@1+ */
+    uint8_t can_mode;           /* 35|1@1+ */
+    uint8_t tx_error_counter;   /* 47|8@0+ */
+    uint8_t rx_error_counter;   /* 55|8@0+ */
+    uint8_t rx_queue_peak;      /* 56|8@1+ */
+} can_db_ecu_status_t;
+
+#define CAN_DB_ECU_STATUS_CAN_ERROR_STATE_MAX 4U
+#define CAN_DB_ECU_STATUS_CAN_ERROR_STATE_ACTIVE 0U
+#define CAN_DB_ECU_STATUS_CAN_ERROR_STATE_WARNING 1U
+#define CAN_DB_ECU_STATUS_CAN_ERROR_STATE_PASSIVE 2U
+#define CAN_DB_ECU_STATUS_CAN_ERROR_STATE_BUS_OFF 3U
+#define CAN_DB_ECU_STATUS_CAN_ERROR_STATE_RECOVERING 4U
+#define CAN_DB_ECU_STATUS_CAN_MODE_MAX 1U
+#define CAN_DB_ECU_STATUS_CAN_MODE_CLASSIC 0U
+#define CAN_DB_ECU_STATUS_CAN_MODE_FD 1U
+#define CAN_DB_ECU_STATUS_RX_QUEUE_PEAK_MAX 128U
+
+void can_db_ecu_status_pack(uint8_t *data, const can_db_ecu_status_t *msg);
+void can_db_ecu_status_unpack(can_db_ecu_status_t *msg, const uint8_t *data);
+bool can_db_ecu_status_check(const can_db_ecu_status_t *msg);
+
+/* ECU_FdStatus, FD, 64 bytes, every 100 ms, sent by S32K144 */
+#define CAN_DB_ECU_FD_STATUS_ID 0x78U
+#define CAN_DB_ECU_FD_STATUS_LEN 64U
+#define CAN_DB_ECU_FD_STATUS_CYCLE_MS 100U
+
+typedef struct
+{
+    uint32_t alive_counter;     /* 0|32@1+ */
+    uint32_t rx_frames;         /* 32|32@1+ */
+    uint32_t tx_frames;         /* 64|32@1+ */
+    uint32_t rx_fd_frames;      /* 96|32@1+ */
+    uint32_t tx_fd_frames;      /* 128|32@1+ */
+    uint16_t rx_queue_overflows; /* 160|16@1+ */
+    uint16_t tx_queue_full;     /* 176|16@1+ */
+    uint16_t error_interrupts;  /* 192|16@1+ */
+    uint16_t bus_load;          /* 215|16@0+ (0.01,0) % */
+} can_db_ecu_fd_status_t;
+
+#define CAN_DB_ECU_FD_STATUS_BUS_LOAD_FACTOR 0.01f
+#define CAN_DB_ECU_FD_STATUS_BUS_LOAD_OFFSET 0.0f
+#define CAN_DB_ECU_FD_STATUS_BUS_LOAD_MAX 10000U
+
+void can_db_ecu_fd_status_pack(uint8_t *data, const can_db_ecu_fd_status_t *msg);
+void can_db_ecu_fd_status_unpack(can_db_ecu_fd_status_t *msg, const uint8_t *data);
+bool can_db_ecu_fd_status_check(const can_db_ecu_fd_status_t *msg);
+
+/* BCM_Status, 8 bytes, every 100 ms, from BCM */
+#define CAN_DB_BCM_STATUS_ID 0x100U
+#define CAN_DB_BCM_STATUS_LEN 8U
+#define CAN_DB_BCM_STATUS_CYCLE_MS 100U
+
+typedef struct
+{
+    uint8_t door_fl;            /* 0|1@1+ */
+    uint8_t door_fr;            /* 1|1@1+ */
+    uint8_t door_rl;            /* 2|1@1+ */
+    uint8_t door_rr;            /* 3|1@1+ */
+    uint8_t trunk;              /* 4|1@1+ */
+    uint8_t ignition_state;     /* 8|2@1+ */
+    uint16_t battery_voltage;   /* 16|10@1+ (0.02,0) V */
+    int8_t interior_temp;       /* 26|8@1- (0.5,0) degC */
+    uint8_t rolling_counter;    /* 60|4@1+ */
+} can_db_bcm_status_t;
+
+#define CAN_DB_BCM_STATUS_DOOR_FL_MAX 1U
+#define CAN_DB_BCM_STATUS_DOOR_FR_MAX 1U
+#define CAN_DB_BCM_STATUS_DOOR_RL_MAX 1U
+#define CAN_DB_BCM_STATUS_DOOR_RR_MAX 1U
+#define CAN_DB_BCM_STATUS_TRUNK_MAX 1U
+#define CAN_DB_BCM_STATUS_IGNITION_STATE_MAX 3U
+#define CAN_DB_BCM_STATUS_IGNITION_STATE_OFF 0U
+#define CAN_DB_BCM_STATUS_IGNITION_STATE_ACCESSORY 1U
+#define CAN_DB_BCM_STATUS_IGNITION_STATE_RUN 2U
+#define CAN_DB_BCM_STATUS_IGNITION_STATE_CRANK 3U
+#define CAN_DB_BCM_STATUS_BATTERY_VOLTAGE_FACTOR 0.02f
+#define CAN_DB_BCM_STATUS_BATTERY_VOLTAGE_OFFSET 0.0f
+#define CAN_DB_BCM_STATUS_BATTERY_VOLTAGE_MAX 900U
+#define CAN_DB_BCM_STATUS_INTERIOR_TEMP_FACTOR 0.5f
+#define CAN_DB_BCM_STATUS_INTERIOR_TEMP_OFFSET 0.0f
+#define CAN_DB_BCM_STATUS_INTERIOR_TEMP_MIN (-80)
+#define CAN_DB_BCM_STATUS_INTERIOR_TEMP_MAX 120
+#define CAN_DB_BCM_STATUS_ROLLING_COUNTER_MAX 15U
+
+void can_db_bcm_status_pack(uint8_t *data, const can_db_bcm_status_t *msg);
+void can_db_bcm_status_unpack(can_db_bcm_status_t *msg, const uint8_t *data);
+bool can_db_bcm_status_check(const can_db_bcm_status_t *msg);
+
+/* GW_Time, 8 bytes, every 1000 ms, from GW */
+#define CAN_DB_GW_TIME_ID 0x1A0U
+#define CAN_DB_GW_TIME_LEN 8U
+#define CAN_DB_GW_TIME_CYCLE_MS 1000U
+
+typedef struct
+{
+    uint64_t utc_time;          /* 0|64@1+ us */
+} can_db_gw_time_t;
+
+
+void can_db_gw_time_pack(uint8_t *data, const can_db_gw_time_t *msg);
+void can_db_gw_time_unpack(can_db_gw_time_t *msg, const uint8_t *data);
+bool can_db_gw_time_check(const can_db_gw_time_t *msg);
+
+/* GW_Odometer, 8 bytes, every 1000 ms, from GW */
+#define CAN_DB_GW_ODOMETER_ID 0x1A1U
+#define CAN_DB_GW_ODOMETER_LEN 8U
+#define CAN_DB_GW_ODOMETER_CYCLE_MS 1000U
+
+typedef struct
+{
+    uint64_t odometer;          /* 7|40@0+ (0.001,0) km */
+    uint32_t trip_counter;      /* 47|20@0+ */
+    uint8_t odometer_status;    /* 59|4@0+ */
+} can_db_gw_odometer_t;
+
+#define CAN_DB_GW_ODOMETER_ODOMETER_FACTOR 0.001f
+#define CAN_DB_GW_ODOMETER_ODOMETER_OFFSET 0.0f
+#define CAN_DB_GW_ODOMETER_ODOMETER_MAX 1099511627775ULL
+#define CAN_DB_GW_ODOMETER_TRIP_COUNTER_MAX 1048575U
+#define CAN_DB_GW_ODOMETER_ODOMETER_STATUS_MAX 2U
+#define CAN_DB_GW_ODOMETER_ODOMETER_STATUS_VALID 0U
+#define CAN_DB_GW_ODOMETER_ODOMETER_STATUS_NOT_CALIBRATED 1U
+#define CAN_DB_GW_ODOMETER_ODOMETER_STATUS_ERROR 2U
+
+void can_db_gw_odometer_pack(uint8_t *data, const can_db_gw_odometer_t *msg);
+void can_db_gw_odometer_unpack(can_db_gw_odometer_t *msg, const uint8_t *data);
+bool can_db_gw_odometer_check(const can_db_gw_odometer_t *msg);
+
+/* ESC_WheelSpeeds, 8 bytes, every 10 ms, from ESC */
+#define CAN_DB_ESC_WHEEL_SPEEDS_ID 0x300U
+#define CAN_DB_ESC_WHEEL_SPEEDS_LEN 8U
+#define CAN_DB_ESC_WHEEL_SPEEDS_CYCLE_MS 10U
+
+typedef struct
+{
+    uint16_t wheel_speed_fl;    /* 7|16@0+ (0.01,0) km/h */
+    uint16_t wheel_speed_fr;    /* 23|16@0+ (0.01,0) km/h */
+    uint16_t wheel_speed_rl;    /* 39|16@0+ (0.01,0) km/h */
+    uint16_t wheel_speed_rr;    /* 55|16@0+ (0.01,0) km/h */
+} can_db_esc_wheel_speeds_t;
+
+#define CAN_DB_ESC_WHEEL_SPEEDS_WHEEL_SPEED_FL_FACTOR 0.01f
+#define CAN_DB_ESC_WHEEL_SPEEDS_WHEEL_SPEED_FL_OFFSET 0.0f
+#define CAN_DB_ESC_WHEEL_SPEEDS_WHEEL_SPEED_FL_MAX 30000U
+#define CAN_DB_ESC_WHEEL_SPEEDS_WHEEL_SPEED_FR_FACTOR 0.01f
+#define CAN_DB_ESC_WHEEL_SPEEDS_WHEEL_SPEED_FR_OFFSET 0.0f
+#define CAN_DB_ESC_WHEEL_SPEEDS_WHEEL_SPEED_FR_MAX 30000U
+#define CAN_DB_ESC_WHEEL_SPEEDS_WHEEL_SPEED_RL_FACTOR 0.01f
+#define CAN_DB_ESC_WHEEL_SPEEDS_WHEEL_SPEED_RL_OFFSET 0.0f
+#define CAN_DB_ESC_WHEEL_SPEEDS_WHEEL_SPEED_RL_MAX 30000U
+#define CAN_DB_ESC_WHEEL_SPEEDS_WHEEL_SPEED_RR_FACTOR 0.01f
+#define CAN_DB_ESC_WHEEL_SPEEDS_WHEEL_SPEED_RR_OFFSET 0.0f
+#define CAN_DB_ESC_WHEEL_SPEEDS_WHEEL_SPEED_RR_MAX 30000U
+
+void can_db_esc_wheel_speeds_pack(uint8_t *data, const can_db_esc_wheel_speeds_t *msg);
+void can_db_esc_wheel_speeds_unpack(can_db_esc_wheel_speeds_t *msg, const uint8_t *data);
+bool can_db_esc_wheel_speeds_check(const can_db_esc_wheel_speeds_t *msg);
+
+/* ESC_YawRate, 8 bytes, every 20 ms, from ESC */
+#define CAN_DB_ESC_YAW_RATE_ID 0x352U
+#define CAN_DB_ESC_YAW_RATE_LEN 8U
+#define CAN_DB_ESC_YAW_RATE_CYCLE_MS 20U
+
+typedef struct
+{
+    int16_t yaw_rate;           /* 7|16@0- (0.01,0) deg/s */
+    int16_t lat_accel;          /* 23|12@0- (0.01,0) m/s2 */
+    int16_t long_accel;         /* 27|12@0- (0.01,0) m/s2 */
+    uint8_t rolling_counter;    /* 51|4@0+ */
+    uint8_t checksum;           /* 63|8@0+ */
+} can_db_esc_yaw_rate_t;
+
+#define CAN_DB_ESC_YAW_RATE_YAW_RATE_FACTOR 0.01f
+#define CAN_DB_ESC_YAW_RATE_YAW_RATE_OFFSET 0.0f
+#define CAN_DB_ESC_YAW_RATE_LAT_ACCEL_FACTOR 0.01f
+#define CAN_DB_ESC_YAW_RATE_LAT_ACCEL_OFFSET 0.0f
+#define CAN_DB_ESC_YAW_RATE_LAT_ACCEL_MIN (-2048)
+#define CAN_DB_ESC_YAW_RATE_LAT_ACCEL_MAX 2047
+#define CAN_DB_ESC_YAW_RATE_LONG_ACCEL_FACTOR 0.01f
+#define CAN_DB_ESC_YAW_RATE_LONG_ACCEL_OFFSET 0.0f
+#define CAN_DB_ESC_YAW_RATE_LONG_ACCEL_MIN (-2048)
+#define CAN_DB_ESC_YAW_RATE_LONG_ACCEL_MAX 2047
+#define CAN_DB_ESC_YAW_RATE_ROLLING_COUNTER_MAX 15U
+
+void can_db_esc_yaw_rate_pack(uint8_t *data, const can_db_esc_yaw_rate_t *msg);
+void can_db_esc_yaw_rate_unpack(can_db_esc_yaw_rate_t *msg, const uint8_t *data);
+bool can_db_esc_yaw_rate_check(const can_db_esc_yaw_rate_t *msg);
+
+/* EEC1, 29 bit ID, 8 bytes, every 10 ms, from EMS */
+#define CAN_DB_EEC1_ID 0xCF00400U
+#define CAN_DB_EEC1_LEN 8U
+#define CAN_DB_EEC1_CYCLE_MS 10U
+
+typedef struct
+{
+    uint8_t engine_torque_mode; /* 0|4@1+ */
+    uint8_t driver_demand_torque; /* 8|8@1+ (1,-125) % */
+    uint8_t actual_engine_torque; /* 16|8@1+ (1,-125) % */
+    uint16_t engine_speed;      /* 24|16@1+ (0.125,0) rpm */
+    uint8_t source_address;     /* 40|8@1+ */
+    uint8_t starter_mode;       /* 48|4@1+ */
+    uint8_t engine_demand_torque; /* 56|8@1+ (1,-125) % */
+} can_db_eec1_t;
+
+#define CAN_DB_EEC1_ENGINE_TORQUE_MODE_MAX 15U
+#define CAN_DB_EEC1_ENGINE_TORQUE_MODE_LOW_IDLE_GOVERNOR 0U
+#define CAN_DB_EEC1_ENGINE_TORQUE_MODE_ACCELERATOR_PEDAL 1U
+#define CAN_DB_EEC1_ENGINE_TORQUE_MODE_CRUISE_CONTROL 2U
+#define CAN_DB_EEC1_ENGINE_TORQUE_MODE_PTO_GOVERNOR 3U
+#define CAN_DB_EEC1_ENGINE_TORQUE_MODE_ROAD_SPEED_GOVERNOR 4U
+#define CAN_DB_EEC1_ENGINE_TORQUE_MODE_ASR_CONTROL 5U
+#define CAN_DB_EEC1_ENGINE_TORQUE_MODE_TRANSMISSION_CONTROL 6U
+#define CAN_DB_EEC1_ENGINE_TORQUE_MODE_ABS_CONTROL 7U
+#define CAN_DB_EEC1_ENGINE_TORQUE_MODE_TORQUE_LIMITING 8U
+#define CAN_DB_EEC1_ENGINE_TORQUE_MODE_HIGH_SPEED_GOVERNOR 9U
+#define CAN_DB_EEC1_ENGINE_TORQUE_MODE_BRAKING_SYSTEM 10U
+#define CAN_DB_EEC1_ENGINE_TORQUE_MODE_REMOTE_ACCELERATOR 11U
+#define CAN_DB_EEC1_ENGINE_TORQUE_MODE_NOT_AVAILABLE 15U
+#define CAN_DB_EEC1_DRIVER_DEMAND_TORQUE_FACTOR 1.0f
+#define CAN_DB_EEC1_DRIVER_DEMAND_TORQUE_OFFSET -125.0f
+#define CAN_DB_EEC1_DRIVER_DEMAND_TORQUE_MAX 250U
+#define CAN_DB_EEC1_ACTUAL_ENGINE_TORQUE_FACTOR 1.0f
+#define CAN_DB_EEC1_ACTUAL_ENGINE_TORQUE_OFFSET -125.0f
+#define CAN_DB_EEC1_ACTUAL_ENGINE_TORQUE_MAX 250U
+#define CAN_DB_EEC1_ENGINE_SPEED_FACTOR 0.125f
+#define CAN_DB_EEC1_ENGINE_SPEED_OFFSET 0.0f
+#define CAN_DB_EEC1_ENGINE_SPEED_MAX 64255U
+#define CAN_DB_EEC1_STARTER_MODE_MAX 15U
+#define CAN_DB_EEC1_ENGINE_DEMAND_TORQUE_FACTOR 1.0f
+#define CAN_DB_EEC1_ENGINE_DEMAND_TORQUE_OFFSET -125.0f
+#define CAN_DB_EEC1_ENGINE_DEMAND_TORQUE_MAX 250U
+
+void can_db_eec1_pack(uint8_t *data, const can_db_eec1_t *msg);
+void can_db_eec1_unpack(can_db_eec1_t *msg, const uint8_t *data);
+bool can_db_eec1_check(const can_db_eec1_t *msg);
+
+/* ET1, 29 bit ID, 8 bytes, every 1000 ms, from EMS */
+#define CAN_DB_ET1_ID 0x18FEEE00U
+#define CAN_DB_ET1_LEN 8U
+#define CAN_DB_ET1_CYCLE_MS 1000U
+
+typedef struct
+{
+    uint8_t engine_coolant_temp; /* 0|8@1+ (1,-40) degC */
+    uint8_t fuel_temp;          /* 8|8@1+ (1,-40) degC */
+    uint16_t engine_oil_temp;   /* 16|16@1+ (0.03125,-273) degC */
+    uint16_t turbo_oil_temp;    /* 32|16@1+ (0.03125,-273) degC */
+    uint8_t intercooler_temp;   /* 48|8@1+ (1,-40) degC */
+    uint8_t thermostat_opening; /* 56|8@1+ (0.4,0) % */
+} can_db_et1_t;
+
+#define CAN_DB_ET1_ENGINE_COOLANT_TEMP_FACTOR 1.0f
+#define CAN_DB_ET1_ENGINE_COOLANT_TEMP_OFFSET -40.0f
+#define CAN_DB_ET1_ENGINE_COOLANT_TEMP_MAX 250U
+#define CAN_DB_ET1_FUEL_TEMP_FACTOR 1.0f
+#define CAN_DB_ET1_FUEL_TEMP_OFFSET -40.0f
+#define CAN_DB_ET1_FUEL_TEMP_MAX 250U
+#define CAN_DB_ET1_ENGINE_OIL_TEMP_FACTOR 0.03125f
+#define CAN_DB_ET1_ENGINE_OIL_TEMP_OFFSET -273.0f
+#define CAN_DB_ET1_ENGINE_OIL_TEMP_MAX 64255U
+#define CAN_DB_ET1_TURBO_OIL_TEMP_FACTOR 0.03125f
+#define CAN_DB_ET1_TURBO_OIL_TEMP_OFFSET -273.0f
+#define CAN_DB_ET1_TURBO_OIL_TEMP_MAX 64255U
+#define CAN_DB_ET1_INTERCOOLER_TEMP_FACTOR 1.0f
+#define CAN_DB_ET1_INTERCOOLER_TEMP_OFFSET -40.0f
+#define CAN_DB_ET1_INTERCOOLER_TEMP_MAX 250U
+#define CAN_DB_ET1_THERMOSTAT_OPENING_FACTOR 0.4f
+#define CAN_DB_ET1_THERMOSTAT_OPENING_OFFSET 0.0f
+#define CAN_DB_ET1_THERMOSTAT_OPENING_MAX 250U
+
+void can_db_et1_pack(uint8_t *data, const can_db_et1_t *msg);
+void can_db_et1_unpack(can_db_et1_t *msg, const uint8_t *data);
+bool can_db_et1_check(const can_db_et1_t *msg);
+
+extern const can_db_msg_t can_db_msg_table[CAN_DB_MSG_NUM];
+#if CAN_DB_SIGNAL_TABLE
+extern const can_db_signal_t can_db_signal_table[CAN_DB_SIGNAL_NUM];
+#endif
+
+#endif
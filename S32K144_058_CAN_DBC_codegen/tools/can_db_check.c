@@ -0,0 +1,463 @@
+/* Host check of the code tools/can_db_gen generated from can_db.dbc.
+ *
+ * can_db_msg.inc is compiled here as it is on the target, together with
+ * can_db_signal_table. A generic codec walks the signal table bit by bit,
+ * the way CAN signals are packed without a generator, and is the reference:
+ *   - pack of random raw values gives the same payload bytes,
+ *   - unpack of random payload bytes gives the same raw values, sign
+ *     extension included,
+ *   - unpack(pack(x)) is x,
+ *   - check() takes every signal at its limits and refuses it one past them.
+ * Then both codecs run over the whole table to compare their speed.
+ *
+ * build: gcc -O2 -I.. -o can_db_check can_db_check.c
+ * usage: can_db_check [-n rounds] [-b iterations]
+ */
+#define CAN_DB_SIGNAL_TABLE 1
+#include "can_db_msg.h"
+#include "can_db_msg.inc"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define STRUCT_SIZE_MAX 256U
+
+static uint64_t rng_state = 0x9E3779B97F4A7C15ULL;
+static uint32_t error_num;
+/* signals of a message in can_db_signal_table, they follow each other */
+static uint32_t msg_signal_first[CAN_DB_MSG_NUM];
+static uint32_t msg_signal_num[CAN_DB_MSG_NUM];
+
+static uint64_t rng(void)
+{
+    /* xorshift64* */
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 0x2545F4914F6CDD1DULL;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+/* @brief: Payload bit of the LSB of a signal. A Motorola start bit is its
+ *         MSB, from there it goes down a byte and on at bit 7 of the next
+ * @param sig : signal
+ * @return    : byte * 8 + bit
+ */
+static uint32_t generic_lsb(const can_db_signal_t *sig)
+{
+    uint32_t pos = sig->start;
+    uint32_t k;
+
+    if (sig->motorola)
+    {
+        for (k = 1U; k < sig->len; k++)
+        {
+            pos = ((pos % 8U) == 0U) ? (pos + 15U) : (pos - 1U);
+        }
+    }
+    return pos;
+}
+
+/* payload bit of the next higher signal bit */
+static uint32_t generic_next(const can_db_signal_t *sig, uint32_t pos)
+{
+    if (!sig->motorola)
+    {
+        return pos + 1U;
+    }
+    return ((pos % 8U) == 7U) ? (pos - 15U) : (pos + 1U);
+}
+
+static int64_t field_get(const can_db_signal_t *sig, const void *msg)
+{
+    const uint8_t *p = (const uint8_t *)msg + sig->field;
+
+    switch (sig->field_size)
+    {
+    case 1U:
+        return sig->is_signed ? (int64_t)*(const int8_t *)p : (int64_t)*(const uint8_t *)p;
+    case 2U:
+        return sig->is_signed ? (int64_t)*(const int16_t *)p : (int64_t)*(const uint16_t *)p;
+    case 4U:
+        return sig->is_signed ? (int64_t)*(const int32_t *)p : (int64_t)*(const uint32_t *)p;
+    default:
+        return *(const int64_t *)p;
+    }
+}
+
+static void field_set(const can_db_signal_t *sig, void *msg, int64_t v)
+{
+    uint8_t *p = (uint8_t *)msg + sig->field;
+
+    switch (sig->field_size)
+    {
+    case 1U:
+        *(uint8_t *)p = (uint8_t)v;
+        break;
+    case 2U:
+        *(uint16_t *)p = (uint16_t)v;
+        break;
+    case 4U:
+        *(uint32_t *)p = (uint32_t)v;
+        break;
+    default:
+        *(int64_t *)p = v;
+        break;
+    }
+}
+
+/* raw value of the signal bits, sign extended */
+static int64_t raw_extend(const can_db_signal_t *sig, uint64_t raw)
+{
+    if (sig->is_signed && (sig->len < 64U) && ((raw >> (sig->len - 1U)) & 1U))
+    {
+        raw |= ~0ULL << sig->len;
+    }
+    return (int64_t)raw;
+}
+
+static uint64_t generic_get(const can_db_signal_t *sig, const uint8_t *data)
+{
+    uint64_t raw = 0U;
+    uint32_t bit = generic_lsb(sig);
+    uint32_t k;
+
+    for (k = 0U; k < sig->len; k++)
+    {
+        raw |= (uint64_t)((data[bit / 8U] >> (bit % 8U)) & 1U) << k;
+        bit = generic_next(sig, bit);
+    }
+    return raw;
+}
+
+static void generic_put(const can_db_signal_t *sig, uint8_t *data, uint64_t raw)
+{
+    uint32_t bit = generic_lsb(sig);
+    uint32_t k;
+
+    for (k = 0U; k < sig->len; k++)
+    {
+        data[bit / 8U] = (uint8_t)((data[bit / 8U] & ~(1U << (bit % 8U))) | (((raw >> k) & 1U) << (bit % 8U)));
+        bit = generic_next(sig, bit);
+    }
+}
+
+static void generic_pack(uint32_t index, uint8_t *data, const void *msg)
+{
+    uint32_t i;
+
+    memset(data, 0, can_db_msg_table[index].len);
+    for (i = msg_signal_first[index]; i < (msg_signal_first[index] + msg_signal_num[index]); i++)
+    {
+        generic_put(&can_db_signal_table[i], data, (uint64_t)field_get(&can_db_signal_table[i], msg));
+    }
+}
+
+static void generic_unpack(uint32_t index, void *msg, const uint8_t *data)
+{
+    uint32_t i;
+
+    for (i = msg_signal_first[index]; i < (msg_signal_first[index] + msg_signal_num[index]); i++)
+    {
+        field_set(&can_db_signal_table[i], msg,
+                  raw_extend(&can_db_signal_table[i], generic_get(&can_db_signal_table[i], data)));
+    }
+}
+
+static void report(const char *what, uint32_t index, const char *name)
+{
+    if (error_num < 20U)
+    {
+        fprintf(stderr, "%s: message 0x%X %s\n", what, (unsigned int)can_db_msg_table[index].id, name);
+    }
+    error_num++;
+}
+
+/* random raw values that fit the signal bits */
+static void random_fill(uint32_t index, void *msg)
+{
+    uint32_t i;
+
+    memset(msg, 0, can_db_msg_table[index].size);
+    for (i = 0U; i < CAN_DB_SIGNAL_NUM; i++)
+    {
+        const can_db_signal_t *sig = &can_db_signal_table[i];
+        uint64_t raw = rng();
+
+        if (sig->msg != index)
+        {
+            continue;
+        }
+        if (sig->len < 64U)
+        {
+            raw &= (1ULL << sig->len) - 1U;
+        }
+        field_set(sig, msg, raw_extend(sig, raw));
+    }
+}
+
+static void round_trip(uint32_t index)
+{
+    const can_db_msg_t *m = &can_db_msg_table[index];
+    uint8_t msg[STRUCT_SIZE_MAX];
+    uint8_t back[STRUCT_SIZE_MAX];
+    uint8_t data[CAN_DB_PAYLOAD_MAX];
+    uint8_t ref[CAN_DB_PAYLOAD_MAX];
+    uint32_t i;
+
+    /* pack */
+    random_fill(index, msg);
+    memset(data, 0xA5, sizeof(data));
+    m->pack(data, msg);
+    generic_pack(index, ref, msg);
+    if (memcmp(data, ref, m->len) != 0)
+    {
+        report("pack differs", index, "");
+    }
+    memset(back, 0, sizeof(back));
+    m->unpack(back, data);
+    if (memcmp(back, msg, m->size) != 0)
+    {
+        report("unpack(pack(x)) differs", index, "");
+    }
+
+    /* unpack */
+    for (i = 0U; i < m->len; i++)
+    {
+        data[i] = (uint8_t)rng();
+    }
+    memset(msg, 0, sizeof(msg));
+    memset(back, 0, sizeof(back));
+    m->unpack(msg, data);
+    generic_unpack(index, back, data);
+    for (i = 0U; i < CAN_DB_SIGNAL_NUM; i++)
+    {
+        const can_db_signal_t *sig = &can_db_signal_table[i];
+
+        if ((sig->msg == index) && (field_get(sig, msg) != field_get(sig, back)))
+        {
+            report("unpack differs", index, sig->name);
+        }
+    }
+}
+
+/* every signal of the message at its lower limit is always valid */
+static void limits_low(uint32_t index, void *msg)
+{
+    uint32_t i;
+
+    memset(msg, 0, can_db_msg_table[index].size);
+    for (i = 0U; i < CAN_DB_SIGNAL_NUM; i++)
+    {
+        const can_db_signal_t *sig = &can_db_signal_table[i];
+
+        if ((sig->msg == index) && sig->low_check)
+        {
+            field_set(sig, msg, sig->low);
+        }
+    }
+}
+
+static bool field_holds(const can_db_signal_t *sig, int64_t v)
+{
+    uint32_t bits = (uint32_t)sig->field_size * 8U;
+
+    if (bits == 64U)
+    {
+        return true;
+    }
+    if (sig->is_signed)
+    {
+        return (v >= -(1LL << (bits - 1U))) && (v < (1LL << (bits - 1U)));
+    }
+    return (v >= 0) && (v < (1LL << bits));
+}
+
+static void range_check(uint32_t index)
+{
+    const can_db_msg_t *m = &can_db_msg_table[index];
+    uint8_t msg[STRUCT_SIZE_MAX];
+    uint32_t i;
+
+    limits_low(index, msg);
+    if (!m->check(msg))
+    {
+        report("check() refuses the lower limits", index, "");
+    }
+    for (i = 0U; i < CAN_DB_SIGNAL_NUM; i++)
+    {
+        const can_db_signal_t *sig = &can_db_signal_table[i];
+
+        if (sig->msg != index)
+        {
+            continue;
+        }
+        limits_low(index, msg);
+        if (sig->high_check)
+        {
+            field_set(sig, msg, sig->high);
+            if (!m->check(msg))
+            {
+                report("check() refuses the upper limit", index, sig->name);
+            }
+            if (field_holds(sig, sig->high + 1))
+            {
+                field_set(sig, msg, sig->high + 1);
+                if (m->check(msg))
+                {
+                    report("check() takes the upper limit + 1", index, sig->name);
+                }
+            }
+        }
+        limits_low(index, msg);
+        if (sig->low_check && field_holds(sig, sig->low - 1))
+        {
+            field_set(sig, msg, sig->low - 1);
+            if (m->check(msg))
+            {
+                report("check() takes the lower limit - 1", index, sig->name);
+            }
+        }
+    }
+}
+
+/* @brief: Time pack and unpack of all messages, generated and generic
+ * @param iterations : rounds over the table
+ * @return           : None
+ */
+static void bench(uint32_t iterations)
+{
+    static uint8_t msgs[CAN_DB_MSG_NUM][STRUCT_SIZE_MAX];
+    static uint8_t data[CAN_DB_MSG_NUM][CAN_DB_PAYLOAD_MAX];
+    uint64_t t[4];
+    uint64_t start;
+    uint32_t signal_bits = 0U;
+    uint32_t frames = iterations * CAN_DB_MSG_NUM;
+    uint32_t n;
+    uint32_t i;
+    volatile uint8_t sink = 0U;
+
+    for (i = 0U; i < CAN_DB_MSG_NUM; i++)
+    {
+        random_fill(i, msgs[i]);
+    }
+    for (i = 0U; i < CAN_DB_SIGNAL_NUM; i++)
+    {
+        signal_bits += can_db_signal_table[i].len;
+    }
+
+    start = now_ns();
+    for (n = 0U; n < iterations; n++)
+    {
+        for (i = 0U; i < CAN_DB_MSG_NUM; i++)
+        {
+            msgs[i][0] ^= (uint8_t)n;
+            can_db_msg_table[i].pack(data[i], msgs[i]);
+            sink ^= data[i][n % can_db_msg_table[i].len];
+        }
+    }
+    t[0] = now_ns() - start;
+
+    start = now_ns();
+    for (n = 0U; n < iterations; n++)
+    {
+        for (i = 0U; i < CAN_DB_MSG_NUM; i++)
+        {
+            msgs[i][0] ^= (uint8_t)n;
+            generic_pack(i, data[i], msgs[i]);
+            sink ^= data[i][n % can_db_msg_table[i].len];
+        }
+    }
+    t[1] = now_ns() - start;
+
+    start = now_ns();
+    for (n = 0U; n < iterations; n++)
+    {
+        for (i = 0U; i < CAN_DB_MSG_NUM; i++)
+        {
+            data[i][0] ^= (uint8_t)n;
+            can_db_msg_table[i].unpack(msgs[i], data[i]);
+            sink ^= msgs[i][0];
+        }
+    }
+    t[2] = now_ns() - start;
+
+    start = now_ns();
+    for (n = 0U; n < iterations; n++)
+    {
+        for (i = 0U; i < CAN_DB_MSG_NUM; i++)
+        {
+            data[i][0] ^= (uint8_t)n;
+            generic_unpack(i, msgs[i], data[i]);
+            sink ^= msgs[i][0];
+        }
+    }
+    t[3] = now_ns() - start;
+    (void)sink;
+
+    printf("%u messages, %u signals, %u signal bits, %u frames each\n", CAN_DB_MSG_NUM, CAN_DB_SIGNAL_NUM, signal_bits,
+           frames);
+    printf("pack:   generated %7.1f ns/frame, bit by bit %7.1f ns/frame, %.1fx\n", (double)t[0] / frames,
+           (double)t[1] / frames, (double)t[1] / (double)t[0]);
+    printf("unpack: generated %7.1f ns/frame, bit by bit %7.1f ns/frame, %.1fx\n", (double)t[2] / frames,
+           (double)t[3] / frames, (double)t[3] / (double)t[2]);
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t rounds = 100000U;
+    uint32_t iterations = 200000U;
+    uint32_t n;
+    uint32_t i;
+    int arg;
+
+    for (arg = 1; arg < argc; arg++)
+    {
+        if ((strcmp(argv[arg], "-n") == 0) && ((arg + 1) < argc))
+        {
+            rounds = (uint32_t)strtoul(argv[++arg], NULL, 0);
+        }
+        else if ((strcmp(argv[arg], "-b") == 0) && ((arg + 1) < argc))
+        {
+            iterations = (uint32_t)strtoul(argv[++arg], NULL, 0);
+        }
+        else
+        {
+            fprintf(stderr, "usage: can_db_check [-n rounds] [-b iterations]\n");
+            return 2;
+        }
+    }
+
+    for (i = CAN_DB_SIGNAL_NUM; i > 0U; i--)
+    {
+        msg_signal_first[can_db_signal_table[i - 1U].msg] = i - 1U;
+        msg_signal_num[can_db_signal_table[i - 1U].msg]++;
+    }
+    for (i = 0U; i < CAN_DB_MSG_NUM; i++)
+    {
+        if (can_db_msg_table[i].size > STRUCT_SIZE_MAX)
+        {
+            fprintf(stderr, "message struct larger than %u bytes\n", STRUCT_SIZE_MAX);
+            return 1;
+        }
+        for (n = 0U; n < rounds; n++)
+        {
+            round_trip(i);
+        }
+        range_check(i);
+    }
+    printf("round trip of %u random frames per message: %s, %u errors\n", rounds, error_num == 0U ? "ok" : "FAILED",
+           error_num);
+    if ((error_num == 0U) && (iterations != 0U))
+    {
+        bench(iterations);
+    }
+    return (error_num == 0U) ? 0 : 1;
+}
@@ -0,0 +1,1205 @@
+/* Host side generator for the CAN signals of a DBC file.
+ *
+ * Every message of the DBC becomes a struct with one raw integer field per
+ * signal and three functions:
+ *   can_db_<msg>_pack()   struct to payload
+ *   can_db_<msg>_unpack() payload to struct
+ *   can_db_<msg>_check()  raw values within the [min|max] of the DBC
+ * The bit layout is resolved here: pack writes every payload byte as one
+ * expression of shifted and masked fields, unpack reads every field as one
+ * expression of shifted and masked bytes, a signed field is sign extended
+ * with an xor and a subtraction. None of them loops or branches. Intel and
+ * Motorola byte order, signals up to 64 bits and CAN FD payloads up to 64
+ * bytes are supported, multiplexed signals are not.
+ *
+ * can_db_msg_table lists the messages sorted by CAN ID for can_db.c, which
+ * hands them to can_lld_tx() and takes them from the RX path. Messages sent
+ * by the node given with -n are TX messages, all others are received.
+ * can_db_signal_table describes every signal for generic code such as
+ * tools/can_db_check, it is only compiled with CAN_DB_SIGNAL_TABLE set.
+ *
+ * build: gcc -O2 -o can_db_gen can_db_gen.c -lm
+ * usage: can_db_gen [-n node] can_db.dbc can_db_msg.h can_db_msg.inc
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+
+#define LINE_SIZE 4096U
+#define NAME_SIZE 64U
+#define MSG_MAX 512U
+#define SIGNAL_MAX 4096U
+#define VALUE_MAX 4096U
+#define PAYLOAD_MAX 64U
+#define SIGNAL_BITS_MAX 64U
+#define EXPR_SIZE 4096U
+#define EXPR_PIECE_SIZE 256U
+#define EXPR_LINE_MAX 120U
+/* unused payload bytes cleared with memset from this many on */
+#define ZERO_RUN_MIN 4U
+
+/* bit 31 of a DBC message ID marks a 29 bit ID */
+#define DBC_ID_EXT 0x80000000U
+#define DBC_ID_MASK 0x1FFFFFFFU
+/* messages of signals which belong to no message */
+#define DBC_ID_INDEPENDENT 0xC0000000U
+/* VFrameFormat attribute values of CAN FD frames */
+#define DBC_FRAME_FD_STD 14U
+#define DBC_FRAME_FD_EXT 15U
+
+typedef struct
+{
+    char name[NAME_SIZE];
+    char cname[NAME_SIZE];      /* snake case */
+    char unit[NAME_SIZE];
+    uint32_t start;
+    uint32_t len;
+    bool motorola;
+    bool is_signed;
+    double factor;
+    double offset;
+    double min;
+    double max;
+    uint32_t bits[SIGNAL_BITS_MAX];     /* payload bit of each signal bit,
+                                         * LSB first, byte * 8 + bit */
+    uint32_t width;     /* bits of the struct field */
+    bool low_check;     /* raw limits compared by check() */
+    bool high_check;
+    int64_t low;
+    int64_t high;
+} signal_t;
+
+typedef struct
+{
+    char name[NAME_SIZE];
+    char cname[NAME_SIZE];
+    char sender[NAME_SIZE];
+    uint32_t dbc_id;
+    uint32_t id;
+    bool ext;
+    bool fd;
+    bool tx;
+    uint32_t len;
+    uint32_t cycle_ms;
+    uint32_t signal_first;
+    uint32_t signal_num;
+} message_t;
+
+typedef struct
+{
+    uint32_t dbc_id;
+    char signal[NAME_SIZE];
+    int64_t value;
+    char name[NAME_SIZE];
+} value_t;
+
+static message_t messages[MSG_MAX];
+static uint32_t message_num;
+/* signals in DBC order, a message owns a contiguous run of them */
+static signal_t signals[SIGNAL_MAX];
+static uint32_t signal_num;
+static value_t values[VALUE_MAX];
+static uint32_t value_num;
+static uint32_t line_num;
+static const char *node = "S32K144";
+
+static void fail(const char *msg)
+{
+    fprintf(stderr, "can_db_gen: line %u: %s\n", line_num, msg);
+    exit(1);
+}
+
+/* @brief: C name of a DBC name, EngineSpeed -> engine_speed,
+ *         ECU_FdStatus -> ecu_fd_status, EEC1 -> eec1
+ * @param in  : DBC name
+ * @param out : NAME_SIZE bytes
+ * @return    : None
+ */
+static void snake_case(const char *in, char *out)
+{
+    uint32_t n = 0U;
+    uint32_t i;
+    char c;
+
+    for (i = 0U; (in[i] != '\0') && (n < (NAME_SIZE - 2U)); i++)
+    {
+        c = in[i];
+        if (!isalnum((unsigned char)c))
+        {
+            c = '_';
+        }
+        else if (isupper((unsigned char)c) && (i > 0U) &&
+                 (islower((unsigned char)in[i - 1U]) || isdigit((unsigned char)in[i - 1U]) ||
+                  (isupper((unsigned char)in[i - 1U]) && islower((unsigned char)in[i + 1U]))))
+        {
+            out[n++] = '_';
+        }
+        if ((c == '_') && ((n == 0U) || (out[n - 1U] == '_')))
+        {
+            continue;
+        }
+        out[n++] = (char)tolower((unsigned char)c);
+    }
+    while ((n > 0U) && (out[n - 1U] == '_'))
+    {
+        n--;
+    }
+    out[n] = '\0';
+    if ((n == 0U) || isdigit((unsigned char)out[0]))
+    {
+        fail("name does not give a C identifier");
+    }
+}
+
+static void upper_case(const char *in, char *out)
+{
+    uint32_t i;
+
+    for (i = 0U; in[i] != '\0'; i++)
+    {
+        out[i] = (char)toupper((unsigned char)in[i]);
+    }
+    out[i] = '\0';
+}
+
+static bool fd_len_valid(uint32_t len)
+{
+    return (len <= 8U) || (len == 12U) || (len == 16U) || (len == 20U) ||
+           (len == 24U) || (len == 32U) || (len == 48U) || (len == 64U);
+}
+
+static message_t *message_find(uint32_t dbc_id)
+{
+    uint32_t i;
+
+    for (i = 0U; i < message_num; i++)
+    {
+        if (messages[i].dbc_id == dbc_id)
+        {
+            return &messages[i];
+        }
+    }
+    return NULL;
+}
+
+static signal_t *signal_find(const message_t *msg, const char *name)
+{
+    uint32_t i;
+
+    for (i = msg->signal_first; i < (msg->signal_first + msg->signal_num); i++)
+    {
+        if (strcmp(signals[i].name, name) == 0)
+        {
+            return &signals[i];
+        }
+    }
+    return NULL;
+}
+
+/* @brief: Payload bit of every signal bit. An Intel signal starts at its
+ *         LSB and counts up. A Motorola signal starts at its MSB and counts
+ *         down within a byte, then goes on at bit 7 of the next byte
+ * @param sig : signal, bits is filled
+ * @param len : payload bytes
+ * @return    : None
+ */
+static void signal_layout(signal_t *sig, uint32_t len)
+{
+    uint32_t pos = sig->start;
+    uint32_t k;
+
+    for (k = 0U; k < sig->len; k++)
+    {
+        if (pos >= (len * 8U))
+        {
+            fail("signal does not fit the payload");
+        }
+        if (!sig->motorola)
+        {
+            sig->bits[k] = pos++;
+        }
+        else
+        {
+            sig->bits[sig->len - 1U - k] = pos;
+            pos = ((pos % 8U) == 0U) ? (pos + 15U) : (pos - 1U);
+        }
+    }
+}
+
+/* @brief: Raw limits of the physical [min|max] of the DBC. Only the limits
+ *         narrower than the field type are compared, a limit narrower than
+ *         the signal bits is compared too, so check() also finds a field
+ *         that does not fit its bits. [0|0] means no limit
+ * @param sig : signal
+ * @return    : None
+ */
+static void signal_limits(signal_t *sig)
+{
+    double bits_low = sig->is_signed ? -ldexp(1.0, (int)sig->len - 1) : 0.0;
+    double bits_high = sig->is_signed ? (ldexp(1.0, (int)sig->len - 1) - 1.0) : (ldexp(1.0, (int)sig->len) - 1.0);
+    double type_low = sig->is_signed ? -ldexp(1.0, (int)sig->width - 1) : 0.0;
+    double type_high = sig->is_signed ? (ldexp(1.0, (int)sig->width - 1) - 1.0) : (ldexp(1.0, (int)sig->width) - 1.0);
+    double low = bits_low;
+    double high = bits_high;
+    double a;
+    double b;
+
+    if ((sig->min != 0.0) || (sig->max != 0.0))
+    {
+        a = (sig->min - sig->offset) / sig->factor;
+        b = (sig->max - sig->offset) / sig->factor;
+        if (a > b)
+        {
+            double t = a;
+            a = b;
+            b = t;
+        }
+        /* the DBC limits are rounded to its factor */
+        a = ceil(a - 1e-6);
+        b = floor(b + 1e-6);
+        low = (a > bits_low) ? a : bits_low;
+        high = (b < bits_high) ? b : bits_high;
+        if (low > high)
+        {
+            fprintf(stderr, "can_db_gen: line %u: range of %s outside its bits, not checked\n", line_num, sig->name);
+            low = bits_low;
+            high = bits_high;
+        }
+    }
+    /* a 64 bit unsigned limit above INT64_MAX is not kept */
+    sig->low_check = low > type_low;
+    sig->high_check = (high < type_high) && (high < 9.2e18);
+    sig->low = (int64_t)low;
+    sig->high = (high < 9.2e18) ? (int64_t)high : INT64_MAX;
+}
+
+/* @brief: BO_ <id> <name>: <len> <sender>
+ * @param p : after "BO_ "
+ * @return  : None
+ */
+static void parse_message(const char *p)
+{
+    message_t *msg;
+    char name[NAME_SIZE];
+    char sender[NAME_SIZE];
+    unsigned long dbc_id;
+    unsigned int len;
+
+    if (sscanf(p, "%lu %63[^: ] : %u %63s", &dbc_id, name, &len, sender) != 4)
+    {
+        fail("bad BO_ line");
+    }
+    if ((uint32_t)dbc_id == DBC_ID_INDEPENDENT)
+    {
+        return;
+    }
+    if (message_num >= MSG_MAX)
+    {
+        fail("too many messages");
+    }
+    if ((len > PAYLOAD_MAX) || !fd_len_valid(len))
+    {
+        fail("message length no DLC can code");
+    }
+    if (message_find((uint32_t)dbc_id) != NULL)
+    {
+        fail("message ID used twice");
+    }
+
+    msg = &messages[message_num++];
+    memset(msg, 0, sizeof(*msg));
+    strcpy(msg->name, name);
+    snake_case(name, msg->cname);
+    strcpy(msg->sender, sender);
+    msg->dbc_id = (uint32_t)dbc_id;
+    msg->ext = (msg->dbc_id & DBC_ID_EXT) != 0U;
+    msg->id = msg->dbc_id & DBC_ID_MASK;
+    if (!msg->ext && (msg->id > 0x7FFU))
+    {
+        fail("standard ID above 0x7FF");
+    }
+    msg->len = len;
+    msg->fd = len > 8U;
+    msg->tx = strcmp(sender, node) == 0;
+    msg->signal_first = signal_num;
+}
+
+/* @brief: SG_ <name> [mux] : <start>|<len>@<order><sign> (<factor>,<offset>)
+ *         [<min>|<max>] "<unit>" <receivers>
+ * @param p   : after "SG_ "
+ * @param msg : message of the signal
+ * @return    : None
+ */
+static void parse_signal(const char *p, message_t *msg)
+{
+    signal_t *sig;
+    char name[NAME_SIZE];
+    char mux[NAME_SIZE];
+    unsigned int start;
+    unsigned int len;
+    char order;
+    char sign;
+    int n = 0;
+    uint32_t i;
+
+    if (signal_num >= SIGNAL_MAX)
+    {
+        fail("too many signals");
+    }
+    sig = &signals[signal_num];
+    memset(sig, 0, sizeof(*sig));
+    if (sscanf(p, "%63s %n", name, &n) != 1)
+    {
+        fail("bad SG_ line");
+    }
+    p += n;
+    if (*p != ':')
+    {
+        if ((sscanf(p, "%63s %n", mux, &n) != 1) || (p[n] != ':'))
+        {
+            fail("bad SG_ line");
+        }
+        fail("multiplexed signals are not supported");
+    }
+    p++;
+    if (sscanf(p, " %u|%u@%c%c ( %lf , %lf ) [ %lf | %lf ] \"%63[^\"]\"", &start, &len, &order, &sign,
+               &sig->factor, &sig->offset, &sig->min, &sig->max, sig->unit) < 8)
+    {
+        fail("bad SG_ line");
+    }
+    if ((len == 0U) || (len > SIGNAL_BITS_MAX) || ((order != '0') && (order != '1')) ||
+        ((sign != '+') && (sign != '-')) || (sig->factor == 0.0))
+    {
+        fail("bad signal layout or factor");
+    }
+    if (signal_find(msg, name) != NULL)
+    {
+        fail("signal name used twice in its message");
+    }
+
+    strcpy(sig->name, name);
+    snake_case(name, sig->cname);
+    sig->start = start;
+    sig->len = len;
+    sig->motorola = order == '0';
+    sig->is_signed = sign == '-';
+    sig->width = (len <= 8U) ? 8U : ((len <= 16U) ? 16U : ((len <= 32U) ? 32U : 64U));
+    signal_layout(sig, msg->len);
+    signal_limits(sig);
+
+    /* no bit is written by two signals */
+    for (i = msg->signal_first; i < signal_num; i++)
+    {
+        uint32_t a;
+        uint32_t b;
+
+        for (a = 0U; a < signals[i].len; a++)
+        {
+            for (b = 0U; b < sig->len; b++)
+            {
+                if (signals[i].bits[a] == sig->bits[b])
+                {
+                    fail("signals overlap");
+                }
+            }
+        }
+    }
+    signal_num++;
+    msg->signal_num++;
+}
+
+/* @brief: BA_ "GenMsgCycleTime" BO_ <id> <ms>; and
+ *         BA_ "VFrameFormat" BO_ <id> <format>;
+ * @param p : after "BA_ "
+ * @return  : None
+ */
+static void parse_attribute(const char *p)
+{
+    message_t *msg;
+    char attr[NAME_SIZE];
+    unsigned long dbc_id;
+    unsigned long value;
+
+    if (sscanf(p, "\"%63[^\"]\" BO_ %lu %lu", attr, &dbc_id, &value) != 3)
+    {
+        return;
+    }
+    msg = message_find((uint32_t)dbc_id);
+    if (msg == NULL)
+    {
+        return;
+    }
+    if (strcmp(attr, "GenMsgCycleTime") == 0)
+    {
+        if (value > 0xFFFFU)
+        {
+            fail("cycle time above 65535 ms");
+        }
+        msg->cycle_ms = (uint32_t)value;
+    }
+    else if (strcmp(attr, "VFrameFormat") == 0)
+    {
+        msg->fd = msg->fd || (value == DBC_FRAME_FD_STD) || (value == DBC_FRAME_FD_EXT);
+    }
+}
+
+/* @brief: VAL_ <id> <signal> <value> "<name>" ... ;
+ * @param p : after "VAL_ "
+ * @return  : None
+ */
+static void parse_values(const char *p)
+{
+    message_t *msg;
+    value_t *val;
+    char signal[NAME_SIZE];
+    char text[NAME_SIZE];
+    unsigned long dbc_id;
+    long long value;
+    int n = 0;
+
+    if (sscanf(p, "%lu %63s %n", &dbc_id, signal, &n) != 2)
+    {
+        return;
+    }
+    msg = message_find((uint32_t)dbc_id);
+    if ((msg == NULL) || (signal_find(msg, signal) == NULL))
+    {
+        fail("VAL_ of an unknown signal");
+    }
+    p += n;
+    while (sscanf(p, "%lld \"%63[^\"]\" %n", &value, text, &n) == 2)
+    {
+        if (value_num >= VALUE_MAX)
+        {
+            fail("too many values");
+        }
+        val = &values[value_num++];
+        val->dbc_id = (uint32_t)dbc_id;
+        strcpy(val->signal, signal);
+        val->value = value;
+        snake_case(text, val->name);
+        p += n;
+    }
+}
+
+static void load_dbc(FILE *dbc)
+{
+    char line[LINE_SIZE];
+    message_t *msg = NULL;
+    const char *p;
+
+    while (fgets(line, sizeof(line), dbc) != NULL)
+    {
+        line_num++;
+        if (strchr(line, '\n') == NULL && !feof(dbc))
+        {
+            fail("line too long");
+        }
+        p = line;
+        while (isspace((unsigned char)*p))
+        {
+            p++;
+        }
+        if (strncmp(p, "BO_ ", 4U) == 0)
+        {
+            uint32_t before = message_num;
+
+            parse_message(p + 4);
+            msg = (message_num != before) ? &messages[message_num - 1U] : NULL;
+        }
+        else if (strncmp(p, "SG_ ", 4U) == 0)
+        {
+            if (msg != NULL)
+            {
+                parse_signal(p + 4, msg);
+            }
+        }
+        else
+        {
+            msg = NULL;
+            if (strncmp(p, "BA_ ", 4U) == 0)
+            {
+                parse_attribute(p + 4);
+            }
+            else if (strncmp(p, "VAL_ ", 5U) == 0)
+            {
+                parse_values(p + 5);
+            }
+        }
+    }
+    line_num = 0U;
+}
+
+/* standard IDs first, then by ID, the order can_db_rx() searches in */
+static int message_cmp(const void *a, const void *b)
+{
+    const message_t *x = a;
+    const message_t *y = b;
+
+    if (x->ext != y->ext)
+    {
+        return x->ext ? 1 : -1;
+    }
+    return (x->id > y->id) - (x->id < y->id);
+}
+
+static const char *field_type(const signal_t *sig)
+{
+    static const char *const types[2][4] = {
+        {"uint8_t", "uint16_t", "uint32_t", "uint64_t"},
+        {"int8_t", "int16_t", "int32_t", "int64_t"},
+    };
+    uint32_t i = (sig->width == 8U) ? 0U : ((sig->width == 16U) ? 1U : ((sig->width == 32U) ? 2U : 3U));
+
+    return types[sig->is_signed ? 1 : 0][i];
+}
+
+static const char *uint_type(uint32_t width)
+{
+    return (width == 8U) ? "uint8_t" : ((width == 16U) ? "uint16_t" : ((width == 32U) ? "uint32_t" : "uint64_t"));
+}
+
+static const char *suffix(uint32_t width)
+{
+    return (width == 64U) ? "ULL" : "U";
+}
+
+/* @brief: Float constant in C, always with a point or an exponent
+ * @param v   : value
+ * @param out : at least 32 bytes
+ * @return    : out
+ */
+static char *float_text(double v, char *out)
+{
+    snprintf(out, 32U, "%.9g", v);
+    if (strpbrk(out, ".en") == NULL)
+    {
+        strcat(out, ".0");
+    }
+    strcat(out, "f");
+    return out;
+}
+
+static char *int64_text(int64_t v, char *out)
+{
+    if (v == INT64_MIN)
+    {
+        snprintf(out, 32U, "(-%lldLL - 1LL)", (long long)INT64_MAX);
+    }
+    else
+    {
+        snprintf(out, 32U, "%lldLL", (long long)v);
+    }
+    return out;
+}
+
+static void int_text(const signal_t *sig, int64_t v, char *out)
+{
+    if (!sig->is_signed)
+    {
+        snprintf(out, 32U, "%llu%s", (unsigned long long)v, suffix(sig->width));
+    }
+    else if ((sig->width == 64U) && (v < -INT64_MAX))
+    {
+        snprintf(out, 32U, "(-%lldLL - 1LL)", (long long)INT64_MAX);
+    }
+    else if ((sig->width == 32U) && (v < -(int64_t)INT32_MAX))
+    {
+        snprintf(out, 32U, "(-%ld - 1)", (long)INT32_MAX);
+    }
+    else
+    {
+        snprintf(out, 32U, (v < 0) ? "(%lld%s)" : "%lld%s", (long long)v, (sig->width == 64U) ? "LL" : "");
+    }
+}
+
+/* @brief: Signal bits that land in one payload byte. They are contiguous
+ *         with both byte orders and ascend with the bits of the byte
+ * @param sig  : signal
+ * @param byte : payload byte
+ * @param k0   : first signal bit
+ * @param b0   : its bit in the byte
+ * @return     : number of bits, 0 if the signal has none there
+ */
+static uint32_t signal_piece(const signal_t *sig, uint32_t byte, uint32_t *k0, uint32_t *b0)
+{
+    uint32_t n = 0U;
+    uint32_t k;
+
+    for (k = 0U; k < sig->len; k++)
+    {
+        if ((sig->bits[k] / 8U) == byte)
+        {
+            if (n == 0U)
+            {
+                *k0 = k;
+                *b0 = sig->bits[k] % 8U;
+            }
+            n++;
+        }
+    }
+    return n;
+}
+
+/* @brief: Append the pieces of an expression joined by " | ", a new line
+ *         starts before the line gets longer than EXPR_LINE_MAX
+ * @param expr   : expression so far
+ * @param col    : column of the end of expr, updated
+ * @param piece  : piece to append
+ * @param indent : indent of a new line
+ * @return       : None
+ */
+static void expr_append(char *expr, uint32_t *col, const char *piece, uint32_t indent)
+{
+    size_t len = strlen(piece);
+
+    if (expr[0] != '\0')
+    {
+        if ((*col + 3U + len) > EXPR_LINE_MAX)
+        {
+            snprintf(expr + strlen(expr), EXPR_SIZE - strlen(expr), "\n%*s| ", (int)indent, "");
+            *col = indent + 2U;
+        }
+        else
+        {
+            strcat(expr, " | ");
+            *col += 3U;
+        }
+    }
+    if ((strlen(expr) + len) >= EXPR_SIZE)
+    {
+        fail("expression too long");
+    }
+    strcat(expr, piece);
+    *col += (uint32_t)len;
+}
+
+static void write_pack(FILE *out, const message_t *msg)
+{
+    char expr[EXPR_SIZE];
+    char piece[EXPR_PIECE_SIZE * 2U];
+    char src[EXPR_PIECE_SIZE];
+    uint32_t byte;
+    uint32_t zero;
+    uint32_t col;
+    uint32_t pieces;
+    uint32_t i;
+    uint32_t k0;
+    uint32_t b0;
+    uint32_t n;
+
+    fprintf(out, "void can_db_%s_pack(uint8_t *data, const can_db_%s_t *msg)\n{\n", msg->cname, msg->cname);
+    for (byte = 0U; byte < msg->len; byte++)
+    {
+        expr[0] = '\0';
+        col = 24U;
+        pieces = 0U;
+        for (i = msg->signal_first; i < (msg->signal_first + msg->signal_num); i++)
+        {
+            const signal_t *sig = &signals[i];
+
+            n = signal_piece(sig, byte, &k0, &b0);
+            if (n == 0U)
+            {
+                continue;
+            }
+            if (sig->is_signed)
+            {
+                snprintf(src, sizeof(src), "(%s)msg->%s", uint_type(sig->width), sig->cname);
+            }
+            else
+            {
+                snprintf(src, sizeof(src), "msg->%s", sig->cname);
+            }
+            if (k0 != 0U)
+            {
+                snprintf(piece, sizeof(piece), "(%s >> %uU)", src, k0);
+                strcpy(src, piece);
+            }
+            /* the cast to uint8_t drops the bits above the byte */
+            if ((b0 + n) != 8U)
+            {
+                snprintf(piece, sizeof(piece), "(%s & 0x%XU)", src, (1U << n) - 1U);
+                strcpy(src, piece);
+            }
+            if (b0 != 0U)
+            {
+                snprintf(piece, sizeof(piece), "(%s << %uU)", src, b0);
+                strcpy(src, piece);
+            }
+            expr_append(expr, &col, src, 14U);
+            pieces++;
+        }
+
+        if (pieces == 0U)
+        {
+            /* unused bytes are 0, a run of them is cleared at once */
+            for (zero = byte; zero < msg->len; zero++)
+            {
+                for (i = msg->signal_first; i < (msg->signal_first + msg->signal_num); i++)
+                {
+                    if (signal_piece(&signals[i], zero, &k0, &b0) != 0U)
+                    {
+                        break;
+                    }
+                }
+                if (i != (msg->signal_first + msg->signal_num))
+                {
+                    break;
+                }
+            }
+            if ((zero - byte) >= ZERO_RUN_MIN)
+            {
+                fprintf(out, "    (void)memset(&data[%u], 0, %uU);\n", byte, zero - byte);
+                byte = zero - 1U;
+            }
+            else
+            {
+                fprintf(out, "    data[%u] = 0U;\n", byte);
+            }
+        }
+        else if (pieces == 1U)
+        {
+            fprintf(out, "    data[%u] = (uint8_t)%s;\n", byte, expr);
+        }
+        else
+        {
+            fprintf(out, "    data[%u] = (uint8_t)(%s);\n", byte, expr);
+        }
+    }
+    if (msg->len == 0U)
+    {
+        fprintf(out, "    (void)data;\n");
+    }
+    if (msg->signal_num == 0U)
+    {
+        fprintf(out, "    (void)msg;\n");
+    }
+    fprintf(out, "}\n\n");
+}
+
+static void write_unpack(FILE *out, const message_t *msg)
+{
+    char expr[EXPR_SIZE];
+    char piece[EXPR_PIECE_SIZE];
+    char lead[EXPR_PIECE_SIZE];
+    uint32_t byte;
+    uint32_t col;
+    uint32_t pieces;
+    uint32_t bits;
+    uint32_t i;
+    uint32_t k0 = 0U;
+    uint32_t b0 = 0U;
+    uint32_t n;
+
+    fprintf(out, "void can_db_%s_unpack(can_db_%s_t *msg, const uint8_t *data)\n{\n", msg->cname, msg->cname);
+    for (i = msg->signal_first; i < (msg->signal_first + msg->signal_num); i++)
+    {
+        const signal_t *sig = &signals[i];
+        const char *ut = uint_type(sig->width);
+        bool extend = sig->is_signed && (sig->len < sig->width);
+
+        snprintf(lead, sizeof(lead), "    msg->%s = ", sig->cname);
+        expr[0] = '\0';
+        col = (uint32_t)strlen(lead) + 16U;
+        pieces = 0U;
+        /* pieces from the LSB up, a byte holds one contiguous piece */
+        n = 0U;
+        while (n < sig->len)
+        {
+            byte = sig->bits[n] / 8U;
+            bits = signal_piece(sig, byte, &k0, &b0);
+            if ((b0 + bits) == 8U)
+            {
+                snprintf(piece, sizeof(piece), (b0 != 0U) ? "(data[%u] >> %uU)" : "data[%u]", byte, b0);
+            }
+            else if (b0 != 0U)
+            {
+                snprintf(piece, sizeof(piece), "((data[%u] >> %uU) & 0x%XU)", byte, b0, (1U << bits) - 1U);
+            }
+            else
+            {
+                snprintf(piece, sizeof(piece), "(data[%u] & 0x%XU)", byte, (1U << bits) - 1U);
+            }
+            if (k0 != 0U)
+            {
+                /* a byte shifted into the top of 32 bits would overflow int */
+                char shifted[EXPR_PIECE_SIZE * 2U];
+
+                snprintf(shifted, sizeof(shifted), (sig->width > 16U) ? "((%s)%s << %uU)" : "(%s%s << %uU)",
+                         (sig->width > 16U) ? ut : "", piece, k0);
+                strcpy(piece, shifted);
+            }
+            else if (sig->width > 16U)
+            {
+                char cast[EXPR_PIECE_SIZE * 2U];
+
+                snprintf(cast, sizeof(cast), "(%s)%s", ut, piece);
+                strcpy(piece, cast);
+            }
+            expr_append(expr, &col, piece, 8U);
+            pieces++;
+            n = k0 + bits;
+        }
+
+        if (extend)
+        {
+            uint64_t sign = 1ULL << (sig->len - 1U);
+
+            fprintf(out, "%s(%s)((((%s)(%s)) ^ 0x%llX%s) - 0x%llX%s);\n", lead, field_type(sig), ut, expr,
+                    (unsigned long long)sign, suffix(sig->width), (unsigned long long)sign, suffix(sig->width));
+        }
+        else if (sig->is_signed)
+        {
+            fprintf(out, "%s(%s)(%s)(%s);\n", lead, field_type(sig), ut, expr);
+        }
+        else if ((pieces == 1U) && (expr[0] != '('))
+        {
+            fprintf(out, "%s%s;\n", lead, expr);
+        }
+        else
+        {
+            fprintf(out, "%s(%s)%s%s%s;\n", lead, ut, (pieces == 1U) ? "" : "(", expr, (pieces == 1U) ? "" : ")");
+        }
+    }
+    if (msg->signal_num == 0U)
+    {
+        fprintf(out, "    (void)msg;\n    (void)data;\n");
+    }
+    fprintf(out, "}\n\n");
+}
+
+static void write_check(FILE *out, const message_t *msg)
+{
+    uint32_t checks = 0U;
+    uint32_t i;
+    char text[32];
+
+    fprintf(out, "bool can_db_%s_check(const can_db_%s_t *msg)\n{\n", msg->cname, msg->cname);
+    for (i = msg->signal_first; i < (msg->signal_first + msg->signal_num); i++)
+    {
+        const signal_t *sig = &signals[i];
+
+        if (sig->low_check)
+        {
+            int_text(sig, sig->low, text);
+            fprintf(out, "%s(msg->%s >= %s)", (checks == 0U) ? "    return " : "\n           & ", sig->cname, text);
+            checks++;
+        }
+        if (sig->high_check)
+        {
+            int_text(sig, sig->high, text);
+            fprintf(out, "%s(msg->%s <= %s)", (checks == 0U) ? "    return " : "\n           & ", sig->cname, text);
+            checks++;
+        }
+    }
+    if (checks == 0U)
+    {
+        fprintf(out, "    (void)msg;\n    return true;\n}\n\n");
+    }
+    else
+    {
+        fprintf(out, ";\n}\n\n");
+    }
+}
+
+static void write_header(FILE *out, const char *dbc_name)
+{
+    uint32_t i;
+    uint32_t j;
+    uint32_t payload_max = 0U;
+    char upper[NAME_SIZE];
+    char sig_upper[NAME_SIZE];
+    char val_upper[NAME_SIZE];
+    char text[32];
+
+    for (i = 0U; i < message_num; i++)
+    {
+        payload_max = (messages[i].len > payload_max) ? messages[i].len : payload_max;
+    }
+
+    fprintf(out, "/* generated by tools/can_db_gen from %s, do not edit */\n", dbc_name);
+    fprintf(out, "#ifndef CAN_DB_MSG_H\n#define CAN_DB_MSG_H\n\n");
+    fprintf(out, "#include <stdint.h>\n#include <stdbool.h>\n#include <stddef.h>\n#include <string.h>\n\n");
+    fprintf(out, "/* messages of can_db_msg_table, standard IDs first, sorted by ID */\n");
+    fprintf(out, "#define CAN_DB_MSG_NUM %uU\n", message_num);
+    fprintf(out, "#define CAN_DB_SIGNAL_NUM %uU\n", signal_num);
+    fprintf(out, "/* longest payload of a message */\n");
+    fprintf(out, "#define CAN_DB_PAYLOAD_MAX %uU\n\n", payload_max);
+    fprintf(out, "/* index of a message in can_db_msg_table */\n");
+    for (i = 0U; i < message_num; i++)
+    {
+        upper_case(messages[i].cname, upper);
+        fprintf(out, "#define CAN_DB_%s %uU\n", upper, i);
+    }
+
+    fprintf(out, "\ntypedef struct\n{\n");
+    fprintf(out, "    uint32_t id;\n");
+    fprintf(out, "    bool ext;           /* 29 bit ID */\n");
+    fprintf(out, "    bool fd;            /* CAN FD frame */\n");
+    fprintf(out, "    bool tx;            /* sent by this node, else received */\n");
+    fprintf(out, "    uint8_t len;        /* payload bytes */\n");
+    fprintf(out, "    uint16_t cycle_ms;  /* GenMsgCycleTime, 0 if not cyclic */\n");
+    fprintf(out, "    uint16_t size;      /* bytes of the message struct */\n");
+    fprintf(out, "    void *value;        /* last value sent or received */\n");
+    fprintf(out, "    void (*pack)(uint8_t *data, const void *msg);\n");
+    fprintf(out, "    void (*unpack)(void *msg, const uint8_t *data);\n");
+    fprintf(out, "    bool (*check)(const void *msg);\n");
+    fprintf(out, "} can_db_msg_t;\n\n");
+
+    fprintf(out, "/* a signal for generic code, see CAN_DB_SIGNAL_TABLE */\n");
+    fprintf(out, "typedef struct\n{\n");
+    fprintf(out, "    const char *name;\n");
+    fprintf(out, "    uint16_t msg;       /* index in can_db_msg_table */\n");
+    fprintf(out, "    uint16_t start;     /* DBC start bit */\n");
+    fprintf(out, "    uint8_t len;\n");
+    fprintf(out, "    bool motorola;\n");
+    fprintf(out, "    bool is_signed;\n");
+    fprintf(out, "    uint8_t field_size; /* bytes of the struct field */\n");
+    fprintf(out, "    uint16_t field;     /* offset of the struct field */\n");
+    fprintf(out, "    bool low_check;     /* raw limits compared by check() */\n");
+    fprintf(out, "    bool high_check;\n");
+    fprintf(out, "    int64_t low;\n");
+    fprintf(out, "    int64_t high;\n");
+    fprintf(out, "    float factor;\n");
+    fprintf(out, "    float offset;\n");
+    fprintf(out, "} can_db_signal_t;\n\n");
+
+    for (i = 0U; i < message_num; i++)
+    {
+        const message_t *msg = &messages[i];
+
+        upper_case(msg->cname, upper);
+        fprintf(out, "/* %s, %s%s%u bytes", msg->name, msg->fd ? "FD, " : "", msg->ext ? "29 bit ID, " : "", msg->len);
+        if (msg->cycle_ms != 0U)
+        {
+            fprintf(out, ", every %u ms", msg->cycle_ms);
+        }
+        fprintf(out, ", %s %s */\n", msg->tx ? "sent by" : "from", msg->sender);
+        fprintf(out, "#define CAN_DB_%s_ID 0x%XU\n", upper, msg->id);
+        fprintf(out, "#define CAN_DB_%s_LEN %uU\n", upper, msg->len);
+        fprintf(out, "#define CAN_DB_%s_CYCLE_MS %uU\n\n", upper, msg->cycle_ms);
+
+        fprintf(out, "typedef struct\n{\n");
+        for (j = msg->signal_first; j < (msg->signal_first + msg->signal_num); j++)
+        {
+            const signal_t *sig = &signals[j];
+            int pad = 32 - (int)(strlen(field_type(sig)) + strlen(sig->cname) + 6U);
+
+            fprintf(out, "    %s %s;%*s/* %u|%u@%c%c", field_type(sig), sig->cname, (pad > 1) ? pad : 1, "", sig->start,
+                    sig->len, sig->motorola ? '0' : '1', sig->is_signed ? '-' : '+');
+            if ((sig->factor != 1.0) || (sig->offset != 0.0))
+            {
+                fprintf(out, " (%g,%g)", sig->factor, sig->offset);
+            }
+            if (sig->unit[0] != '\0')
+            {
+                fprintf(out, " %s", sig->unit);
+            }
+            fprintf(out, " */\n");
+        }
+        if (msg->signal_num == 0U)
+        {
+            fprintf(out, "    uint8_t unused;\n");
+        }
+        fprintf(out, "} can_db_%s_t;\n\n", msg->cname);
+
+        for (j = msg->signal_first; j < (msg->signal_first + msg->signal_num); j++)
+        {
+            const signal_t *sig = &signals[j];
+            uint32_t v;
+
+            upper_case(sig->cname, sig_upper);
+            if ((sig->factor != 1.0) || (sig->offset != 0.0))
+            {
+                fprintf(out, "#define CAN_DB_%s_%s_FACTOR %s\n", upper, sig_upper, float_text(sig->factor, text));
+                fprintf(out, "#define CAN_DB_%s_%s_OFFSET %s\n", upper, sig_upper, float_text(sig->offset, text));
+            }
+            if (sig->low_check)
+            {
+                int_text(sig, sig->low, text);
+                fprintf(out, "#define CAN_DB_%s_%s_MIN %s\n", upper, sig_upper, text);
+            }
+            if (sig->high_check)
+            {
+                int_text(sig, sig->high, text);
+                fprintf(out, "#define CAN_DB_%s_%s_MAX %s\n", upper, sig_upper, text);
+            }
+            for (v = 0U; v < value_num; v++)
+            {
+                if ((values[v].dbc_id == msg->dbc_id) && (strcmp(values[v].signal, sig->name) == 0))
+                {
+                    upper_case(values[v].name, val_upper);
+                    int_text(sig, values[v].value, text);
+                    fprintf(out, "#define CAN_DB_%s_%s_%s %s\n", upper, sig_upper, val_upper, text);
+                }
+            }
+        }
+
+        fprintf(out, "\nvoid can_db_%s_pack(uint8_t *data, const can_db_%s_t *msg);\n", msg->cname, msg->cname);
+        fprintf(out, "void can_db_%s_unpack(can_db_%s_t *msg, const uint8_t *data);\n", msg->cname, msg->cname);
+        fprintf(out, "bool can_db_%s_check(const can_db_%s_t *msg);\n\n", msg->cname, msg->cname);
+    }
+
+    fprintf(out, "extern const can_db_msg_t can_db_msg_table[CAN_DB_MSG_NUM];\n");
+    fprintf(out, "#if CAN_DB_SIGNAL_TABLE\n");
+    fprintf(out, "extern const can_db_signal_t can_db_signal_table[CAN_DB_SIGNAL_NUM];\n");
+    fprintf(out, "#endif\n\n#endif\n");
+}
+
+static void write_inc(FILE *out, const char *dbc_name)
+{
+    uint32_t i;
+    uint32_t j;
+    char upper[NAME_SIZE];
+    char text[32];
+    char text2[32];
+    char text3[32];
+
+    fprintf(out, "/* generated by tools/can_db_gen from %s, do not edit */\n\n", dbc_name);
+    for (i = 0U; i < message_num; i++)
+    {
+        const message_t *msg = &messages[i];
+
+        fprintf(out, "/* %s 0x%X */\n", msg->name, msg->id);
+        write_pack(out, msg);
+        write_unpack(out, msg);
+        write_check(out, msg);
+        fprintf(out, "static can_db_%s_t can_db_%s_value;\n\n", msg->cname, msg->cname);
+        fprintf(out, "static void can_db_%s_pack_any(uint8_t *data, const void *msg)\n{\n", msg->cname);
+        fprintf(out, "    can_db_%s_pack(data, (const can_db_%s_t *)msg);\n}\n\n", msg->cname, msg->cname);
+        fprintf(out, "static void can_db_%s_unpack_any(void *msg, const uint8_t *data)\n{\n", msg->cname);
+        fprintf(out, "    can_db_%s_unpack((can_db_%s_t *)msg, data);\n}\n\n", msg->cname, msg->cname);
+        fprintf(out, "static bool can_db_%s_check_any(const void *msg)\n{\n", msg->cname);
+        fprintf(out, "    return can_db_%s_check((const can_db_%s_t *)msg);\n}\n\n", msg->cname, msg->cname);
+    }
+
+    fprintf(out, "const can_db_msg_t can_db_msg_table[CAN_DB_MSG_NUM] =\n{\n");
+    for (i = 0U; i < message_num; i++)
+    {
+        const message_t *msg = &messages[i];
+
+        upper_case(msg->cname, upper);
+        fprintf(out, "    {CAN_DB_%s_ID, %s, %s, %s, CAN_DB_%s_LEN, CAN_DB_%s_CYCLE_MS, sizeof(can_db_%s_t),\n", upper,
+                msg->ext ? "true" : "false", msg->fd ? "true" : "false", msg->tx ? "true" : "false", upper, upper,
+                msg->cname);
+        fprintf(out, "     &can_db_%s_value, can_db_%s_pack_any, can_db_%s_unpack_any, can_db_%s_check_any},\n",
+                msg->cname, msg->cname, msg->cname, msg->cname);
+    }
+    fprintf(out, "};\n\n");
+
+    fprintf(out, "#if CAN_DB_SIGNAL_TABLE\n");
+    fprintf(out, "const can_db_signal_t can_db_signal_table[CAN_DB_SIGNAL_NUM] =\n{\n");
+    for (i = 0U; i < message_num; i++)
+    {
+        const message_t *msg = &messages[i];
+
+        upper_case(msg->cname, upper);
+        for (j = msg->signal_first; j < (msg->signal_first + msg->signal_num); j++)
+        {
+            const signal_t *sig = &signals[j];
+
+            fprintf(out, "    {\"%s.%s\", CAN_DB_%s, %uU, %uU, %s, %s,\n", msg->name, sig->name, upper, sig->start,
+                    sig->len, sig->motorola ? "true" : "false", sig->is_signed ? "true" : "false");
+            fprintf(out, "     sizeof(((can_db_%s_t *)0)->%s), offsetof(can_db_%s_t, %s),\n", msg->cname, sig->cname,
+                    msg->cname, sig->cname);
+            fprintf(out, "     %s, %s, %s, %lldLL, %s, %s},\n", sig->low_check ? "true" : "false",
+                    sig->high_check ? "true" : "false", int64_text(sig->low, text3), (long long)sig->high,
+                    float_text(sig->factor, text), float_text(sig->offset, text2));
+        }
+    }
+    fprintf(out, "};\n#endif\n");
+}
+
+int main(int argc, char *argv[])
+{
+    FILE *dbc;
+    FILE *hdr;
+    FILE *inc;
+    const char *dbc_name;
+    signal_t *copy;
+    uint32_t first;
+    uint32_t i;
+    int arg = 1;
+
+    while ((arg < argc) && (argv[arg][0] == '-'))
+    {
+        if ((strcmp(argv[arg], "-n") == 0) && ((arg + 1) < argc))
+        {
+            node = argv[arg + 1];
+            arg += 2;
+        }
+        else
+        {
+            arg = argc;
+        }
+    }
+    if ((argc - arg) != 3)
+    {
+        fprintf(stderr, "usage: can_db_gen [-n node] can_db.dbc can_db_msg.h can_db_msg.inc\n");
+        return 2;
+    }
+
+    dbc = fopen(argv[arg], "r");
+    if (dbc == NULL)
+    {
+        perror(argv[arg]);
+        return 1;
+    }
+    load_dbc(dbc);
+    fclose(dbc);
+    if (message_num == 0U)
+    {
+        fail("no message in the DBC");
+    }
+
+    /* sort the messages, their signals move along to stay contiguous */
+    qsort(messages, message_num, sizeof(message_t), message_cmp);
+    copy = malloc(sizeof(signal_t) * signal_num);
+    if (copy == NULL)
+    {
+        fail("out of memory");
+    }
+    memcpy(copy, signals, sizeof(signal_t) * signal_num);
+    first = 0U;
+    for (i = 0U; i < message_num; i++)
+    {
+        memcpy(&signals[first], &copy[messages[i].signal_first], sizeof(signal_t) * messages[i].signal_num);
+        messages[i].signal_first = first;
+        first += messages[i].signal_num;
+    }
+    free(copy);
+    for (i = 1U; i < message_num; i++)
+    {
+        if (strcmp(messages[i].cname, messages[i - 1U].cname) == 0)
+        {
+            fail("two messages with the same C name");
+        }
+    }
+
+    dbc_name = strrchr(argv[arg], '/');
+    dbc_name = (dbc_name != NULL) ? (dbc_name + 1) : argv[arg];
+    hdr = fopen(argv[arg + 1], "w");
+    inc = fopen(argv[arg + 2], "w");
+    if ((hdr == NULL) || (inc == NULL))
+    {
+        perror("output");
+        return 1;
+    }
+    write_header(hdr, dbc_name);
+    write_inc(inc, dbc_name);
+    fclose(hdr);
+    fclose(inc);
+
+    for (i = 0U; i < message_num; i++)
+    {
+        printf("0x%08X %-16s %2u bytes %2u signals %s%s\n", messages[i].id, messages[i].name, messages[i].len,
+               messages[i].signal_num, messages[i].tx ? "TX" : "RX", messages[i].fd ? " FD" : "");
+    }
+    printf("%u messages, %u signals\n", message_num, signal_num);
+    return 0;
+}
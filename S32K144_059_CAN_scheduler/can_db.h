@@ -0,0 +1,43 @@
+#ifndef CAN_DB_H
+#define CAN_DB_H
+
+#include "can_lld.h"
+#include "can_db_msg.h"
+
+/* CAN signals of can_db.dbc. tools/can_db_gen turns the DBC into
+ * can_db_msg.h and can_db_msg.inc: a struct per message with the raw value
+ * of every signal, its pack, unpack and range check functions and
+ * can_db_msg_table. Regenerate both after a change of the DBC:
+ *   can_db_gen can_db.dbc can_db_msg.h can_db_msg.inc
+ *
+ * can_lld_rx_process() hands every frame ISO-TP does not take to
+ * can_db_rx(), which keeps the last value of each RX message. Tasks read it
+ * with can_db_get() and send TX messages with can_db_tx(), or with can_sched
+ * and can_db_pack() in its fill function. The values are raw,
+ * CAN_DB_TO_PHYS() and CAN_DB_FROM_PHYS() apply factor and offset */
+
+#if CAN_DB_PAYLOAD_MAX > CAN_LLD_PAYLOAD_MAX
+#error "a message of can_db.dbc is longer than a can_lld frame"
+#endif
+
+/* physical value of a raw one and back, sig names the signal as in the
+ * macros of can_db_msg.h, CAN_DB_ET1_ENGINE_COOLANT_TEMP for example.
+ * FROM_PHYS is rounded to the nearest raw value */
+#define CAN_DB_TO_PHYS(sig, raw) (((float)(raw) * sig##_FACTOR) + sig##_OFFSET)
+#define CAN_DB_FROM_PHYS(sig, phys) ((((phys) - sig##_OFFSET) / sig##_FACTOR) + \
+                                     (((((phys) - sig##_OFFSET) / sig##_FACTOR) < 0.0f) ? -0.5f : 0.5f))
+
+extern uint32_t can_db_rx_num;
+/* received with an ID of no RX message */
+extern uint32_t can_db_rx_unknown_num;
+/* shorter than the message of the DBC, dropped */
+extern uint32_t can_db_rx_len_error_num;
+/* can_db_tx() of values out of their DBC range */
+extern uint32_t can_db_tx_range_error_num;
+
+bool can_db_rx(const can_lld_rx_frame_t *frame);
+bool can_db_get(uint32_t index, void *value, TickType_t *tick);
+status_t can_db_pack(uint32_t index, const void *value, uint8_t *data);
+status_t can_db_tx(uint32_t index, const void *value);
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef CAN_STATS_H
+#define CAN_STATS_H
+
+#include "can_lld.h"
+
+/* CAN bus statistics: per ID frame rate, inter-arrival times and TX latency,
+ * bus load and error counts. The stuff bits of a frame are not known, the bus
+ * load is given without any and with the worst case number of them, the real
+ * load is in between. Frames are counted by can_lld from the CAN
+ * interrupt and freertos_task_can_rx, every update is a few atomic operations
+ * on one table entry and never takes a lock. Only frames this node sees are
+ * counted, own TX frames and RX frames passing the acceptance filters */
+
+/* IDs with their own table entry, must be a power of 2. Frames of further IDs
+ * only count for the bus load and can_stats_no_entry_num */
+#define CAN_STATS_ID_NUM 32U
+/* open addressing, entries tried for an ID before giving up */
+#define CAN_STATS_PROBE_MAX 8U
+
+/* jitter histogram of every ID, how many FreeRTOS ticks longer than the
+ * shortest one so far the time between two frames was. Bucket 0 is 0, bucket
+ * n holds 2^(n-1) up to 2^n - 1 and the last one everything above */
+#define CAN_STATS_HIST_NUM 16U
+
+/* bus load is counted in 1/8 nominal bit times, see can_stats_frame_bits() */
+#define CAN_STATS_BIT_SCALE 8U
+
+/* can_stats_step() is called with this period, rates and bus load are the
+ * averages over it */
+#define CAN_STATS_WINDOW_MS 1000U
+
+/* the snapshot is sent over the UART by test case 13 of freertos_task_1000ms,
+ * between the printf lines. tools/can_stats_dump reads it from a capture */
+#define CAN_STATS_UART_EXPORT_ENABLE 1
+
+typedef enum
+{
+    /* ESR1 error bits, arbitration phase and FD data phase */
+    CAN_STATS_ERROR_BIT0 = 0,
+    CAN_STATS_ERROR_BIT1,
+    CAN_STATS_ERROR_STUFF,
+    CAN_STATS_ERROR_FORM,
+    CAN_STATS_ERROR_CRC,
+    CAN_STATS_ERROR_ACK,
+    CAN_STATS_ERROR_BIT0_FAST,
+    CAN_STATS_ERROR_BIT1_FAST,
+    CAN_STATS_ERROR_STUFF_FAST,
+    CAN_STATS_ERROR_FORM_FAST,
+    CAN_STATS_ERROR_CRC_FAST,
+    /* fault confinement */
+    CAN_STATS_ERROR_RX_WARNING,
+    CAN_STATS_ERROR_TX_WARNING,
+    CAN_STATS_ERROR_PASSIVE,
+    CAN_STATS_ERROR_BUS_OFF,
+    /* frames lost by the node */
+    CAN_STATS_ERROR_RX_FIFO_OVERFLOW,
+    CAN_STATS_ERROR_RX_QUEUE_OVERFLOW,
+    CAN_STATS_ERROR_TX_QUEUE_FULL,
+    CAN_STATS_ERROR_DMA,
+    CAN_STATS_ERROR_NUM
+} can_stats_error_t;
+
+/* snapshot packets, little endian:
+ *   'C' 'S' type len payload[len] crc16
+ * crc16 is CRC-16/CCITT-FALSE over type, len and the payload. A snapshot is
+ * one summary packet followed by one ID packet per table entry in use.
+ * Types 0x10 and up are the dump of can_trace */
+#define CAN_STATS_PACKET_SUMMARY 0x01U
+#define CAN_STATS_PACKET_ID 0x02U
+#define CAN_STATS_PACKET_VERSION 1U
+#define CAN_STATS_PACKET_OVERHEAD 6U
+
+/* summary payload:
+ *   u8  version          u8  ID packets following
+ *   u16 window in ms     u32 tick of the snapshot
+ *   u16 bus load of the last window and u16 the highest one, 0.01 %
+ *   u16 the same with worst case stuffing, u16 its highest one
+ *   u32 frames counted    u32 frames without a table entry
+ *   u32 error counters, CAN_STATS_ERROR_NUM of them */
+#define CAN_STATS_SUMMARY_SIZE (24U + (4U * CAN_STATS_ERROR_NUM))
+/* ID payload:
+ *   u32 ID, bit 31 set for a 29 bit ID
+ *   u32 frames            u16 frames/s of the last window
+ *   u32 shortest and u32 longest time between two frames, ticks
+ *   u32 TX frames with a latency   u32 sum of the latencies, ticks
+ *   u16 shortest and u16 longest latency, ticks
+ *   u16 jitter histogram buckets, CAN_STATS_HIST_NUM of them, saturated */
+#define CAN_STATS_ID_SIZE (30U + (2U * CAN_STATS_HIST_NUM))
+
+/* room for a whole snapshot */
+#define CAN_STATS_EXPORT_SIZE ((CAN_STATS_PACKET_OVERHEAD + CAN_STATS_SUMMARY_SIZE) + \
+                               (CAN_STATS_ID_NUM * (CAN_STATS_PACKET_OVERHEAD + CAN_STATS_ID_SIZE)))
+
+#if (CAN_STATS_SUMMARY_SIZE > 255U) || (CAN_STATS_ID_SIZE > 255U)
+#error "a can_stats packet payload does not fit its length byte"
+#endif
+
+extern uint32_t can_stats_bus_load;
+extern uint32_t can_stats_bus_load_peak;
+extern uint32_t can_stats_bus_load_worst;
+extern uint32_t can_stats_bus_load_worst_peak;
+extern uint32_t can_stats_frame_num;
+extern uint32_t can_stats_no_entry_num;
+extern uint32_t can_stats_error_num[CAN_STATS_ERROR_NUM];
+/* written by test case 13 and FreeMASTER application command 4, a packet
+ * torn by both at once fails its CRC */
+extern uint8_t can_stats_export_buf[CAN_STATS_EXPORT_SIZE];
+extern uint32_t can_stats_export_len;
+
+void can_stats_rx(uint32_t msgId, uint32_t cs, TickType_t tick);
+void can_stats_tx(uint32_t msgId, uint32_t len, bool fd, TickType_t queued, TickType_t tick);
+void can_stats_error(can_stats_error_t error, uint32_t num);
+void can_stats_esr1(uint32_t esr1);
+void can_stats_step(void);
+uint32_t can_stats_frame_bits(bool ext, bool fd, bool brs, uint32_t len, uint32_t *stuff);
+uint32_t can_stats_id_num(void);
+uint32_t can_stats_export(uint8_t *buf, uint32_t size);
+uint32_t can_stats_packet(uint8_t *p, uint8_t type, uint32_t len);
+
+#endif
@@ -0,0 +1,66 @@
+#include "lpit_lld.h"
+#include "can_sched.h"
+
+#define INC_DIREC 0
+#define DEC_DIREC 1
+
+float pit_lld_counter;
+uint8_t pit_lld_cnt_direction;
+
+/* channel 1 is the time base of can_sched, not in the lpit1 component */
+static const lpit_user_channel_config_t lpit_lld_ch1_config =
+{
+    .timerMode = LPIT_PERIODIC_COUNTER,
+    .periodUnits = LPIT_PERIOD_UNITS_MICROSECONDS,
+    .period = CAN_SCHED_TICK_MS * 1000U,
+    .triggerSource = LPIT_TRIGGER_SOURCE_EXTERNAL,
+    .triggerSelect = 0U,
+    .enableReloadOnTrigger = false,
+    .enableStopOnInterrupt = false,
+    .enableStartOnTrigger = false,
+    .chainChannel = false,
+    .isInterruptEnabled = true
+};
+
+void lpit_lld_init(void)
+{
+    LPIT_DRV_Init(INST_LPIT1, &lpit1_InitConfig);
+    LPIT_DRV_InitChannel(INST_LPIT1, 0, &lpit1_ChnConfig0);
+    /* Install LPIT_ISR as LPIT interrupt handler */
+    INT_SYS_InstallHandler(LPIT0_Ch0_IRQn, &lpit_ch0_isr, (isr_t *)0);
+    LPIT_DRV_InitChannel(INST_LPIT1, 1, &lpit_lld_ch1_config);
+    INT_SYS_InstallHandler(LPIT0_Ch1_IRQn, &lpit_ch1_isr, (isr_t *)0);
+    /* wakes freertos_task_can_sched */
+    INT_SYS_SetPriority(LPIT0_Ch1_IRQn, configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY);
+
+    /* Start LPIT0 channel 0 and 1 counters together */
+    LPIT_DRV_StartTimerChannels(INST_LPIT1, (1 << 0) | (1 << 1));
+}
+
+void lpit_ch0_isr(void)
+{
+    LPIT_DRV_ClearInterruptFlagTimerChannels(INST_LPIT1, (1 << 0));
+    // PINS_DRV_TogglePins(PTD, 1 << 0);
+    if(pit_lld_cnt_direction == INC_DIREC)
+    {
+        pit_lld_counter += 0.1F;
+        if(pit_lld_counter > 1.0F)
+        {
+            pit_lld_cnt_direction = DEC_DIREC;
+        }
+    }
+    else
+    {
+        pit_lld_counter -= 0.1F;
+        if(pit_lld_counter < 0.0F)
+        {
+            pit_lld_cnt_direction = INC_DIREC;
+        }
+    }
+}
+
+void lpit_ch1_isr(void)
+{
+    LPIT_DRV_ClearInterruptFlagTimerChannels(INST_LPIT1, (1 << 1));
+    can_sched_tick_from_isr();
+}
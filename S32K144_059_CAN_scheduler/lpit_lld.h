@@ -0,0 +1,11 @@
+#ifndef LPIT_LLD_H
+#define LPIT_LLD_H
+
+#include "lpit1.h"
+#include "pin_mux.h"
+
+void lpit_lld_init(void);
+void lpit_ch0_isr(void);
+void lpit_ch1_isr(void);
+
+#endif
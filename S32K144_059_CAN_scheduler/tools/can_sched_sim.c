@@ -0,0 +1,663 @@
+/* Host simulation of can_sched: the scheduler runs as it is, driven by a
+ * simulated LPIT tick, and its frames go through a model of a 500 kbit/s bus
+ * with ID priority arbitration. Every frame takes its length with worst case
+ * stuffing, so the latencies are upper bounds.
+ *
+ * A 100 message table is run once with all offsets 0 and once with the
+ * offsets of can_sched_init(), and the bursts, TX latencies and period jitter
+ * on the bus are compared. Random tables check the offset plan against the
+ * lower bound of the peak tick, and the on change, on demand, fill and
+ * catch up paths are checked on their own. Exit status 1 on a failed check.
+ *
+ * build: gcc -O2 -Wall -DCAN_SCHED_MSG_MAX=128 -I.. -I../../S32K144_057_CAN_socketcan/host
+ *            -I../../S32K144_050_CAN_filter_compiler -o can_sched_sim can_sched_sim.c ../can_sched.c ../can_stats.c
+ * usage: can_sched_sim [-s seed] [-t seconds] [-r random tables]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "can_sched.h"
+#include "can_stats.h"
+
+#define SIM_TICKS_PER_MS (configTICK_RATE_HZ / 1000U)
+#define SIM_BITS_PER_TICK (CAN_LLD_BITRATE / configTICK_RATE_HZ)
+#define SIM_BUS_QUEUE_SIZE 4096U
+#define SIM_LATENCY_HIST 4096U
+#define SIM_MSG_NUM 100U
+/* of the 100 message table, with worst case stuffing */
+#define SIM_LOAD_MAX 65.0
+
+typedef struct
+{
+    uint32_t key;           /* arbitration order, lower wins */
+    uint32_t index;         /* message of the table */
+    uint32_t bits;
+    uint64_t queued;        /* bit time */
+} sim_frame_t;
+
+typedef struct
+{
+    uint32_t frame_num;
+    uint64_t last_done;
+    uint64_t period_min;
+    uint64_t period_max;
+} sim_msg_t;
+
+typedef struct
+{
+    uint32_t frame_num;
+    uint32_t queue_peak;
+    uint64_t latency_max;
+    uint64_t latency_p99;
+    uint64_t jitter_max;    /* longest minus shortest period on the bus of
+                             * a periodic message, bit times */
+    uint32_t jitter_index;
+} sim_result_t;
+
+static can_sched_msg_t sim_table[CAN_SCHED_MSG_MAX];
+static uint32_t sim_num;
+static sim_msg_t sim_msg[CAN_SCHED_MSG_MAX];
+static sim_frame_t sim_queue[SIM_BUS_QUEUE_SIZE];
+static uint32_t sim_queue_num;
+static uint32_t sim_queue_peak;
+static uint64_t sim_bus_time;       /* bit time the bus is free */
+static uint32_t sim_latency_hist[SIM_LATENCY_HIST];
+static uint64_t sim_latency_max;
+static uint32_t sim_frame_num;
+static TickType_t sim_tick;
+static bool sim_tx_full;
+static uint32_t sim_fill_num;
+static bool sim_fill_ok = true;
+static uint32_t sim_error;
+
+/* FreeRTOS and can_lld, as far as can_sched and can_stats use them */
+
+TickType_t xTaskGetTickCount(void)
+{
+    return sim_tick;
+}
+
+TickType_t xTaskGetTickCountFromISR(void)
+{
+    return sim_tick;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return NULL;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    (void)xTaskToNotify;
+    (void)pxHigherPriorityTaskWoken;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait)
+{
+    (void)xClearCountOnExit;
+    (void)xTicksToWait;
+    return 0U;
+}
+
+void vPortEnterCritical(void)
+{
+}
+
+void vPortExitCritical(void)
+{
+}
+
+uint8_t can_lld_len_to_dlc(uint32_t len)
+{
+    static const uint8_t fd_len[7] = {12U, 16U, 20U, 24U, 32U, 48U, 64U};
+    uint8_t dlc;
+
+    if (len <= 8U)
+    {
+        return (uint8_t)len;
+    }
+    for (dlc = 0U; fd_len[dlc] < len; dlc++)
+    {
+    }
+    return (uint8_t)(9U + dlc);
+}
+
+uint32_t can_lld_dlc_to_len(uint8_t dlc)
+{
+    static const uint8_t len[16] = {0U, 1U, 2U, 3U, 4U, 5U, 6U, 7U, 8U, 12U, 16U, 20U, 24U, 32U, 48U, 64U};
+
+    return len[dlc & 0x0FU];
+}
+
+static uint32_t sim_key(uint32_t messageId)
+{
+    uint32_t id = messageId & 0x1FFFFFFFU;
+
+    /* base ID first, a standard frame wins over an extended one with it */
+    if ((messageId & CAN_LLD_TX_ID_EXT) != 0U)
+    {
+        return ((id >> 18) << 19) | (1UL << 18) | (id & 0x3FFFFU);
+    }
+    return (id & 0x7FFU) << 19;
+}
+
+static uint32_t sim_bits(uint32_t messageId, uint32_t len)
+{
+    bool fd = ((messageId & CAN_LLD_TX_ID_FD) != 0U) || (len > 8U);
+    uint32_t stuff;
+    uint32_t units;
+
+    if (fd)
+    {
+        len = can_lld_dlc_to_len(can_lld_len_to_dlc(len));
+    }
+    units = can_stats_frame_bits((messageId & CAN_LLD_TX_ID_EXT) != 0U, fd, fd && (CAN_LLD_FD_BRS_ENABLE != 0),
+                                 len, &stuff);
+    return (units + stuff + CAN_STATS_BIT_SCALE - 1U) / CAN_STATS_BIT_SCALE;
+}
+
+status_t can_lld_tx(uint32_t messageId, const uint8_t *data, uint32_t len)
+{
+    sim_frame_t *f;
+    uint32_t i;
+
+    (void)data;
+    if (sim_tx_full || (sim_queue_num == SIM_BUS_QUEUE_SIZE))
+    {
+        return STATUS_BUSY;
+    }
+    for (i = 0U; (i < sim_num) && (sim_table[i].messageId != messageId); i++)
+    {
+    }
+    f = &sim_queue[sim_queue_num++];
+    f->key = sim_key(messageId);
+    f->index = i;
+    f->bits = sim_bits(messageId, len);
+    f->queued = (uint64_t)sim_tick * SIM_BITS_PER_TICK;
+    if (sim_queue_num > sim_queue_peak)
+    {
+        sim_queue_peak = sim_queue_num;
+    }
+    return STATUS_SUCCESS;
+}
+
+/* the bus up to the end of the current tick: while frames wait, the one with
+ * the lowest key wins the next arbitration */
+static void sim_bus(void)
+{
+    uint64_t end = ((uint64_t)sim_tick + 1U) * SIM_BITS_PER_TICK;
+    uint64_t latency;
+    sim_frame_t f;
+    sim_msg_t *m;
+    uint32_t best;
+    uint32_t i;
+
+    for (;;)
+    {
+        if (sim_queue_num == 0U)
+        {
+            break;
+        }
+        if (sim_bus_time < sim_queue[0].queued)
+        {
+            /* idle bus up to the oldest frame */
+            sim_bus_time = sim_queue[0].queued;
+        }
+        if (sim_bus_time >= end)
+        {
+            break;
+        }
+        /* the frames waiting when the bus gets free, queue[0] is one */
+        best = 0U;
+        for (i = 1U; (i < sim_queue_num) && (sim_queue[i].queued <= sim_bus_time); i++)
+        {
+            if (sim_queue[i].key < sim_queue[best].key)
+            {
+                best = i;
+            }
+        }
+        f = sim_queue[best];
+        memmove(&sim_queue[best], &sim_queue[best + 1U], (sim_queue_num - best - 1U) * sizeof(sim_frame_t));
+        sim_queue_num--;
+
+        sim_bus_time += f.bits;
+        latency = sim_bus_time - f.queued;
+        sim_latency_hist[(latency < SIM_LATENCY_HIST) ? latency : (SIM_LATENCY_HIST - 1U)]++;
+        if (latency > sim_latency_max)
+        {
+            sim_latency_max = latency;
+        }
+        sim_frame_num++;
+        if (f.index < sim_num)
+        {
+            m = &sim_msg[f.index];
+            if (m->frame_num != 0U)
+            {
+                if ((m->frame_num == 1U) || ((sim_bus_time - m->last_done) < m->period_min))
+                {
+                    m->period_min = sim_bus_time - m->last_done;
+                }
+                if ((sim_bus_time - m->last_done) > m->period_max)
+                {
+                    m->period_max = sim_bus_time - m->last_done;
+                }
+            }
+            m->frame_num++;
+            m->last_done = sim_bus_time;
+        }
+    }
+}
+
+static void sim_reset(void)
+{
+    memset(sim_msg, 0, sizeof(sim_msg));
+    memset(sim_latency_hist, 0, sizeof(sim_latency_hist));
+    sim_queue_num = 0U;
+    sim_queue_peak = 0U;
+    sim_bus_time = 0U;
+    sim_latency_max = 0U;
+    sim_frame_num = 0U;
+    sim_tick = 0U;
+}
+
+/* @brief: Run the scheduler on the bus model
+ * @param ms      : simulated time
+ * @param late    : the task runs up to this many FreeRTOS ticks after the
+ *                  timer interrupt, random
+ * @param catchup : every this many ms the task misses a tick, 0 never
+ */
+static void sim_run(uint32_t ms, uint32_t late, uint32_t catchup)
+{
+    uint32_t t;
+    uint32_t k;
+    uint32_t run_at;
+
+    for (t = 0U; t < ms; t++)
+    {
+        can_sched_tick_from_isr();
+        run_at = (late == 0U) ? 0U : (uint32_t)(rand() % (int)(late + 1U));
+        for (k = 0U; k < SIM_TICKS_PER_MS; k++)
+        {
+            if ((k == run_at) && ((catchup == 0U) || ((t % catchup) != (catchup - 1U))))
+            {
+                can_sched_run();
+            }
+            sim_bus();
+            sim_tick++;
+        }
+    }
+}
+
+static void sim_result(sim_result_t *r)
+{
+    uint32_t sum = 0U;
+    uint32_t i;
+
+    memset(r, 0, sizeof(*r));
+    r->frame_num = sim_frame_num;
+    r->queue_peak = sim_queue_peak;
+    r->latency_max = sim_latency_max;
+    for (i = 0U; i < SIM_LATENCY_HIST; i++)
+    {
+        sum += sim_latency_hist[i];
+        if ((uint64_t)sum * 100U >= (uint64_t)sim_frame_num * 99U)
+        {
+            r->latency_p99 = i;
+            break;
+        }
+    }
+    for (i = 0U; i < sim_num; i++)
+    {
+        if ((sim_table[i].mode == (uint8_t)CAN_SCHED_MODE_PERIODIC) && (sim_msg[i].frame_num > 1U) &&
+            ((sim_msg[i].period_max - sim_msg[i].period_min) > r->jitter_max))
+        {
+            r->jitter_max = sim_msg[i].period_max - sim_msg[i].period_min;
+            r->jitter_index = i;
+        }
+    }
+}
+
+/* bit times to us at CAN_LLD_BITRATE */
+static double sim_us(uint64_t bits)
+{
+    return (double)bits * 1e6 / CAN_LLD_BITRATE;
+}
+
+/* average bus load of the table, % */
+static double sim_load(void)
+{
+    double bits = 0.0;
+    uint32_t i;
+
+    for (i = 0U; i < sim_num; i++)
+    {
+        bits += (double)sim_bits(sim_table[i].messageId, sim_table[i].len) * 1000.0 / sim_table[i].period_ms;
+    }
+    return 100.0 * bits / CAN_LLD_BITRATE;
+}
+
+/* periodic messages like a body/chassis ECU: mostly 8 bytes, some short
+ * ones, one in ten with a 29 bit ID. Random ones get longer periods until the
+ * load is below max_load % */
+static void sim_table_ecu(uint32_t num, bool random_len, double max_load)
+{
+    static const uint16_t period[] = {10U, 10U, 20U, 20U, 50U, 100U, 100U, 100U, 200U, 500U, 1000U};
+    uint32_t i;
+    uint32_t j;
+    uint32_t id;
+
+    for (i = 0U; i < num; i++)
+    {
+        do
+        {
+            id = 0x100U + (uint32_t)(rand() % 0x600);
+            if ((rand() % 10) == 0)
+            {
+                id = CAN_LLD_TX_ID_EXT | 0x18000000U | ((uint32_t)rand() & 0x00FFFFFFU);
+            }
+            for (j = 0U; (j < i) && (sim_table[j].messageId != id); j++)
+            {
+            }
+        } while (j != i);
+        sim_table[i].messageId = id;
+        sim_table[i].len = (uint8_t)(((rand() % 4) == 0) ? (1 + (rand() % 8)) : 8);
+        if (random_len && ((rand() % 8) == 0))
+        {
+            sim_table[i].messageId |= CAN_LLD_TX_ID_FD;
+            sim_table[i].len = (uint8_t)(1 + (rand() % 64));
+        }
+        sim_table[i].mode = (uint8_t)CAN_SCHED_MODE_PERIODIC;
+        sim_table[i].period_ms = period[rand() % (int)(sizeof(period) / sizeof(period[0]))];
+        sim_table[i].offset_ms = CAN_SCHED_OFFSET_AUTO;
+        sim_table[i].fill = NULL;
+    }
+    sim_num = num;
+    while (sim_load() > max_load)
+    {
+        i = (uint32_t)(rand() % (int)num);
+        for (j = 0U; (period[j] <= sim_table[i].period_ms) && (period[j] != 1000U); j++)
+        {
+        }
+        sim_table[i].period_ms = period[j];
+    }
+}
+
+/* @brief: Lower bound of the highest tick of any offset plan: the average
+ *         bits per tick, and the longest frame
+ */
+static uint32_t sim_lower_bound(void)
+{
+    uint64_t sum = 0U;
+    uint32_t max = 0U;
+    uint32_t bits;
+    uint32_t i;
+
+    for (i = 0U; i < sim_num; i++)
+    {
+        bits = sim_bits(sim_table[i].messageId, sim_table[i].len);
+        sum += (uint64_t)bits * (CAN_SCHED_HYPER_MS / sim_table[i].period_ms);
+        if (bits > max)
+        {
+            max = bits;
+        }
+    }
+    sum = (sum + CAN_SCHED_SLOT_NUM - 1U) / CAN_SCHED_SLOT_NUM;
+    return (sum > max) ? (uint32_t)sum : max;
+}
+
+static uint32_t sim_max_bits(void)
+{
+    uint32_t max = 0U;
+    uint32_t i;
+
+    for (i = 0U; i < sim_num; i++)
+    {
+        if (sim_bits(sim_table[i].messageId, sim_table[i].len) > max)
+        {
+            max = sim_bits(sim_table[i].messageId, sim_table[i].len);
+        }
+    }
+    return max;
+}
+
+#define SIM_CHECK(cond, ...) do { if (!(cond)) { printf("FAIL: " __VA_ARGS__); printf("\n"); sim_error++; } } while (0)
+
+/* the 100 message table with offsets 0 and with planned ones */
+static void sim_burst(uint32_t seconds)
+{
+    sim_result_t r[2];
+    uint32_t plan[2];
+    uint32_t tick_peak[2];
+    uint32_t load_peak[2];
+    uint32_t late = 2U;
+    can_sched_stats_t st;
+    uint32_t pass;
+    uint32_t i;
+    uint32_t expect;
+
+    sim_table_ecu(SIM_MSG_NUM, false, SIM_LOAD_MAX);
+    for (pass = 0U; pass < 2U; pass++)
+    {
+        for (i = 0U; i < sim_num; i++)
+        {
+            sim_table[i].offset_ms = (pass == 0U) ? 0U : CAN_SCHED_OFFSET_AUTO;
+        }
+        sim_reset();
+        SIM_CHECK(can_sched_init(sim_table, sim_num) == STATUS_SUCCESS, "init of the 100 message table");
+        sim_run(seconds * 1000U, late, 0U);
+        sim_result(&r[pass]);
+        plan[pass] = can_sched_plan_bits_peak;
+        tick_peak[pass] = can_sched_tick_bits_peak;
+        load_peak[pass] = can_sched_load_peak;
+
+        for (i = 0U; i < sim_num; i++)
+        {
+            expect = (seconds * 1000U) / sim_table[i].period_ms;
+            SIM_CHECK(can_sched_stats(i, &st), "stats of %u", i);
+            SIM_CHECK((st.frame_num + 1U >= expect) && (st.frame_num <= expect), "message %u: %u frames, %u expected",
+                      i, st.frame_num, expect);
+            SIM_CHECK(st.error_num == 0U, "message %u: %u TX errors", i, st.error_num);
+            SIM_CHECK((st.period_min + late >= sim_table[i].period_ms * SIM_TICKS_PER_MS) &&
+                      (st.period_max <= sim_table[i].period_ms * SIM_TICKS_PER_MS + late),
+                      "message %u: period %u-%u ticks", i, st.period_min, st.period_max);
+            SIM_CHECK(st.late_max <= late, "message %u: released %u ticks late", i, st.late_max);
+            SIM_CHECK((pass == 0U) || (st.offset_ms < sim_table[i].period_ms), "message %u: offset %u", i, st.offset_ms);
+        }
+        SIM_CHECK(tick_peak[pass] == plan[pass], "pass %u: %u bits in a tick sent, %u planned", pass,
+                  tick_peak[pass], plan[pass]);
+    }
+
+    printf("%u periodic messages, %u frames in %us, bus load %.1f%% with worst case stuffing\n", sim_num,
+           r[1].frame_num, seconds, sim_load());
+    printf("                       offsets 0   planned\n");
+    printf("bits in one tick       %9u %9u   (the bus carries %u per ms, lower bound %u)\n", plan[0], plan[1],
+           CAN_LLD_BITRATE / 1000U, sim_lower_bound());
+    printf("peak load of %2ums      %8.2f%% %8.2f%%\n", CAN_SCHED_LOAD_WINDOW_MS, load_peak[0] / 100.0,
+           load_peak[1] / 100.0);
+    printf("TX queue peak          %9u %9u\n", r[0].queue_peak, r[1].queue_peak);
+    printf("TX latency 99%%, us     %9.0f %9.0f\n", sim_us(r[0].latency_p99), sim_us(r[1].latency_p99));
+    printf("TX latency max, us     %9.0f %9.0f\n", sim_us(r[0].latency_max), sim_us(r[1].latency_max));
+    printf("period jitter max, us  %9.0f %9.0f\n", sim_us(r[0].jitter_max), sim_us(r[1].jitter_max));
+
+    SIM_CHECK(plan[1] <= sim_lower_bound() + sim_max_bits(), "planned peak %u above the lower bound %u + %u",
+              plan[1], sim_lower_bound(), sim_max_bits());
+    SIM_CHECK(plan[1] <= CAN_LLD_BITRATE / 1000U, "planned peak %u does not fit one tick of the bus", plan[1]);
+    SIM_CHECK(plan[1] * 4U <= plan[0], "planned peak %u not a quarter of the burst %u", plan[1], plan[0]);
+    SIM_CHECK(r[1].latency_max * 4U <= r[0].latency_max, "latency %.0fus not a quarter of %.0fus",
+              sim_us(r[1].latency_max), sim_us(r[0].latency_max));
+    SIM_CHECK(r[1].jitter_max * 4U <= r[0].jitter_max, "jitter %.0fus not a quarter of %.0fus",
+              sim_us(r[1].jitter_max), sim_us(r[0].jitter_max));
+}
+
+/* random tables, up to CAN_SCHED_MSG_MAX messages with FD frames: the plan
+ * stays within one frame of the lower bound and never above offsets 0 */
+static void sim_random(uint32_t tables)
+{
+    uint32_t n;
+    uint32_t zero;
+    uint32_t worst = 0U;
+    uint32_t i;
+    double ratio;
+    double ratio_max = 0.0;
+
+    for (n = 0U; n < tables; n++)
+    {
+        sim_table_ecu(1U + (uint32_t)(rand() % (int)CAN_SCHED_MSG_MAX), true, 100.0);
+        for (i = 0U; i < sim_num; i++)
+        {
+            sim_table[i].offset_ms = 0U;
+        }
+        SIM_CHECK(can_sched_init(sim_table, sim_num) == STATUS_SUCCESS, "init of random table %u", n);
+        zero = can_sched_plan_bits_peak;
+        for (i = 0U; i < sim_num; i++)
+        {
+            sim_table[i].offset_ms = CAN_SCHED_OFFSET_AUTO;
+        }
+        SIM_CHECK(can_sched_init(sim_table, sim_num) == STATUS_SUCCESS, "init of random table %u", n);
+        SIM_CHECK(can_sched_plan_bits_peak <= zero, "table %u: planned peak %u above %u of offsets 0", n,
+                  can_sched_plan_bits_peak, zero);
+        SIM_CHECK(can_sched_plan_bits_peak <= sim_lower_bound() + sim_max_bits(),
+                  "table %u: planned peak %u above the lower bound %u + %u", n, can_sched_plan_bits_peak,
+                  sim_lower_bound(), sim_max_bits());
+        ratio = (double)can_sched_plan_bits_peak / sim_lower_bound();
+        if (ratio > ratio_max)
+        {
+            ratio_max = ratio;
+            worst = n;
+        }
+    }
+    printf("%u random tables: planned peak at most %.2f times the lower bound (table %u)\n", tables, ratio_max, worst);
+}
+
+static bool sim_fill(uint8_t *data)
+{
+    data[0] = (uint8_t)sim_fill_num++;
+    return sim_fill_ok;
+}
+
+/* on change, on demand, fill, wrong entries, TX queue full and catch up */
+static void sim_modes(void)
+{
+    static const can_sched_msg_t table[] =
+    {
+        {0x200U, 8U, CAN_SCHED_MODE_ON_CHANGE, 50U, 0U, NULL},
+        {0x201U, 8U, CAN_SCHED_MODE_ON_DEMAND, 0U, 0U, NULL},
+        {0x202U, 4U, CAN_SCHED_MODE_PERIODIC, 10U, 3U, sim_fill},
+        {0x203U, 8U, CAN_SCHED_MODE_PERIODIC, 7U, CAN_SCHED_OFFSET_AUTO, NULL},
+        {0x204U, 8U, CAN_SCHED_MODE_PERIODIC, 10U, 10U, NULL},
+        {0x205U, 65U, CAN_SCHED_MODE_ON_DEMAND, 0U, 0U, NULL},
+        {0x206U, 8U, CAN_SCHED_MODE_PERIODIC, 20U, CAN_SCHED_OFFSET_AUTO, NULL}
+    };
+    can_sched_stats_t st;
+    uint8_t data[8] = {0U};
+    uint32_t t;
+
+    memcpy(sim_table, table, sizeof(table));
+    sim_num = sizeof(table) / sizeof(table[0]);
+    sim_reset();
+    SIM_CHECK(can_sched_init(sim_table, sim_num) == STATUS_ERROR, "wrong entries taken");
+    SIM_CHECK(!can_sched_stats(3U, &st) && !can_sched_stats(4U, &st) && !can_sched_stats(5U, &st),
+              "stats of wrong entries");
+    SIM_CHECK(can_sched_trigger(5U) == STATUS_ERROR, "trigger of a wrong entry");
+    SIM_CHECK(can_sched_set(sim_num, data) == STATUS_ERROR, "set past the table");
+
+    /* first data of an on change message goes out, the same data again not */
+    SIM_CHECK(can_sched_set(0U, data) == STATUS_SUCCESS, "set");
+    sim_run(100U, 0U, 0U);
+    (void)can_sched_stats(0U, &st);
+    SIM_CHECK(st.frame_num == 1U, "on change: %u frames for the first data", st.frame_num);
+    (void)can_sched_set(0U, data);
+    sim_run(100U, 0U, 0U);
+    (void)can_sched_stats(0U, &st);
+    SIM_CHECK(st.frame_num == 1U, "on change: %u frames for the same data", st.frame_num);
+    /* new data every ms: one frame per 50 ms, the last data goes out */
+    for (t = 0U; t < 1000U; t++)
+    {
+        data[0] = (uint8_t)(t + 1U);
+        (void)can_sched_set(0U, data);
+        sim_run(1U, 0U, 0U);
+    }
+    sim_run(100U, 0U, 0U);
+    (void)can_sched_stats(0U, &st);
+    SIM_CHECK((st.frame_num >= 20U) && (st.frame_num <= 22U), "on change: %u frames in 1s, 50ms apart",
+              st.frame_num);
+    SIM_CHECK(st.period_min >= 50U * SIM_TICKS_PER_MS, "on change: %u ticks apart", st.period_min);
+
+    /* on demand: one frame per trigger, in the next tick */
+    (void)can_sched_stats(1U, &st);
+    SIM_CHECK(st.frame_num == 0U, "on demand: frame without trigger");
+    (void)can_sched_trigger(1U);
+    (void)can_sched_trigger(1U);
+    sim_run(1U, 0U, 0U);
+    (void)can_sched_stats(1U, &st);
+    SIM_CHECK(st.frame_num == 1U, "on demand: %u frames for a trigger", st.frame_num);
+    sim_run(10U, 0U, 0U);
+    (void)can_sched_stats(1U, &st);
+    SIM_CHECK(st.frame_num == 1U, "on demand: %u frames later", st.frame_num);
+
+    /* fill false skips, TX queue full counts errors and the phase stays */
+    (void)can_sched_stats(2U, &st);
+    t = st.frame_num;
+    SIM_CHECK(st.offset_ms == 3U, "fixed offset %u", st.offset_ms);
+    sim_fill_ok = false;
+    sim_run(100U, 0U, 0U);
+    sim_fill_ok = true;
+    sim_tx_full = true;
+    sim_run(100U, 0U, 0U);
+    sim_tx_full = false;
+    (void)can_sched_stats(2U, &st);
+    SIM_CHECK((st.frame_num == t) && (st.skip_num == 10U) && (st.error_num == 10U),
+              "fill/queue full: %u frames, %u skipped, %u errors", st.frame_num - t, st.skip_num, st.error_num);
+
+    /* the task misses every third tick: nothing is lost, every frame in
+     * the tick it was due or the next */
+    (void)can_sched_stats(6U, &st);
+    t = st.frame_num;
+    sim_run(1000U, 0U, 3U);
+    (void)can_sched_stats(6U, &st);
+    SIM_CHECK(st.frame_num - t == 50U, "catch up: %u frames of 50", st.frame_num - t);
+    SIM_CHECK(st.late_max <= SIM_TICKS_PER_MS, "catch up: %u ticks late", st.late_max);
+    SIM_CHECK(can_sched_overrun_num >= 300U, "catch up: %u overruns", can_sched_overrun_num);
+    printf("modes: on change, on demand, fill, wrong entries, TX queue full and catch up checked\n");
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t seed = 1U;
+    uint32_t seconds = 10U;
+    uint32_t tables = 500U;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:t:r:")) != -1)
+    {
+        switch (opt)
+        {
+        case 's':
+            seed = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 't':
+            seconds = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'r':
+            tables = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-s seed] [-t seconds] [-r random tables]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (CAN_SCHED_MSG_MAX < SIM_MSG_NUM)
+    {
+        fprintf(stderr, "build with -DCAN_SCHED_MSG_MAX=128\n");
+        return 2;
+    }
+    srand(seed);
+
+    sim_burst(seconds);
+    sim_random(tables);
+    sim_modes();
+    printf("%s, %u errors\n", (sim_error == 0U) ? "PASS" : "FAIL", sim_error);
+    return (sim_error == 0U) ? 0 : 1;
+}
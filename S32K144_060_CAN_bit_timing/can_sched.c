@@ -0,0 +1,567 @@
+#include "can_sched.h"
+#include "can_stats.h"
+#include "string.h"
+
+#define CAN_SCHED_PERIOD_TICKS(ms) ((uint32_t)(ms) / CAN_SCHED_TICK_MS)
+/* rounds of the offset plan after the greedy placement, each one costs about
+ * as much as the greedy placement */
+#define CAN_SCHED_PLAN_ROUNDS 4U
+
+/* one message of the table. The data and pending are shared with
+ * can_sched_set() and can_sched_trigger(), everything else belongs to
+ * freertos_task_can_sched after can_sched_init() */
+typedef struct
+{
+    const can_sched_msg_t *msg;
+    bool valid;
+    bool sent;
+    bool pending;
+    uint32_t bits;          /* nominal bits with worst case stuffing */
+    uint32_t period;        /* scheduler ticks */
+    uint32_t next;          /* tick a periodic message is due next */
+    uint32_t last;          /* tick of the last release */
+    TickType_t last_tick;   /* FreeRTOS tick of the last release */
+    can_sched_stats_t stats;
+    uint8_t data[CAN_LLD_PAYLOAD_MAX];
+} can_sched_entry_t;
+
+volatile uint32_t can_sched_tick_num = 0U;
+uint32_t can_sched_overrun_num = 0U;
+uint32_t can_sched_plan_bits_peak = 0U;
+uint32_t can_sched_tick_bits_peak = 0U;
+uint32_t can_sched_load = 0U;
+uint32_t can_sched_load_peak = 0U;
+
+static can_sched_entry_t can_sched_table[CAN_SCHED_MSG_MAX];
+static uint32_t can_sched_num = 0U;
+static bool can_sched_ready = false;
+/* planned bits of every tick of CAN_SCHED_HYPER_MS, can_sched_init() only */
+static uint32_t can_sched_slot_bits[CAN_SCHED_SLOT_NUM];
+/* bits released in the last CAN_SCHED_LOAD_WINDOW_NUM ticks */
+static uint32_t can_sched_window_bits[CAN_SCHED_LOAD_WINDOW_NUM];
+static uint32_t can_sched_window_sum = 0U;
+/* ticks handled by the task, FreeRTOS tick of the last timer tick */
+static uint32_t can_sched_done = 0U;
+static volatile TickType_t can_sched_tick_time = 0U;
+static TaskHandle_t can_sched_task = NULL;
+/* bitrates of can_lld the bits of the messages were counted with */
+static uint32_t can_sched_bitrate = 0U;
+static uint32_t can_sched_data_bitrate = 0U;
+
+static bool can_sched_check(const can_sched_msg_t *msg);
+static uint32_t can_sched_bits(const can_sched_msg_t *msg);
+static void can_sched_bitrate_check(void);
+static void can_sched_plan(void);
+static uint32_t can_sched_place(const can_sched_entry_t *e);
+static void can_sched_slots(const can_sched_entry_t *e, bool add);
+static void can_sched_tick(uint32_t t, TickType_t due);
+static uint32_t can_sched_release(can_sched_entry_t *e, uint32_t t, TickType_t due);
+
+/* @brief: Take a new table, check its messages and plan the offsets of the
+ *         periodic ones. Messages failing the check are never sent. Called
+ *         once, before freertos_task_can_sched runs the first tick
+ * @param table : messages, must stay valid, the index into it is the one of
+ *                can_sched_set() and can_sched_trigger()
+ * @param num   : CAN_SCHED_MSG_MAX at most
+ * @return      : STATUS_ERROR if a message is wrong or the table too long
+ */
+status_t can_sched_init(const can_sched_msg_t *table, uint32_t num)
+{
+    status_t ret = STATUS_SUCCESS;
+    can_sched_entry_t *e;
+    uint32_t i;
+
+    __atomic_store_n(&can_sched_ready, false, __ATOMIC_SEQ_CST);
+    if (num > CAN_SCHED_MSG_MAX)
+    {
+        num = CAN_SCHED_MSG_MAX;
+        ret = STATUS_ERROR;
+    }
+
+    memset(can_sched_table, 0, sizeof(can_sched_table));
+    can_sched_bitrate = can_lld_get_bitrate(false);
+    can_sched_data_bitrate = can_lld_get_bitrate(true);
+    for (i = 0U; i < num; i++)
+    {
+        e = &can_sched_table[i];
+        e->msg = &table[i];
+        e->valid = can_sched_check(&table[i]);
+        if (!e->valid)
+        {
+            ret = STATUS_ERROR;
+            continue;
+        }
+        e->bits = can_sched_bits(&table[i]);
+        e->period = CAN_SCHED_PERIOD_TICKS(table[i].period_ms);
+    }
+    can_sched_num = num;
+    can_sched_plan();
+
+    memset(can_sched_window_bits, 0, sizeof(can_sched_window_bits));
+    can_sched_window_sum = 0U;
+    can_sched_overrun_num = 0U;
+    can_sched_tick_bits_peak = 0U;
+    can_sched_load = 0U;
+    can_sched_load_peak = 0U;
+    taskENTER_CRITICAL();
+    can_sched_tick_num = 0U;
+    can_sched_done = 0U;
+    taskEXIT_CRITICAL();
+    __atomic_store_n(&can_sched_ready, true, __ATOMIC_SEQ_CST);
+    return ret;
+}
+
+/* @brief: Timer tick, called from the LPIT channel 1 interrupt every
+ *         CAN_SCHED_TICK_MS
+ * @return: None
+ */
+void can_sched_tick_from_isr(void)
+{
+    TaskHandle_t task;
+    BaseType_t woken = pdFALSE;
+
+    if (!__atomic_load_n(&can_sched_ready, __ATOMIC_SEQ_CST))
+    {
+        return;
+    }
+    can_sched_tick_time = xTaskGetTickCountFromISR();
+    can_sched_tick_num++;
+    task = __atomic_load_n(&can_sched_task, __ATOMIC_SEQ_CST);
+    if (task != NULL)
+    {
+        vTaskNotifyGiveFromISR(task, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+}
+
+/* @brief: Send the messages of every tick since the last run, in tick order.
+ *         Called by freertos_task_can_sched
+ * @return: None
+ */
+void can_sched_run(void)
+{
+    uint32_t now;
+    TickType_t tick_time;
+
+    if (!__atomic_load_n(&can_sched_ready, __ATOMIC_SEQ_CST))
+    {
+        return;
+    }
+    taskENTER_CRITICAL();
+    now = can_sched_tick_num;
+    tick_time = can_sched_tick_time;
+    taskEXIT_CRITICAL();
+
+    if ((now - can_sched_done) > 1U)
+    {
+        can_sched_overrun_num++;
+    }
+    /* tick n - 1 of the scheduler is the n-th timer interrupt */
+    while (can_sched_done != now)
+    {
+        can_sched_tick(can_sched_done,
+                       tick_time - ((now - 1U - can_sched_done) * pdMS_TO_TICKS(CAN_SCHED_TICK_MS)));
+        can_sched_done++;
+    }
+}
+
+/* @brief: New data of a message without a fill function. An on change
+ *         message is sent if it differs from the last data, or was never sent
+ * @param index : into the table of can_sched_init()
+ * @param data  : len bytes of the message
+ * @return      : STATUS_ERROR for a wrong index
+ */
+status_t can_sched_set(uint32_t index, const uint8_t *data)
+{
+    can_sched_entry_t *e;
+
+    if ((index >= can_sched_num) || !can_sched_table[index].valid)
+    {
+        return STATUS_ERROR;
+    }
+    e = &can_sched_table[index];
+    taskENTER_CRITICAL();
+    if ((e->msg->mode == (uint8_t)CAN_SCHED_MODE_ON_CHANGE) &&
+        ((memcmp(e->data, data, e->msg->len) != 0) || !e->sent))
+    {
+        e->pending = true;
+    }
+    memcpy(e->data, data, e->msg->len);
+    taskEXIT_CRITICAL();
+    return STATUS_SUCCESS;
+}
+
+/* @brief: Send a message in the next tick, an on change or on demand one not
+ *         before period_ms after its last frame. A periodic message keeps its
+ *         phase, this frame comes on top
+ * @param index : into the table of can_sched_init()
+ * @return      : STATUS_ERROR for a wrong index
+ */
+status_t can_sched_trigger(uint32_t index)
+{
+    if ((index >= can_sched_num) || !can_sched_table[index].valid)
+    {
+        return STATUS_ERROR;
+    }
+    __atomic_store_n(&can_sched_table[index].pending, true, __ATOMIC_SEQ_CST);
+    return STATUS_SUCCESS;
+}
+
+/* @brief: Statistics of one message
+ * @param index : into the table of can_sched_init()
+ * @param stats : copy of them
+ * @return      : false for a wrong index or a message failing the check
+ */
+bool can_sched_stats(uint32_t index, can_sched_stats_t *stats)
+{
+    if ((index >= can_sched_num) || !can_sched_table[index].valid)
+    {
+        return false;
+    }
+    taskENTER_CRITICAL();
+    *stats = can_sched_table[index].stats;
+    taskEXIT_CRITICAL();
+    return true;
+}
+
+void freertos_task_can_sched(void *pvParameters)
+{
+    (void)pvParameters;
+
+    __atomic_store_n(&can_sched_task, xTaskGetCurrentTaskHandle(), __ATOMIC_SEQ_CST);
+    for (;;)
+    {
+        (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        can_sched_run();
+    }
+}
+
+/* @brief: A message the scheduler can send
+ * @param msg : message of the table
+ * @return    : true if it is fine
+ */
+static bool can_sched_check(const can_sched_msg_t *msg)
+{
+    uint32_t period = CAN_SCHED_PERIOD_TICKS(msg->period_ms);
+
+    if ((msg->len > CAN_LLD_PAYLOAD_MAX) || ((msg->period_ms % CAN_SCHED_TICK_MS) != 0U))
+    {
+        return false;
+    }
+    if (msg->mode == (uint8_t)CAN_SCHED_MODE_PERIODIC)
+    {
+        return (period != 0U) && ((CAN_SCHED_SLOT_NUM % period) == 0U) &&
+               ((msg->offset_ms == CAN_SCHED_OFFSET_AUTO) ||
+                ((msg->offset_ms < msg->period_ms) && ((msg->offset_ms % CAN_SCHED_TICK_MS) == 0U)));
+    }
+    return (msg->mode == (uint8_t)CAN_SCHED_MODE_ON_CHANGE) || (msg->mode == (uint8_t)CAN_SCHED_MODE_ON_DEMAND);
+}
+
+/* @brief: Length of a frame of the message on the bus
+ * @param msg : message of the table
+ * @return    : nominal bits with worst case stuffing, rounded up
+ */
+static uint32_t can_sched_bits(const can_sched_msg_t *msg)
+{
+    bool fd = ((msg->messageId & CAN_LLD_TX_ID_FD) != 0U) || (msg->len > 8U);
+    uint32_t len = fd ? can_lld_dlc_to_len(can_lld_len_to_dlc(msg->len)) : msg->len;
+    uint32_t stuff;
+    uint32_t units = can_stats_frame_bits((msg->messageId & CAN_LLD_TX_ID_EXT) != 0U, fd,
+                                          fd && (CAN_LLD_FD_BRS_ENABLE != 0), len, &stuff);
+
+    return (units + stuff + CAN_STATS_BIT_SCALE - 1U) / CAN_STATS_BIT_SCALE;
+}
+
+/* @brief: Count the bits of the messages again after can_lld_set_bitrate()
+ *         or can_lld_autobaud(), a FD data phase takes another share of the
+ *         nominal bits. The plan of can_sched_init() stays as it was
+ * @return: None
+ */
+static void can_sched_bitrate_check(void)
+{
+    uint32_t bitrate = can_lld_get_bitrate(false);
+    uint32_t data_bitrate = can_lld_get_bitrate(true);
+    uint32_t i;
+
+    if ((bitrate == can_sched_bitrate) && (data_bitrate == can_sched_data_bitrate))
+    {
+        return;
+    }
+    can_sched_bitrate = bitrate;
+    can_sched_data_bitrate = data_bitrate;
+    for (i = 0U; i < can_sched_num; i++)
+    {
+        if (can_sched_table[i].valid)
+        {
+            can_sched_table[i].bits = can_sched_bits(can_sched_table[i].msg);
+        }
+    }
+}
+
+/* @brief: Offsets of the periodic messages. Fixed ones are taken as they
+ *         are, then the automatic ones are placed one by one, shortest period
+ *         first and longer frames first within a period: each takes the
+ *         offset whose ticks hold the fewest bits so far, the highest tick
+ *         counts first, then their sum. Greedy, but the short periods that
+ *         leave the least choice go first. Some rounds of placing each one
+ *         again against all the others take out most of what the greedy
+ *         order got wrong
+ * @return: None
+ */
+static void can_sched_plan(void)
+{
+    can_sched_entry_t *e;
+    can_sched_entry_t *best;
+    uint32_t i;
+    uint32_t slot;
+    uint32_t round;
+    bool moved;
+
+    memset(can_sched_slot_bits, 0, sizeof(can_sched_slot_bits));
+    for (i = 0U; i < can_sched_num; i++)
+    {
+        e = &can_sched_table[i];
+        if (e->valid && (e->msg->mode == (uint8_t)CAN_SCHED_MODE_PERIODIC) &&
+            (e->msg->offset_ms != CAN_SCHED_OFFSET_AUTO))
+        {
+            e->next = CAN_SCHED_PERIOD_TICKS(e->msg->offset_ms);
+            can_sched_slots(e, true);
+        }
+    }
+
+    /* next is CAN_SCHED_SLOT_NUM as long as an automatic one is not placed */
+    for (i = 0U; i < can_sched_num; i++)
+    {
+        e = &can_sched_table[i];
+        if (e->valid && (e->msg->mode == (uint8_t)CAN_SCHED_MODE_PERIODIC) &&
+            (e->msg->offset_ms == CAN_SCHED_OFFSET_AUTO))
+        {
+            e->next = CAN_SCHED_SLOT_NUM;
+        }
+    }
+    for (;;)
+    {
+        best = NULL;
+        for (i = 0U; i < can_sched_num; i++)
+        {
+            e = &can_sched_table[i];
+            if ((e->next == CAN_SCHED_SLOT_NUM) &&
+                ((best == NULL) || (e->period < best->period) ||
+                 ((e->period == best->period) && (e->bits > best->bits))))
+            {
+                best = e;
+            }
+        }
+        if (best == NULL)
+        {
+            break;
+        }
+        best->next = can_sched_place(best);
+        can_sched_slots(best, true);
+    }
+
+    /* take the automatic ones out again one by one and put them back at the
+     * best offset with all the others in place, until none moves */
+    for (round = 0U; round < CAN_SCHED_PLAN_ROUNDS; round++)
+    {
+        moved = false;
+        for (i = 0U; i < can_sched_num; i++)
+        {
+            e = &can_sched_table[i];
+            if (e->valid && (e->msg->mode == (uint8_t)CAN_SCHED_MODE_PERIODIC) &&
+                (e->msg->offset_ms == CAN_SCHED_OFFSET_AUTO))
+            {
+                can_sched_slots(e, false);
+                slot = can_sched_place(e);
+                moved = moved || (slot != e->next);
+                e->next = slot;
+                can_sched_slots(e, true);
+            }
+        }
+        if (!moved)
+        {
+            break;
+        }
+    }
+    for (i = 0U; i < can_sched_num; i++)
+    {
+        e = &can_sched_table[i];
+        if (e->valid && (e->msg->mode == (uint8_t)CAN_SCHED_MODE_PERIODIC))
+        {
+            e->stats.offset_ms = e->next * CAN_SCHED_TICK_MS;
+        }
+    }
+
+    can_sched_plan_bits_peak = 0U;
+    for (slot = 0U; slot < CAN_SCHED_SLOT_NUM; slot++)
+    {
+        if (can_sched_slot_bits[slot] > can_sched_plan_bits_peak)
+        {
+            can_sched_plan_bits_peak = can_sched_slot_bits[slot];
+        }
+    }
+}
+
+/* @brief: Offset of the least loaded ticks for a periodic message
+ * @param e : the message
+ * @return  : offset in scheduler ticks
+ */
+static uint32_t can_sched_place(const can_sched_entry_t *e)
+{
+    uint32_t offset;
+    uint32_t slot;
+    uint32_t max;
+    uint32_t sum;
+    uint32_t best = 0U;
+    uint32_t best_max = UINT32_MAX;
+    uint32_t best_sum = UINT32_MAX;
+
+    for (offset = 0U; offset < e->period; offset++)
+    {
+        max = 0U;
+        sum = 0U;
+        for (slot = offset; slot < CAN_SCHED_SLOT_NUM; slot += e->period)
+        {
+            if (can_sched_slot_bits[slot] > max)
+            {
+                max = can_sched_slot_bits[slot];
+            }
+            sum += can_sched_slot_bits[slot];
+        }
+        if ((max < best_max) || ((max == best_max) && (sum < best_sum)))
+        {
+            best = offset;
+            best_max = max;
+            best_sum = sum;
+        }
+    }
+    return best;
+}
+
+/* @brief: Add or take out the bits of a periodic message in its ticks
+ * @param e   : the message, next holds its offset
+ * @param add : false to take them out
+ * @return    : None
+ */
+static void can_sched_slots(const can_sched_entry_t *e, bool add)
+{
+    uint32_t slot;
+
+    for (slot = e->next; slot < CAN_SCHED_SLOT_NUM; slot += e->period)
+    {
+        if (add)
+        {
+            can_sched_slot_bits[slot] += e->bits;
+        }
+        else
+        {
+            can_sched_slot_bits[slot] -= e->bits;
+        }
+    }
+}
+
+/* @brief: Send the messages of one tick and count its bits
+ * @param t   : scheduler tick
+ * @param due : FreeRTOS tick of its timer interrupt
+ * @return    : None
+ */
+static void can_sched_tick(uint32_t t, TickType_t due)
+{
+    can_sched_entry_t *e;
+    uint32_t bits = 0U;
+    uint32_t i;
+    bool send;
+
+    can_sched_bitrate_check();
+    for (i = 0U; i < can_sched_num; i++)
+    {
+        e = &can_sched_table[i];
+        if (!e->valid)
+        {
+            continue;
+        }
+        send = false;
+        if ((e->msg->mode == (uint8_t)CAN_SCHED_MODE_PERIODIC) && ((int32_t)(t - e->next) >= 0))
+        {
+            e->next += e->period;
+            send = true;
+        }
+        if (__atomic_load_n(&e->pending, __ATOMIC_SEQ_CST) &&
+            ((e->msg->mode == (uint8_t)CAN_SCHED_MODE_PERIODIC) || !e->sent || ((t - e->last) >= e->period)))
+        {
+            send = true;
+        }
+        if (send)
+        {
+            bits += can_sched_release(e, t, due);
+        }
+    }
+
+    if (bits > can_sched_tick_bits_peak)
+    {
+        can_sched_tick_bits_peak = bits;
+    }
+    i = t % CAN_SCHED_LOAD_WINDOW_NUM;
+    can_sched_window_sum = (can_sched_window_sum - can_sched_window_bits[i]) + bits;
+    can_sched_window_bits[i] = bits;
+    can_sched_load = (uint32_t)(((uint64_t)can_sched_window_sum * 10000U * 1000U) /
+                                ((uint64_t)can_sched_bitrate * CAN_SCHED_LOAD_WINDOW_MS));
+    if (can_sched_load > can_sched_load_peak)
+    {
+        can_sched_load_peak = can_sched_load;
+    }
+}
+
+/* @brief: Fill in a frame of a message and queue it
+ * @param e   : the message
+ * @param t   : scheduler tick
+ * @param due : FreeRTOS tick the message was due
+ * @return    : bits of the frame, 0 if it was not queued
+ */
+static uint32_t can_sched_release(can_sched_entry_t *e, uint32_t t, TickType_t due)
+{
+    uint8_t data[CAN_LLD_PAYLOAD_MAX];
+    TickType_t tick;
+    uint32_t period;
+
+    taskENTER_CRITICAL();
+    e->pending = false;
+    if (e->msg->fill == NULL)
+    {
+        memcpy(data, e->data, e->msg->len);
+    }
+    taskEXIT_CRITICAL();
+    if ((e->msg->fill != NULL) && !e->msg->fill(data))
+    {
+        e->stats.skip_num++;
+        return 0U;
+    }
+
+    tick = xTaskGetTickCount();
+    if (can_lld_tx(e->msg->messageId, data, e->msg->len) != STATUS_SUCCESS)
+    {
+        e->stats.error_num++;
+        return 0U;
+    }
+    e->stats.frame_num++;
+    if (e->sent)
+    {
+        period = tick - e->last_tick;
+        if ((e->stats.frame_num == 2U) || (period < e->stats.period_min))
+        {
+            e->stats.period_min = period;
+        }
+        if (period > e->stats.period_max)
+        {
+            e->stats.period_max = period;
+        }
+    }
+    if ((tick - due) > e->stats.late_max)
+    {
+        e->stats.late_max = tick - due;
+    }
+    e->sent = true;
+    e->last = t;
+    e->last_tick = tick;
+    return e->bits;
+}
@@ -0,0 +1,103 @@
+#ifndef CAN_SCHED_H
+#define CAN_SCHED_H
+
+#include "can_lld.h"
+
+/* Table driven CAN transmit scheduler. LPIT channel 1 interrupts every
+ * CAN_SCHED_TICK_MS and calls can_sched_tick_from_isr(), which only counts
+ * the tick and wakes freertos_task_can_sched. The task sends every message
+ * due in the ticks since its last run with can_lld_tx(), one task and one
+ * timer for all rates.
+ *
+ * A periodic message is sent in the ticks where (time - offset) is a
+ * multiple of its period. can_sched_init() gives every periodic message of
+ * the table an offset so the frames of a tick add up to as few bits as the
+ * periods allow, instead of all 10 ms messages bursting together in tick 0.
+ * On change and on demand messages go out in the next tick after
+ * can_sched_set() changed their data or can_sched_trigger() */
+
+/* messages of the table, the host simulation builds with more */
+#ifndef CAN_SCHED_MSG_MAX
+#define CAN_SCHED_MSG_MAX 16U
+#endif
+
+/* period of LPIT channel 1 */
+#define CAN_SCHED_TICK_MS 1U
+/* every period is a multiple of CAN_SCHED_TICK_MS dividing this, the
+ * offsets are planned over one of these. Holds the planned bits of each tick,
+ * 4 bytes per tick */
+#define CAN_SCHED_HYPER_MS 1000U
+#define CAN_SCHED_SLOT_NUM (CAN_SCHED_HYPER_MS / CAN_SCHED_TICK_MS)
+
+/* sliding window of the bus load peak */
+#define CAN_SCHED_LOAD_WINDOW_MS 10U
+#define CAN_SCHED_LOAD_WINDOW_NUM (CAN_SCHED_LOAD_WINDOW_MS / CAN_SCHED_TICK_MS)
+
+/* offset of can_sched_msg_t for one chosen by can_sched_init() */
+#define CAN_SCHED_OFFSET_AUTO 0xFFFFU
+
+#if ((CAN_SCHED_HYPER_MS % CAN_SCHED_TICK_MS) != 0U) || ((CAN_SCHED_LOAD_WINDOW_MS % CAN_SCHED_TICK_MS) != 0U)
+#error "CAN_SCHED_HYPER_MS and CAN_SCHED_LOAD_WINDOW_MS must be multiples of CAN_SCHED_TICK_MS"
+#endif
+
+typedef enum
+{
+    CAN_SCHED_MODE_PERIODIC = 0,    /* every period_ms */
+    CAN_SCHED_MODE_ON_CHANGE,       /* when can_sched_set() changed the data,
+                                     * period_ms apart at least */
+    CAN_SCHED_MODE_ON_DEMAND        /* after can_sched_trigger(), period_ms
+                                     * apart at least */
+} can_sched_mode_t;
+
+typedef struct
+{
+    uint32_t messageId;     /* as for can_lld_tx(), with CAN_LLD_TX_ID_EXT
+                             * and CAN_LLD_TX_ID_FD */
+    uint8_t len;
+    uint8_t mode;           /* can_sched_mode_t */
+    uint16_t period_ms;     /* 0 for no minimum distance of an on change or
+                             * on demand message */
+    uint16_t offset_ms;     /* first tick of a periodic message, below
+                             * period_ms, or CAN_SCHED_OFFSET_AUTO */
+    /* called in freertos_task_can_sched to fill in the payload right before
+     * the frame is queued, false skips this frame. NULL sends the data of
+     * can_sched_set() */
+    bool (*fill)(uint8_t *data);
+} can_sched_msg_t;
+
+/* one message, the release is the call of can_lld_tx(). Times are FreeRTOS
+ * ticks, the period ones are measured between two releases */
+typedef struct
+{
+    uint32_t offset_ms;     /* planned offset */
+    uint32_t frame_num;
+    uint32_t skip_num;      /* fill returned false */
+    uint32_t error_num;     /* can_lld_tx() failed, TX queue full or a FD
+                             * frame in classic mode */
+    uint32_t period_min;
+    uint32_t period_max;
+    uint32_t late_max;      /* release after the timer tick it was due in */
+} can_sched_stats_t;
+
+/* ticks of LPIT channel 1 since can_sched_init() */
+extern volatile uint32_t can_sched_tick_num;
+/* task runs that found more than one tick to catch up with */
+extern uint32_t can_sched_overrun_num;
+/* bits of one tick with worst case stuffing: the highest of the plan of
+ * can_sched_init() and the highest sent. The bus carries
+ * can_lld_get_bitrate(false) / 1000 * CAN_SCHED_TICK_MS bits per tick */
+extern uint32_t can_sched_plan_bits_peak;
+extern uint32_t can_sched_tick_bits_peak;
+/* 0.01 %, frames released in the last CAN_SCHED_LOAD_WINDOW_MS and the
+ * highest one, worst case stuffing */
+extern uint32_t can_sched_load;
+extern uint32_t can_sched_load_peak;
+
+status_t can_sched_init(const can_sched_msg_t *table, uint32_t num);
+void can_sched_tick_from_isr(void);
+void can_sched_run(void);
+status_t can_sched_set(uint32_t index, const uint8_t *data);
+status_t can_sched_trigger(uint32_t index);
+bool can_sched_stats(uint32_t index, can_sched_stats_t *stats);
+
+#endif
@@ -0,0 +1,358 @@
+#include "can_timing.h"
+
+/* tq_min is 8 for a nominal bit (ISO 11898-1) and 5 for a data phase bit */
+const can_timing_limits_t can_timing_limits[CAN_TIMING_PHASE_NUM] =
+{
+    /* CTRL1: PRESDIV 8 bits, PROPSEG, PSEG1, PSEG2 3 bits, RJW 2 bits */
+    {255U, 0U, 7U, 7U, 1U, 7U, 3U, 8U, 25U},
+    /* CBT: EPRESDIV 10 bits, EPROPSEG 6 bits, EPSEG1, EPSEG2, ERJW 5 bits */
+    {1023U, 0U, 63U, 31U, 1U, 31U, 31U, 8U, 129U},
+    /* FDCBT: FPRESDIV 10 bits, FPROPSEG 5 bits, FPSEG1, FPSEG2, FRJW 3 bits */
+    {1023U, 0U, 31U, 7U, 1U, 7U, 7U, 5U, 48U}
+};
+
+static uint32_t can_timing_ppm(uint32_t num, uint32_t den);
+static uint32_t can_timing_min(uint32_t a, uint32_t b);
+static uint32_t can_timing_sp_error(uint32_t sample_point, uint32_t target);
+static bool can_timing_better(const can_timing_t *a, const can_timing_t *b, uint16_t sample_point,
+                              can_timing_phase_t phase);
+static void can_timing_insert(can_timing_t *out, uint32_t max, uint32_t num, const can_timing_t *timing,
+                              uint16_t sample_point, can_timing_phase_t phase);
+
+/* @brief: Every segment set of a phase for a bitrate, sorted by oscillator
+ *         tolerance, then by the distance to the sample point, the number
+ *         of tq and the SJW. The bitrate must be met exactly, the sample point
+ *         within CAN_TIMING_SAMPLE_POINT_TOL
+ * @param pe_clock     : FlexCAN PE clock, Hz
+ * @param bitrate      : bit/s
+ * @param sample_point : 0.1 %, 875 for 87.5 %
+ * @param prop_delay_ns: nominal phases: shortest propagation segment, twice
+ *                       the bus and transceiver delay. 0 for no limit. The
+ *                       data phase relies on the TDC and ignores it
+ * @param phase        : register set the result is for
+ * @param out          : the best max results, may be NULL with max 0
+ * @param max          : size of out
+ * @return             : number of valid segment sets, may be more than max
+ */
+uint32_t can_timing_solve(uint32_t pe_clock, uint32_t bitrate, uint16_t sample_point, uint32_t prop_delay_ns,
+                          can_timing_phase_t phase, can_timing_t *out, uint32_t max)
+{
+    const can_timing_limits_t *lim;
+    can_timing_t timing;
+    uint32_t clocks;
+    uint32_t presc;
+    uint32_t tq;
+    uint32_t ps1;
+    uint32_t ps2;
+    uint32_t prop;
+    uint32_t prop_min;
+    uint32_t sjw;
+    uint32_t sp;
+    uint32_t num = 0U;
+    /* FDCBT[FPROPSEG] is the segment in tq, the other phases add one */
+    uint32_t prop_add = (phase == CAN_TIMING_DATA) ? 0U : 1U;
+
+    if ((phase >= CAN_TIMING_PHASE_NUM) || (bitrate == 0U) || ((pe_clock % bitrate) != 0U))
+    {
+        return 0U;
+    }
+    lim = &can_timing_limits[phase];
+    clocks = pe_clock / bitrate;
+
+    for (presc = 1U; presc <= (lim->presdiv_max + 1U); presc++)
+    {
+        if ((clocks % presc) != 0U)
+        {
+            continue;
+        }
+        tq = clocks / presc;
+        if ((tq < lim->tq_min) || (tq > lim->tq_max))
+        {
+            continue;
+        }
+        prop_min = lim->propseg_min + prop_add;
+        if ((phase != CAN_TIMING_DATA) && (prop_delay_ns != 0U))
+        {
+            /* tq of presc PE clocks covering the delay */
+            uint64_t delay = (uint64_t)prop_delay_ns * pe_clock;
+            uint64_t tq_len = (uint64_t)presc * 1000000000ULL;
+            uint32_t need = (uint32_t)((delay + tq_len - 1U) / tq_len);
+
+            if (need > prop_min)
+            {
+                prop_min = need;
+            }
+        }
+
+        for (ps2 = lim->pseg2_min + 1U; ps2 <= (lim->pseg2_max + 1U); ps2++)
+        {
+            /* the sync segment takes one tq */
+            if ((ps2 + 2U) > tq)
+            {
+                break;
+            }
+            sp = ((1000U * (tq - ps2)) + (tq / 2U)) / tq;
+            if (can_timing_sp_error(sp, sample_point) > CAN_TIMING_SAMPLE_POINT_TOL)
+            {
+                continue;
+            }
+            for (ps1 = 1U; ps1 <= (lim->pseg1_max + 1U); ps1++)
+            {
+                if ((ps1 + ps2 + 1U) > tq)
+                {
+                    break;
+                }
+                prop = tq - 1U - ps1 - ps2;
+                if ((prop < prop_min) || (prop > (lim->propseg_max + prop_add)))
+                {
+                    continue;
+                }
+                for (sjw = 1U; sjw <= can_timing_min(lim->rjw_max + 1U, can_timing_min(ps1, ps2)); sjw++)
+                {
+                    timing.seg.propSeg = prop - prop_add;
+                    timing.seg.phaseSeg1 = ps1 - 1U;
+                    timing.seg.phaseSeg2 = ps2 - 1U;
+                    timing.seg.preDivider = presc - 1U;
+                    timing.seg.rJumpwidth = sjw - 1U;
+                    timing.tq = (uint16_t)tq;
+                    timing.sample_point = (uint16_t)sp;
+                    timing.tolerance = can_timing_tolerance(&timing.seg, phase);
+                    can_timing_insert(out, max, num, &timing, sample_point, phase);
+                    num++;
+                }
+            }
+        }
+    }
+    return num;
+}
+
+/* @brief: Check a segment set against the register ranges of a phase
+ * @param seg   : register values
+ * @param phase : register set
+ * @return      : true if FlexCAN can run it
+ */
+bool can_timing_check(const flexcan_time_segment_t *seg, can_timing_phase_t phase)
+{
+    const can_timing_limits_t *lim;
+    uint32_t tq;
+
+    if (phase >= CAN_TIMING_PHASE_NUM)
+    {
+        return false;
+    }
+    lim = &can_timing_limits[phase];
+    if ((seg->preDivider > lim->presdiv_max) || (seg->propSeg < lim->propseg_min) ||
+        (seg->propSeg > lim->propseg_max) || (seg->phaseSeg1 > lim->pseg1_max) ||
+        (seg->phaseSeg2 < lim->pseg2_min) || (seg->phaseSeg2 > lim->pseg2_max) ||
+        (seg->rJumpwidth > lim->rjw_max))
+    {
+        return false;
+    }
+    /* SJW <= min(PS1, PS2), all three stored minus one */
+    if ((seg->rJumpwidth > seg->phaseSeg1) || (seg->rJumpwidth > seg->phaseSeg2))
+    {
+        return false;
+    }
+    tq = can_timing_tq(seg, phase);
+    return (tq >= lim->tq_min) && (tq <= lim->tq_max);
+}
+
+/* @brief: Time quanta of one bit
+ * @param seg   : register values
+ * @param phase : register set
+ * @return      : tq
+ */
+uint32_t can_timing_tq(const flexcan_time_segment_t *seg, can_timing_phase_t phase)
+{
+    uint32_t tq = 1U + seg->propSeg + (seg->phaseSeg1 + 1U) + (seg->phaseSeg2 + 1U);
+
+    return (phase == CAN_TIMING_DATA) ? tq : (tq + 1U);
+}
+
+/* @brief: Bitrate of a segment set
+ * @param pe_clock : FlexCAN PE clock, Hz
+ * @param seg      : register values
+ * @param phase    : register set
+ * @return         : bit/s, rounded down
+ */
+uint32_t can_timing_bitrate(uint32_t pe_clock, const flexcan_time_segment_t *seg, can_timing_phase_t phase)
+{
+    return pe_clock / ((seg->preDivider + 1U) * can_timing_tq(seg, phase));
+}
+
+/* @brief: Sample point of a segment set, the end of PS1
+ * @param seg   : register values
+ * @param phase : register set
+ * @return      : 0.1 %
+ */
+uint32_t can_timing_sample_point(const flexcan_time_segment_t *seg, can_timing_phase_t phase)
+{
+    uint32_t tq = can_timing_tq(seg, phase);
+
+    return ((1000U * (tq - (seg->phaseSeg2 + 1U))) + (tq / 2U)) / tq;
+}
+
+/* @brief: Oscillator tolerance of one phase. Nominal phases: the smaller of
+ *         the two conditions of the header. Data phase alone: only
+ *         SJW / (20 * DBT), the rest needs the nominal phase, see
+ *         can_timing_tolerance_fd()
+ * @param seg   : register values
+ * @param phase : register set
+ * @return      : ppm, rounded down
+ */
+uint32_t can_timing_tolerance(const flexcan_time_segment_t *seg, can_timing_phase_t phase)
+{
+    uint32_t tq = can_timing_tq(seg, phase);
+    uint32_t ps1 = seg->phaseSeg1 + 1U;
+    uint32_t ps2 = seg->phaseSeg2 + 1U;
+    uint32_t sjw = seg->rJumpwidth + 1U;
+    uint32_t df = can_timing_ppm(sjw, 20U * tq);
+
+    if (phase != CAN_TIMING_DATA)
+    {
+        df = can_timing_min(df, can_timing_ppm(can_timing_min(ps1, ps2), 2U * ((13U * tq) - ps2)));
+    }
+    return df;
+}
+
+/* @brief: Oscillator tolerance of a CAN FD node, the smallest of the five
+ *         conditions of Hartwich. NBT and DBT in tq of their own phase, the
+ *         prescaler ratio scales between them:
+ *         1: SJW_N / (20 * NBT)
+ *         2: min(PS1_N, PS2_N) / (2 * (13 * NBT - PS2_N))
+ *         3: SJW_D / (20 * DBT)
+ *         4: min(PS1_N, PS2_N) / (2 * ((6 * DBT - PS1_D) * BRP_D / BRP_N + 7 * NBT))
+ *         5: (SJW_D - max(0, BRP_N / BRP_D - 1)) /
+ *            (2 * ((2 * NBT - PS2_N) * BRP_N / BRP_D + PS2_D + 4 * DBT))
+ * @param nominal : nominal phase register values
+ * @param data    : data phase register values
+ * @return        : ppm, rounded down. 0 if condition 5 cannot be met
+ */
+uint32_t can_timing_tolerance_fd(const flexcan_time_segment_t *nominal, const flexcan_time_segment_t *data)
+{
+    uint32_t nbt = can_timing_tq(nominal, CAN_TIMING_NOMINAL);
+    uint32_t dbt = can_timing_tq(data, CAN_TIMING_DATA);
+    uint32_t ps1_n = nominal->phaseSeg1 + 1U;
+    uint32_t ps2_n = nominal->phaseSeg2 + 1U;
+    uint32_t ps1_d = data->phaseSeg1 + 1U;
+    uint32_t ps2_d = data->phaseSeg2 + 1U;
+    uint32_t sjw_d = data->rJumpwidth + 1U;
+    uint32_t brp_n = nominal->preDivider + 1U;
+    uint32_t brp_d = data->preDivider + 1U;
+    uint32_t ps_n = can_timing_min(ps1_n, ps2_n);
+    uint32_t loss = (brp_n > brp_d) ? (brp_n - brp_d) : 0U;
+    uint32_t df;
+
+    df = can_timing_tolerance(nominal, CAN_TIMING_NOMINAL);
+    df = can_timing_min(df, can_timing_tolerance(data, CAN_TIMING_DATA));
+    /* 4 and 5 with both sides multiplied by the prescaler in the divisor */
+    df = can_timing_min(df, can_timing_ppm(ps_n * brp_n, 2U * ((((6U * dbt) - ps1_d) * brp_d) + (7U * nbt * brp_n))));
+    if ((sjw_d * brp_d) <= loss)
+    {
+        return 0U;
+    }
+    df = can_timing_min(df, can_timing_ppm((sjw_d * brp_d) - loss,
+                                           2U * ((((2U * nbt) - ps2_n) * brp_n) + ((ps2_d + (4U * dbt)) * brp_d))));
+    return df;
+}
+
+/* @brief: Transmitter delay compensation offset of a data phase, the
+ *         secondary sample point at the sample point
+ * @param data : data phase register values
+ * @return     : PE clocks, (FPROPSEG + FPSEG1 + 2) * (FPRESDIV + 1). TDC
+ *               only above CAN_TIMING_TDC_OFFSET_MAX is not possible
+ */
+uint32_t can_timing_tdc_offset(const flexcan_time_segment_t *data)
+{
+    return (data->propSeg + data->phaseSeg1 + 2U) * (data->preDivider + 1U);
+}
+
+/* @brief: num / den in ppm, rounded down
+ * @param num : numerator
+ * @param den : denominator, not 0
+ * @return    : ppm
+ */
+static uint32_t can_timing_ppm(uint32_t num, uint32_t den)
+{
+    return (uint32_t)(((uint64_t)num * 1000000U) / den);
+}
+
+static uint32_t can_timing_min(uint32_t a, uint32_t b)
+{
+    return (a < b) ? a : b;
+}
+
+static uint32_t can_timing_sp_error(uint32_t sample_point, uint32_t target)
+{
+    return (sample_point > target) ? (sample_point - target) : (target - sample_point);
+}
+
+/* @brief: Ranking of can_timing_solve()
+ * @param a            : candidate
+ * @param b            : result already kept
+ * @param sample_point : target, 0.1 %
+ * @param phase        : register set
+ * @return             : true if a goes before b
+ */
+static bool can_timing_better(const can_timing_t *a, const can_timing_t *b, uint16_t sample_point,
+                              can_timing_phase_t phase)
+{
+    uint32_t err_a = can_timing_sp_error(a->sample_point, sample_point);
+    uint32_t err_b = can_timing_sp_error(b->sample_point, sample_point);
+
+    if (a->tolerance != b->tolerance)
+    {
+        return a->tolerance > b->tolerance;
+    }
+    if (err_a != err_b)
+    {
+        return err_a < err_b;
+    }
+    if (a->tq != b->tq)
+    {
+        return a->tq > b->tq;
+    }
+    if (a->seg.rJumpwidth != b->seg.rJumpwidth)
+    {
+        return a->seg.rJumpwidth > b->seg.rJumpwidth;
+    }
+    /* nominal: the longest propagation segment for the longest bus. Data:
+     * the TDC covers the delay, a longer PS1 helps condition 4 of
+     * can_timing_tolerance_fd() */
+    if (phase == CAN_TIMING_DATA)
+    {
+        return a->seg.phaseSeg1 > b->seg.phaseSeg1;
+    }
+    return a->seg.propSeg > b->seg.propSeg;
+}
+
+/* @brief: Insertion into the sorted results, the worst one falls off when
+ *         all max are taken
+ * @param out          : results
+ * @param max          : size of out
+ * @param num          : results found before this one
+ * @param timing       : new result
+ * @param sample_point : target, 0.1 %
+ * @param phase        : register set
+ * @return             : None
+ */
+static void can_timing_insert(can_timing_t *out, uint32_t max, uint32_t num, const can_timing_t *timing,
+                              uint16_t sample_point, can_timing_phase_t phase)
+{
+    uint32_t i = (num < max) ? num : max;
+
+    if ((i == max) && ((max == 0U) || !can_timing_better(timing, &out[max - 1U], sample_point, phase)))
+    {
+        return;
+    }
+    if (i == max)
+    {
+        i--;
+    }
+    while ((i > 0U) && can_timing_better(timing, &out[i - 1U], sample_point, phase))
+    {
+        out[i] = out[i - 1U];
+        i--;
+    }
+    out[i] = *timing;
+}
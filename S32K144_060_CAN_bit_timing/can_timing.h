@@ -0,0 +1,75 @@
+#ifndef CAN_TIMING_H
+#define CAN_TIMING_H
+
+#include "canCom1.h"
+
+/* FlexCAN bit timing solver. For a PE clock, a bitrate and a sample point it
+ * lists every flexcan_time_segment_t the registers of a phase can hold, best
+ * oscillator tolerance first. The fields are register values as the SDK
+ * takes them, one bit is
+ *   nominal: 1 + (propSeg + 1) + (phaseSeg1 + 1) + (phaseSeg2 + 1) tq
+ *   data:    1 + propSeg + (phaseSeg1 + 1) + (phaseSeg2 + 1) tq
+ * of (preDivider + 1) PE clocks, FDCBT[FPROPSEG] counts whole tq from 0.
+ *
+ * The oscillator tolerance is the clock difference two nodes may have
+ * (ISO 11898-1, Bosch "The Configuration of the CAN Bit Timing"):
+ *   df <= min(PS1, PS2) / (2 * (13 * NBT - PS2))
+ *   df <= SJW / (20 * NBT)
+ * and for CAN FD the three data phase conditions of F. Hartwich, "Bit Time
+ * Requirements for CAN FD", see can_timing_tolerance_fd() */
+
+typedef enum
+{
+    CAN_TIMING_NOMINAL = 0,     /* CTRL1, classic mode. Fits CBT as well */
+    CAN_TIMING_NOMINAL_CBT,     /* CBT, the extended nominal fields of FD mode */
+    CAN_TIMING_DATA,            /* FDCBT, FD data phase */
+    CAN_TIMING_PHASE_NUM
+} can_timing_phase_t;
+
+/* register field ranges of each phase, S32K1xx reference manual. phaseSeg2
+ * starts at 1, 2 tq are the information processing time. rJumpwidth is also
+ * kept to min(PS1, PS2) */
+typedef struct
+{
+    uint16_t presdiv_max;
+    uint8_t propseg_min;
+    uint8_t propseg_max;
+    uint8_t pseg1_max;
+    uint8_t pseg2_min;
+    uint8_t pseg2_max;
+    uint8_t rjw_max;
+    uint8_t tq_min;             /* whole bit */
+    uint8_t tq_max;
+} can_timing_limits_t;
+
+/* one segment set of can_timing_solve() */
+typedef struct
+{
+    flexcan_time_segment_t seg;
+    uint16_t tq;                /* time quanta of a bit */
+    uint16_t sample_point;      /* 0.1 %, at the end of PS1 */
+    uint32_t tolerance;         /* ppm, of this phase alone */
+} can_timing_t;
+
+/* sample point window of can_timing_solve(), 0.1 %. CiA 601-3 recommends
+ * 87.5 % for the nominal phase up to 500 kbit/s and 75 % to 80 % for the
+ * data phase */
+#define CAN_TIMING_SAMPLE_POINT_TOL 25U
+
+/* FDCBT[TDCOFF] is 5 bits, a longer offset cannot use the transmitter delay
+ * compensation */
+#define CAN_TIMING_TDC_OFFSET_MAX 31U
+
+extern const can_timing_limits_t can_timing_limits[CAN_TIMING_PHASE_NUM];
+
+uint32_t can_timing_solve(uint32_t pe_clock, uint32_t bitrate, uint16_t sample_point, uint32_t prop_delay_ns,
+                          can_timing_phase_t phase, can_timing_t *out, uint32_t max);
+bool can_timing_check(const flexcan_time_segment_t *seg, can_timing_phase_t phase);
+uint32_t can_timing_tq(const flexcan_time_segment_t *seg, can_timing_phase_t phase);
+uint32_t can_timing_bitrate(uint32_t pe_clock, const flexcan_time_segment_t *seg, can_timing_phase_t phase);
+uint32_t can_timing_sample_point(const flexcan_time_segment_t *seg, can_timing_phase_t phase);
+uint32_t can_timing_tolerance(const flexcan_time_segment_t *seg, can_timing_phase_t phase);
+uint32_t can_timing_tolerance_fd(const flexcan_time_segment_t *nominal, const flexcan_time_segment_t *data);
+uint32_t can_timing_tdc_offset(const flexcan_time_segment_t *data);
+
+#endif
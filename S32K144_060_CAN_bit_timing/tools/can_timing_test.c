@@ -0,0 +1,425 @@
+/* Host unit test of can_timing. The solver runs as it is for a grid of PE
+ * clocks, bitrates and sample points in all three register sets, and every
+ * result is checked against an independent brute force over the register
+ * fields with the limits of the S32K1xx reference manual:
+ *   CTRL1: PRESDIV 0-255, PROPSEG 0-7, PSEG1 0-7, PSEG2 1-7, RJW 0-3,
+ *          8 to 25 tq
+ *   CBT:   EPRESDIV 0-1023, EPROPSEG 0-63, EPSEG1 0-31, EPSEG2 1-31,
+ *          ERJW 0-31, 8 to 129 tq
+ *   FDCBT: FPRESDIV 0-1023, FPROPSEG 0-31 (tq, no +1), FPSEG1 0-7,
+ *          FPSEG2 1-7, FRJW 0-7, 5 to 48 tq
+ *   RJW <= PSEG1 and RJW <= PSEG2
+ * The number of results must match the brute force, each result must be in
+ * range, meet the bitrate exactly and the sample point window, carry the
+ * tolerance of the formulas in floating point and come in ranking order.
+ * canCom1_InitConfig0 and the FD data phase of can_lld are checked as well.
+ * Exit status 1 on a failed check.
+ *
+ * With -c the solutions of one bitrate are listed instead.
+ *
+ * build: gcc -O2 -Wall -I.. -I../../S32K144_057_CAN_socketcan/host
+ *            -o can_timing_test can_timing_test.c ../can_timing.c
+ * usage: can_timing_test
+ *        can_timing_test -c pe_clock -b bitrate [-s sample point 0.1%] [-p prop delay ns]
+ *                        [-d data bitrate] [-S data sample point 0.1%] [-n results]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "can_timing.h"
+
+#define TEST_OUT_MAX 100000U
+#define TEST_LIST_MAX 16U
+
+typedef struct
+{
+    uint32_t presdiv_max;
+    uint32_t propseg_max;
+    uint32_t pseg1_max;
+    uint32_t pseg2_max;
+    uint32_t rjw_max;
+    uint32_t tq_min;
+    uint32_t tq_max;
+    uint32_t prop_add;      /* tq of PROPSEG 0 */
+} test_rm_t;
+
+/* the reference manual ranges, written out again on purpose */
+static const test_rm_t test_rm[CAN_TIMING_PHASE_NUM] =
+{
+    {255U, 7U, 7U, 7U, 3U, 8U, 25U, 1U},
+    {1023U, 63U, 31U, 31U, 31U, 8U, 129U, 1U},
+    {1023U, 31U, 7U, 7U, 7U, 5U, 48U, 0U}
+};
+
+static const char *const test_phase_name[CAN_TIMING_PHASE_NUM] = {"CTRL1", "CBT", "FDCBT"};
+
+static can_timing_t test_out[TEST_OUT_MAX];
+static uint32_t test_error = 0U;
+static uint32_t test_check_num = 0U;
+
+#define TEST_CHECK(cond, ...) do { test_check_num++; if (!(cond)) { printf("FAIL: " __VA_ARGS__); printf("\n"); test_error++; } } while (0)
+
+static uint32_t test_min(uint32_t a, uint32_t b)
+{
+    return (a < b) ? a : b;
+}
+
+/* tolerance of one phase in floating point, ppm */
+static double test_tolerance(const flexcan_time_segment_t *seg, can_timing_phase_t phase)
+{
+    double tq = (double)(1U + test_rm[phase].prop_add + seg->propSeg + seg->phaseSeg1 + 1U + seg->phaseSeg2 + 1U);
+    double ps1 = seg->phaseSeg1 + 1U;
+    double ps2 = seg->phaseSeg2 + 1U;
+    double sjw = seg->rJumpwidth + 1U;
+    double df = sjw / (20.0 * tq);
+    double df1;
+
+    if (phase != CAN_TIMING_DATA)
+    {
+        df1 = ((ps1 < ps2) ? ps1 : ps2) / (2.0 * ((13.0 * tq) - ps2));
+        df = (df1 < df) ? df1 : df;
+    }
+    return df * 1e6;
+}
+
+static uint32_t test_sp_error(uint32_t sp, uint32_t target)
+{
+    return (sp > target) ? (sp - target) : (target - sp);
+}
+
+/* valid register sets by brute force over the fields, the prescaler follows
+ * from the tq */
+static uint32_t test_brute(uint32_t pe_clock, uint32_t bitrate, uint32_t sample_point, uint32_t prop_delay_ns,
+                           can_timing_phase_t phase)
+{
+    const test_rm_t *rm = &test_rm[phase];
+    uint32_t clocks = pe_clock / bitrate;
+    uint32_t num = 0U;
+    uint32_t prop;
+    uint32_t ps1;
+    uint32_t ps2;
+    uint32_t rjw;
+    uint32_t tq;
+    uint32_t presc;
+    uint32_t sp;
+
+    if ((pe_clock % bitrate) != 0U)
+    {
+        return 0U;
+    }
+    for (prop = 0U; prop <= rm->propseg_max; prop++)
+    {
+        for (ps1 = 0U; ps1 <= rm->pseg1_max; ps1++)
+        {
+            for (ps2 = 1U; ps2 <= rm->pseg2_max; ps2++)
+            {
+                tq = 1U + (prop + rm->prop_add) + (ps1 + 1U) + (ps2 + 1U);
+                if ((tq < rm->tq_min) || (tq > rm->tq_max) || ((clocks % tq) != 0U))
+                {
+                    continue;
+                }
+                presc = clocks / tq;
+                if ((presc < 1U) || (presc > (rm->presdiv_max + 1U)))
+                {
+                    continue;
+                }
+                sp = ((1000U * (tq - (ps2 + 1U))) + (tq / 2U)) / tq;
+                if (test_sp_error(sp, sample_point) > CAN_TIMING_SAMPLE_POINT_TOL)
+                {
+                    continue;
+                }
+                if ((phase != CAN_TIMING_DATA) &&
+                    (((uint64_t)(prop + rm->prop_add) * presc * 1000000000ULL) < ((uint64_t)prop_delay_ns * pe_clock)))
+                {
+                    continue;
+                }
+                for (rjw = 0U; rjw <= test_min(rm->rjw_max, test_min(ps1, ps2)); rjw++)
+                {
+                    num++;
+                }
+            }
+        }
+    }
+    return num;
+}
+
+/* one grid point: count, ranges, bitrate, sample point, tolerance, order */
+static void test_case(uint32_t pe_clock, uint32_t bitrate, uint32_t sample_point, uint32_t prop_delay_ns,
+                      can_timing_phase_t phase)
+{
+    const test_rm_t *rm = &test_rm[phase];
+    uint32_t num = can_timing_solve(pe_clock, bitrate, (uint16_t)sample_point, prop_delay_ns, phase,
+                                    test_out, TEST_OUT_MAX);
+    uint32_t brute = test_brute(pe_clock, bitrate, sample_point, prop_delay_ns, phase);
+    uint32_t i;
+    const flexcan_time_segment_t *seg;
+    uint32_t tq;
+    double df;
+
+    TEST_CHECK(num == brute, "%s %u Hz %u bit/s %u: %u results, brute force %u", test_phase_name[phase],
+               pe_clock, bitrate, sample_point, num, brute);
+    if (num > TEST_OUT_MAX)
+    {
+        num = TEST_OUT_MAX;
+    }
+    for (i = 0U; i < num; i++)
+    {
+        seg = &test_out[i].seg;
+        tq = 1U + rm->prop_add + seg->propSeg + (seg->phaseSeg1 + 1U) + (seg->phaseSeg2 + 1U);
+        TEST_CHECK((seg->preDivider <= rm->presdiv_max) && (seg->propSeg <= rm->propseg_max) &&
+                   (seg->phaseSeg1 <= rm->pseg1_max) && (seg->phaseSeg2 >= 1U) &&
+                   (seg->phaseSeg2 <= rm->pseg2_max) && (seg->rJumpwidth <= rm->rjw_max),
+                   "%s result %u out of the register ranges", test_phase_name[phase], i);
+        TEST_CHECK((seg->rJumpwidth <= seg->phaseSeg1) && (seg->rJumpwidth <= seg->phaseSeg2),
+                   "%s result %u: RJW above PSEG1 or PSEG2", test_phase_name[phase], i);
+        TEST_CHECK((tq >= rm->tq_min) && (tq <= rm->tq_max) && (tq == test_out[i].tq),
+                   "%s result %u: %u tq", test_phase_name[phase], i, tq);
+        TEST_CHECK(((seg->preDivider + 1U) * tq * bitrate) == pe_clock, "%s result %u: not %u bit/s",
+                   test_phase_name[phase], i, bitrate);
+        TEST_CHECK(test_sp_error(test_out[i].sample_point, sample_point) <= CAN_TIMING_SAMPLE_POINT_TOL,
+                   "%s result %u: sample point %u", test_phase_name[phase], i, test_out[i].sample_point);
+        TEST_CHECK(can_timing_check(seg, phase), "%s result %u: can_timing_check() refuses it",
+                   test_phase_name[phase], i);
+        TEST_CHECK(can_timing_bitrate(pe_clock, seg, phase) == bitrate, "%s result %u: can_timing_bitrate()",
+                   test_phase_name[phase], i);
+        df = test_tolerance(seg, phase);
+        TEST_CHECK((test_out[i].tolerance <= df) && ((double)test_out[i].tolerance > (df - 1.0)),
+                   "%s result %u: tolerance %u ppm, %.1f expected", test_phase_name[phase], i,
+                   test_out[i].tolerance, df);
+        if (i > 0U)
+        {
+            TEST_CHECK((test_out[i - 1U].tolerance > test_out[i].tolerance) ||
+                       ((test_out[i - 1U].tolerance == test_out[i].tolerance) &&
+                        (test_sp_error(test_out[i - 1U].sample_point, sample_point) <=
+                         test_sp_error(test_out[i].sample_point, sample_point))),
+                       "%s result %u out of order", test_phase_name[phase], i);
+        }
+        if ((phase != CAN_TIMING_DATA) && (prop_delay_ns != 0U))
+        {
+            TEST_CHECK(((uint64_t)(seg->propSeg + 1U) * (seg->preDivider + 1U) * 1000000000ULL) >=
+                       ((uint64_t)prop_delay_ns * pe_clock), "%s result %u: propagation segment too short",
+                       test_phase_name[phase], i);
+        }
+    }
+}
+
+/* the solver over the grid */
+static void test_grid(void)
+{
+    static const uint32_t clocks[] = {8000000U, 16000000U, 20000000U, 40000000U, 48000000U, 80000000U};
+    static const uint32_t bitrates[] = {10000U, 20000U, 50000U, 83333U, 100000U, 125000U, 250000U,
+                                        500000U, 800000U, 1000000U, 2000000U, 4000000U, 5000000U, 8000000U};
+    static const uint32_t sample_points[] = {750U, 800U, 875U};
+    static const uint32_t delays[] = {0U, 250U};
+    uint32_t c;
+    uint32_t b;
+    uint32_t s;
+    uint32_t d;
+    uint32_t p;
+    uint32_t before = test_error;
+
+    for (p = 0U; p < CAN_TIMING_PHASE_NUM; p++)
+    {
+        for (c = 0U; c < (sizeof(clocks) / sizeof(clocks[0])); c++)
+        {
+            for (b = 0U; b < (sizeof(bitrates) / sizeof(bitrates[0])); b++)
+            {
+                for (s = 0U; s < (sizeof(sample_points) / sizeof(sample_points[0])); s++)
+                {
+                    for (d = 0U; d < (sizeof(delays) / sizeof(delays[0])); d++)
+                    {
+                        test_case(clocks[c], bitrates[b], sample_points[s], delays[d], (can_timing_phase_t)p);
+                    }
+                }
+            }
+        }
+    }
+    printf("grid: %s\n", (test_error == before) ? "ok" : "failed");
+}
+
+/* can_timing_check() on hand made register sets */
+static void test_check(void)
+{
+    flexcan_time_segment_t seg = {7U, 4U, 1U, 0U, 1U};
+
+    TEST_CHECK(can_timing_check(&seg, CAN_TIMING_NOMINAL), "canCom1 timing refused");
+    seg.phaseSeg2 = 0U;
+    seg.rJumpwidth = 0U;
+    TEST_CHECK(!can_timing_check(&seg, CAN_TIMING_NOMINAL), "PSEG2 0 taken");
+    seg.phaseSeg2 = 1U;
+    seg.rJumpwidth = 2U;
+    TEST_CHECK(!can_timing_check(&seg, CAN_TIMING_NOMINAL), "RJW above PSEG2 taken");
+    seg.rJumpwidth = 1U;
+    seg.propSeg = 8U;
+    TEST_CHECK(!can_timing_check(&seg, CAN_TIMING_NOMINAL), "PROPSEG 8 taken by CTRL1");
+    TEST_CHECK(can_timing_check(&seg, CAN_TIMING_NOMINAL_CBT), "EPROPSEG 8 refused by CBT");
+    seg.propSeg = 0U;
+    seg.phaseSeg1 = 0U;
+    seg.rJumpwidth = 0U;
+    /* 1 + 1 + 1 + 2 = 5 tq nominal */
+    TEST_CHECK(!can_timing_check(&seg, CAN_TIMING_NOMINAL), "5 tq nominal bit taken");
+    /* 1 + 0 + 1 + 2 = 4 tq data */
+    TEST_CHECK(!can_timing_check(&seg, CAN_TIMING_DATA), "4 tq data bit taken");
+    seg.phaseSeg1 = 1U;
+    TEST_CHECK(can_timing_check(&seg, CAN_TIMING_DATA), "5 tq data bit refused");
+    seg.preDivider = 256U;
+    TEST_CHECK(!can_timing_check(&seg, CAN_TIMING_NOMINAL), "PRESDIV 256 taken by CTRL1");
+    TEST_CHECK(can_timing_check(&seg, CAN_TIMING_DATA), "FPRESDIV 256 refused");
+}
+
+/* the timings of the board: canCom1_InitConfig0 is the best 500 kbit/s set
+ * of the 8 MHz SOSCDIV2, the FD data phase of can_lld is a valid 1 Mbit/s
+ * one and the hand computed FD tolerance of the pair */
+static void test_board(void)
+{
+    const flexcan_time_segment_t nominal = {7U, 4U, 1U, 0U, 1U};
+    const flexcan_time_segment_t data = {2U, 2U, 1U, 0U, 1U};
+    uint32_t num;
+    uint32_t i;
+    bool found = false;
+
+    num = can_timing_solve(8000000U, 500000U, 875U, 0U, CAN_TIMING_NOMINAL, test_out, TEST_OUT_MAX);
+    TEST_CHECK((num > 0U) && (memcmp(&test_out[0].seg, &nominal, sizeof(nominal)) == 0),
+               "canCom1_InitConfig0 timing is not the best 500 kbit/s set");
+    TEST_CHECK((test_out[0].tq == 16U) && (test_out[0].sample_point == 875U) && (test_out[0].tolerance == 4854U),
+               "500 kbit/s: %u tq, %u, %u ppm", test_out[0].tq, test_out[0].sample_point, test_out[0].tolerance);
+
+    num = can_timing_solve(8000000U, 1000000U, 750U, 0U, CAN_TIMING_DATA, test_out, TEST_OUT_MAX);
+    for (i = 0U; i < num; i++)
+    {
+        found |= (memcmp(&test_out[i].seg, &data, sizeof(data)) == 0);
+    }
+    TEST_CHECK(found, "FD data phase of can_lld is not a 1 Mbit/s set");
+    TEST_CHECK(can_timing_tdc_offset(&data) == 6U, "TDC offset %u", can_timing_tdc_offset(&data));
+    TEST_CHECK(can_timing_sample_point(&data, CAN_TIMING_DATA) == 750U, "data sample point %u",
+               can_timing_sample_point(&data, CAN_TIMING_DATA));
+    /* 1: 2/320 2: 2/412 3: 2/160 4: 2/314 5: 2/128 */
+    TEST_CHECK(can_timing_tolerance_fd(&nominal, &data) == 4854U, "FD tolerance %u ppm",
+               can_timing_tolerance_fd(&nominal, &data));
+    TEST_CHECK(can_timing_tolerance_fd(&nominal, &test_out[0].seg) >= can_timing_tolerance_fd(&nominal, &data),
+               "best data phase below the one of can_lld");
+
+    /* not a whole number of PE clocks per bit */
+    TEST_CHECK(can_timing_solve(8000000U, 300000U, 875U, 0U, CAN_TIMING_NOMINAL, NULL, 0U) == 0U,
+               "300 kbit/s from 8 MHz");
+    /* 2 Mbit/s needs at least 5 tq of one 8 MHz clock */
+    TEST_CHECK(can_timing_solve(8000000U, 2000000U, 750U, 0U, CAN_TIMING_DATA, NULL, 0U) == 0U,
+               "2 Mbit/s from 8 MHz");
+    TEST_CHECK(can_timing_solve(80000000U, 2000000U, 750U, 0U, CAN_TIMING_DATA, NULL, 0U) > 0U,
+               "no 2 Mbit/s from 80 MHz");
+}
+
+/* condition 5 of can_timing_tolerance_fd(): a nominal prescaler far above
+ * the data one eats the data SJW */
+static void test_fd(void)
+{
+    const flexcan_time_segment_t nominal = {31U, 15U, 15U, 9U, 15U};
+    flexcan_time_segment_t data = {0U, 2U, 1U, 0U, 0U};
+
+    TEST_CHECK(can_timing_tolerance_fd(&nominal, &data) == 0U, "condition 5 with BRP_N 10, BRP_D 1, SJW_D 1");
+    data.preDivider = 9U;
+    data.rJumpwidth = 1U;
+    TEST_CHECK(can_timing_tolerance_fd(&nominal, &data) > 0U, "same prescalers");
+    TEST_CHECK(can_timing_tolerance_fd(&nominal, &data) <= can_timing_tolerance(&data, CAN_TIMING_DATA),
+               "FD tolerance above condition 3");
+}
+
+static void test_list(uint32_t pe_clock, uint32_t bitrate, uint32_t sample_point, uint32_t prop_delay_ns,
+                      uint32_t data_bitrate, uint32_t data_sample_point, uint32_t list)
+{
+    static can_timing_t data_out[TEST_LIST_MAX];
+    can_timing_phase_t phase = (data_bitrate != 0U) ? CAN_TIMING_NOMINAL_CBT : CAN_TIMING_NOMINAL;
+    uint32_t num;
+    uint32_t data_num = 0U;
+    uint32_t i;
+    uint32_t j;
+    const flexcan_time_segment_t *seg;
+
+    if (list > TEST_LIST_MAX)
+    {
+        list = TEST_LIST_MAX;
+    }
+    num = can_timing_solve(pe_clock, bitrate, (uint16_t)sample_point, prop_delay_ns, phase, test_out, TEST_OUT_MAX);
+    printf("%s %u bit/s from %u Hz, sample point %u.%u%%: %u sets\n", test_phase_name[phase], bitrate, pe_clock,
+           sample_point / 10U, sample_point % 10U, num);
+    if (data_bitrate != 0U)
+    {
+        data_num = can_timing_solve(pe_clock, data_bitrate, (uint16_t)data_sample_point, 0U, CAN_TIMING_DATA,
+                                    data_out, TEST_LIST_MAX);
+        printf("FDCBT %u bit/s, sample point %u.%u%%: %u sets\n", data_bitrate, data_sample_point / 10U,
+               data_sample_point % 10U, data_num);
+    }
+    printf(" presdiv propseg pseg1 pseg2 rjw  tq     sp     df\n");
+    for (i = 0U; (i < num) && (i < list); i++)
+    {
+        seg = &test_out[i].seg;
+        printf(" %7u %7u %5u %5u %3u %3u %5u.%u%% %5u.%04u%%\n", seg->preDivider, seg->propSeg, seg->phaseSeg1,
+               seg->phaseSeg2, seg->rJumpwidth, test_out[i].tq, test_out[i].sample_point / 10U,
+               test_out[i].sample_point % 10U, test_out[i].tolerance / 10000U, test_out[i].tolerance % 10000U);
+        for (j = 0U; (j < data_num) && (j < list) && (i == 0U); j++)
+        {
+            seg = &data_out[j].seg;
+            printf("   data %7u %7u %5u %5u %3u %3u %5u.%u%% FD df %u ppm, TDC offset %u\n", seg->preDivider,
+                   seg->propSeg, seg->phaseSeg1, seg->phaseSeg2, seg->rJumpwidth, data_out[j].tq,
+                   data_out[j].sample_point / 10U, data_out[j].sample_point % 10U,
+                   can_timing_tolerance_fd(&test_out[0].seg, seg), can_timing_tdc_offset(seg));
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t pe_clock = 0U;
+    uint32_t bitrate = 500000U;
+    uint32_t sample_point = 875U;
+    uint32_t prop_delay_ns = 0U;
+    uint32_t data_bitrate = 0U;
+    uint32_t data_sample_point = 750U;
+    uint32_t list = 8U;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "c:b:s:p:d:S:n:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'c':
+            pe_clock = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'b':
+            bitrate = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            sample_point = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'p':
+            prop_delay_ns = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'd':
+            data_bitrate = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'S':
+            data_sample_point = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'n':
+            list = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-c pe_clock -b bitrate [-s sp] [-p ns] [-d data bitrate] [-S sp] [-n num]]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if (pe_clock != 0U)
+    {
+        test_list(pe_clock, bitrate, sample_point, prop_delay_ns, data_bitrate, data_sample_point, list);
+        return 0;
+    }
+
+    test_check();
+    test_board();
+    test_fd();
+    test_grid();
+    printf("%s, %u checks, %u errors\n", (test_error == 0U) ? "PASS" : "FAIL", test_check_num, test_error);
+    return (test_error == 0U) ? 0 : 1;
+}
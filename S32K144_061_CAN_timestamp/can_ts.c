@@ -0,0 +1,76 @@
+#include "can_ts.h"
+
+/* the time base, only touched by can_ts_now() */
+static can_ts_ext_t can_ts_base;
+
+/* @brief: Start the time base at 0, LPIT channel 2 must run. Called from
+ *         lpit_lld_init()
+ * @return: None
+ */
+void can_ts_init(void)
+{
+    can_ts_ext_init(&can_ts_base, can_ts_hw_period(), can_ts_hw_count());
+}
+
+/* @brief: Time since can_ts_init(). Called from the CAN interrupts or with
+ *         them masked, the sum is not atomic
+ * @return: us
+ */
+uint64_t can_ts_now(void)
+{
+    return can_ts_extend(&can_ts_base, can_ts_hw_count()) / CAN_TS_COUNTS_PER_US;
+}
+
+/* @brief: Date a frame with its FlexCAN time stamp
+ * @param now     : can_ts_now(), us
+ * @param timer   : FlexCAN TIMER read together with now
+ * @param stamp   : time stamp of the CS word of the frame
+ * @param bitrate : nominal bit/s, the FlexCAN timer counts these bits
+ * @return        : us of the time stamp, the frame must be less than one
+ *                  timer round old
+ */
+uint64_t can_ts_date(uint64_t now, uint16_t timer, uint16_t stamp, uint32_t bitrate)
+{
+    uint16_t age = (uint16_t)(timer - stamp);
+    uint64_t age_us = ((uint64_t)age * 1000000U) / bitrate;
+
+    return (age_us > now) ? 0U : (now - age_us);
+}
+
+/* @brief: Start a counter extension
+ * @param ext    : extension
+ * @param period : counts of one round of the counter, 0 for 2^32
+ * @param count  : counter now, the sum starts at 0 here
+ * @return       : None
+ */
+void can_ts_ext_init(can_ts_ext_t *ext, uint32_t period, uint32_t count)
+{
+    ext->sum = 0U;
+    ext->last = count;
+    ext->period = period;
+}
+
+/* @brief: Extend a counter reading to 64 bits. The counter must not go more
+ *         than one round between two calls
+ * @param ext   : extension
+ * @param count : counter now, below the period
+ * @return      : counts since can_ts_ext_init()
+ */
+uint64_t can_ts_extend(can_ts_ext_t *ext, uint32_t count)
+{
+    uint32_t delta;
+
+    if (count >= ext->last)
+    {
+        delta = count - ext->last;
+    }
+    else
+    {
+        /* wrapped, with a period of 2^32 the unsigned difference already is
+         * the step */
+        delta = (count - ext->last) + ext->period;
+    }
+    ext->sum += delta;
+    ext->last = count;
+    return ext->sum;
+}
@@ -0,0 +1,47 @@
+#ifndef CAN_TS_H
+#define CAN_TS_H
+
+#include "Cpu.h"
+
+/* Time stamps of CAN frames in us on one 64 bit time base.
+ *
+ * LPIT channel 2 counts down with the LPIT clock (SIRCDIV2, 8 MHz) from its
+ * largest period and reloads, without an interrupt. can_ts_now() adds the
+ * counts since its last call to a 64 bit sum, this needs a call at least
+ * once per LPIT period, 536 s. can_lld_step() makes one every 100 ms.
+ *
+ * FlexCAN copies its 16 bit timer into the CS word of every frame it sends
+ * or receives, one count per nominal bit. can_ts_date() takes the timer and
+ * can_ts_now() read together and dates the frame back by the timer counts
+ * since its stamp. Right while the frame is less than one timer round old,
+ * 131 ms at 500 kbit/s, to one bit, 2 us */
+
+/* clock of LPIT channel 2 */
+#define CAN_TS_CLOCK_HZ 8000000U
+#define CAN_TS_COUNTS_PER_US (CAN_TS_CLOCK_HZ / 1000000U)
+#define CAN_TS_LPIT_CHANNEL 2U
+
+#if (CAN_TS_CLOCK_HZ % 1000000U) != 0U
+#error "CAN_TS_CLOCK_HZ must be a whole number of MHz"
+#endif
+
+/* extension of a counter that wraps after period counts to 64 bits */
+typedef struct
+{
+    uint64_t sum;       /* counts since can_ts_ext_init() */
+    uint32_t last;      /* counter at the last can_ts_extend() */
+    uint32_t period;    /* counts of one round, 0 for 2^32 */
+} can_ts_ext_t;
+
+/* the hardware of the time base, lpit_lld.c: counts since the last reload
+ * of LPIT channel 2 and counts of one LPIT period, 0 for 2^32 */
+uint32_t can_ts_hw_count(void);
+uint32_t can_ts_hw_period(void);
+
+void can_ts_init(void);
+uint64_t can_ts_now(void);
+uint64_t can_ts_date(uint64_t now, uint16_t timer, uint16_t stamp, uint32_t bitrate);
+void can_ts_ext_init(can_ts_ext_t *ext, uint32_t period, uint32_t count);
+uint64_t can_ts_extend(can_ts_ext_t *ext, uint32_t count);
+
+#endif
@@ -0,0 +1,40 @@
+/* Time base of can_ts on the host: LPIT channel 2 counts CAN_TS_CLOCK_HZ
+ * on CLOCK_MONOTONIC, the same clock the FlexCAN timer of
+ * flexcan_socketcan.c runs on. Built into the benchmark of
+ * S32K144_057_CAN_socketcan/host with the lessons up to this one, oldest
+ * first, the Makefile there takes the newest copy of every file:
+ *
+ *   make LESSONS="../../S32K144_050_CAN_filter_compiler ../../S32K144_051_ISO_TP \
+ *                 ../../S32K144_055_CAN_bus_off ../../S32K144_056_CAN_trace \
+ *                 ../../S32K144_058_CAN_DBC_codegen ../../S32K144_059_CAN_scheduler \
+ *                 ../../S32K144_060_CAN_bit_timing ../../S32K144_061_CAN_timestamp \
+ *                 ../../S32K144_061_CAN_timestamp/host" \
+ *        HOST_SRC="freertos_host.c sdk_host.c flexcan_socketcan.c can_ts_host.c" \
+ *        LLD_SRC="can_lld.c can_stats.c can_trace.c can_err.c isotp.c can_db.c can_sched.c can_timing.c can_ts.c"
+ *
+ * The targets can_bench on vcan0 and vbus can_bench_vbus on the emulated bus
+ * take the same variables.
+ */
+#include <time.h>
+#include "can_ts.h"
+
+/* @brief: Counts of the LPIT clock, up with the time like the counts since
+ *         the reload of LPIT channel 2
+ * @return: counts, wraps after 2^32
+ */
+uint32_t can_ts_hw_count(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)(((uint64_t)now.tv_sec * CAN_TS_CLOCK_HZ) +
+                      (((uint64_t)now.tv_nsec * CAN_TS_COUNTS_PER_US) / 1000U));
+}
+
+/* @brief: One round of the host counter
+ * @return: 0, 2^32 counts
+ */
+uint32_t can_ts_hw_period(void)
+{
+    return 0U;
+}
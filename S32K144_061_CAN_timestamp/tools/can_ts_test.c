@@ -0,0 +1,223 @@
+/* Host test of can_ts. The time base runs on a simulated LPIT channel 2 and
+ * frames are stamped by a simulated 16 bit FlexCAN timer, both driven by one
+ * true time in ns.
+ *
+ * - can_ts_extend(): random steps up to one round on counters with a period
+ *   of 2^32, TVAL + 1 = 2^32 - 1 and a few short ones, the sum must follow
+ *   the true count exactly, also right at the wrap and for steps of a whole
+ *   period minus one
+ * - can_ts_now(): the LPIT model read through can_ts_hw_count(), more than
+ *   one LPIT round (536 s) in steps of up to 400 s, us must be the true time
+ * - can_ts_date(): frames read back up to one FlexCAN timer round after
+ *   their stamp at 50 k to 1 Mbit/s, around the 16 bit wrap of the timer,
+ *   the date must be within one bit time plus 1 us of the truth
+ * Exit status 1 on a failed check.
+ *
+ * build: gcc -O2 -Wall -I.. -I../../S32K144_057_CAN_socketcan/host -o can_ts_test can_ts_test.c ../can_ts.c
+ * usage: can_ts_test [-s seed] [-n steps]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "can_ts.h"
+
+static uint32_t test_error = 0U;
+static uint32_t test_check_num = 0U;
+
+#define TEST_CHECK(cond, ...) do { test_check_num++; if (!(cond)) { printf("FAIL: " __VA_ARGS__); printf("\n"); test_error++; } } while (0)
+
+/* simulated LPIT channel 2: true counts since reset and TVAL */
+static uint64_t test_lpit_count = 0U;
+static uint64_t test_lpit_period = 1ULL << 32;
+
+uint32_t can_ts_hw_count(void)
+{
+    return (uint32_t)(test_lpit_count % test_lpit_period);
+}
+
+uint32_t can_ts_hw_period(void)
+{
+    return (uint32_t)test_lpit_period;
+}
+
+static uint64_t test_rand64(void)
+{
+    return ((uint64_t)(uint32_t)rand() << 33) ^ ((uint64_t)(uint32_t)rand() << 16) ^ (uint32_t)rand();
+}
+
+/* random steps of at most one round, the sum must stay the true count */
+static void test_extend(uint64_t period, uint32_t steps)
+{
+    can_ts_ext_t ext;
+    uint64_t count = test_rand64() % period;
+    uint64_t start = count;
+    uint64_t sum = 0U;
+    uint64_t step;
+    uint32_t i;
+    uint32_t before = test_error;
+
+    can_ts_ext_init(&ext, (uint32_t)period, (uint32_t)count);
+    for (i = 0U; i < steps; i++)
+    {
+        switch (i % 4U)
+        {
+        case 0U:
+            /* up to one round minus one */
+            step = test_rand64() % period;
+            break;
+        case 1U:
+            /* onto the last count before the wrap, then across it */
+            step = (period - 1U) - (count % period);
+            break;
+        case 2U:
+            step = 1U;
+            break;
+        default:
+            step = test_rand64() % ((period < 1000U) ? period : 1000U);
+            break;
+        }
+        count += step;
+        sum = can_ts_extend(&ext, (uint32_t)(count % period));
+        if (sum != (count - start))
+        {
+            break;
+        }
+    }
+    TEST_CHECK(sum == (count - start), "period %llu: sum %llu after %u steps, %llu expected",
+               (unsigned long long)period, (unsigned long long)sum, i, (unsigned long long)(count - start));
+    /* a whole period between two reads is lost, the limit of the scheme */
+    count += period;
+    TEST_CHECK(can_ts_extend(&ext, (uint32_t)(count % period)) == sum, "period %llu: a full round seen",
+               (unsigned long long)period);
+    if (test_error == before)
+    {
+        printf("extend, period %llu: ok\n", (unsigned long long)period);
+    }
+}
+
+/* the time base through the LPIT model over more than one LPIT round */
+static void test_now(void)
+{
+    uint64_t t0;
+    uint64_t us;
+    uint32_t i;
+    uint32_t before = test_error;
+
+    test_lpit_period = 0xFFFFFFFFULL;
+    test_lpit_count = 0xFFFFF000ULL;
+    can_ts_init();
+    t0 = test_lpit_count;
+    for (i = 0U; i < 100U; i++)
+    {
+        /* up to 400 s, below one round */
+        test_lpit_count += test_rand64() % (400ULL * CAN_TS_CLOCK_HZ);
+        us = can_ts_now();
+        TEST_CHECK(us == ((test_lpit_count - t0) / CAN_TS_COUNTS_PER_US), "now %llu us, %llu expected",
+                   (unsigned long long)us, (unsigned long long)((test_lpit_count - t0) / CAN_TS_COUNTS_PER_US));
+    }
+    TEST_CHECK(us > (536ULL * 1000000U), "time base did not pass one LPIT round");
+    if (test_error == before)
+    {
+        printf("now over %llu s: ok\n", (unsigned long long)(us / 1000000U));
+    }
+}
+
+/* FlexCAN timer of the true time, one count per bit */
+static uint16_t test_timer(uint64_t ns, uint32_t bitrate)
+{
+    return (uint16_t)((ns * bitrate) / 1000000000ULL);
+}
+
+/* frames read back from 0 to one timer round after their stamp */
+static void test_date(uint32_t bitrate, uint32_t frames)
+{
+    uint64_t round_ns = (65536ULL * 1000000000ULL) / bitrate;
+    uint64_t bit_ns = 1000000000ULL / bitrate;
+    uint64_t frame_ns;
+    uint64_t read_ns;
+    uint64_t dated;
+    int64_t err;
+    int64_t err_max = 0;
+    uint32_t wraps = 0U;
+    uint32_t i;
+    uint32_t before = test_error;
+
+    for (i = 0U; i < frames; i++)
+    {
+        /* every fourth frame right before a timer wrap */
+        frame_ns = 1000000000ULL + (test_rand64() % (3600ULL * 1000000000ULL));
+        if ((i % 4U) == 0U)
+        {
+            frame_ns = ((frame_ns / round_ns) + 1U) * round_ns - (test_rand64() % (64U * bit_ns));
+        }
+        /* less than one round minus one bit later */
+        read_ns = frame_ns + (test_rand64() % (round_ns - (2U * bit_ns)));
+        if (test_timer(read_ns, bitrate) < test_timer(frame_ns, bitrate))
+        {
+            wraps++;
+        }
+        dated = can_ts_date(read_ns / 1000U, test_timer(read_ns, bitrate), test_timer(frame_ns, bitrate), bitrate);
+        err = (int64_t)dated - (int64_t)(frame_ns / 1000U);
+        if (llabs(err) > llabs(err_max))
+        {
+            err_max = err;
+        }
+    }
+    TEST_CHECK(llabs(err_max) <= (int64_t)((bit_ns / 1000U) + 1U), "%u bit/s: date off by %lld us", bitrate,
+               (long long)err_max);
+    TEST_CHECK(wraps > (frames / 8U), "%u bit/s: only %u timer wraps", bitrate, wraps);
+    if (test_error == before)
+    {
+        printf("date at %u bit/s: ok, %u frames, %u across the timer wrap, worst %lld us\n", bitrate, frames, wraps,
+               (long long)err_max);
+    }
+}
+
+/* a frame stamped at the last count before the wrap and read after it */
+static void test_date_wrap(void)
+{
+    TEST_CHECK(can_ts_date(1000000U, 0x0002U, 0xFFFEU, 500000U) == (1000000U - 8U), "4 bits across the wrap");
+    TEST_CHECK(can_ts_date(1000000U, 0x1234U, 0x1234U, 500000U) == 1000000U, "same count");
+    TEST_CHECK(can_ts_date(1000000U, 0x1233U, 0x1234U, 500000U) == (1000000U - 131070U), "65535 bits old");
+    TEST_CHECK(can_ts_date(100U, 0x0100U, 0x0000U, 500000U) == 0U, "older than the time base");
+}
+
+int main(int argc, char **argv)
+{
+    static const uint32_t bitrates[] = {50000U, 125000U, 250000U, 500000U, 1000000U};
+    static const uint64_t periods[] = {1ULL << 32, 0xFFFFFFFFULL, 80000000ULL, 1000U, 7U};
+    uint32_t seed = 1U;
+    uint32_t steps = 1000000U;
+    uint32_t i;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:n:")) != -1)
+    {
+        switch (opt)
+        {
+        case 's':
+            seed = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'n':
+            steps = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-s seed] [-n steps]\n", argv[0]);
+            return 2;
+        }
+    }
+    srand(seed);
+
+    for (i = 0U; i < (sizeof(periods) / sizeof(periods[0])); i++)
+    {
+        test_extend(periods[i], steps);
+    }
+    test_now();
+    test_date_wrap();
+    for (i = 0U; i < (sizeof(bitrates) / sizeof(bitrates[0])); i++)
+    {
+        test_date(bitrates[i], steps / 10U);
+    }
+    printf("%s, %u checks, %u errors\n", (test_error == 0U) ? "PASS" : "FAIL", test_check_num, test_error);
+    return (test_error == 0U) ? 0 : 1;
+}
@@ -0,0 +1,535 @@
+#include "can_log.h"
+#include "string.h"
+
+/* the log text of the lessons without its numbers, printf formats of
+ * rtos.c and adc_lld.c, CAN_LOG_DICT_SIZE at most */
+static const char can_log_dict[] =
+    "adc value is: V\n"
+    " test for ADC:\n"
+    " test for RTC:\n"
+    " test for 1ms task:\n"
+    "1ms counter is ,  times of 1000ms counter.\n"
+    " test for FreeRTOS tick hook.\n"
+    "tick number is \n"
+    " do some test for FreeRTOS.\n"
+    "priority of 1ms task: \n"
+    "priority of 1000ms task: \n"
+    "free heap memory:  bytes.\n"
+    " do some test for lpTmr.\n"
+    "1000ms time cost is about: us\n"
+    "-----new test loop started-----\n"
+    " test for CAN RX queue.\n"
+    "CAN frames: , pending: , peak: \n"
+    "CAN RX queue overflow: , RX FIFO overflow: \n"
+    " test for CAN TX priority queue.\n"
+    "CAN TX frames: , complete: \n"
+    "CAN TX queue full: , cancel: , error: \n"
+    " test for CAN ISO-TP.\n"
+    "ISO-TP RX messages: , errors: \n"
+    "ISO-TP TX messages: \n"
+    " test for CAN FD.\n"
+    "CAN mode: classic, FD frames TX: , RX: \n"
+    " test for CAN RX DMA.\n"
+    "RX FIFO DMA: on, half rings: , DMA errors: , RX frames: \n"
+    " test for CAN statistics.\n"
+    "bus load: %, peak: %, IDs: , frames: \n"
+    " test for CAN bus off recovery.\n"
+    "CAN error state: error active, TEC: , REC: , bus off: \n"
+    "recoveries: , last: us, max: us, stale TX frames dropped: \n"
+    " test for CAN trace.\n"
+    "CAN trace state: , records: , overwritten: , triggers: \n"
+    " test for CAN scheduler.\n"
+    "CAN scheduler ticks: , overruns: , bits per tick planned: , sent: \n"
+    "bus load of ms: \n"
+    "ECU_Status offset: ms, frames: , errors: , period: -us, late: \n"
+    " test for CAN bit timing.\n"
+    "CAN bitrate: , FD data phase: , last autobaud: \n"
+    "best timing:  tq, sample point , oscillator tolerance ppm\n"
+    " test for CAN time stamps.\n"
+    "time base: ms, TX frames: \n"
+    "can_lld_tx() to bus: \n"
+    "can_lld_tx() to TX complete: us, mean us\n"
+    "running time: s\n"
+    "\n";
+
+#define CAN_LOG_DICT_LEN (sizeof(can_log_dict) - 1U)
+#define CAN_LOG_WINDOW_SIZE (CAN_LOG_DICT_SIZE + CAN_LOG_HISTORY_SIZE + CAN_LOG_BATCH_SIZE)
+#define CAN_LOG_HASH_BITS 10U
+#define CAN_LOG_HASH_SIZE (1U << CAN_LOG_HASH_BITS)
+#define CAN_LOG_NIL 0xFFFFU
+/* D of a run of chars as they are */
+#define CAN_LOG_DIST_RAW 4095U
+#define CAN_LOG_RAW_MAX 8U
+#define CAN_LOG_LEN_EXT 7U
+
+uint32_t can_log_line_num = 0U;
+uint32_t can_log_batch_num = 0U;
+uint32_t can_log_text_bytes = 0U;
+uint32_t can_log_packed_bytes = 0U;
+uint32_t can_log_frame_num = 0U;
+uint32_t can_log_drop_num = 0U;
+
+uint32_t can_log_rx_batch_num = 0U;
+uint32_t can_log_rx_lost_frame_num = 0U;
+uint32_t can_log_rx_lost_batch_num = 0U;
+uint32_t can_log_rx_error_num = 0U;
+
+/* sender, only the printf writer task gets here */
+static can_log_ctx_t can_log_tx_ctx;
+static bool can_log_tx_ready = false;
+static bool can_log_key = true;
+static uint8_t can_log_batch[CAN_LOG_BATCH_SIZE];
+static uint32_t can_log_batch_len = 0U;
+static uint8_t can_log_seq = 0U;
+static uint8_t can_log_packed[1U + CAN_LOG_PACKED_MAX(CAN_LOG_BATCH_SIZE)];
+
+/* hash chains of can_log_compress(), 3 chars at every window position */
+static uint16_t can_log_head[CAN_LOG_HASH_SIZE];
+static uint16_t can_log_prev[CAN_LOG_WINDOW_SIZE];
+
+/* receiver, the board links it only if it is called (-fdata-sections,
+ * --gc-sections) */
+static can_log_ctx_t can_log_rx_ctx;
+static bool can_log_rx_synced = false;
+static bool can_log_rx_in_batch = false;
+static bool can_log_rx_history = false;
+static uint8_t can_log_rx_seq;
+static uint32_t can_log_rx_len;
+static uint8_t can_log_rx_packed[1U + CAN_LOG_PACKED_MAX(CAN_LOG_BATCH_SIZE)];
+static uint8_t can_log_rx_text[CAN_LOG_BATCH_SIZE];
+
+static uint32_t can_log_hash(const uint8_t *p);
+static void can_log_insert(const uint8_t *w, uint32_t pos, uint32_t end);
+static void can_log_history(can_log_ctx_t *ctx, uint32_t len);
+
+/* @brief: Add log text to the batch, a line which does not fit any more
+ *         sends the batch first. Called from the printf writer task only
+ * @param text : chars
+ * @param len  : number of chars, a line longer than a batch is split
+ * @return     : None
+ */
+void can_log_write(const char *text, uint32_t len)
+{
+    uint32_t n;
+
+    can_log_line_num++;
+    if ((can_log_batch_len + len) > CAN_LOG_BATCH_SIZE)
+    {
+        can_log_flush();
+    }
+    while (len > 0U)
+    {
+        n = CAN_LOG_BATCH_SIZE - can_log_batch_len;
+        if (n > len)
+        {
+            n = len;
+        }
+        memcpy(&can_log_batch[can_log_batch_len], text, n);
+        can_log_batch_len += n;
+        text += n;
+        len -= n;
+        if (can_log_batch_len == CAN_LOG_BATCH_SIZE)
+        {
+            can_log_flush();
+        }
+    }
+}
+
+/* @brief: Compress the batch and send it. A frame can_log_send() refuses
+ *         ends the batch, its sequence number is used all the same so the
+ *         receiver sees the gap, and the next batch is a key batch
+ * @return: None
+ */
+void can_log_flush(void)
+{
+    uint8_t frame[CAN_LOG_FRAME_SIZE];
+    uint32_t packed;
+    uint32_t pos;
+    uint32_t n;
+
+    if (can_log_batch_len == 0U)
+    {
+        return;
+    }
+    if (!can_log_tx_ready)
+    {
+        can_log_ctx_init(&can_log_tx_ctx, true);
+        can_log_tx_ready = true;
+    }
+
+    if ((can_log_batch_num % CAN_LOG_KEY_INTERVAL) == 0U)
+    {
+        can_log_key = true;
+    }
+    can_log_packed[0] = can_log_key ? CAN_LOG_BATCH_KEY : 0U;
+    packed = 1U + can_log_compress(&can_log_tx_ctx, can_log_batch, can_log_batch_len, &can_log_packed[1], can_log_key);
+    can_log_key = false;
+    can_log_batch_num++;
+    can_log_text_bytes += can_log_batch_len;
+    can_log_packed_bytes += packed;
+    can_log_batch_len = 0U;
+
+    for (pos = 0U; pos < packed; pos += n)
+    {
+        n = packed - pos;
+        if (n > (CAN_LOG_FRAME_SIZE - 1U))
+        {
+            n = CAN_LOG_FRAME_SIZE - 1U;
+        }
+        frame[0] = (uint8_t)((can_log_seq & CAN_LOG_SEQ_MASK) | ((pos == 0U) ? CAN_LOG_FIRST : 0U) |
+                             (((pos + n) == packed) ? CAN_LOG_LAST : 0U));
+        can_log_seq++;
+        memcpy(&frame[1], &can_log_packed[pos], n);
+        if (!can_log_send(frame, n + 1U))
+        {
+            /* the receiver lost this batch, its history is not ours */
+            can_log_drop_num++;
+            can_log_key = true;
+            break;
+        }
+        can_log_frame_num++;
+    }
+}
+
+/* @brief: Chars waiting in the batch
+ * @return: number of chars
+ */
+uint32_t can_log_pending(void)
+{
+    return can_log_batch_len;
+}
+
+/* @brief: Take one frame of the stream
+ * @param data : frame data, header byte first
+ * @param len  : frame length
+ * @param text : the log text of a complete batch, valid until the next call
+ * @return     : length of text if a batch is complete, else 0
+ */
+int32_t can_log_rx(const uint8_t *data, uint32_t len, const uint8_t **text)
+{
+    uint8_t seq;
+    uint8_t gap;
+    bool key;
+    int32_t ret;
+
+    if ((len < 2U) || (len > CAN_LOG_FRAME_SIZE))
+    {
+        can_log_rx_error_num++;
+        return 0;
+    }
+
+    seq = data[0] & CAN_LOG_SEQ_MASK;
+    gap = (uint8_t)((seq - can_log_rx_seq - 1U) & CAN_LOG_SEQ_MASK);
+    if (can_log_rx_synced && (gap != 0U))
+    {
+        /* whole batches may be in the gap, at least one is lost */
+        can_log_rx_lost_frame_num += gap;
+        can_log_rx_lost_batch_num++;
+        can_log_rx_in_batch = false;
+        can_log_rx_history = false;
+    }
+    can_log_rx_synced = true;
+    can_log_rx_seq = seq;
+
+    if ((data[0] & CAN_LOG_FIRST) != 0U)
+    {
+        if (can_log_rx_in_batch)
+        {
+            /* the sender gave up on the batch without a gap */
+            can_log_rx_error_num++;
+            can_log_rx_history = false;
+        }
+        can_log_rx_in_batch = true;
+        can_log_rx_len = 0U;
+    }
+    else if (!can_log_rx_in_batch)
+    {
+        /* the rest of a lost batch or of one before we listened */
+        return 0;
+    }
+
+    if ((can_log_rx_len + len - 1U) > sizeof(can_log_rx_packed))
+    {
+        can_log_rx_error_num++;
+        can_log_rx_in_batch = false;
+        can_log_rx_history = false;
+        return 0;
+    }
+    memcpy(&can_log_rx_packed[can_log_rx_len], &data[1], len - 1U);
+    can_log_rx_len += len - 1U;
+
+    if ((data[0] & CAN_LOG_LAST) == 0U)
+    {
+        return 0;
+    }
+    can_log_rx_in_batch = false;
+
+    key = (can_log_rx_packed[0] & CAN_LOG_BATCH_KEY) != 0U;
+    if (key && !can_log_rx_ctx.dict)
+    {
+        can_log_ctx_init(&can_log_rx_ctx, true);
+    }
+    if (!key && !can_log_rx_history)
+    {
+        /* refers to a history we do not have, wait for a key batch */
+        can_log_rx_lost_batch_num++;
+        return 0;
+    }
+    ret = can_log_expand(&can_log_rx_ctx, &can_log_rx_packed[1], can_log_rx_len - 1U, key, can_log_rx_text);
+    if (ret < 0)
+    {
+        can_log_rx_error_num++;
+        can_log_rx_history = false;
+        return 0;
+    }
+    can_log_rx_history = true;
+    can_log_rx_batch_num++;
+    *text = can_log_rx_text;
+    return ret;
+}
+
+/* @brief: Start one end of a stream with an empty history
+ * @param ctx  : stream end
+ * @param dict : matches may reach into can_log_dict, both ends must agree
+ * @return     : None
+ */
+void can_log_ctx_init(can_log_ctx_t *ctx, bool dict)
+{
+    ctx->dict = dict;
+    ctx->hist_len = 0U;
+    memcpy(ctx->window, can_log_dict, CAN_LOG_DICT_LEN);
+}
+
+/* @brief: Compress a batch, greedy LZ77 with hash chains, and add it to the
+ *         history. Not reentrant, the hash chains are static
+ * @param ctx  : sending end
+ * @param text : chars
+ * @param len  : number of chars, CAN_LOG_BATCH_SIZE at most
+ * @param out  : room for CAN_LOG_PACKED_MAX(len) bytes
+ * @param key  : key batch, the history starts over
+ * @return     : number of bytes in out
+ */
+uint32_t can_log_compress(can_log_ctx_t *ctx, const uint8_t *text, uint32_t len, uint8_t *out, bool key)
+{
+    uint8_t *w = ctx->window;
+    uint32_t start;
+    uint32_t end;
+    uint32_t pos;
+    uint32_t cand;
+    uint32_t chain;
+    uint32_t limit;
+    uint32_t n;
+    uint32_t best_len;
+    uint32_t best_dist;
+    uint32_t o = 0U;
+
+    if (key)
+    {
+        ctx->hist_len = 0U;
+    }
+    start = CAN_LOG_DICT_LEN + ctx->hist_len;
+    end = start + len;
+    memcpy(&w[start], text, len);
+    memset(can_log_head, 0xFF, sizeof(can_log_head));
+    for (pos = ctx->dict ? 0U : CAN_LOG_DICT_LEN; pos < start; pos++)
+    {
+        can_log_insert(w, pos, end);
+    }
+
+    pos = start;
+    while (pos < end)
+    {
+        best_len = 0U;
+        best_dist = 0U;
+        if ((end - pos) >= CAN_LOG_MATCH_MIN)
+        {
+            limit = ((end - pos) < CAN_LOG_MATCH_MAX) ? (end - pos) : CAN_LOG_MATCH_MAX;
+            cand = can_log_head[can_log_hash(&w[pos])];
+            for (chain = 0U; (chain < CAN_LOG_CHAIN_MAX) && (cand != CAN_LOG_NIL); chain++)
+            {
+                for (n = 0U; (n < limit) && (w[cand + n] == w[pos + n]); n++)
+                {
+                }
+                if (n > best_len)
+                {
+                    best_len = n;
+                    best_dist = pos - cand;
+                    if (n == limit)
+                    {
+                        break;
+                    }
+                }
+                cand = can_log_prev[cand];
+            }
+        }
+
+        if (best_len >= CAN_LOG_MATCH_MIN)
+        {
+            n = best_len - CAN_LOG_MATCH_MIN;
+            out[o++] = (uint8_t)(0x80U | (((n < CAN_LOG_LEN_EXT) ? n : CAN_LOG_LEN_EXT) << 4U) | ((best_dist - 1U) >> 8U));
+            out[o++] = (uint8_t)(best_dist - 1U);
+            if (n >= CAN_LOG_LEN_EXT)
+            {
+                out[o++] = (uint8_t)(n - CAN_LOG_LEN_EXT);
+            }
+            for (n = 0U; n < best_len; n++)
+            {
+                can_log_insert(w, pos++, end);
+            }
+        }
+        else if (w[pos] < 0x80U)
+        {
+            out[o++] = w[pos];
+            can_log_insert(w, pos++, end);
+        }
+        else
+        {
+            for (n = 1U; (n < CAN_LOG_RAW_MAX) && ((pos + n) < end) && (w[pos + n] >= 0x80U); n++)
+            {
+            }
+            out[o++] = (uint8_t)(0x80U | ((n - 1U) << 4U) | (CAN_LOG_DIST_RAW >> 8U));
+            out[o++] = (uint8_t)CAN_LOG_DIST_RAW;
+            for (; n > 0U; n--)
+            {
+                out[o++] = w[pos];
+                can_log_insert(w, pos++, end);
+            }
+        }
+    }
+
+    can_log_history(ctx, len);
+    return o;
+}
+
+/* @brief: Expand a compressed batch and add it to the history, every
+ *         reference is checked
+ * @param ctx  : receiving end
+ * @param data : compressed batch
+ * @param len  : number of bytes
+ * @param key  : key batch, the history starts over
+ * @param text : room for CAN_LOG_BATCH_SIZE chars
+ * @return     : number of chars, -1 for a broken batch, the history is
+ *               lost then
+ */
+int32_t can_log_expand(can_log_ctx_t *ctx, const uint8_t *data, uint32_t len, bool key, uint8_t *text)
+{
+    uint8_t *w = ctx->window;
+    uint32_t start;
+    uint32_t end;
+    uint32_t first = ctx->dict ? 0U : CAN_LOG_DICT_LEN;
+    uint32_t i = 0U;
+    uint32_t o;
+    uint32_t dist;
+    uint32_t n;
+    uint8_t b;
+
+    if (key)
+    {
+        ctx->hist_len = 0U;
+    }
+    start = CAN_LOG_DICT_LEN + ctx->hist_len;
+    end = start + CAN_LOG_BATCH_SIZE;
+    o = start;
+    while (i < len)
+    {
+        b = data[i++];
+        if (b < 0x80U)
+        {
+            if (o >= end)
+            {
+                return -1;
+            }
+            w[o++] = b;
+            continue;
+        }
+
+        if (i >= len)
+        {
+            return -1;
+        }
+        dist = (((uint32_t)b & 0x0FU) << 8U) | data[i++];
+        n = ((uint32_t)b >> 4U) & 0x07U;
+        if (dist == CAN_LOG_DIST_RAW)
+        {
+            n++;
+            if (((i + n) > len) || ((o + n) > end))
+            {
+                return -1;
+            }
+            memcpy(&w[o], &data[i], n);
+            i += n;
+            o += n;
+            continue;
+        }
+
+        if (n == CAN_LOG_LEN_EXT)
+        {
+            if (i >= len)
+            {
+                return -1;
+            }
+            n += data[i++];
+        }
+        n += CAN_LOG_MATCH_MIN;
+        dist++;
+        if (((o + n) > end) || ((o - first) < dist))
+        {
+            return -1;
+        }
+        /* char by char, a match may overlap the chars it makes */
+        for (; n > 0U; n--, o++)
+        {
+            w[o] = w[o - dist];
+        }
+    }
+
+    memcpy(text, &w[start], o - start);
+    can_log_history(ctx, o - start);
+    return (int32_t)(o - start);
+}
+
+static uint32_t can_log_hash(const uint8_t *p)
+{
+    uint32_t v = ((uint32_t)p[0] << 16U) | ((uint32_t)p[1] << 8U) | p[2];
+
+    return (v * 2654435761U) >> (32U - CAN_LOG_HASH_BITS);
+}
+
+/* @brief: Put a window position at the head of its hash chain
+ * @param w   : window
+ * @param pos : window position
+ * @param end : end of the batch, the last 2 chars have nothing to hash
+ * @return    : None
+ */
+static void can_log_insert(const uint8_t *w, uint32_t pos, uint32_t end)
+{
+    uint32_t h;
+
+    if ((pos + CAN_LOG_MATCH_MIN) > end)
+    {
+        return;
+    }
+    h = can_log_hash(&w[pos]);
+    can_log_prev[pos] = can_log_head[h];
+    can_log_head[h] = (uint16_t)pos;
+}
+
+/* @brief: The batch behind the history becomes part of it, only the last
+ *         CAN_LOG_HISTORY_SIZE chars are kept
+ * @param ctx : stream end
+ * @param len : chars of the batch
+ * @return    : None
+ */
+static void can_log_history(can_log_ctx_t *ctx, uint32_t len)
+{
+    uint32_t total = ctx->hist_len + len;
+    uint32_t drop;
+
+    if (total > CAN_LOG_HISTORY_SIZE)
+    {
+        drop = total - CAN_LOG_HISTORY_SIZE;
+        memmove(&ctx->window[CAN_LOG_DICT_LEN], &ctx->window[CAN_LOG_DICT_LEN + drop], CAN_LOG_HISTORY_SIZE);
+        total = CAN_LOG_HISTORY_SIZE;
+    }
+    ctx->hist_len = total;
+}
@@ -0,0 +1,94 @@
+#ifndef CAN_LOG_H
+#define CAN_LOG_H
+
+#include "Cpu.h"
+
+/* printf log stream on CAN, the successor of the ID 0x10 text frames of
+ * S32K144_035_printf_via_CAN.
+ *
+ * The printf writer task hands over its lines with can_log_write(). They
+ * are collected into a batch of up to CAN_LOG_BATCH_SIZE chars, which goes
+ * out when it is full or CAN_LOG_FLUSH_MS after its first line. A batch is
+ * compressed as one block and cut into frames, the first byte of each frame
+ * is its header:
+ *   bit 7   : first frame of a batch, its second byte is the batch header
+ *   bit 6   : last frame of a batch
+ *   bit 5-0 : sequence number, one up per frame
+ * and the batch header:
+ *   bit 0   : key batch, the history starts over
+ *
+ * The block is LZ77 over a window of a preset dictionary of the log text,
+ * the history (the last CAN_LOG_HISTORY_SIZE chars of the batches before)
+ * and the batch itself:
+ *   0x00-0x7F     : this char
+ *   1LLLDDDD DDDDDDDD
+ *                 : D 0-4094, L 0-6: copy L + 3 chars from D + 1 back
+ *                   D 0-4094, L 7: one more byte E follows, copy 10 + E
+ *                   D 4095: L + 1 chars follow as they are, chars of 0x80
+ *                   and above
+ * Sender and receiver keep the same history. A gap in the sequence numbers
+ * drops the batch, and the receiver drops the following ones up to the
+ * next key batch. Every CAN_LOG_KEY_INTERVAL batch is a key batch, and so
+ * is the one after a batch which could not be sent */
+
+#define CAN_LOG_ID 0x10U
+/* classic frames: can_lld pads an FD frame up to the length of its DLC and
+ * the stream has no length of its own */
+#define CAN_LOG_FRAME_SIZE 8U
+#define CAN_LOG_BATCH_SIZE 512U
+#define CAN_LOG_HISTORY_SIZE 2048U
+/* room for can_log_dict */
+#define CAN_LOG_DICT_SIZE 1536U
+#define CAN_LOG_FLUSH_MS 20U
+#define CAN_LOG_KEY_INTERVAL 16U
+/* match candidates tried per position, more packs tighter and takes longer */
+#define CAN_LOG_CHAIN_MAX 32U
+
+#define CAN_LOG_FIRST 0x80U
+#define CAN_LOG_LAST 0x40U
+#define CAN_LOG_SEQ_MASK 0x3FU
+#define CAN_LOG_BATCH_KEY 0x01U
+
+#define CAN_LOG_MATCH_MIN 3U
+#define CAN_LOG_MATCH_MAX (10U + 255U)
+#define CAN_LOG_DIST_MAX 4095U
+/* a batch packs into this at worst: 2 bytes for every 8 chars of 0x80 and up */
+#define CAN_LOG_PACKED_MAX(len) ((len) + ((((len) + 7U) / 8U) * 2U))
+
+#if (CAN_LOG_DICT_SIZE + CAN_LOG_HISTORY_SIZE + CAN_LOG_BATCH_SIZE) > (CAN_LOG_DIST_MAX + 1U)
+#error "the start of the window is out of reach at the end of a batch"
+#endif
+
+/* one end of the stream: dictionary, history and batch in a row */
+typedef struct
+{
+    bool dict;          /* matches may reach into the dictionary */
+    uint32_t hist_len;  /* chars of history */
+    uint8_t window[CAN_LOG_DICT_SIZE + CAN_LOG_HISTORY_SIZE + CAN_LOG_BATCH_SIZE];
+} can_log_ctx_t;
+
+extern uint32_t can_log_line_num;
+extern uint32_t can_log_batch_num;
+extern uint32_t can_log_text_bytes;
+extern uint32_t can_log_packed_bytes;
+extern uint32_t can_log_frame_num;
+extern uint32_t can_log_drop_num;
+
+extern uint32_t can_log_rx_batch_num;
+extern uint32_t can_log_rx_lost_frame_num;
+extern uint32_t can_log_rx_lost_batch_num;
+extern uint32_t can_log_rx_error_num;
+
+/* sends one frame of the stream, false if it could not be queued. printf_lld.c
+ * on the board, the host tools have their own */
+bool can_log_send(const uint8_t *data, uint32_t len);
+
+void can_log_write(const char *text, uint32_t len);
+void can_log_flush(void);
+uint32_t can_log_pending(void);
+int32_t can_log_rx(const uint8_t *data, uint32_t len, const uint8_t **text);
+void can_log_ctx_init(can_log_ctx_t *ctx, bool dict);
+uint32_t can_log_compress(can_log_ctx_t *ctx, const uint8_t *text, uint32_t len, uint8_t *out, bool key);
+int32_t can_log_expand(can_log_ctx_t *ctx, const uint8_t *data, uint32_t len, bool key, uint8_t *text);
+
+#endif
@@ -0,0 +1,881 @@
+/* Compression and bus load of the CAN log stream on the printf output of the
+ * lessons.
+ *
+ * The corpus is every printf format of the given sources, printf("...") and
+ * PRINTF_FMT(name, "...") of printf_fmt.def, printed in source order with
+ * made up arguments for -r rounds. Every argument is a counter which goes up
+ * by its own step from round to round, like the counters of the test
+ * cases. Lines are cut like printf_lld does, at '\n' and at 80 chars. -t
+ * takes a log captured from the UART instead.
+ *
+ * For batches of 1 to 32 lines, the stream runs through can_log.c and is
+ * compared with the ID 0x10 text frames of S32K144_035_printf_via_CAN,
+ * every line in frames of up to 8 chars:
+ *   - packed bytes of the stream, and of the same batches each on its own
+ *     (every one a key batch) with and without can_log_dict
+ *   - frames and bits on the bus, classic frames with an 11 bit ID and the
+ *     worst case stuff bits, as can_stats_frame_bits() counts them
+ * Every frame goes through can_log_rx() and every batch must come back as
+ * it was. Then the stream runs once more with -p percent of its frames lost
+ * and once more with -p percent of the frames refused by can_log_send(): a
+ * batch may only come back whole, every gap must be counted, and the
+ * stream must be back with the next key batch. Last, can_log_expand() gets
+ * broken batches and must turn them down without reaching out of its
+ * window.
+ * -o sends the stream of -l lines per batch to a SocketCAN interface for
+ * can_log_rx, -w writes the corpus to compare its output with. Without vcan
+ * both go on the emulated bus of S32K144_057 when linked with its
+ * vbus_wrap.c, see build below.
+ * Exit status 1 on a failed check.
+ *
+ * build: gcc -O2 -Wall -I.. -I../../S32K144_057_CAN_socketcan/host -o can_log_bench can_log_bench.c ../can_log.c
+ * usage: can_log_bench [-r rounds] [-s seed] [-p loss%] [-l lines] [-w corpus.txt] [-o ifname] [-t log.txt | sources...]
+ *   e.g. can_log_bench ../rtos.c ../../S32K144_043_printf_format_specialization/printf_fmt.def
+ * emulated bus: add ../../S32K144_057_CAN_socketcan/host/vbus_wrap.c
+ *   -Wl,--wrap=socket,--wrap=bind,--wrap=setsockopt,--wrap=ioctl,--wrap=recvmsg,--wrap=read,--wrap=write
+ *   to the build lines of can_log_bench and can_log_rx, then with vbus of S32K144_057
+ *   ./vbus & ./can_log_rx -i vcan0 > rx.txt & ./can_log_bench -w corpus.txt -o vcan0 sources...;
+ *   kill -INT %2; kill %1; cmp rx.txt corpus.txt
+ */
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include "can_log.h"
+
+/* PRINTF_LLD_LINE_SIZE */
+#define BENCH_LINE_SIZE 80U
+#define BENCH_FMT_MAX 512U
+#define BENCH_ARG_MAX 16U
+#define BENCH_LINE_MAX 200000U
+#define BENCH_FRAME_MAX 2000000U
+/* gap between two frames sent with -o, a vcan socket has no bitrate */
+#define BENCH_TX_GAP_US 200U
+
+#define BENCH_CHECK(cond, ...) do { bench_check_num++; if (!(cond)) { printf("FAIL: " __VA_ARGS__); printf("\n"); bench_error++; } } while (0)
+
+typedef struct
+{
+    char *text;
+    uint32_t len;
+} bench_line_t;
+
+typedef struct
+{
+    uint8_t data[CAN_LOG_FRAME_SIZE];
+    uint8_t len;
+} bench_frame_t;
+
+/* a batch size and its frames */
+typedef struct
+{
+    uint32_t packed;    /* bytes with the batch header */
+    uint32_t frames;
+    uint64_t bits;
+} bench_size_t;
+
+typedef struct
+{
+    uint32_t text;      /* chars of the log */
+    bench_size_t stream;
+    bench_size_t key;   /* every batch a key batch */
+    bench_size_t nodict;
+    uint64_t stuff;
+} bench_result_t;
+
+static uint32_t bench_error = 0U;
+static uint32_t bench_check_num = 0U;
+
+static char *bench_fmt[BENCH_FMT_MAX];
+static uint32_t bench_fmt_num = 0U;
+static uint32_t bench_value[BENCH_FMT_MAX][BENCH_ARG_MAX];
+static uint32_t bench_step[BENCH_FMT_MAX][BENCH_ARG_MAX];
+
+static bench_line_t bench_line[BENCH_LINE_MAX];
+static uint32_t bench_line_num = 0U;
+
+/* key batches bench_receive() let through whole */
+static uint32_t bench_rx_key_num = 0U;
+
+/* can_log_send() records the frames here */
+static bench_frame_t *bench_frame;
+static uint32_t bench_frame_num = 0U;
+static int bench_socket = -1;
+/* percent of the frames can_log_send() refuses */
+static uint32_t bench_refuse = 0U;
+
+bool can_log_send(const uint8_t *data, uint32_t len)
+{
+    struct can_frame frame;
+
+    if ((bench_frame_num >= BENCH_FRAME_MAX) || ((bench_refuse != 0U) && (((uint32_t)rand() % 100U) < bench_refuse)))
+    {
+        return false;
+    }
+    memcpy(bench_frame[bench_frame_num].data, data, len);
+    bench_frame[bench_frame_num].len = (uint8_t)len;
+    bench_frame_num++;
+
+    if (bench_socket >= 0)
+    {
+        memset(&frame, 0, sizeof(frame));
+        frame.can_id = CAN_LOG_ID;
+        frame.can_dlc = (uint8_t)len;
+        memcpy(frame.data, data, len);
+        if (write(bench_socket, &frame, sizeof(frame)) != (ssize_t)sizeof(frame))
+        {
+            perror("write");
+            return false;
+        }
+        usleep(BENCH_TX_GAP_US);
+    }
+    return true;
+}
+
+/* @brief: Bits of a classic data frame with an 11 bit ID, the same sums as
+ *         can_stats_frame_bits()
+ * @param len   : data bytes
+ * @param stuff : worst case stuff bits
+ * @return      : bits including the intermission
+ */
+static uint32_t bench_frame_bits(uint32_t len, uint32_t *stuff)
+{
+    uint32_t data = 34U + (8U * len);
+
+    *stuff = (data - 1U) / 4U;
+    return data + 13U;
+}
+
+static void bench_add_line(const char *text, uint32_t len)
+{
+    if (bench_line_num >= BENCH_LINE_MAX)
+    {
+        return;
+    }
+    bench_line[bench_line_num].text = malloc(len);
+    memcpy(bench_line[bench_line_num].text, text, len);
+    bench_line[bench_line_num].len = len;
+    bench_line_num++;
+}
+
+/* @brief: Cut printed text into lines like printf_lld_putchar()
+ * @param text : printed chars
+ * @return     : None
+ */
+static void bench_add_text(const char *text)
+{
+    static char line[BENCH_LINE_SIZE];
+    static uint32_t len = 0U;
+
+    for (; *text != '\0'; text++)
+    {
+        line[len++] = *text;
+        if ((*text == '\n') || (len >= BENCH_LINE_SIZE))
+        {
+            bench_add_line(line, len);
+            len = 0U;
+        }
+    }
+}
+
+/* @brief: Take the string literal that starts at p, C escapes resolved
+ * @param p : the char after the opening quote
+ * @return  : the format, NULL if the literal does not end on the line
+ */
+static char *bench_literal(const char *p)
+{
+    char buf[512];
+    uint32_t len = 0U;
+
+    for (; (*p != '"') && (*p != '\0') && (len < (sizeof(buf) - 1U)); p++)
+    {
+        if (*p == '\\')
+        {
+            p++;
+            switch (*p)
+            {
+            case 'n':
+                buf[len++] = '\n';
+                break;
+            case 't':
+                buf[len++] = '\t';
+                break;
+            case '\0':
+                return NULL;
+            default:
+                buf[len++] = *p;
+                break;
+            }
+        }
+        else
+        {
+            buf[len++] = *p;
+        }
+    }
+    if (*p != '"')
+    {
+        return NULL;
+    }
+    buf[len] = '\0';
+    return strdup(buf);
+}
+
+/* @brief: Collect the printf formats of a source, lines which start as a
+ *         comment are left out
+ * @param path : C source or printf_fmt.def
+ * @return     : None
+ */
+static void bench_read_source(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    char line[1024];
+    const char *p;
+    const char *s;
+    char *fmt;
+
+    if (f == NULL)
+    {
+        perror(path);
+        exit(2);
+    }
+    while (fgets(line, sizeof(line), f) != NULL)
+    {
+        for (s = line; isspace((unsigned char)*s); s++)
+        {
+        }
+        if ((strncmp(s, "/*", 2U) == 0) || (strncmp(s, "//", 2U) == 0) || (strncmp(s, "*", 1U) == 0))
+        {
+            continue;
+        }
+        p = strstr(line, "printf(\"");
+        if ((p != NULL) && ((p == line) || (!isalnum((unsigned char)p[-1]) && (p[-1] != '_'))))
+        {
+            p += strlen("printf(\"");
+        }
+        else if ((p = strstr(line, "PRINTF_FMT(")) != NULL)
+        {
+            p = strchr(p, '"');
+            p = (p != NULL) ? (p + 1) : NULL;
+        }
+        else
+        {
+            p = NULL;
+        }
+        if ((p != NULL) && (bench_fmt_num < BENCH_FMT_MAX) && ((fmt = bench_literal(p)) != NULL))
+        {
+            bench_fmt[bench_fmt_num++] = fmt;
+        }
+    }
+    fclose(f);
+}
+
+/* @brief: Print a format with its counters and step them
+ * @param i : format
+ * @return  : None
+ */
+static void bench_render(uint32_t i)
+{
+    static const char *const words[] = {"classic", "on", "error active", "FD", "off", "error passive"};
+    const char *p = bench_fmt[i];
+    char out[1024];
+    char spec[32];
+    uint32_t o = 0U;
+    uint32_t arg = 0U;
+    uint32_t n;
+    uint32_t v;
+    char conv;
+    int bit;
+
+    while ((*p != '\0') && (o < (sizeof(out) - 64U)))
+    {
+        if (*p != '%')
+        {
+            out[o++] = *p++;
+            continue;
+        }
+        /* flags, width, precision, length */
+        spec[0] = '%';
+        n = 1U;
+        for (p++; (strchr("-+ #0123456789.", *p) != NULL) && (*p != '\0') && (n < 16U); p++)
+        {
+            spec[n++] = *p;
+        }
+        while ((*p == 'l') || (*p == 'h') || (*p == 'z'))
+        {
+            p++;
+        }
+        conv = *p;
+        if (conv == '\0')
+        {
+            break;
+        }
+        p++;
+        if (conv == '%')
+        {
+            out[o++] = '%';
+            continue;
+        }
+        v = bench_value[i][arg % BENCH_ARG_MAX];
+        bench_value[i][arg % BENCH_ARG_MAX] += bench_step[i][arg % BENCH_ARG_MAX];
+        arg++;
+        spec[n++] = conv;
+        spec[n] = '\0';
+        switch (conv)
+        {
+        case 'f':
+            spec[n - 1U] = 'f';
+            o += (uint32_t)snprintf(&out[o], sizeof(out) - o, spec, (double)v / 1000.0);
+            break;
+        case 's':
+            o += (uint32_t)snprintf(&out[o], sizeof(out) - o, "%s", words[v % (sizeof(words) / sizeof(words[0]))]);
+            break;
+        case 'c':
+            out[o++] = (char)('a' + (v % 26U));
+            break;
+        case 'b':
+            /* binary, printf.c of the lessons */
+            for (bit = 31; (bit > 0) && (((v >> bit) & 1U) == 0U); bit--)
+            {
+            }
+            for (; bit >= 0; bit--)
+            {
+                out[o++] = (char)('0' + ((v >> bit) & 1U));
+            }
+            break;
+        case 'x':
+        case 'X':
+        case 'u':
+            o += (uint32_t)snprintf(&out[o], sizeof(out) - o, spec, v);
+            break;
+        default:
+            spec[n - 1U] = 'd';
+            o += (uint32_t)snprintf(&out[o], sizeof(out) - o, spec, (int)v);
+            break;
+        }
+    }
+    out[o] = '\0';
+    bench_add_text(out);
+}
+
+static void bench_make_corpus(uint32_t rounds)
+{
+    static const uint32_t steps[] = {0U, 1U, 1U, 3U, 17U, 100U, 1000U, 40000U};
+    uint32_t i;
+    uint32_t a;
+    uint32_t r;
+
+    for (i = 0U; i < bench_fmt_num; i++)
+    {
+        for (a = 0U; a < BENCH_ARG_MAX; a++)
+        {
+            bench_value[i][a] = (uint32_t)rand() % 100U;
+            bench_step[i][a] = steps[(uint32_t)rand() % (sizeof(steps) / sizeof(steps[0]))];
+        }
+    }
+    for (r = 0U; r < rounds; r++)
+    {
+        for (i = 0U; i < bench_fmt_num; i++)
+        {
+            bench_render(i);
+        }
+    }
+}
+
+static void bench_read_log(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    char buf[4096];
+    size_t n;
+
+    if (f == NULL)
+    {
+        perror(path);
+        exit(2);
+    }
+    while ((n = fread(buf, 1U, sizeof(buf) - 1U, f)) > 0U)
+    {
+        buf[n] = '\0';
+        bench_add_text(buf);
+    }
+    fclose(f);
+}
+
+/* @brief: Frames and bits of a packed batch
+ * @param packed : bytes with the batch header
+ * @param size   : sums
+ * @return       : None
+ */
+static void bench_size(uint32_t packed, bench_size_t *size)
+{
+    uint32_t stuff;
+
+    size->packed += packed;
+    size->frames += (packed + CAN_LOG_FRAME_SIZE - 2U) / (CAN_LOG_FRAME_SIZE - 1U);
+    size->bits += (uint64_t)bench_frame_bits(CAN_LOG_FRAME_SIZE, &stuff) * (packed / (CAN_LOG_FRAME_SIZE - 1U));
+    if ((packed % (CAN_LOG_FRAME_SIZE - 1U)) != 0U)
+    {
+        size->bits += bench_frame_bits((packed % (CAN_LOG_FRAME_SIZE - 1U)) + 1U, &stuff);
+    }
+}
+
+/* @brief: A batch on its own, as a key batch with and without the
+ *         dictionary, and back again
+ * @param batch  : chars
+ * @param len    : number of chars, 0 afterwards
+ * @param result : sizes
+ * @return       : None
+ */
+static void bench_batch(const uint8_t *batch, uint32_t *len, bench_result_t *result)
+{
+    static can_log_ctx_t ctx_dict;
+    static can_log_ctx_t ctx_nodict;
+    static can_log_ctx_t ctx_back;
+    static bool ready = false;
+    static uint8_t packed[CAN_LOG_PACKED_MAX(CAN_LOG_BATCH_SIZE)];
+    static uint8_t text[CAN_LOG_BATCH_SIZE];
+    uint32_t n;
+    int32_t back;
+
+    if (*len == 0U)
+    {
+        return;
+    }
+    if (!ready)
+    {
+        can_log_ctx_init(&ctx_dict, true);
+        can_log_ctx_init(&ctx_nodict, false);
+        can_log_ctx_init(&ctx_back, false);
+        ready = true;
+    }
+    n = can_log_compress(&ctx_dict, batch, *len, packed, true);
+    BENCH_CHECK(n <= CAN_LOG_PACKED_MAX(*len), "%u chars packed into %u bytes", *len, n);
+    bench_size(1U + n, &result->key);
+    n = can_log_compress(&ctx_nodict, batch, *len, packed, true);
+    bench_size(1U + n, &result->nodict);
+    back = can_log_expand(&ctx_back, packed, n, true, text);
+    BENCH_CHECK((back == (int32_t)*len) && (memcmp(text, batch, *len) == 0), "batch without the dictionary broken");
+    *len = 0U;
+}
+
+/* @brief: The stream of lines per batch through can_log.c, the writer task
+ *         of printf_lld with a flush after every few lines
+ * @param lines  : lines per batch, a full batch goes earlier
+ * @param result : sizes
+ * @return       : None
+ */
+static void bench_stream(uint32_t lines, bench_result_t *result)
+{
+    static uint8_t batch[CAN_LOG_BATCH_SIZE];
+    uint32_t batch_len = 0U;
+    uint32_t i;
+    uint32_t stuff;
+    uint32_t packed_start = can_log_packed_bytes;
+
+    memset(result, 0, sizeof(*result));
+    bench_frame_num = 0U;
+    for (i = 0U; i < bench_line_num; i++)
+    {
+        /* the batches of can_log_write() once more, each on its own */
+        if ((batch_len + bench_line[i].len) > CAN_LOG_BATCH_SIZE)
+        {
+            bench_batch(batch, &batch_len, result);
+        }
+        memcpy(&batch[batch_len], bench_line[i].text, bench_line[i].len);
+        batch_len += bench_line[i].len;
+
+        can_log_write(bench_line[i].text, bench_line[i].len);
+        result->text += bench_line[i].len;
+        if (((i + 1U) % lines) == 0U)
+        {
+            can_log_flush();
+            bench_batch(batch, &batch_len, result);
+        }
+    }
+    can_log_flush();
+    bench_batch(batch, &batch_len, result);
+
+    result->stream.packed = can_log_packed_bytes - packed_start;
+    result->stream.frames = bench_frame_num;
+    for (i = 0U; i < bench_frame_num; i++)
+    {
+        result->stream.bits += bench_frame_bits(bench_frame[i].len, &stuff);
+        result->stuff += stuff;
+    }
+}
+
+/* @brief: Lines of the corpus a batch is made of
+ * @param text : batch
+ * @param len  : number of chars
+ * @param line : first line it may start at, the line after it on return
+ * @return     : number of lines, 0 if the batch is nowhere from line on
+ */
+static uint32_t bench_match(const uint8_t *text, uint32_t len, uint32_t *line)
+{
+    uint32_t start;
+    uint32_t l;
+    uint32_t pos;
+
+    for (start = *line; start < bench_line_num; start++)
+    {
+        for (l = start, pos = 0U; (pos < len) && (l < bench_line_num); pos += bench_line[l].len, l++)
+        {
+            if (((len - pos) < bench_line[l].len) || (memcmp(&text[pos], bench_line[l].text, bench_line[l].len) != 0))
+            {
+                break;
+            }
+        }
+        if (pos == len)
+        {
+            *line = l;
+            return l - start;
+        }
+    }
+    return 0U;
+}
+
+/* @brief: Feed the frames of the last stream to can_log_rx(), drop some of
+ *         them, and compare what comes out with the corpus
+ * @param loss  : percent of the frames dropped
+ * @param whole : the stream is complete, every line must come back in order
+ * @param lost  : frames dropped before the last one let through, the ones
+ *                after it are no gap yet
+ * @return      : lines that came back
+ */
+static uint32_t bench_receive(uint32_t loss, bool whole, uint32_t *lost)
+{
+    const uint8_t *text;
+    uint32_t line = 0U;
+    uint32_t first;
+    uint32_t back = 0U;
+    uint32_t num;
+    uint32_t i;
+    uint32_t tail = 0U;
+    uint32_t gaps_before = can_log_rx_lost_frame_num;
+    int32_t n;
+    bool key = false;
+
+    *lost = 0U;
+    bench_rx_key_num = 0U;
+    for (i = 0U; i < bench_frame_num; i++)
+    {
+        if ((loss != 0U) && (((uint32_t)rand() % 100U) < loss))
+        {
+            tail++;
+            key = false;
+            continue;
+        }
+        *lost += tail;
+        tail = 0U;
+        if ((bench_frame[i].data[0] & CAN_LOG_FIRST) != 0U)
+        {
+            key = (bench_frame[i].data[1] & CAN_LOG_BATCH_KEY) != 0U;
+        }
+        if (key && ((bench_frame[i].data[0] & CAN_LOG_LAST) != 0U))
+        {
+            bench_rx_key_num++;
+        }
+        n = can_log_rx(bench_frame[i].data, bench_frame[i].len, &text);
+        if (n <= 0)
+        {
+            continue;
+        }
+        /* whole lines, in order, right after the last batch without loss */
+        first = line;
+        num = bench_match(text, (uint32_t)n, &line);
+        BENCH_CHECK(num != 0U, "batch of %d chars not in the corpus after line %u", n, first);
+        BENCH_CHECK(!whole || ((line - num) == first), "batch at line %u, %u expected", line - num, first);
+        if (num == 0U)
+        {
+            break;
+        }
+        back += num;
+    }
+    BENCH_CHECK(!whole || ((can_log_rx_lost_frame_num - gaps_before) == 0U), "gap in a stream without loss");
+    return back;
+}
+
+/* @brief: can_log_expand() on batches with bytes flipped, cut short and
+ *         made up, the window has a guard zone behind it which must stay as
+ *         it is
+ * @return: None
+ */
+static void bench_broken(void)
+{
+    static struct
+    {
+        can_log_ctx_t ctx;
+        uint8_t guard[64];
+    } rx;
+    static can_log_ctx_t tx;
+    static uint8_t packed[CAN_LOG_PACKED_MAX(CAN_LOG_BATCH_SIZE)];
+    static uint8_t text[CAN_LOG_BATCH_SIZE];
+    uint32_t len;
+    uint32_t n;
+    uint32_t i;
+    uint32_t j;
+    uint32_t refused = 0U;
+    int32_t ret;
+    bool guard = true;
+
+    can_log_ctx_init(&tx, true);
+    can_log_ctx_init(&rx.ctx, true);
+    memset(rx.guard, 0xA5, sizeof(rx.guard));
+    for (i = 0U; i < 20000U; i++)
+    {
+        len = 0U;
+        for (j = (uint32_t)rand() % bench_line_num; (j < bench_line_num) && ((len + bench_line[j].len) <= CAN_LOG_BATCH_SIZE); j++)
+        {
+            memcpy(&text[len], bench_line[j].text, bench_line[j].len);
+            len += bench_line[j].len;
+            if (((uint32_t)rand() % 8U) == 0U)
+            {
+                break;
+            }
+        }
+        n = can_log_compress(&tx, text, len, packed, (i % CAN_LOG_KEY_INTERVAL) == 0U);
+        switch (i % 3U)
+        {
+        case 0U:
+            packed[(uint32_t)rand() % n] ^= (uint8_t)(1U << ((uint32_t)rand() % 8U));
+            break;
+        case 1U:
+            n = (uint32_t)rand() % n;
+            break;
+        default:
+            for (j = 0U; j < n; j++)
+            {
+                packed[j] = (uint8_t)rand();
+            }
+            break;
+        }
+        ret = can_log_expand(&rx.ctx, packed, n, (i % CAN_LOG_KEY_INTERVAL) == 0U, text);
+        BENCH_CHECK(ret <= (int32_t)CAN_LOG_BATCH_SIZE, "broken batch expanded to %d chars", ret);
+        BENCH_CHECK(rx.ctx.hist_len <= CAN_LOG_HISTORY_SIZE, "history of %u chars", rx.ctx.hist_len);
+        refused += (ret < 0) ? 1U : 0U;
+        for (j = 0U; j < sizeof(rx.guard); j++)
+        {
+            guard = guard && (rx.guard[j] == 0xA5U);
+        }
+    }
+    BENCH_CHECK(guard, "write behind the window");
+    BENCH_CHECK(refused != 0U, "no broken batch turned down");
+    printf("broken batches: %u of %u turned down\n", refused, i);
+}
+
+static int bench_open(const char *ifname)
+{
+    struct sockaddr_can addr;
+    struct ifreq ifr;
+    int s = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+
+    if (s < 0)
+    {
+        perror("socket");
+        exit(2);
+    }
+    memset(&ifr, 0, sizeof(ifr));
+    snprintf(ifr.ifr_name, sizeof(ifr.ifr_name), "%s", ifname);
+    if (ioctl(s, SIOCGIFINDEX, &ifr) < 0)
+    {
+        perror(ifname);
+        exit(2);
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = ifr.ifr_ifindex;
+    if (bind(s, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        perror("bind");
+        exit(2);
+    }
+    return s;
+}
+
+int main(int argc, char **argv)
+{
+    static const uint32_t batch_lines[] = {1U, 2U, 4U, 8U, 16U, 32U};
+    bench_result_t result;
+    const char *log_path = NULL;
+    const char *corpus_path = NULL;
+    const char *ifname = NULL;
+    uint32_t rounds = 50U;
+    uint32_t seed = 1U;
+    uint32_t loss = 5U;
+    uint32_t lines = 4U;
+    uint32_t text_035;
+    uint32_t frames_035;
+    uint64_t bits_035;
+    uint64_t stuff_035;
+    uint32_t stuff;
+    uint32_t lost;
+    uint32_t gaps;
+    uint32_t back;
+    uint32_t i;
+    uint32_t n;
+    FILE *f;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "r:s:p:l:w:o:t:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'r':
+            rounds = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            seed = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'p':
+            loss = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'l':
+            lines = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'w':
+            corpus_path = optarg;
+            break;
+        case 'o':
+            ifname = optarg;
+            break;
+        case 't':
+            log_path = optarg;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-r rounds] [-s seed] [-p loss%%] [-l lines] [-w corpus.txt] [-o ifname] "
+                            "[-t log.txt | sources...]\n", argv[0]);
+            return 2;
+        }
+    }
+    srand(seed);
+    bench_frame = malloc(sizeof(bench_frame_t) * BENCH_FRAME_MAX);
+
+    if (log_path != NULL)
+    {
+        bench_read_log(log_path);
+    }
+    else
+    {
+        for (i = (uint32_t)optind; i < (uint32_t)argc; i++)
+        {
+            bench_read_source(argv[i]);
+        }
+        if (bench_fmt_num == 0U)
+        {
+            fprintf(stderr, "no printf formats, give the sources or -t\n");
+            return 2;
+        }
+        bench_make_corpus(rounds);
+    }
+    if (corpus_path != NULL)
+    {
+        f = fopen(corpus_path, "w");
+        for (i = 0U; (f != NULL) && (i < bench_line_num); i++)
+        {
+            fwrite(bench_line[i].text, 1U, bench_line[i].len, f);
+        }
+        if (f != NULL)
+        {
+            fclose(f);
+        }
+    }
+
+    /* first of all, a can_log_rx started before it gets all of the stream
+     * from the first key batch on */
+    if (ifname != NULL)
+    {
+        bench_socket = bench_open(ifname);
+        bench_stream(lines, &result);
+        close(bench_socket);
+        bench_socket = -1;
+        back = bench_receive(0U, true, &lost);
+        BENCH_CHECK(back == bench_line_num, "%u of %u lines sent to %s came back", back, bench_line_num, ifname);
+        printf("sent %u lines in %u frames to %s\n", bench_line_num, result.stream.frames, ifname);
+    }
+
+    /* S32K144_035: every line in frames of up to 8 chars */
+    text_035 = 0U;
+    frames_035 = 0U;
+    bits_035 = 0U;
+    stuff_035 = 0U;
+    for (i = 0U; i < bench_line_num; i++)
+    {
+        text_035 += bench_line[i].len;
+        for (n = 0U; n < bench_line[i].len; n += 8U)
+        {
+            frames_035++;
+            bits_035 += bench_frame_bits(((bench_line[i].len - n) < 8U) ? (bench_line[i].len - n) : 8U, &stuff);
+            stuff_035 += stuff;
+        }
+    }
+    printf("corpus: %u formats, %u lines, %u chars, batches of up to %u chars, dictionary on\n", bench_fmt_num,
+           bench_line_num, text_035, CAN_LOG_BATCH_SIZE);
+    printf("S32K144_035 text frames: %u frames, %llu bits, %llu with worst case stuffing\n", frames_035,
+           (unsigned long long)bits_035, (unsigned long long)(bits_035 + stuff_035));
+    printf("             ratio                  frames                   bus load of 035\n");
+    printf("lines/batch  stream  key  no dict  stream  key     no dict  stream  key     no dict  bits/char\n");
+
+    for (i = 0U; i < (sizeof(batch_lines) / sizeof(batch_lines[0])); i++)
+    {
+        bench_stream(batch_lines[i], &result);
+        back = bench_receive(0U, true, &lost);
+        BENCH_CHECK(back == bench_line_num, "%u lines/batch: %u of %u lines came back", batch_lines[i], back,
+                    bench_line_num);
+        printf("%11u  %6.2f  %4.2f  %7.2f  %6u  %6u  %7u  %5.1f%%  %5.1f%%  %6.1f%%  %9.2f\n", batch_lines[i],
+               (double)result.text / result.stream.packed, (double)result.text / result.key.packed,
+               (double)result.text / result.nodict.packed, result.stream.frames, result.key.frames,
+               result.nodict.frames, 100.0 * (double)result.stream.bits / bits_035,
+               100.0 * (double)result.key.bits / bits_035, 100.0 * (double)result.nodict.bits / bits_035,
+               (double)result.stream.bits / result.text);
+    }
+
+    /* lossy channel, the receiver starts in sync from the stream above */
+    bench_stream(lines, &result);
+    gaps = can_log_rx_lost_batch_num;
+    n = can_log_rx_lost_frame_num;
+    back = bench_receive(loss, loss == 0U, &lost);
+    gaps = can_log_rx_lost_batch_num - gaps;
+    n = can_log_rx_lost_frame_num - n;
+    printf("%u%% loss, %u lines/batch: %u of %u frames lost, %u counted, %u batches lost, %u of %u lines came back\n",
+           loss, lines, lost, result.stream.frames, n, gaps, back, bench_line_num);
+    /* more than 63 frames in a row are counted modulo 64 */
+    BENCH_CHECK((loss >= 50U) || (n == lost), "%u frames lost, %u counted", lost, n);
+    BENCH_CHECK((lost == 0U) || (gaps != 0U), "no gap seen");
+    BENCH_CHECK((loss == 0U) || (back < bench_line_num), "all lines back in spite of the loss");
+    BENCH_CHECK((bench_rx_key_num == 0U) || (back > 0U), "no line back after %u whole key batches", bench_rx_key_num);
+    BENCH_CHECK(can_log_rx_error_num == 0U, "%u receive errors", can_log_rx_error_num);
+
+    /* back in step after a key batch */
+    bench_stream(lines, &result);
+    back = bench_receive(0U, false, &lost);
+    BENCH_CHECK(back + (CAN_LOG_KEY_INTERVAL * lines) >= bench_line_num, "%u of %u lines back after the loss", back,
+                bench_line_num);
+
+    /* the sender gives up on frames, the next batch is a key batch. The
+     * receiver is in sync again from the stream above */
+    bench_refuse = loss;
+    n = can_log_drop_num;
+    bench_stream(lines, &result);
+    bench_refuse = 0U;
+    n = can_log_drop_num - n;
+    gaps = can_log_rx_lost_batch_num;
+    back = bench_receive(0U, n == 0U, &lost);
+    gaps = can_log_rx_lost_batch_num - gaps;
+    printf("%u%% refused, %u lines/batch: %u batches dropped by the sender, %u lost, %u of %u lines came back\n",
+           loss, lines, n, gaps, back, bench_line_num);
+    BENCH_CHECK((loss == 0U) || (n != 0U), "no batch dropped");
+    BENCH_CHECK((n == 0U) || (gaps != 0U), "%u batches dropped, none lost", n);
+    /* a drop costs its own batch only, the next one is a key batch */
+    BENCH_CHECK((back + (n * lines)) >= bench_line_num, "%u of %u lines back after %u drops", back, bench_line_num, n);
+    BENCH_CHECK(can_log_rx_error_num == 0U, "%u receive errors", can_log_rx_error_num);
+
+    bench_broken();
+
+    printf("%s, %u checks, %u errors\n", (bench_error == 0U) ? "PASS" : "FAIL", bench_check_num, bench_error);
+    return (bench_error == 0U) ? 0 : 1;
+}
@@ -0,0 +1,188 @@
+/* Host receiver of the CAN log stream of can_log.c. It takes the frames of
+ * CAN_LOG_ID from a SocketCAN interface or from a candump log (candump -l,
+ * can_trace_export), puts the batches back together and prints the log
+ * text on stdout. A gap in the stream is printed as a line of its own:
+ *   [can_log: 3 frames lost]
+ * At the end of the log or on Ctrl-C the counters go to stderr.
+ *
+ * build: gcc -O2 -Wall -I.. -I../../S32K144_057_CAN_socketcan/host -o can_log_rx can_log_rx.c ../can_log.c
+ * usage: can_log_rx [-i ifname] [-f candump.log] [-I id]
+ */
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include "can_log.h"
+
+static volatile sig_atomic_t rx_stop = 0;
+
+/* can_log.c sends with it, the receiver never does */
+bool can_log_send(const uint8_t *data, uint32_t len)
+{
+    (void)data;
+    (void)len;
+    return false;
+}
+
+static void rx_signal(int sig)
+{
+    (void)sig;
+    rx_stop = 1;
+}
+
+/* @brief: One frame of the stream, print the text of a complete batch and
+ *         the frames lost in front of it
+ * @param data : frame data
+ * @param len  : frame length
+ * @return     : None
+ */
+static void rx_frame(const uint8_t *data, uint32_t len)
+{
+    uint32_t lost = can_log_rx_lost_frame_num;
+    const uint8_t *text;
+    int32_t n = can_log_rx(data, len, &text);
+
+    if (can_log_rx_lost_frame_num != lost)
+    {
+        printf("[can_log: %u frames lost]\n", can_log_rx_lost_frame_num - lost);
+    }
+    if (n > 0)
+    {
+        fwrite(text, 1U, (size_t)n, stdout);
+        fflush(stdout);
+    }
+}
+
+static int rx_socket(const char *ifname, uint32_t id)
+{
+    struct sockaddr_can addr;
+    struct can_filter filter;
+    struct ifreq ifr;
+    struct can_frame frame;
+    ssize_t n;
+    int s;
+
+    s = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (s < 0)
+    {
+        perror("socket");
+        return 1;
+    }
+    memset(&ifr, 0, sizeof(ifr));
+    snprintf(ifr.ifr_name, sizeof(ifr.ifr_name), "%s", ifname);
+    if (ioctl(s, SIOCGIFINDEX, &ifr) < 0)
+    {
+        perror(ifname);
+        return 1;
+    }
+    filter.can_id = id;
+    filter.can_mask = CAN_SFF_MASK | CAN_EFF_FLAG | CAN_RTR_FLAG;
+    (void)setsockopt(s, SOL_CAN_RAW, CAN_RAW_FILTER, &filter, sizeof(filter));
+    memset(&addr, 0, sizeof(addr));
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = ifr.ifr_ifindex;
+    if (bind(s, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        perror("bind");
+        return 1;
+    }
+
+    while (!rx_stop)
+    {
+        n = read(s, &frame, sizeof(frame));
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            perror("read");
+            return 1;
+        }
+        /* the filter of a vcan socket may let others through */
+        if ((n == (ssize_t)sizeof(frame)) && (frame.can_id == id))
+        {
+            rx_frame(frame.data, frame.can_dlc);
+        }
+    }
+    close(s);
+    return 0;
+}
+
+/* candump -l: "(1700000000.000000) can0 010#8148656C6C6F" */
+static int rx_file(const char *path, uint32_t id)
+{
+    FILE *f = fopen(path, "r");
+    char line[256];
+    char data[2 * CAN_LOG_FRAME_SIZE + 2];
+    uint8_t bytes[CAN_LOG_FRAME_SIZE];
+    unsigned int frame_id;
+    unsigned int byte;
+    uint32_t len;
+
+    if (f == NULL)
+    {
+        perror(path);
+        return 1;
+    }
+    while (!rx_stop && (fgets(line, sizeof(line), f) != NULL))
+    {
+        if ((sscanf(line, "%*s %*s %x#%18s", &frame_id, data) != 2) || (frame_id != id))
+        {
+            continue;
+        }
+        for (len = 0U; (len < CAN_LOG_FRAME_SIZE) && (sscanf(&data[2U * len], "%2x", &byte) == 1); len++)
+        {
+            bytes[len] = (uint8_t)byte;
+        }
+        rx_frame(bytes, len);
+    }
+    fclose(f);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    const char *ifname = "vcan0";
+    const char *path = NULL;
+    uint32_t id = CAN_LOG_ID;
+    struct sigaction sa;
+    int ret;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "i:f:I:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'i':
+            ifname = optarg;
+            break;
+        case 'f':
+            path = optarg;
+            break;
+        case 'I':
+            id = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-i ifname] [-f candump.log] [-I id]\n", argv[0]);
+            return 2;
+        }
+    }
+    /* without SA_RESTART, Ctrl-C ends a read() which waits for a frame */
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = rx_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    ret = (path != NULL) ? rx_file(path, id) : rx_socket(ifname, id);
+    fprintf(stderr, "can_log: batches %u, lost frames %u, lost batches %u, errors %u\n", can_log_rx_batch_num,
+            can_log_rx_lost_frame_num, can_log_rx_lost_batch_num, can_log_rx_error_num);
+    return ret;
+}
@@ -0,0 +1,181 @@
+/* UDS server of this lesson on SocketCAN, the ECU side of
+ * tools/uds_tester. can_lld, isotp and uds.c are built as they are,
+ * freertos_task_can_rx and freertos_task_uds each run on a thread of their
+ * own. The tables are the ones of rtos.c where the host has the data, plus
+ * for the tester:
+ *   DID 0xF190   17 bytes, written in the extended session
+ *   DID 0x0300   address of a readable block of 256 bytes 0x00-0xFF, the
+ *                only memory of ReadMemoryByAddress
+ *   RID 0x0201   counts the received CAN frames for 1-10000 ms, as on the
+ *                board, with a response pending
+ * Ctrl-C prints the counters of the server.
+ *
+ * build: make (see Makefile)
+ * usage: uds_ecu [-i ifname]
+ */
+#include "rtos.h"
+#include "uds.h"
+#include "can_stats.h"
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define ECU_COUNT_MS_MAX 10000U
+
+static uint8_t ecu_memory[256];
+static uint32_t ecu_memory_addr;
+static uint8_t ecu_vin[17] = {'W', 'S', '3', '2', 'K', '1', '4', '4', 'U', 'D', 'S', '0', '0', '0', '0', '0', '1'};
+
+static TickType_t ecu_count_end;
+static uint32_t ecu_count_first;
+static uint32_t ecu_count_frames;
+static bool ecu_count_valid = false;
+
+static uint8_t ecu_count_start(const uint8_t *option, uint32_t len, uint8_t *status, uint32_t *status_len,
+                               bool first);
+static uint8_t ecu_count_results(const uint8_t *option, uint32_t len, uint8_t *status, uint32_t *status_len,
+                                 bool first);
+
+static const uds_did_t ecu_dids[] =
+{
+    {0xF186U, 1U, UDS_DID_NUMBER, 0U, &uds_session},
+    {0xF190U, 17U, 0U, UDS_SESSIONS_EXTENDED, ecu_vin},
+    {0x0200U, 4U, UDS_DID_NUMBER, UDS_SESSIONS_EXTENDED, &can_lld_rx_frame_num},
+    {0x0201U, 4U, UDS_DID_NUMBER, UDS_SESSIONS_EXTENDED, &can_lld_tx_frame_num},
+    {0x0202U, 4U, UDS_DID_NUMBER, UDS_SESSIONS_EXTENDED, &can_lld_rx_queue_overflow_num},
+    {0x0203U, 4U, UDS_DID_NUMBER, UDS_SESSIONS_EXTENDED, &can_lld_tx_queue_full_num},
+    {0x0204U, 4U, UDS_DID_NUMBER, UDS_SESSIONS_EXTENDED, &can_lld_tx_error_num},
+    {0x0205U, 4U, UDS_DID_NUMBER, UDS_SESSIONS_EXTENDED, &can_lld_error_num},
+    {0x0206U, 4U, UDS_DID_NUMBER, 0U, &can_stats_bus_load},
+    {0x0300U, 4U, UDS_DID_NUMBER, 0U, &ecu_memory_addr}
+};
+
+static const uds_routine_t ecu_routines[] =
+{
+    {0x0201U, UDS_SESSIONS_ALL, ecu_count_start, NULL, ecu_count_results}
+};
+
+/* filled in with the address of ecu_memory, linked without PIE it is a 32
+ * bit one */
+static uds_mem_region_t ecu_mem[1];
+
+static const uds_config_t ecu_config =
+{
+    ecu_dids, sizeof(ecu_dids) / sizeof(ecu_dids[0]),
+    ecu_routines, sizeof(ecu_routines) / sizeof(ecu_routines[0]),
+    ecu_mem, sizeof(ecu_mem) / sizeof(ecu_mem[0])
+};
+
+static uint8_t ecu_count_start(const uint8_t *option, uint32_t len, uint8_t *status, uint32_t *status_len,
+                               bool first)
+{
+    uint32_t ms;
+
+    if (first)
+    {
+        if (len != 2U)
+        {
+            return UDS_NRC_IMLOIF;
+        }
+        ms = ((uint32_t)option[0] << 8U) | option[1];
+        if ((ms == 0U) || (ms > ECU_COUNT_MS_MAX))
+        {
+            return UDS_NRC_ROOR;
+        }
+        ecu_count_end = xTaskGetTickCount() + pdMS_TO_TICKS(ms);
+        ecu_count_first = can_lld_rx_frame_num;
+        return UDS_NRC_PENDING;
+    }
+    if ((TickType_t)(ecu_count_end - xTaskGetTickCount()) < (portMAX_DELAY / 2U))
+    {
+        return UDS_NRC_PENDING;
+    }
+    ecu_count_frames = can_lld_rx_frame_num - ecu_count_first;
+    ecu_count_valid = true;
+    return ecu_count_results(option, 0U, status, status_len, true);
+}
+
+static uint8_t ecu_count_results(const uint8_t *option, uint32_t len, uint8_t *status, uint32_t *status_len,
+                                 bool first)
+{
+    (void)option;
+    (void)first;
+
+    if (len != 0U)
+    {
+        return UDS_NRC_IMLOIF;
+    }
+    if (!ecu_count_valid)
+    {
+        return UDS_NRC_RSE;
+    }
+    status[0] = (uint8_t)(ecu_count_frames >> 24U);
+    status[1] = (uint8_t)(ecu_count_frames >> 16U);
+    status[2] = (uint8_t)(ecu_count_frames >> 8U);
+    status[3] = (uint8_t)ecu_count_frames;
+    *status_len = 4U;
+    return UDS_NRC_OK;
+}
+
+static void *ecu_task(void *arg)
+{
+    ((void (*)(void *))arg)(NULL);
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    pthread_t thread;
+    sigset_t set;
+    uint32_t i;
+    int sig;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "i:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'i':
+            flexcan_host_set_ifname(optarg);
+            break;
+        default:
+            fprintf(stderr, "usage: uds_ecu [-i ifname]\n");
+            return 2;
+        }
+    }
+
+    for (i = 0U; i < sizeof(ecu_memory); i++)
+    {
+        ecu_memory[i] = (uint8_t)i;
+    }
+    ecu_memory_addr = (uint32_t)(uintptr_t)ecu_memory;
+    ecu_mem[0].start = ecu_memory_addr;
+    ecu_mem[0].len = sizeof(ecu_memory);
+
+    /* the threads inherit the mask, only sigwait() below takes Ctrl-C */
+    sigemptyset(&set);
+    sigaddset(&set, SIGINT);
+    sigaddset(&set, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+    can_lld_init();
+    uds_init(&ecu_config);
+    if ((pthread_create(&thread, NULL, ecu_task, (void *)freertos_task_can_rx) != 0) ||
+        (pthread_create(&thread, NULL, ecu_task, (void *)freertos_task_uds) != 0))
+    {
+        perror("pthread_create");
+        return 1;
+    }
+    printf("UDS server on 0x%03X/0x%03X, responses on 0x%03X\n", UDS_PHYS_ID, UDS_FUNC_ID, UDS_RESP_ID);
+    fflush(stdout);
+
+    (void)sigwait(&set, &sig);
+    printf("UDS requests: %u, negative: %u, pending: %u, refused: %u, S3 timeouts: %u\n", uds_request_num,
+           uds_negative_num, uds_pending_num, uds_refused_num, uds_s3_timeout_num);
+    printf("UDS response time max: %uus, later than P2: %u\n", uds_response_max_us, uds_p2_miss_num);
+    printf("ISO-TP RX messages: %u, errors: %u, TX messages: %u, errors: %u\n", isotp_rx_msg_num, isotp_rx_error_num,
+           isotp_tx_msg_num, isotp_tx_error_num);
+    return 0;
+}
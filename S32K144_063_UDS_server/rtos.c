@@ -0,0 +1,834 @@
+#include "rtos.h"
+#include "clockMan1.h"
+#include "pin_mux.h"
+#include "string.h"
+#include "lpit_lld.h"
+#include "freemaster.h"
+#include "math.h"
+#include "adConv1.h"
+#include "pdb1.h"
+#include "adc_lld.h"
+#include "rtc_lld.h"
+#include "lpuart_lld.h"
+#include "wdg_lld.h"
+#include "lptmr_lld.h"
+#include "power_lld.h"
+#include "gps_lld.h"
+#include "printf.h"
+#include "printf_lld.h"
+#include "can_lld.h"
+#include "isotp.h"
+#include "can_stats.h"
+#include "can_err.h"
+#include "can_trace.h"
+#include "can_db.h"
+#include "can_sched.h"
+#include "can_timing.h"
+#include "uds.h"
+
+#define LED_TEST_MODE 0
+#define FREERTOS_QUEUE_TEST_MODE 0
+
+/* variables used for FreeRTOS monitoring */
+uint32_t freertos_counter_1000ms = 0U;
+uint32_t freertos_counter_1ms = 0U;
+uint32_t freertos_counter_tick = 0U;
+uint16_t lptmr_current_value_us;
+uint16_t freertos_counter_1000ms_time_cost;
+TaskHandle_t freertos_handle_uart_rx;
+TaskHandle_t freertos_handle_1ms;
+TaskHandle_t freertos_handle_1000ms;
+TaskHandle_t freertos_handle_100ms;
+TaskHandle_t freertos_handle_powermode;
+TaskHandle_t freertos_handle_printf;
+TaskHandle_t freertos_handle_gps;
+TaskHandle_t freertos_handle_can_rx;
+TaskHandle_t freertos_handle_can_sched;
+TaskHandle_t freertos_handle_uds;
+
+/* variables used for test */
+double value_sin_x;
+double value_sin_y;
+status_t power_mode_init_ret_val;
+#if !LPUART_LLD_RX_BUFFER_ENABLE
+const char rmc_msg_test[] = "$GPRMC,021618.000,A,3150.7827,N,11711.8695,E,0.14,181.50,030119,,,A*76";
+#endif
+
+#if FREERTOS_QUEUE_TEST_MODE
+QueueHandle_t freertos_queue_test = NULL;
+#endif
+
+/* cyclic CAN messages of this node, sent by freertos_task_can_sched */
+#define FREERTOS_CAN_SCHED_ECU_STATUS 0U
+static const can_sched_msg_t freertos_can_sched_table[] =
+{
+    {CAN_DB_ECU_STATUS_ID, CAN_DB_ECU_STATUS_LEN, CAN_SCHED_MODE_PERIODIC, CAN_DB_ECU_STATUS_CYCLE_MS,
+     CAN_SCHED_OFFSET_AUTO, can_lld_ecu_status},
+    {CAN_DB_ECU_FD_STATUS_ID | CAN_LLD_TX_ID_FD, CAN_DB_ECU_FD_STATUS_LEN, CAN_SCHED_MODE_PERIODIC,
+     CAN_DB_ECU_FD_STATUS_CYCLE_MS, CAN_SCHED_OFFSET_AUTO, can_lld_ecu_fd_status}
+};
+
+/* diagnostics of this node on UDS, the counters of can_lld may be cleared
+ * in the extended session */
+static const uds_did_t freertos_uds_dids[] =
+{
+    {0xF186U, 1U, UDS_DID_NUMBER, 0U, &uds_session},
+    {0x0100U, 4U, UDS_DID_NUMBER, 0U, &freertos_counter_1000ms},
+    {0x0101U, 4U, UDS_DID_NUMBER, 0U, &freertos_counter_1ms},
+    {0x0102U, 4U, UDS_DID_NUMBER, 0U, &freertos_counter_tick},
+    {0x0103U, 2U, UDS_DID_NUMBER, 0U, &freertos_counter_1000ms_time_cost},
+    {0x0200U, 4U, UDS_DID_NUMBER, UDS_SESSIONS_EXTENDED, &can_lld_rx_frame_num},
+    {0x0201U, 4U, UDS_DID_NUMBER, UDS_SESSIONS_EXTENDED, &can_lld_tx_frame_num},
+    {0x0202U, 4U, UDS_DID_NUMBER, UDS_SESSIONS_EXTENDED, &can_lld_rx_queue_overflow_num},
+    {0x0203U, 4U, UDS_DID_NUMBER, UDS_SESSIONS_EXTENDED, &can_lld_tx_queue_full_num},
+    {0x0204U, 4U, UDS_DID_NUMBER, UDS_SESSIONS_EXTENDED, &can_lld_tx_error_num},
+    {0x0205U, 4U, UDS_DID_NUMBER, UDS_SESSIONS_EXTENDED, &can_lld_error_num},
+    {0x0206U, 4U, UDS_DID_NUMBER, 0U, &can_stats_bus_load}
+};
+
+static uint8_t freertos_uds_trace_start(const uint8_t *option, uint32_t len, uint8_t *status, uint32_t *status_len,
+                                        bool first);
+static uint8_t freertos_uds_trace_results(const uint8_t *option, uint32_t len, uint8_t *status,
+                                          uint32_t *status_len, bool first);
+static uint8_t freertos_uds_count_start(const uint8_t *option, uint32_t len, uint8_t *status, uint32_t *status_len,
+                                        bool first);
+static uint8_t freertos_uds_count_results(const uint8_t *option, uint32_t len, uint8_t *status,
+                                          uint32_t *status_len, bool first);
+
+/* 0x0200 fires the CAN trace trigger, 0x0201 counts the received CAN frames
+ * for 1 to FREERTOS_UDS_COUNT_MS_MAX ms, with a response pending */
+#define FREERTOS_UDS_COUNT_MS_MAX 10000U
+static const uds_routine_t freertos_uds_routines[] =
+{
+    {0x0200U, UDS_SESSIONS_EXTENDED, freertos_uds_trace_start, NULL, freertos_uds_trace_results},
+    {0x0201U, UDS_SESSIONS_ALL, freertos_uds_count_start, NULL, freertos_uds_count_results}
+};
+
+/* P-Flash, SRAM_L and SRAM_U */
+static const uds_mem_region_t freertos_uds_mem[] =
+{
+    {0x00000000U, 0x00080000U},
+    {0x1FFF8000U, 0x00008000U},
+    {0x20000000U, 0x00007000U}
+};
+
+static const uds_config_t freertos_uds_config =
+{
+    freertos_uds_dids, sizeof(freertos_uds_dids) / sizeof(freertos_uds_dids[0]),
+    freertos_uds_routines, sizeof(freertos_uds_routines) / sizeof(freertos_uds_routines[0]),
+    freertos_uds_mem, sizeof(freertos_uds_mem) / sizeof(freertos_uds_mem[0])
+};
+
+/* routine 0x0201: start and end of the count, result valid after the
+ * first count */
+static TickType_t freertos_uds_count_end;
+static uint32_t freertos_uds_count_first;
+static uint32_t freertos_uds_count_frames;
+static bool freertos_uds_count_valid = false;
+
+/* bitrates of the FreeMASTER autobaud command, most likely first. Each is
+ * listened to for FREERTOS_CAN_AUTOBAUD_WAIT_MS by freertos_task_100ms */
+static const uint32_t freertos_can_autobaud_bitrates[] = {500000U, 250000U, 125000U, 50000U};
+#define FREERTOS_CAN_AUTOBAUD_WAIT_MS 300U
+static volatile bool freertos_can_autobaud_request = false;
+static status_t freertos_can_autobaud_ret = STATUS_SUCCESS;
+
+void board_init(void)
+{
+    /* Initialize and configure clocks
+     *  -   Setup system clocks, dividers
+     *  -   see clock manager component for more details
+     */
+    CLOCK_SYS_Init(g_clockManConfigsArr, CLOCK_MANAGER_CONFIG_CNT,
+                   g_clockManCallbacksArr, CLOCK_MANAGER_CALLBACK_CNT);
+    CLOCK_SYS_UpdateConfiguration(0U, CLOCK_MANAGER_POLICY_AGREEMENT);
+    PINS_DRV_Init(NUM_OF_CONFIGURED_PINS, g_pin_mux_InitConfigArr);
+    PINS_DRV_SetPins(PTD, (1 << 0) | (1 << 15) | (1 << 16));
+    EDMA_DRV_Init(&dmaController1_State, &dmaController1_InitConfig0,
+                  edmaChnStateArray, edmaChnConfigArray, EDMA_CONFIGURED_CHANNELS_COUNT);
+    lpuart_lld_init();
+#if FMSTR_DISABLE
+#else
+    INT_SYS_InstallHandler(LPUART1_RxTx_IRQn, FMSTR_Isr, NULL);
+    FMSTR_Init();
+#endif
+    adc_lld_init();
+    rtc_lld_init();
+    lpit_lld_init();
+    wdg_lld_init();
+    lptmr_lld_init();
+    power_lld_init();
+    SystemInit();
+    power_mode_init_ret_val = POWER_SYS_SetMode(HSRUN, POWER_MANAGER_POLICY_AGREEMENT);
+}
+
+void rtos_start(void)
+{
+    UBaseType_t priority = 0U;
+    /* Start the two tasks as described in the comments at the top of this
+       file. */
+#if FREERTOS_QUEUE_TEST_MODE
+    freertos_queue_test = xQueueCreate(10, sizeof(unsigned long));
+#endif
+
+    printf_lld_init();
+    xTaskCreate(freertos_task_printf, "printf", configMINIMAL_STACK_SIZE, NULL, PRINTF_LLD_WRITER_PRIORITY, &freertos_handle_printf);
+#if LPUART_LLD_RX_BUFFER_ENABLE
+    /* LPUART1 RX carries the NMEA stream of the GPS receiver */
+    xTaskCreate(freertos_task_gps, "gps", 2 * configMINIMAL_STACK_SIZE, NULL, ++priority, &freertos_handle_gps);
+#else
+    xTaskCreate(freertos_task_uart_rx, "uart rx", configMINIMAL_STACK_SIZE, NULL, ++priority, &freertos_handle_uart_rx);
+#endif
+    xTaskCreate(freertos_task_1000ms, "1000ms", 2 * configMINIMAL_STACK_SIZE, NULL, ++priority, &freertos_handle_1000ms);
+    xTaskCreate(freertos_task_100ms, "100ms", 1 * configMINIMAL_STACK_SIZE, NULL, ++priority, &freertos_handle_100ms);
+    /* woken by a UDS request, above the tasks which print so P2 holds */
+    xTaskCreate(freertos_task_uds, "uds", 2 * configMINIMAL_STACK_SIZE, NULL, ++priority, &freertos_handle_uds);
+    /* xTaskCreate(freertos_task_power_mode_test, "power-mode", 2 * configMINIMAL_STACK_SIZE, NULL, ++priority, &freertos_handle_powermode); */
+    xTaskCreate(freertos_task_1ms, "1ms", configMINIMAL_STACK_SIZE, NULL, ++priority, &freertos_handle_1ms);
+    /* drains the CAN RX queue, above the periodic tasks so it keeps up with a
+       fully loaded bus */
+    xTaskCreate(freertos_task_can_rx, "can rx", configMINIMAL_STACK_SIZE, NULL, ++priority, &freertos_handle_can_rx);
+    /* woken by LPIT channel 1 every millisecond, on top so the cyclic CAN
+       messages keep their phase */
+    xTaskCreate(freertos_task_can_sched, "can sched", 2 * configMINIMAL_STACK_SIZE, NULL, ++priority, &freertos_handle_can_sched);
+#if FREERTOS_QUEUE_TEST_MODE
+    xTaskCreate(freertos_task_trigger_by_queue, "queue", configMINIMAL_STACK_SIZE, NULL, ++priority, NULL);
+#endif
+    /* Start the tasks and timer running. */
+    vTaskStartScheduler();
+
+    /* If all is well, the scheduler will now be running, and the following line
+       will never be reached.  If the following line does execute, then there was
+       insufficient FreeRTOS heap memory available for the idle and/or timer tasks
+       to be created.  See the memory management section on the FreeRTOS web site
+       for more details. */
+    for (;;)
+    {
+        /* no code here */
+    }
+}
+
+void freertos_task_100ms(void *pvParameters)
+{
+#if CAN_TRACE_UART_EXPORT_ENABLE
+    /* a packet the UART ring had no room for is sent again next time */
+    static uint8_t can_trace_packet[CAN_TRACE_PACKET_MAX];
+    static uint32_t can_trace_packet_len = 0U;
+#endif
+
+    (void)pvParameters;
+
+    for (;;)
+    {
+        vTaskDelay(pdMS_TO_TICKS(100UL));
+        can_lld_step();
+
+        if (freertos_can_autobaud_request)
+        {
+            /* this task stops for up to a wait of each bitrate */
+            freertos_can_autobaud_ret = can_lld_autobaud(freertos_can_autobaud_bitrates,
+                                                         sizeof(freertos_can_autobaud_bitrates) / sizeof(freertos_can_autobaud_bitrates[0]),
+                                                         pdMS_TO_TICKS(FREERTOS_CAN_AUTOBAUD_WAIT_MS), NULL);
+            freertos_can_autobaud_request = false;
+        }
+
+#if CAN_TRACE_UART_EXPORT_ENABLE
+        /* a stopped trace goes out as fast as the UART takes it, then the
+         * next one is armed */
+        if (can_trace_state == CAN_TRACE_STATE_STOPPED)
+        {
+            if (can_trace_packet_len == 0U)
+            {
+                can_trace_packet_len = can_trace_dump(can_trace_packet);
+            }
+            while ((can_trace_packet_len != 0U) && lpuart_lld_tx_write(can_trace_packet, can_trace_packet_len))
+            {
+                can_trace_packet_len = can_trace_dump(can_trace_packet);
+            }
+            if (can_trace_packet_len == 0U)
+            {
+                can_trace_arm(NULL);
+            }
+        }
+#endif
+    }
+}
+
+void freertos_task_power_mode_test(void *pvParameters)
+{
+    uint32_t power_mode_counter = 0U;
+    status_t ret_val;
+    uint32_t core_frequency;
+
+    (void)pvParameters;
+
+    for (;;)
+    {
+        vTaskDelay(pdMS_TO_TICKS(1000UL));
+        power_mode_counter++;
+        printf("power mode task running: %d\n", power_mode_counter);
+
+        if (lpuart_lld_data_received_flg == 1U)
+        {
+            switch (lpuart_lld_rx_data[0])
+            {
+            case '1':
+                printf("going to HRUN mode.\n");
+                ret_val = POWER_SYS_SetMode(HSRUN, POWER_MANAGER_POLICY_AGREEMENT);
+                if (STATUS_SUCCESS == ret_val)
+                {
+                    printf("now CPU is in HRUM mode.\n");
+                    (void)CLOCK_SYS_GetFreq(CORE_CLOCK, &core_frequency);
+                    printf("core frequency is: %d\n", core_frequency);
+                }
+                else
+                {
+                    printf("failed when change to HRUN mode.\n");
+                }
+                break;
+            case '2':
+                printf("going to RUN mode.\n");
+                ret_val = POWER_SYS_SetMode(RUN, POWER_MANAGER_POLICY_AGREEMENT);
+                if (ret_val == STATUS_SUCCESS)
+                {
+                    printf("now CPU is in RUN mode.\n");
+                    (void)CLOCK_SYS_GetFreq(CORE_CLOCK, &core_frequency);
+                    printf("core frequency is: %d\n", core_frequency);
+                }
+                else
+                {
+                    printf("failed when change to RUN mode.\n");
+                }
+
+                break;
+            case '3':
+                printf("going to VLPR mode.\n");
+                ret_val = POWER_SYS_SetMode(VLPR, POWER_MANAGER_POLICY_AGREEMENT);
+                if (ret_val == STATUS_SUCCESS)
+                {
+                    printf("now CPU is in VLPR mode.\n");
+                    (void)CLOCK_SYS_GetFreq(CORE_CLOCK, &core_frequency);
+                    printf("core frequency is: %d\n", core_frequency);
+                }
+                else
+                {
+                    printf("failed when change to VLPR mode.\n");
+                }
+
+                break;
+            case '4':
+                printf("going to STOP1 mode.\n");
+                ret_val = POWER_SYS_SetMode(STOP1, POWER_MANAGER_POLICY_AGREEMENT);
+                if (ret_val == STATUS_SUCCESS)
+                {
+                    printf("now CPU is in STOP1 mode.\n");
+                    (void)CLOCK_SYS_GetFreq(CORE_CLOCK, &core_frequency);
+                    printf("core frequency is: %d\n", core_frequency);
+                }
+                else
+                {
+                    printf("failed when change to STOP1 mode.\n");
+                }
+
+                break;
+            case '5':
+                printf("going to STOP2 mode.\n");
+                ret_val = POWER_SYS_SetMode(STOP2, POWER_MANAGER_POLICY_AGREEMENT);
+                if (ret_val == STATUS_SUCCESS)
+                {
+                    printf("now CPU is in STOP2 mode.\n");
+                    (void)CLOCK_SYS_GetFreq(CORE_CLOCK, &core_frequency);
+                    printf("core frequency is: %d\n", core_frequency);
+                }
+                else
+                {
+                    printf("failed when change to STOP2 mode.\n");
+                }
+
+                break;
+            case '6':
+                printf("going to VLPS mode.\n");
+                ret_val = POWER_SYS_SetMode(VLPS, POWER_MANAGER_POLICY_AGREEMENT);
+                if (ret_val == STATUS_SUCCESS)
+                {
+                    printf("now CPU is in VLPS mode.\n");
+                    (void)CLOCK_SYS_GetFreq(CORE_CLOCK, &core_frequency);
+                    printf("core frequency is: %d\n", core_frequency);
+                }
+                else
+                {
+                    printf("failed when change to VLPS mode.\n");
+                }
+
+                break;
+            default:
+                break;
+            }
+            lpuart_lld_data_received_flg = 0U;
+        }
+    }
+}
+
+void freertos_task_1000ms(void *pvParameters)
+{
+    TickType_t last_wake_time = 0U;
+    const TickType_t delay_counter_1000ms = pdMS_TO_TICKS(1000UL);
+    char test_str[] = "hello world\n";
+    uint8_t tx_buf[20];
+    uint32_t print_indicating_counter = 0U;
+    uint32_t can_stats_pos = 0U;
+    can_sched_stats_t can_sched_stats_value;
+    can_timing_t can_timing_value;
+    static can_lld_latency_t can_latency_bus;
+    static can_lld_latency_t can_latency_done;
+    uint64_t can_ts_value;
+#if FREERTOS_QUEUE_TEST_MODE
+    uint32_t counter_sent_by_queue = 0U;
+    uint8_t i = 0U;
+#endif
+#if !LPUART_LLD_RX_BUFFER_ENABLE
+    enum minmea_sentence_id gps_msg_type;
+#endif
+    struct minmea_sentence_rmc gps_rmc_msg;
+
+    (void)pvParameters;
+
+    memcpy(tx_buf, test_str, sizeof(test_str));
+
+    last_wake_time = xTaskGetTickCount();
+
+    while (1)
+    {
+        lptmr_current_value_us = LPTMR_DRV_GetCounterValueByCount(INST_LPTMR1);
+        freertos_counter_1000ms++;
+        wdg_lld_feed_dog();
+        can_stats_step();
+        printf_defer("running time: %ds\n", freertos_counter_1000ms);
+#if LED_TEST_MODE
+        /* test code for LED blink */
+        PINS_DRV_TogglePins(PTD, 1 << 0);
+        PINS_DRV_TogglePins(PTD, 1 << 15);
+        PINS_DRV_TogglePins(PTD, 1 << 16);
+#endif
+#if FREERTOS_QUEUE_TEST_MODE
+        for (i = 0U; i < 9U; i++)
+        {
+            xQueueSend(freertos_queue_test, &counter_sent_by_queue, 0);
+            counter_sent_by_queue++;
+        }
+#endif
+
+        switch (print_indicating_counter)
+        {
+        case 1U:
+            printf("%d. test for ADC:\n", print_indicating_counter);
+            adc_lld_step();
+            break;
+        case 2U:
+            printf("%d. test for RTC:\n", print_indicating_counter);
+            rtc_lld_step();
+            break;
+        case 3U:
+            printf("%d. test for 1ms task:\n", print_indicating_counter);
+            printf("1ms counter is %d, %d times of 1000ms counter.\n",
+                   freertos_counter_1ms, (freertos_counter_1ms / freertos_counter_1000ms));
+            break;
+        case 4U:
+            if (freertos_counter_1ms != 0U)
+            {
+                printf("%d. test for FreeRTOS tick hook.\n", print_indicating_counter);
+                printf("tick number is %d times of 1000ms counter.\n", freertos_counter_tick / freertos_counter_1000ms);
+            }
+            else
+            {
+                /* avoid divider is 0. */
+            }
+            break;
+        case 5U:
+            printf("%d. do some test for FreeRTOS.\n", print_indicating_counter);
+#if LPUART_LLD_RX_BUFFER_ENABLE
+            printf("priority of GPS task: %d\n", uxTaskPriorityGet(freertos_handle_gps));
+#else
+            printf("priority of UART RX task: %d\n", uxTaskPriorityGet(freertos_handle_uart_rx));
+#endif
+            printf("priority of 1ms task: %d\n", uxTaskPriorityGet(freertos_handle_1ms));
+            printf("priority of 1000ms task: %d\n", uxTaskPriorityGet(freertos_handle_1000ms));
+            printf("free heap memory: %d bytes.\n", xPortGetFreeHeapSize());
+            break;
+        case 6U:
+            printf("%d. do some test for lpTmr.\n", print_indicating_counter);
+            lptmr_current_value_us = LPTMR_DRV_GetCounterValueByCount(INST_LPTMR1);
+            printf("1000ms time cost is about: %dus\n", freertos_counter_1000ms_time_cost);
+            if (LPTMR_DRV_GetCompareFlag(INST_LPTMR1))
+            {
+                LPTMR_DRV_ClearCompareFlag(INST_LPTMR1);
+            }
+            else
+            {
+                /* no code */
+            }
+            break;
+        case 7U:
+            printf("%d. test for GPS parese function.\n", print_indicating_counter);
+#if LPUART_LLD_RX_BUFFER_ENABLE
+            printf("GPS sentences: %d, invalid: %d, unknown: %d, too long: %d, overrun: %d\n",
+                   gps_lld_sentence_num, gps_lld_invalid_num, gps_lld_unknown_num,
+                   gps_lld_too_long_num, gps_lld_overrun_num);
+            printf("RMC messages: %d\n", gps_lld_rmc_num);
+            /* the GPS task may update the fix while it is copied */
+            taskENTER_CRITICAL();
+            gps_rmc_msg = gps_lld_rmc_last;
+            taskEXIT_CRITICAL();
+#else
+            gps_msg_type = minmea_sentence_id(rmc_msg_test, false);
+            gps_lld_display_msg_type(gps_msg_type);
+            minmea_parse_rmc(&gps_rmc_msg, rmc_msg_test);
+#endif
+            printf("parse result of RMC message:\n");
+            printf("    1) course is %f\n", (float)gps_rmc_msg.course.value / (float)gps_rmc_msg.course.scale);
+            printf("    2) date and time is %02d-%02d-%02d %02d:%02d:%02d\n",
+                   gps_rmc_msg.date.year, gps_rmc_msg.date.month, gps_rmc_msg.date.day,
+                   gps_rmc_msg.time.hours, gps_rmc_msg.time.minutes, gps_rmc_msg.time.seconds);
+            printf("    3) longitude is %f\n", (float)gps_rmc_msg.longitude.value / (float)gps_rmc_msg.longitude.scale);
+            printf("    4) latitude is %f\n", (float)gps_rmc_msg.latitude.value / (float)gps_rmc_msg.latitude.scale);
+            printf("    5) speed is %f\n", (float)gps_rmc_msg.speed.value / (float)gps_rmc_msg.speed.scale);
+            break;
+        case 8U:
+            printf("%d. test for CAN RX queue.\n", print_indicating_counter);
+            printf("CAN frames: %d, pending: %d, peak: %d\n",
+                   can_lld_rx_frame_num, can_lld_rx_pending(), can_lld_rx_queue_peak);
+            printf("CAN RX queue overflow: %d, RX FIFO overflow: %d\n",
+                   can_lld_rx_queue_overflow_num, can_lld_rx_fifo_overflow_num);
+            break;
+        case 9U:
+            printf("%d. test for CAN TX priority queue.\n", print_indicating_counter);
+            printf("CAN TX frames: %d, complete: %d, pending: %d, peak: %d\n",
+                   can_lld_tx_frame_num, can_lld_tx_complete_num, can_lld_tx_pending(), can_lld_tx_queue_peak);
+            printf("CAN TX queue full: %d, cancel: %d, error: %d\n",
+                   can_lld_tx_queue_full_num, can_lld_tx_cancel_num, can_lld_tx_error_num);
+            break;
+        case 10U:
+            printf("%d. test for CAN ISO-TP.\n", print_indicating_counter);
+            printf("ISO-TP RX messages: %d, errors: %d\n", isotp_rx_msg_num, isotp_rx_error_num);
+            printf("ISO-TP TX messages: %d, errors: %d\n", isotp_tx_msg_num, isotp_tx_error_num);
+            break;
+        case 11U:
+            printf("%d. test for CAN FD.\n", print_indicating_counter);
+            printf("CAN mode: %s, FD frames TX: %d, RX: %d\n", (can_lld_get_mode() == CAN_LLD_MODE_FD) ? "FD" : "classic",
+                   can_lld_tx_fd_frame_num, can_lld_rx_fd_frame_num);
+            break;
+        case 12U:
+            printf("%d. test for CAN RX DMA.\n", print_indicating_counter);
+            printf("RX FIFO DMA: %s, half rings: %d, DMA errors: %d, RX frames: %d\n", can_lld_rx_dma_running() ? "on" : "off",
+                   can_lld_dma_complete_num, can_lld_dma_error_num, can_lld_rx_frame_num);
+            break;
+        case 13U:
+            printf("%d. test for CAN statistics.\n", print_indicating_counter);
+            printf("bus load: %d.%02d%%, peak: %d.%02d%%, IDs: %d, frames: %d\n",
+                   can_stats_bus_load / 100U, can_stats_bus_load % 100U,
+                   can_stats_bus_load_peak / 100U, can_stats_bus_load_peak % 100U,
+                   can_stats_id_num(), can_stats_frame_num);
+#if CAN_STATS_UART_EXPORT_ENABLE
+            /* packet by packet, printf lines of other tasks only go in between */
+            can_stats_export_len = can_stats_export(can_stats_export_buf, sizeof(can_stats_export_buf));
+            for (can_stats_pos = 0U; can_stats_pos < can_stats_export_len;
+                 can_stats_pos += CAN_STATS_PACKET_OVERHEAD + can_stats_export_buf[can_stats_pos + 3U])
+            {
+                (void)lpuart_lld_tx_write(&can_stats_export_buf[can_stats_pos],
+                                          CAN_STATS_PACKET_OVERHEAD + can_stats_export_buf[can_stats_pos + 3U]);
+            }
+#endif
+            break;
+        case 14U:
+            printf("%d. test for CAN bus off recovery.\n", print_indicating_counter);
+            printf("CAN error state: %s, TEC: %d, REC: %d, bus off: %d\n", can_err_state_name(can_err_state),
+                   (CAN0->ECR & CAN_ECR_TXERRCNT_MASK) >> CAN_ECR_TXERRCNT_SHIFT,
+                   (CAN0->ECR & CAN_ECR_RXERRCNT_MASK) >> CAN_ECR_RXERRCNT_SHIFT,
+                   can_err_state_num[CAN_ERR_STATE_BUS_OFF]);
+            printf("recoveries: %d, last: %dus, max: %dus, stale TX frames dropped: %d\n", can_err_recovery_num,
+                   can_err_recovery_last * (1000000U / configTICK_RATE_HZ),
+                   can_err_recovery_max * (1000000U / configTICK_RATE_HZ), can_lld_tx_stale_num);
+            break;
+        case 15U:
+            printf("%d. test for CAN trace.\n", print_indicating_counter);
+            printf("CAN trace state: %d, records: %d, overwritten: %d, triggers: %d\n", can_trace_state,
+                   can_trace_record_num, can_trace_overwritten_num, can_trace_trigger_num);
+            break;
+        case 16U:
+            printf("%d. test for CAN scheduler.\n", print_indicating_counter);
+            printf("CAN scheduler ticks: %d, overruns: %d, bits per tick planned: %d, sent: %d\n", can_sched_tick_num,
+                   can_sched_overrun_num, can_sched_plan_bits_peak, can_sched_tick_bits_peak);
+            printf("bus load of %dms: %d.%02d%%, peak: %d.%02d%%\n", CAN_SCHED_LOAD_WINDOW_MS,
+                   can_sched_load / 100U, can_sched_load % 100U, can_sched_load_peak / 100U, can_sched_load_peak % 100U);
+            if (can_sched_stats(FREERTOS_CAN_SCHED_ECU_STATUS, &can_sched_stats_value))
+            {
+                printf("ECU_Status offset: %dms, frames: %d, errors: %d, period: %d-%dus, late: %dus\n",
+                       can_sched_stats_value.offset_ms, can_sched_stats_value.frame_num, can_sched_stats_value.error_num,
+                       can_sched_stats_value.period_min * (1000000U / configTICK_RATE_HZ),
+                       can_sched_stats_value.period_max * (1000000U / configTICK_RATE_HZ),
+                       can_sched_stats_value.late_max * (1000000U / configTICK_RATE_HZ));
+            }
+            break;
+        case 17U:
+            printf("%d. test for CAN bit timing.\n", print_indicating_counter);
+            printf("CAN bitrate: %d, FD data phase: %d, last autobaud: %d\n", can_lld_get_bitrate(false),
+                   can_lld_get_bitrate(true), freertos_can_autobaud_ret);
+            if (can_timing_solve(CAN_LLD_PE_CLOCK, can_lld_get_bitrate(false), CAN_LLD_SAMPLE_POINT, 0U,
+                                 CAN_TIMING_NOMINAL, &can_timing_value, 1U) != 0U)
+            {
+                printf("best timing: %d tq, sample point %d, oscillator tolerance %dppm\n", can_timing_value.tq,
+                       can_timing_value.sample_point, can_timing_value.tolerance);
+            }
+            break;
+        case 18U:
+            printf("%d. test for CAN time stamps.\n", print_indicating_counter);
+            taskENTER_CRITICAL();
+            can_ts_value = can_ts_now();
+            can_latency_bus = can_lld_tx_latency_bus;
+            can_latency_done = can_lld_tx_latency_done;
+            taskEXIT_CRITICAL();
+            printf("time base: %dms, TX frames: %d\n", (uint32_t)(can_ts_value / 1000U), can_latency_done.num);
+            if (can_latency_done.num != 0U)
+            {
+                printf("can_lld_tx() to bus: %d-%dus, mean %dus\n", can_latency_bus.min_us, can_latency_bus.max_us,
+                       (uint32_t)(can_latency_bus.sum_us / can_latency_bus.num));
+                printf("can_lld_tx() to TX complete: %d-%dus, mean %dus\n", can_latency_done.min_us,
+                       can_latency_done.max_us, (uint32_t)(can_latency_done.sum_us / can_latency_done.num));
+            }
+            break;
+        case 19U:
+            printf("%d. test for CAN log stream.\n", print_indicating_counter);
+            printf("CAN log lines: %d, batches: %d, frames: %d, dropped batches: %d\n", can_log_line_num,
+                   can_log_batch_num, can_log_frame_num, can_log_drop_num);
+            if (can_log_packed_bytes != 0U)
+            {
+                printf("CAN log text: %d bytes, packed: %d bytes, ratio %d.%02d\n", can_log_text_bytes,
+                       can_log_packed_bytes, can_log_text_bytes / can_log_packed_bytes,
+                       ((can_log_text_bytes % can_log_packed_bytes) * 100U) / can_log_packed_bytes);
+            }
+            break;
+        case 20U:
+            printf("%d. test for UDS server.\n", print_indicating_counter);
+            printf("UDS session: %d, requests: %d, negative: %d, pending: %d, refused: %d, S3 timeouts: %d\n",
+                   uds_session, uds_request_num, uds_negative_num, uds_pending_num, uds_refused_num,
+                   uds_s3_timeout_num);
+            printf("UDS response time max: %dus, later than P2: %d\n", uds_response_max_us, uds_p2_miss_num);
+            break;
+        default:
+            print_indicating_counter = 0U;
+            printf("%d-----new test loop started-----\n", print_indicating_counter);
+            break;
+        }
+
+        if (lptmr_current_value_us < LPTMR_DRV_GetCounterValueByCount(INST_LPTMR1))
+        {
+            freertos_counter_1000ms_time_cost = LPTMR_DRV_GetCounterValueByCount(INST_LPTMR1) - lptmr_current_value_us;
+        }
+
+        print_indicating_counter++;
+        vTaskDelayUntil(&last_wake_time, delay_counter_1000ms);
+        SBC_FeedWatchdog();
+    }
+}
+
+void freertos_task_1ms(void *pvParameters)
+{
+    const TickType_t delay_tick_1ms = pdMS_TO_TICKS(1UL);
+    TickType_t last_wake_time = xTaskGetTickCount();
+
+    (void)pvParameters;
+
+    for (;;)
+    {
+        freertos_counter_1ms++;
+        vTaskDelayUntil(&last_wake_time, delay_tick_1ms);
+    }
+}
+
+#if FREERTOS_QUEUE_TEST_MODE
+void freertos_task_trigger_by_queue(void *pvParameters)
+{
+    uint32_t received_data;
+    uint8_t data[] = "deadbeaf\n";
+
+    (void)pvParameters;
+
+    while (1)
+    {
+        xQueueReceive(freertos_queue_test, &received_data, portMAX_DELAY);
+
+        LPUART_DRV_SendDataBlocking(INST_LPUART1, &data[received_data % 9], 1, 100);
+    }
+}
+#endif
+
+void vApplicationIdleHook(void)
+{
+#if FMSTR_DISABLE
+#else
+    static FMSTR_APPCMD_CODE cmd;
+    static FMSTR_APPCMD_PDATA cmdDataP;
+    static FMSTR_SIZE cmdSize;
+
+    value_sin_x += 0.0001;
+    value_sin_y = sin(value_sin_x);
+
+    /* Process FreeMASTER application commands */
+    cmd = FMSTR_GetAppCmd();
+    if (cmd != FMSTR_APPCMDRESULT_NOCMD)
+    {
+        cmdDataP = FMSTR_GetAppCmdData(&cmdSize);
+        switch (cmd)
+        {
+        case 0:
+            /* Acknowledge the command */
+            FMSTR_AppCmdAck(0);
+            break;
+        case 1:
+            /* Acknowledge the command */
+            FMSTR_AppCmdAck(0);
+            break;
+        case 2:
+            /* Acknowledge the command */
+            FMSTR_AppCmdAck(0);
+            break;
+        case 3:
+            /* Acknowledge the command */
+            FMSTR_AppCmdAck(0);
+            break;
+        case 4:
+            /* CAN statistics snapshot into can_stats_export_buf */
+            can_stats_export_len = can_stats_export(can_stats_export_buf, sizeof(can_stats_export_buf));
+            FMSTR_AppCmdAck(0);
+            break;
+        case 5:
+            /* fire the CAN trace trigger, freertos_task_100ms sends the trace */
+            can_trace_trigger();
+            FMSTR_AppCmdAck(0);
+            break;
+        case 6:
+            /* look for the bitrate of the bus, run by freertos_task_100ms */
+            freertos_can_autobaud_request = true;
+            FMSTR_AppCmdAck(0);
+            break;
+        default:
+            /* Acknowledge the command with failure */
+            FMSTR_AppCmdAck(1);
+            break;
+        }
+    }
+
+    /* Handle the protocol decoding and execution */
+    FMSTR_Poll();
+
+    (void)cmdDataP;
+#endif
+}
+
+void vApplicationTickHook(void)
+{
+    freertos_counter_tick++;
+}
+
+void vApplicationDaemonTaskStartupHook(void)
+{
+    printf("FreeRTOS daemon task started.\n");
+    if (power_mode_init_ret_val != STATUS_SUCCESS)
+    {
+        printf("failed to change RUN mode.\n");
+    }
+    can_lld_init();
+    (void)can_sched_init(freertos_can_sched_table,
+                         sizeof(freertos_can_sched_table) / sizeof(freertos_can_sched_table[0]));
+    uds_init(&freertos_uds_config);
+}
+
+/* 31 01 0200: 71 01 0200 */
+static uint8_t freertos_uds_trace_start(const uint8_t *option, uint32_t len, uint8_t *status, uint32_t *status_len,
+                                        bool first)
+{
+    (void)option;
+    (void)status;
+    (void)first;
+
+    if (len != 0U)
+    {
+        return UDS_NRC_IMLOIF;
+    }
+    can_trace_trigger();
+    *status_len = 0U;
+    return UDS_NRC_OK;
+}
+
+/* 31 03 0200: 71 03 0200 state records(4) */
+static uint8_t freertos_uds_trace_results(const uint8_t *option, uint32_t len, uint8_t *status,
+                                          uint32_t *status_len, bool first)
+{
+    (void)option;
+    (void)first;
+
+    if (len != 0U)
+    {
+        return UDS_NRC_IMLOIF;
+    }
+    status[0] = (uint8_t)can_trace_state;
+    status[1] = (uint8_t)(can_trace_record_num >> 24U);
+    status[2] = (uint8_t)(can_trace_record_num >> 16U);
+    status[3] = (uint8_t)(can_trace_record_num >> 8U);
+    status[4] = (uint8_t)can_trace_record_num;
+    *status_len = 5U;
+    return UDS_NRC_OK;
+}
+
+/* 31 01 0201 ms(2): 71 01 0201 frames(4), after ms */
+static uint8_t freertos_uds_count_start(const uint8_t *option, uint32_t len, uint8_t *status, uint32_t *status_len,
+                                        bool first)
+{
+    uint32_t ms;
+
+    if (first)
+    {
+        if (len != 2U)
+        {
+            return UDS_NRC_IMLOIF;
+        }
+        ms = ((uint32_t)option[0] << 8U) | option[1];
+        if ((ms == 0U) || (ms > FREERTOS_UDS_COUNT_MS_MAX))
+        {
+            return UDS_NRC_ROOR;
+        }
+        freertos_uds_count_end = xTaskGetTickCount() + pdMS_TO_TICKS(ms);
+        freertos_uds_count_first = can_lld_rx_frame_num;
+        return UDS_NRC_PENDING;
+    }
+    if ((TickType_t)(freertos_uds_count_end - xTaskGetTickCount()) < (portMAX_DELAY / 2U))
+    {
+        return UDS_NRC_PENDING;
+    }
+    freertos_uds_count_frames = can_lld_rx_frame_num - freertos_uds_count_first;
+    freertos_uds_count_valid = true;
+    return freertos_uds_count_results(option, 0U, status, status_len, true);
+}
+
+/* 31 03 0201: 71 03 0201 frames(4) of the last count */
+static uint8_t freertos_uds_count_results(const uint8_t *option, uint32_t len, uint8_t *status,
+                                          uint32_t *status_len, bool first)
+{
+    (void)option;
+    (void)first;
+
+    if (len != 0U)
+    {
+        return UDS_NRC_IMLOIF;
+    }
+    if (!freertos_uds_count_valid)
+    {
+        return UDS_NRC_RSE;
+    }
+    status[0] = (uint8_t)(freertos_uds_count_frames >> 24U);
+    status[1] = (uint8_t)(freertos_uds_count_frames >> 16U);
+    status[2] = (uint8_t)(freertos_uds_count_frames >> 8U);
+    status[3] = (uint8_t)freertos_uds_count_frames;
+    *status_len = 4U;
+    return UDS_NRC_OK;
+}
@@ -0,0 +1,765 @@
+/* UDS tester for the server of uds.c, on the board or host/uds_ecu. It has
+ * an ISO-TP client of its own on a raw CAN socket, so it checks the ISO-TP
+ * of the server too.
+ *
+ * A script is one request per line and the response it must bring:
+ *   22 F186 -> 62 F186 01          physical request on 0x7E0
+ *   f 3E 00 -> 7E 00               functional request on 0x7DF
+ *   3E 80 -> none                  no response within P2
+ *   31 01 0201 0064 -> pending 71 01 0201 ...
+ *                                  response pending (0x78) first, then this
+ *   22 0300 -> 62 0300 * * * *     * is any byte, ... any bytes to the end
+ *   save addr 3 4                  bytes 3-6 of the last response, $addr in a
+ *                                  request puts them in
+ *   wait 5200                      ms, for the S3 timer
+ * Bytes are hex, "F186" is two of them, # starts a comment. The first
+ * response to every request must come within P2, the next ones within P2*
+ * after a response pending.
+ *
+ * With -b N the script is not read: TesterPresent, ReadDataByIdentifier of
+ * one and of nine DIDs (a multi-frame response) and WriteDataByIdentifier of
+ * 17 bytes (a multi-frame request) go N times each, and the response times
+ * are printed, from the last frame of the request to the last of the
+ * response.
+ *
+ * build: gcc -O2 -Wall -o uds_tester uds_tester.c
+ * usage: uds_tester [-i ifname] [-b N] [script]
+ */
+#include <errno.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+
+/* as in uds.h */
+#define UDS_PHYS_ID 0x7E0U
+#define UDS_FUNC_ID 0x7DFU
+#define UDS_RESP_ID 0x7E8U
+#define UDS_BUF_SIZE 512U
+#define UDS_P2_MS 50U
+#define UDS_P2_STAR_MS 5000U
+#define UDS_NRC_PENDING 0x78U
+/* as in isotp.h */
+#define ISOTP_PADDING_BYTE 0xCCU
+#define ISOTP_TIMEOUT_MS 1000U
+
+/* the tester waits this much longer than the server has, for the bus */
+#define TESTER_MARGIN_MS 50U
+#define TESTER_SAVE_NUM 8U
+#define TESTER_LINE_SIZE 4096U
+
+#define TESTER_CHECK(cond, ...)                                 \
+    do                                                          \
+    {                                                           \
+        tester_checks++;                                        \
+        if (!(cond))                                            \
+        {                                                       \
+            tester_errors++;                                    \
+            fprintf(stderr, "line %u: ", tester_line);          \
+            fprintf(stderr, __VA_ARGS__);                       \
+            fputc('\n', stderr);                                \
+        }                                                       \
+    } while (0)
+
+typedef struct
+{
+    int32_t len;            /* final response, -1 for none */
+    uint32_t pending;       /* response pending before it */
+    uint64_t first_us;      /* last frame of the request to the first frame
+                             * of the first response */
+    uint64_t total_us;      /* to the last frame of the final response */
+    uint64_t gap_max_us;    /* longest wait after a response pending */
+    uint8_t data[UDS_BUF_SIZE];
+} tester_result_t;
+
+typedef struct
+{
+    char name[32];
+    uint8_t data[16];
+    uint32_t len;
+} tester_save_t;
+
+static int tester_fd = -1;
+static uint32_t tester_checks = 0U;
+static uint32_t tester_errors = 0U;
+static uint32_t tester_line = 0U;
+static tester_save_t tester_saves[TESTER_SAVE_NUM];
+static tester_result_t tester_last;
+
+static uint64_t tester_now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000U) + ((uint64_t)ts.tv_nsec / 1000U);
+}
+
+static void tester_sleep_us(uint64_t us)
+{
+    struct timespec ts;
+
+    ts.tv_sec = (time_t)(us / 1000000U);
+    ts.tv_nsec = (long)((us % 1000000U) * 1000U);
+    while ((nanosleep(&ts, &ts) != 0) && (errno == EINTR))
+    {
+    }
+}
+
+static int tester_open(const char *ifname)
+{
+    struct sockaddr_can addr;
+    struct can_filter filter;
+    struct ifreq ifr;
+
+    tester_fd = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (tester_fd < 0)
+    {
+        perror("socket");
+        return -1;
+    }
+    memset(&ifr, 0, sizeof(ifr));
+    snprintf(ifr.ifr_name, sizeof(ifr.ifr_name), "%s", ifname);
+    if (ioctl(tester_fd, SIOCGIFINDEX, &ifr) < 0)
+    {
+        perror(ifname);
+        return -1;
+    }
+    filter.can_id = UDS_RESP_ID;
+    filter.can_mask = CAN_SFF_MASK | CAN_EFF_FLAG | CAN_RTR_FLAG;
+    (void)setsockopt(tester_fd, SOL_CAN_RAW, CAN_RAW_FILTER, &filter, sizeof(filter));
+    memset(&addr, 0, sizeof(addr));
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = ifr.ifr_ifindex;
+    if (bind(tester_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        perror("bind");
+        return -1;
+    }
+    return 0;
+}
+
+/* @brief: Send one frame, padded to 8 bytes
+ * @param id   : CAN ID
+ * @param data : frame data
+ * @param len  : 1-8
+ * @return     : 0, -1 on error
+ */
+static int tester_tx_frame(uint32_t id, const uint8_t *data, uint32_t len)
+{
+    struct can_frame frame;
+
+    memset(&frame, 0, sizeof(frame));
+    frame.can_id = id;
+    frame.can_dlc = 8U;
+    memset(frame.data, ISOTP_PADDING_BYTE, sizeof(frame.data));
+    memcpy(frame.data, data, len);
+    if (write(tester_fd, &frame, sizeof(frame)) != (ssize_t)sizeof(frame))
+    {
+        perror("write");
+        return -1;
+    }
+    return 0;
+}
+
+/* @brief: Wait for a frame of UDS_RESP_ID
+ * @param deadline : tester_now_us() to give up at
+ * @param data     : 8 bytes for the frame data
+ * @return         : frame length, -1 at the deadline
+ */
+static int tester_rx_frame(uint64_t deadline, uint8_t *data)
+{
+    struct pollfd pfd;
+    struct can_frame frame;
+    uint64_t now;
+    ssize_t n;
+
+    for (;;)
+    {
+        now = tester_now_us();
+        if (now >= deadline)
+        {
+            return -1;
+        }
+        pfd.fd = tester_fd;
+        pfd.events = POLLIN;
+        if (poll(&pfd, 1, (int)((deadline - now + 999U) / 1000U)) <= 0)
+        {
+            continue;
+        }
+        n = read(tester_fd, &frame, sizeof(frame));
+        /* the filter of a vcan socket may let others through */
+        if ((n == (ssize_t)sizeof(frame)) && (frame.can_id == UDS_RESP_ID))
+        {
+            memcpy(data, frame.data, 8U);
+            return frame.can_dlc;
+        }
+    }
+}
+
+/* late frames of a request given up on would be taken for the next one */
+static void tester_flush(void)
+{
+    struct pollfd pfd;
+    struct can_frame frame;
+
+    pfd.fd = tester_fd;
+    pfd.events = POLLIN;
+    while ((poll(&pfd, 1, 0) > 0) && (read(tester_fd, &frame, sizeof(frame)) >= 0))
+    {
+    }
+}
+
+/* @brief: ISO-TP send, a single frame or first frame, flow control and
+ *         consecutive frames
+ * @param id   : UDS_PHYS_ID or UDS_FUNC_ID
+ * @param data : message
+ * @param len  : message length, more than 7 only physical
+ * @return     : 0, -1 on error
+ */
+static int tester_isotp_send(uint32_t id, const uint8_t *data, uint32_t len)
+{
+    uint8_t frame[8];
+    uint8_t fc[8];
+    uint32_t pos;
+    uint32_t n;
+    uint32_t block = 0U;
+    uint32_t bs = 0U;
+    uint64_t st_us = 0U;
+    uint8_t sn = 1U;
+
+    if (len <= 7U)
+    {
+        frame[0] = (uint8_t)len;
+        memcpy(&frame[1], data, len);
+        return tester_tx_frame(id, frame, len + 1U);
+    }
+    frame[0] = (uint8_t)(0x10U | (len >> 8U));
+    frame[1] = (uint8_t)len;
+    memcpy(&frame[2], data, 6U);
+    if (tester_tx_frame(id, frame, 8U) != 0)
+    {
+        return -1;
+    }
+    for (pos = 6U; pos < len; pos += n)
+    {
+        if (block == 0U)
+        {
+            /* flow control, FC.WAIT keeps us waiting */
+            do
+            {
+                if ((tester_rx_frame(tester_now_us() + (ISOTP_TIMEOUT_MS * 1000U), fc) < 3) ||
+                    ((fc[0] & 0xF0U) != 0x30U))
+                {
+                    fprintf(stderr, "no flow control\n");
+                    return -1;
+                }
+            } while ((fc[0] & 0x0FU) == 1U);
+            if ((fc[0] & 0x0FU) != 0U)
+            {
+                fprintf(stderr, "flow control overflow\n");
+                return -1;
+            }
+            bs = fc[1];
+            st_us = (fc[2] <= 0x7FU) ? ((uint64_t)fc[2] * 1000U) :
+                    (((fc[2] >= 0xF1U) && (fc[2] <= 0xF9U)) ? ((uint64_t)(fc[2] - 0xF0U) * 100U) : 127000U);
+            block = (bs == 0U) ? UINT32_MAX : bs;
+        }
+        else if (st_us != 0U)
+        {
+            tester_sleep_us(st_us);
+        }
+        n = ((len - pos) < 7U) ? (len - pos) : 7U;
+        frame[0] = (uint8_t)(0x20U | sn);
+        memcpy(&frame[1], &data[pos], n);
+        if (tester_tx_frame(id, frame, n + 1U) != 0)
+        {
+            return -1;
+        }
+        sn = (uint8_t)((sn + 1U) & 0x0FU);
+        block--;
+    }
+    return 0;
+}
+
+/* @brief: ISO-TP receive of one response
+ * @param deadline : tester_now_us() the first frame must come by
+ * @param data     : UDS_BUF_SIZE bytes for the message
+ * @param first_us : time of the first frame
+ * @return         : message length, -1 at the deadline, -2 on an ISO-TP
+ *                   error
+ */
+static int32_t tester_isotp_recv(uint64_t deadline, uint8_t *data, uint64_t *first_us)
+{
+    static const uint8_t fc[3] = {0x30U, 0x00U, 0x00U};
+    uint8_t frame[8];
+    uint32_t len;
+    uint32_t pos;
+    uint32_t n;
+    uint8_t sn = 1U;
+    int dlc;
+
+    for (;;)
+    {
+        dlc = tester_rx_frame(deadline, frame);
+        if (dlc < 0)
+        {
+            return -1;
+        }
+        *first_us = tester_now_us();
+        if ((frame[0] & 0xF0U) == 0x00U)
+        {
+            len = frame[0] & 0x0FU;
+            if ((len == 0U) || (len > 7U) || ((int)len >= dlc))
+            {
+                return -2;
+            }
+            memcpy(data, &frame[1], len);
+            return (int32_t)len;
+        }
+        if ((frame[0] & 0xF0U) == 0x10U)
+        {
+            break;
+        }
+        /* flow control or consecutive frames of nothing we wait for */
+    }
+    len = ((uint32_t)(frame[0] & 0x0FU) << 8U) | frame[1];
+    if ((len < 8U) || (len > UDS_BUF_SIZE) || (dlc < 8))
+    {
+        return -2;
+    }
+    memcpy(data, &frame[2], 6U);
+    if (tester_tx_frame(UDS_PHYS_ID, fc, sizeof(fc)) != 0)
+    {
+        return -2;
+    }
+    for (pos = 6U; pos < len; pos += n)
+    {
+        dlc = tester_rx_frame(tester_now_us() + (ISOTP_TIMEOUT_MS * 1000U), frame);
+        if (dlc < 0)
+        {
+            fprintf(stderr, "consecutive frame timeout\n");
+            return -2;
+        }
+        if (frame[0] != (0x20U | sn))
+        {
+            fprintf(stderr, "consecutive frame 0x%02X, SN %u expected\n", frame[0], sn);
+            return -2;
+        }
+        n = ((len - pos) < 7U) ? (len - pos) : 7U;
+        memcpy(&data[pos], &frame[1], n);
+        sn = (uint8_t)((sn + 1U) & 0x0FU);
+    }
+    return (int32_t)len;
+}
+
+/* @brief: One request and its responses up to the final one, P2 for the
+ *         first and P2* after a response pending
+ * @param func   : functional request
+ * @param req    : request
+ * @param len    : request length
+ * @param result : the responses
+ * @return       : 0, -1 on an ISO-TP error
+ */
+static int tester_request(int func, const uint8_t *req, uint32_t len, tester_result_t *result)
+{
+    uint64_t sent;
+    uint64_t last;
+    uint64_t first;
+    uint64_t timeout = (UDS_P2_MS + TESTER_MARGIN_MS) * 1000U;
+    int32_t n;
+
+    memset(result, 0, sizeof(*result));
+    result->len = -1;
+    tester_flush();
+    if (tester_isotp_send(func ? UDS_FUNC_ID : UDS_PHYS_ID, req, len) != 0)
+    {
+        return -1;
+    }
+    sent = tester_now_us();
+    last = sent;
+    for (;;)
+    {
+        n = tester_isotp_recv(last + timeout, result->data, &first);
+        if (n == -2)
+        {
+            return -1;
+        }
+        if (n < 0)
+        {
+            return 0;
+        }
+        if ((result->pending == 0U) && (result->len < 0))
+        {
+            result->first_us = first - sent;
+        }
+        if ((first - last) > result->gap_max_us)
+        {
+            result->gap_max_us = first - last;
+        }
+        last = tester_now_us();
+        if ((n == 3) && (result->data[0] == 0x7FU) && (result->data[1] == req[0]) &&
+            (result->data[2] == UDS_NRC_PENDING))
+        {
+            result->pending++;
+            timeout = (UDS_P2_STAR_MS + TESTER_MARGIN_MS) * 1000U;
+            continue;
+        }
+        result->len = n;
+        result->total_us = last - sent;
+        return 0;
+    }
+}
+
+/* @brief: Hex bytes and $names of a script into bytes
+ * @param text : tokens up to the end of the string
+ * @param out  : the bytes
+ * @param max  : room in out
+ * @param mask : NULL, or 1 for each byte of out which has to match: * puts a
+ *               0 there, ... ends the bytes with -2 - number of them
+ * @return     : number of bytes, -1 on a syntax error
+ */
+static int32_t tester_parse(char *text, uint8_t *out, uint32_t max, uint8_t *mask)
+{
+    char *tok;
+    char *save = NULL;
+    uint32_t n = 0U;
+    uint32_t i;
+    size_t len;
+    unsigned int byte;
+
+    for (tok = strtok_r(text, " \t\r\n", &save); tok != NULL; tok = strtok_r(NULL, " \t\r\n", &save))
+    {
+        if ((mask != NULL) && (strcmp(tok, "...") == 0))
+        {
+            return -2 - (int32_t)n;
+        }
+        if ((mask != NULL) && (strcmp(tok, "*") == 0))
+        {
+            if (n >= max)
+            {
+                return -1;
+            }
+            mask[n] = 0U;
+            out[n++] = 0U;
+            continue;
+        }
+        if (tok[0] == '$')
+        {
+            for (i = 0U; (i < TESTER_SAVE_NUM) && (strcmp(tester_saves[i].name, &tok[1]) != 0); i++)
+            {
+            }
+            if ((i == TESTER_SAVE_NUM) || ((n + tester_saves[i].len) > max))
+            {
+                return -1;
+            }
+            memcpy(&out[n], tester_saves[i].data, tester_saves[i].len);
+            n += tester_saves[i].len;
+            continue;
+        }
+        len = strlen(tok);
+        if ((len % 2U) != 0U)
+        {
+            return -1;
+        }
+        for (i = 0U; i < len; i += 2U)
+        {
+            if ((n >= max) || (sscanf(&tok[i], "%2x", &byte) != 1))
+            {
+                return -1;
+            }
+            if (mask != NULL)
+            {
+                mask[n] = 1U;
+            }
+            out[n++] = (uint8_t)byte;
+        }
+    }
+    return (int32_t)n;
+}
+
+static void tester_print(const char *what, const uint8_t *data, int32_t len)
+{
+    int32_t i;
+
+    fprintf(stderr, "  %s:", what);
+    if (len < 0)
+    {
+        fprintf(stderr, " none");
+    }
+    for (i = 0; (i < len) && (i < 24); i++)
+    {
+        fprintf(stderr, " %02X", data[i]);
+    }
+    fprintf(stderr, "%s\n", (len > 24) ? " .." : "");
+}
+
+/* @brief: One line of a script, see the top of the file
+ * @param text : the line
+ * @return     : 0, -1 to stop
+ */
+static int tester_script_line(char *text)
+{
+    static uint8_t req[UDS_BUF_SIZE];
+    static uint8_t expect[UDS_BUF_SIZE];
+    static uint8_t mask[UDS_BUF_SIZE];
+    tester_result_t *res = &tester_last;
+    char *arrow;
+    char *p;
+    char name[32];
+    unsigned int off;
+    unsigned int len;
+    unsigned int ms;
+    int32_t req_len;
+    int32_t exp_len;
+    int32_t i;
+    int func = 0;
+    int none = 0;
+    int pending = 0;
+    int open = 0;
+
+    if ((p = strchr(text, '#')) != NULL)
+    {
+        *p = '\0';
+    }
+    p = text + strspn(text, " \t\r\n");
+    if (*p == '\0')
+    {
+        return 0;
+    }
+    if (sscanf(p, "wait %u", &ms) == 1)
+    {
+        tester_sleep_us((uint64_t)ms * 1000U);
+        return 0;
+    }
+    if (sscanf(p, "save %31s %u %u", name, &off, &len) == 3)
+    {
+        TESTER_CHECK((res->len >= 0) && ((off + len) <= (unsigned int)res->len) && (len <= 16U),
+                     "save %s: bytes %u-%u not in the last response", name, off, off + len - 1U);
+        for (i = 0; (i < (int32_t)TESTER_SAVE_NUM) && (tester_saves[i].name[0] != '\0') &&
+             (strcmp(tester_saves[i].name, name) != 0); i++)
+        {
+        }
+        if ((i < (int32_t)TESTER_SAVE_NUM) && (res->len >= 0) && ((off + len) <= (unsigned int)res->len) &&
+            (len <= 16U))
+        {
+            snprintf(tester_saves[i].name, sizeof(tester_saves[i].name), "%s", name);
+            memcpy(tester_saves[i].data, &res->data[off], len);
+            tester_saves[i].len = len;
+        }
+        return 0;
+    }
+
+    arrow = strstr(p, "->");
+    if (arrow == NULL)
+    {
+        fprintf(stderr, "line %u: no ->\n", tester_line);
+        return -1;
+    }
+    *arrow = '\0';
+    arrow += 2;
+    if ((p[0] == 'f') && ((p[1] == ' ') || (p[1] == '\t')))
+    {
+        func = 1;
+        p += 2;
+    }
+    arrow += strspn(arrow, " \t");
+    if (strncmp(arrow, "none", 4U) == 0)
+    {
+        none = 1;
+        arrow += 4;
+    }
+    else if (strncmp(arrow, "pending", 7U) == 0)
+    {
+        pending = 1;
+        arrow += 7;
+    }
+    req_len = tester_parse(p, req, sizeof(req), NULL);
+    exp_len = tester_parse(arrow, expect, sizeof(expect), mask);
+    if (exp_len <= -2)
+    {
+        open = 1;
+        exp_len = -2 - exp_len;
+    }
+    if ((req_len <= 0) || (exp_len < 0) || (func && (req_len > 7)))
+    {
+        fprintf(stderr, "line %u: syntax\n", tester_line);
+        return -1;
+    }
+
+    if (tester_request(func, req, (uint32_t)req_len, res) != 0)
+    {
+        TESTER_CHECK(0, "ISO-TP error");
+        return 0;
+    }
+    if (none)
+    {
+        TESTER_CHECK((res->len < 0) && (res->pending == 0U), "a response where none may come");
+        return 0;
+    }
+    TESTER_CHECK(res->len >= 0, "no response");
+    TESTER_CHECK(res->first_us <= (UDS_P2_MS * 1000U), "first response after %lu us, P2 is %u ms",
+                 (unsigned long)res->first_us, UDS_P2_MS);
+    TESTER_CHECK(pending ? (res->pending > 0U) : (res->pending == 0U), "%u responses pending", res->pending);
+    TESTER_CHECK(res->gap_max_us <= ((UDS_P2_STAR_MS + TESTER_MARGIN_MS) * 1000U), "P2* overrun");
+    if (res->len < 0)
+    {
+        return 0;
+    }
+    for (i = 0; (i < exp_len) && (i < res->len) && ((mask[i] == 0U) || (res->data[i] == expect[i])); i++)
+    {
+    }
+    if ((i != exp_len) || (open ? (res->len < exp_len) : (res->len != exp_len)))
+    {
+        TESTER_CHECK(0, "response does not match");
+        tester_print("expected", expect, exp_len);
+        tester_print("received", res->data, res->len);
+    }
+    else
+    {
+        tester_checks++;
+    }
+    return 0;
+}
+
+static int tester_script(const char *path)
+{
+    char line[TESTER_LINE_SIZE];
+    FILE *f = (path != NULL) ? fopen(path, "r") : stdin;
+
+    if (f == NULL)
+    {
+        perror(path);
+        return 2;
+    }
+    while (fgets(line, sizeof(line), f) != NULL)
+    {
+        tester_line++;
+        if (tester_script_line(line) != 0)
+        {
+            tester_errors++;
+            break;
+        }
+    }
+    if (f != stdin)
+    {
+        fclose(f);
+    }
+    printf("%s, %u checks, %u errors\n", (tester_errors == 0U) ? "PASS" : "FAIL", tester_checks, tester_errors);
+    return (tester_errors == 0U) ? 0 : 1;
+}
+
+static int tester_cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+/* @brief: n requests, the response times and the errors
+ * @param name : printed
+ * @param req  : request, answered with the positive response
+ * @param len  : request length
+ * @param n    : number of requests
+ * @param us   : room for n response times
+ * @return     : None
+ */
+static void tester_bench_one(const char *name, const uint8_t *req, uint32_t len, uint32_t n, uint64_t *us)
+{
+    tester_result_t res;
+    uint64_t sum = 0U;
+    uint32_t ok = 0U;
+    uint32_t rsp_len = 0U;
+    uint32_t i;
+
+    for (i = 0U; i < n; i++)
+    {
+        tester_checks++;
+        if ((tester_request(0, req, len, &res) != 0) || (res.len <= 0) || (res.data[0] != (req[0] + 0x40U)) ||
+            (res.pending != 0U))
+        {
+            tester_errors++;
+            continue;
+        }
+        us[ok++] = res.total_us;
+        sum += res.total_us;
+        rsp_len = (uint32_t)res.len;
+    }
+    if (ok == 0U)
+    {
+        printf("%-22s all %u failed\n", name, n);
+        return;
+    }
+    qsort(us, ok, sizeof(us[0]), tester_cmp_u64);
+    printf("%-22s %3u/%3u bytes  min %6lu  mean %6lu  p99 %6lu  max %6lu us, %u failed\n", name, len, rsp_len,
+           (unsigned long)us[0], (unsigned long)(sum / ok), (unsigned long)us[((uint64_t)ok * 99U) / 100U],
+           (unsigned long)us[ok - 1U], n - ok);
+}
+
+static int tester_bench(uint32_t n)
+{
+    static const uint8_t extended[] = {0x10U, 0x03U};
+    static const uint8_t tp[] = {0x3EU, 0x00U};
+    static const uint8_t rdbi_one[] = {0x22U, 0xF1U, 0x86U};
+    static const uint8_t rdbi_nine[] = {0x22U, 0xF1U, 0x86U, 0x02U, 0x00U, 0x02U, 0x01U, 0x02U, 0x02U, 0x02U, 0x03U,
+                                        0x02U, 0x04U, 0x02U, 0x05U, 0x02U, 0x06U, 0x03U, 0x00U};
+    static const uint8_t wdbi[] = {0x2EU, 0xF1U, 0x90U, 'W', 'S', '3', '2', 'K', '1', '4', '4', 'U', 'D', 'S',
+                                   'B', 'E', 'N', 'C', 'H', '1'};
+    tester_result_t res;
+    uint64_t *us = malloc(sizeof(uint64_t) * n);
+
+    if (us == NULL)
+    {
+        return 2;
+    }
+    /* WriteDataByIdentifier of 0xF190 only in the extended session */
+    if ((tester_request(0, extended, sizeof(extended), &res) != 0) || (res.len != 6))
+    {
+        fprintf(stderr, "no extended session\n");
+        free(us);
+        return 1;
+    }
+    tester_bench_one("TesterPresent", tp, sizeof(tp), n, us);
+    tester_bench_one("RDBI 1 DID", rdbi_one, sizeof(rdbi_one), n, us);
+    tester_bench_one("RDBI 9 DIDs", rdbi_nine, sizeof(rdbi_nine), n, us);
+    tester_bench_one("WDBI 17 bytes", wdbi, sizeof(wdbi), n, us);
+    free(us);
+    printf("%s, %u checks, %u errors\n", (tester_errors == 0U) ? "PASS" : "FAIL", tester_checks, tester_errors);
+    return (tester_errors == 0U) ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+    const char *ifname = "vcan0";
+    uint32_t bench = 0U;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "i:b:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'i':
+            ifname = optarg;
+            break;
+        case 'b':
+            bench = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-i ifname] [-b N] [script]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (tester_open(ifname) != 0)
+    {
+        return 2;
+    }
+    return (bench != 0U) ? tester_bench(bench) : tester_script((optind < argc) ? argv[optind] : NULL);
+}
@@ -0,0 +1,636 @@
+#include "uds.h"
+#include "string.h"
+
+#define UDS_TICK_US (1000000U / configTICK_RATE_HZ)
+
+typedef enum
+{
+    UDS_IDLE = 0,
+    UDS_RECEIVING,      /* uds_isotp_rx_buf() gave out the request buffer */
+    UDS_RECEIVED,       /* for freertos_task_uds */
+    UDS_PENDING,        /* the service returned UDS_NRC_PENDING */
+    UDS_SEND_WAIT,      /* response ready, ISO-TP still sends a response pending */
+    UDS_SENDING         /* response with ISO-TP until uds_isotp_tx_done() */
+} uds_state_t;
+
+uint8_t uds_session = UDS_SESSION_DEFAULT;
+uint32_t uds_request_num = 0U;
+uint32_t uds_negative_num = 0U;
+uint32_t uds_pending_num = 0U;
+uint32_t uds_refused_num = 0U;
+uint32_t uds_s3_timeout_num = 0U;
+uint32_t uds_response_max_us = 0U;
+uint32_t uds_p2_miss_num = 0U;
+
+static const uds_config_t *uds_config = NULL;
+static TaskHandle_t uds_task = NULL;
+static volatile uds_state_t uds_state = UDS_IDLE;
+
+static uint8_t uds_req[UDS_BUF_SIZE];
+static uint32_t uds_req_len;
+static bool uds_req_func;
+/* request complete, the P2 timer starts here */
+static TickType_t uds_req_tick;
+static uint8_t uds_rsp[UDS_BUF_SIZE];
+static uint32_t uds_rsp_len;
+static uint8_t uds_rsp_pending[3];
+/* a response went out for the request, pending or final */
+static bool uds_responded;
+static TickType_t uds_next_pending;
+static TickType_t uds_next_poll;
+/* S3 runs from here while the server is idle */
+static TickType_t uds_idle_tick;
+
+static void uds_run(TickType_t now);
+static uint8_t uds_serve(bool first);
+static uint8_t uds_dsc(void);
+static uint8_t uds_tp(void);
+static uint8_t uds_rdbi(void);
+static uint8_t uds_wdbi(void);
+static uint8_t uds_rmba(void);
+static uint8_t uds_rc(bool first);
+static const uds_did_t *uds_find_did(uint16_t did);
+static void uds_finish(uint8_t nrc, TickType_t now);
+static void uds_send(TickType_t now);
+static void uds_send_pending(TickType_t now);
+static void uds_responded_at(TickType_t now);
+static void uds_idle(TickType_t now);
+static TickType_t uds_timeout(TickType_t now);
+static bool uds_expired(TickType_t now, TickType_t deadline);
+
+/* @brief: Start the server in the default session
+ * @param config : tables of the application, kept
+ * @return       : None
+ */
+void uds_init(const uds_config_t *config)
+{
+    uds_config = config;
+    uds_session = UDS_SESSION_DEFAULT;
+    uds_idle_tick = xTaskGetTickCount();
+    uds_state = UDS_IDLE;
+}
+
+/* @brief: ISO-TP asks for the buffer of a request, freertos_task_can_rx
+ * @param channel : UDS_ISOTP_CHANNEL or UDS_ISOTP_FUNC_CHANNEL
+ * @param len     : request length
+ * @return        : request buffer, NULL while the last request is served or
+ *                  for a functional request of more than one frame
+ */
+uint8_t *uds_isotp_rx_buf(uint8_t channel, uint32_t len)
+{
+    uint8_t *buf = NULL;
+
+    if ((uds_config == NULL) || (len > UDS_BUF_SIZE) || ((channel == UDS_ISOTP_FUNC_CHANNEL) && (len > 7U)))
+    {
+        uds_refused_num++;
+        return NULL;
+    }
+    taskENTER_CRITICAL();
+    if (uds_state == UDS_IDLE)
+    {
+        uds_state = UDS_RECEIVING;
+        buf = uds_req;
+    }
+    taskEXIT_CRITICAL();
+    if (buf == NULL)
+    {
+        uds_refused_num++;
+    }
+    return buf;
+}
+
+/* @brief: A request is complete or failed, freertos_task_can_rx
+ * @param channel : UDS_ISOTP_CHANNEL or UDS_ISOTP_FUNC_CHANNEL
+ * @param data    : uds_req
+ * @param len     : request length
+ * @param result  : ISO-TP result
+ * @return        : None
+ */
+void uds_isotp_rx_done(uint8_t channel, uint8_t *data, uint32_t len, isotp_result_t result)
+{
+    TaskHandle_t task;
+
+    (void)data;
+    if (result != ISOTP_RESULT_OK)
+    {
+        uds_state = UDS_IDLE;
+        return;
+    }
+    uds_req_len = len;
+    uds_req_func = (channel == UDS_ISOTP_FUNC_CHANNEL);
+    uds_req_tick = xTaskGetTickCount();
+    uds_state = UDS_RECEIVED;
+    task = __atomic_load_n(&uds_task, __ATOMIC_SEQ_CST);
+    if (task != NULL)
+    {
+        (void)xTaskNotifyGive(task);
+    }
+}
+
+/* @brief: ISO-TP is done with a response, freertos_task_can_rx
+ * @param channel : UDS_ISOTP_CHANNEL
+ * @param data    : the response sent
+ * @param result  : ISO-TP result, a response lost is not sent again
+ * @return        : None
+ */
+void uds_isotp_tx_done(uint8_t channel, const uint8_t *data, isotp_result_t result)
+{
+    TaskHandle_t task;
+
+    (void)channel;
+    (void)result;
+    if (data == uds_rsp)
+    {
+        uds_state = UDS_IDLE;
+    }
+    /* a final response may wait for the response pending to go */
+    task = __atomic_load_n(&uds_task, __ATOMIC_SEQ_CST);
+    if (task != NULL)
+    {
+        (void)xTaskNotifyGive(task);
+    }
+}
+
+void freertos_task_uds(void *pvParameters)
+{
+    TickType_t timeout = portMAX_DELAY;
+    TickType_t now;
+
+    (void)pvParameters;
+
+    __atomic_store_n(&uds_task, xTaskGetCurrentTaskHandle(), __ATOMIC_SEQ_CST);
+    for (;;)
+    {
+        (void)ulTaskNotifyTake(pdTRUE, timeout);
+        now = xTaskGetTickCount();
+        uds_run(now);
+        timeout = uds_timeout(now);
+    }
+}
+
+/* @brief: One run of the server: a new request, a pending service, a
+ *         response waiting for ISO-TP or the S3 timer
+ * @param now : tick count
+ * @return    : None
+ */
+static void uds_run(TickType_t now)
+{
+    uint8_t nrc;
+
+    switch (uds_state)
+    {
+    case UDS_RECEIVED:
+        uds_request_num++;
+        uds_responded = false;
+        uds_next_pending = uds_req_tick + pdMS_TO_TICKS(UDS_P2_MS - UDS_P2_MARGIN_MS);
+        nrc = uds_serve(true);
+        uds_finish(nrc, now);
+        break;
+    case UDS_PENDING:
+        if (uds_expired(now, uds_next_poll))
+        {
+            nrc = uds_serve(false);
+            uds_finish(nrc, now);
+        }
+        if ((uds_state == UDS_PENDING) && uds_expired(now, uds_next_pending))
+        {
+            uds_send_pending(now);
+        }
+        break;
+    case UDS_SEND_WAIT:
+        uds_send(now);
+        break;
+    case UDS_IDLE:
+        if ((uds_session != UDS_SESSION_DEFAULT) &&
+            uds_expired(now, uds_idle_tick + pdMS_TO_TICKS(UDS_S3_MS)))
+        {
+            uds_session = UDS_SESSION_DEFAULT;
+            uds_s3_timeout_num++;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/* @brief: Serve the request in uds_req, the positive response goes to uds_rsp
+ * @param first : false for the repeated call of a pending service
+ * @return      : UDS_NRC_OK, a NRC or UDS_NRC_PENDING
+ */
+static uint8_t uds_serve(bool first)
+{
+    uds_rsp[0] = uds_req[0] + UDS_POSITIVE;
+    uds_rsp_len = 1U;
+
+    switch (uds_req[0])
+    {
+    case UDS_SID_DSC:
+        return uds_dsc();
+    case UDS_SID_TP:
+        return uds_tp();
+    case UDS_SID_RDBI:
+        return uds_rdbi();
+    case UDS_SID_WDBI:
+        return uds_wdbi();
+    case UDS_SID_RMBA:
+        return uds_rmba();
+    case UDS_SID_RC:
+        return uds_rc(first);
+    default:
+        return UDS_NRC_SNS;
+    }
+}
+
+/* 10 session: 50 session P2 P2*/
+static uint8_t uds_dsc(void)
+{
+    uint8_t session;
+
+    if (uds_req_len != 2U)
+    {
+        return UDS_NRC_IMLOIF;
+    }
+    session = uds_req[1] & (uint8_t)~UDS_SUPPRESS_POS;
+    if ((session != UDS_SESSION_DEFAULT) && (session != UDS_SESSION_EXTENDED))
+    {
+        return UDS_NRC_SFNS;
+    }
+    uds_session = session;
+    uds_rsp[1] = session;
+    uds_rsp[2] = (uint8_t)(UDS_P2_MS >> 8U);
+    uds_rsp[3] = (uint8_t)UDS_P2_MS;
+    uds_rsp[4] = (uint8_t)((UDS_P2_STAR_MS / 10U) >> 8U);
+    uds_rsp[5] = (uint8_t)(UDS_P2_STAR_MS / 10U);
+    uds_rsp_len = 6U;
+    return UDS_NRC_OK;
+}
+
+/* 3E 00: 7E 00 */
+static uint8_t uds_tp(void)
+{
+    if (uds_req_len != 2U)
+    {
+        return UDS_NRC_IMLOIF;
+    }
+    if ((uds_req[1] & (uint8_t)~UDS_SUPPRESS_POS) != 0U)
+    {
+        return UDS_NRC_SFNS;
+    }
+    uds_rsp[1] = 0U;
+    uds_rsp_len = 2U;
+    return UDS_NRC_OK;
+}
+
+/* 22 DID..: 62 DID data .., DIDs the server does not know are left out */
+static uint8_t uds_rdbi(void)
+{
+    const uds_did_t *entry;
+    uint32_t num = (uds_req_len - 1U) / 2U;
+    uint32_t value;
+    uint32_t i;
+    uint32_t b;
+
+    if ((uds_req_len < 3U) || (((uds_req_len - 1U) % 2U) != 0U) || (num > UDS_RDBI_DID_MAX))
+    {
+        return UDS_NRC_IMLOIF;
+    }
+    for (i = 0U; i < num; i++)
+    {
+        entry = uds_find_did((uint16_t)(((uint16_t)uds_req[1U + (2U * i)] << 8U) | uds_req[2U + (2U * i)]));
+        if (entry == NULL)
+        {
+            continue;
+        }
+        if ((uds_rsp_len + 2U + entry->len) > UDS_BUF_SIZE)
+        {
+            return UDS_NRC_RTL;
+        }
+        uds_rsp[uds_rsp_len++] = (uint8_t)(entry->did >> 8U);
+        uds_rsp[uds_rsp_len++] = (uint8_t)entry->did;
+        taskENTER_CRITICAL();
+        if ((entry->flags & UDS_DID_NUMBER) != 0U)
+        {
+            value = (entry->len == 1U) ? *(const uint8_t *)entry->data :
+                    ((entry->len == 2U) ? *(const uint16_t *)entry->data : *(const uint32_t *)entry->data);
+            for (b = entry->len; b > 0U; b--)
+            {
+                uds_rsp[uds_rsp_len++] = (uint8_t)(value >> (8U * (b - 1U)));
+            }
+        }
+        else
+        {
+            memcpy(&uds_rsp[uds_rsp_len], entry->data, entry->len);
+            uds_rsp_len += entry->len;
+        }
+        taskEXIT_CRITICAL();
+    }
+    return (uds_rsp_len == 1U) ? UDS_NRC_ROOR : UDS_NRC_OK;
+}
+
+/* 2E DID data: 6E DID */
+static uint8_t uds_wdbi(void)
+{
+    const uds_did_t *entry;
+    uint32_t value = 0U;
+    uint32_t i;
+
+    if (uds_req_len < 4U)
+    {
+        return UDS_NRC_IMLOIF;
+    }
+    entry = uds_find_did((uint16_t)(((uint16_t)uds_req[1] << 8U) | uds_req[2]));
+    if ((entry == NULL) || ((entry->write_sessions & UDS_SESSION_BIT(uds_session)) == 0U))
+    {
+        return UDS_NRC_ROOR;
+    }
+    if (uds_req_len != (3U + entry->len))
+    {
+        return UDS_NRC_IMLOIF;
+    }
+    taskENTER_CRITICAL();
+    if ((entry->flags & UDS_DID_NUMBER) != 0U)
+    {
+        for (i = 0U; i < entry->len; i++)
+        {
+            value = (value << 8U) | uds_req[3U + i];
+        }
+        if (entry->len == 1U)
+        {
+            *(uint8_t *)entry->data = (uint8_t)value;
+        }
+        else if (entry->len == 2U)
+        {
+            *(uint16_t *)entry->data = (uint16_t)value;
+        }
+        else
+        {
+            *(uint32_t *)entry->data = value;
+        }
+    }
+    else
+    {
+        memcpy(entry->data, &uds_req[3], entry->len);
+    }
+    taskEXIT_CRITICAL();
+    uds_rsp[1] = uds_req[1];
+    uds_rsp[2] = uds_req[2];
+    uds_rsp_len = 3U;
+    return UDS_NRC_OK;
+}
+
+/* 23 ALFID address size: 63 data, extended session only */
+static uint8_t uds_rmba(void)
+{
+    uint32_t addr_len;
+    uint32_t size_len;
+    uint32_t addr = 0U;
+    uint32_t size = 0U;
+    uint32_t i;
+    const uds_mem_region_t *region;
+
+    if (uds_session != UDS_SESSION_EXTENDED)
+    {
+        return UDS_NRC_SNSIAS;
+    }
+    if (uds_req_len < 4U)
+    {
+        return UDS_NRC_IMLOIF;
+    }
+    addr_len = uds_req[1] & 0x0FU;
+    size_len = uds_req[1] >> 4U;
+    if ((addr_len == 0U) || (addr_len > 4U) || (size_len == 0U) || (size_len > 4U))
+    {
+        return UDS_NRC_ROOR;
+    }
+    if (uds_req_len != (2U + addr_len + size_len))
+    {
+        return UDS_NRC_IMLOIF;
+    }
+    for (i = 0U; i < addr_len; i++)
+    {
+        addr = (addr << 8U) | uds_req[2U + i];
+    }
+    for (i = 0U; i < size_len; i++)
+    {
+        size = (size << 8U) | uds_req[2U + addr_len + i];
+    }
+    if ((size == 0U) || (size > (UDS_BUF_SIZE - 1U)))
+    {
+        return UDS_NRC_ROOR;
+    }
+    for (i = 0U; i < uds_config->mem_num; i++)
+    {
+        region = &uds_config->mem[i];
+        if ((addr >= region->start) && ((addr - region->start) < region->len) &&
+            (size <= (region->len - (addr - region->start))))
+        {
+            memcpy(&uds_rsp[1], (const void *)(uintptr_t)addr, size);
+            uds_rsp_len = 1U + size;
+            return UDS_NRC_OK;
+        }
+    }
+    return UDS_NRC_ROOR;
+}
+
+/* 31 type RID option: 71 type RID status */
+static uint8_t uds_rc(bool first)
+{
+    const uds_routine_t *routine = NULL;
+    uds_routine_func_t func;
+    uint16_t rid;
+    uint8_t type;
+    uint32_t status_len = UDS_BUF_SIZE - 4U;
+    uint32_t i;
+    uint8_t nrc;
+
+    if (uds_req_len < 4U)
+    {
+        return UDS_NRC_IMLOIF;
+    }
+    type = uds_req[1] & (uint8_t)~UDS_SUPPRESS_POS;
+    if ((type < UDS_RC_START) || (type > UDS_RC_RESULTS))
+    {
+        return UDS_NRC_SFNS;
+    }
+    rid = (uint16_t)(((uint16_t)uds_req[2] << 8U) | uds_req[3]);
+    for (i = 0U; i < uds_config->routine_num; i++)
+    {
+        if (uds_config->routines[i].rid == rid)
+        {
+            routine = &uds_config->routines[i];
+            break;
+        }
+    }
+    if ((routine == NULL) || ((routine->sessions & UDS_SESSION_BIT(uds_session)) == 0U))
+    {
+        return UDS_NRC_ROOR;
+    }
+    func = (type == UDS_RC_START) ? routine->start : ((type == UDS_RC_STOP) ? routine->stop : routine->results);
+    if (func == NULL)
+    {
+        return UDS_NRC_SFNS;
+    }
+
+    nrc = func(&uds_req[4], uds_req_len - 4U, &uds_rsp[4], &status_len, first);
+    if (nrc == UDS_NRC_OK)
+    {
+        uds_rsp[1] = type;
+        uds_rsp[2] = uds_req[2];
+        uds_rsp[3] = uds_req[3];
+        uds_rsp_len = 4U + status_len;
+    }
+    return nrc;
+}
+
+static const uds_did_t *uds_find_did(uint16_t did)
+{
+    uint32_t i;
+
+    for (i = 0U; i < uds_config->did_num; i++)
+    {
+        if (uds_config->dids[i].did == did)
+        {
+            return &uds_config->dids[i];
+        }
+    }
+    return NULL;
+}
+
+/* @brief: What comes after a service returned
+ * @param nrc : UDS_NRC_OK, a NRC or UDS_NRC_PENDING
+ * @param now : tick count
+ * @return    : None
+ */
+static void uds_finish(uint8_t nrc, TickType_t now)
+{
+    uint8_t sub = uds_req[1] & UDS_SUPPRESS_POS;
+
+    if (nrc == UDS_NRC_PENDING)
+    {
+        if (uds_state != UDS_PENDING)
+        {
+            uds_pending_num++;
+        }
+        uds_state = UDS_PENDING;
+        uds_next_poll = now + pdMS_TO_TICKS(UDS_POLL_MS);
+        return;
+    }
+
+    if (nrc != UDS_NRC_OK)
+    {
+        uds_negative_num++;
+        /* a functional request gets no "not supported" and "out of range" */
+        if (uds_req_func && !uds_responded &&
+            ((nrc == UDS_NRC_SNS) || (nrc == UDS_NRC_SFNS) || (nrc == UDS_NRC_ROOR) ||
+             (nrc == UDS_NRC_SFNSIAS) || (nrc == UDS_NRC_SNSIAS)))
+        {
+            uds_idle(now);
+            return;
+        }
+        uds_rsp[0] = UDS_SID_NEGATIVE;
+        uds_rsp[1] = uds_req[0];
+        uds_rsp[2] = nrc;
+        uds_rsp_len = 3U;
+    }
+    else if ((uds_req_len >= 2U) && (sub != 0U) && !uds_responded &&
+             ((uds_req[0] == UDS_SID_DSC) || (uds_req[0] == UDS_SID_TP) || (uds_req[0] == UDS_SID_RC)))
+    {
+        /* suppressPosRspMsgIndicationBit, only before a response pending */
+        uds_idle(now);
+        return;
+    }
+    uds_send(now);
+}
+
+/* @brief: Hand the response in uds_rsp to ISO-TP, or wait for the response
+ *         pending still in it
+ * @param now : tick count
+ * @return    : None
+ */
+static void uds_send(TickType_t now)
+{
+    uds_state = UDS_SENDING;
+    if (isotp_send(UDS_ISOTP_CHANNEL, uds_rsp, uds_rsp_len) != STATUS_SUCCESS)
+    {
+        uds_state = UDS_SEND_WAIT;
+        return;
+    }
+    uds_responded_at(now);
+    uds_idle_tick = now;
+}
+
+static void uds_send_pending(TickType_t now)
+{
+    uds_rsp_pending[0] = UDS_SID_NEGATIVE;
+    uds_rsp_pending[1] = uds_req[0];
+    uds_rsp_pending[2] = UDS_NRC_PENDING;
+    if (isotp_send(UDS_ISOTP_CHANNEL, uds_rsp_pending, sizeof(uds_rsp_pending)) == STATUS_SUCCESS)
+    {
+        uds_responded_at(now);
+        uds_next_pending = now + pdMS_TO_TICKS(UDS_PENDING_REPEAT_MS);
+    }
+}
+
+/* @brief: Response time of the first response to a request
+ * @param now : tick count of the response
+ * @return    : None
+ */
+static void uds_responded_at(TickType_t now)
+{
+    uint32_t us = (now - uds_req_tick) * UDS_TICK_US;
+
+    if (uds_responded)
+    {
+        return;
+    }
+    uds_responded = true;
+    if (us > uds_response_max_us)
+    {
+        uds_response_max_us = us;
+    }
+    if (us > (UDS_P2_MS * 1000U))
+    {
+        uds_p2_miss_num++;
+    }
+}
+
+static void uds_idle(TickType_t now)
+{
+    uds_idle_tick = now;
+    uds_state = UDS_IDLE;
+}
+
+/* @brief: Ticks freertos_task_uds may sleep
+ * @param now : tick count
+ * @return    : ticks, portMAX_DELAY if only a request can bring work
+ */
+static TickType_t uds_timeout(TickType_t now)
+{
+    TickType_t deadline;
+
+    switch (uds_state)
+    {
+    case UDS_PENDING:
+        deadline = ((TickType_t)(uds_next_poll - now) < (TickType_t)(uds_next_pending - now)) ? uds_next_poll :
+                   uds_next_pending;
+        break;
+    case UDS_SEND_WAIT:
+        /* uds_isotp_tx_done() of the response pending wakes us */
+        return pdMS_TO_TICKS(UDS_POLL_MS);
+    case UDS_IDLE:
+        if (uds_session == UDS_SESSION_DEFAULT)
+        {
+            return portMAX_DELAY;
+        }
+        deadline = uds_idle_tick + pdMS_TO_TICKS(UDS_S3_MS);
+        break;
+    default:
+        return portMAX_DELAY;
+    }
+    return uds_expired(now, deadline) ? 0U : (deadline - now);
+}
+
+static bool uds_expired(TickType_t now, TickType_t deadline)
+{
+    return (TickType_t)(now - deadline) < (portMAX_DELAY / 2U);
+}
@@ -0,0 +1,153 @@
+#ifndef UDS_H
+#define UDS_H
+
+#include "isotp.h"
+
+/* UDS (ISO 14229-1) server on the ISO-TP channels of can_lld: physical
+ * requests on 0x7E0, functional ones on 0x7DF, responses on 0x7E8.
+ *
+ * ISO-TP hands a complete request over in freertos_task_can_rx,
+ * uds_isotp_rx_done() only wakes freertos_task_uds. The task serves the
+ * request and gives the response to isotp_send(), one request at a time: a
+ * request which comes while the last one is served or its response still
+ * goes out is refused by ISO-TP like a message too long for the buffer.
+ *
+ * A service has UDS_P2_MS for its response. One which needs longer returns
+ * UDS_NRC_PENDING and is called again every UDS_POLL_MS. The server sends a
+ * response pending (NRC 0x78) before P2 runs out and again every
+ * UDS_PENDING_REPEAT_MS, the tester waits up to P2* after each. Outside the
+ * default session, the server falls back to it after UDS_S3_MS without a
+ * request, TesterPresent keeps the session.
+ *
+ * The data identifiers, routines and readable memory are tables of the
+ * application given to uds_init() */
+
+/* ISO-TP channels of can_lld, physical and functional requests */
+#define UDS_ISOTP_CHANNEL 1U
+#define UDS_ISOTP_FUNC_CHANNEL 2U
+#define UDS_PHYS_ID 0x7E0U
+#define UDS_FUNC_ID 0x7DFU
+#define UDS_RESP_ID 0x7E8U
+
+/* longest request and response */
+#define UDS_BUF_SIZE 512U
+
+/* timing of the default session, P2 in ms and P2* in 10 ms in the response
+ * of DiagnosticSessionControl */
+#define UDS_P2_MS 50U
+#define UDS_P2_STAR_MS 5000U
+#define UDS_S3_MS 5000U
+/* a pending service is called this often */
+#define UDS_POLL_MS 10U
+/* first response pending this long before P2 runs out, and the next ones
+ * this far apart */
+#define UDS_P2_MARGIN_MS 10U
+#define UDS_PENDING_REPEAT_MS (UDS_P2_STAR_MS / 2U)
+
+/* DIDs read with one ReadDataByIdentifier */
+#define UDS_RDBI_DID_MAX 16U
+
+/* service identifiers, a positive response is SID + 0x40 */
+#define UDS_SID_DSC 0x10U
+#define UDS_SID_RDBI 0x22U
+#define UDS_SID_RMBA 0x23U
+#define UDS_SID_WDBI 0x2EU
+#define UDS_SID_RC 0x31U
+#define UDS_SID_TP 0x3EU
+#define UDS_SID_NEGATIVE 0x7FU
+#define UDS_POSITIVE 0x40U
+
+/* suppressPosRspMsgIndicationBit of a sub-function */
+#define UDS_SUPPRESS_POS 0x80U
+
+#define UDS_SESSION_DEFAULT 0x01U
+#define UDS_SESSION_EXTENDED 0x03U
+/* session masks of the tables */
+#define UDS_SESSION_BIT(session) (1U << (session))
+#define UDS_SESSIONS_ALL (UDS_SESSION_BIT(UDS_SESSION_DEFAULT) | UDS_SESSION_BIT(UDS_SESSION_EXTENDED))
+#define UDS_SESSIONS_EXTENDED UDS_SESSION_BIT(UDS_SESSION_EXTENDED)
+
+#define UDS_RC_START 0x01U
+#define UDS_RC_STOP 0x02U
+#define UDS_RC_RESULTS 0x03U
+
+/* negative response codes */
+#define UDS_NRC_OK 0x00U
+#define UDS_NRC_SNS 0x11U       /* serviceNotSupported */
+#define UDS_NRC_SFNS 0x12U      /* subFunctionNotSupported */
+#define UDS_NRC_IMLOIF 0x13U    /* incorrectMessageLengthOrInvalidFormat */
+#define UDS_NRC_RTL 0x14U       /* responseTooLong */
+#define UDS_NRC_CNC 0x22U       /* conditionsNotCorrect */
+#define UDS_NRC_RSE 0x24U       /* requestSequenceError */
+#define UDS_NRC_ROOR 0x31U      /* requestOutOfRange */
+#define UDS_NRC_GPF 0x72U       /* generalProgrammingFailure */
+#define UDS_NRC_PENDING 0x78U   /* requestCorrectlyReceived-ResponsePending */
+#define UDS_NRC_SFNSIAS 0x7EU   /* subFunctionNotSupportedInActiveSession */
+#define UDS_NRC_SNSIAS 0x7FU    /* serviceNotSupportedInActiveSession */
+
+/* a number of 1, 2 or 4 bytes in the byte order of the CPU, sent big
+ * endian. Without it the bytes go as they are */
+#define UDS_DID_NUMBER 0x01U
+
+typedef struct
+{
+    uint16_t did;
+    uint8_t len;
+    uint8_t flags;              /* UDS_DID_NUMBER */
+    uint8_t write_sessions;     /* sessions WriteDataByIdentifier may change
+                                 * it in, 0 for read only */
+    void *data;
+} uds_did_t;
+
+/* one sub-function of a routine. option is the routineControlOptionRecord
+ * of the request, the routineStatusRecord goes to status, room for
+ * *status_len bytes, and *status_len is set to its length. first is false
+ * when the call repeats one which returned UDS_NRC_PENDING.
+ * Returns UDS_NRC_OK, a NRC, or UDS_NRC_PENDING to be called again */
+typedef uint8_t (*uds_routine_func_t)(const uint8_t *option, uint32_t len, uint8_t *status, uint32_t *status_len,
+                                      bool first);
+
+typedef struct
+{
+    uint16_t rid;
+    uint8_t sessions;           /* sessions it may run in */
+    uds_routine_func_t start;   /* NULL: the sub-function is not supported */
+    uds_routine_func_t stop;
+    uds_routine_func_t results;
+} uds_routine_t;
+
+/* memory ReadMemoryByAddress may read */
+typedef struct
+{
+    uint32_t start;
+    uint32_t len;
+} uds_mem_region_t;
+
+typedef struct
+{
+    const uds_did_t *dids;
+    uint32_t did_num;
+    const uds_routine_t *routines;
+    uint32_t routine_num;
+    const uds_mem_region_t *mem;
+    uint32_t mem_num;
+} uds_config_t;
+
+/* active diagnostic session, for DID 0xF186 of the application */
+extern uint8_t uds_session;
+extern uint32_t uds_request_num;
+extern uint32_t uds_negative_num;
+extern uint32_t uds_pending_num;
+extern uint32_t uds_refused_num;
+extern uint32_t uds_s3_timeout_num;
+/* request complete to first response handed to ISO-TP, and the responses
+ * later than P2 */
+extern uint32_t uds_response_max_us;
+extern uint32_t uds_p2_miss_num;
+
+void uds_init(const uds_config_t *config);
+uint8_t *uds_isotp_rx_buf(uint8_t channel, uint32_t len);
+void uds_isotp_rx_done(uint8_t channel, uint8_t *data, uint32_t len, isotp_result_t result);
+void uds_isotp_tx_done(uint8_t channel, const uint8_t *data, isotp_result_t result);
+
+#endif